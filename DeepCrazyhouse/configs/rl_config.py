@@ -48,14 +48,19 @@ class UCIConfig:
     Centi_Quick_Probability: int = 0
     Centi_Temperature: int = 80
     EPD_File_Path: str = "<empty>"
+    EPD_Sampling: str = "uniform"  # "uniform", "weighted" (by the "weight <value>;" operation) or "without_replacement"
     MaxInitPly: int = 0  # default: 30
     MCTS_Solver: bool = True
     MeanInitPly: int = 0  # default: 15
     Milli_Policy_Clip_Thresh: int = 10
     Nodes: int = 800
-    Reuse_Tree: str = False
+    Reuse_Tree: str = False  # the dirichlet noise is renewed at each reused root
+    Reuse_Tree_Max_Nodes: int = 0  # reused nodes counting towards the node limit (0: all), e.g. 400 keeps 400 fresh simulations
     Search_Type: str = f'mcts'
     Selfplay_Chunk_Size: int = 128  # default: 128
+    Selfplay_Export_Format: str = f'dense'  # 'packed' stores bit masks for the planes and a sparse policy
+    Selfplay_Stream_Directory: str = f'<empty>'  # directory of the append-only shards (rl/shardio.py) instead of zarr files
+    Selfplay_Publish_Address: str = f'<empty>'  # <host>:<port> of the replay buffer service (rl/replaybuffer.py)
     Selfplay_Number_Chunks: int = 640  # default: 640
     Simulations: int = 3200
     SyzygyPath: str = f''
@@ -71,5 +76,6 @@ class UCIConfigArena:
     All other options will be taken from the UCIConfig class.
     """
     Centi_Temperature: int = 60
+    Arena_SPRT: bool = False  # stop the arena as soon as the SPRT (Arena_SPRT_Elo0, Arena_SPRT_Elo1) is decided
 
 
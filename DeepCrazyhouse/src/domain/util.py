@@ -160,6 +160,39 @@ def get_dic_sorted_by_key(dic):
     return [dic[key] for key in sorted(dic)]
 
 
+def unpack_planes(plane_masks, plane_values, board_height=8, board_width=8):
+    """
+    Restores the dense planes of the packed export format (format_version 2).
+    Every plane is given by a 64 bit mask of its non-zero squares and the value of these squares.
+    :param plane_masks: uint64 array of shape (nb_samples, nb_channels)
+    :param plane_values: Array of shape (nb_samples, nb_channels)
+    :param board_height: Board height
+    :param board_width: Board width
+    :return: Planes of shape (nb_samples, nb_channels, board_height, board_width) with the dtype of plane_values
+    """
+    # bit i of a mask belongs to square i
+    mask_bytes = np.ascontiguousarray(plane_masks, dtype="<u8").view(np.uint8)
+    mask_bytes = mask_bytes.reshape(plane_masks.shape + (8,))
+    bits = np.unpackbits(mask_bytes, axis=-1, bitorder="little")
+    planes = bits.astype(plane_values.dtype) * plane_values[..., np.newaxis]
+    return planes.reshape(plane_masks.shape + (board_height, board_width))
+
+
+def densify_policy(policy_indices, policy_probs, nb_labels):
+    """
+    Restores the dense policy of the packed export format (format_version 2).
+    Unused entries are marked by the index nb_labels.
+    :param policy_indices: Array of shape (nb_samples, sparse_policy_size) with the policy indices
+    :param policy_probs: Array of shape (nb_samples, sparse_policy_size) with the corresponding probabilities
+    :param nb_labels: Number of policy labels
+    :return: Policy of shape (nb_samples, nb_labels)
+    """
+    policy = np.zeros((len(policy_indices), nb_labels + 1), np.float32)
+    rows = np.arange(len(policy_indices))[:, np.newaxis]
+    policy[rows, policy_indices.astype(np.int64)] = policy_probs
+    return np.ascontiguousarray(policy[:, :nb_labels])
+
+
 def get_numpy_arrays(pgn_dataset):
     """
     Loads the content of the dataset file into numpy arrays
@@ -178,12 +211,19 @@ def get_numpy_arrays(pgn_dataset):
     """
     # Get the data
     start_indices = np.array(pgn_dataset["start_indices"])
-    x = np.array(pgn_dataset["x"])
     y_value = np.array(pgn_dataset["y_value"])
-    try:
-        y_policy = np.array(pgn_dataset["y_policy_prediction_risev2_27"])
-    except Exception:
-        y_policy = np.array(pgn_dataset["y_policy"])
+    if pgn_dataset.attrs.get("format_version", 1) == 2:
+        # packed export format of the selfplay engine
+        x = unpack_planes(np.array(pgn_dataset["x_plane_masks"]), np.array(pgn_dataset["x_plane_values"]),
+                          pgn_dataset.attrs["board_height"], pgn_dataset.attrs["board_width"])
+        y_policy = densify_policy(np.array(pgn_dataset["y_policy_indices"]), np.array(pgn_dataset["y_policy_probs"]),
+                                  pgn_dataset.attrs["nb_labels"])
+    else:
+        x = np.array(pgn_dataset["x"])
+        try:
+            y_policy = np.array(pgn_dataset["y_policy_prediction_risev2_27"])
+        except Exception:
+            y_policy = np.array(pgn_dataset["y_policy"])
 
     possible_entries = ["plys_to_end", "y_best_move_q", "phase_vector"]
     entries = [None] * 3
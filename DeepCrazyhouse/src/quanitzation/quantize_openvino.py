@@ -0,0 +1,56 @@
+"""
+@file: quantize_openvino.py
+Created on 14.10.2026
+@project: CrazyAra
+@author: queensgambit
+
+Script for creating an INT8 quantised OpenVINO IR of an ONNX model using post-training quantisation (NNCF).
+The quantised model is stored next to the ONNX file as "<model>-int8.xml" / "<model>-int8.bin"
+and is loaded by the OpenVINO backend of the engine with the UCI option "Precision" set to "int8".
+
+Usage:
+python quantize_openvino.py --onnx-file model/ClassicAra/chess/model-1.19-bsize-16.onnx
+
+References:
+https://docs.openvino.ai/latest/basic_quantization_flow.html
+"""
+
+import sys
+import argparse
+import numpy as np
+import nncf
+import openvino.runtime as ov
+sys.path.insert(0, '../../../')
+from DeepCrazyhouse.src.preprocessing.dataset_loader import load_pgn_dataset
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='INT8 post-training quantisation for the OpenVINO backend')
+    parser.add_argument('--onnx-file', type=str, required=True, help='Path to the ONNX model')
+    parser.add_argument('--batch-size', type=int, default=16,
+                        help='Batch size of the calibration samples (must match the batch size of the ONNX model)')
+    parser.add_argument('--num-calib-batches', type=int, default=128, help='Number of calibration batches')
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+
+    # load calibration dataset
+    _, x_train, _, _, _, _ = load_pgn_dataset(normalize=True)
+    num_samples = min(len(x_train), args.num_calib_batches * args.batch_size)
+    num_samples -= num_samples % args.batch_size
+    calib_batches = [x_train[idx:idx + args.batch_size].astype(np.float32)
+                     for idx in range(0, num_samples, args.batch_size)]
+
+    core = ov.Core()
+    model = core.read_model(args.onnx_file)
+    quantized_model = nncf.quantize(model, nncf.Dataset(calib_batches), subset_size=len(calib_batches))
+
+    ir_file = args.onnx_file[:-len('.onnx')] + '-int8.xml'
+    ov.serialize(quantized_model, ir_file)
+    print('Saved quantised model to', ir_file)
+
+
+if __name__ == '__main__':
+    main()
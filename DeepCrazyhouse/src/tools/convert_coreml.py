@@ -0,0 +1,60 @@
+"""
+@file: convert_coreml.py
+Created on 15.10.2026
+@project: CrazyAra
+@author: queensgambit
+
+Script for converting the TorchScript export of a model (torch_cpu/model-bsize-<batch size>.pt) into a CoreML ML program
+for the CoreML backend of the engine on Apple Silicon.
+The model is stored as "<prefix>-bsize-<batch size>.mlpackage" in the output directory, next to the onnx files of the model,
+and is compiled by the engine on its first start.
+The inputs and outputs stay in float32, the weights and the computation use float16 unless --precision float32 is given.
+
+Usage:
+python convert_coreml.py --torch-file model/ClassicAra/chess/torch_cpu/model-bsize-16.pt --output-dir model/ClassicAra/chess/ --input-shape 52 8 8 --prefix model-1.19
+
+References:
+https://apple.github.io/coremltools/docs-guides/source/convert-pytorch.html
+"""
+
+import argparse
+import os
+import coremltools as ct
+import torch
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='CoreML conversion for the CoreML backend')
+    parser.add_argument('--torch-file', type=str, required=True, help='Path to the TorchScript model "model-bsize-<batch size>.pt"')
+    parser.add_argument('--output-dir', type=str, required=True, help='Directory of the model files of the engine')
+    parser.add_argument('--input-shape', type=int, nargs=3, required=True, help='Input shape of a single position, e.g. 52 8 8')
+    parser.add_argument('--prefix', type=str, default='model', help='Prefix of the model name which contains the input version')
+    parser.add_argument('--precision', type=str, default='float16', choices=['float16', 'float32'],
+                        help='Precision of the weights and the computation')
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+    # the script module was created by tracing (see export_as_script_module() in trainer_agent_pytorch.py)
+    model = torch.jit.load(args.torch_file, map_location='cpu').eval()
+    batch_size = int(os.path.basename(args.torch_file).split('-bsize-')[1].split('.')[0])
+    sample_input = torch.ones([batch_size] + args.input_shape)
+    nb_outputs = len(model(sample_input))
+
+    # the engine looks the outputs up by the names of the onnx export, the further auxiliary outputs are not used
+    output_names = ['value_out', 'policy_out', 'auxiliary_out', 'wdl_out', 'plys_to_end_out'][:nb_outputs]
+    mlmodel = ct.convert(model,
+                         inputs=[ct.TensorType(name='data', shape=sample_input.shape)],
+                         outputs=[ct.TensorType(name=name) for name in output_names],
+                         convert_to='mlprogram',
+                         compute_precision=ct.precision.FLOAT16 if args.precision == 'float16' else ct.precision.FLOAT32,
+                         minimum_deployment_target=ct.target.macOS13)
+
+    model_file = os.path.join(args.output_dir, f'{args.prefix}-bsize-{batch_size}.mlpackage')
+    mlmodel.save(model_file)
+    print('Saved CoreML model to', model_file)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,85 @@
+"""
+@file: search_tree_io.py
+Created on 14.10.2026
+@project: CrazyAra
+@author: queensgambit
+
+Reader for the binary search tree export of the engine (see engine/src/agents/util/treeexport.h for the layout).
+The export is created with the custom UCI command "tree <depth> <filename>.bin" after a search (depth 0 exports the full tree).
+Snapshots of the command "savetree <filename>" can be read as well and additionally contain the node states.
+
+Usage:
+tree = read_search_tree("tree.bin")
+root_children = get_children(tree, 0)
+"""
+
+import numpy as np
+
+TREE_EXPORT_MAGIC = 0x45455254
+TREE_EXPORT_VERSION = 1
+TREE_EXPORT_NO_CHILD = 0xFFFFFFFF
+TREE_EXPORT_FLAG_SNAPSHOT = 1
+HEADER_SIZE = 32
+
+NODE_DTYPE = np.dtype([("visits", "<u4"), ("value", "<f4"), ("first_edge", "<u4"), ("number_edges", "<u2"),
+                       ("node_type", "u1"), ("is_terminal", "u1")])
+EDGE_DTYPE = np.dtype([("child", "<u4"), ("action", "<u4"), ("visits", "<u4"), ("q_value", "<f4"), ("prior", "<f4")])
+NODE_STATE_DTYPE = np.dtype([("visit_sum", "<u4"), ("free_visits", "<u4"), ("no_visit_idx", "<u2"), ("checkmate_idx", "<u2"),
+                             ("end_in_ply", "<u2"), ("flags", "u1"), ("reserved", "u1")])
+
+
+def _padded_size(nb_bytes):
+    return (nb_bytes + 7) & ~7
+
+
+def read_search_tree(file_path):
+    """
+    Memory maps an exported search tree
+    :param file_path: Path of the export
+    :return: dict with "fen", "nodes" (structured array in breadth first order, index 0 is the root), "edges"
+     and "node_states" (None if the file isn't a snapshot)
+    """
+    data = np.memmap(file_path, dtype=np.uint8, mode="r")
+    magic, version = np.frombuffer(data, dtype="<u4", count=2, offset=0)
+    if magic != TREE_EXPORT_MAGIC:
+        raise ValueError("The given file is not a search tree export.")
+    if version != TREE_EXPORT_VERSION:
+        raise ValueError("Unsupported search tree export version %d." % version)
+    nb_nodes, nb_edges = [int(value) for value in np.frombuffer(data, dtype="<u8", count=2, offset=8)]
+    fen_length, flags = [int(value) for value in np.frombuffer(data, dtype="<u4", count=2, offset=24)]
+    fen = bytes(data[HEADER_SIZE:HEADER_SIZE + fen_length]).decode("ascii")
+
+    node_offset = HEADER_SIZE + _padded_size(fen_length)
+    nodes = np.frombuffer(data, dtype=NODE_DTYPE, count=nb_nodes, offset=node_offset)
+    edge_offset = node_offset + nb_nodes * NODE_DTYPE.itemsize
+    edges = np.frombuffer(data, dtype=EDGE_DTYPE, count=nb_edges, offset=edge_offset)
+    node_states = None
+    if flags & TREE_EXPORT_FLAG_SNAPSHOT:
+        node_states = np.frombuffer(data, dtype=NODE_STATE_DTYPE, count=nb_nodes,
+                                    offset=edge_offset + nb_edges * EDGE_DTYPE.itemsize)
+    return {"fen": fen, "nodes": nodes, "edges": edges, "node_states": node_states}
+
+
+def get_children(tree, node_idx):
+    """
+    Returns the edge records of a node, the field "child" holds the node index of the child or TREE_EXPORT_NO_CHILD
+    """
+    node = tree["nodes"][node_idx]
+    first_edge = int(node["first_edge"])
+    return tree["edges"][first_edge:first_edge + int(node["number_edges"])]
+
+
+def get_parent_indices(tree):
+    """
+    Returns the parent node index for each node (-1 for the root node), for MCGS exports the first parent in breadth first order
+    """
+    nodes = tree["nodes"]
+    edges = tree["edges"]
+    parents = np.full(len(nodes), -1, dtype=np.int64)
+    edge_parents = np.repeat(np.arange(len(nodes)), nodes["number_edges"].astype(np.int64))
+    has_child = edges["child"] != TREE_EXPORT_NO_CHILD
+    # assign in reverse order so that the first parent wins
+    children = edges["child"][has_child][::-1].astype(np.int64)
+    parents[children] = edge_parents[has_child][::-1]
+    parents[0] = -1
+    return parents
@@ -29,6 +29,7 @@
 #include "agent.h"
 #include "../util/communication.h"
 #include "../util/blazeutil.h"
+#include "../nn/inferencerecording.h"
 #include "stateobj.h"
 
 using namespace std;
@@ -57,8 +58,8 @@ void Agent::set_must_wait(bool value)
     mustWait = value;
 }
 
-Agent::Agent(const vector<unique_ptr<NeuralNetAPI>>& nets, const PlaySettings* playSettings, bool verbose):
-    NeuralNetAPIUser(nets),
+Agent::Agent(const vector<unique_ptr<NeuralNetAPI>>& nets, const PlaySettings* playSettings, bool verbose, bool useAuxiliaryOutputs):
+    NeuralNetAPIUser(nets, false, useAuxiliaryOutputs),
     playSettings(playSettings), mustWait(true), verbose(verbose), isRunning(false)
 {
 }
@@ -77,7 +78,7 @@ Action Agent::get_best_action()
 
 void Agent::lock_and_wait()
 {
-    unique_lock<mutex> lock(isRunningMutex);
+    unique_lock<decltype(isRunningMutex)> lock(isRunningMutex);
     while(mustWait) {
         isRunningCondition.wait(lock);
     }
@@ -86,7 +87,7 @@ void Agent::lock_and_wait()
 void Agent::unlock_and_notify()
 {
     // std::lock_guard is deprecated in C++17, therefore we use scoped_lock instead
-    scoped_lock<mutex> lock(isRunningMutex);
+    scoped_lock<decltype(isRunningMutex)> lock(isRunningMutex);
     mustWait = false;
     isRunningCondition.notify_one();
 }
@@ -94,17 +95,32 @@ void Agent::unlock_and_notify()
 void Agent::perform_action()
 {
     isRunning = true;
+    evalInfo->latency.lap(LATENCY_GO);
     evalInfo->start = chrono::steady_clock::now();
     this->evaluate_board_state();
     evalInfo->end = chrono::steady_clock::now();
+    // the MCTS agent has measured its stages already
+    evalInfo->latency.lap(LATENCY_SEARCH);
     set_best_move(state->steps_from_null());
+    if (inference_recording().is_recording() || inference_recording().is_replaying()) {
+        inference_recording().add_decision(state->fen() + " " + StateConstants::action_to_uci(evalInfo->bestMove, state->is_chess960()));
+    }
     info_msg(*evalInfo);
     info_string(state->fen());
     #ifdef MODE_STRATEGO
         info_bestmove(StateConstants::action_to_uci(evalInfo->bestMove, state->is_chess960()) + " equals " + state->action_to_string(evalInfo->bestMove));
     #else
-        info_bestmove(StateConstants::action_to_uci(evalInfo->bestMove, state->is_chess960()));
+        string bestmove = StateConstants::action_to_uci(evalInfo->bestMove, state->is_chess960());
+        if (!evalInfo->pv.empty() && evalInfo->pv[0].size() > 1 && evalInfo->pv[0][0] == evalInfo->bestMove) {
+            // expected reply of the opponent which can be used for "go ponder"
+            bestmove += " ponder " + StateConstants::action_to_uci(evalInfo->pv[0][1], state->is_chess960());
+        }
+        info_bestmove(bestmove);
     #endif
+    evalInfo->latency.lap(LATENCY_OUTPUT);
+    if (evalInfo->latency.isMeasured) {
+        info_string("latency", evalInfo->latency.to_string());
+    }
     isRunning = false;
 }
 
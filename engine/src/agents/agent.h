@@ -33,6 +33,7 @@
 #include "../evalinfo.h"
 #include "config/searchlimits.h"
 #include "config/playsettings.h"
+#include "../util/instrumentedmutex.h"
 #ifdef USE_RL
 #include "../rl/traindataexporter.h"
 #endif
@@ -46,15 +47,14 @@ namespace crazyara {
  */
 class Agent : public NeuralNetAPIUser
 {
-private:
+protected:
     /**
      * @brief set_best_move Sets the "best" (chosen) move by the engine to the evalInformation
      * @param evalInfo Evaluation information
      * @param moveCounter Current move counter (ply//2)
      */
-    void set_best_move(size_t moveCounter);
+    virtual void set_best_move(size_t moveCounter);
 
-protected:
     SearchLimits* searchLimits;
     const PlaySettings* playSettings;
     StateObj* state;
@@ -63,8 +63,8 @@ protected:
     // Locking a mutex from the main thread and releasing it in a different thread causes problems in Windows.
     // Therefore, we need to use a condition variable and a mutex here:
     // Reference: https://github.com/dmfrodrigues/GraphViewerCpp/issues/16
-    condition_variable isRunningCondition;
-    mutex isRunningMutex;
+    ProfiledConditionVariable isRunningCondition;
+    ProfiledMutex<LOCK_AGENT> isRunningMutex;
     // additional boolean variable to control the condition variable
     bool mustWait;
     bool verbose;
@@ -72,7 +72,7 @@ protected:
     bool isRunning;
 
 public:
-    Agent(const vector<unique_ptr<NeuralNetAPI>>& nets, const PlaySettings* playSettings, bool verbose);
+    Agent(const vector<unique_ptr<NeuralNetAPI>>& nets, const PlaySettings* playSettings, bool verbose, bool useAuxiliaryOutputs=true);
 
     /**
      * @brief perform_action Selects an action based on the evaluation result
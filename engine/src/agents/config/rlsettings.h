@@ -59,10 +59,48 @@ struct RLSettings
     float resignProbability;
     // the game will be resigned if the bestMove Q-value is below this threshold and resignation is allowed (e.g. -0.9)
     float resignThreshold;
+    // percentage of games in which tablebase positions are adjudicated by their WDL score
+    float tbAdjudicationProbability;
+    // percentage of games which are adjudicated as a draw after drawAdjudicationPlies consecutive plies
+    // with an absolute bestMove Q-value of at most drawAdjudicationThreshold (0 plies disables the draw adjudication)
+    float drawAdjudicationProbability;
+    size_t drawAdjudicationPlies;
+    float drawAdjudicationThreshold;
+    // percentage of games which are adjudicated as a draw after maxGamePlies plies (0 disables the cap)
+    float maxPliesProbability;
+    size_t maxGamePlies;
     // boolean indicating if the search tree is reused during selfplay game generation
     bool reuseTreeForSelpay;
     // string indicating the file path to an epd file which is used to initialize the rl games
     std::string epdFilePath;
+    // sampling strategy of the epd positions (EPD_SAMPLING_UNIFORM, EPD_SAMPLING_WEIGHTED or EPD_SAMPLING_WITHOUT_REPLACEMENT)
+    int epdSampling;
+    // number of games which are generated at the same time, their searches share the batched inference server
+    size_t concurrentGames;
+    // if true, the arena stops as soon as the sequential probability ratio test between elo0 and elo1 is decided
+    bool arenaSPRT;
+    float sprtElo0;
+    float sprtElo1;
+    // false positive (alpha) and false negative (beta) rate of the SPRT
+    float sprtAlpha;
+    float sprtBeta;
+    // blosc codec for compressing the exported training data ("none" for no compression) and its compression level
+    std::string compressionCodec;
+    int compressionLevel;
+    // maximum number of finished games waiting for the background writer before the selfplay threads are blocked
+    size_t exportQueueSize;
+    // export format of the training data (EXPORT_FORMAT_DENSE or EXPORT_FORMAT_PACKED)
+    int exportFormat;
+    // number of (move index, probability) pairs of each sample in the packed export format
+    size_t sparsePolicySize;
+    // directory of the append-only streaming shards, if empty the preallocated zarr file is used
+    std::string streamDirectory;
+    // size in MB after which a new streaming shard is started
+    size_t shardSizeMB;
+    // <host>:<port> of a replay buffer service which receives the finished games, if empty no games are published
+    std::string publishAddress;
+    // if true, the pgn files of selfplay and arena games are written gzip compressed (".pgn.gz")
+    bool compressPGN;
 };
 
 #endif // RLSETTINGS_H
@@ -28,6 +28,7 @@
 SearchSettings::SearchSettings():
         threads(2),
         batchSize(8),
+        minBatchSize(0),
         dirichletEpsilon(0.25f),
         dirichletAlpha(0.2f),
         nodePolicyTemperature(1.0f),
@@ -36,6 +37,8 @@ SearchSettings::SearchSettings():
         verbose(true),
         epsilonChecksCounter(100),
         useMCGS(true),
+        hashShards(64),
+        hashSize(4000000),
         cpuctInit(2.5f),
         cpuctBase(19652.0f),
         uInit(1.0f),
@@ -43,10 +46,33 @@ SearchSettings::SearchSettings():
         uBase(1965.0f),
         randomMoveFactor(0.0f),
         allowEarlyStopping(false),
+        klStoppingInterval(0),
+        klStoppingGain(0.00005),
+        asyncInference(false),
+        batchBackup(false),
+        multiVisitCollisions(false),
+        rootPrefill(false),
+        rootPrefillTopK(0),
+        numaPinning(false),
+        subtreeSplitDepth(0),
+        memoryBudget(0),
+        evalCacheSize(0),
+        evalCacheSymmetry(true),
+        refineVisits(0),
         useNPSTimemanager(false),
+        useStabilityTimeManager(false),
+        stabilityTimeMin(0.5f),
+        stabilityTimeMax(2.0f),
+        gumbelRoot(false),
+        gumbelTopK(16),
+        gumbelCVisit(50.0f),
+        gumbelCScale(1.0f),
         useTablebase(false),
         epsilonGreedyCounter(20),
         reuseTree(true),
+        reuseTreeMaxNodes(0),
+        backgroundTreeMaintenance(true),
+        rootStatsIntervalMS(50),
         mctsSolver(false),
         searchPlayerMode(MODE_TWO_PLAYER),
         virtualStyle(VIRTUAL_VISIT),
@@ -30,6 +30,8 @@
 
 #include <cstdlib>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 enum SearchPlayerMode {
     MODE_SINGLE_PLAYER,
@@ -53,6 +55,8 @@ struct SearchSettings
     uint16_t multiPV;
     size_t threads;
     unsigned int batchSize;
+    // lower bound of the adaptive mini-batch fill target (0 for always filling the full batch)
+    unsigned int minBatchSize;
     float dirichletEpsilon;
     float dirichletAlpha;
     // policy temperature which can be applied on the every nodes' policy
@@ -65,6 +69,10 @@ struct SearchSettings
 //    bool enhanceCaptures;   currently not support
 //    bool useFutureQValues;  currently not supported
     bool useMCGS;
+    // number of independently locked shards of the transposition table (rounded down to a power of two)
+    size_t hashShards;
+    // maximum number of entries of the transposition table
+    size_t hashSize;
     float cpuctInit;
     float cpuctBase;
     float uInit;
@@ -74,14 +82,62 @@ struct SearchSettings
 
     // If true, the exact given node count doesn't need to reached, but search can be stopped earlier
     bool allowEarlyStopping;
+    // Number of nodes between two comparisons of the root visit distribution for the KL-divergence stopping rule (0 disables it)
+    size_t klStoppingInterval;
+    // Minimum KL-divergence gain per node between two comparisons, the search is stopped once the root visit distribution changes less
+    double klStoppingGain;
+    // If true, every search thread collects the next mini-batch while the former one is evaluated by the neural network
+    bool asyncInference;
+    // If true, the values and collisions of a mini-batch are merged per node and each node is locked once per mini-batch
+    bool batchBackup;
+    // If true, repeated selections of a new node of the same mini-batch are backed up with its value instead of being discarded as collisions
+    bool multiVisitCollisions;
+    // If true, the root children without child nodes are evaluated in the first mini-batches of a small tree before the PUCT selection starts
+    bool rootPrefill;
+    // number of grandchildren with the highest prior of each prefilled root child which are evaluated afterwards (0 to disable)
+    size_t rootPrefillTopK;
+    // If true, each search thread and its buffers are placed on the NUMA node of its inference device
+    bool numaPinning;
+    // Cpus to which all search threads are bound, the remaining cores are left to the inference threads (empty = no partition)
+    std::vector<int> searchCpus;
+    // Number of plies below the root in which the rollouts of all threads are distributed as work items (0 disables the subtree scheduler)
+    size_t subtreeSplitDepth;
+    // Maximum number of bytes for the nodes of all search trees before low visit subtrees are pruned (0 = unlimited)
+    size_t memoryBudget;
+    // Number of bytes of the neural network evaluation cache which is kept across searches (0 disables the cache)
+    size_t evalCacheSize;
+    // Colour mirrored positions share an entry of the evaluation cache if the network input doesn't encode the side to move
+    bool evalCacheSymmetry;
+    // Path of the book with the network evaluations of the opening positions which is consulted before the inference (empty to disable)
+    std::string nnBookFile;
+    // Number of visits after which a node which was evaluated by the fast network is re-evaluated by the main network (0 if no fast network is loaded)
+    uint32_t refineVisits;
     // early break out based on max node visits in tree; increases time for falling eval
     bool useNPSTimemanager;
+    // If true the move time is scaled by the stability of the best move and the evaluation during the search
+    bool useStabilityTimeManager;
+    // lowest and highest factor of the planned move time for the stability time manager
+    float stabilityTimeMin;
+    float stabilityTimeMax;
+    // If true the root node is searched by Gumbel top-k sampling and sequential halving when the search has a node or simulation limit
+    bool gumbelRoot;
+    // number of root candidates which are sampled for sequential halving
+    size_t gumbelTopK;
+    // visit offset and scale of the Q-value transformation sigma(q) = (cVisit + maxVisits) * cScale * q
+    float gumbelCVisit;
+    float gumbelCScale;
     // boolean indicator if tablebases were loaded correctly
     bool useTablebase;
     // If true random exploration is used
     uint_fast8_t epsilonGreedyCounter;
     // If the tree or parts of the treee can be reused for the next search
     bool reuseTree;
+    // Maximum number of nodes of a reused tree which count towards the node limit of the next search (0 for no limit)
+    size_t reuseTreeMaxNodes;
+    // If true, the part of the tree which can't be reached after the own move is freed in the background right after "bestmove" (only with time controls)
+    bool backgroundTreeMaintenance;
+    // Publishing interval of the root statistics feed in milliseconds (see rootstatsfeed.h)
+    size_t rootStatsIntervalMS;
     // If true, then the MCTS solver for terminals and tablebases will be active
     bool mctsSolver;
     // Defines the nubmer of players within the MCTS search. Available are MODE_SINGLE_PLAYER and MODE_TWO_PLAYER
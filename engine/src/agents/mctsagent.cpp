@@ -29,14 +29,19 @@
 #include "../evalinfo.h"
 #include "../constants.h"
 #include "../util/blazeutil.h"
+#include "../util/numa.h"
+#include "../util/tracerecorder.h"
+#include "../util/metrics.h"
 #include "../manager/treemanager.h"
 #include "../manager/threadmanager.h"
 #include "../node.h"
 #include "../util/communication.h"
+#include "util/treeexport.h"
+#include "util/rootstatsfeed.h"
 
 MCTSAgent::MCTSAgent(const vector<unique_ptr<NeuralNetAPI>>& netSingleVector, const vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
-                     SearchSettings* searchSettings, PlaySettings* playSettings):
-    Agent(netSingleVector, playSettings, true),
+                     SearchSettings* searchSettings, PlaySettings* playSettings, size_t firstThreadIdx):
+    Agent(netSingleVector, playSettings, true, SEARCH_AUXILIARY_OUTPUTS),
     searchSettings(searchSettings),
     rootNode(nullptr),
     rootState(nullptr),
@@ -44,22 +49,67 @@ MCTSAgent::MCTSAgent(const vector<unique_ptr<NeuralNetAPI>>& netSingleVector, co
     opponentsNextRoot(nullptr),
     lastValueEval(-1.0f),
     reusedFullTree(false),
+    noisyRootNode(nullptr),
     overallNPS(0.0f),
     nbNPSentries(0),
     threadManager(nullptr),
-    reachedTablebases(false)
+    reachedTablebases(false),
+    isPondering(false),
+    rootPredictionMutex(nullptr)
 {
-    mapWithMutex.hashTable.reserve(1e6);
+    mapWithMutex.init(searchSettings->hashShards, searchSettings->hashSize);
+#ifdef MCTS_NODE_POOL
+    gcThread.mapWithMutex = &mapWithMutex;
+#endif
 
+    if (searchSettings->subtreeSplitDepth != 0) {
+        scheduler = make_unique<SubtreeScheduler>(searchSettings, searchSettings->threads);
+    }
+#ifndef MCTS_STORE_STATES
+    // the auxiliary outputs of the stored states are not cached
+    string modelNames;
+    for (const unique_ptr<NeuralNetAPI>& net : netBatchesVector[firstThreadIdx]) {
+        modelNames += net->get_model_name();
+    }
+    const Version version = netBatchesVector[firstThreadIdx].front()->get_version();
+    if (searchSettings->evalCacheSize != 0) {
+        evalCache = make_unique<EvalCache>(searchSettings->evalCacheSize, modelNames, version, searchSettings->evalCacheSymmetry);
+    }
+    if (!searchSettings->nnBookFile.empty()) {
+        try {
+            nnBook = make_unique<NNBook>(searchSettings->nnBookFile, modelNames, version);
+        }
+        catch (const invalid_argument& e) {
+            info_string(e.what());
+        }
+    }
+#endif
     for (size_t idx = 0; idx < searchSettings->threads; ++idx) {
-        searchThreads.emplace_back(new SearchThread(netBatchesVector[idx], searchSettings, &mapWithMutex));
+        const vector<unique_ptr<NeuralNetAPI>>& threadNets = netBatchesVector[firstThreadIdx + idx];
+        const int numaNode = searchSettings->numaPinning ? threadNets.front()->get_numa_node() : NO_NUMA_NODE;
+        // the batch buffers of the thread are allocated on the NUMA node of its device
+        ScopedNumaBinding numaBinding(numaNode);
+        searchThreads.emplace_back(new SearchThread(threadNets, searchSettings, &mapWithMutex));
+        searchThreads.back()->set_numa_node(numaNode);
+        searchThreads.back()->set_scheduler(scheduler.get(), idx);
+        searchThreads.back()->set_eval_cache(evalCache.get());
+        searchThreads.back()->set_nn_book(nnBook.get());
+        if (numaNode != NO_NUMA_NODE) {
+            info_string("Search thread", idx, "is bound to NUMA node " + to_string(numaNode));
+        }
     }
     timeManager = make_unique<TimeManager>(searchSettings->randomMoveFactor);
-    generator = default_random_engine(r());
 }
 
 MCTSAgent::~MCTSAgent()
 {
+    join_tree_maintenance();
+#ifdef MCTS_NODE_POOL
+    // nodes of the pool are only freed by the garbage collector
+    gcThread.oldRootNode = rootNode;
+    gcThread.newRootNode = nullptr;
+    run_gc_thread(&gcThread);
+#endif
     for (auto searchThread : searchThreads) {
         delete searchThread;
     }
@@ -112,6 +162,7 @@ bool MCTSAgent::is_running() const
 
 size_t MCTSAgent::init_root_node(StateObj *state)
 {
+    join_tree_maintenance();
     size_t nodesPreSearch;
     gcThread.oldRootNode = rootNode;
     rootNode = get_root_node_from_tree(state);
@@ -124,12 +175,28 @@ size_t MCTSAgent::init_root_node(StateObj *state)
             nodesPreSearch -= rootNode->get_free_visits();
         }
         info_string(nodesPreSearch, "nodes of former tree will be reused");
+#ifdef MCTS_RELEASE_LEAF_STATES
+        if (rootNode->get_state() == nullptr) {
+            // the new root was a leaf of the former search
+            rootNode->set_state(state->clone());
+        }
+#endif
     }
     else {
         create_new_root_node(state);
         nodesPreSearch = 0;
     }
     reachedTablebases = rootNode->is_tablebase() || reachedTablebases;
+    if (rootNode.get() != noisyRootNode) {
+        // the former noisy root will be freed and its address might be reused by a new node
+        noisyRootNode = nullptr;
+    }
+#ifdef MCTS_NODE_POOL
+    gcThread.newRootNode = rootNode.get();
+    // the next root candidates might be freed by the garbage collector
+    ownNextRoot = nullptr;
+    opponentsNextRoot = nullptr;
+#endif
     return nodesPreSearch;
 }
 
@@ -157,9 +224,13 @@ shared_ptr<Node> MCTSAgent::get_root_node_from_tree(StateObj *state)
     if (same_hash_key(opponentsNextRoot.get(), state) && opponentsNextRoot->is_playout_node() && opponentsNextRoot->get_number_of_nodes() > 0) {
         return opponentsNextRoot;
     }
-    // the node wasn't found, clear the old tree
-    delete_old_tree();
-
+    // the position might have been reached via another move order
+    const shared_ptr<Node> transpositionNode = get_transposition_node(&mapWithMutex, state);
+    if (transpositionNode != nullptr) {
+        info_string("reuse the tree of a transposition");
+        return transpositionNode;
+    }
+    // the node wasn't found, the entries of the old tree are removed lazily when their shard runs full
     return nullptr;
 }
 
@@ -169,9 +240,15 @@ void MCTSAgent::set_root_node_predictions()
     size_t netIdx = 0;
     if (nets.size() > 1) {
         GamePhase currentPhase = state->get_phase(numPhases, searchSettings->gamePhaseDefinition);
-        netIdx = phaseToNetsIndex.at(currentPhase);
+        netIdx = get_phase_net_index(currentPhase);
+    }
+    if (rootPredictionMutex != nullptr) {
+        lock_guard<RootPredictionMutex> lock(*rootPredictionMutex);
+        nets[netIdx]->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+    }
+    else {
+        nets[netIdx]->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
     }
-    nets[netIdx]->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
     size_t tbHits = 0;
     fill_nn_results(0, nets[netIdx]->is_policy_map(), valueOutputs, probOutputs, auxiliaryOutputs, rootNode.get(), tbHits,
                     rootState->mirror_policy(state->side_to_move()), searchSettings, rootNode->is_tablebase());
@@ -181,9 +258,15 @@ void MCTSAgent::create_new_root_node(StateObj* state)
 {
     info_string("create new tree");
 #ifdef MCTS_STORE_STATES
-    rootNode = make_shared<Node>(state->clone(), searchSettings);
+    StateObj* rootNodeState = state->clone();
 #else
-    rootNode = make_shared<Node>(state, searchSettings);
+    StateObj* rootNodeState = state;
+#endif
+#ifdef MCTS_NODE_POOL
+    // non-owning handle: the tree is freed by the garbage collector thread
+    rootNode = shared_ptr<Node>(node_pool().get(node_pool().new_node(rootNodeState, searchSettings)), [](Node*){});
+#else
+    rootNode = make_shared<Node>(rootNodeState, searchSettings);
 #endif
 #ifdef SEARCH_UCT
     unique_ptr<StateObj> newState = unique_ptr<StateObj>(state->clone());
@@ -198,8 +281,40 @@ void MCTSAgent::create_new_root_node(StateObj* state)
 void MCTSAgent::delete_old_tree()
 {
     // clear all remaining node of the former root node
-    mapWithMutex.hashTable.clear();
-    assert(mapWithMutex.hashTable.size() == 0);
+    mapWithMutex.clear();
+    assert(mapWithMutex.size() == 0);
+}
+
+void run_tree_maintenance(GCThread* gcThread, MapWithMutex* mapWithMutex)
+{
+    run_gc_thread(gcThread);
+    const size_t removedEntries = mapWithMutex->remove_expired_entries();
+    if (removedEntries != 0) {
+        info_string("removed hash entries:", removedEntries);
+    }
+}
+
+void MCTSAgent::start_tree_maintenance()
+{
+    join_tree_maintenance();
+    if (!searchSettings->backgroundTreeMaintenance || !searchSettings->reuseTree || searchLimits == nullptr || !is_game_sceneario(searchLimits) ||
+            opponentsNextRoot == nullptr || !opponentsNextRoot->is_playout_node()) {
+        return;
+    }
+    // the tree is handled as if the node after the own move had already been the root node of the former search
+    gcThread.oldRootNode = rootNode;
+    rootNode = opponentsNextRoot;
+#ifdef MCTS_NODE_POOL
+    gcThread.newRootNode = rootNode.get();
+#endif
+    maintenanceThread = thread(run_tree_maintenance, &gcThread, &mapWithMutex);
+}
+
+void MCTSAgent::join_tree_maintenance()
+{
+    if (maintenanceThread.joinable()) {
+        maintenanceThread.join();
+    }
 }
 
 void MCTSAgent::sleep_and_log_for(size_t timeMS, size_t updateIntervalMS)
@@ -227,12 +342,26 @@ void MCTSAgent::update_nps_measurement(float curNPS)
     }
 }
 
+void MCTSAgent::update_metrics()
+{
+    metrics().add(METRIC_SEARCHES, 1);
+    if (evalInfo->nodes > evalInfo->nodesPreSearch) {
+        metrics().add(METRIC_NODES, evalInfo->nodes - evalInfo->nodesPreSearch);
+    }
+    metrics().add(METRIC_TB_HITS, evalInfo->tbHits);
+    metrics().set(METRIC_NPS, evalInfo->calculate_nps());
+    metrics().set(METRIC_TREE_NODES, rootNode->get_node_count());
+    metrics().set(METRIC_NODE_MEMORY_BYTES, get_node_memory_usage());
+    metrics().set(METRIC_HASH_LOAD_PERMILLE, int64_t(mapWithMutex.get_load_factor() * 1000));
+}
+
 void MCTSAgent::apply_move_to_tree(Action move, bool ownMove)
 {
     if (!reusedFullTree && rootNode != nullptr && rootNode->is_playout_node()) {
         if (ownMove) {
             info_string("apply move to tree");
             opponentsNextRoot = pick_next_node(move, rootNode.get());
+            start_tree_maintenance();
             return;
         }
         else if (opponentsNextRoot != nullptr && opponentsNextRoot->is_playout_node()){
@@ -248,14 +377,22 @@ void MCTSAgent::apply_move_to_tree(Action move, bool ownMove)
 
 void MCTSAgent::clear_game_history()
 {
+    join_tree_maintenance();
     delete_old_tree();
+#ifdef MCTS_NODE_POOL
+    gcThread.oldRootNode = rootNode;
+    gcThread.newRootNode = nullptr;
+    run_gc_thread(&gcThread);
+#endif
     ownNextRoot = nullptr;
     opponentsNextRoot = nullptr;
     rootNode = nullptr;
+    noisyRootNode = nullptr;
     lastValueEval = -1.0f;
     nbNPSentries = 0;
     overallNPS = 0;
     reachedTablebases = false;
+    timeManager->clear_saved_time();
 }
 
 bool MCTSAgent::is_policy_map()
@@ -273,6 +410,20 @@ void MCTSAgent::update_stats()
     avgDepth = get_avg_depth(searchThreads);
     maxDepth = get_max_depth(searchThreads);
     tbHits = get_tb_hits(searchThreads);
+#ifdef MCTS_PHASE_TIMERS
+    for (SearchThread* searchThread : searchThreads) {
+        phaseTimers.add(searchThread->get_phase_timers());
+        searchThread->reset_phase_timers();
+    }
+#endif
+#ifdef MCTS_TREE_STATS
+    TreeStats treeStats;
+    for (SearchThread* searchThread : searchThreads) {
+        treeStats.add(searchThread->get_tree_stats());
+    }
+    TreeStats::increment(treeStats.tablebaseHits, tbHits);
+    info_string("treestats", treeStats.to_json());
+#endif
 }
 
 void MCTSAgent::handle_single_move()
@@ -289,75 +440,212 @@ void MCTSAgent::handle_single_move()
     rootNode->set_q_value(0, targetEval);
 }
 
+void MCTSAgent::apply_root_noise()
+{
+    if (rootNode.get() == noisyRootNode) {
+        rootNode->get_policy_prob_small() = rootPolicyWithoutNoise;
+        noisyRootNode = nullptr;
+    }
+    // the Gumbel root selection samples its own noise
+    if (searchSettings->dirichletEpsilon > 0.009f && get_gumbel_budget() == 0) {
+        info_string("apply dirichlet noise");
+        rootPolicyWithoutNoise = rootNode->get_policy_prob_small();
+        noisyRootNode = rootNode.get();
+        // TODO: Check for dirichlet compability
+        rootNode->apply_dirichlet_noise_to_prior_policy(searchSettings);
+        rootNode->fully_expand_node();
+    }
+}
+
+size_t MCTSAgent::get_gumbel_budget() const
+{
+    if (!searchSettings->gumbelRoot || scheduler != nullptr) {
+        return 0;
+    }
+    size_t budget = 0;
+    if (searchLimits->nodes != 0 && searchLimits->nodes > rootNode->get_node_count()) {
+        budget = searchLimits->nodes - rootNode->get_node_count();
+    }
+    if (searchLimits->simulations != 0 && searchLimits->simulations > rootNode->get_visits()) {
+        budget = max(budget, searchLimits->simulations - rootNode->get_visits());
+    }
+    return budget;
+}
+
+void MCTSAgent::init_gumbel_root()
+{
+    const size_t budget = get_gumbel_budget();
+    if (budget == 0) {
+        return;
+    }
+    info_string("apply gumbel root selection");
+    rootNode->fully_expand_node();
+    gumbelRoot.init(rootNode.get(), budget, searchSettings);
+}
+
+void MCTSAgent::set_gumbel_policy_target()
+{
+    DynamicVector<double> improvedPolicy;
+    gumbelRoot.get_improved_policy(rootNode.get(), improvedPolicy);
+    // the legal moves are sorted by the visits in multi-pv mode
+    for (ChildIdx childIdx = 0; childIdx < rootNode->get_number_child_nodes(); ++childIdx) {
+        const auto it = find(evalInfo->legalMoves.begin(), evalInfo->legalMoves.end(), rootNode->get_action(childIdx));
+        if (it != evalInfo->legalMoves.end()) {
+            evalInfo->policyProbSmall[it - evalInfo->legalMoves.begin()] = improvedPolicy[childIdx];
+        }
+    }
+}
+
+void MCTSAgent::set_best_move(size_t moveCounter)
+{
+    if (gumbelRoot.is_active()) {
+        // the Gumbel noise already samples the move
+        evalInfo->bestMove = rootNode->get_action(gumbelRoot.get_best_child(rootNode.get()));
+        return;
+    }
+    Agent::set_best_move(moveCounter);
+}
+
+size_t MCTSAgent::get_reused_nodes_surplus(size_t nodesPreSearch) const
+{
+    if (searchSettings->reuseTreeMaxNodes == 0 || searchLimits->nodes == 0 || nodesPreSearch <= searchSettings->reuseTreeMaxNodes) {
+        return 0;
+    }
+    return nodesPreSearch - searchSettings->reuseTreeMaxNodes;
+}
+
+/**
+ * @brief join_and_measure_ms Joins the given thread and returns the waiting time in ms
+ */
+float join_and_measure_ms(thread& t)
+{
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    t.join();
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1000.0f;
+}
+
 void MCTSAgent::evaluate_board_state()
 {
+    isPondering = searchLimits->ponder;
     rootState = unique_ptr<StateObj>(state->clone());
     evalInfo->nodesPreSearch = init_root_node(state);
+    evalInfo->latency.lap(LATENCY_TREE_REUSE);
     thread tGCThread = thread(run_gc_thread, &gcThread);
+    // the delays of a search can't be compared to the move time when pondering or without a search
+    bool measureDelays = !isPondering;
+    float gcPauseMS = 0;
+    float batchLatencyMS = 0;
 #ifdef USE_RL
-    tGCThread.join();
+    gcPauseMS = join_and_measure_ms(tGCThread);
+    evalInfo->latency.lap(LATENCY_GC);
 #endif
     evalInfo->isChess960 = state->is_chess960();
+    gumbelRoot.reset();
     if (rootNode->get_number_child_nodes() == 1) {
         info_string("Only single move available -> early stopping");
+        measureDelays = false;
         handle_single_move();
         unlock_and_notify();
     }
     else if (rootNode->get_number_child_nodes() == 0) {
         info_string("The given position has no legal moves");
+        measureDelays = false;
         unlock_and_notify();
     }
     else {
-        if (searchSettings->dirichletEpsilon > 0.009f) {
-            info_string("apply dirichlet noise");
-            // TODO: Check for dirichlet compability
-            rootNode->apply_dirichlet_noise_to_prior_policy(searchSettings);
-            rootNode->fully_expand_node();
-        }
+        apply_root_noise();
+        init_gumbel_root();
 
         if (!rootNode->is_root_node()) {
             rootNode->make_to_root();
         }
-        info_string("hash size: ", mapWithMutex.hashTable.size());
-        if (mapWithMutex.hashTable.size() > MAX_HASH_SIZE) {
-            info_string("clear hash");
-            mapWithMutex.hashTable.clear();
-        }
+        info_string("hash size: ", mapWithMutex.size(), "load factor:", mapWithMutex.get_load_factor());
+        // entries of former searches are only replaced when a shard runs full
+        mapWithMutex.new_generation();
         info_string("run mcts search");
+        const uint64_t batchesPreSearch = metrics().get(METRIC_NN_BATCHES);
+        const uint64_t latencyPreSearchUS = metrics().get_nn_latency_sum_us();
+        const size_t reusedNodesSurplus = get_reused_nodes_surplus(evalInfo->nodesPreSearch);
+        searchLimits->nodes += reusedNodesSurplus;
         run_mcts_search();
+        searchLimits->nodes -= reusedNodesSurplus;
         update_stats();
+        evalInfo->latency.lap(LATENCY_SEARCH_SHUTDOWN);
+        const uint64_t batches = metrics().get(METRIC_NN_BATCHES) - batchesPreSearch;
+        if (batches != 0) {
+            batchLatencyMS = (metrics().get_nn_latency_sum_us() - latencyPreSearchUS) / 1000.0f / batches;
+        }
+    }
+    // the best move must not be sent before "ponderhit" or "stop" even if the search finished early
+    while (isPondering && isRunning) {
+        this_thread::sleep_for(chrono::milliseconds(1));
     }
+    evalInfo->latency.lap(LATENCY_SEARCH);
     update_eval_info(*evalInfo, rootNode.get(), tbHits, maxDepth, searchSettings);
+    if (gumbelRoot.is_active()) {
+        set_gumbel_policy_target();
+    }
     lastValueEval = evalInfo->bestMoveQ[0];
     lastSideToMove = state->side_to_move();
     update_nps_measurement(evalInfo->calculate_nps());
+    update_metrics();
+    evalInfo->latency.lap(LATENCY_EVAL_INFO);
 #ifndef USE_RL
-    tGCThread.join();
+    gcPauseMS = join_and_measure_ms(tGCThread);
+    evalInfo->latency.lap(LATENCY_GC);
 #endif
+    if (measureDelays) {
+        const int elapsedMS = int(chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - evalInfo->start).count());
+        timeManager->update_latency_statistics(elapsedMS, batchLatencyMS, gcPauseMS);
+    }
+    // the events of the inference threads which are still running are written by the next dump
+    trace_recorder().dump();
 }
 
 void MCTSAgent::run_mcts_search()
 {
     thread** threads = new thread*[searchSettings->threads];
+    if (scheduler != nullptr) {
+        scheduler->set_root_node(rootNode.get());
+    }
+    int curMovetime = timeManager->get_time_for_move(searchLimits, rootState->side_to_move(), rootNode->plies_from_null()/2);
+    ThreadManagerData tData(rootNode.get(), searchThreads, evalInfo, lastValueEval, &mapWithMutex);
+    ThreadManagerInfo tInfo(searchSettings, searchLimits, overallNPS, rootState->side_to_move());
+    ThreadManagerParams tParams(curMovetime, 250, is_game_sceneario(searchLimits), can_prolong_search(rootNode->plies_from_null()/2, timeManager->get_thresh_move()),
+                                isPondering, timeManager->get_batch_latency_ms());
+    threadManager = make_unique<ThreadManager>(&tData, &tInfo, &tParams);
     for (size_t i = 0; i < searchSettings->threads; ++i) {
         searchThreads[i]->set_root_node(rootNode.get());
         searchThreads[i]->set_root_state(rootState.get());
         searchThreads[i]->set_search_limits(searchLimits);
         searchThreads[i]->set_reached_tablebases(reachedTablebases);
+        searchThreads[i]->set_event_listener(threadManager.get());
+        searchThreads[i]->set_gumbel_root(gumbelRoot.is_active() ? &gumbelRoot : nullptr);
         threads[i] = new thread(run_search_thread, searchThreads[i]);
     }
-    int curMovetime = timeManager->get_time_for_move(searchLimits, rootState->side_to_move(), rootNode->plies_from_null()/2);
-    ThreadManagerData tData(rootNode.get(), searchThreads, evalInfo, lastValueEval);
-    ThreadManagerInfo tInfo(searchSettings, searchLimits, overallNPS, rootState->side_to_move());
-    ThreadManagerParams tParams(curMovetime, 250, is_game_sceneario(searchLimits), can_prolong_search(rootNode->plies_from_null()/2, timeManager->get_thresh_move()));
-    threadManager = make_unique<ThreadManager>(&tData, &tInfo, &tParams);
     unique_ptr<thread> tManager = make_unique<thread>(run_thread_manager, threadManager.get());
+#ifdef __linux__
+    const bool isPublishingRootStats = root_stats_feed().is_open() &&
+            root_stats_feed().start_publishing(rootNode.get(), rootState->is_chess960(), searchSettings->rootStatsIntervalMS);
+#endif
+    evalInfo->latency.lap(LATENCY_SEARCH_SETUP);
     unlock_and_notify();
     for (size_t i = 0; i < searchSettings->threads; ++i) {
         threads[i]->join();
     }
+#ifdef __linux__
+    if (isPublishingRootStats) {
+        root_stats_feed().stop_publishing();
+    }
+#endif
+    evalInfo->latency.lap(LATENCY_SEARCH);
+    if (scheduler != nullptr) {
+        // the remaining items hold virtual losses on the current tree
+        scheduler->release_items();
+    }
     threadManager->kill();
     tManager->join();
+    timeManager->add_saved_time(tData.savedTimeMS);
     delete[] threads;
 }
 
@@ -372,6 +660,17 @@ void MCTSAgent::stop()
     isRunning = false;
 }
 
+void MCTSAgent::ponderhit()
+{
+    if (!isPondering) {
+        return;
+    }
+    isPondering = false;
+    if (threadManager != nullptr) {
+        threadManager->ponderhit();
+    }
+}
+
 void MCTSAgent::print_root_node()
 {
     if (rootNode == nullptr) {
@@ -382,6 +681,26 @@ void MCTSAgent::print_root_node()
     rootNode->print_node_statistics(rootState.get(), customOrdering, searchSettings);
 }
 
+void MCTSAgent::print_search_stats() const
+{
+#ifdef MCTS_PHASE_TIMERS
+    print_phase_timers(phaseTimers);
+#else
+    info_string("The search phase timers require a build with MCTS_PHASE_TIMERS.");
+#endif
+#ifdef MCTS_LOCK_STATS
+    lock_stats().print();
+#endif
+}
+
+void MCTSAgent::reset_search_stats()
+{
+    phaseTimers.reset();
+#ifdef MCTS_LOCK_STATS
+    lock_stats().reset();
+#endif
+}
+
 void print_child_nodes_to_file(const Node* parentNode, StateObj* state, size_t parentId, size_t& nodeId, ostream& outFile, size_t depth, size_t maxDepth)
 {
     int initialId = nodeId;
@@ -390,7 +709,7 @@ void print_child_nodes_to_file(const Node* parentNode, StateObj* state, size_t p
     }
     size_t childIdx = 0;
     for (auto it = parentNode->get_node_it_begin(); it != parentNode->get_node_it_end(); ++it) {
-        const Node* node = it->get();
+        const Node* node = get_node_ptr(*it);
         if (node != nullptr) {
             Action action = parentNode->get_action(childIdx);
             outFile << "N" << ++nodeId << " [label = \""
@@ -409,7 +728,7 @@ void print_child_nodes_to_file(const Node* parentNode, StateObj* state, size_t p
     }
     outFile << "}" << endl;
     for (auto it = parentNode->get_node_it_begin(); it != parentNode->get_node_it_end(); ++it) {
-        const Node* node = it->get();
+        const Node* node = get_node_ptr(*it);
         if (node != nullptr && node->is_playout_node()) {
             unique_ptr<StateObj> state2 = unique_ptr<StateObj>(state->clone());
             Action action = parentNode->get_action(childIdx);
@@ -421,6 +740,17 @@ void print_child_nodes_to_file(const Node* parentNode, StateObj* state, size_t p
 
 void MCTSAgent::export_search_tree(size_t maxDepth, const string& filename)
 {
+    if (rootNode == nullptr) {
+        info_string("You must do a search before you can export the search tree");
+        return;
+    }
+    if (has_suffix(filename, ".bin")) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        const size_t numberNodes = export_search_tree_binary(rootNode.get(), rootState->fen(), maxDepth, searchSettings->useMCGS, filename);
+        info_string("exported nodes:", numberNodes);
+        info_elapsed_time("export time:", start, chrono::steady_clock::now());
+        return;
+    }
     size_t nodeId = 0;
     ofstream outFile;
     outFile.open (filename);
@@ -446,3 +776,42 @@ void MCTSAgent::export_search_tree(size_t maxDepth, const string& filename)
     outFile << "}" << endl;
     outFile.close();
 }
+
+void MCTSAgent::save_search_tree(const string& filename)
+{
+    if (rootNode == nullptr) {
+        info_string("You must do a search before you can save the search tree");
+        return;
+    }
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    const size_t numberNodes = export_search_tree_binary(rootNode.get(), rootState->fen(), 0, searchSettings->useMCGS, filename, true);
+    info_string("saved nodes:", numberNodes);
+    info_elapsed_time("save time:", start, chrono::steady_clock::now());
+}
+
+void MCTSAgent::load_search_tree(const TreeSnapshot& snapshot, StateObj* state)
+{
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    clear_game_history();
+    rootState = unique_ptr<StateObj>(state->clone());
+    NodeLink rootLink = NodeLink();
+    try {
+        rootLink = snapshot.restore(rootState.get(), searchSettings, &mapWithMutex);
+    }
+    catch (const exception&) {
+        // the transposition table may refer to nodes of the incomplete tree
+        delete_old_tree();
+        throw;
+    }
+#ifdef MCTS_NODE_POOL
+    // non-owning handle: the tree is freed by the garbage collector thread
+    rootNode = shared_ptr<Node>(get_node_ptr(rootLink), [](Node*){});
+#else
+    rootNode = rootLink;
+#endif
+    if (!rootNode->is_playout_node()) {
+        rootNode->prepare_node_for_visits();
+    }
+    info_string("restored nodes:", snapshot.get_number_nodes());
+    info_elapsed_time("restore time:", start, chrono::steady_clock::now());
+}
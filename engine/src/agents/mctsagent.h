@@ -45,9 +45,14 @@
 #include "../manager/timemanager.h"
 #include "../manager/threadmanager.h"
 #include "util/gcthread.h"
+#include <atomic>
+
+class TreeSnapshot;
 
 using namespace crazyara;
 
+typedef ProfiledMutex<LOCK_ROOT_PREDICTION> RootPredictionMutex;
+
 class MCTSAgent : public Agent
 {
 public:
@@ -69,23 +74,51 @@ public:
 
     // boolean which indicates if the same node was requested twice for analysis
     bool reusedFullTree;
+    // prior policy of noisyRootNode before the dirichlet noise was applied to it
+    DynamicVector<float> rootPolicyWithoutNoise;
+    // root node of the last search which received dirichlet noise (nullptr if none)
+    const Node* noisyRootNode;
+    // sequential halving of the root node of the current search (inactive if the root node uses the PUCT selection)
+    GumbelRoot gumbelRoot;
 
     // saves the overall nps for each move during the game
     float overallNPS;
     size_t avgDepth;
     size_t maxDepth;
     size_t tbHits;
+    // accumulated phase timers of all search threads since the last reset_search_stats() call
+    PhaseTimers phaseTimers;
     size_t nbNPSentries;
 
     GCThread gcThread;
+    // frees the unreachable part of the tree between "bestmove" and the next search (see start_tree_maintenance())
+    thread maintenanceThread;
+    unique_ptr<SubtreeScheduler> scheduler;
+    // neural network evaluations which are kept across searches (nullptr if disabled)
+    unique_ptr<EvalCache> evalCache;
+    // network evaluations of the opening positions (nullptr if disabled)
+    unique_ptr<NNBook> nnBook;
 
     unique_ptr<ThreadManager> threadManager;
     bool reachedTablebases;
+    // true while searching on the opponent's time ("go ponder") until "ponderhit" or "stop" is received
+    atomic<bool> isPondering;
+    // locked during the root node prediction if the single networks are shared with other agents (nullptr otherwise)
+    RootPredictionMutex* rootPredictionMutex;
 public:
+    /**
+     * @brief MCTSAgent
+     * @param netSingleVector Networks with batch size one for the root node predictions
+     * @param netBatchesVector Networks of the search threads
+     * @param searchSettings Search settings, the agent uses searchSettings->threads search threads
+     * @param playSettings Play settings
+     * @param firstThreadIdx Index of the networks in netBatchesVector which are used by the first search thread
+     */
     MCTSAgent(const vector<unique_ptr<NeuralNetAPI>>& netSingleVector,
               const vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
               SearchSettings* searchSettings,
-              PlaySettings* playSettings);
+              PlaySettings* playSettings,
+              size_t firstThreadIdx=0);
     ~MCTSAgent();
     MCTSAgent(const MCTSAgent&) = delete;
     MCTSAgent& operator=(MCTSAgent const&) = delete;
@@ -100,6 +133,11 @@ public:
 
     void stop() override;
 
+    /**
+     * @brief ponderhit Continues the current ponder search as a regular search under the time budget of the time manager
+     */
+    virtual void ponderhit();
+
     /**
      * @brief print_root_node Prints out the root node statistics (visits, q-value, u-value)
      *  by calling the stdout operator for the Node class
@@ -107,13 +145,39 @@ public:
      */
     void print_root_node();
 
+    /**
+     * @brief print_search_stats Prints the time spent in the main search phases summed over all searches since the last reset.
+     * The timers are only available when building with MCTS_PHASE_TIMERS, the lock statistics are added when building with MCTS_LOCK_STATS.
+     */
+    void print_search_stats() const;
+
+    /**
+     * @brief reset_search_stats Resets the accumulated phase timers and lock statistics
+     */
+    void reset_search_stats();
+
     /**
      * @brief export_search_tree Exports the current search tree as a graph in a .gv/.dot-file
+     * or in the binary format of treeexport.h if the file name ends with .bin
      * @param maxDepth Maximum depth which will be printed. If 0, the full tree will be printed
-     * @param filename File name where the information will be written to (should end with .gv or .dot)
+     * @param filename File name where the information will be written to (should end with .gv, .dot or .bin)
      */
     void export_search_tree(size_t maxDepth, const string& filename);
 
+    /**
+     * @brief save_search_tree Writes the full search tree of the last search as a snapshot (see treeexport.h)
+     * @param filename Snapshot file
+     */
+    void save_search_tree(const string& filename);
+
+    /**
+     * @brief load_search_tree Replaces the current tree by the tree of a snapshot.
+     * The next search of the snapshot position continues on the restored tree.
+     * @param snapshot Mapped snapshot
+     * @param state State of the root position of the snapshot
+     */
+    void load_search_tree(const TreeSnapshot& snapshot, StateObj* state);
+
     void apply_move_to_tree(Action move, bool ownMove) override;
 
     /**
@@ -159,6 +223,7 @@ public:
 
     /**
      * @brief update_stats Updates the avg depth, max depth and tablebase hits statistics
+     * and prints the tree statistics as JSON when building with MCTS_TREE_STATS
      */
     void update_stats();
 
@@ -168,6 +233,35 @@ public:
      */
     void handle_single_move();
 
+    /**
+     * @brief apply_root_noise Applies fresh dirichlet noise to the root node. If the root node already received noise in a former search,
+     * its noise free prior policy is restored first, so the noise of several searches doesn't accumulate in a reused tree.
+     */
+    void apply_root_noise();
+
+    /**
+     * @brief get_gumbel_budget Returns the number of simulations of the current search for the Gumbel root selection.
+     * Zero if the Gumbel root selection is disabled, the search has no node or simulation limit or the subtree scheduler is used.
+     */
+    size_t get_gumbel_budget() const;
+
+    /**
+     * @brief init_gumbel_root Starts the Gumbel root selection for the current search if get_gumbel_budget() isn't zero
+     */
+    void init_gumbel_root();
+
+    /**
+     * @brief set_gumbel_policy_target Replaces the policy of the eval info by the improved policy of the Gumbel root selection which is exported as the policy target
+     */
+    void set_gumbel_policy_target();
+
+    /**
+     * @brief get_reused_nodes_surplus Returns the number of reused nodes of the current tree which exceed searchSettings->reuseTreeMaxNodes.
+     * These nodes don't count towards the node limit, so a reused tree can't replace more than reuseTreeMaxNodes new simulations.
+     * @param nodesPreSearch Number of nodes which have been reused from the former search
+     */
+    size_t get_reused_nodes_surplus(size_t nodesPreSearch) const;
+
     /**
      * @brief reuse_tree Checks if the postion is know and if the tree or parts of the tree can be reused.
      * The old tree or former subtrees will be freed from memory.
@@ -196,6 +290,18 @@ public:
      */
     void delete_old_tree();
 
+    /**
+     * @brief start_tree_maintenance Makes the node after the own move the root node and frees the rest of the former tree
+     * together with the expired hash entries in a background thread, so that this work is done while the opponent is thinking.
+     * The replies of the opponent stay untouched and are picked as the next root node by apply_move_to_tree().
+     */
+    void start_tree_maintenance();
+
+    /**
+     * @brief join_tree_maintenance Waits until the background tree maintenance has finished
+     */
+    void join_tree_maintenance();
+
     /**
      * @brief sleep_and_log_for Sleeps for a given amout of ms while every update interval ms the eval info will be updated an printed to stdout
      * @param evalInfo Evaluation information
@@ -208,8 +314,18 @@ public:
      * @param curNPS New NPS measurement
      */
     void update_nps_measurement(float curNPS);
+
+    /**
+     * @brief update_metrics Reports the statistics of the finished search to the process wide metrics
+     */
+    void update_metrics();
 private:
     void set_root_node_predictions();
+
+    /**
+     * @brief set_best_move Plays the winner of sequential halving if the Gumbel root selection was active, otherwise Agent::set_best_move()
+     */
+    void set_best_move(size_t moveCounter) override;
 };
 
 /**
@@ -44,13 +44,21 @@ MCTSAgentBatch::MCTSAgentBatch(vector<unique_ptr<NeuralNetAPI>>& netSingleVector
     {
         numberOfAgents = noa;
         splitNodes = sN;
+        // every member agent needs at least one search thread, the remaining trees are built one after another
+        const size_t numberMembers = min(size_t(numberOfAgents), searchSettings->threads);
+        for (size_t memberIdx = 0; memberIdx < numberMembers; ++memberIdx) {
+            const size_t firstThreadIdx = memberIdx * searchSettings->threads / numberMembers;
+            memberSettings.emplace_back(make_unique<SearchSettings>(*searchSettings));
+            memberSettings.back()->threads = (memberIdx + 1) * searchSettings->threads / numberMembers - firstThreadIdx;
+            memberSettings.back()->hashSize = max(searchSettings->hashSize / numberMembers, size_t(1));
+            memberAgents.emplace_back(make_unique<MCTSAgent>(netSingleVector, netBatchesVector, memberSettings.back().get(), playSettings, firstThreadIdx));
+            memberAgents.back()->rootPredictionMutex = &rootPredictionMutex;
+        }
     }
 
 MCTSAgentBatch::~MCTSAgentBatch()
 {
-    for (auto searchThread : searchThreads) {
-        delete searchThread;
-    }
+    // the search threads are deleted by the MCTSAgent destructor
 }
 
 string MCTSAgentBatch::get_name() const
@@ -62,104 +70,59 @@ string MCTSAgentBatch::get_name() const
     return ret;
 }
 
-void MCTSAgentBatch::evaluate_board_state()
+void set_eval_of_tree(const MCTSAgent* agent, EvalInfo& eval, const SearchSettings* searchSettings)
 {
-    vector<EvalInfo> evals;
-    evalInfo->isChess960 = state->is_chess960();
+    const Node* rootNode = agent->rootNode.get();
+    const size_t targetLength = rootNode->get_number_child_nodes();
+    eval.childNumberVisits = rootNode->get_child_number_visits();
+    eval.qValues = rootNode->get_q_values();
+    if (targetLength == 1) {
+        eval.policyProbSmall = DynamicVector<float>(1);
+        eval.policyProbSmall[0] = 1.0f;
+    }
+    else {
+        ChildIdx bestMoveIdx;
+        rootNode->get_mcts_policy(eval.policyProbSmall, bestMoveIdx, searchSettings);
+    }
 
-    for (size_t i = 0; i < numberOfAgents; i++)
-    {
-        EvalInfo eval = *evalInfo;
-        auto rt = state->clone();
-        rootState = unique_ptr<StateObj>(rt);
-        eval.nodesPreSearch = init_root_node(rt);
-        
-        info_string(rootState->fen());
-        
-        thread tGCThread = thread(run_gc_thread, &gcThread);
-        
-        if (rootNode->get_number_child_nodes() == 1) {
-            info_string("Only single move available -> early stopping");
-            unlock_and_notify();
-        }
-        else if (rootNode->get_number_child_nodes() == 0) {
-            info_string("The given position has no legal moves");
-            unlock_and_notify();
-        }
-        else {
-            if (searchSettings->dirichletEpsilon > 0.009f) {
-                info_string("apply dirichlet noise");
-                // TODO: Check for dirichlet compability
-                rootNode->apply_dirichlet_noise_to_prior_policy(searchSettings);
-                rootNode->fully_expand_node();
-            }
-
-            if (!rootNode->is_root_node()) {
-                rootNode->make_to_root();
-            }
-            int tmp = searchLimits->nodes;
-            if(splitNodes){  
-                searchLimits->nodes = tmp/numberOfAgents;
-            }
-            info_string("run mcts search");
-            run_mcts_search();
-            update_stats();
-            searchLimits->nodes = tmp;
-        }
-        
-        const size_t targetLength = rootNode->get_number_child_nodes();
-        eval.childNumberVisits = rootNode->get_child_number_visits();
-        eval.qValues = rootNode->get_q_values();
-        if (targetLength == 1) {
-            eval.policyProbSmall = DynamicVector<float>(1);
-            eval.policyProbSmall[0] = 1.0f;
-        }
-        else {
-            ChildIdx bestMoveIdx;
-            rootNode->get_mcts_policy(eval.policyProbSmall, bestMoveIdx, searchSettings);
-        }
-       
-        eval.legalMoves = rootNode->get_legal_actions();
+    eval.legalMoves = rootNode->get_legal_actions();
 
-        vector<size_t> indices;
-        uint16_t maxIdx = min(searchSettings->multiPV, rootNode->get_no_visit_idx());
+    vector<size_t> indices;
+    uint16_t maxIdx = min(searchSettings->multiPV, rootNode->get_no_visit_idx());
 
-        if (maxIdx > 1) {
-            sort_eval_lists(eval, indices);
-        }
-        
-        auto p = sort_permutation(eval.legalMoves, std::greater<float>());
-        for (size_t idx = 0; idx < eval.legalMoves.size(); ++idx) {
-        indices.emplace_back(idx);
-        }
-        apply_permutation_in_place(eval.legalMoves, p);
-        apply_permutation_in_place(indices, p);
+    if (maxIdx > 1) {
+        sort_eval_lists(eval, indices);
+    }
 
-        eval.init_vectors_for_multi_pv(searchSettings->multiPV);
+    auto p = sort_permutation(eval.legalMoves, std::greater<float>());
+    for (size_t idx = 0; idx < eval.legalMoves.size(); ++idx) {
+    indices.emplace_back(idx);
+    }
+    apply_permutation_in_place(eval.legalMoves, p);
+    apply_permutation_in_place(indices, p);
 
-        if (targetLength == 1 && rootNode->is_blank_root_node()) {
-            // single move with no tree reuse
-            eval.pv[0] = {rootNode->get_action(0)};
-            // there are no q-values available, therefore use the state value evaluation as bestMoveQ
-            eval.bestMoveQ[0] = rootNode->get_value();
-            eval.centipawns[0] = value_to_centipawn(eval.bestMoveQ[0]);
-        }
-        else {
-            for (size_t idx = 0; idx < maxIdx; ++idx) {
-                set_eval_for_single_pv(eval, rootNode.get(), idx, indices, searchSettings);
-            }
-        }
-        eval.selDepth = maxDepth;
-        eval.nodes = rootNode->get_node_count();
-        eval.tbHits = tbHits;
+    eval.init_vectors_for_multi_pv(searchSettings->multiPV);
 
-        evals.push_back(eval);
-        tGCThread.join();
+    if (targetLength == 1 && rootNode->is_blank_root_node()) {
+        // single move with no tree reuse
+        eval.pv[0] = {rootNode->get_action(0)};
+        // there are no q-values available, therefore use the state value evaluation as bestMoveQ
+        eval.bestMoveQ[0] = rootNode->get_value();
+        eval.centipawns[0] = value_to_centipawn(eval.bestMoveQ[0]);
+    }
+    else {
+        for (size_t idx = 0; idx < maxIdx; ++idx) {
+            set_eval_for_single_pv(eval, rootNode, idx, indices, searchSettings);
+        }
     }
+    eval.selDepth = agent->maxDepth;
+    eval.nodes = rootNode->get_node_count();
+    eval.tbHits = agent->tbHits;
+}
 
-    evalInfo->nodesPreSearch = init_root_node(state);
-    evalInfo->legalMoves = rootNode->get_legal_actions();
-    
+size_t get_consensus_tree_idx(const vector<EvalInfo>& evals)
+{
+    const size_t numberOfAgents = evals.size();
     auto combinedPolicy = evals[0].policyProbSmall;
     auto combinedChildVisits = evals[0].childNumberVisits;
     auto combinedQValues = evals[0].qValues;
@@ -196,10 +159,79 @@ void MCTSAgentBatch::evaluate_board_state()
         }
     }
     std::vector<float>::iterator result = std::min_element(diffs.begin(), diffs.end()); 
-    int stateIdx = std::distance(diffs.begin(), result);
+    return std::distance(diffs.begin(), result);
+}
+
+void MCTSAgentBatch::evaluate_board_state()
+{
+    evalInfo->isChess960 = state->is_chess960();
+    vector<EvalInfo> evals(numberOfAgents, *evalInfo);
+    vector<unique_ptr<StateObj>> states;
+    vector<SearchLimits> limits(numberOfAgents, *searchLimits);
+    // the trees which are searched after a "ponderhit" don't ponder anymore
+    isPondering = searchLimits->ponder;
+    for (size_t i = 0; i < numberOfAgents; i++) {
+        states.emplace_back(state->clone());
+        if (splitNodes) {
+            limits[i].nodes = searchLimits->nodes / numberOfAgents;
+        }
+    }
+
+    // each member agent writes only to the evaluations of its own trees, so no lock is needed for merging them afterwards
+    auto run_member_agent = [&](size_t memberIdx) {
+        MCTSAgent* agent = memberAgents[memberIdx].get();
+        for (size_t i = memberIdx; i < numberOfAgents; i += memberAgents.size()) {
+            limits[i].ponder = isPondering;
+            agent->set_search_settings(states[i].get(), &limits[i], &evals[i]);
+            agent->evaluate_board_state();
+            set_eval_of_tree(agent, evals[i], searchSettings);
+        }
+    };
+    info_string("run mcts search with parallel agents:", memberAgents.size());
+    vector<thread> memberThreads;
+    for (size_t memberIdx = 0; memberIdx < memberAgents.size(); ++memberIdx) {
+        memberThreads.emplace_back(run_member_agent, memberIdx);
+    }
+    // the search can be stopped from now on
+    unlock_and_notify();
+    for (thread& memberThread : memberThreads) {
+        memberThread.join();
+    }
+
+    evalInfo->nodesPreSearch = init_root_node(state);
+    evalInfo->legalMoves = rootNode->get_legal_actions();
+    
+    const size_t stateIdx = get_consensus_tree_idx(evals);
 
     *evalInfo = evals[stateIdx];
     update_nps_measurement(evalInfo->calculate_nps());
     
     info_string("Selected State: " + std::to_string(stateIdx));
 }
+
+void MCTSAgentBatch::stop()
+{
+    for (unique_ptr<MCTSAgent>& agent : memberAgents) {
+        if (agent->threadManager != nullptr) {
+            agent->threadManager->stop_search();
+        }
+    }
+    MCTSAgent::stop();
+}
+
+void MCTSAgentBatch::ponderhit()
+{
+    // resets isPondering first, so that the trees which haven't started yet don't ponder
+    MCTSAgent::ponderhit();
+    for (unique_ptr<MCTSAgent>& agent : memberAgents) {
+        agent->ponderhit();
+    }
+}
+
+void MCTSAgentBatch::apply_move_to_tree(Action move, bool ownMove)
+{
+    for (unique_ptr<MCTSAgent>& agent : memberAgents) {
+        agent->apply_move_to_tree(move, ownMove);
+    }
+    MCTSAgent::apply_move_to_tree(move, ownMove);
+}
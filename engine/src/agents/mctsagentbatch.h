@@ -22,7 +22,8 @@
  * Created on 05.2021
  * @author: BluemlJ
  *
- * This MCTSAgent starts several MCTSAgents after another and calculates the best move based on all of the MCTSAgents. 
+ * This MCTSAgent starts several MCTSAgents and calculates the best move based on all of the MCTSAgents.
+ * The search threads are split between the member agents, so that the trees are built concurrently.
  */
 
 #ifndef MCTSAGENTBATCH_H
@@ -52,6 +53,13 @@ public:
   // boolean, deciding if the given nodes are player per tree or are split between the trees
   bool splitNodes;
 
+private:
+  // agents which search concurrently, each with its own part of the search threads and networks
+  vector<unique_ptr<MCTSAgent>> memberAgents;
+  vector<unique_ptr<SearchSettings>> memberSettings;
+  // the networks for the root node predictions are shared by all member agents
+  RootPredictionMutex rootPredictionMutex;
+
 public:
     MCTSAgentBatch(vector<unique_ptr<NeuralNetAPI>>& netSingleVector,
               vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
@@ -65,7 +73,25 @@ public:
 
     string get_name() const override;
     void evaluate_board_state() override;
+    void stop() override;
+    void ponderhit() override;
+    void apply_move_to_tree(Action move, bool ownMove) override;
 };
 
+/**
+ * @brief set_eval_of_tree Sets the policy, visits, Q-values and principal variations of the given evaluation from the tree of an agent
+ * @param agent Agent which finished its search
+ * @param eval Evaluation of the agent
+ * @param searchSettings Search settings
+ */
+void set_eval_of_tree(const MCTSAgent* agent, EvalInfo& eval, const SearchSettings* searchSettings);
+
+/**
+ * @brief get_consensus_tree_idx Returns the index of the tree whose policy is closest to the combined policy of all trees
+ * @param evals Evaluations of the trees, which were set by set_eval_of_tree()
+ * @return Index of the selected evaluation
+ */
+size_t get_consensus_tree_idx(const vector<EvalInfo>& evals);
+
 
 #endif // MCTSAGENTBATCH_H
@@ -0,0 +1,219 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: mctsagentrootparallel.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include <thread>
+#include "mctsagentrootparallel.h"
+#include "../util/communication.h"
+
+
+MCTSAgentRootParallel::MCTSAgentRootParallel(vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
+                                             SearchSettings* searchSettings, PlaySettings* playSettings, size_t numberTrees):
+    MCTSAgent(netSingleVector, netBatchesVector, searchSettings, playSettings),
+    finishedTrees(0)
+{
+    // the search threads are grouped by device, so every tree uses the threads and networks of a single device
+    const size_t numberAgents = max(min(numberTrees, searchSettings->threads), size_t(1));
+    for (size_t treeIdx = 0; treeIdx < numberAgents; ++treeIdx) {
+        const size_t firstThreadIdx = treeIdx * searchSettings->threads / numberAgents;
+        treeSettings.emplace_back(make_unique<SearchSettings>(*searchSettings));
+        treeSettings.back()->threads = (treeIdx + 1) * searchSettings->threads / numberAgents - firstThreadIdx;
+        treeSettings.back()->hashSize = max(searchSettings->hashSize / numberAgents, size_t(1));
+        treeAgents.emplace_back(make_unique<MCTSAgent>(netSingleVector, netBatchesVector, treeSettings.back().get(), playSettings, firstThreadIdx));
+        treeAgents.back()->rootPredictionMutex = &rootPredictionMutex;
+    }
+}
+
+string MCTSAgentRootParallel::get_name() const
+{
+    return "MCTSRootParallel-" + std::to_string(treeAgents.size()) + "-" + engineVersion + "-" + nets.front()->get_model_name();
+}
+
+unordered_map<Action, RootStatistics> MCTSAgentRootParallel::collect_root_statistics(bool lockRoots)
+{
+    unordered_map<Action, RootStatistics> statistics;
+    for (unique_ptr<MCTSAgent>& agent : treeAgents) {
+        Node* rootNode = agent->rootNode.get();
+        if (lockRoots) {
+            rootNode->lock();
+        }
+        for (ChildIdx childIdx = 0; childIdx < rootNode->get_no_visit_idx(); ++childIdx) {
+            const uint32_t visits = rootNode->get_real_visits(childIdx);
+            if (visits != 0) {
+                RootStatistics& moveStatistics = statistics[rootNode->get_action(childIdx)];
+                moveStatistics.visits += visits;
+                moveStatistics.qValueSum += visits * double(rootNode->get_q_value(childIdx));
+            }
+        }
+        if (lockRoots) {
+            rootNode->unlock();
+        }
+    }
+    return statistics;
+}
+
+void MCTSAgentRootParallel::share_root_statistics()
+{
+    const unordered_map<Action, RootStatistics> statistics = collect_root_statistics(true);
+    for (unique_ptr<MCTSAgent>& agent : treeAgents) {
+        Node* rootNode = agent->rootNode.get();
+        rootNode->lock();
+        for (ChildIdx childIdx = 0; childIdx < rootNode->get_no_visit_idx(); ++childIdx) {
+            auto it = statistics.find(rootNode->get_action(childIdx));
+            if (it != statistics.end()) {
+                rootNode->blend_q_value(childIdx, it->second.get_q_value(), ROOT_PARALLEL_SHARE_WEIGHT);
+            }
+        }
+        rootNode->unlock();
+    }
+}
+
+void MCTSAgentRootParallel::combine_trees(const vector<EvalInfo>& evals)
+{
+    const unordered_map<Action, RootStatistics> statistics = collect_root_statistics(false);
+    uint_fast32_t nodes = 0;
+    for (const EvalInfo& eval : evals) {
+        nodes += eval.nodes;
+    }
+    if (statistics.empty()) {
+        // no search has been done, e.g. for a single legal move
+        *evalInfo = evals.front();
+        evalInfo->nodes = nodes;
+        return;
+    }
+    Action bestAction = statistics.begin()->first;
+    double bestVisits = -1;
+    double visitSum = 0;
+    for (const auto& moveStatistics : statistics) {
+        visitSum += moveStatistics.second.visits;
+        if (moveStatistics.second.visits > bestVisits) {
+            bestVisits = moveStatistics.second.visits;
+            bestAction = moveStatistics.first;
+        }
+    }
+
+    // the tree which spent the most visits on the combined best move provides the principal variation
+    size_t treeIdx = 0;
+    double treeVisits = -1;
+    for (size_t idx = 0; idx < evals.size(); ++idx) {
+        for (size_t moveIdx = 0; moveIdx < evals[idx].legalMoves.size(); ++moveIdx) {
+            if (evals[idx].legalMoves[moveIdx] == bestAction && evals[idx].childNumberVisits[moveIdx] > treeVisits) {
+                treeVisits = evals[idx].childNumberVisits[moveIdx];
+                treeIdx = idx;
+            }
+        }
+    }
+
+    *evalInfo = evals[treeIdx];
+    evalInfo->nodes = nodes;
+    for (size_t moveIdx = 0; moveIdx < evalInfo->legalMoves.size(); ++moveIdx) {
+        auto it = statistics.find(evalInfo->legalMoves[moveIdx]);
+        if (it != statistics.end()) {
+            evalInfo->childNumberVisits[moveIdx] = it->second.visits;
+            evalInfo->qValues[moveIdx] = it->second.get_q_value();
+            evalInfo->policyProbSmall[moveIdx] = it->second.visits / visitSum;
+        }
+        else {
+            evalInfo->childNumberVisits[moveIdx] = 0;
+            evalInfo->policyProbSmall[moveIdx] = 0;
+        }
+    }
+    if (evalInfo->pv[0].empty() || evalInfo->pv[0][0] != bestAction) {
+        evalInfo->pv[0] = {bestAction};
+    }
+}
+
+void MCTSAgentRootParallel::evaluate_board_state()
+{
+    evalInfo->isChess960 = state->is_chess960();
+    vector<EvalInfo> evals(treeAgents.size(), *evalInfo);
+    vector<unique_ptr<StateObj>> states;
+    vector<SearchLimits> limits(treeAgents.size(), *searchLimits);
+    for (size_t idx = 0; idx < treeAgents.size(); ++idx) {
+        states.emplace_back(state->clone());
+        // node and simulation limits apply to the combined search
+        limits[idx].nodes = searchLimits->nodes / treeAgents.size();
+        limits[idx].simulations = searchLimits->simulations / treeAgents.size();
+        treeAgents[idx]->set_search_settings(states[idx].get(), &limits[idx], &evals[idx]);
+        treeAgents[idx]->set_must_wait(true);
+    }
+
+    finishedTrees = 0;
+    auto run_tree_agent = [&](size_t treeIdx) {
+        MCTSAgent* agent = treeAgents[treeIdx].get();
+        // the evaluation of the tree is written to evals[treeIdx]
+        agent->evaluate_board_state();
+        ++finishedTrees;
+    };
+    info_string("run root parallel mcts search with trees:", treeAgents.size());
+    vector<thread> treeThreads;
+    for (size_t treeIdx = 0; treeIdx < treeAgents.size(); ++treeIdx) {
+        treeThreads.emplace_back(run_tree_agent, treeIdx);
+    }
+    // the root nodes are set as soon as the trees have started their search
+    for (unique_ptr<MCTSAgent>& agent : treeAgents) {
+        agent->lock_and_wait();
+    }
+    // the search can be stopped from now on
+    unlock_and_notify();
+    while (finishedTrees < treeAgents.size()) {
+        this_thread::sleep_for(chrono::milliseconds(ROOT_PARALLEL_SHARE_INTERVAL_MS));
+        if (finishedTrees == 0) {
+            share_root_statistics();
+        }
+    }
+    for (thread& treeThread : treeThreads) {
+        treeThread.join();
+    }
+
+    combine_trees(evals);
+    update_nps_measurement(evalInfo->calculate_nps());
+}
+
+void MCTSAgentRootParallel::stop()
+{
+    for (unique_ptr<MCTSAgent>& agent : treeAgents) {
+        if (agent->threadManager != nullptr) {
+            agent->threadManager->stop_search();
+        }
+    }
+    MCTSAgent::stop();
+}
+
+void MCTSAgentRootParallel::ponderhit()
+{
+    // the move time is managed by the thread manager of each tree
+    for (unique_ptr<MCTSAgent>& agent : treeAgents) {
+        agent->ponderhit();
+    }
+    MCTSAgent::ponderhit();
+}
+
+void MCTSAgentRootParallel::apply_move_to_tree(Action move, bool ownMove)
+{
+    for (unique_ptr<MCTSAgent>& agent : treeAgents) {
+        agent->apply_move_to_tree(move, ownMove);
+    }
+    MCTSAgent::apply_move_to_tree(move, ownMove);
+}
@@ -0,0 +1,101 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: mctsagentrootparallel.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Root-parallel MCTS for multiple GPUs: every GPU builds its own tree with its own search threads, so the threads of different
+ * devices don't compete for the mutexes of the root and first-ply nodes.
+ * The visits and Q-values of the root children are exchanged periodically during the search and the trees are combined at the end.
+ */
+
+#ifndef MCTSAGENTROOTPARALLEL_H
+#define MCTSAGENTROOTPARALLEL_H
+
+#include <atomic>
+#include "mctsagent.h"
+
+// interval in which the root statistics of the trees are exchanged
+#define ROOT_PARALLEL_SHARE_INTERVAL_MS 20
+// fraction by which the root Q-values of each tree are moved towards the combined Q-values of all trees
+#define ROOT_PARALLEL_SHARE_WEIGHT 0.5f
+
+using namespace crazyara;
+
+/**
+ * @brief The RootStatistics struct holds the combined visits and Q-values of a root move over all trees
+ */
+struct RootStatistics {
+    double visits = 0;
+    double qValueSum = 0;
+
+    float get_q_value() const {
+        return float(qValueSum / visits);
+    }
+};
+
+class MCTSAgentRootParallel : public MCTSAgent
+{
+private:
+    // one agent per device, each with the search threads and networks of its device
+    vector<unique_ptr<MCTSAgent>> treeAgents;
+    vector<unique_ptr<SearchSettings>> treeSettings;
+    // the networks for the root node predictions are shared by all tree agents
+    RootPredictionMutex rootPredictionMutex;
+    // number of tree agents which finished their search
+    atomic<size_t> finishedTrees;
+
+    /**
+     * @brief collect_root_statistics Sums up the visits and visit-weighted Q-values of the root children of all trees by their move
+     * @param lockRoots True, if the root nodes must be locked because the trees are still searched
+     * @return Statistics for every visited move
+     */
+    unordered_map<Action, RootStatistics> collect_root_statistics(bool lockRoots);
+
+    /**
+     * @brief share_root_statistics Moves the Q-values of the root children of every tree towards the combined Q-values of all trees
+     */
+    void share_root_statistics();
+
+    /**
+     * @brief combine_trees Sets the evaluation of the tree which agrees with the combined best move and replaces its policy,
+     *  visits and Q-values by the combined statistics of all trees
+     * @param evals Evaluations of the tree agents
+     */
+    void combine_trees(const vector<EvalInfo>& evals);
+
+public:
+    MCTSAgentRootParallel(vector<unique_ptr<NeuralNetAPI>>& netSingleVector,
+                          vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
+                          SearchSettings* searchSettings,
+                          PlaySettings* playSettings,
+                          size_t numberTrees);
+    MCTSAgentRootParallel(const MCTSAgentRootParallel&) = delete;
+    MCTSAgentRootParallel& operator=(MCTSAgentRootParallel const&) = delete;
+
+    string get_name() const override;
+    void evaluate_board_state() override;
+    void stop() override;
+    void ponderhit() override;
+    void apply_move_to_tree(Action move, bool ownMove) override;
+};
+
+#endif // MCTSAGENTROOTPARALLEL_H
@@ -27,6 +27,7 @@
 #include <thread>
 #include <fstream>
 #include "mctsagenttruesight.h"
+#include "mctsagentbatch.h"
 #include "../evalinfo.h"
 #include "../constants.h"
 #include "../util/blazeutil.h"
@@ -38,26 +39,92 @@
 
 
 MCTSAgentTrueSight::MCTSAgentTrueSight(vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
-                     SearchSettings* searchSettings, PlaySettings* playSettings):
-    MCTSAgent(netSingleVector, netBatchesVector, searchSettings, playSettings)
+                     SearchSettings* searchSettings, PlaySettings* playSettings, size_t numberDeterminizations):
+    MCTSAgent(netSingleVector, netBatchesVector, searchSettings, playSettings),
+    numberDeterminizations(max(numberDeterminizations, size_t(1)))
     {
-        
+        if (this->numberDeterminizations == 1) {
+            return;
+        }
+        // the search threads are split between the member agents, the remaining determinizations are searched one after another
+        const size_t numberMembers = min(this->numberDeterminizations, searchSettings->threads);
+        for (size_t memberIdx = 0; memberIdx < numberMembers; ++memberIdx) {
+            const size_t firstThreadIdx = memberIdx * searchSettings->threads / numberMembers;
+            memberSettings.emplace_back(make_unique<SearchSettings>(*searchSettings));
+            memberSettings.back()->threads = (memberIdx + 1) * searchSettings->threads / numberMembers - firstThreadIdx;
+            memberSettings.back()->hashSize = max(searchSettings->hashSize / numberMembers, size_t(1));
+            memberAgents.emplace_back(make_unique<MCTSAgent>(netSingleVector, netBatchesVector, memberSettings.back().get(), playSettings, firstThreadIdx));
+            memberAgents.back()->rootPredictionMutex = &rootPredictionMutex;
+        }
     }
 
 MCTSAgentTrueSight::~MCTSAgentTrueSight()
 {
-    for (auto searchThread : searchThreads) {
-        delete searchThread;
-    }
+    // the search threads are deleted by the MCTSAgent destructor
 }
 
 string MCTSAgentTrueSight::get_name() const
 {   
+   if (numberDeterminizations > 1) {
+       return "MCTSTrueSight-" + std::to_string(numberDeterminizations) + "-" + engineVersion + "-" + nets.front()->get_model_name();
+   }
    return "MCTSTrueSight-" + engineVersion + "-" + nets.front()->get_model_name();
 }
 
+void MCTSAgentTrueSight::evaluate_determinizations()
+{
+    evalInfo->isChess960 = state->is_chess960();
+    vector<EvalInfo> evals(numberDeterminizations, *evalInfo);
+    vector<unique_ptr<StateObj>> states;
+    // the node budget is spent on all determinizations, so that the latency per move doesn't grow with their number
+    vector<SearchLimits> limits(numberDeterminizations, *searchLimits);
+    // the determinizations which are searched after a "ponderhit" don't ponder anymore
+    isPondering = searchLimits->ponder;
+    for (size_t i = 0; i < numberDeterminizations; i++) {
+#ifdef MODE_STRATEGO
+        // every determinization assigns the hidden pieces of the opponent differently, the seeds follow Random_Seed
+        states.emplace_back(state->sample_hidden_pieces(thread_random()()));
+#else
+        // without hidden information all determinizations search the same state
+        states.emplace_back(state->clone());
+#endif
+        if (searchLimits->nodes != 0) {
+            limits[i].nodes = max(searchLimits->nodes / numberDeterminizations, size_t(1));
+        }
+    }
+
+    auto run_member_agent = [&](size_t memberIdx) {
+        MCTSAgent* agent = memberAgents[memberIdx].get();
+        for (size_t i = memberIdx; i < numberDeterminizations; i += memberAgents.size()) {
+            limits[i].ponder = isPondering;
+            agent->set_search_settings(states[i].get(), &limits[i], &evals[i]);
+            agent->evaluate_board_state();
+            set_eval_of_tree(agent, evals[i], searchSettings);
+        }
+    };
+    info_string("run mcts search on determinizations:", numberDeterminizations);
+    vector<thread> memberThreads;
+    for (size_t memberIdx = 0; memberIdx < memberAgents.size(); ++memberIdx) {
+        memberThreads.emplace_back(run_member_agent, memberIdx);
+    }
+    // the search can be stopped from now on
+    unlock_and_notify();
+    for (thread& memberThread : memberThreads) {
+        memberThread.join();
+    }
+
+    evalInfo->nodesPreSearch = init_root_node(state);
+    *evalInfo = evals[get_consensus_tree_idx(evals)];
+    lastValueEval = evalInfo->bestMoveQ[0];
+    update_nps_measurement(evalInfo->calculate_nps());
+}
+
 void MCTSAgentTrueSight::evaluate_board_state()
 {
+    if (numberDeterminizations > 1) {
+        evaluate_determinizations();
+        return;
+    }
     evalInfo->nodesPreSearch = init_root_node(state);
 
     thread tGCThread = thread(run_gc_thread, &gcThread);
@@ -94,3 +161,30 @@ void MCTSAgentTrueSight::evaluate_board_state()
     update_nps_measurement(evalInfo->calculate_nps());
     tGCThread.join();
 }
+
+void MCTSAgentTrueSight::stop()
+{
+    for (unique_ptr<MCTSAgent>& agent : memberAgents) {
+        if (agent->threadManager != nullptr) {
+            agent->threadManager->stop_search();
+        }
+    }
+    MCTSAgent::stop();
+}
+
+void MCTSAgentTrueSight::ponderhit()
+{
+    // resets isPondering first, so that the determinizations which haven't started yet don't ponder
+    MCTSAgent::ponderhit();
+    for (unique_ptr<MCTSAgent>& agent : memberAgents) {
+        agent->ponderhit();
+    }
+}
+
+void MCTSAgentTrueSight::apply_move_to_tree(Action move, bool ownMove)
+{
+    for (unique_ptr<MCTSAgent>& agent : memberAgents) {
+        agent->apply_move_to_tree(move, ownMove);
+    }
+    MCTSAgent::apply_move_to_tree(move, ownMove);
+}
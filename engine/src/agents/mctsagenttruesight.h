@@ -24,6 +24,7 @@
  *
  * The TrueSightAgent is used in games with imperfect information. In such situations it uses the perfect information state of the game.
  * In games with perfect information this is identical to the default MCTSAgent 
+ * With more than one determinization, the hidden information is sampled several times instead and the samples are searched concurrently.
  */
 
 #ifndef MCTSAGENTTRUESIGHT_H
@@ -47,11 +48,30 @@ using namespace crazyara;
 
 class MCTSAgentTrueSight : public MCTSAgent
 {
+private:
+    // number of sampled states of the hidden information which are searched for each move
+    size_t numberDeterminizations;
+    // agents which search the determinizations concurrently, each with its own part of the search threads
+    vector<unique_ptr<MCTSAgent>> memberAgents;
+    vector<unique_ptr<SearchSettings>> memberSettings;
+    RootPredictionMutex rootPredictionMutex;
+
+    /**
+     * @brief evaluate_determinizations Searches numberDeterminizations sampled states and selects the tree
+     * which agrees most with the combined policy of all trees (see MCTSAgentBatch)
+     */
+    void evaluate_determinizations();
+
 public:
+    /**
+     * @brief MCTSAgentTrueSight
+     * @param numberDeterminizations Number of sampled states of the hidden information, 1 searches the perfect information state
+     */
     MCTSAgentTrueSight(vector<unique_ptr<NeuralNetAPI>>& netSingleVector,
               vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
               SearchSettings* searchSettings,
-              PlaySettings* playSettings
+              PlaySettings* playSettings,
+              size_t numberDeterminizations=1
               );
     ~MCTSAgentTrueSight();
     MCTSAgentTrueSight(const MCTSAgentTrueSight&) = delete;
@@ -59,6 +79,9 @@ public:
 
     string get_name() const override;
     void evaluate_board_state() override;
+    void stop() override;
+    void ponderhit() override;
+    void apply_move_to_tree(Action move, bool ownMove) override;
 
 
 };
@@ -55,24 +55,62 @@ void RawNetAgent::evaluate_board_state()
         return;
     }
     state->get_state_planes(true, inputPlanes, nets.front()->get_version());
-    nets[phaseToNetsIndex.at(state->get_phase(numPhases, searchSettings->gamePhaseDefinition))]->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+    nets[get_phase_net_index(state->get_phase(numPhases, searchSettings->gamePhaseDefinition))]->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
     state->set_auxiliary_outputs(auxiliaryOutputs);
+    set_eval_info(0, state, *evalInfo);
+    unlock_and_notify();
+}
 
-    evalInfo->policyProbSmall.resize(evalInfo->legalMoves.size());
-    get_probs_of_move_list(0, probOutputs, evalInfo->legalMoves, state->mirror_policy(state->side_to_move()),
-                           !nets.front()->is_policy_map(), evalInfo->policyProbSmall, nets.front()->is_policy_map());
-    size_t selIdx = argmax(evalInfo->policyProbSmall);
-    Action bestmove = evalInfo->legalMoves[selIdx];
+void RawNetAgent::set_eval_info(size_t batchIdx, const StateObj* state, EvalInfo& evalInfo) const
+{
+    evalInfo.centipawns[0] = value_to_centipawn(valueOutputs[batchIdx]);
+    evalInfo.bestMoveQ[0] = valueOutputs[batchIdx];
+    evalInfo.movesToMate[0] = 0;
+    evalInfo.depth = 1;
+    evalInfo.selDepth = 1;
+    evalInfo.tbHits = 0;
+    evalInfo.nodes = 1;
+    evalInfo.isChess960 = state->is_chess960();
+    if (evalInfo.legalMoves.empty()) {
+        evalInfo.pv[0].clear();
+        return;
+    }
+    evalInfo.policyProbSmall.resize(evalInfo.legalMoves.size());
+    get_probs_of_move_list(batchIdx, probOutputs, evalInfo.legalMoves, state->mirror_policy(state->side_to_move()),
+                           !nets.front()->is_policy_map(), evalInfo.policyProbSmall, nets.front()->is_policy_map());
+    size_t selIdx = argmax(evalInfo.policyProbSmall);
+    evalInfo.pv[0] = { evalInfo.legalMoves[selIdx] };
+}
 
-    evalInfo->centipawns[0] = value_to_centipawn(valueOutputs[0]);
-    evalInfo->movesToMate[0] = 0;
-    evalInfo->depth = 1;
-    evalInfo->selDepth = 1;
-    evalInfo->tbHits = 0;
-    evalInfo->nodes = 1;
-    evalInfo->isChess960 = state->is_chess960();
-    evalInfo->pv[0] = { bestmove };
-    unlock_and_notify();
+void RawNetAgent::evaluate_states(const vector<unique_ptr<StateObj>>& states, vector<EvalInfo>& evalInfos)
+{
+    evalInfos.resize(states.size());
+    const size_t batchSize = nets.front()->get_batch_size();
+    const size_t numberInputValues = nets.front()->get_nb_input_values_total();
+    vector<vector<size_t>> netPositions(nets.size());
+    for (size_t idx = 0; idx < states.size(); ++idx) {
+        netPositions[get_phase_net_index(states[idx]->get_phase(numPhases, searchSettings->gamePhaseDefinition))].push_back(idx);
+    }
+    for (size_t netIdx = 0; netIdx < nets.size(); ++netIdx) {
+        const vector<size_t>& positions = netPositions[netIdx];
+        for (size_t start = 0; start < positions.size(); start += batchSize) {
+            const size_t numberPositions = min(batchSize, positions.size() - start);
+            for (size_t batchIdx = 0; batchIdx < numberPositions; ++batchIdx) {
+                states[positions[start + batchIdx]]->get_state_planes(true, inputPlanes + batchIdx * numberInputValues, nets.front()->get_version());
+            }
+            // the last mini-batch is usually incomplete
+            nets[netIdx]->set_number_positions(numberPositions);
+            nets[netIdx]->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+            nets[netIdx]->set_number_positions(batchSize);
+            for (size_t batchIdx = 0; batchIdx < numberPositions; ++batchIdx) {
+                const StateObj* state = states[positions[start + batchIdx]].get();
+                EvalInfo& evalInfo = evalInfos[positions[start + batchIdx]];
+                evalInfo.legalMoves = state->legal_actions();
+                evalInfo.init_vectors_for_multi_pv(1UL);
+                set_eval_info(batchIdx, state, evalInfo);
+            }
+        }
+    }
 }
 
 void RawNetAgent::stop()
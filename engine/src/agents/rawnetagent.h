@@ -53,6 +53,23 @@ public:
     void stop() override;
 
     void apply_move_to_tree(Action move, bool ownMove) override;
+
+    /**
+     * @brief evaluate_states Evaluates the given positions in mini-batches of the network batch size without a search.
+     * The positions are grouped by the network of their game phase.
+     * @param states Positions to evaluate
+     * @param evalInfos Output, the network evaluation of each position
+     */
+    void evaluate_states(const vector<unique_ptr<StateObj>>& states, vector<EvalInfo>& evalInfos);
+
+private:
+    /**
+     * @brief set_eval_info Sets the policy, value and best move of a position from the network outputs
+     * @param batchIdx Index of the position in the mini-batch
+     * @param state Evaluated position
+     * @param evalInfo Evaluation with the legal moves of the position
+     */
+    void set_eval_info(size_t batchIdx, const StateObj* state, EvalInfo& evalInfo) const;
 };
 
 #endif // RAWNETAGENT_H
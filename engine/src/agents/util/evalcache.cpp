@@ -0,0 +1,190 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: evalcache.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "evalcache.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include "../../util/halfconversion.h"
+#include "../../util/largepages.h"
+
+EvalCache::EvalCache(size_t numberBytes, const string& modelName, Version version, bool colourSymmetric):
+    modelKey(std::hash<string>()(modelName)),
+    version(version),
+    colourSymmetric(colourSymmetric),
+    hits(0)
+{
+    size_t numberEntries = EVAL_CACHE_BUCKET_SIZE;
+    while (numberEntries * 2 * sizeof(EvalCacheEntry) <= numberBytes) {
+        numberEntries *= 2;
+    }
+    static_assert(std::is_trivially_destructible<EvalCacheEntry>::value, "The entries are released without calling their destructors");
+    entries = static_cast<EvalCacheEntry*>(large_page_allocate(numberEntries * sizeof(EvalCacheEntry), alignof(EvalCacheEntry)));
+    for (size_t idx = 0; idx < numberEntries; ++idx) {
+        new (&entries[idx]) EvalCacheEntry;
+    }
+    mask = numberEntries - 1;
+    clear();
+}
+
+EvalCache::~EvalCache()
+{
+    large_page_free(entries, (mask + 1) * sizeof(EvalCacheEntry));
+}
+
+Key EvalCache::get_cache_key(const Node* node, Key stateKey) const
+{
+    // the plies from null are part of the network input
+    return stateKey ^ modelKey ^ (Key(node->plies_from_null()) * 0x9E3779B97F4A7C15ULL);
+}
+
+void fill_canonical_order(const uint32_t* policyIndices, size_t numberMoves, uint8_t* order)
+{
+    for (size_t idx = 0; idx < numberMoves; ++idx) {
+        order[idx] = uint8_t(idx);
+    }
+    std::sort(order, order + numberMoves, [policyIndices](uint8_t lhs, uint8_t rhs) { return policyIndices[lhs] < policyIndices[rhs]; });
+}
+
+void fill_canonical_order(const Node* node, bool mirrorPolicy, uint8_t* order)
+{
+    uint32_t policyIndices[EVAL_CACHE_MAX_MOVES];
+    node->fill_policy_indices(policyIndices, mirrorPolicy);
+    fill_canonical_order(policyIndices, node->get_number_child_nodes(), order);
+}
+
+Key EvalCache::get_state_key(const StateObj& state) const
+{
+    return colourSymmetric ? state.colour_symmetric_hash_key(version) : state.hash_key();
+}
+
+bool EvalCache::probe(Node* node, Key stateKey, bool mirrorPolicy)
+{
+    const size_t numberMoves = node->get_number_child_nodes();
+    if (numberMoves == 0 || numberMoves > EVAL_CACHE_MAX_MOVES) {
+        return false;
+    }
+    const Key key = get_cache_key(node, stateKey);
+    uint16_t policy[EVAL_CACHE_MAX_MOVES];
+    for (size_t idx = 0; idx < EVAL_CACHE_BUCKET_SIZE; ++idx) {
+        EvalCacheEntry& entry = entries[(key + idx) & mask];
+        const uint32_t sequence = entry.sequence.load(memory_order_acquire);
+        if ((sequence & 1) != 0 || entry.key.load(memory_order_relaxed) != key) {
+            continue;
+        }
+        const size_t entryMoves = entry.numberMoves;
+        const float value = entry.value;
+        memcpy(policy, entry.policy, numberMoves * sizeof(uint16_t));
+        atomic_thread_fence(memory_order_acquire);
+        if (entry.sequence.load(memory_order_relaxed) != sequence || entryMoves != numberMoves) {
+            continue;
+        }
+        entry.referenced.store(1, memory_order_relaxed);
+        if (colourSymmetric) {
+            uint8_t order[EVAL_CACHE_MAX_MOVES];
+            fill_canonical_order(node, mirrorPolicy, order);
+            float* policyProbs = node->get_policy_prob_small().data();
+            for (size_t rank = 0; rank < numberMoves; ++rank) {
+                policyProbs[order[rank]] = half_to_float_scalar(policy[rank]);
+            }
+        }
+        else {
+            half_to_float(policy, node->get_policy_prob_small().data(), numberMoves);
+        }
+        node->set_value(value);
+        ++hits;
+        return true;
+    }
+    return false;
+}
+
+void EvalCache::store(Node* node, Key stateKey, bool mirrorPolicy)
+{
+    const size_t numberMoves = node->get_number_child_nodes();
+    if (numberMoves == 0 || numberMoves > EVAL_CACHE_MAX_MOVES || node->is_terminal() || node->is_tablebase()) {
+        return;
+    }
+    const Key key = get_cache_key(node, stateKey);
+    const size_t bucketIdx = size_t(key) & mask;
+
+    // clock replacement: prefer the same key, then the first entry which wasn't referenced since the last sweep
+    EvalCacheEntry* victim = nullptr;
+    for (size_t idx = 0; idx < EVAL_CACHE_BUCKET_SIZE && victim == nullptr; ++idx) {
+        EvalCacheEntry& entry = entries[(bucketIdx + idx) & mask];
+        if (entry.key.load(memory_order_relaxed) == key) {
+            victim = &entry;
+        }
+    }
+    for (size_t idx = 0; idx < EVAL_CACHE_BUCKET_SIZE && victim == nullptr; ++idx) {
+        EvalCacheEntry& entry = entries[(bucketIdx + idx) & mask];
+        if (entry.referenced.exchange(0, memory_order_relaxed) == 0) {
+            victim = &entry;
+        }
+    }
+    if (victim == nullptr) {
+        // all entries have been referenced and received their second chance
+        victim = &entries[bucketIdx];
+    }
+
+    uint32_t sequence = victim->sequence.load(memory_order_relaxed);
+    if ((sequence & 1) != 0 || !victim->sequence.compare_exchange_strong(sequence, sequence + 1, memory_order_acquire)) {
+        return;
+    }
+    atomic_thread_fence(memory_order_release);
+    victim->key.store(key, memory_order_relaxed);
+    victim->numberMoves = uint16_t(numberMoves);
+    victim->value = node->get_value();
+    if (colourSymmetric) {
+        uint8_t order[EVAL_CACHE_MAX_MOVES];
+        fill_canonical_order(node, mirrorPolicy, order);
+        const float* policyProbs = node->get_policy_prob_small().data();
+        for (size_t rank = 0; rank < numberMoves; ++rank) {
+            victim->policy[rank] = float_to_half_scalar(policyProbs[order[rank]]);
+        }
+    }
+    else {
+        float_to_half(node->get_policy_prob_small().data(), victim->policy, numberMoves);
+    }
+    victim->referenced.store(0, memory_order_relaxed);
+    victim->sequence.store(sequence + 2, memory_order_release);
+}
+
+void EvalCache::clear()
+{
+    for (size_t idx = 0; idx <= mask; ++idx) {
+        entries[idx].sequence.store(0, memory_order_relaxed);
+        entries[idx].referenced.store(0, memory_order_relaxed);
+        entries[idx].key.store(0, memory_order_relaxed);
+        entries[idx].numberMoves = 0;
+    }
+}
+
+size_t EvalCache::get_hits() const
+{
+    return hits;
+}
@@ -0,0 +1,147 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: evalcache.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Fixed size cache for the neural network evaluations which is kept across searches.
+ * Each entry holds the value and the legal move policy of a position in half precision.
+ * Readers and writers don't use locks: every entry is guarded by a sequence counter
+ * and the entries of a bucket are replaced by the clock (second chance) algorithm.
+ * Optionally, a position and its colour mirrored counterpart share an entry if the network can't distinguish them.
+ * The policy of these entries is stored in the order of the (mirrored) policy indices and un-mirrored on look-up.
+ */
+
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include "../../node.h"
+
+// positions with more legal moves are not cached
+#define EVAL_CACHE_MAX_MOVES 80
+// number of neighbouring entries which are searched for a key
+#define EVAL_CACHE_BUCKET_SIZE 4
+
+/**
+ * @brief The EvalCacheEntry struct stores the network outputs of a single position.
+ * The sequence counter is odd while the entry is written.
+ */
+struct alignas(64) EvalCacheEntry
+{
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint8_t> referenced;
+    uint16_t numberMoves;
+    std::atomic<Key> key;
+    float value;
+    uint16_t policy[EVAL_CACHE_MAX_MOVES];
+};
+
+/**
+ * @brief fill_canonical_order Sorts the move indices by the policy index of their moves.
+ * The order is identical for a position and its colour mirrored counterpart if the policy of the side to move is mirrored.
+ * @param policyIndices (Mirrored) policy index of every legal move
+ * @param numberMoves Number of legal moves (at most EVAL_CACHE_MAX_MOVES)
+ * @param order Output array with numberMoves entries
+ */
+void fill_canonical_order(const uint32_t* policyIndices, size_t numberMoves, uint8_t* order);
+
+/**
+ * @brief fill_canonical_order Sorts the child indices of the node by the policy index of their moves
+ * @param node Node object with at most EVAL_CACHE_MAX_MOVES child nodes
+ * @param mirrorPolicy Decides if the policy of the node is mirrored
+ * @param order Output array with get_number_child_nodes() entries
+ */
+void fill_canonical_order(const Node* node, bool mirrorPolicy, uint8_t* order);
+
+class EvalCache
+{
+private:
+    // the table can be backed by huge pages (see largepages.h)
+    EvalCacheEntry* entries;
+    size_t mask;
+    Key modelKey;
+    Version version;
+    bool colourSymmetric;
+    std::atomic<size_t> hits;
+
+    /**
+     * @brief get_cache_key Combines the state key of the node with its plies from null and the model identity
+     * @param node Node object
+     * @param stateKey Key returned by get_state_key()
+     * @return Key
+     */
+    Key get_cache_key(const Node* node, Key stateKey) const;
+
+public:
+    /**
+     * @brief EvalCache
+     * @param numberBytes Memory size of the cache (rounded down to a power of two number of entries)
+     * @param modelName Identity of the neural network which is part of every key
+     * @param version Input representation version of the neural network
+     * @param colourSymmetric Decides if colour mirrored positions share their entries
+     */
+    EvalCache(size_t numberBytes, const string& modelName, Version version, bool colourSymmetric);
+    ~EvalCache();
+    EvalCache(const EvalCache&) = delete;
+    EvalCache& operator=(const EvalCache&) = delete;
+
+    /**
+     * @brief get_state_key Returns the key of the given state which is passed to probe() and store()
+     * @param state State of the node
+     * @return Key
+     */
+    Key get_state_key(const StateObj& state) const;
+
+    /**
+     * @brief probe Looks up the network outputs for the given node and assigns its value and policy on success
+     * @param node Newly created node without network results
+     * @param stateKey Key returned by get_state_key()
+     * @param mirrorPolicy Decides if the policy of the node is mirrored
+     * @return True, if the node was found in the cache
+     */
+    bool probe(Node* node, Key stateKey, bool mirrorPolicy);
+
+    /**
+     * @brief store Inserts the value and policy of a node which was just evaluated by the neural network.
+     * The insertion is skipped if the entry is written by another thread at the same time.
+     * @param node Node with network results
+     * @param stateKey Key returned by get_state_key()
+     * @param mirrorPolicy Decides if the policy of the node is mirrored
+     */
+    void store(Node* node, Key stateKey, bool mirrorPolicy);
+
+    /**
+     * @brief clear Removes all entries, e.g. when a different neural network is loaded
+     */
+    void clear();
+
+    /**
+     * @brief get_hits Returns the number of successful look-ups since the creation of the cache
+     * @return size_t
+     */
+    size_t get_hits() const;
+};
+
+#endif // EVALCACHE_H
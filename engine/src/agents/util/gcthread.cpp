@@ -21,10 +21,154 @@
  */
 
 #include "gcthread.h"
+#include <thread>
+#include "../../util/tracerecorder.h"
+#include "../../util/memorystats.h"
 
 
 
 void run_gc_thread(GCThread *t)
 {
+    trace_recorder().set_thread_name("GCThread");
+    TRACE_SCOPE("gc_delete");
+#ifdef MCTS_NODE_POOL
+    if (t->oldRootNode != nullptr) {
+        free_unreachable_nodes(t->oldRootNode.get(), t->newRootNode, t->mapWithMutex);
+    }
     t->oldRootNode = nullptr;
+#else
+    release_tree(t->oldRootNode);
+#endif
 }
+
+#ifndef MCTS_NODE_POOL
+/**
+ * @brief release_subtrees Releases the given links with rate limiting (executed by each garbage collector thread)
+ * @param links Links to the subtrees
+ * @param startIdx First link of this thread
+ * @param endIdx End of the links of this thread (exclusive)
+ */
+void release_subtrees(vector<shared_ptr<Node>>* links, size_t startIdx, size_t endIdx)
+{
+    set_node_release_yield_interval(GC_YIELD_INTERVAL);
+    for (size_t idx = startIdx; idx < endIdx; ++idx) {
+        (*links)[idx] = nullptr;
+    }
+    set_node_release_yield_interval(0);
+}
+
+void release_tree(shared_ptr<Node>& rootNode)
+{
+#ifdef MCTS_NODE_ARENA
+    set_node_release_yield_interval(GC_YIELD_INTERVAL);
+    rootNode = nullptr;
+    set_node_release_yield_interval(0);
+#else
+    if (rootNode == nullptr || rootNode.use_count() > 1 || !rootNode->is_playout_node()) {
+        // the root node is still referenced (e.g. it is the new root node) or has no subtrees
+        rootNode = nullptr;
+        return;
+    }
+    // keep the subtrees alive while the root node is destroyed
+    vector<shared_ptr<Node>> links;
+    for (auto it = rootNode->get_node_it_begin(); it != rootNode->get_node_it_end(); ++it) {
+        shared_ptr<Node> link = atomic_load(&*it);
+        if (link != nullptr) {
+            links.emplace_back(std::move(link));
+        }
+    }
+    rootNode = nullptr;
+
+    const size_t numberThreads = min(size_t(GC_NUMBER_THREADS), links.size());
+    vector<thread> threads;
+    for (size_t threadIdx = 1; threadIdx < numberThreads; ++threadIdx) {
+        threads.emplace_back(release_subtrees, &links, threadIdx * links.size() / numberThreads, (threadIdx+1) * links.size() / numberThreads);
+    }
+    release_subtrees(&links, 0, numberThreads == 0 ? 0 : links.size() / numberThreads);
+    for (thread& t : threads) {
+        t.join();
+    }
+#endif
+}
+#endif
+
+#ifdef MCTS_NODE_POOL
+/**
+ * @brief release_node_reference Removes a reference to the given node and erases the node from the hash table if no reference is left.
+ * The lock of the corresponding hash shard is held during the update, so that no search thread can link to the node at the same time.
+ * @param idx Node index
+ * @param isParentLink True, if the reference is a link from a parent node, false for the reference of a root node
+ * @param mapWithMutex Hash table
+ * @return True, if the node isn't referenced anymore and can be freed
+ */
+bool release_node_reference(NodeIdx idx, bool isParentLink, MapWithMutex* mapWithMutex)
+{
+    Node* node = node_pool().get(idx);
+    HashShard& shard = mapWithMutex->get_shard(node->hash_key());
+    lock_guard<HashMutex> lock(shard.mtx);
+    node->lock();
+    if (isParentLink) {
+        if (node->is_root_node()) {
+            // the node is already scheduled for deletion or is a root node
+            node->unlock();
+            return false;
+        }
+        node->decrement_number_parents();
+    }
+    const bool unreferenced = node->is_root_node();
+    node->unlock();
+    if (unreferenced) {
+        HashMap::const_iterator it = shard.hashTable.find(node->hash_key());
+        if (it != shard.hashTable.end() && it->second.node == idx) {
+            shard.hashTable.erase(it);
+            memory_stats().add(MEMORY_HASH_TABLE, -HASH_ENTRY_MEMORY_SIZE);
+        }
+    }
+    return unreferenced;
+}
+
+/**
+ * @brief free_unreferenced_nodes Frees the given nodes and all their descendants which aren't referenced by any other node
+ * @param unreferencedNodes Nodes which have no parent nodes left
+ * @param newRootNode Root node which must not be freed (can be a nullptr)
+ * @param mapWithMutex Hash table
+ */
+void free_unreferenced_nodes(vector<NodeIdx>& unreferencedNodes, const Node* newRootNode, MapWithMutex* mapWithMutex)
+{
+    while (!unreferencedNodes.empty()) {
+        const NodeIdx idx = unreferencedNodes.back();
+        unreferencedNodes.pop_back();
+        const Node* node = node_pool().get(idx);
+        if (node->is_playout_node()) {
+            for (auto it = node->get_node_it_begin(); it != node->get_node_it_end(); ++it) {
+                if (*it != NO_NODE_IDX && get_node_ptr(*it) != newRootNode && release_node_reference(*it, true, mapWithMutex)) {
+                    unreferencedNodes.emplace_back(*it);
+                }
+            }
+        }
+        node_pool().free_node(idx);
+    }
+}
+
+void free_unreachable_nodes(Node* oldRootNode, const Node* newRootNode, MapWithMutex* mapWithMutex)
+{
+    if (oldRootNode == newRootNode) {
+        return;
+    }
+    const NodeIdx rootIdx = node_pool().get_idx(oldRootNode);
+    if (rootIdx == NO_NODE_IDX || !release_node_reference(rootIdx, false, mapWithMutex)) {
+        return;
+    }
+    vector<NodeIdx> unreferencedNodes = {rootIdx};
+    free_unreferenced_nodes(unreferencedNodes, newRootNode, mapWithMutex);
+}
+
+void release_detached_node(NodeIdx idx, MapWithMutex* mapWithMutex)
+{
+    if (!release_node_reference(idx, true, mapWithMutex)) {
+        return;
+    }
+    vector<NodeIdx> unreferencedNodes = {idx};
+    free_unreferenced_nodes(unreferencedNodes, nullptr, mapWithMutex);
+}
+#endif
@@ -29,12 +29,23 @@
 #include "node.h"
 using namespace std;
 
+// maximum number of threads which destroy the subtrees of the old root node in parallel
+#define GC_NUMBER_THREADS 2
+// number of released nodes after which a garbage collector thread yields to the search threads
+#define GC_YIELD_INTERVAL 1024
+
 /**
  * @brief The GCThread class is a garbage collector object which asynchronously frees memory
  */
 struct GCThread
 {
     shared_ptr<Node> oldRootNode;
+#ifdef MCTS_NODE_POOL
+    // root node of the current search which must be kept alive together with its subtree
+    const Node* newRootNode = nullptr;
+    // hash table from which freed nodes are removed
+    MapWithMutex* mapWithMutex = nullptr;
+#endif
 public:
     void delete_elements() {
         oldRootNode = nullptr;
@@ -47,4 +58,36 @@ public:
  */
 void run_gc_thread(GCThread *t);
 
+#ifndef MCTS_NODE_POOL
+/**
+ * @brief release_tree Releases the reference to the given root node and destroys all nodes which aren't referenced anymore.
+ * The subtrees of the root node are split across up to GC_NUMBER_THREADS threads. Each thread destroys its subtrees
+ * iteratively and yields every GC_YIELD_INTERVAL nodes, so that the search threads aren't starved.
+ * If MCTS_NODE_ARENA is defined, the tree is released by the calling thread because the arena chunks
+ * are returned in one piece and the remaining work is small.
+ * @param rootNode Root node of the former search which is reset to a nullptr
+ */
+void release_tree(shared_ptr<Node>& rootNode);
+#endif
+
+#ifdef MCTS_NODE_POOL
+/**
+ * @brief free_unreachable_nodes Frees all nodes of the old tree which can't be reached from the new root node anymore.
+ * Starting from the old root node, the parent counter of each child node is decremented and a node is freed
+ * as soon as it has no parent nodes left.
+ * @param oldRootNode Root node of the former search
+ * @param newRootNode Root node of the next search (can be a nullptr)
+ * @param mapWithMutex Hash table which is shared with the search threads
+ */
+void free_unreachable_nodes(Node* oldRootNode, const Node* newRootNode, MapWithMutex* mapWithMutex);
+
+/**
+ * @brief release_detached_node Removes the parent link of a node which has been detached from its parent node
+ * and frees the node together with all of its descendants which can't be reached anymore.
+ * @param idx Index of the detached node
+ * @param mapWithMutex Hash table which is shared with the search threads
+ */
+void release_detached_node(NodeIdx idx, MapWithMutex* mapWithMutex);
+#endif
+
 #endif // GCTHREAD_H
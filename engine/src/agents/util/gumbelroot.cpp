@@ -0,0 +1,174 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: gumbelroot.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "gumbelroot.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "../../util/randomgen.h"
+
+float gumbel_transformed_q(float qValue, uint32_t maxVisits, float cVisit, float cScale)
+{
+    return (cVisit + maxVisits) * cScale * (qValue + 1.0f) * 0.5f;
+}
+
+void gumbel_improved_policy(const DynamicVector<float>& priors, const DynamicVector<float>& completedQ, uint32_t maxVisits,
+                            float cVisit, float cScale, DynamicVector<double>& policy)
+{
+    policy.resize(priors.size());
+    if (priors.size() == 0) {
+        return;
+    }
+    for (size_t idx = 0; idx < priors.size(); ++idx) {
+        policy[idx] = std::log(std::max(priors[idx], FLT_MIN)) + gumbel_transformed_q(completedQ[idx], maxVisits, cVisit, cScale);
+    }
+    // the highest logit is subtracted to avoid an overflow
+    const double maxLogit = max(policy);
+    for (size_t idx = 0; idx < policy.size(); ++idx) {
+        policy[idx] = std::exp(policy[idx] - maxLogit);
+    }
+    policy /= sum(policy);
+}
+
+uint32_t sequential_halving_phase_visits(size_t budget, size_t numberPhases, size_t numberCandidates)
+{
+    if (numberPhases == 0 || numberCandidates == 0) {
+        return 1;
+    }
+    return std::max(uint32_t(1), uint32_t(budget / (numberPhases * numberCandidates)));
+}
+
+GumbelRoot::GumbelRoot():
+    targetVisits(0),
+    budget(0),
+    numberPhases(0),
+    cVisit(0),
+    cScale(0),
+    active(false)
+{
+}
+
+void GumbelRoot::init(Node* rootNode, size_t budget, const SearchSettings* searchSettings)
+{
+    const size_t numberChildren = rootNode->get_number_child_nodes();
+    const DynamicVector<float>& priors = rootNode->get_policy_prob_small();
+    FastRandom& random = thread_random();
+    scores.resize(numberChildren);
+    visitsPreSearch.resize(numberChildren);
+    std::vector<ChildIdx> childIndices(numberChildren);
+    for (ChildIdx childIdx = 0; childIdx < numberChildren; ++childIdx) {
+        const float gumbelNoise = -std::log(-std::log(std::max(random.uniform(), FLT_MIN)));
+        scores[childIdx] = gumbelNoise + std::log(std::max(priors[childIdx], FLT_MIN));
+        visitsPreSearch[childIdx] = rootNode->get_child_number_visits(childIdx);
+        childIndices[childIdx] = childIdx;
+    }
+    const size_t topK = std::min(size_t(searchSettings->gumbelTopK), numberChildren);
+    std::partial_sort(childIndices.begin(), childIndices.begin() + topK, childIndices.end(),
+                      [this](ChildIdx lhs, ChildIdx rhs) { return scores[lhs] > scores[rhs]; });
+    candidates.assign(childIndices.begin(), childIndices.begin() + topK);
+
+    this->budget = budget;
+    numberPhases = topK > 1 ? size_t(std::ceil(std::log2(topK))) : 1;
+    targetVisits = sequential_halving_phase_visits(budget, numberPhases, candidates.size());
+    cVisit = searchSettings->gumbelCVisit;
+    cScale = searchSettings->gumbelCScale;
+    active = !candidates.empty();
+}
+
+void GumbelRoot::reset()
+{
+    active = false;
+}
+
+bool GumbelRoot::is_active() const
+{
+    return active;
+}
+
+float GumbelRoot::get_final_score(const Node* rootNode, ChildIdx childIdx, uint32_t maxVisits) const
+{
+    if (rootNode->get_child_number_visits(childIdx) == 0) {
+        // unvisited candidates are only compared by their prior and noise
+        return scores[childIdx];
+    }
+    return scores[childIdx] + gumbel_transformed_q(rootNode->get_q_value(childIdx), maxVisits, cVisit, cScale);
+}
+
+void GumbelRoot::halve_candidates(const Node* rootNode)
+{
+    const uint32_t maxVisits = max(rootNode->get_child_number_visits());
+    std::sort(candidates.begin(), candidates.end(), [&](ChildIdx lhs, ChildIdx rhs) {
+        return get_final_score(rootNode, lhs, maxVisits) > get_final_score(rootNode, rhs, maxVisits);
+    });
+    candidates.resize(std::max(size_t(1), candidates.size() / 2));
+    targetVisits += sequential_halving_phase_visits(budget, numberPhases, candidates.size());
+}
+
+ChildIdx GumbelRoot::select_child(const Node* rootNode)
+{
+    while (true) {
+        ChildIdx selectedIdx = candidates.front();
+        uint32_t fewestVisits = UINT32_MAX;
+        for (ChildIdx childIdx : candidates) {
+            const uint32_t visits = rootNode->get_child_number_visits(childIdx) - visitsPreSearch[childIdx];
+            if (visits < fewestVisits) {
+                fewestVisits = visits;
+                selectedIdx = childIdx;
+            }
+        }
+        // the last candidate receives the remaining simulations
+        if (fewestVisits < targetVisits || candidates.size() == 1) {
+            return selectedIdx;
+        }
+        halve_candidates(rootNode);
+    }
+}
+
+ChildIdx GumbelRoot::get_best_child(const Node* rootNode) const
+{
+    const uint32_t maxVisits = max(rootNode->get_child_number_visits());
+    ChildIdx bestIdx = candidates.front();
+    float bestScore = -FLT_MAX;
+    for (ChildIdx childIdx : candidates) {
+        const float score = get_final_score(rootNode, childIdx, maxVisits);
+        if (score > bestScore) {
+            bestScore = score;
+            bestIdx = childIdx;
+        }
+    }
+    return bestIdx;
+}
+
+void GumbelRoot::get_improved_policy(Node* rootNode, DynamicVector<double>& policy) const
+{
+    const size_t numberChildren = rootNode->get_number_child_nodes();
+    const DynamicVector<uint32_t> childVisits = rootNode->get_child_number_visits();
+    DynamicVector<float> completedQ(numberChildren);
+    const float valueEval = rootNode->updated_value_eval();
+    for (ChildIdx childIdx = 0; childIdx < numberChildren; ++childIdx) {
+        completedQ[childIdx] = childVisits[childIdx] != 0 ? rootNode->get_q_value(childIdx) : valueEval;
+    }
+    gumbel_improved_policy(rootNode->get_policy_prob_small(), completedQ, max(childVisits), cVisit, cScale, policy);
+}
@@ -0,0 +1,140 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: gumbelroot.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Root selection by Gumbel top-k sampling and sequential halving (Danihelka et al., "Policy improvement by planning with Gumbel", 2022).
+ * The m candidates with the highest g(a) + log(pi(a)) are visited evenly in ceil(log2(m)) phases and the worse half is dropped after each phase.
+ * The remaining candidate is played and the improved policy softmax(log(pi) + sigma(completedQ)) is used as the policy target.
+ * Only the root node is affected, all other nodes keep the PUCT selection.
+ */
+
+#ifndef GUMBELROOT_H
+#define GUMBELROOT_H
+
+#include <vector>
+#include "../../node.h"
+#include "../config/searchsettings.h"
+#include "../../util/blazeutil.h"
+
+/**
+ * @brief gumbel_transformed_q Returns the monotonic transformation sigma(q) = (cVisit + maxVisits) * cScale * q for a Q-value in [-1,1]
+ * which is rescaled to [0,1] beforehand
+ * @param qValue Q-value in [-1,1]
+ * @param maxVisits Highest number of visits of a child node
+ * @param cVisit Visit offset of the transformation
+ * @param cScale Scale of the transformation
+ */
+float gumbel_transformed_q(float qValue, uint32_t maxVisits, float cVisit, float cScale);
+
+/**
+ * @brief gumbel_improved_policy Computes the improved policy softmax(log(priors) + sigma(completedQ))
+ * @param priors Prior policy of the child nodes
+ * @param completedQ Q-values of the child nodes, unvisited child nodes are completed by the value of the parent
+ * @param maxVisits Highest number of visits of a child node
+ * @param cVisit Visit offset of sigma()
+ * @param cScale Scale of sigma()
+ * @param policy Return value which will be resized to the number of child nodes
+ */
+void gumbel_improved_policy(const DynamicVector<float>& priors, const DynamicVector<float>& completedQ, uint32_t maxVisits,
+                            float cVisit, float cScale, DynamicVector<double>& policy);
+
+/**
+ * @brief sequential_halving_phase_visits Returns the number of visits of each candidate in a single phase of sequential halving
+ * @param budget Number of simulations of the search
+ * @param numberPhases Number of phases ceil(log2(m))
+ * @param numberCandidates Number of candidates of the current phase
+ * @return Visits per candidate, at least one
+ */
+uint32_t sequential_halving_phase_visits(size_t budget, size_t numberPhases, size_t numberCandidates);
+
+/**
+ * @brief The GumbelRoot class stores the state of sequential halving for the root node of a single search.
+ * select_child() must be called while holding the lock of the root node.
+ */
+class GumbelRoot
+{
+private:
+    // g(a) + log(pi(a)) for every child node
+    std::vector<float> scores;
+    // child indices which are still considered
+    std::vector<ChildIdx> candidates;
+    // visits of the child nodes before the search (reused tree)
+    std::vector<uint32_t> visitsPreSearch;
+    // visits since the start of the search which every candidate has to reach before the next halving
+    uint32_t targetVisits;
+    size_t budget;
+    size_t numberPhases;
+    float cVisit;
+    float cScale;
+    bool active;
+
+    /**
+     * @brief get_final_score Returns g(a) + log(pi(a)) + sigma(q(a)) which decides which candidates are kept
+     */
+    float get_final_score(const Node* rootNode, ChildIdx childIdx, uint32_t maxVisits) const;
+
+    /**
+     * @brief halve_candidates Keeps the better half of the candidates and raises the visit target for the next phase
+     */
+    void halve_candidates(const Node* rootNode);
+
+public:
+    GumbelRoot();
+
+    /**
+     * @brief init Samples the Gumbel noise and selects the top-k candidates of the root node.
+     * The root node must be fully expanded.
+     * @param rootNode Root node of the search
+     * @param budget Number of simulations of the search
+     * @param searchSettings Search settings which provide gumbelTopK, gumbelCVisit and gumbelCScale
+     */
+    void init(Node* rootNode, size_t budget, const SearchSettings* searchSettings);
+
+    /**
+     * @brief reset Disables the Gumbel root selection until the next init() call
+     */
+    void reset();
+
+    bool is_active() const;
+
+    /**
+     * @brief select_child Returns the candidate with the fewest visits of the current phase and starts the next phase once all candidates reached the visit target
+     * @param rootNode Root node of the search
+     * @return Child index
+     */
+    ChildIdx select_child(const Node* rootNode);
+
+    /**
+     * @brief get_best_child Returns the remaining candidate with the highest final score which is the move to play
+     */
+    ChildIdx get_best_child(const Node* rootNode) const;
+
+    /**
+     * @brief get_improved_policy Returns the improved policy of the root node which is used as the policy target
+     * @param rootNode Root node of the search
+     * @param policy Return value in the order of the child nodes
+     */
+    void get_improved_policy(Node* rootNode, DynamicVector<double>& policy) const;
+};
+
+#endif // GUMBELROOT_H
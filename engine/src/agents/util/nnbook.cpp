@@ -0,0 +1,233 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: nnbook.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "nnbook.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include "../../stateobj.h"
+#include "../../util/communication.h"
+#include "../../util/halfconversion.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Key get_nn_book_key(const StateObj& state, Version version)
+{
+    // the plies from null are part of the network input
+    return state.colour_symmetric_hash_key(version) ^ (Key(state.steps_from_null()) * 0x9E3779B97F4A7C15ULL);
+}
+
+NNBook::NNBook(const string& filePath, const string& modelName, Version version):
+    fileData(nullptr),
+    fileSize(0),
+    entries(nullptr),
+    numberEntries(0),
+    version(version)
+{
+    map_file(filePath);
+    NNBookHeader header;
+    if (fileSize < sizeof(NNBookHeader)) {
+        throw invalid_argument("Given nn book: " + filePath + " is too small.");
+    }
+    memcpy(&header, fileData, sizeof(NNBookHeader));
+    if (header.magic != NN_BOOK_MAGIC || header.maxMoves != EVAL_CACHE_MAX_MOVES ||
+            fileSize != sizeof(NNBookHeader) + header.numberEntries * sizeof(NNBookEntry)) {
+        throw invalid_argument("Given nn book: " + filePath + " has an invalid format.");
+    }
+    if (header.modelKey != std::hash<string>()(modelName) || header.version != version) {
+        throw invalid_argument("Given nn book: " + filePath + " was created for a different model.");
+    }
+    entries = reinterpret_cast<const NNBookEntry*>(fileData + sizeof(NNBookHeader));
+    numberEntries = header.numberEntries;
+    info_string("Loaded nn book:", filePath, "(" + to_string(numberEntries) + " positions)");
+}
+
+NNBook::~NNBook()
+{
+#ifndef _WIN32
+    if (fileData != nullptr) {
+        munmap(const_cast<char*>(fileData), fileSize);
+    }
+#endif
+}
+
+void NNBook::map_file(const string& filePath)
+{
+#ifndef _WIN32
+    const int fd = open(filePath.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd == -1 || fstat(fd, &fileStat) == -1 || fileStat.st_size == 0) {
+        if (fd != -1) {
+            close(fd);
+        }
+        throw invalid_argument("Given nn book: " + filePath + " could not be opened.");
+    }
+    fileSize = size_t(fileStat.st_size);
+    void* data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw invalid_argument("Given nn book: " + filePath + " couldn't be mapped into memory.");
+    }
+    fileData = static_cast<const char*>(data);
+    // the entries are accessed by binary search
+    madvise(data, fileSize, MADV_RANDOM);
+#else
+    ifstream file(filePath, ios::binary);
+    if (!file.is_open()) {
+        throw invalid_argument("Given nn book: " + filePath + " could not be opened.");
+    }
+    fileContent.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    fileData = fileContent.data();
+    fileSize = fileContent.size();
+#endif
+}
+
+bool NNBook::probe(Node* node, const StateObj& state, bool mirrorPolicy) const
+{
+    const size_t numberMoves = node->get_number_child_nodes();
+    if (numberMoves == 0 || numberMoves > EVAL_CACHE_MAX_MOVES) {
+        return false;
+    }
+    const Key key = get_nn_book_key(state, version);
+    const NNBookEntry* entry = lower_bound(entries, entries + numberEntries, key,
+                                           [](const NNBookEntry& lhs, Key rhs) { return lhs.key < rhs; });
+    if (entry == entries + numberEntries || entry->key != key || entry->numberMoves != numberMoves) {
+        return false;
+    }
+    uint8_t order[EVAL_CACHE_MAX_MOVES];
+    fill_canonical_order(node, mirrorPolicy, order);
+    float* policyProbs = node->get_policy_prob_small().data();
+    for (size_t rank = 0; rank < numberMoves; ++rank) {
+        policyProbs[order[rank]] = half_to_float_scalar(entry->policy[rank]);
+    }
+    node->set_value(entry->value);
+    return true;
+}
+
+size_t NNBook::size() const
+{
+    return numberEntries;
+}
+
+NNBookGenerator::NNBookGenerator(const vector<unique_ptr<NeuralNetAPI>>& nets, const SearchSettings* searchSettings):
+    NeuralNetAPIUser(nets, false, false),
+    searchSettings(searchSettings),
+    netStates(nets.size())
+{
+}
+
+void NNBookGenerator::add_positions(StateObj* state, size_t plies, unordered_set<Key>& keys)
+{
+    const vector<Action> legalActions = state->legal_actions();
+    float customTerminalValue;
+    // repetitions and terminal positions are never evaluated by the network during search
+    if (state->number_repetitions() == 0 && legalActions.size() <= EVAL_CACHE_MAX_MOVES &&
+            state->is_terminal(legalActions.size(), customTerminalValue) == TERMINAL_NONE &&
+            keys.insert(get_nn_book_key(*state, nets.front()->get_version())).second) {
+        const size_t netIdx = get_phase_net_index(state->get_phase(numPhases, searchSettings->gamePhaseDefinition));
+        netStates[netIdx].emplace_back(state->clone());
+        if (netStates[netIdx].size() == nets[netIdx]->get_batch_size()) {
+            evaluate_states(netIdx);
+        }
+    }
+    if (plies == 0) {
+        return;
+    }
+    for (Action action : legalActions) {
+        state->do_action(action);
+        add_positions(state, plies - 1, keys);
+        state->undo_action(action);
+    }
+}
+
+void NNBookGenerator::evaluate_states(size_t netIdx)
+{
+    vector<unique_ptr<StateObj>>& states = netStates[netIdx];
+    const Version version = nets.front()->get_version();
+    const size_t numberInputValues = nets.front()->get_nb_input_values_total();
+    for (size_t batchIdx = 0; batchIdx < states.size(); ++batchIdx) {
+        states[batchIdx]->get_state_planes(true, inputPlanes + batchIdx * numberInputValues, version);
+    }
+    // the last mini-batch is usually incomplete
+    nets[netIdx]->set_number_positions(states.size());
+    nets[netIdx]->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+    nets[netIdx]->set_number_positions(nets[netIdx]->get_batch_size());
+
+    for (size_t batchIdx = 0; batchIdx < states.size(); ++batchIdx) {
+        const StateObj& state = *states[batchIdx];
+        const vector<Action> legalActions = state.legal_actions();
+        const bool mirrorPolicy = state.mirror_policy(state.side_to_move());
+        // the same policy entries as in Node::set_probabilities_for_moves()
+        DynamicVector<double> policy(legalActions.size());
+        get_probs_of_move_list(batchIdx, probOutputs, legalActions, mirrorPolicy, false, policy, nets[netIdx]->is_policy_map());
+        uint32_t policyIndices[EVAL_CACHE_MAX_MOVES];
+        for (size_t mvIdx = 0; mvIdx < legalActions.size(); ++mvIdx) {
+            policyIndices[mvIdx] = mirrorPolicy ? StateConstants::action_to_index<normal,mirrored>(legalActions[mvIdx]) :
+                                                  StateConstants::action_to_index<normal,notMirrored>(legalActions[mvIdx]);
+        }
+        uint8_t order[EVAL_CACHE_MAX_MOVES];
+        fill_canonical_order(policyIndices, legalActions.size(), order);
+
+        NNBookEntry entry = {};
+        entry.key = get_nn_book_key(state, version);
+        entry.value = valueOutputs[batchIdx];
+        entry.numberMoves = uint16_t(legalActions.size());
+        for (size_t rank = 0; rank < legalActions.size(); ++rank) {
+            entry.policy[rank] = float_to_half_scalar(float(policy[order[rank]]));
+        }
+        bookEntries.emplace_back(entry);
+    }
+    states.clear();
+}
+
+size_t NNBookGenerator::create(const StateObj* state, size_t plies, const string& filePath, const string& modelName)
+{
+    bookEntries.clear();
+    unordered_set<Key> keys;
+    unique_ptr<StateObj> searchState(state->clone());
+    add_positions(searchState.get(), plies, keys);
+    for (size_t netIdx = 0; netIdx < netStates.size(); ++netIdx) {
+        if (!netStates[netIdx].empty()) {
+            evaluate_states(netIdx);
+        }
+    }
+    sort(bookEntries.begin(), bookEntries.end(), [](const NNBookEntry& lhs, const NNBookEntry& rhs) { return lhs.key < rhs.key; });
+
+    ofstream file(filePath, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw invalid_argument("Given nn book: " + filePath + " could not be created.");
+    }
+    const NNBookHeader header = {NN_BOOK_MAGIC, EVAL_CACHE_MAX_MOVES, std::hash<string>()(modelName), nets.front()->get_version(), bookEntries.size()};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(bookEntries.data()), streamsize(bookEntries.size() * sizeof(NNBookEntry)));
+    return bookEntries.size();
+}
@@ -0,0 +1,162 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: nnbook.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Read-only book of neural network evaluations for the positions of the first plies of a game.
+ * The book is created once per model with the "nnbook" command and memory mapped by every agent which loads it.
+ * It is consulted before a new position is added to the mini-batch, so the opening positions are never evaluated again.
+ * File layout: NNBookHeader followed by the NNBookEntry objects sorted by their key.
+ */
+
+#ifndef NNBOOK_H
+#define NNBOOK_H
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "evalcache.h"
+#include "../config/searchsettings.h"
+#include "../../nn/neuralnetapiuser.h"
+
+// identifies a book file
+#define NN_BOOK_MAGIC 0x4B424E4E
+
+struct NNBookHeader
+{
+    uint32_t magic;
+    // size of the policy array of an entry
+    uint32_t maxMoves;
+    // identity of the neural network and its input representation
+    uint64_t modelKey;
+    uint64_t version;
+    uint64_t numberEntries;
+};
+
+/**
+ * @brief The NNBookEntry struct stores the network outputs of a single position.
+ * The policy is stored in half precision in the order of fill_canonical_order().
+ */
+struct NNBookEntry
+{
+    Key key;
+    float value;
+    uint16_t numberMoves;
+    uint16_t policy[EVAL_CACHE_MAX_MOVES];
+};
+
+/**
+ * @brief get_nn_book_key Returns the key of a position in the book
+ * @param state Position
+ * @param version Input representation version of the neural network
+ * @return Key
+ */
+Key get_nn_book_key(const StateObj& state, Version version);
+
+class NNBook
+{
+private:
+    const char* fileData;
+    size_t fileSize;
+#ifdef _WIN32
+    std::string fileContent;
+#endif
+    const NNBookEntry* entries;
+    size_t numberEntries;
+    Version version;
+
+    /**
+     * @brief map_file Maps the book file into memory
+     * @param filePath Path of the book file
+     */
+    void map_file(const std::string& filePath);
+
+public:
+    /**
+     * @brief NNBook Loads the book and checks that it has been created for the given neural network
+     * @param filePath Path of the book file
+     * @param modelName Identity of the neural network
+     * @param version Input representation version of the neural network
+     */
+    NNBook(const std::string& filePath, const std::string& modelName, Version version);
+    ~NNBook();
+    NNBook(const NNBook&) = delete;
+    NNBook& operator=(const NNBook&) = delete;
+
+    /**
+     * @brief probe Looks up the network outputs for the given node and assigns its value and (not post-processed) policy on success.
+     * This method is thread-safe.
+     * @param node Newly created node without network results
+     * @param state State of the node
+     * @param mirrorPolicy Decides if the policy of the node is mirrored
+     * @return True, if the position is in the book
+     */
+    bool probe(Node* node, const StateObj& state, bool mirrorPolicy) const;
+
+    /**
+     * @brief size Returns the number of positions in the book
+     */
+    size_t size() const;
+};
+
+/**
+ * @brief The NNBookGenerator class evaluates all positions of the first plies with the neural network and writes them to a book file
+ */
+class NNBookGenerator : public NeuralNetAPIUser
+{
+private:
+    const SearchSettings* searchSettings;
+    std::vector<NNBookEntry> bookEntries;
+    // positions which are waiting for their evaluation by each network
+    std::vector<std::vector<std::unique_ptr<StateObj>>> netStates;
+
+    /**
+     * @brief add_positions Adds the given position and all its successors within the given number of plies
+     * @param state Position which is restored before returning
+     * @param plies Remaining number of plies
+     * @param keys Keys of the positions which have already been added
+     */
+    void add_positions(StateObj* state, size_t plies, std::unordered_set<Key>& keys);
+
+    /**
+     * @brief evaluate_states Evaluates the waiting positions of a network and converts them into book entries
+     * @param netIdx Index of the network
+     */
+    void evaluate_states(size_t netIdx);
+
+public:
+    NNBookGenerator(const vector<unique_ptr<NeuralNetAPI>>& nets, const SearchSettings* searchSettings);
+
+    /**
+     * @brief create Evaluates all positions which can be reached from the given position and writes the book file
+     * @param state Starting position, e.g. the starting position of the variant
+     * @param plies Maximum number of plies from the starting position
+     * @param filePath Path of the book file
+     * @param modelName Identity of the neural network
+     * @return Number of positions in the book
+     */
+    size_t create(const StateObj* state, size_t plies, const std::string& filePath, const std::string& modelName);
+};
+
+#endif // NNBOOK_H
@@ -0,0 +1,274 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: rootstatsfeed.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "rootstatsfeed.h"
+
+#ifdef __linux__
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+inline size_t align_cache_line(size_t numberBytes)
+{
+    return (numberBytes + 63) & ~size_t(63);
+}
+
+void copy_move(char* target, const std::string& source)
+{
+    strncpy(target, source.c_str(), ROOT_STATS_MOVE_LENGTH - 1);
+    target[ROOT_STATS_MOVE_LENGTH - 1] = '\0';
+}
+}
+
+RootStatsMove* get_root_stats_moves(RootStatsHeader* header)
+{
+    return reinterpret_cast<RootStatsMove*>(reinterpret_cast<char*>(header) + align_cache_line(sizeof(RootStatsHeader)));
+}
+
+bool read_root_stats_snapshot(RootStatsHeader* header, RootStatsSnapshot& snapshot, size_t maxRetries)
+{
+    if (header->magic != ROOT_STATS_MAGIC || header->version != ROOT_STATS_VERSION) {
+        return false;
+    }
+    const RootStatsMove* moves = get_root_stats_moves(header);
+    for (size_t attempt = 0; attempt < maxRetries; ++attempt) {
+        const uint32_t sequence = header->sequence.load(std::memory_order_acquire);
+        if (sequence % 2 == 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        snapshot.searchId = header->searchId;
+        snapshot.isSearching = header->isSearching;
+        snapshot.elapsedMS = header->elapsedMS;
+        snapshot.nodes = header->nodes;
+        const size_t numberMoves = std::min(header->numberMoves, header->maxMoves);
+        snapshot.moves.assign(moves, moves + numberMoves);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) == sequence) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RootStatsFeed::RootStatsFeed():
+    header(nullptr),
+    segmentSize(0),
+    rootNode(nullptr),
+    isChess960(false),
+    isPublishing(false)
+{
+}
+
+RootStatsFeed::~RootStatsFeed()
+{
+    close();
+}
+
+void RootStatsFeed::open(const std::string& segmentName)
+{
+    if (segmentName == name && is_open()) {
+        return;
+    }
+    close();
+    if (segmentName.empty()) {
+        return;
+    }
+    segmentSize = align_cache_line(sizeof(RootStatsHeader)) + ROOT_STATS_MAX_MOVES * sizeof(RootStatsMove);
+
+    // a stale segment of an engine which has crashed is replaced
+    shm_unlink(segmentName.c_str());
+    const int fd = shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1) {
+        throw std::invalid_argument("The shared memory segment " + segmentName + " couldn't be created: " + strerror(errno));
+    }
+    if (ftruncate(fd, off_t(segmentSize)) == -1) {
+        ::close(fd);
+        shm_unlink(segmentName.c_str());
+        throw std::invalid_argument("The shared memory segment " + segmentName + " couldn't be resized: " + strerror(errno));
+    }
+    void* memory = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(segmentName.c_str());
+        throw std::invalid_argument("The shared memory segment " + segmentName + " couldn't be mapped: " + strerror(errno));
+    }
+
+    header = new (memory) RootStatsHeader;
+    header->version = ROOT_STATS_VERSION;
+    header->maxMoves = ROOT_STATS_MAX_MOVES;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->searchId = 0;
+    header->isSearching = 0;
+    header->numberMoves = 0;
+    header->elapsedMS = 0;
+    header->nodes = 0;
+    // the readers only accept the segment once it is initialized
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = ROOT_STATS_MAGIC;
+    name = segmentName;
+}
+
+void RootStatsFeed::close()
+{
+    stop_publishing();
+    if (header == nullptr) {
+        return;
+    }
+    munmap(header, segmentSize);
+    shm_unlink(name.c_str());
+    header = nullptr;
+    name.clear();
+}
+
+bool RootStatsFeed::is_open() const
+{
+    return header != nullptr;
+}
+
+bool RootStatsFeed::start_publishing(const Node* root, bool isChess960, size_t intervalMS)
+{
+    std::lock_guard<std::mutex> publisherLock(publisherMtx);
+    if (header == nullptr || publisherThread.joinable() || root == nullptr || !root->is_playout_node()) {
+        return false;
+    }
+    rootNode = root;
+    this->isChess960 = isChess960;
+    startTime = std::chrono::steady_clock::now();
+    const size_t numberMoves = std::min(root->get_number_child_nodes(), size_t(ROOT_STATS_MAX_MOVES));
+    moveStrings.resize(numberMoves);
+    for (size_t moveIdx = 0; moveIdx < numberMoves; ++moveIdx) {
+        moveStrings[moveIdx] = StateConstants::action_to_uci(root->get_action(moveIdx), isChess960);
+    }
+    pvHeadActions.assign(numberMoves, 0);
+    hasPvHead.assign(numberMoves, false);
+    ++header->searchId;
+    // the move strings are only written once per search
+    RootStatsMove* moves = get_root_stats_moves(header);
+    const uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t moveIdx = 0; moveIdx < numberMoves; ++moveIdx) {
+        copy_move(moves[moveIdx].move, moveStrings[moveIdx]);
+        moves[moveIdx].pvHead[0] = '\0';
+    }
+    header->sequence.store(sequence + 2, std::memory_order_release);
+    write_snapshot(true);
+
+    isPublishing = true;
+    publisherThread = std::thread(&RootStatsFeed::run_publisher, this, intervalMS);
+    return true;
+}
+
+void RootStatsFeed::stop_publishing()
+{
+    std::lock_guard<std::mutex> publisherLock(publisherMtx);
+    if (!publisherThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        isPublishing = false;
+    }
+    condition.notify_one();
+    publisherThread.join();
+    write_snapshot(false);
+    rootNode = nullptr;
+}
+
+void RootStatsFeed::run_publisher(size_t intervalMS)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!condition.wait_for(lock, std::chrono::milliseconds(intervalMS), [this]{ return !isPublishing; })) {
+        write_snapshot(true);
+    }
+}
+
+void RootStatsFeed::write_pv_head(size_t moveIdx, RootStatsMove& entry)
+{
+    const Node* childNode = rootNode->get_child_node(moveIdx);
+    if (childNode == nullptr || !childNode->is_playout_node() || childNode->get_no_visit_idx() == 0) {
+        if (hasPvHead[moveIdx]) {
+            entry.pvHead[0] = '\0';
+            hasPvHead[moveIdx] = false;
+        }
+        return;
+    }
+    thread_local std::vector<ChildIdx> childIndices;
+    thread_local std::vector<uint32_t> childVisits;
+    childNode->get_most_visited_children(childIndices, 1, childVisits);
+    const Action pvHead = childNode->get_action(childIndices.front());
+    if (!hasPvHead[moveIdx] || pvHeadActions[moveIdx] != pvHead) {
+        copy_move(entry.pvHead, StateConstants::action_to_uci(pvHead, isChess960));
+        pvHeadActions[moveIdx] = pvHead;
+        hasPvHead[moveIdx] = true;
+    }
+}
+
+void RootStatsFeed::write_snapshot(bool isSearching)
+{
+    RootStatsMove* moves = get_root_stats_moves(header);
+    const size_t numberMoves = moveStrings.size();
+    const size_t numberVisited = std::min(size_t(rootNode->get_no_visit_idx()), numberMoves);
+    const uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t nodes = 0;
+    for (size_t moveIdx = 0; moveIdx < numberMoves; ++moveIdx) {
+        RootStatsMove& entry = moves[moveIdx];
+        entry.prior = rootNode->get_prior(moveIdx);
+        if (moveIdx < numberVisited) {
+            entry.visits = rootNode->get_child_number_visits(moveIdx);
+            entry.q = rootNode->get_q_value(moveIdx);
+            write_pv_head(moveIdx, entry);
+        }
+        else {
+            entry.visits = 0;
+            entry.q = -1;
+        }
+        nodes += entry.visits;
+    }
+    header->numberMoves = numberMoves;
+    header->nodes = nodes;
+    header->isSearching = isSearching;
+    header->elapsedMS = uint32_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count());
+    header->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+RootStatsFeed& root_stats_feed()
+{
+    static RootStatsFeed feed;
+    return feed;
+}
+
+#endif
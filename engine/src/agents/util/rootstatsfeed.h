@@ -0,0 +1,172 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: rootstatsfeed.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Read-only POSIX shared memory segment in which the engine publishes the statistics of the children of the root node
+ * during a search, so that local GUIs and dashboards can draw the move bars at any rate without parsing "info" lines.
+ * Layout: RootStatsHeader (padded to 64 bytes) | ROOT_STATS_MAX_MOVES x RootStatsMove
+ * The snapshot is protected by a sequence lock: the sequence number is odd while the engine writes.
+ * A reader copies the snapshot and retries if the sequence number was odd or has changed meanwhile (see read_root_stats_snapshot()).
+ * The move strings of the root are formatted once per search and the heads of the principal variations only when they change.
+ */
+
+#ifndef ROOTSTATSFEED_H
+#define ROOTSTATSFEED_H
+
+#ifdef __linux__
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../node.h"
+
+#define ROOT_STATS_MAGIC 0x54535452  // "RTST"
+#define ROOT_STATS_VERSION 1
+#define ROOT_STATS_MAX_MOVES 512
+#define ROOT_STATS_MOVE_LENGTH 8
+
+/**
+ * @brief The RootStatsHeader struct is located at the beginning of the shared memory segment
+ */
+struct alignas(64) RootStatsHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t maxMoves;
+    // odd while the snapshot is written
+    std::atomic<uint32_t> sequence;
+    // incremented for every new search
+    uint32_t searchId;
+    uint32_t isSearching;
+    uint32_t numberMoves;
+    uint32_t elapsedMS;
+    uint64_t nodes;
+};
+
+/**
+ * @brief The RootStatsMove struct describes a single child of the root node.
+ * Unvisited children have zero visits, a Q-value of -1 and an empty principal variation head.
+ */
+struct RootStatsMove
+{
+    char move[ROOT_STATS_MOVE_LENGTH];
+    // best reply of the opponent after the move
+    char pvHead[ROOT_STATS_MOVE_LENGTH];
+    uint32_t visits;
+    float q;
+    float prior;
+    uint32_t padding;
+};
+
+/**
+ * @brief The RootStatsSnapshot struct is a consistent copy of the shared memory segment
+ */
+struct RootStatsSnapshot
+{
+    uint32_t searchId;
+    bool isSearching;
+    uint32_t elapsedMS;
+    uint64_t nodes;
+    std::vector<RootStatsMove> moves;
+};
+
+/**
+ * @brief get_root_stats_moves Returns the move array which follows the header
+ */
+RootStatsMove* get_root_stats_moves(RootStatsHeader* header);
+
+/**
+ * @brief read_root_stats_snapshot Copies the current snapshot of a segment
+ * @param header Mapped segment of the engine
+ * @param snapshot Output
+ * @param maxRetries Maximum number of attempts while the engine is writing
+ * @return True if a consistent snapshot was copied
+ */
+bool read_root_stats_snapshot(RootStatsHeader* header, RootStatsSnapshot& snapshot, size_t maxRetries = 1000);
+
+/**
+ * @brief The RootStatsFeed class owns the shared memory segment and publishes the root statistics in a background thread
+ */
+class RootStatsFeed
+{
+private:
+    std::string name;
+    RootStatsHeader* header;
+    size_t segmentSize;
+
+    const Node* rootNode;
+    std::chrono::steady_clock::time_point startTime;
+    // cached move strings of the root and the last published principal variation heads
+    std::vector<std::string> moveStrings;
+    std::vector<Action> pvHeadActions;
+    std::vector<bool> hasPvHead;
+    bool isChess960;
+
+    std::thread publisherThread;
+    // only a single search at a time publishes its root, e.g. not all games of the concurrent selfplay
+    std::mutex publisherMtx;
+    std::mutex mtx;
+    std::condition_variable condition;
+    bool isPublishing;
+
+    void run_publisher(size_t intervalMS);
+    void write_snapshot(bool isSearching);
+    void write_pv_head(size_t moveIdx, RootStatsMove& entry);
+public:
+    RootStatsFeed();
+    ~RootStatsFeed();
+    RootStatsFeed(const RootStatsFeed&) = delete;
+    RootStatsFeed& operator=(const RootStatsFeed&) = delete;
+
+    /**
+     * @brief open (Re)creates the segment with the given name, e.g. "/crazyara_root". An empty name closes the segment.
+     * Throws invalid_argument if the segment can't be created.
+     */
+    void open(const std::string& segmentName);
+    void close();
+    bool is_open() const;
+
+    /**
+     * @brief start_publishing Publishes the statistics of the given root node every intervalMS milliseconds until stop_publishing() is called
+     * @return False if the segment isn't open or a different search is already publishing
+     */
+    bool start_publishing(const Node* root, bool isChess960, size_t intervalMS);
+
+    /**
+     * @brief stop_publishing Stops the publisher thread and publishes the final statistics of the search
+     */
+    void stop_publishing();
+};
+
+/**
+ * @brief root_stats_feed Returns the feed of the engine process
+ */
+RootStatsFeed& root_stats_feed();
+
+#endif
+
+#endif // ROOTSTATSFEED_H
@@ -0,0 +1,418 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: treeexport.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "treeexport.h"
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// size of the stream buffers of the output files
+#define TREE_EXPORT_BUFFER_SIZE (1 << 22)
+
+namespace {
+/**
+ * @brief The NodeIndexer class assigns the breadth first index to a node when it is discovered
+ */
+class NodeIndexer
+{
+private:
+    bool isGraph;
+    uint32_t numberNodes;
+    std::unordered_map<const Node*, uint32_t> indices;
+public:
+    NodeIndexer(bool isGraph, size_t expectedNodes):
+        isGraph(isGraph), numberNodes(0)
+    {
+        if (isGraph) {
+            indices.reserve(expectedNodes);
+        }
+    }
+
+    /**
+     * @brief get_index Returns the index of the node and sets isNew if it has not been discovered before
+     */
+    uint32_t get_index(const Node* node, bool& isNew) {
+        if (!isGraph) {
+            isNew = true;
+            return numberNodes++;
+        }
+        auto it = indices.find(node);
+        if (it != indices.end()) {
+            isNew = false;
+            return it->second;
+        }
+        isNew = true;
+        indices.emplace(node, numberNodes);
+        return numberNodes++;
+    }
+
+    uint32_t get_number_nodes() const {
+        return numberNodes;
+    }
+};
+
+template <typename T>
+inline void write_record(std::ofstream& file, const T& record)
+{
+    file.write(reinterpret_cast<const char*>(&record), sizeof(T));
+}
+
+void open_buffered(std::ofstream& file, std::vector<char>& buffer, const std::string& filename)
+{
+    buffer.resize(TREE_EXPORT_BUFFER_SIZE);
+    file.rdbuf()->pubsetbuf(buffer.data(), std::streamsize(buffer.size()));
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open " + filename + " for the tree export.");
+    }
+}
+
+void append_file(std::ofstream& file, const std::string& filename, bool isEmpty)
+{
+    if (!isEmpty) {
+        std::ifstream input(filename, std::ios::binary);
+        file << input.rdbuf();
+    }
+    std::remove(filename.c_str());
+}
+
+TreeNodeStateRecord get_state_record(Node* node)
+{
+    TreeNodeStateRecord stateRecord = {0, 0, 0, NO_CHECKMATE, 0, 0, 0};
+    if (node->has_nn_results()) {
+        stateRecord.flags |= TREE_SNAPSHOT_NN_RESULTS;
+        if (node->is_playout_node() && !node->is_terminal()) {
+            stateRecord.flags |= TREE_SNAPSHOT_NODE_DATA;
+            stateRecord.visitSum = node->get_visits();
+            stateRecord.freeVisits = node->get_free_visits();
+            stateRecord.noVisitIdx = node->get_no_visit_idx();
+            stateRecord.checkmateIdx = uint16_t(node->get_checkmate_idx());
+            stateRecord.endInPly = node->get_end_in_ply();
+            if (node->was_inspected()) {
+                stateRecord.flags |= TREE_SNAPSHOT_INSPECTED;
+            }
+        }
+    }
+    if (node->is_sorted()) {
+        stateRecord.flags |= TREE_SNAPSHOT_SORTED;
+    }
+    return stateRecord;
+}
+}
+
+size_t export_search_tree_binary(Node* rootNode, const std::string& rootFen, size_t maxDepth, bool isGraph, const std::string& filename,
+                                 bool isSnapshot)
+{
+    std::vector<char> nodeBuffer;
+    std::vector<char> edgeBuffer;
+    std::vector<char> stateBuffer;
+    std::ofstream nodeFile;
+    std::ofstream edgeFile;
+    std::ofstream stateFile;
+    const std::string edgeFilename = filename + ".edges.tmp";
+    const std::string stateFilename = filename + ".states.tmp";
+    open_buffered(nodeFile, nodeBuffer, filename);
+    open_buffered(edgeFile, edgeBuffer, edgeFilename);
+    if (isSnapshot) {
+        open_buffered(stateFile, stateBuffer, stateFilename);
+        maxDepth = 0;
+    }
+
+    TreeExportHeader header = {TREE_EXPORT_MAGIC, TREE_EXPORT_VERSION, 0, 0, uint32_t(rootFen.size()),
+                               uint32_t(isSnapshot ? TREE_EXPORT_FLAG_SNAPSHOT : 0)};
+    write_record(nodeFile, header);
+    nodeFile.write(rootFen.data(), std::streamsize(rootFen.size()));
+    const char padding[8] = {0};
+    nodeFile.write(padding, std::streamsize((8 - rootFen.size() % 8) % 8));
+
+    NodeIndexer indexer(isGraph, rootNode->get_node_count());
+    // nodes which have been discovered but not written yet and the depth of the first node of the next level
+    std::deque<Node*> queue;
+    bool isNew;
+    indexer.get_index(rootNode, isNew);
+    queue.push_back(rootNode);
+    size_t depth = 0;
+    uint32_t levelEnd = 1;
+    uint32_t nodeIdx = 0;
+    uint64_t numberEdges = 0;
+
+    while (!queue.empty()) {
+        Node* node = queue.front();
+        queue.pop_front();
+        if (nodeIdx == levelEnd) {
+            ++depth;
+            levelEnd = indexer.get_number_nodes();
+        }
+        ++nodeIdx;
+
+        TreeNodeRecord nodeRecord = {node->get_real_visits(), node->get_value(), uint32_t(numberEdges), 0,
+                                     uint8_t(node->get_node_type()), uint8_t(node->is_terminal())};
+        // snapshots store all moves of the evaluated nodes, otherwise only the visited moves are exported
+        const ChildIdx numberVisited = node->is_playout_node() ? node->get_no_visit_idx() : 0;
+        if (isSnapshot) {
+            nodeRecord.numberEdges = node->has_nn_results() && !node->is_terminal() ? node->get_number_child_nodes() : 0;
+            write_record(stateFile, get_state_record(node));
+        }
+        else if (maxDepth == 0 || depth < maxDepth) {
+            nodeRecord.numberEdges = numberVisited;
+        }
+        if (nodeRecord.numberEdges != 0) {
+            for (ChildIdx childIdx = 0; childIdx < nodeRecord.numberEdges; ++childIdx) {
+                TreeEdgeRecord edgeRecord = {TREE_EXPORT_NO_CHILD, uint32_t(node->get_action(childIdx)), 0, 0, node->get_prior(childIdx)};
+                Node* childNode = nullptr;
+                if (childIdx < numberVisited) {
+                    edgeRecord.visits = node->get_real_visits(childIdx);
+                    edgeRecord.qValue = node->get_q_value(childIdx);
+                    childNode = node->get_child_node(childIdx);
+                }
+                if (childNode != nullptr) {
+                    edgeRecord.child = indexer.get_index(childNode, isNew);
+                    if (isNew) {
+                        queue.push_back(childNode);
+                    }
+                }
+                write_record(edgeFile, edgeRecord);
+            }
+            numberEdges += nodeRecord.numberEdges;
+        }
+        write_record(nodeFile, nodeRecord);
+    }
+
+    // append the edge section and the state section of snapshots
+    edgeFile.close();
+    append_file(nodeFile, edgeFilename, numberEdges == 0);
+    if (isSnapshot) {
+        stateFile.close();
+        append_file(nodeFile, stateFilename, false);
+    }
+
+    header.numberNodes = indexer.get_number_nodes();
+    header.numberEdges = numberEdges;
+    nodeFile.seekp(0);
+    write_record(nodeFile, header);
+    nodeFile.close();
+    if (!nodeFile) {
+        throw std::runtime_error("Failed to write the tree export " + filename);
+    }
+    return header.numberNodes;
+}
+
+TreeSnapshot::TreeSnapshot(const std::string& filename):
+    fileData(nullptr),
+    fileSize(0),
+    header(nullptr),
+    nodes(nullptr),
+    edges(nullptr),
+    states(nullptr)
+{
+    map_file(filename);
+    if (fileSize < sizeof(TreeExportHeader)) {
+        throw std::invalid_argument("The given file " + filename + " is not a search tree snapshot.");
+    }
+    header = reinterpret_cast<const TreeExportHeader*>(fileData);
+    if (header->magic != TREE_EXPORT_MAGIC || header->version != TREE_EXPORT_VERSION) {
+        throw std::invalid_argument("The given file " + filename + " is not a search tree export of this version.");
+    }
+    if (!(header->flags & TREE_EXPORT_FLAG_SNAPSHOT)) {
+        throw std::invalid_argument("The given tree export " + filename + " isn't a snapshot, use \"savetree\" to create one.");
+    }
+    const size_t nodeOffset = sizeof(TreeExportHeader) + ((size_t(header->fenLength) + 7) & ~size_t(7));
+    const size_t edgeOffset = nodeOffset + header->numberNodes * sizeof(TreeNodeRecord);
+    const size_t stateOffset = edgeOffset + header->numberEdges * sizeof(TreeEdgeRecord);
+    if (header->numberNodes == 0 || stateOffset + header->numberNodes * sizeof(TreeNodeStateRecord) != fileSize) {
+        throw std::invalid_argument("The size of the snapshot " + filename + " doesn't match its header.");
+    }
+    nodes = reinterpret_cast<const TreeNodeRecord*>(fileData + nodeOffset);
+    edges = reinterpret_cast<const TreeEdgeRecord*>(fileData + edgeOffset);
+    states = reinterpret_cast<const TreeNodeStateRecord*>(fileData + stateOffset);
+    validate();
+}
+
+TreeSnapshot::~TreeSnapshot()
+{
+#ifndef _WIN32
+    if (fileData != nullptr) {
+        munmap(const_cast<char*>(fileData), fileSize);
+    }
+#endif
+}
+
+void TreeSnapshot::map_file(const std::string& filename)
+{
+#ifndef _WIN32
+    const int fd = open(filename.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd == -1 || fstat(fd, &fileStat) == -1 || fileStat.st_size == 0) {
+        if (fd != -1) {
+            close(fd);
+        }
+        throw std::invalid_argument("Given snapshot file: " + filename + " could not be opened.");
+    }
+    fileSize = size_t(fileStat.st_size);
+    void* data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::invalid_argument("Given snapshot file: " + filename + " couldn't be mapped into memory.");
+    }
+    fileData = static_cast<const char*>(data);
+    // the node records are read in order, the edges and states of a node are next to each other
+    madvise(data, fileSize, MADV_SEQUENTIAL);
+#else
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::invalid_argument("Given snapshot file: " + filename + " could not be opened.");
+    }
+    fileContent.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    fileData = fileContent.data();
+    fileSize = fileContent.size();
+#endif
+}
+
+void TreeSnapshot::validate() const
+{
+    for (size_t nodeIdx = 0; nodeIdx < header->numberNodes; ++nodeIdx) {
+        const TreeNodeRecord& nodeRecord = nodes[nodeIdx];
+        if (size_t(nodeRecord.firstEdge) + nodeRecord.numberEdges > header->numberEdges ||
+                states[nodeIdx].noVisitIdx > nodeRecord.numberEdges) {
+            throw std::invalid_argument("The edges of snapshot node " + std::to_string(nodeIdx) + " are out of range.");
+        }
+        for (size_t edgeIdx = nodeRecord.firstEdge; edgeIdx < nodeRecord.firstEdge + nodeRecord.numberEdges; ++edgeIdx) {
+            if (edges[edgeIdx].child != TREE_EXPORT_NO_CHILD && edges[edgeIdx].child >= header->numberNodes) {
+                throw std::invalid_argument("Snapshot node " + std::to_string(nodeIdx) + " refers to an invalid child index.");
+            }
+        }
+    }
+}
+
+std::string TreeSnapshot::get_fen() const
+{
+    return std::string(fileData + sizeof(TreeExportHeader), header->fenLength);
+}
+
+size_t TreeSnapshot::get_number_nodes() const
+{
+    return header->numberNodes;
+}
+
+namespace {
+/**
+ * @brief new_node Creates a node like Node::add_new_node_to_tree(), with MCTS_STORE_STATES the node takes the ownership of the state
+ */
+NodeLink new_node(StateObj* state, const SearchSettings* searchSettings)
+{
+#ifdef MCTS_NODE_POOL
+    return node_pool().new_node(state, searchSettings);
+#else
+    return std::make_shared<Node>(state, searchSettings);
+#endif
+}
+
+struct SnapshotTask {
+    uint32_t nodeIdx;
+    Node* parentNode;
+    ChildIdx childIdx;
+    std::unique_ptr<StateObj> state;
+};
+}
+
+NodeLink TreeSnapshot::restore(const StateObj* rootState, const SearchSettings* searchSettings, MapWithMutex* mapWithMutex) const
+{
+    // nodes of an MCGS export can be reached by several edges and are connected to each parent
+    std::vector<NodeLink> links(header->numberNodes);
+    NodeLink rootLink = NodeLink();
+    std::vector<SnapshotTask> stack;
+    stack.push_back({0, nullptr, 0, std::unique_ptr<StateObj>(rootState->clone())});
+
+    try {
+        while (!stack.empty()) {
+            SnapshotTask task = std::move(stack.back());
+            stack.pop_back();
+            Node* node = get_node_ptr(links[task.nodeIdx]);
+            if (node != nullptr) {
+                // transposition which has been restored via another parent
+                node->add_transposition_parent_node();
+                task.parentNode->restore_child_node(task.childIdx, links[task.nodeIdx]);
+                continue;
+            }
+#ifdef MCTS_STORE_STATES
+            StateObj* nodeState = task.state->clone();
+#else
+            StateObj* nodeState = task.state.get();
+#endif
+            links[task.nodeIdx] = new_node(nodeState, searchSettings);
+            node = get_node_ptr(links[task.nodeIdx]);
+            const TreeNodeRecord& nodeRecord = nodes[task.nodeIdx];
+            const TreeEdgeRecord* nodeEdges = edges + nodeRecord.firstEdge;
+            node->restore_from_snapshot(nodeRecord, states[task.nodeIdx], nodeEdges);
+            if (searchSettings->useMCGS) {
+                HashShard& shard = mapWithMutex->get_shard(node->hash_key());
+                shard.mtx.lock();
+                mapWithMutex->insert(shard, node->hash_key(), links[task.nodeIdx]);
+                shard.mtx.unlock();
+            }
+            if (task.parentNode == nullptr) {
+                rootLink = links[task.nodeIdx];
+            }
+            else {
+                task.parentNode->restore_child_node(task.childIdx, links[task.nodeIdx]);
+            }
+            for (ChildIdx childIdx = 0; childIdx < states[task.nodeIdx].noVisitIdx; ++childIdx) {
+                const uint32_t childNodeIdx = nodeEdges[childIdx].child;
+                if (childNodeIdx == TREE_EXPORT_NO_CHILD) {
+                    continue;
+                }
+                std::unique_ptr<StateObj> childState;
+                if (get_node_ptr(links[childNodeIdx]) == nullptr) {
+                    childState = std::unique_ptr<StateObj>(task.state->clone());
+                    childState->do_action(Action(nodeEdges[childIdx].action));
+                }
+                stack.push_back({childNodeIdx, node, childIdx, std::move(childState)});
+            }
+        }
+    }
+    catch (const std::exception&) {
+#ifdef MCTS_NODE_POOL
+        // pool nodes are only released explicitly
+        for (NodeLink link : links) {
+            if (link != NO_NODE_IDX) {
+                node_pool().free_node(link);
+            }
+        }
+#endif
+        throw;
+    }
+    return rootLink;
+}
@@ -0,0 +1,163 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: treeexport.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Binary export of the search tree for large trees.
+ * Layout (little endian):
+ * TreeExportHeader | root fen (padded to 8 bytes) | numberNodes x TreeNodeRecord | numberEdges x TreeEdgeRecord
+ * The nodes are stored in breadth first order starting with the root node at index 0.
+ * Every node refers to the consecutive range [firstEdge, firstEdge+numberEdges) of the edge section,
+ * which holds the visited child moves of the node.
+ * Positions which are reached by several move sequences (MCGS) are only stored once.
+ * The reader is DeepCrazyhouse/src/tools/search_tree_io.py.
+ *
+ * Snapshots (flag TREE_EXPORT_FLAG_SNAPSHOT) always contain the full tree and are used to restore a search with "loadtree".
+ * Every evaluated node stores all legal moves as edges in the order of the node, so that the priors are kept as well,
+ * and the file ends with numberNodes x TreeNodeStateRecord.
+ */
+
+#ifndef TREEEXPORT_H
+#define TREEEXPORT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../../node.h"
+
+#define TREE_EXPORT_MAGIC 0x45455254  // "TREE"
+#define TREE_EXPORT_VERSION 1
+// child index of an edge which has no exported child node
+#define TREE_EXPORT_NO_CHILD UINT32_MAX
+#define TREE_EXPORT_FLAG_SNAPSHOT 1
+
+// flags of TreeNodeStateRecord
+#define TREE_SNAPSHOT_NN_RESULTS 1
+#define TREE_SNAPSHOT_NODE_DATA 2
+#define TREE_SNAPSHOT_INSPECTED 4
+#define TREE_SNAPSHOT_SORTED 8
+
+struct TreeExportHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t numberNodes;
+    uint64_t numberEdges;
+    uint32_t fenLength;
+    uint32_t flags;
+};
+
+struct TreeNodeRecord {
+    uint32_t visits;
+    float value;
+    uint32_t firstEdge;
+    uint16_t numberEdges;
+    uint8_t nodeType;
+    uint8_t isTerminal;
+};
+
+struct TreeEdgeRecord {
+    uint32_t child;
+    // Action of the state class, e.g. the Stockfish move encoding for chess
+    uint32_t action;
+    uint32_t visits;
+    float qValue;
+    float prior;
+};
+
+struct TreeNodeStateRecord {
+    uint32_t visitSum;
+    uint32_t freeVisits;
+    uint16_t noVisitIdx;
+    uint16_t checkmateIdx;
+    uint16_t endInPly;
+    uint8_t flags;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(TreeExportHeader) == 32, "The header layout must match the reader");
+static_assert(sizeof(TreeNodeRecord) == 16, "The node record layout must match the reader");
+static_assert(sizeof(TreeEdgeRecord) == 20, "The edge record layout must match the reader");
+static_assert(sizeof(TreeNodeStateRecord) == 16, "The node state record layout must match the reader");
+
+/**
+ * @brief export_search_tree_binary Writes the search tree with an iterative breadth first walk.
+ * The node records are streamed into the file and the edge records into a temporary file which is appended at the end.
+ * Must not be called while the search is running.
+ * @param rootNode Root node of the tree
+ * @param rootFen FEN of the root position
+ * @param maxDepth Maximum depth of the exported nodes, 0 exports the full tree
+ * @param isGraph True if nodes can have several parents (MCGS), otherwise every node is assumed to be reached once
+ * @param filename Output file
+ * @param isSnapshot Writes a snapshot which can be restored by TreeSnapshot (maxDepth is ignored)
+ * @return Number of exported nodes
+ */
+size_t export_search_tree_binary(Node* rootNode, const std::string& rootFen, size_t maxDepth, bool isGraph, const std::string& filename,
+                                 bool isSnapshot = false);
+
+/**
+ * @brief The TreeSnapshot class maps a snapshot file into memory and rebuilds the search tree from it
+ */
+class TreeSnapshot
+{
+private:
+    const char* fileData;
+    size_t fileSize;
+#ifdef _WIN32
+    std::vector<char> fileContent;
+#endif
+    const TreeExportHeader* header;
+    const TreeNodeRecord* nodes;
+    const TreeEdgeRecord* edges;
+    const TreeNodeStateRecord* states;
+
+    void map_file(const std::string& filename);
+    void validate() const;
+public:
+    /**
+     * @brief TreeSnapshot Maps and validates the given snapshot, throws an invalid_argument exception for unsupported files
+     * @param filename Snapshot file written by export_search_tree_binary()
+     */
+    TreeSnapshot(const std::string& filename);
+    ~TreeSnapshot();
+    TreeSnapshot(const TreeSnapshot&) = delete;
+    TreeSnapshot& operator=(const TreeSnapshot&) = delete;
+
+    /**
+     * @brief get_fen Returns the FEN of the root position
+     */
+    std::string get_fen() const;
+
+    size_t get_number_nodes() const;
+
+    /**
+     * @brief restore Rebuilds all nodes of the snapshot with an iterative depth first walk.
+     * The positions are replayed from the root state and nodes with several parents are only created once.
+     * @param rootState State of the root position (a copy is stored in the root node with MCTS_STORE_STATES)
+     * @param searchSettings Search settings
+     * @param mapWithMutex Transposition table in which all nodes are inserted if MCGS is enabled
+     * @return Link to the root node
+     */
+    NodeLink restore(const StateObj* rootState, const SearchSettings* searchSettings, MapWithMutex* mapWithMutex) const;
+};
+
+#endif // TREEEXPORT_H
@@ -79,6 +79,12 @@ const string engineAuthors = "Johannes Czech and CrazyAra developers (see AUTHOR
 #define DRAW_VALUE 0
 #define WIN_VALUE 1
 #define PRESERVED_ITEMS 8
+// size of a cache line in bytes, used for aligning data which is written by different threads
+#define CACHE_LINE_SIZE 64
+// number of child moves which are additionally sorted by their prior when the visited range reaches the end of the sorted range (MCTS_PARTIAL_SORT)
+#define PARTIAL_SORT_STEP 8
+// the PV line of the periodic info output is walked again once the visits of its first move have grown by this factor
+#define PV_REFRESH_VISITS_FACTOR 1.25f
 // Pre-initialized index when no forced win was found: 2^16 - 1
 #define NO_CHECKMATE 65535
 #define Q_VALUE_DIFF 0.1f
@@ -86,6 +92,9 @@ const string engineAuthors = "Johannes Czech and CrazyAra developers (see AUTHOR
 #define DEPTH_INIT 64
 #define Q_TRANSPOS_DIFF 0.01
 #define MAX_HASH_SIZE 100000000
+#define DEFAULT_HASH_SIZE 1000000
+// number of hash buckets whose expired entries are removed under a single shard lock
+#define HASH_SWEEP_BUCKETS 64
 #ifdef MODE_CHESS
 #define VALUE_TO_CENTI_PARAM 1.4f
 #else
@@ -96,6 +105,19 @@ const string engineAuthors = "Johannes Czech and CrazyAra developers (see AUTHOR
 #define TIME_PROP_MOVES_TO_GO 14
 #define TIME_INCREMENT_FACTOR 0.7f
 #define TIME_BUFFER_FACTOR 30
+// smoothing factor of the exponential moving averages of the measured search latencies
+#define TIME_LATENCY_SMOOTHING 0.3f
+// number of unchanged best move samples after which the stability time control starts to reduce the move time
+#define TIME_STABLE_SAMPLES 3
+#define TIME_STABLE_STEP 0.1f
+// Q-value margin of the best move over the best alternative which is considered decisive
+#define TIME_STABLE_Q_MARGIN 0.1f
+#define TIME_STABLE_MARGIN_FACTOR 0.8f
+// additional move time for every recent change of the best move (the changes decay by TIME_CHANGE_DECAY per sample)
+#define TIME_CHANGE_STEP 0.3f
+#define TIME_CHANGE_DECAY 0.75f
+// additional move time per value unit which the evaluation dropped since the first sample
+#define TIME_DROP_FACTOR 4.0f
 #define NONE_IDX uint16_t(-1)
 
 #ifndef MODE_POMMERMAN
@@ -40,17 +40,18 @@ vector<std::string> OutputRepresentation::LABELS_MIRRORED;
 constexpr int MAX_SUPPORTED_TB_PIECES = 7;
 
 BoardState::BoardState():
-    State(),
-    states(StateListPtr(new std::deque<StateInfo>(0)))
+    State()
 {
 }
 
 BoardState::BoardState(const BoardState &b) :
     State(),
-    board(b.board),
-    states(StateListPtr(new std::deque<StateInfo>(0)))
+    board(b.board)
 {
-    states->emplace_back(b.states->back());
+    // only the current entry is copied, the previous entries which are needed for the repetition detection remain in the history of b
+    if (b.states.size() != 0) {
+        board.set_state_info(&states.emplace_back(b.states.back()));
+    }
 }
 
 bool BoardState::mirror_policy(SideToMove sideToMove) const
@@ -60,9 +61,11 @@ bool BoardState::mirror_policy(SideToMove sideToMove) const
 
 vector<Action> BoardState::legal_actions() const
 {
-    vector<Action> legalMoves;
     // generate the legal moves and save them in the list
-    for (const ExtMove& move : MoveList<LEGAL>(board)) {
+    const MoveList<LEGAL> moveList(board);
+    vector<Action> legalMoves;
+    legalMoves.reserve(moveList.size());
+    for (const ExtMove& move : moveList) {
         legalMoves.push_back(Action(move.move));
     }
     return legalMoves;
@@ -70,8 +73,8 @@ vector<Action> BoardState::legal_actions() const
 
 void BoardState::set(const string &fenStr, bool isChess960, int variant)
 {
-    states = StateListPtr(new std::deque<StateInfo>(1));
-    board.set(fenStr, isChess960, Variant(variant), &states->back(), nullptr);
+    states.clear();
+    board.set(fenStr, isChess960, Variant(variant), &states.emplace_back(), nullptr);
 }
 
 void BoardState::get_state_planes(bool normalize, float *inputPlanes, Version version) const
@@ -96,13 +99,13 @@ string BoardState::fen() const
 
 void BoardState::do_action(Action action)
 {
-    states->emplace_back();
-    board.do_move(Move(action), states->back());
+    board.do_move(Move(action), states.emplace_back());
 }
 
 void BoardState::undo_action(Action action)
 {
     board.undo_move(Move(action));
+    states.pop_back();
 }
 
 void BoardState::prepare_action()
@@ -125,6 +128,14 @@ Key BoardState::hash_key() const
     return board.hash_key();
 }
 
+Key BoardState::colour_symmetric_hash_key(Version version) const
+{
+    if (!is_colour_symmetric_input(version)) {
+        return hash_key();
+    }
+    return side_relative_hash_key(board);
+}
+
 void BoardState::flip()
 {
     board.flip();
@@ -225,6 +236,19 @@ TerminalType BoardState::is_terminal(size_t numberLegalMoves, float& customTermi
     return TERMINAL_NONE;
 }
 
+bool BoardState::is_draw_by_rule() const
+{
+#ifdef MODE_LICHESS
+    // the variant specific terminal conditions have precedence
+    return false;
+#else
+    // a repeated position or a position with insufficient material can't be a checkmate
+    // and a checkmate has precedence over the 50 moves rule
+    return board.can_claim_3fold_repetition() || board.draw_by_insufficient_material() ||
+            (board.is_50_move_rule_draw() && !board.checkers());
+#endif
+}
+
 bool BoardState::gives_check(Action action) const
 {
     return board.gives_check(Move(action));
@@ -235,9 +259,15 @@ void BoardState::print(ostream &os) const
     os << board;
 }
 
+bool BoardState::could_be_in_tablebase() const
+{
+    const int numberPieces = board.count<ALL_PIECES>();
+    return numberPieces <= MAX_SUPPORTED_TB_PIECES && numberPieces <= Tablebases::MaxCardinality;
+}
+
 Tablebase::WDLScore BoardState::check_for_tablebase_wdl(Tablebase::ProbeState &result)
 {
-    if (board.count<ALL_PIECES>() > MAX_SUPPORTED_TB_PIECES) {
+    if (!could_be_in_tablebase()) {
         result = Tablebase::FAIL;
         return Tablebase::WDLDraw;
     }
@@ -259,7 +289,7 @@ BoardState* BoardState::clone() const
 
 void BoardState::init(int variant, bool is960)
 {
-    states = StateListPtr(new std::deque<StateInfo>(1));
+    states.clear();
     string start_fen = StateConstantsBoard::start_fen(variant);
     if(is960 && variant == CHESS_VARIANT) {
         start_fen = chess960fen();
@@ -267,7 +297,7 @@ void BoardState::init(int variant, bool is960)
         info_string("960 has not yet been implemented for" + variants[variant]);
         info_string("Using standard starting position instead.");
     }
-    board.set(start_fen, is960, Variant(variant), &states->back(), nullptr);
+    board.set(start_fen, is960, Variant(variant), &states.emplace_back(), nullptr);
 }
 
 #endif
@@ -33,6 +33,7 @@
 #include "../state.h"
 #include "board.h"
 #include "outputrepresentation.h"
+#include "util/statehistory.h"
 using namespace std;
 
 
@@ -384,11 +385,11 @@ inline static constexpr Version CURRENT_VERSION() {
 
 };
 
-class BoardState : public State
+class BoardState final : public State
 {
 private:
     Board board;
-    StateListPtr states;
+    StateHistory<StateInfo, STATE_HISTORY_INLINE_SIZE> states;
 public:
     BoardState();
     BoardState(const BoardState& b);
@@ -407,12 +408,15 @@ public:
     unsigned int number_repetitions() const override;
     int side_to_move() const override;
     Key hash_key() const override;
+    Key colour_symmetric_hash_key(Version version) const override;
     void flip() override;
     Action uci_to_action(string& uciStr) const override;
     string action_to_san(Action action, const vector<Action>& legalActions, bool leadsToWin=false, bool bookMove=false) const override;
     TerminalType is_terminal(size_t numberLegalMoves, float& customTerminalValue) const override;
+    bool is_draw_by_rule() const override;
     bool gives_check(Action action) const override;
     void print(ostream& os) const override;
+    bool could_be_in_tablebase() const override;
     Tablebase::WDLScore check_for_tablebase_wdl(Tablebase::ProbeState &result) override;
     void set_auxiliary_outputs(const float* auxiliaryOutputs) override;
     BoardState* clone() const override;
@@ -22,6 +22,15 @@
 #include "chessbatchstream.h"
 #include "uci.h"
 #include "stateobj.h"
+#include "../../util/communication.h"
+#include <cuda_runtime_api.h>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 ChessBatchStream::ChessBatchStream(int batchSize, int maxBatches):
     mBatchSize{batchSize},
@@ -109,8 +118,82 @@ ChessBatchStream::ChessBatchStream(int batchSize, int maxBatches):
     }
 }
 
+ChessBatchStream::ChessBatchStream(int batchSize, int maxBatches, const string& epdFile):
+    mBatchSize{batchSize},
+    mMaxBatches{maxBatches},
+    mDims{batchSize, int(StateConstants::NB_CHANNELS_TOTAL()), int(StateConstants::BOARD_HEIGHT()), int(StateConstants::BOARD_WIDTH())}
+{
+    Bitboards::init();
+    Position::init();
+    Bitbases::init();
+    mUiThread = make_shared<Thread>(0);
+    mData.resize(StateConstants::NB_VALUES_TOTAL() * batchSize);
+
+    const int fd = open(epdFile.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd == -1 || fstat(fd, &fileStat) == -1 || fileStat.st_size == 0) {
+        if (fd != -1) {
+            close(fd);
+        }
+        throw invalid_argument("The calibration file " + epdFile + " couldn't be read.");
+    }
+    mFileSize = size_t(fileStat.st_size);
+    void* fileData = mmap(nullptr, mFileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (fileData == MAP_FAILED) {
+        throw invalid_argument("The calibration file " + epdFile + " couldn't be mapped into memory.");
+    }
+    mFileData = static_cast<const char*>(fileData);
+    // the positions are read in sequential order
+    madvise(fileData, mFileSize, MADV_SEQUENTIAL);
+}
+
+ChessBatchStream::~ChessBatchStream()
+{
+    if (mFileData != nullptr) {
+        munmap(const_cast<char*>(mFileData), mFileSize);
+    }
+}
+
+bool ChessBatchStream::read_epd_batch()
+{
+    Board pos;
+    StateListPtr states;
+    int batchIdx = 0;
+    while (batchIdx < mBatchSize && mFileOffset < mFileSize) {
+        const char* lineBegin = mFileData + mFileOffset;
+        const char* lineEnd = static_cast<const char*>(memchr(lineBegin, '\n', mFileSize - mFileOffset));
+        if (lineEnd == nullptr) {
+            lineEnd = mFileData + mFileSize;
+        }
+        mFileOffset = lineEnd - mFileData + 1;
+
+        // an EPD line starts with the first four FEN fields followed by optional operations
+        istringstream line(string(lineBegin, lineEnd));
+        string fen, field;
+        for (int fieldIdx = 0; fieldIdx < 4 && line >> field; ++fieldIdx) {
+            fen += field + " ";
+        }
+        if (field.empty()) {
+            continue;
+        }
+        fen += "0 1";
+        states = StateListPtr(new std::deque<StateInfo>(1));
+        pos.set(fen, false, Variant(StateConstants::DEFAULT_VARIANT()), &states->back(), mUiThread.get());
+        board_to_planes(&pos, 0, true, mData.data() + StateConstants::NB_VALUES_TOTAL() * batchIdx, StateConstants::NB_VALUES_TOTAL());
+        ++batchIdx;
+    }
+    return batchIdx == mBatchSize;
+}
+
 void ChessBatchStream::reset(int firstBatch)
 {
+    if (mFileData != nullptr) {
+        mFileOffset = 0;
+        mBatchCount = 0;
+        skip(firstBatch);
+        return;
+    }
     mBatchCount = firstBatch;
 }
 
@@ -120,18 +203,28 @@ bool ChessBatchStream::next()
     {
         return false;
     }
+    if (mFileData != nullptr && !read_epd_batch()) {
+        return false;
+    }
     ++mBatchCount;
     return true;
 }
 
 void ChessBatchStream::skip(int skipCount)
 {
+    if (mFileData != nullptr) {
+        for (int idx = 0; idx < skipCount && read_epd_batch(); ++idx);
+    }
     mBatchCount += skipCount;
 }
 
 float* ChessBatchStream::getBatch()
 {
-    return mData.data() + (mBatchCount * mBatchSize * samplesCommon::volume(mDims));
+    if (mFileData != nullptr) {
+        return mData.data();
+    }
+    // next() has already moved on to the following batch index
+    return mData.data() + ((mBatchCount - 1) * mBatchSize * StateConstants::NB_VALUES_TOTAL());
 }
 
 float* ChessBatchStream::getLabels()
@@ -161,6 +254,56 @@ nvinfer1::Dims ChessBatchStream::getDims() const
     return dims;
 }
 
+ChessInt8Calibrator::ChessInt8Calibrator(ChessBatchStream& stream, const string& cacheFile):
+    mStream(stream),
+    mCacheFile(cacheFile),
+    mInputCount(size_t(stream.getBatchSize()) * StateConstants::NB_VALUES_TOTAL())
+{
+    cudaMalloc(&mDeviceInput, mInputCount * sizeof(float));
+    mStream.reset(0);
+}
+
+ChessInt8Calibrator::~ChessInt8Calibrator()
+{
+    cudaFree(mDeviceInput);
+}
+
+int ChessInt8Calibrator::getBatchSize() const TRT_NOEXCEPT
+{
+    return mStream.getBatchSize();
+}
+
+bool ChessInt8Calibrator::getBatch(void* bindings[], const char* names[], int nbBindings) TRT_NOEXCEPT
+{
+    if (!mStream.next()) {
+        return false;
+    }
+    cudaMemcpy(mDeviceInput, mStream.getBatch(), mInputCount * sizeof(float), cudaMemcpyHostToDevice);
+    bindings[0] = mDeviceInput;
+    return true;
+}
+
+const void* ChessInt8Calibrator::readCalibrationCache(size_t& length) TRT_NOEXCEPT
+{
+    mCalibrationCache.clear();
+    ifstream input(mCacheFile, ios::binary);
+    if (input.good()) {
+        mCalibrationCache.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+        info_string("load INT8 calibration table:", mCacheFile);
+    }
+    length = mCalibrationCache.size();
+    return length != 0 ? mCalibrationCache.data() : nullptr;
+}
+
+void ChessInt8Calibrator::writeCalibrationCache(const void* cache, size_t length) TRT_NOEXCEPT
+{
+    ofstream output(mCacheFile, ios::binary);
+    output.write(static_cast<const char*>(cache), length);
+    if (!output.good()) {
+        info_string_important("Failed to write the INT8 calibration table to", mCacheFile);
+    }
+}
+
 void reset_to_startpos(Board& pos, Thread* uiThread, StateListPtr& states)
 {
     states = StateListPtr(new std::deque<StateInfo>(1));
@@ -23,7 +23,7 @@
  * @author: queensgambit
  *
  * Calibration stream data for INT8 quantization.
- * The calibration data is generated using sample chess positions.
+ * The calibration data is either generated using sample chess positions or streamed from an EPD file.
  */
 
 #ifndef CHESSBATCHSTREAM_H
@@ -37,6 +37,15 @@
 #include "BatchStream.h"
 #include "environments/chess_related/inputrepresentation.h"
 #include "constants.h"
+#include <memory>
+#include <string>
+
+#ifndef TRT_NOEXCEPT
+#define TRT_NOEXCEPT
+#endif
+
+// maximum number of positions which are read from a calibration file
+#define INT8_CALIBRATION_MAX_POSITIONS 1024
 
 /**
  * @brief The ChessBatchStream class
@@ -48,6 +57,18 @@ class ChessBatchStream : public IBatchStream
 public:
     ChessBatchStream(int batchSize, int maxBatches);
 
+    /**
+     * @brief ChessBatchStream Streams the calibration batches lazily from a memory mapped EPD file.
+     * Only a single batch is kept in memory and the positions are converted when the batch is requested.
+     * @param batchSize Batch size
+     * @param maxBatches Maximum number of batches (the stream ends earlier if the file contains less positions)
+     * @param epdFile Path to the EPD file with one position per line
+     */
+    ChessBatchStream(int batchSize, int maxBatches, const std::string& epdFile);
+    ~ChessBatchStream();
+    ChessBatchStream(const ChessBatchStream&) = delete;
+    ChessBatchStream& operator=(const ChessBatchStream&) = delete;
+
     void reset(int firstBatch) override;
 
     bool next() override;
@@ -71,6 +92,46 @@ private:
     nvinfer1::Dims mDims{};
     std::vector<float> mData;
     std::vector<float> mLabels{};
+
+    // memory mapped EPD file (nullptr if the sample games are replayed)
+    const char* mFileData{nullptr};
+    size_t mFileSize{0};
+    size_t mFileOffset{0};
+    std::shared_ptr<Thread> mUiThread;
+
+    /**
+     * @brief read_epd_batch Converts the next positions of the EPD file into the input planes of a single batch
+     * @return False if the file doesn't contain enough positions for a full batch
+     */
+    bool read_epd_batch();
+};
+
+/**
+ * @brief The ChessInt8Calibrator class feeds the batches of a ChessBatchStream to the TensorRT INT8 calibration
+ * and persists the calibration table at the given path, so that the calibration is only run once per model.
+ */
+class ChessInt8Calibrator : public nvinfer1::IInt8EntropyCalibrator2
+{
+public:
+    /**
+     * @brief ChessInt8Calibrator
+     * @param stream Calibration stream
+     * @param cacheFile File path of the calibration table
+     */
+    ChessInt8Calibrator(ChessBatchStream& stream, const std::string& cacheFile);
+    ~ChessInt8Calibrator() override;
+
+    int getBatchSize() const TRT_NOEXCEPT override;
+    bool getBatch(void* bindings[], const char* names[], int nbBindings) TRT_NOEXCEPT override;
+    const void* readCalibrationCache(size_t& length) TRT_NOEXCEPT override;
+    void writeCalibrationCache(const void* cache, size_t length) TRT_NOEXCEPT override;
+
+private:
+    ChessBatchStream& mStream;
+    std::string mCacheFile;
+    size_t mInputCount;
+    void* mDeviceInput{nullptr};
+    std::vector<char> mCalibrationCache;
 };
 
 void reset_to_startpos(Board& pos, Thread* uiThread, StateListPtr& states);
@@ -34,14 +34,11 @@ inline void set_bits_from_bitmap(Bitboard bitboard, float *curIt, bool flipBoard
     if (flipBoard) {
         bitboard = flip_vertical(bitboard);
     }
-    // set the individual bits for the pieces
+    // set the individual bits for the pieces by only visiting the set bits
     // https://lemire.me/blog/2018/02/21/iterating-over-set-bits-quickly/
     while (bitboard != 0) {
-        if (bitboard & 0x1) {
-            *curIt = 1;
-        }
-        bitboard >>= 1;
-        ++curIt;
+        curIt[lsb(bitboard)] = 1;
+        bitboard &= bitboard - 1;
     }
 }
 
@@ -301,16 +298,9 @@ inline void set_piece_masks(PlaneData& p)
 
 inline void set_checkerboard(PlaneData& p)
 {
-    bool targetModulo = 1;
-    for (uint row = 0; row < StateConstants::BOARD_HEIGHT(); ++row) {
-        for (uint col = 0; col < StateConstants::BOARD_WIDTH(); ++col) {
-            if (col % 2 == targetModulo) {
-                *p.curIt = 1.0f;
-            }
-            ++p.curIt;
-        }
-        targetModulo = !targetModulo;
-    }
+    // odd columns on the first row, even columns on the second row, ... (independent of the side to move)
+    set_bits_from_bitmap(0x55AA55AA55AA55AAULL, p.curIt, false);
+    p.increment_channel();
 }
 
 inline void set_single_relative_count(PlaneData& p, const float relativeCount)
@@ -500,10 +490,15 @@ inline void default_board_to_planes(PlaneData& planeData, size_t boardRepetition
     assert(planeData.current_channel() == nbChannelsTotal);
 }
 
+// The layout functions are templated on zeroPlanes: a layout that extends another layout clears its planes once
+// and calls the base layout with zeroPlanes=false, so that the memory isn't cleared twice.
+template<bool zeroPlanes=true>
 inline void board_to_planes_chess_v_2_7(PlaneData& planeData, const vector<Action>& legalMoves)
 {
     const uint_fast32_t nbChannelsTotal = 33;
-    planeData.set_all_planes_to_zero(nbChannelsTotal);
+    if (zeroPlanes) {
+        planeData.set_all_planes_to_zero(nbChannelsTotal);
+    }
     set_plane_pieces(planeData);
     set_plane_ep_square(planeData);
     assert(planeData.current_channel() == StateConstants::NB_CHANNELS_POS());
@@ -527,16 +522,19 @@ inline void board_to_planes_chess_v_2_8(PlaneData& planeData, const vector<Actio
 {
     const uint_fast32_t nbChannelsTotal = 38;
     planeData.set_all_planes_to_zero(nbChannelsTotal);
-    board_to_planes_chess_v_2_7(planeData, legalMoves);
+    board_to_planes_chess_v_2_7<false>(planeData, legalMoves);
     set_material_count(planeData);
     assert(planeData.current_channel() == nbChannelsTotal);
 }
 
 
+template<bool zeroPlanes=true>
 inline void board_to_planes_chess_v3(PlaneData& planeData, size_t boardRepetition)
 {
     const uint_fast32_t nbChannelsTotal = 52;
-    planeData.set_all_planes_to_zero(nbChannelsTotal);
+    if (zeroPlanes) {
+        planeData.set_all_planes_to_zero(nbChannelsTotal);
+    }
     set_plane_pieces(planeData);
     set_plane_repetition(planeData, boardRepetition);
     set_plane_ep_square(planeData);
@@ -570,7 +568,7 @@ inline void board_to_planes_crazyhouse_v3(PlaneData& planeData, size_t boardRepe
 {
     const uint_fast32_t nbChannelsTotal = 64;
     planeData.set_all_planes_to_zero(nbChannelsTotal);
-    board_to_planes_chess_v3(planeData, boardRepetition);
+    board_to_planes_chess_v3<false>(planeData, boardRepetition);
     set_plane_pockets(planeData);
     set_plane_promoted_pieces(planeData);
     assert(planeData.current_channel() == nbChannelsTotal);
@@ -679,3 +677,54 @@ void board_to_planes(const Board *pos, size_t boardRepetition, bool normalize, f
     default_board_to_planes(planeData, boardRepetition);
 }
 
+
+bool is_colour_symmetric_input(Version version)
+{
+#ifdef MODE_CHESS
+    return version >= make_version<2,7,0>();
+#else
+    return version >= make_version<3,0,0>();
+#endif
+}
+
+inline Key mix_key(Key key, uint64_t value)
+{
+    key = (key ^ value) * 0x9E3779B97F4A7C15ULL;
+    return key ^ (key >> 29);
+}
+
+Key side_relative_hash_key(const Board& pos)
+{
+    const Color me = pos.side_to_move();
+    const bool flipBoard = flip_board(pos, me);
+    Key key = 0;
+    for (Color color : {me, ~me}) {
+        for (PieceType piece: {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING}) {
+            const Bitboard pieces = pos.pieces(color, piece);
+            key = mix_key(key, flipBoard ? flip_vertical(pieces) : pieces);
+        }
+#ifdef CRAZYHOUSE
+        for (PieceType piece: {PAWN, KNIGHT, BISHOP, ROOK, QUEEN}) {
+            key = mix_key(key, pos.get_pocket_count(color, piece));
+        }
+        const Bitboard promoted = pos.promoted_pieces() & pos.pieces(color);
+        key = mix_key(key, flipBoard ? flip_vertical(promoted) : promoted);
+#endif
+#ifdef THREECHECK
+        key = mix_key(key, pos.checks_given(color));
+#endif
+    }
+    // castling rights of the side to move in the lower bits, like in set_plane_castling_rights()
+    const uint64_t whiteCastling = uint64_t(bool(pos.can_castle(WHITE_OO))) | uint64_t(bool(pos.can_castle(WHITE_OOO))) << 1;
+    const uint64_t blackCastling = uint64_t(bool(pos.can_castle(BLACK_OO))) | uint64_t(bool(pos.can_castle(BLACK_OOO))) << 1;
+    key = mix_key(key, me == WHITE ? whiteCastling | blackCastling << 2 : blackCastling | whiteCastling << 2);
+    if (pos.ep_square() != SQ_NONE) {
+        key = mix_key(key, flipBoard ? vertical_flip(pos.ep_square()) : pos.ep_square());
+    }
+    key = mix_key(key, pos.rule50_count());
+    key = mix_key(key, pos.is_chess960());
+#ifdef MODE_LICHESS
+    key = mix_key(key, pos.variant());
+#endif
+    return key;
+}
@@ -41,6 +41,22 @@
  */
 void board_to_planes(const Board *pos, size_t boardRepetition, bool normalize, float* inputPlanes, Version version);
 
+/**
+ * @brief is_colour_symmetric_input Returns true, if the input representation of the given version neither encodes the colour
+ * of the side to move nor the total move count. A position and its colour mirrored counterpart then result in identical inputs.
+ * @param version Version of the input representation
+ * @return bool
+ */
+bool is_colour_symmetric_input(Version version);
+
+/**
+ * @brief side_relative_hash_key Computes a hash key of the board from the point of view of the side to move like the input planes.
+ * It is identical for a position and its colour mirrored counterpart with the other side to move. The move history is ignored.
+ * @param pos Board position
+ * @return Key
+ */
+Key side_relative_hash_key(const Board& pos);
+
 /**
  * @brief set_bits_from_bitmap Sets the individual bits from a given bitboard on the given channel for the inputPlanes
  * @param bitboard Bitboard of a single 8x8 plane
@@ -33,10 +33,11 @@
 #include <blaze/Math.h>
 #include "constants.h"
 #include "state.h"
+#include "util/policyindextable.h"
 
 using blaze::HybridVector;
 using blaze::DynamicVector;
-using action_idx_map = Action[USHRT_MAX];
+using action_idx_map = PolicyIndexTable;
 
 using namespace std;
 
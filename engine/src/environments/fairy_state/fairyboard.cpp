@@ -40,6 +40,10 @@ Key FairyBoard::hash_key() const {
     return state()->key;
 }
 
+void FairyBoard::set_state_info(StateInfo* st) {
+    this->st = st;
+}
+
 bool FairyBoard::is_terminal() const {
     // "Unlike in chess, in which stalemate is a draw, in xiangqi, it is a loss for the stalemated player."
     // -- https://en.wikipedia.org/wiki/Xiangqi
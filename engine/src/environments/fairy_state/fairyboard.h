@@ -18,6 +18,7 @@ public:
 
     int get_pocket_count(Color c, PieceType pt) const;
     Key hash_key() const;
+    void set_state_info(StateInfo* st);
     bool is_terminal() const;
     size_t number_repetitions() const;
 };
@@ -3,22 +3,19 @@
 
 using namespace std;
 
-void set_bits_from_bitmap(Bitboard bitboard, size_t channel, float *inputPlanes, Color color) {
-    size_t p = 0;
+/**
+ * @brief set_bits_from_bitmap Sets the individual bits from a given bitboard on a single plane
+ * by only visiting the set bits (the board size is known at compile time)
+ * @param bitboard Bitboard of the wide Fairy-Stockfish board (Largeboards use 12 files per rank)
+ * @param curIt Start of the plane
+ */
+template <uint boardWidth, uint boardHeight, bool flipVertical>
+inline void set_bits_from_bitmap(Bitboard bitboard, float *curIt) {
     while (bitboard != Bitboard(0)) {
-        if (bitboard & Bitboard(0x1)) {
-            if (color == WHITE) {
-                int col = std::abs(9-std::floor(p/9));
-                int row = p % 9;
-                inputPlanes[channel * StateConstantsFairy::NB_SQUARES() + col * 9 + row] = 1;
-            }
-            else {
-                inputPlanes[channel * StateConstantsFairy::NB_SQUARES() + p] = 1;
-            }
-        }
-        // Largeboards use 12 files per rank, xiangqi boards only use 9 files per rank
-        (p+1) % 9 == 0 ? bitboard = bitboard >> 4 : bitboard = bitboard >> 1;
-        p++;
+        const Square square = lsb(bitboard);
+        const uint rank = flipVertical ? boardHeight - 1 - uint(rank_of(square)) : uint(rank_of(square));
+        curIt[rank * boardWidth + uint(file_of(square))] = 1;
+        bitboard &= bitboard - 1;
     }
 }
 
@@ -29,19 +26,10 @@ void board_to_planes(const FairyBoard* pos, bool normalize, float *inputPlanes)
     Color you = ~me;
 
 #ifdef MODE_BOARDGAMES
-    // iterate over all board squares
-    size_t currentIdx = 0;
+    // pieces of both players
     for (Color color : {me, you}) {
-        for (Rank rank = RANK_1; rank < Rank(StateConstantsFairy::BOARD_HEIGHT()); ++rank) {
-            for (File file = FILE_A; file < File(StateConstantsFairy::BOARD_WIDTH()); ++file) {
-                const Square square = make_square(file, rank);
-                const Piece piece = pos->piece_on(square);
-                if (piece != NO_PIECE && color_of(piece) == color) {
-                    inputPlanes[currentIdx] = 1;
-                }
-                currentIdx++;
-            }
-        }
+        set_bits_from_bitmap<StateConstantsFairy::NB_SQUARES_HORIZONTAL(), StateConstantsFairy::NB_SQUARES_VERTICAL(), false>(
+                    pos->pieces(color), inputPlanes + currentChannel * StateConstantsFairy::NB_SQUARES());
         currentChannel++;
     }
 #endif
@@ -50,8 +38,14 @@ void board_to_planes(const FairyBoard* pos, bool normalize, float *inputPlanes)
     // pieces (ORDER: King, Advisor, Elephant, Horse, Rook, Cannon, Soldier)
     for (Color color : {me, you}) {
         for (PieceType piece : {KING, FERS, ELEPHANT, HORSE, ROOK, CANNON, SOLDIER}) {
-            const Bitboard pieces = pos->pieces(color, piece);
-            set_bits_from_bitmap(pieces, currentChannel, inputPlanes, me);
+            float* curIt = inputPlanes + currentChannel * StateConstantsFairy::NB_SQUARES();
+            // the ranks are mirrored if WHITE is to move
+            if (me == WHITE) {
+                set_bits_from_bitmap<StateConstantsFairy::NB_SQUARES_HORIZONTAL(), StateConstantsFairy::NB_SQUARES_VERTICAL(), true>(pos->pieces(color, piece), curIt);
+            }
+            else {
+                set_bits_from_bitmap<StateConstantsFairy::NB_SQUARES_HORIZONTAL(), StateConstantsFairy::NB_SQUARES_VERTICAL(), false>(pos->pieces(color, piece), curIt);
+            }
             currentChannel++;
         }
     }
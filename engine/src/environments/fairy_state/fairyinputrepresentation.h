@@ -11,13 +11,4 @@
  */
 void board_to_planes(const FairyBoard* pos, bool normalize, float *inputPlanes);
 
-/**
- * @brief set_bits_from_bitmap Sets the individual bits from a given bitboard on the given channel for the inputPlanes
- * @param bitboard Bitboard of a single 8x8 plane
- * @param channel Channel index on where to set the bits
- * @param input_planes Input planes encoded as flat vector
- * @param color Color of the side to move
- */
-inline void set_bits_from_bitmap(Bitboard bitboard, size_t channel, float *inputPlanes, Color color);
-
 #endif // FAIRYINPUTREPRESENTATION_H
@@ -197,6 +197,7 @@ void FairyOutputRepresentation::init_policy_constants(bool isPolicyMap) {
         Square fromSquare = get_origin_square(LABELS[i]);
         Square toSquare = get_destination_square(LABELS[i]);
         Move move = make_move(fromSquare, toSquare);
+        assert(size_t(move) < POLICY_INDEX_TABLE_SIZE);
         isPolicyMap ? MV_LOOKUP[move] = FLAT_PLANE_IDX[i] : MV_LOOKUP[move] = i;
         MV_LOOKUP_CLASSIC[move] = i;
 
@@ -3,13 +3,13 @@
 
 #include <climits>
 #include <array>
-#include <unordered_map>
 #include <blaze/Math.h>
 #include "state.h"
+#include "util/policyindextable.h"
 
 using blaze::HybridVector;
 using blaze::DynamicVector;
-using action_idx_map = unordered_map<Action, int_fast32_t>;
+using action_idx_map = PolicyIndexTable;
 
 using namespace std;
 
@@ -14,33 +14,36 @@ vector<std::string> FairyOutputRepresentation::LABELS_MIRRORED;
 
 FairyState::FairyState() :
         State(),
-        states(StateListPtr(new std::deque<StateInfo>(0))),
         variantNumber(0) {}
 
 FairyState::FairyState(const FairyState &f) :
         State(),
         board(f.board),
-        states(StateListPtr(new std::deque<StateInfo>(0))),
         variantNumber(f.variantNumber){
-    states->emplace_back(f.states->back());
+    // only the current entry is copied, the previous entries which are needed for the repetition detection remain in the history of f
+    if (f.states.size() != 0) {
+        board.set_state_info(&states.emplace_back(f.states.back()));
+    }
 }
 
 std::vector<Action> FairyState::legal_actions() const {
+    const MoveList<LEGAL> moveList(board);
     std::vector<Action> legalMoves;
-    for (const ExtMove &move : MoveList<LEGAL>(board)) {
+    legalMoves.reserve(moveList.size());
+    for (const ExtMove &move : moveList) {
         legalMoves.push_back(Action(move.move));
     }
     return legalMoves;
 }
 
 void FairyState::set(const string &fenStr, bool isChess960, int variant) {
-    states = StateListPtr(new std::deque<StateInfo>(1));
+    states.clear();
     Thread *thread;
 #ifdef MODE_BOARDGAMES
-    board.set(variants.find(StateConstantsFairy::available_variants()[variant])->second, fenStr, isChess960, &states->back(), thread, false);
+    board.set(variants.find(StateConstantsFairy::available_variants()[variant])->second, fenStr, isChess960, &states.emplace_back(), thread, false);
     variantNumber = variant;
 #else
-    board.set(variants.find("xiangqi")->second, fenStr, isChess960, &states->back(), thread, false);
+    board.set(variants.find("xiangqi")->second, fenStr, isChess960, &states.emplace_back(), thread, false);
 #endif
 }
 
@@ -61,12 +64,12 @@ string FairyState::fen() const {
 }
 
 void FairyState::do_action(Action action) {
-    states->emplace_back();
-    board.do_move(Move(action), states->back());
+    board.do_move(Move(action), states.emplace_back());
 }
 
 void FairyState::undo_action(Action action) {
     board.undo_move(Move(action));
+    states.pop_back();
 }
 
 void FairyState::prepare_action() {
@@ -155,8 +158,8 @@ void FairyState::set_auxiliary_outputs(const float* auxiliaryOutputs) {
 
 void FairyState::init(int variant, bool isChess960)
 {
-    states = StateListPtr(new std::deque<StateInfo>(1));
-    board.set(variants.find(StateConstantsFairy::available_variants()[variant])->second, variants.find(StateConstantsFairy::available_variants()[variant])->second->startFen, isChess960, &states->back(), nullptr, false);
+    states.clear();
+    board.set(variants.find(StateConstantsFairy::available_variants()[variant])->second, variants.find(StateConstantsFairy::available_variants()[variant])->second->startFen, isChess960, &states.emplace_back(), nullptr, false);
     variantNumber = variant;
 }
 
@@ -6,6 +6,7 @@
 #include "state.h"
 #include "uci.h"
 #include "variant.h"
+#include "util/statehistory.h"
 
 class StateConstantsFairy : public StateConstantsInterface<StateConstantsFairy>
 {
@@ -64,29 +65,29 @@ public:
                 return moveIdx;
             }
         }
-        return FairyOutputRepresentation::MV_LOOKUP[action];
+        return FairyOutputRepresentation::MV_LOOKUP.get(action);
 #endif
         switch (p) {
             case normal:
                 switch (m) {
                     case notMirrored:
-                        return FairyOutputRepresentation::MV_LOOKUP[action];
+                        return FairyOutputRepresentation::MV_LOOKUP.get(action);
                     case mirrored:
-                        return FairyOutputRepresentation::MV_LOOKUP_MIRRORED[action];
+                        return FairyOutputRepresentation::MV_LOOKUP_MIRRORED.get(action);
                     default:
-                        return FairyOutputRepresentation::MV_LOOKUP[action];
+                        return FairyOutputRepresentation::MV_LOOKUP.get(action);
                 }
             case classic:
                 switch (m) {
                     case notMirrored:
-                        return FairyOutputRepresentation::MV_LOOKUP_CLASSIC[action];
+                        return FairyOutputRepresentation::MV_LOOKUP_CLASSIC.get(action);
                     case mirrored:
-                        return FairyOutputRepresentation::MV_LOOKUP_MIRRORED_CLASSIC[action];
+                        return FairyOutputRepresentation::MV_LOOKUP_MIRRORED_CLASSIC.get(action);
                     default:
-                        return FairyOutputRepresentation::MV_LOOKUP_CLASSIC[action];
+                        return FairyOutputRepresentation::MV_LOOKUP_CLASSIC.get(action);
                 }
             default:
-                return FairyOutputRepresentation::MV_LOOKUP[action];
+                return FairyOutputRepresentation::MV_LOOKUP.get(action);
         }
     }
     // Currently only ucci notation is supported
@@ -117,10 +118,10 @@ public:
     }
 
 #ifdef MODE_BOARDGAMES
-    static uint NB_SQUARES_HORIZONTAL() {
+    static constexpr uint NB_SQUARES_HORIZONTAL() {
         return 8;
     }
-    static uint NB_SQUARES_VERTICAL() {
+    static constexpr uint NB_SQUARES_VERTICAL() {
         return 8;
     }
     static uint NB_CHANNELS_POS() {
@@ -136,10 +137,10 @@ public:
         return 500;
     }
 #else  // MODE_XIANGQI
-    static uint NB_SQUARES_HORIZONTAL() {
+    static constexpr uint NB_SQUARES_HORIZONTAL() {
         return 9;
     }
-    static uint NB_SQUARES_VERTICAL() {
+    static constexpr uint NB_SQUARES_VERTICAL() {
         return 10;
     }
     static uint NB_CHANNELS_POS() {
@@ -194,11 +195,11 @@ public:
 
 };
 
-class FairyState : public State
+class FairyState final : public State
 {
 private:
     FairyBoard board;
-    StateListPtr states;
+    StateHistory<StateInfo, STATE_HISTORY_INLINE_SIZE> states;
     int variantNumber;
 
 public:
@@ -26,17 +26,40 @@
 #include "openspielstate.h"
 #include "util/communication.h"
 #include <functional>
+#include <random>
+
+// maximum number of cells of a placement game for which Zobrist keys are available
+const size_t NB_MAX_ZOBRIST_CELLS = 19 * 19;
+
+/**
+ * @brief get_zobrist_key Returns the random key of a stone of the given player on the given cell
+ */
+static Key get_zobrist_key(open_spiel::Player player, open_spiel::Action cell)
+{
+    static const std::vector<Key> zobristKeys = [] {
+        std::mt19937_64 prng(1070372);
+        std::vector<Key> keys(open_spiel::hex::kNumPlayers * NB_MAX_ZOBRIST_CELLS);
+        for (Key& key : keys) {
+            key = prng();
+        }
+        return keys;
+    }();
+    return zobristKeys[player * NB_MAX_ZOBRIST_CELLS + cell];
+}
 
 OpenSpielState::OpenSpielState():
     currentVariant(open_spiel::gametype::SupportedOpenSpielVariants::HEX),
     spielGame(open_spiel::LoadGame(StateConstantsOpenSpiel::variant_to_string(currentVariant))),
     spielState(spielGame->NewInitialState())
 {
+    reset_hash_key();
 }
 
 OpenSpielState::OpenSpielState(const OpenSpielState &openSpielState):
+    currentVariant(openSpielState.currentVariant),
     spielGame(openSpielState.spielGame->shared_from_this()),
-    spielState(openSpielState.spielState->Clone())
+    spielState(openSpielState.spielState->Clone()),
+    hashKey(openSpielState.hashKey)
 {
 }
 
@@ -53,6 +76,47 @@ inline void OpenSpielState::check_variant(int variant)
     }
 }
 
+inline bool OpenSpielState::is_placement_game() const
+{
+    return (currentVariant == open_spiel::gametype::SupportedOpenSpielVariants::HEX ||
+            currentVariant == open_spiel::gametype::SupportedOpenSpielVariants::DARKHEX) &&
+            size_t(spielGame->NumDistinctActions()) <= NB_MAX_ZOBRIST_CELLS;
+}
+
+inline open_spiel::Action OpenSpielState::to_spiel_action(Action action, open_spiel::Player player) const
+{
+    if (player == 1) {
+        // the second player sees the transposed board
+        const int X = action / 11; //currently easier to set board size fix; change it later
+        const int Y = action % 11;
+        return Y*11+X;
+    }
+    return action;
+}
+
+inline void OpenSpielState::update_hash_key(open_spiel::Player player, open_spiel::Action spielAction)
+{
+    if (is_placement_game()) {
+        // placing and removing a stone are the same xor operation
+        hashKey ^= get_zobrist_key(player, spielAction);
+        return;
+    }
+    // the board delta of the other games isn't exposed by OpenSpiel, so their string is hashed once per action instead of once per call
+    hashKey = std::hash<std::string>()(spielState->ToString());
+}
+
+void OpenSpielState::reset_hash_key()
+{
+    if (is_placement_game()) {
+        hashKey = 0;
+        for (const open_spiel::State::PlayerAction& playerAction : spielState->FullHistory()) {
+            hashKey ^= get_zobrist_key(playerAction.player, playerAction.action);
+        }
+        return;
+    }
+    hashKey = std::hash<std::string>()(spielState->ToString());
+}
+
 void OpenSpielState::set(const std::string &fenStr, bool isChess960, int variant)
 {
     check_variant(variant);
@@ -61,14 +125,17 @@ void OpenSpielState::set(const std::string &fenStr, bool isChess960, int variant
         return;
     }
     spielState = spielGame->NewInitialState(fenStr);
+    reset_hash_key();
 }
 
 void OpenSpielState::get_state_planes(bool normalize, float *inputPlanes, Version version) const
 {
-    std::fill(inputPlanes, inputPlanes+StateConstantsOpenSpiel::NB_VALUES_TOTAL(), 0.0f);
-    std::vector<float> v(spielGame->ObservationTensorSize());
-    spielState->ObservationTensor(spielState->CurrentPlayer(), absl::MakeSpan(v));
-    std::copy( v.begin(), v.end(), inputPlanes);
+    // the observation is written directly into the batch buffer, OpenSpiel sets all values of the given span
+    const size_t observationSize = spielGame->ObservationTensorSize();
+    spielState->ObservationTensor(spielState->CurrentPlayer(), absl::MakeSpan(inputPlanes, observationSize));
+    if (observationSize < StateConstantsOpenSpiel::NB_VALUES_TOTAL()) {
+        std::fill(inputPlanes+observationSize, inputPlanes+StateConstantsOpenSpiel::NB_VALUES_TOTAL(), 0.0f);
+    }
 }
 
 unsigned int OpenSpielState::steps_from_null() const
@@ -88,19 +155,18 @@ std::string OpenSpielState::fen() const
 
 void OpenSpielState::do_action(Action action)
 {
-    auto player = spielState->CurrentPlayer();
-    if(player == 1){
-        int X = action / 11; //currently easier to set board size fix; change it later
-        int Y = action % 11;
-        spielState->ApplyAction(Y*11+X);
-        return;
-    }
-    spielState->ApplyAction(action);
+    const open_spiel::Player player = spielState->CurrentPlayer();
+    const open_spiel::Action spielAction = to_spiel_action(action, player);
+    spielState->ApplyAction(spielAction);
+    update_hash_key(player, spielAction);
 }
 
 void OpenSpielState::undo_action(Action action)
 {
-    spielState->UndoAction(!spielState->CurrentPlayer(), action); // note: this formulation assumes a two player, non-simultaneaous game
+    const open_spiel::Player player = !spielState->CurrentPlayer(); // note: this formulation assumes a two player, non-simultaneaous game
+    const open_spiel::Action spielAction = to_spiel_action(action, player);
+    spielState->UndoAction(player, spielAction);
+    update_hash_key(player, spielAction);
 }
 
 void OpenSpielState::prepare_action()
@@ -124,8 +190,7 @@ int OpenSpielState::side_to_move() const
 
 Key OpenSpielState::hash_key() const
 {
-    std::hash<std::string> hash_string;
-    return hash_string(this->fen());
+    return hashKey;
 }
 
 void OpenSpielState::flip()
@@ -192,6 +257,7 @@ OpenSpielState* OpenSpielState::clone() const
 void OpenSpielState::init(int variant, bool isChess960) {
     check_variant(variant);
     spielState = spielGame->NewInitialState();
+    reset_hash_key();
 }
 
 GamePhase OpenSpielState::get_phase(unsigned int numPhases, GamePhaseDefinition gamePhaseDefinition) const {
@@ -102,12 +102,14 @@ public:
     }
 };
 
-class OpenSpielState : public State
+class OpenSpielState final : public State
 {
 private:
     open_spiel::gametype::SupportedOpenSpielVariants currentVariant;
     std::shared_ptr<const open_spiel::Game> spielGame;
     std::unique_ptr<open_spiel::State> spielState;
+    // hash of the current state which is updated in do_action() and undo_action()
+    Key hashKey;
 
     /**
      * @brief check_variant Checks the given variant against the current active variant and loads a new game type if necessary.
@@ -115,6 +117,27 @@ private:
      */
     inline void check_variant(int variant);
 
+    /**
+     * @brief is_placement_game Returns true for games in which every action places a single stone of the current player on the cell of the action.
+     * For these games the Zobrist key of the board is updated incrementally with the key of the placed stone.
+     */
+    inline bool is_placement_game() const;
+
+    /**
+     * @brief to_spiel_action Converts the action of the engine into the action of OpenSpiel for the given player
+     */
+    inline open_spiel::Action to_spiel_action(Action action, open_spiel::Player player) const;
+
+    /**
+     * @brief update_hash_key Updates the hash key after the given action of the player has been applied or undone
+     */
+    inline void update_hash_key(open_spiel::Player player, open_spiel::Action spielAction);
+
+    /**
+     * @brief reset_hash_key Recomputes the hash key from scratch after a new state has been set
+     */
+    void reset_hash_key();
+
 public:
     OpenSpielState();
     OpenSpielState(const OpenSpielState& openSpielState);
@@ -24,6 +24,8 @@
  */
 
 #include "strategostate.h"
+#include "../../util/randomgen.h"
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <fstream>
@@ -33,14 +35,22 @@ StrategoState::StrategoState():
     spielGame(open_spiel::LoadGame("yorktown")),
     spielState(spielGame->NewInitialState())
 {
+    reset_hash_key();
 }
 
 StrategoState::StrategoState(const StrategoState &strategoState):
     spielGame(strategoState.spielGame->shared_from_this()),
-    spielState(strategoState.spielState->Clone())
+    spielState(strategoState.spielState->Clone()),
+    hashKey(strategoState.hashKey)
 {
 }
 
+inline void StrategoState::reset_hash_key()
+{
+    // the yorktown board isn't exposed by OpenSpiel, so the state string is hashed once per action instead of once per call
+    hashKey = std::hash<std::string>()(spielState->ToString());
+}
+
 
 std::vector<Action> StrategoState::legal_actions() const
 {
@@ -50,13 +60,13 @@ std::vector<Action> StrategoState::legal_actions() const
 void StrategoState::set(const std::string &fenStr, bool isChess960, int variant)
 {
     spielState = spielGame->NewInitialState(fenStr);
+    reset_hash_key();
 }
 
 void StrategoState::get_state_planes(bool normalize, float *inputPlanes, Version version) const
 {
-    std::vector<float> v(spielGame->InformationStateTensorSize());
-    spielState->InformationStateTensor(spielState->CurrentPlayer(), absl::MakeSpan(v));
-    std::copy( v.begin(), v.end(), inputPlanes);
+    // the information state is written directly into the batch buffer
+    spielState->InformationStateTensor(spielState->CurrentPlayer(), absl::MakeSpan(inputPlanes, spielGame->InformationStateTensorSize()));
 }
 
 unsigned int StrategoState::steps_from_null() const
@@ -77,12 +87,13 @@ std::string StrategoState::fen() const
 void StrategoState::do_action(Action action)
 {
     spielState->ApplyAction(action);
-    spielState->ToString();
+    reset_hash_key();
 }
 
 void StrategoState::undo_action(Action action)
 {
     spielState->UndoAction(!spielState->CurrentPlayer(), action); // note: this formulation assumes a two player, non-simultaneaous game
+    reset_hash_key();
 }
 
 void StrategoState::prepare_action()
@@ -103,8 +114,7 @@ int StrategoState::side_to_move() const
 
 Key StrategoState::hash_key() const
 {
-    std::hash<std::string> hash_string;
-    return hash_string(this->fen());
+    return hashKey;
 }
 
 void StrategoState::flip()
@@ -191,6 +201,34 @@ StrategoState* StrategoState::openBoard() const
     return new_state;
 }
 
+StrategoState* StrategoState::sample_hidden_pieces(uint64_t seed) const
+{
+    std::string fen = this->fen();
+    const size_t boardEnd = fen.find(' ');
+    const bool isRedToMove = boardEnd != std::string::npos && fen.compare(boardEnd + 1, 1, "r") == 0;
+    // yorktown notation: the red pieces are 'C'-'N' and the blue pieces 'O'-'Z', upper case pieces haven't been revealed yet
+    const char firstOpponentPiece = isRedToMove ? 'O' : 'C';
+    const char lastOpponentPiece = isRedToMove ? 'Z' : 'N';
+    std::vector<size_t> hiddenSquares;
+    for (size_t idx = 0; idx < std::min(boardEnd, fen.size()); ++idx) {
+        if (fen[idx] >= firstOpponentPiece && fen[idx] <= lastOpponentPiece) {
+            hiddenSquares.push_back(idx);
+        }
+    }
+    // Fisher-Yates shuffle of the hidden pieces, so that every assignment with the same piece counts is equally likely
+    FastRandom random(seed);
+    for (size_t idx = hiddenSquares.size(); idx > 1; --idx) {
+        std::swap(fen[hiddenSquares[idx-1]], fen[hiddenSquares[random.bounded(uint32_t(idx))]]);
+    }
+    std::for_each(fen.begin(), fen.end(), [](char & c){
+            c = ::tolower(c);
+    });
+
+    auto new_state = new StrategoState(*this);
+    new_state->set(fen, false, 0);
+    return new_state;
+}
+
 void StrategoState::init(int variant, bool isChess960) {
     spielState = spielGame->NewInitialState();
   
@@ -218,6 +256,7 @@ void StrategoState::init(int variant, bool isChess960) {
         //std::cout << "Unable to open position file"; 
         spielState = spielGame->NewInitialState();
     }
+    reset_hash_key();
 }
 
 GamePhase StrategoState::get_phase(unsigned int numPhases, GamePhaseDefinition gamePhaseDefinition) const
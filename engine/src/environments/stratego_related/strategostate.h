@@ -82,11 +82,18 @@ public:
     }
 };
 
-class StrategoState : public State
+class StrategoState final : public State
 {
 private:
     std::shared_ptr<const open_spiel::Game> spielGame;
     std::unique_ptr<open_spiel::State> spielState;
+    // hash of the current state which is updated in do_action() and undo_action()
+    Key hashKey;
+
+    /**
+     * @brief reset_hash_key Recomputes the hash key of the current state
+     */
+    inline void reset_hash_key();
 public:
     StrategoState();
     StrategoState(const StrategoState& strategostate);
@@ -116,6 +123,14 @@ public:
     void set_auxiliary_outputs(const float* auxiliaryOutputs);
     StrategoState *clone() const;
     StrategoState *openBoard() const;
+
+    /**
+     * @brief sample_hidden_pieces Returns a determinization of the current state for the side to move. The unrevealed pieces of the opponent
+     * are shuffled over their squares and all pieces are revealed afterwards like in openBoard().
+     * @param seed Seed of the random generator, equal seeds give the same sample
+     * @return New state object
+     */
+    StrategoState *sample_hidden_pieces(uint64_t seed) const;
     void init(int variant, bool isChess960) override;
     GamePhase get_phase(unsigned int numPhases, GamePhaseDefinition gamePhaseDefinition) const override;
 };
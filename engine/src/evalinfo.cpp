@@ -122,7 +122,6 @@ float get_best_move_q(const Node* nextNode, const SearchSettings* searchSettings
 
 void set_eval_for_single_pv(EvalInfo& evalInfo, const Node* rootNode, size_t idx, vector<size_t>& indices, const SearchSettings* searchSettings)
 {
-    vector<Action> pv;
     size_t childIdx;
     if (idx == 0) {
         childIdx = get_best_action_index(rootNode, false, searchSettings);
@@ -130,13 +129,19 @@ void set_eval_for_single_pv(EvalInfo& evalInfo, const Node* rootNode, size_t idx
     else {
         childIdx = indices[idx];
     }
-    pv.push_back(rootNode->get_action(childIdx));
+    set_eval_for_child(evalInfo, rootNode, idx, childIdx, true, searchSettings);
+}
 
+void set_eval_for_child(EvalInfo& evalInfo, const Node* rootNode, size_t idx, size_t childIdx, bool walkPV, const SearchSettings* searchSettings)
+{
     Node* nextNode = rootNode->get_child_node(childIdx);
     // make sure the nextNode has been expanded (e.g. when inference of the NN is too slow on the given hardware to evaluate the next node in time)
     if (nextNode != nullptr) {
-        nextNode->get_principal_variation(pv, searchSettings);
-        evalInfo.pv[idx] = pv;
+        if (walkPV) {
+            evalInfo.pv[idx] = {rootNode->get_action(childIdx)};
+            nextNode->get_principal_variation(evalInfo.pv[idx], searchSettings);
+        }
+        const vector<Action>& pv = evalInfo.pv[idx];
 
         // scores
         // return mate score for known wins and losses
@@ -247,3 +252,51 @@ void update_eval_info(EvalInfo& evalInfo, const Node* rootNode, size_t tbHits, s
     evalInfo.nodes = rootNode->get_node_count();
     evalInfo.tbHits = tbHits;
 }
+
+void update_eval_info_lines(EvalInfo& evalInfo, const Node* rootNode, size_t tbHits, size_t selDepth, const SearchSettings* searchSettings, PVCache& pvCache)
+{
+    if (rootNode->get_number_child_nodes() <= 1) {
+        // nothing to save for a single move
+        update_eval_info(evalInfo, rootNode, tbHits, selDepth, searchSettings);
+        return;
+    }
+    evalInfo.init_vectors_for_multi_pv(searchSettings->multiPV);
+    pvCache.childIndices.resize(searchSettings->multiPV, NONE_IDX);
+    pvCache.refreshVisits.resize(searchSettings->multiPV, 0);
+
+    rootNode->get_most_visited_children(pvCache.candidates, searchSettings->multiPV, pvCache.candidateVisits);
+    if (!pvCache.candidates.empty()) {
+        // the first line must show the move which would be played
+        const ChildIdx bestIdx = get_best_action_index(rootNode, false, searchSettings);
+        if (pvCache.candidates.front() != bestIdx) {
+            size_t pos = 0;
+            while (pos < pvCache.candidates.size() && pvCache.candidates[pos] != bestIdx) {
+                ++pos;
+            }
+            if (pos == pvCache.candidates.size()) {
+                --pos;
+            }
+            pvCache.candidates.erase(pvCache.candidates.begin() + pos);
+            pvCache.candidateVisits.erase(pvCache.candidateVisits.begin() + pos);
+            pvCache.candidates.insert(pvCache.candidates.begin(), bestIdx);
+            pvCache.candidateVisits.insert(pvCache.candidateVisits.begin(), rootNode->get_child_number_visits(bestIdx));
+        }
+    }
+
+    for (size_t idx = 0; idx < pvCache.candidates.size(); ++idx) {
+        const ChildIdx childIdx = pvCache.candidates[idx];
+        const uint32_t visits = pvCache.candidateVisits[idx];
+        const bool walkPV = pvCache.childIndices[idx] != childIdx || evalInfo.pv[idx].empty() ||
+                visits >= pvCache.refreshVisits[idx] * PV_REFRESH_VISITS_FACTOR;
+        set_eval_for_child(evalInfo, rootNode, idx, childIdx, walkPV, searchSettings);
+        if (walkPV) {
+            pvCache.childIndices[idx] = childIdx;
+            pvCache.refreshVisits[idx] = visits;
+        }
+    }
+
+    evalInfo.depth = evalInfo.pv[0].size();
+    evalInfo.selDepth = selDepth;
+    evalInfo.nodes = rootNode->get_node_count();
+    evalInfo.tbHits = tbHits;
+}
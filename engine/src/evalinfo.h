@@ -34,6 +34,7 @@
 
 #include <blaze/Math.h>
 #include "node.h"
+#include "util/movelatency.h"
 
 using blaze::HybridVector;
 using blaze::DynamicVector;
@@ -57,6 +58,8 @@ struct EvalInfo
     Action bestMove;
     std::vector<int> movesToMate;
     size_t tbHits;
+    // time spent in the stages from "position" to "bestmove"
+    MoveLatency latency;
 
     size_t calculate_elapsed_time_ms() const;
     size_t calculate_nps(size_t elapsedTimeMS) const;
@@ -68,6 +71,20 @@ struct EvalInfo
     void init_vectors_for_multi_pv(size_t multiPV);
 };
 
+/**
+ * @brief The PVCache struct Remembers the PV lines of the periodic info output.
+ * A line is only walked again if its first move changed or the visits of its first move have grown by PV_REFRESH_VISITS_FACTOR.
+ */
+struct PVCache
+{
+    // first child index and its visits when the line was walked for each MultiPV line
+    std::vector<ChildIdx> childIndices;
+    std::vector<uint32_t> refreshVisits;
+    // buffers of the current update
+    std::vector<ChildIdx> candidates;
+    std::vector<uint32_t> candidateVisits;
+};
+
 /**
  * @brief value_to_centipawn Converts a value in A0-notation to roughly a centi-pawn loss
  * @param value floating value from [-1.,1.]
@@ -84,6 +101,18 @@ int value_to_centipawn(float value);
  */
 void update_eval_info(EvalInfo& evalInfo, const Node* rootNode, size_t tbHits, size_t selDepth, const SearchSettings* searchSettings);
 
+/**
+ * @brief update_eval_info_lines Updates only the MultiPV lines, scores and counters of the evaluation information for the periodic info output.
+ * The policy, visits, Q-values and legal moves are left unchanged and the root is not locked.
+ * The cost scales with MultiPV and the PV length instead of the number of root moves.
+ * @param evalInfo Evaluation infomration struct
+ * @param rootNode Root node of the search tree
+ * @param selDepth Selective depth, in this case the maximum reached depth
+ * @param searchSettings searchSettings struct
+ * @param pvCache Cached PV lines of the former calls during the same search
+ */
+void update_eval_info_lines(EvalInfo& evalInfo, const Node* rootNode, size_t tbHits, size_t selDepth, const SearchSettings* searchSettings, PVCache& pvCache);
+
 /**
  * @brief get_best_move_q Return the value evaluation for the given next node.
  * If it is a drawn tablebase position, 0.0 is returned.
@@ -103,6 +132,16 @@ float get_best_move_q(const Node* nextNode, const SearchSettings* searchSettings
  */
 void set_eval_for_single_pv(EvalInfo& evalInfo, const Node* rootNode, size_t idx, vector<size_t>& indices, const SearchSettings* searchSettings);
 
+/**
+ * @brief set_eval_for_child Sets the eval struct pv line and score for a single pv which starts with the given child
+ * @param evalInfo struct
+ * @param rootNode root node of the tree
+ * @param idx index of the pv line
+ * @param childIdx child index of the first move
+ * @param walkPV If false, the current pv line of the struct is kept and only the score is updated
+ */
+void set_eval_for_child(EvalInfo& evalInfo, const Node* rootNode, size_t idx, size_t childIdx, bool walkPV, const SearchSettings* searchSettings);
+
 /**
  * @brief operator << Returns all MultiPV as a string sperated by endl
  * @param os stream handle
@@ -0,0 +1,128 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: batchbackup.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "batchbackup.h"
+#include "util/instrumentedmutex.h"
+
+#define NO_ENTRY uint32_t(-1)
+
+BatchBackup::Entry::Entry(Node* node, ChildIdx childIdx, uint32_t depth, uint32_t nextSibling):
+    node(node), childIdx(childIdx), depth(depth), firstChild(NO_ENTRY), nextSibling(nextSibling),
+    firstValue(NO_ENTRY), lastValue(NO_ENTRY), numberValues(0), numberCollisions(0), solveForTerminal(false)
+{
+}
+
+BatchBackup::BatchBackup()
+{
+    clear();
+}
+
+uint32_t BatchBackup::get_entry(uint32_t parent, const NodeAndIdx& nodeAndIdx, uint32_t depth)
+{
+    for (uint32_t idx = entries[parent].firstChild; idx != NO_ENTRY; idx = entries[idx].nextSibling) {
+        if (entries[idx].node == nodeAndIdx.node && entries[idx].childIdx == nodeAndIdx.childIdx) {
+            return idx;
+        }
+    }
+    const uint32_t idx = uint32_t(entries.size());
+    entries.emplace_back(nodeAndIdx.node, nodeAndIdx.childIdx, depth, entries[parent].firstChild);
+    entries[parent].firstChild = idx;
+    return idx;
+}
+
+void BatchBackup::add_value(float value, TrajectoryView trajectory, bool solveForTerminal, const SearchSettings* searchSettings)
+{
+    // backup_value() flips the value before updating each node, starting at the last node of the trajectory
+    if (searchSettings->searchPlayerMode == MODE_TWO_PLAYER && trajectory.size() % 2 == 1) {
+        value = -value;
+    }
+    uint32_t parent = 0;
+    for (size_t depth = 0; depth < trajectory.size(); ++depth) {
+        const uint32_t idx = get_entry(parent, trajectory[depth], uint32_t(depth));
+        Entry& entry = entries[idx];
+        const uint32_t link = uint32_t(valueLinks.size());
+        valueLinks.push_back({value, NO_ENTRY});
+        if (entry.lastValue == NO_ENTRY) {
+            entry.firstValue = link;
+        }
+        else {
+            valueLinks[entry.lastValue].next = link;
+        }
+        entry.lastValue = link;
+        ++entry.numberValues;
+        entry.solveForTerminal = entry.solveForTerminal || solveForTerminal;
+        if (searchSettings->searchPlayerMode == MODE_TWO_PLAYER) {
+            value = -value;
+        }
+        parent = idx;
+    }
+}
+
+void BatchBackup::add_collision(TrajectoryView trajectory)
+{
+    uint32_t parent = 0;
+    for (size_t depth = 0; depth < trajectory.size(); ++depth) {
+        parent = get_entry(parent, trajectory[depth], uint32_t(depth));
+        ++entries[parent].numberCollisions;
+    }
+}
+
+void BatchBackup::apply(const SearchSettings* searchSettings)
+{
+    // every entry is created after its parent, so the reverse order updates the child nodes first like backup_value()
+    for (size_t idx = entries.size() - 1; idx > 0; --idx) {
+        const Entry& entry = entries[idx];
+        LOCK_DEPTH(entry.depth);
+        if (entry.numberValues != 0) {
+            valueBuffer.clear();
+            for (uint32_t link = entry.firstValue; link != NO_ENTRY; link = valueLinks[link].next) {
+                valueBuffer.push_back(valueLinks[link].value);
+            }
+            entry.node->revert_virtual_loss_and_update<false>(entry.childIdx, valueBuffer.data(), valueBuffer.size(), searchSettings, entry.solveForTerminal);
+        }
+        if (entry.numberCollisions != 0) {
+            entry.node->revert_virtual_loss(entry.childIdx, searchSettings, entry.numberCollisions);
+        }
+    }
+    clear();
+}
+
+void BatchBackup::clear()
+{
+    entries.clear();
+    entries.emplace_back(nullptr, 0, 0, NO_ENTRY);
+    valueLinks.clear();
+}
+
+bool contains_transposition(TrajectoryView trajectory)
+{
+    for (const NodeAndIdx& nodeAndIdx : trajectory) {
+        if (nodeAndIdx.node->is_transposition()) {
+            return true;
+        }
+    }
+    return false;
+}
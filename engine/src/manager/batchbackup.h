@@ -0,0 +1,103 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: batchbackup.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Backup of all simulations of a mini-batch at once.
+ * The trajectories are merged into a prefix tree with one entry per (node, child index), so the root and the upper nodes
+ * which are shared by many simulations are only locked once per mini-batch instead of once per simulation.
+ */
+
+#ifndef BATCHBACKUP_H
+#define BATCHBACKUP_H
+
+#include <vector>
+#include "node.h"
+
+/**
+ * @brief The BatchBackup class collects the values and collisions of a mini-batch and applies them per node
+ */
+class BatchBackup
+{
+private:
+    struct Entry {
+        Node* node;
+        ChildIdx childIdx;
+        uint32_t depth;
+        // child entries form a linked list of siblings
+        uint32_t firstChild;
+        uint32_t nextSibling;
+        // values form a linked list in valueLinks
+        uint32_t firstValue;
+        uint32_t lastValue;
+        uint32_t numberValues;
+        uint32_t numberCollisions;
+        bool solveForTerminal;
+        Entry(Node* node, ChildIdx childIdx, uint32_t depth, uint32_t nextSibling);
+    };
+    struct ValueLink {
+        float value;
+        uint32_t next;
+    };
+    // entries[0] is a placeholder for the parent of the root node
+    std::vector<Entry> entries;
+    std::vector<ValueLink> valueLinks;
+    std::vector<float> valueBuffer;
+
+    /**
+     * @brief get_entry Returns the index of the child entry of the given parent entry and creates it if needed
+     */
+    uint32_t get_entry(uint32_t parent, const NodeAndIdx& nodeAndIdx, uint32_t depth);
+
+public:
+    BatchBackup();
+
+    /**
+     * @brief add_value Adds the value of a new node for all nodes of its trajectory, the value is flipped at every ply in two player mode
+     * @param value Value evaluation of the last node of the trajectory
+     * @param trajectory Trajectory from the root node
+     * @param solveForTerminal Decides if the terminal solver will be used
+     * @param searchSettings Pointer to the search settings struct
+     */
+    void add_value(float value, TrajectoryView trajectory, bool solveForTerminal, const SearchSettings* searchSettings);
+
+    /**
+     * @brief add_collision Adds a collision whose virtual losses will be reverted for all nodes of its trajectory
+     */
+    void add_collision(TrajectoryView trajectory);
+
+    /**
+     * @brief apply Updates all nodes from the deepest entries up to the root with a single lock per entry and clears the batch
+     */
+    void apply(const SearchSettings* searchSettings);
+
+    void clear();
+};
+
+/**
+ * @brief contains_transposition Returns true if a node of the trajectory is a transposition node.
+ * The backup of such trajectories depends on the updated values of the former nodes and can't be merged.
+ */
+bool contains_transposition(TrajectoryView trajectory);
+
+#endif // BATCHBACKUP_H
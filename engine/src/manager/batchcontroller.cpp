@@ -0,0 +1,90 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: batchcontroller.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "batchcontroller.h"
+#include <algorithm>
+
+using namespace std;
+
+BatchController::BatchController(size_t minTarget, size_t maxTarget):
+    minTarget(min(max(minTarget, size_t(1)), maxTarget)),
+    maxTarget(maxTarget)
+{
+    reset();
+}
+
+void BatchController::update(size_t newNodes, size_t collisions, float batchLatencyMS)
+{
+    if (minTarget == maxTarget) {
+        return;
+    }
+    ++numberBatches;
+    numberNewNodes += newNodes;
+    numberCollisions += collisions;
+    latencyMS += batchLatencyMS;
+    if (numberBatches < BATCH_CONTROLLER_WINDOW) {
+        return;
+    }
+
+    const float collisionRatio = float(numberCollisions) / max(numberNewNodes + numberCollisions, size_t(1));
+    const double throughput = latencyMS > 0 ? numberNewNodes / latencyMS : 0;
+    int step = 0;
+    if (collisionRatio > BATCH_CONTROLLER_HIGH_COLLISIONS) {
+        step = -1;
+    }
+    else if (collisionRatio < BATCH_CONTROLLER_LOW_COLLISIONS) {
+        // keep growing while larger batches improve the throughput of the backend, otherwise go back
+        step = (lastStep > 0 && throughput < lastThroughput) ? -1 : 1;
+    }
+    if (step > 0) {
+        fillTarget = min(fillTarget + max(fillTarget / 4, size_t(1)), maxTarget);
+    }
+    else if (step < 0) {
+        fillTarget = max(fillTarget - max(fillTarget / 4, size_t(1)), minTarget);
+    }
+    lastStep = step;
+    lastThroughput = throughput;
+    numberBatches = 0;
+    numberNewNodes = 0;
+    numberCollisions = 0;
+    latencyMS = 0;
+}
+
+void BatchController::reset()
+{
+    fillTarget = maxTarget;
+    numberBatches = 0;
+    numberNewNodes = 0;
+    numberCollisions = 0;
+    latencyMS = 0;
+    lastThroughput = 0;
+    lastStep = 0;
+}
+
+size_t BatchController::get_fill_target() const
+{
+    return fillTarget;
+}
@@ -0,0 +1,85 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: batchcontroller.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Online controller for the number of new nodes which a search thread collects for a mini-batch.
+ * Narrow trees produce many collisions when the full batch is filled, so the fill target is reduced.
+ * Wide trees have few collisions and the target is increased as long as the throughput of the backend improves.
+ */
+
+#ifndef BATCHCONTROLLER_H
+#define BATCHCONTROLLER_H
+
+#include <cstddef>
+
+// number of mini-batches after which the fill target is adjusted
+#define BATCH_CONTROLLER_WINDOW 16
+// collision ratio above which the fill target is decreased
+#define BATCH_CONTROLLER_HIGH_COLLISIONS 0.2f
+// collision ratio below which the fill target may be increased
+#define BATCH_CONTROLLER_LOW_COLLISIONS 0.05f
+
+/**
+ * @brief The BatchController class adjusts the fill target of a single search thread within [minTarget, maxTarget]
+ */
+class BatchController
+{
+private:
+    size_t minTarget;
+    size_t maxTarget;
+    size_t fillTarget;
+    // statistics of the current window
+    size_t numberBatches;
+    size_t numberNewNodes;
+    size_t numberCollisions;
+    double latencyMS;
+    // throughput of the previous window in new nodes per ms and the direction of the last adjustment
+    double lastThroughput;
+    int lastStep;
+
+public:
+    /**
+     * @brief BatchController
+     * @param minTarget Minimum number of new nodes per mini-batch, the controller is disabled if it is equal to maxTarget
+     * @param maxTarget Maximum number of new nodes per mini-batch (the batch size of the network)
+     */
+    BatchController(size_t minTarget, size_t maxTarget);
+
+    /**
+     * @brief update Adds the statistics of a finished mini-batch and adjusts the fill target at the end of each window
+     * @param newNodes Number of new nodes which have been evaluated by the network
+     * @param collisions Number of collisions which occurred while filling the mini-batch
+     * @param batchLatencyMS Latency of the neural network for the mini-batch
+     */
+    void update(size_t newNodes, size_t collisions, float batchLatencyMS);
+
+    /**
+     * @brief reset Restarts the controller with the maximum fill target, should be called before each search
+     */
+    void reset();
+
+    size_t get_fill_target() const;
+};
+
+#endif // BATCHCONTROLLER_H
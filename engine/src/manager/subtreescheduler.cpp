@@ -0,0 +1,172 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: subtreescheduler.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "subtreescheduler.h"
+#include <algorithm>
+#include <climits>
+
+SubtreeScheduler::SubtreeScheduler(const SearchSettings* searchSettings, size_t numberThreads):
+    queues(numberThreads),
+    searchSettings(searchSettings),
+    rootNode(nullptr)
+{
+}
+
+void SubtreeScheduler::set_root_node(Node* value)
+{
+    lock_guard<mutex> lock(refillMtx);
+    rootNode = value;
+}
+
+bool SubtreeScheduler::pop_own_item(size_t threadIdx, NodeAndBudget& item)
+{
+    WorkQueue& queue = queues[threadIdx];
+    lock_guard<mutex> lock(queue.mtx);
+    if (queue.items.empty()) {
+        return false;
+    }
+    item = std::move(queue.items.front());
+    queue.items.pop_front();
+    return true;
+}
+
+bool SubtreeScheduler::steal_item(size_t threadIdx, NodeAndBudget& item)
+{
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkQueue& queue = queues[(threadIdx + offset) % queues.size()];
+        lock_guard<mutex> lock(queue.mtx);
+        if (!queue.items.empty()) {
+            item = std::move(queue.items.back());
+            queue.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SubtreeScheduler::get_work_item(size_t threadIdx, NodeAndBudget& item)
+{
+    if (pop_own_item(threadIdx, item) || steal_item(threadIdx, item)) {
+        return true;
+    }
+    lock_guard<mutex> lock(refillMtx);
+    // another thread may have refilled the queues in the meantime
+    if (pop_own_item(threadIdx, item) || steal_item(threadIdx, item)) {
+        return true;
+    }
+    if (rootNode == nullptr) {
+        return false;
+    }
+    refill();
+    return pop_own_item(threadIdx, item) || steal_item(threadIdx, item);
+}
+
+bool SubtreeScheduler::can_split(const Node* childNode) const
+{
+    return childNode != nullptr && childNode->is_playout_node() && childNode->has_nn_results() &&
+            !childNode->is_terminal() && childNode->get_node_type() == UNSOLVED;
+}
+
+void SubtreeScheduler::split_item(const NodeAndBudget& item, vector<NodeAndBudget>& stack, vector<NodeAndBudget>& leaves)
+{
+    Node* node = item.node;
+    node->lock();
+    if (!can_split(node)) {
+        node->unlock();
+        leaves.emplace_back(item);
+        return;
+    }
+    const NodeSplit nodeSplit = node->select_child_nodes(searchSettings, item.budget);
+    const ChildIdx childIndices[2] = {nodeSplit.firstArg, nodeSplit.secondArg};
+    const Budget budgets[2] = {nodeSplit.firstBudget, nodeSplit.secondBudget};
+    // the budget of children which can't be claimed remains at the node itself
+    Budget remainingBudget = 0;
+    for (size_t idx = 0; idx < 2; ++idx) {
+        if (budgets[idx] == 0) {
+            continue;
+        }
+        if (!can_split(node->get_child_node(childIndices[idx]))) {
+            remainingBudget += budgets[idx];
+            continue;
+        }
+        for (Budget visit = 0; visit < budgets[idx]; ++visit) {
+            node->apply_virtual_loss_to_child(childIndices[idx], searchSettings);
+        }
+        NodeAndBudget childItem(node->get_child_node(childIndices[idx]), budgets[idx], nullptr);
+        childItem.curTrajectory = item.curTrajectory;
+        childItem.curTrajectory.emplace_back(NodeAndIdx(node, childIndices[idx]));
+        stack.emplace_back(std::move(childItem));
+    }
+    node->unlock();
+    if (remainingBudget != 0) {
+        NodeAndBudget nodeItem(node, remainingBudget, nullptr);
+        nodeItem.curTrajectory = item.curTrajectory;
+        leaves.emplace_back(std::move(nodeItem));
+    }
+}
+
+void SubtreeScheduler::refill()
+{
+    vector<NodeAndBudget> stack;
+    vector<NodeAndBudget> leaves;
+    const size_t totalBudget = min(searchSettings->threads * searchSettings->batchSize, size_t(USHRT_MAX));
+    stack.emplace_back(rootNode, Budget(totalBudget), nullptr);
+
+    while (!stack.empty()) {
+        NodeAndBudget item = std::move(stack.back());
+        stack.pop_back();
+        if (item.curTrajectory.size() >= searchSettings->subtreeSplitDepth || item.budget < 2) {
+            leaves.emplace_back(std::move(item));
+        }
+        else {
+            split_item(item, stack, leaves);
+        }
+    }
+
+    for (size_t idx = 0; idx < leaves.size(); ++idx) {
+        WorkQueue& queue = queues[idx % queues.size()];
+        lock_guard<mutex> lock(queue.mtx);
+        queue.items.emplace_back(std::move(leaves[idx]));
+    }
+}
+
+void SubtreeScheduler::release_items()
+{
+    for (WorkQueue& queue : queues) {
+        lock_guard<mutex> lock(queue.mtx);
+        for (NodeAndBudget& item : queue.items) {
+            release_work_item(searchSettings, item);
+        }
+        queue.items.clear();
+    }
+}
+
+void release_work_item(const SearchSettings* searchSettings, NodeAndBudget& item)
+{
+    for (; item.budget != 0; --item.budget) {
+        backup_collision(searchSettings, item.curTrajectory);
+    }
+}
@@ -0,0 +1,124 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: subtreescheduler.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Distributes the rollouts of all search threads as budget based work items over the upper part of the search tree.
+ * A work item claims a subtree for a number of rollouts and the thread which runs it starts its rollouts at the
+ * root of the subtree. This avoids that all threads lock the root node and the first ply nodes for every rollout.
+ */
+
+#ifndef SUBTREESCHEDULER_H
+#define SUBTREESCHEDULER_H
+
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "../node.h"
+
+using namespace std;
+
+/**
+ * @brief The WorkQueue struct holds the work items of a single search thread. Other threads steal from its back.
+ */
+struct WorkQueue
+{
+    mutex mtx;
+    deque<NodeAndBudget> items;
+};
+
+class SubtreeScheduler
+{
+private:
+    vector<WorkQueue> queues;
+    mutex refillMtx;
+    const SearchSettings* searchSettings;
+    Node* rootNode;
+
+    /**
+     * @brief pop_own_item Returns the next item from the front of the own queue
+     */
+    bool pop_own_item(size_t threadIdx, NodeAndBudget& item);
+
+    /**
+     * @brief steal_item Returns an item from the back of the queue of another thread
+     */
+    bool steal_item(size_t threadIdx, NodeAndBudget& item);
+
+    /**
+     * @brief refill Splits a budget of searchSettings->threads * searchSettings->batchSize rollouts from the root node down to
+     * searchSettings->subtreeSplitDepth plies using Node::select_child_nodes() and distributes the resulting items over all queues.
+     * The virtual loss for the complete budget of an item is applied on the path to its subtree when the item is created.
+     */
+    void refill();
+
+    /**
+     * @brief split_item Splits the budget of the given item between its two most promising children
+     * @param item Item which is split
+     * @param stack Items which can be split further
+     * @param leaves Items which won't be split further
+     */
+    void split_item(const NodeAndBudget& item, vector<NodeAndBudget>& stack, vector<NodeAndBudget>& leaves);
+
+    /**
+     * @brief can_split Returns true if the search can start from the given child node instead of its parent
+     */
+    bool can_split(const Node* childNode) const;
+public:
+    /**
+     * @brief SubtreeScheduler
+     * @param searchSettings Search settings
+     * @param numberThreads Number of search threads and queues
+     */
+    SubtreeScheduler(const SearchSettings* searchSettings, size_t numberThreads);
+    SubtreeScheduler(const SubtreeScheduler&) = delete;
+
+    /**
+     * @brief set_root_node Releases all former items and sets the root node for the next search
+     * @param value Root node
+     */
+    void set_root_node(Node* value);
+
+    /**
+     * @brief get_work_item Returns the next work item for the given thread. Items of other threads are stolen if the own queue is empty
+     * and a new set of items is created if all queues are empty.
+     * @param threadIdx Index of the calling search thread
+     * @param item Output item
+     * @return False if no item could be created (e.g. the root node is a terminal node)
+     */
+    bool get_work_item(size_t threadIdx, NodeAndBudget& item);
+
+    /**
+     * @brief release_items Reverts the virtual loss of all unused items of all queues. Must be called after all search threads have stopped.
+     */
+    void release_items();
+};
+
+/**
+ * @brief release_work_item Reverts the virtual loss of the remaining budget of an item on the path to its subtree
+ * @param searchSettings Search settings
+ * @param item Work item, its budget is set to 0
+ */
+void release_work_item(const SearchSettings* searchSettings, NodeAndBudget& item);
+
+#endif // SUBTREESCHEDULER_H
@@ -25,38 +25,102 @@
 
 #include "threadmanager.h"
 #include "../util/blazeutil.h"
+#include "treemanager.h"
 #include <chrono>
+#include "../util/tracerecorder.h"
 
 ThreadManager::ThreadManager(ThreadManagerData* tData, ThreadManagerInfo* tInfo, ThreadManagerParams* tParams):
     tData(tData),
     tInfo(tInfo),
     tParams(tParams),
     checkedContinueSearch(0),
-    isRunning(true)
+    isRunning(true),
+    isPondering(tParams->ponder),
+    lastKLCheckNodes(tData->rootNode->get_node_count()),
+    stability(tInfo->searchSettings->stabilityTimeMin, tInfo->searchSettings->stabilityTimeMax)
 {
 }
 
 void ThreadManager::print_info()
 {
     tData->evalInfo->end = chrono::steady_clock::now();
-    update_eval_info(*tData->evalInfo, tData->rootNode, get_tb_hits(tData->searchThreads), get_max_depth(tData->searchThreads), tInfo->searchSettings);
+    update_eval_info_lines(*tData->evalInfo, tData->rootNode, get_tb_hits(tData->searchThreads), get_max_depth(tData->searchThreads), tInfo->searchSettings, pvCache);
     info_msg(*tData->evalInfo);
 }
 
+void ThreadManager::check_memory_budget()
+{
+    const size_t memoryBudget = tInfo->searchSettings->memoryBudget;
+    if (memoryBudget == 0) {
+        return;
+    }
+    const size_t memoryUsage = get_node_memory_usage();
+    if (memoryUsage > memoryBudget) {
+        const size_t numberPrunedNodes = prune_tree(tData->rootNode, memoryUsage - size_t(memoryBudget * MEMORY_BUDGET_PRUNE_RATIO),
+                                                    tData->mapWithMutex, tInfo->searchSettings);
+        info_string("memory budget exceeded, pruned subtrees:", numberPrunedNodes);
+    }
+}
+
 void ThreadManager::await_kill_signal()
 {
+    // the KL-divergence stopping rule is checked whenever a search thread has finished a batch
+    const bool waitForEvents = tInfo->searchSettings->klStoppingInterval != 0;
+    const chrono::milliseconds updateInterval(tParams->updateIntervalMS*4);
+    chrono::steady_clock::time_point nextUpdate = chrono::steady_clock::now() + updateInterval;
+    size_t seenEvents = 0;
     while(isRunning && tData->searchThreads.front()->is_running()) {
-        if (wait_for(chrono::milliseconds(tParams->updateIntervalMS*4))){
+        if (!(waitForEvents ? wait_for_event(nextUpdate, seenEvents) : wait_for(nextUpdate - chrono::steady_clock::now()))) {
+            return;
+        }
+        if (chrono::steady_clock::now() >= nextUpdate) {
+            check_memory_budget();
             print_info();
+            nextUpdate += updateInterval;
+        }
+        if (kl_stopping()) {
+            stop_search();
+            return;
         }
-        else {
+    }
+}
+
+void ThreadManager::await_ponderhit()
+{
+    unique_lock<EventMutex> lock(mtx);
+    while (isPondering && isRunning && tData->searchThreads.front()->is_running()) {
+        if (cv.wait_for(lock, chrono::milliseconds(tParams->updateIntervalMS*4), [&]{return terminate || !isPondering;})) {
             return;
         }
+        lock.unlock();
+        check_memory_budget();
+        print_info();
+        lock.lock();
     }
 }
 
+void ThreadManager::ponderhit()
+{
+    unique_lock<EventMutex> lock(mtx);
+    isPondering = false;
+    cv.notify_all();
+}
+
+bool ThreadManager::is_pondering() const
+{
+    unique_lock<EventMutex> lock(mtx);
+    return isPondering;
+}
+
 void run_thread_manager(ThreadManager* t)
 {
+    trace_recorder().set_thread_name("ThreadManager");
+    t->await_ponderhit();
+    if (t->is_pondering()) {
+        // the search was stopped before a ponderhit
+        t->stop_search();
+        return;
+    }
     if (t->get_movetime_ms() == 0) {
         t->await_kill_signal();
     }
@@ -68,27 +132,57 @@ void run_thread_manager(ThreadManager* t)
 
 void ThreadManager::stop_search_based_on_limits()
 {
-    do {
-        tData->remainingMoveTimeMS = tParams->moveTimeMS;
-        for (int var = 0; var < tParams->moveTimeMS / tParams->updateIntervalMS && isRunning; ++var) {
-            if (wait_for(chrono::milliseconds(tParams->updateIntervalMS))){
-                tData->remainingMoveTimeMS -= tParams->updateIntervalMS;
-                if (checkedContinueSearch == 0 && early_stopping() && !continue_search()) {
-                    stop_search();
-                }
-                // log every fourth iteration
-                if (var % 4 == 3) {
-                    print_info();
-                }
+    // the timers are only used for the wall clock deadline and logging,
+    // the stop conditions are checked whenever a search thread has finished a batch
+    const chrono::milliseconds updateInterval(tParams->updateIntervalMS);
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    const chrono::steady_clock::time_point start = now;
+    chrono::steady_clock::time_point deadline = now + chrono::milliseconds(tParams->moveTimeMS);
+    const bool useStability = tParams->inGame && tInfo->searchSettings->useStabilityTimeManager;
+    chrono::steady_clock::time_point nextUpdate = now + updateInterval;
+    // batches which are started within the last batch latency before the deadline wouldn't finish in time
+    const chrono::microseconds batchReserve(int64_t(min(tParams->batchLatencyMS, tParams->moveTimeMS * 0.5f) * 1000));
+    size_t numberUpdates = 0;
+    size_t seenEvents = 0;
+    tData->remainingMoveTimeMS = tParams->moveTimeMS;
+    while (isRunning) {
+        if (!wait_for_event(min(deadline - batchReserve, nextUpdate), seenEvents)) {
+            return;
+        }
+        now = chrono::steady_clock::now();
+        tData->remainingMoveTimeMS = int(max(chrono::duration_cast<chrono::milliseconds>(deadline - now).count(), int64_t(0)));
+        if (now >= nextUpdate) {
+            TRACE_SCOPE("thread_manager_check");
+            check_memory_budget();
+            // log every fourth update
+            if (++numberUpdates % 4 == 0) {
+                print_info();
+            }
+            if (useStability) {
+                deadline = start + chrono::milliseconds(get_stability_move_time());
+            }
+            nextUpdate += updateInterval;
+        }
+        if (checkedContinueSearch == 0 && early_stopping() && !continue_search()) {
+            stop_search();
+            return;
+        }
+        if (kl_stopping()) {
+            tData->savedTimeMS = tData->remainingMoveTimeMS;
+            stop_search();
+            return;
+        }
+        if (now + batchReserve >= deadline) {
+            if (useStability) {
+                // the stability time manager replaces the prolongation, time which a stable search didn't use is carried over
+                tData->savedTimeMS = max(tParams->moveTimeMS - int(chrono::duration_cast<chrono::milliseconds>(now - start).count()), 0);
+                return;
             }
-            else {
+            if (!continue_search()) {
                 return;
             }
+            deadline += chrono::milliseconds(tParams->moveTimeMS);
         }
-    } while(continue_search());
-
-    if (!wait_for(chrono::milliseconds(tParams->moveTimeMS % tParams->updateIntervalMS))){
-        return;
     }
 }
 
@@ -144,6 +238,58 @@ bool ThreadManager::early_stopping()
     return false;
 }
 
+int ThreadManager::get_stability_move_time()
+{
+    const Node* rootNode = tData->rootNode;
+    const ChildIdx numberChildren = ChildIdx(rootNode->get_no_visit_idx());
+    if (numberChildren == 0) {
+        return tParams->moveTimeMS;
+    }
+    uint32_t firstMax;
+    uint32_t secondMax;
+    ChildIdx firstArg;
+    ChildIdx secondArg;
+    first_and_second_max(rootNode->get_child_number_visits(), numberChildren, firstMax, secondMax, firstArg, secondArg);
+    // a single explored move is treated as a decisive margin
+    const float qMargin = numberChildren > 1 ? rootNode->get_q_value(firstArg) - rootNode->get_q_value(secondArg) : 1.0f;
+    stability.update(firstArg, qMargin, rootNode->updated_value_eval());
+    const float timeFactor = stability.get_time_factor();
+    int moveTimeMS = int(tParams->moveTimeMS * timeFactor);
+    if (timeFactor > 1) {
+        // make sure not to flag when spending more time
+        const int maxMoveTimeMS = tInfo->searchLimits->get_safe_remaining_time(tInfo->sideToMove) / 2;
+        moveTimeMS = max(tParams->moveTimeMS, min(moveTimeMS, maxMoveTimeMS));
+    }
+    return moveTimeMS;
+}
+
+bool ThreadManager::kl_stopping()
+{
+    const SearchSettings* searchSettings = tInfo->searchSettings;
+    if (searchSettings->klStoppingInterval == 0 || tInfo->searchLimits->infinite) {
+        return false;
+    }
+    const uint32_t nodeCount = tData->rootNode->get_node_count();
+    if (nodeCount < lastKLCheckNodes + searchSettings->klStoppingInterval) {
+        return false;
+    }
+    DynamicVector<uint32_t> childVisits = tData->rootNode->get_child_number_visits();
+    // the first check only records the reference distribution
+    const double gain = kl_divergence(childVisits, lastChildVisits) / (nodeCount - lastKLCheckNodes);
+    lastChildVisits = std::move(childVisits);
+    lastKLCheckNodes = nodeCount;
+    if (gain >= searchSettings->klStoppingGain) {
+        return false;
+    }
+    if (tParams->moveTimeMS != 0) {
+        info_string("KL stopping, saved time:", tData->remainingMoveTimeMS);
+    }
+    else {
+        const size_t nodesLimit = max(tInfo->searchLimits->nodes, tInfo->searchLimits->simulations);
+        info_string("KL stopping, saved nodes:", nodesLimit > nodeCount ? nodesLimit - nodeCount : 0);
+    }
+    return true;
+}
 
 bool ThreadManager::continue_search() {
     if (!tParams->inGame || !tParams->canProlong || tInfo->overallNPS == 0 || checkedContinueSearch > 1 || !tData->searchThreads.front()->is_running()) {
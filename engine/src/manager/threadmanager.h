@@ -34,19 +34,23 @@
 #include "../searchthread.h"
 #include "../evalinfo.h"
 #include "../util/killablethread.h"
+#include "timemanager.h"
 
 using namespace std;
 
 
 struct ThreadManagerData {
-    const Node* rootNode;
+    Node* rootNode;
     vector<SearchThread*> searchThreads;
     EvalInfo* evalInfo;
     int remainingMoveTimeMS;
+    // move time which wasn't used because the root visit distribution had converged
+    int savedTimeMS;
     float lastValueEval;
+    MapWithMutex* mapWithMutex;
 
-    ThreadManagerData(const Node* rootNode, vector<SearchThread*> searchThreads, EvalInfo* evalInfo, float lastValueEval) :
-        rootNode(rootNode), searchThreads(searchThreads), evalInfo(evalInfo), remainingMoveTimeMS(0), lastValueEval(lastValueEval)
+    ThreadManagerData(Node* rootNode, vector<SearchThread*> searchThreads, EvalInfo* evalInfo, float lastValueEval, MapWithMutex* mapWithMutex) :
+        rootNode(rootNode), searchThreads(searchThreads), evalInfo(evalInfo), remainingMoveTimeMS(0), savedTimeMS(0), lastValueEval(lastValueEval), mapWithMutex(mapWithMutex)
     {}
 };
 
@@ -66,9 +70,15 @@ struct ThreadManagerParams {
     const int updateIntervalMS;
     const bool inGame;
     const bool canProlong;
-
-    ThreadManagerParams(const int moveTimeMS, const int updateIntervalMS, const bool inGame, const bool canProlong) :
-        moveTimeMS(moveTimeMS), updateIntervalMS(updateIntervalMS), inGame(inGame), canProlong(canProlong)
+    // the search was started by "go ponder" and the move time only starts after "ponderhit"
+    const bool ponder;
+    // measured latency of a neural network batch, no new batch is started if it can't finish before the move time ends
+    const float batchLatencyMS;
+
+    ThreadManagerParams(const int moveTimeMS, const int updateIntervalMS, const bool inGame, const bool canProlong, const bool ponder=false,
+                        const float batchLatencyMS=0) :
+        moveTimeMS(moveTimeMS), updateIntervalMS(updateIntervalMS), inGame(inGame), canProlong(canProlong), ponder(ponder),
+        batchLatencyMS(batchLatencyMS)
     {}
 };
 
@@ -84,29 +94,57 @@ private:
     ThreadManagerParams* tParams;
     int checkedContinueSearch = 0;
     bool isRunning;
+    // protected by the mutex of the KillableThread
+    bool isPondering;
+    // PV lines of the periodic info output
+    PVCache pvCache;
+    // root visits and node count at the last check of the KL-divergence stopping rule
+    DynamicVector<uint32_t> lastChildVisits;
+    uint32_t lastKLCheckNodes;
+    // stability of the best move and the evaluation which scales the move time (see SearchSettings::useStabilityTimeManager)
+    SearchStability stability;
     /**
      * @brief check_early_stopping Checks if the search can be ended prematurely based on the current tree statistics (visits & Q-values)
      * @return True, if early stopping is recommended
      */
     inline bool early_stopping();
 
+    /**
+     * @brief kl_stopping Compares the root visit distribution to the one of the last check every klStoppingInterval nodes
+     * @return True, if the KL-divergence gain per node fell below klStoppingGain and the policy is considered to have converged
+     */
+    inline bool kl_stopping();
+
     /**
      * @brief continue_search Checks if the search should which is based on the initial value prediciton
      * @return True, if search extension is recommend
      */
     inline bool continue_search();
 
+    /**
+     * @brief get_stability_move_time Samples the root statistics and returns the move time which is scaled by the stability of the search.
+     * A longer move time is limited to half of the safe remaining time.
+     * @return Move time in ms
+     */
+    int get_stability_move_time();
+
     /**
      * @brief print_info Updates and prints the uci eval info to stdout
      */
     void print_info();
 
+    /**
+     * @brief check_memory_budget Prunes low visit subtrees if the nodes exceed the memory budget of the search settings
+     */
+    void check_memory_budget();
+
 public:
     ThreadManager(ThreadManagerData* tData, ThreadManagerInfo* tInfo, ThreadManagerParams* tParams);
 
     /**
     * @brief stop_search_based_on_limits Checks for the search limit condition and possible early break-ups
-    * and stops all running search threads accordingly
+    * and stops all running search threads accordingly.
+    * Early stopping is checked after every batch of the search threads, timers are only used for the move time and logging.
     * @param evalInfo Evaluation struct which updated during search
     */
     void stop_search_based_on_limits();
@@ -126,6 +164,23 @@ public:
      */
     void await_kill_signal();
 
+    /**
+     * @brief await_ponderhit Locks the thread as long as the search is pondering on the opponent's time.
+     * Returns after a ponderhit() or kill() call or when the search threads have been stopped.
+     */
+    void await_ponderhit();
+
+    /**
+     * @brief ponderhit Informs the thread manager that the opponent played the expected move. The move time starts from now on.
+     */
+    void ponderhit();
+
+    /**
+     * @brief is_pondering Returns true if the search is still pondering on the opponent's time
+     * @return bool
+     */
+    bool is_pondering() const;
+
     size_t get_movetime_ms() const;
     bool isInGame() const;
 };
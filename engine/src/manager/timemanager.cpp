@@ -37,7 +37,11 @@ TimeManager::TimeManager(float randomMoveFactor, int expectedGameLength, int thr
     expectedGameLength(expectedGameLength),
     threshMove(threshMove),
     timePropMovesToGo(timePropMovesToGo),
-    incrementFactor(incrementFactor)
+    incrementFactor(incrementFactor),
+    batchLatencyMS(0),
+    moveDelayMS(0),
+    gcPauseMS(0),
+    savedTimeMS(0)
 {
     auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
     srand(unsigned(int(seed)));
@@ -51,10 +55,12 @@ inline int get_constant_movetime(const SearchLimits* searchLimits, SideToMove me
 int TimeManager::get_time_for_move(const SearchLimits* searchLimits, SideToMove me, int moveNumber)
 {
     if (searchLimits->infinite) {
+        curMovetime = 0;
         return 0;
     }
     if (searchLimits->nodes != 0 || searchLimits->simulations != 0 || searchLimits->depth != 0) {
         if (searchLimits->movetime == 0) {
+            curMovetime = 0;
             return 0;
         }
     }
@@ -81,22 +87,68 @@ int TimeManager::get_time_for_move(const SearchLimits* searchLimits, SideToMove
         info_string("No limit specification given, setting movetime[ms] to", curMovetime);
     }
 
-    // substract the move overhead
-    curMovetime -= searchLimits->moveOverhead;
+    if (searchLimits->movetime == 0 && searchLimits->time[me] != 0) {
+        // the time which was saved on former moves is only spent when the engine manages its own clock
+        curMovetime += savedTimeMS;
+        savedTimeMS = 0;
+    }
+
+    // substract the move overhead and the measured delays of the engine
+    curMovetime -= searchLimits->moveOverhead + get_latency_reserve_ms();
 
     if (curMovetime <= 0) {
-        curMovetime = searchLimits->moveOverhead * 2;
+        curMovetime = std::max(searchLimits->moveOverhead * 2, int(batchLatencyMS));
     }
 
     curMovetime = apply_random_factor(curMovetime);
 
     if (searchLimits->time[me] != 0) {
         // make sure the returned movetime is within bounds
-        return std::min(searchLimits->get_safe_remaining_time(me), curMovetime);
+        curMovetime = std::min(searchLimits->get_safe_remaining_time(me), curMovetime);
     }
     return curMovetime;
 }
 
+/**
+ * @brief update_average Updates an exponential moving average, the first measurement is taken directly
+ */
+inline void update_average(float& average, float value)
+{
+    average = average == 0 ? value : average + TIME_LATENCY_SMOOTHING * (value - average);
+}
+
+void TimeManager::update_latency_statistics(int elapsedMS, float batchLatencyMS, float gcPauseMS)
+{
+    if (batchLatencyMS > 0) {
+        update_average(this->batchLatencyMS, batchLatencyMS);
+    }
+    update_average(this->gcPauseMS, gcPauseMS);
+    if (curMovetime != 0) {
+        // only searches with a time limit can be compared to their planned move time
+        update_average(moveDelayMS, std::max(elapsedMS - curMovetime, 0));
+    }
+}
+
+void TimeManager::add_saved_time(int savedTimeMS)
+{
+    this->savedTimeMS += savedTimeMS;
+}
+
+void TimeManager::clear_saved_time()
+{
+    savedTimeMS = 0;
+}
+
+float TimeManager::get_batch_latency_ms() const
+{
+    return batchLatencyMS;
+}
+
+int TimeManager::get_latency_reserve_ms() const
+{
+    return int(std::max(moveDelayMS, gcPauseMS));
+}
+
 int TimeManager::get_thresh_move() const
 {
     return threshMove;
@@ -114,3 +166,54 @@ float TimeManager::get_current_random_factor()
 {
     return (double(rand()) / RAND_MAX) * randomMoveFactor * 2 - randomMoveFactor;
 }
+
+SearchStability::SearchStability(float minFactor, float maxFactor):
+    minFactor(minFactor),
+    maxFactor(maxFactor),
+    bestMoveIdx(0),
+    stableSamples(0),
+    bestMoveChanges(0),
+    qMargin(0),
+    firstValueEval(0),
+    valueEval(0),
+    hasSamples(false)
+{
+}
+
+void SearchStability::update(size_t bestMoveIdx, float qMargin, float valueEval)
+{
+    if (!hasSamples) {
+        firstValueEval = valueEval;
+        hasSamples = true;
+    }
+    else if (bestMoveIdx != this->bestMoveIdx) {
+        stableSamples = 0;
+        bestMoveChanges += 1;
+    }
+    else {
+        ++stableSamples;
+    }
+    bestMoveChanges *= TIME_CHANGE_DECAY;
+    this->bestMoveIdx = bestMoveIdx;
+    this->qMargin = qMargin;
+    this->valueEval = valueEval;
+}
+
+float SearchStability::get_time_factor() const
+{
+    if (!hasSamples) {
+        return 1;
+    }
+    float factor = 1;
+    if (stableSamples > TIME_STABLE_SAMPLES) {
+        factor -= TIME_STABLE_STEP * (stableSamples - TIME_STABLE_SAMPLES);
+        if (qMargin > TIME_STABLE_Q_MARGIN) {
+            factor *= TIME_STABLE_MARGIN_FACTOR;
+        }
+    }
+    factor += TIME_CHANGE_STEP * bestMoveChanges;
+    if (valueEval < firstValueEval) {
+        factor += TIME_DROP_FACTOR * (firstValueEval - valueEval);
+    }
+    return std::clamp(factor, minFactor, maxFactor);
+}
@@ -44,6 +44,15 @@ private:
     int timePropMovesToGo;
     float incrementFactor;
 
+    // exponential moving averages of the measured latencies in ms
+    float batchLatencyMS;
+    // time between the end of the move time and the emission of the best move
+    float moveDelayMS;
+    // time which was spent waiting for the garbage collector
+    float gcPauseMS;
+    // move time which was saved by converged searches and is added to the next clock based move time
+    int savedTimeMS;
+
     /**
      * @brief apply_random_factor Applies the current randomly generated move factor on the given movetime.
      * In case the randomMoveFactor is 0.0 the function returns the original curMovetime instead.
@@ -82,6 +91,79 @@ public:
      */
     int get_time_for_move(const SearchLimits* searchLimits, SideToMove me, int moveNumber);
     int get_thresh_move() const;
+
+    /**
+     * @brief update_latency_statistics Updates the latency measurements after a search.
+     * The move time of the next searches is reduced by the observed delays, so that short time controls don't flag on slow hardware.
+     * @param elapsedMS Time between the start of the search and the emission of the best move
+     * @param batchLatencyMS Average time of a neural network batch during the search (0 if no batch was evaluated)
+     * @param gcPauseMS Time which was spent waiting for the garbage collector
+     */
+    void update_latency_statistics(int elapsedMS, float batchLatencyMS, float gcPauseMS);
+
+    /**
+     * @brief add_saved_time Carries the unused time of a search which was stopped early over to the next move
+     * @param savedTimeMS Unused move time in ms
+     */
+    void add_saved_time(int savedTimeMS);
+
+    /**
+     * @brief clear_saved_time Drops the carried over time, e.g. when a new game starts
+     */
+    void clear_saved_time();
+
+    /**
+     * @brief get_batch_latency_ms Returns the measured average latency of a neural network batch
+     * @return Latency in ms (0 if no measurement is available yet)
+     */
+    float get_batch_latency_ms() const;
+
+    /**
+     * @brief get_latency_reserve_ms Returns the time which is reserved for the delays after the end of the move time
+     * @return Time in ms
+     */
+    int get_latency_reserve_ms() const;
+};
+
+/**
+ * @brief The SearchStability class scales the move time by the stability of the root statistics during a search.
+ * A best move which stays the same for many samples with a clear Q-value margin reduces the move time,
+ * switching best moves or a dropping evaluation increase it.
+ */
+class SearchStability
+{
+private:
+    float minFactor;
+    float maxFactor;
+    size_t bestMoveIdx;
+    size_t stableSamples;
+    float bestMoveChanges;
+    float qMargin;
+    float firstValueEval;
+    float valueEval;
+    bool hasSamples;
+
+public:
+    /**
+     * @brief SearchStability
+     * @param minFactor Lowest factor of the move time
+     * @param maxFactor Highest factor of the move time
+     */
+    SearchStability(float minFactor, float maxFactor);
+
+    /**
+     * @brief update Adds a sample of the root statistics
+     * @param bestMoveIdx Child index of the current best move
+     * @param qMargin Q-value of the best move minus the Q-value of the best alternative
+     * @param valueEval Current value evaluation of the root
+     */
+    void update(size_t bestMoveIdx, float qMargin, float valueEval);
+
+    /**
+     * @brief get_time_factor Returns the factor which is applied to the planned move time
+     * @return Factor in [minFactor, maxFactor], 1 without samples
+     */
+    float get_time_factor() const;
 };
 
 /**
@@ -25,6 +25,8 @@
 
 #include "treemanager.h"
 #include "../node.h"
+#include "../agents/util/gcthread.h"
+#include <unordered_set>
 
 shared_ptr<Node> pick_next_node(Action move, const Node* parentNode)
 {
@@ -44,3 +46,146 @@ bool same_hash_key(Node* node, StateObj* state)
             node->hash_key() == state->hash_key() &&
             node->plies_from_null() == state->steps_from_null();
 }
+
+shared_ptr<Node> get_transposition_node(MapWithMutex* mapWithMutex, StateObj* state)
+{
+    HashShard& shard = mapWithMutex->get_shard(state->hash_key());
+    lock_guard<HashMutex> lock(shard.mtx);
+    HashMap::const_iterator it = shard.hashTable.find(state->hash_key());
+    if (it == shard.hashTable.end()) {
+        return nullptr;
+    }
+#ifdef MCTS_NODE_POOL
+    // non-owning handle: the garbage collector keeps the new root node alive
+    shared_ptr<Node> node = shared_ptr<Node>(node_pool().get(it->second.node), [](Node*){});
+#else
+    shared_ptr<Node> node = it->second.node.lock();
+#endif
+    if (node == nullptr || !is_transposition_verified(node.get(), state) || !node->is_playout_node() || node->get_number_of_nodes() == 0) {
+        return nullptr;
+    }
+    return node;
+}
+
+/**
+ * @brief get_max_prune_visits Returns the maximum number of visits of a subtree which may be pruned.
+ * Epsilon greedy rollouts walk down the tree without virtual losses, but only into nodes with at least epsilonGreedyCounter visits.
+ * @param searchSettings Pointer to the search settings struct
+ * @return Visit limit (0 if no subtree can be pruned safely)
+ */
+uint32_t get_max_prune_visits(const SearchSettings* searchSettings)
+{
+    if (searchSettings->epsilonGreedyCounter != 0) {
+        return searchSettings->epsilonGreedyCounter - 1;
+    }
+    if (searchSettings->epsilonChecksCounter != 0) {
+        return 0;
+    }
+    return UINT32_MAX;
+}
+
+/**
+ * @brief get_prune_visit_threshold Builds a histogram of the node memory over log2(visits) and returns the smallest visit threshold
+ * that covers the requested number of bytes.
+ * @param rootNode Root node of the current search
+ * @param bytesToFree Number of bytes which should be released
+ * @return Visit threshold, all subtrees with at most this number of visits are pruned
+ */
+uint32_t get_prune_visit_threshold(Node* rootNode, size_t bytesToFree)
+{
+    size_t memoryPerBucket[32] = {0};
+    unordered_set<const Node*> visitedNodes;
+    vector<Node*> openNodes = {rootNode};
+    while (!openNodes.empty()) {
+        Node* node = openNodes.back();
+        openNodes.pop_back();
+        node->lock();
+        if (node->is_playout_node()) {
+            for (ChildIdx childIdx = 0; childIdx < node->get_no_visit_idx(); ++childIdx) {
+                Node* childNode = node->get_child_node(childIdx);
+                if (childNode != nullptr && visitedNodes.insert(childNode).second) {
+                    const uint32_t visits = max(node->get_child_number_visits(childIdx), 1U);
+                    memoryPerBucket[31 - __builtin_clz(visits)] += childNode->get_memory_size();
+                    openNodes.emplace_back(childNode);
+                }
+            }
+        }
+        node->unlock();
+    }
+
+    size_t freedBytes = 0;
+    for (size_t bucket = 0; bucket < 31; ++bucket) {
+        freedBytes += memoryPerBucket[bucket];
+        if (freedBytes >= bytesToFree) {
+            return (2U << bucket) - 1;
+        }
+    }
+    return UINT32_MAX;
+}
+
+size_t prune_tree(Node* rootNode, size_t bytesToFree, MapWithMutex* mapWithMutex, const SearchSettings* searchSettings)
+{
+    if (rootNode == nullptr || !rootNode->is_playout_node()) {
+        return 0;
+    }
+    const uint32_t visitThreshold = min(get_prune_visit_threshold(rootNode, bytesToFree), get_max_prune_visits(searchSettings));
+    if (visitThreshold == 0) {
+        return 0;
+    }
+
+    size_t numberPrunedNodes = 0;
+    unordered_set<const Node*> visitedNodes;
+    vector<Node*> openNodes;
+    rootNode->lock();
+    for (ChildIdx childIdx = 0; childIdx < rootNode->get_no_visit_idx(); ++childIdx) {
+        Node* childNode = rootNode->get_child_node(childIdx);
+        if (childNode != nullptr && visitedNodes.insert(childNode).second) {
+            openNodes.emplace_back(childNode);
+        }
+    }
+    rootNode->unlock();
+
+    vector<NodeLink> detachedNodes;
+    while (!openNodes.empty()) {
+        Node* node = openNodes.back();
+        openNodes.pop_back();
+        node->lock();
+        if (node->is_playout_node() && !node->is_terminal()) {
+            const size_t bestIdx = get_best_action_index(node, true, searchSettings);
+            for (ChildIdx childIdx = 0; childIdx < node->get_no_visit_idx(); ++childIdx) {
+                Node* childNode = node->get_child_node(childIdx);
+                if (childNode == nullptr) {
+                    continue;
+                }
+                childNode->lock();
+                const bool canPrune = childIdx != bestIdx && node->get_virtual_loss_counter(childIdx) == 0 &&
+                        node->get_child_number_visits(childIdx) <= visitThreshold &&
+                        !childNode->is_terminal() && (!childNode->is_playout_node() || childNode->get_node_type() == UNSOLVED);
+                childNode->unlock();
+                if (canPrune) {
+                    detachedNodes.emplace_back(node->detach_child_node(childIdx));
+                }
+                else if (visitedNodes.insert(childNode).second) {
+                    openNodes.emplace_back(childNode);
+                }
+            }
+        }
+        node->unlock();
+
+        // the detached subtrees are released outside of the lock
+        for (NodeLink& link : detachedNodes) {
+#ifdef MCTS_NODE_POOL
+            release_detached_node(link, mapWithMutex);
+#else
+            Node* childNode = get_node_ptr(link);
+            childNode->lock();
+            childNode->decrement_number_parents();
+            childNode->unlock();
+            link = nullptr;
+#endif
+        }
+        numberPrunedNodes += detachedNodes.size();
+        detachedNodes.clear();
+    }
+    return numberPrunedNodes;
+}
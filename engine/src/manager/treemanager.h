@@ -48,4 +48,29 @@ shared_ptr<Node> pick_next_node(Action move, const Node* parentNode);
  */
 bool same_hash_key(Node* node, StateObj* state);
 
+/**
+ * @brief get_transposition_node Looks up the given position in the hash table of the former searches.
+ * This allows reusing the tree if the position has been reached via another move order.
+ * @param mapWithMutex Hash table
+ * @param state Position of the next search
+ * @return Verified node with at least one expanded child node or a nullptr
+ */
+shared_ptr<Node> get_transposition_node(MapWithMutex* mapWithMutex, StateObj* state);
+
+// fraction of the memory budget to which the tree is reduced when the budget has been exceeded
+#define MEMORY_BUDGET_PRUNE_RATIO 0.8f
+
+/**
+ * @brief prune_tree Detaches the subtrees with the lowest visit counts from the search tree until about the given number of bytes has been freed.
+ * The visits and Q-values of the detached edges remain in their parent nodes, so a pruned subtree is expanded again
+ * once it gets selected. Solved nodes, edges with pending virtual losses, the children of the root node and the nodes
+ * of the principal variation are always kept. The method can be called while the search threads are running.
+ * @param rootNode Root node of the current search
+ * @param bytesToFree Number of bytes which should be released
+ * @param mapWithMutex Hash table which is shared with the search threads
+ * @param searchSettings Pointer to the search settings struct
+ * @return Number of detached subtrees
+ */
+size_t prune_tree(Node* rootNode, size_t bytesToFree, MapWithMutex* mapWithMutex, const SearchSettings* searchSettings);
+
 #endif // TREEMANAGER_H
@@ -0,0 +1,103 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: coremlapi.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * This file describes the CoreML interface for CrazyAra networks on Apple Silicon.
+ * CoreML schedules the model on the CPU, the GPU (Metal) and the Neural Engine of the M-series chips.
+ * The models are converted from the TorchScript export by DeepCrazyhouse/src/tools/convert_coreml.py
+ * into "<model>-bsize-<batch size>.mlpackage" files which are compiled once and cached as ".mlmodelc" directories.
+ * The implementation is written in Objective-C++ (coremlapi.mm), the header hides all Objective-C types.
+ * More information about CoreML can be found at:
+ * https://developer.apple.com/documentation/coreml
+ */
+
+#ifndef COREMLAPI_H
+#define COREMLAPI_H
+
+#ifdef COREML
+#include "neuralnetapi.h"
+#include <memory>
+
+// Objective-C objects of the loaded model (defined in coremlapi.mm)
+struct CoreMLSession;
+
+/**
+ * @brief The CoreMLAPI class provides a compatible interface to use CrazyAra networks with CoreML.
+ * The input planes of the search are wrapped without a copy and the outputs are written by CoreML into the output
+ * buffers of this class (output backings). On Apple Silicon the CPU, GPU and Neural Engine share the unified memory,
+ * so no host-device transfers are needed.
+ */
+class CoreMLAPI : public NeuralNetAPI
+{
+private:
+    std::unique_ptr<CoreMLSession> session;
+    // "all", "cpu", "gpu" or "ane"
+    string computeUnits;
+    // "float16" or "float32"
+    string precision;
+    string cacheDirectory;
+
+    vector<float> valueData;
+    vector<float> policyData;
+    vector<float> auxiliaryData;
+public:
+    /**
+     * @brief CoreMLAPI
+     * @param deviceID Device ID (unused, there is a single Apple GPU)
+     * @param batchSize Batch size
+     * @param modelDirectory Directory which contains the mlpackage files
+     * @param computeUnits Compute units which may be used by CoreML: "all", "cpu", "gpu" (CPU and GPU) or "ane" (CPU and Neural Engine)
+     * @param precision "float16" allows the GPU to accumulate in half precision. The precision of the weights is set by the conversion.
+     * @param cacheDirectory Directory of the compiled models, an empty string uses the model directory
+     */
+    CoreMLAPI(int deviceID, unsigned int batchSize, const string& modelDirectory, const string& computeUnits,
+              const string& precision, const string& cacheDirectory);
+    ~CoreMLAPI();
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+
+private:
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+
+    /**
+     * @brief get_compiled_model_path Returns the path of the compiled model in the cache directory
+     * @return string
+     */
+    string get_compiled_model_path() const;
+};
+
+/**
+ * @brief get_coreml_model_name Returns the name of the mlpackage (or mlmodel) file for the given batch size.
+ * Throws an invalid_argument exception if no such file exists.
+ * @param modelDir Model directory
+ * @param batchSize Batch size
+ * @return Model file name
+ */
+string get_coreml_model_name(const string& modelDir, int batchSize);
+
+#endif
+
+#endif // COREMLAPI_H
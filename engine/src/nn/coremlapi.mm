@@ -0,0 +1,265 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: coremlapi.mm
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#ifdef COREML
+#import <CoreML/CoreML.h>
+#import <Foundation/Foundation.h>
+#include "coremlapi.h"
+#include "stateobj.h"
+#include <algorithm>
+#include <stdexcept>
+
+struct CoreMLSession {
+    MLModel* model = nil;
+    MLPredictionOptions* options = nil;
+    NSString* inputName = nil;
+    NSString* valueName = nil;
+    NSString* policyName = nil;
+    NSString* auxiliaryName = nil;
+    NSArray<NSNumber*>* inputShape = nil;
+    NSArray<NSNumber*>* inputStrides = nil;
+    MLMultiArray* valueBacking = nil;
+    MLMultiArray* policyBacking = nil;
+    MLMultiArray* auxiliaryBacking = nil;
+};
+
+namespace {
+NSString* to_ns_string(const string& text)
+{
+    return [NSString stringWithUTF8String:text.c_str()];
+}
+
+string error_string(NSError* error)
+{
+    return error == nil ? "unknown error" : string([[error localizedDescription] UTF8String]);
+}
+
+MLComputeUnits get_compute_units(const string& computeUnits)
+{
+    if (computeUnits == "cpu") {
+        return MLComputeUnitsCPUOnly;
+    }
+    if (computeUnits == "gpu") {
+        return MLComputeUnitsCPUAndGPU;
+    }
+    if (computeUnits == "ane") {
+        return MLComputeUnitsCPUAndNeuralEngine;
+    }
+    return MLComputeUnitsAll;
+}
+
+void set_shape(nn_api::Shape& shape, NSArray<NSNumber*>* dims)
+{
+    shape.nbDims = int(dims.count);
+    for (int idx = 0; idx < shape.nbDims; ++idx) {
+        shape.v[idx] = dims[idx].intValue;
+    }
+}
+
+// strides of a contiguous row-major array
+NSArray<NSNumber*>* get_strides(NSArray<NSNumber*>* shape)
+{
+    NSMutableArray<NSNumber*>* strides = [NSMutableArray arrayWithCapacity:shape.count];
+    NSInteger stride = 1;
+    for (NSInteger idx = NSInteger(shape.count) - 1; idx >= 0; --idx) {
+        [strides insertObject:@(stride) atIndex:0];
+        stride *= shape[idx].integerValue;
+    }
+    return strides;
+}
+
+NSArray<NSNumber*>* get_output_shape(MLModel* model, NSString* name)
+{
+    return model.modelDescription.outputDescriptionsByName[name].multiArrayConstraint.shape;
+}
+
+MLMultiArray* create_backing(vector<float>& data, NSArray<NSNumber*>* shape)
+{
+    NSError* error = nil;
+    MLMultiArray* array = [[MLMultiArray alloc] initWithDataPointer:data.data() shape:shape dataType:MLMultiArrayDataTypeFloat32
+                                                            strides:get_strides(shape) deallocator:nil error:&error];
+    if (array == nil) {
+        throw invalid_argument("The CoreML output buffer couldn't be created: " + error_string(error));
+    }
+    return array;
+}
+
+/**
+ * @brief read_output Copies an output into the given buffer if CoreML didn't write it into the output backing
+ */
+void read_output(id<MLFeatureProvider> result, NSString* name, MLMultiArray* backing, vector<float>& data)
+{
+    MLMultiArray* output = [result featureValueForName:name].multiArrayValue;
+    if (output == nil || output == backing) {
+        return;
+    }
+    [output getBytesWithHandler:^(const void* bytes, NSInteger size) {
+        std::copy_n(static_cast<const float*>(bytes), std::min(data.size(), size_t(size) / sizeof(float)), data.begin());
+    }];
+}
+}
+
+string get_coreml_model_name(const string& modelDir, int batchSize)
+{
+    for (const string& suffix : {".mlpackage", ".mlmodel"}) {
+        const string modelName = get_file_ending_with(modelDir, "-bsize-" + to_string(batchSize) + suffix);
+        if (modelName != "") {
+            return modelName;
+        }
+    }
+    throw invalid_argument("The given directory at " + modelDir + " doesn't contain a file ending with -bsize-" + to_string(batchSize) +
+                           ".mlpackage. Run convert_coreml.py to create it.");
+}
+
+CoreMLAPI::CoreMLAPI(int deviceID, unsigned int batchSize, const string& modelDirectory, const string& computeUnits,
+                     const string& precision, const string& cacheDirectory):
+    NeuralNetAPI(computeUnits, deviceID, batchSize, modelDirectory, false),
+    session(make_unique<CoreMLSession>()),
+    computeUnits(computeUnits),
+    precision(precision),
+    cacheDirectory(cacheDirectory == "" ? modelDir : parse_directory(cacheDirectory))
+{
+    modelName = get_coreml_model_name(modelDir, batchSize);
+    modelFilePath = modelDir + modelName;
+    initialize();
+    enable_host_policy_gather();
+}
+
+CoreMLAPI::~CoreMLAPI()
+{
+}
+
+string CoreMLAPI::get_compiled_model_path() const
+{
+    return cacheDirectory + modelName.substr(0, modelName.find_last_of('.')) + ".mlmodelc";
+}
+
+void CoreMLAPI::load_model()
+{
+    @autoreleasepool {
+        NSError* error = nil;
+        NSURL* compiledURL = [NSURL fileURLWithPath:to_ns_string(get_compiled_model_path())];
+        if (!file_exists(get_compiled_model_path())) {
+            // the compilation for the device takes several seconds, so the compiled model is kept for the next start
+            info_string("compile CoreML model and save it to", get_compiled_model_path());
+            NSURL* temporaryURL = [MLModel compileModelAtURL:[NSURL fileURLWithPath:to_ns_string(modelFilePath)] error:&error];
+            if (temporaryURL == nil) {
+                throw invalid_argument("The CoreML model " + modelFilePath + " couldn't be compiled: " + error_string(error));
+            }
+            if (![[NSFileManager defaultManager] moveItemAtURL:temporaryURL toURL:compiledURL error:&error]) {
+                info_string("The compiled CoreML model couldn't be cached:", error_string(error));
+                compiledURL = temporaryURL;
+            }
+        }
+        MLModelConfiguration* config = [[MLModelConfiguration alloc] init];
+        config.computeUnits = get_compute_units(computeUnits);
+        config.allowLowPrecisionAccumulationOnGPU = precision == "float16";
+        session->model = [MLModel modelWithContentsOfURL:compiledURL configuration:config error:&error];
+        if (session->model == nil) {
+            throw invalid_argument("The CoreML model " + get_compiled_model_path() + " couldn't be loaded: " + error_string(error));
+        }
+    }
+    MLModelDescription* description = session->model.modelDescription;
+    session->inputName = to_ns_string(nnDesign.inputLayerName);
+    if (description.inputDescriptionsByName[session->inputName] == nil) {
+        session->inputName = description.inputDescriptionsByName.allKeys.firstObject;
+    }
+    session->valueName = to_ns_string(nnDesign.valueOutputName);
+    session->policyName = to_ns_string(nnDesign.policyOutputName);
+    if (description.outputDescriptionsByName[session->valueName] == nil || description.outputDescriptionsByName[session->policyName] == nil) {
+        throw invalid_argument("The CoreML model must have the outputs " + nnDesign.valueOutputName + " and " + nnDesign.policyOutputName + ".");
+    }
+    if (description.outputDescriptionsByName[to_ns_string(nnDesign.auxiliaryOutputName)] != nil) {
+        session->auxiliaryName = to_ns_string(nnDesign.auxiliaryOutputName);
+    }
+}
+
+void CoreMLAPI::load_parameters()
+{
+    // the parameters are loaded together with the model
+}
+
+void CoreMLAPI::init_nn_design()
+{
+    session->inputShape = session->model.modelDescription.inputDescriptionsByName[session->inputName].multiArrayConstraint.shape;
+    session->inputStrides = get_strides(session->inputShape);
+    set_shape(nnDesign.inputShape, session->inputShape);
+    set_shape(nnDesign.valueOutputShape, get_output_shape(session->model, session->valueName));
+    set_shape(nnDesign.policyOutputShape, get_output_shape(session->model, session->policyName));
+    nnDesign.hasAuxiliaryOutputs = session->auxiliaryName != nil;
+    if (nnDesign.hasAuxiliaryOutputs) {
+        set_shape(nnDesign.auxiliaryOutputShape, get_output_shape(session->model, session->auxiliaryName));
+    }
+    nnDesign.isPolicyMap = unsigned(nnDesign.policyOutputShape.v[1]) != StateConstants::NB_LABELS();
+}
+
+void CoreMLAPI::bind_executor()
+{
+    valueData.resize(nnDesign.valueOutputShape.flatten());
+    policyData.resize(nnDesign.policyOutputShape.flatten());
+    // CoreML writes the outputs directly into these buffers
+    NSMutableDictionary<NSString*, id>* backings = [NSMutableDictionary dictionary];
+    session->valueBacking = create_backing(valueData, get_output_shape(session->model, session->valueName));
+    session->policyBacking = create_backing(policyData, get_output_shape(session->model, session->policyName));
+    backings[session->valueName] = session->valueBacking;
+    backings[session->policyName] = session->policyBacking;
+    if (nnDesign.hasAuxiliaryOutputs) {
+        auxiliaryData.resize(nnDesign.auxiliaryOutputShape.flatten());
+        session->auxiliaryBacking = create_backing(auxiliaryData, get_output_shape(session->model, session->auxiliaryName));
+        backings[session->auxiliaryName] = session->auxiliaryBacking;
+    }
+    session->options = [[MLPredictionOptions alloc] init];
+    session->options.outputBackings = backings;
+}
+
+void CoreMLAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    @autoreleasepool {
+        NSError* error = nil;
+        // the input planes of the search thread are used without a copy
+        MLMultiArray* input = [[MLMultiArray alloc] initWithDataPointer:inputPlanes shape:session->inputShape dataType:MLMultiArrayDataTypeFloat32
+                                                                strides:session->inputStrides deallocator:nil error:&error];
+        MLDictionaryFeatureProvider* features = [[MLDictionaryFeatureProvider alloc] initWithDictionary:@{session->inputName: input} error:&error];
+        id<MLFeatureProvider> result = [session->model predictionFromFeatures:features options:session->options error:&error];
+        if (result == nil) {
+            throw runtime_error("CoreML prediction failed: " + error_string(error));
+        }
+        read_output(result, session->valueName, session->valueBacking, valueData);
+        read_output(result, session->policyName, session->policyBacking, policyData);
+        if (nnDesign.hasAuxiliaryOutputs) {
+            read_output(result, session->auxiliaryName, session->auxiliaryBacking, auxiliaryData);
+        }
+    }
+
+    // copy the outputs to the given pointers
+    std::copy(valueData.begin(), valueData.begin() + numberPositions, valueOutput);
+    if (nnDesign.hasAuxiliaryOutputs && auxiliaryOutputs != nullptr) {
+        std::copy(auxiliaryData.begin(), auxiliaryData.begin() + numberPositions * get_nb_auxiliary_outputs(), auxiliaryOutputs);
+    }
+    // the converted models contain the policy logits
+    copy_policy_outputs(policyData.data(), probOutputs, numberPositions);
+}
+
+#endif
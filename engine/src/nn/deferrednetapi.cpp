@@ -0,0 +1,203 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: deferrednetapi.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "deferrednetapi.h"
+#include <cassert>
+#include "../util/communication.h"
+#include "../util/numa.h"
+
+DeferredPhaseLoader::DeferredPhaseLoader(const vector<string>& modelDirectories, size_t numberThreads, const NeuralNetAPI* referenceNet,
+                                         LoadFunction loadFunction):
+    loadFunction(loadFunction),
+    nbInputValues(referenceNet->get_nb_input_values_total()),
+    nbPolicyValues(referenceNet->get_nb_policy_values()),
+    isPolicyMap(referenceNet->is_policy_map()),
+    version(referenceNet->get_version()),
+    supportsPolicyGather(referenceNet->supports_policy_gather()),
+    stopLoading(false)
+{
+    for (const string& modelDirectory : modelDirectories) {
+        phases.push_back(make_unique<Phase>());
+        phases.back()->modelDirectory = modelDirectory;
+        phases.back()->netBatchesVector.resize(numberThreads);
+    }
+}
+
+DeferredPhaseLoader::~DeferredPhaseLoader()
+{
+    // the phase which is currently loaded is finished, all later ones are skipped
+    stopLoading = true;
+    if (loadingThread.joinable()) {
+        loadingThread.join();
+    }
+}
+
+void DeferredPhaseLoader::start()
+{
+    loadingThread = std::thread(&DeferredPhaseLoader::run, this);
+}
+
+void DeferredPhaseLoader::run()
+{
+    for (unique_ptr<Phase>& phase : phases) {
+        if (stopLoading) {
+            return;
+        }
+        try {
+            loadFunction(phase->modelDirectory, phase->netSingleVector, phase->netBatchesVector);
+            check_representation(phase->netSingleVector.front().get());
+            for (const vector<unique_ptr<NeuralNetAPI>>& threadNets : phase->netBatchesVector) {
+                check_representation(threadNets.front().get());
+            }
+            phase->loaded.store(true, std::memory_order_release);
+            info_string("loaded the deferred phase network", phase->modelDirectory);
+        }
+        catch (const exception& e) {
+            phase->netSingleVector.clear();
+            for (vector<unique_ptr<NeuralNetAPI>>& threadNets : phase->netBatchesVector) {
+                threadNets.clear();
+            }
+            info_string_important("The phase network", phase->modelDirectory, "couldn't be loaded:", e.what());
+        }
+    }
+}
+
+void DeferredPhaseLoader::check_representation(const NeuralNetAPI* net) const
+{
+    if (net->get_nb_input_values_total() != nbInputValues || net->get_nb_policy_values() != nbPolicyValues ||
+            net->is_policy_map() != isPolicyMap || net->get_version() != version || net->supports_policy_gather() != supportsPolicyGather) {
+        throw invalid_argument("the network doesn't use the input and policy representation of the first phase network");
+    }
+}
+
+bool DeferredPhaseLoader::is_loaded(size_t phaseIdx) const
+{
+    return phases[phaseIdx]->loaded.load(std::memory_order_acquire);
+}
+
+NeuralNetAPI* DeferredPhaseLoader::get_net(size_t phaseIdx, size_t threadIdx) const
+{
+    assert(is_loaded(phaseIdx));
+    if (threadIdx == DEFERRED_SINGLE_NET) {
+        return phases[phaseIdx]->netSingleVector.front().get();
+    }
+    return phases[phaseIdx]->netBatchesVector[threadIdx].front().get();
+}
+
+DeferredNetAPI::DeferredNetAPI(shared_ptr<DeferredPhaseLoader> loader, size_t phaseIdx, size_t threadIdx, const NeuralNetAPI* referenceNet,
+                               const string& modelDirectory):
+    NeuralNetAPI("deferred", 0, referenceNet->get_batch_size(), modelDirectory, false),
+    loader(loader),
+    phaseIdx(phaseIdx),
+    threadIdx(threadIdx),
+    referenceDesign(referenceNet->get_nn_design()),
+    referenceModelName(referenceNet->get_model_name()),
+    referenceDeviceName(referenceNet->get_device_name()),
+    referencePolicyGather(referenceNet->supports_policy_gather())
+{
+    initialize();
+}
+
+NeuralNetAPI* DeferredNetAPI::prepare_net()
+{
+    NeuralNetAPI* net = loader->get_net(phaseIdx, threadIdx);
+    net->set_number_positions(numberPositions);
+    if (gatherIndices != nullptr) {
+        net->set_policy_gather(gatherIndices, gatherCounts);
+        gatherIndices = nullptr;
+        gatherCounts = nullptr;
+    }
+    return net;
+}
+
+void DeferredNetAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    prepare_net()->predict(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+}
+
+void DeferredNetAPI::predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    prepare_net()->predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+}
+
+void DeferredNetAPI::wait()
+{
+    loader->get_net(phaseIdx, threadIdx)->wait();
+}
+
+bool DeferredNetAPI::supports_policy_gather() const
+{
+    return referencePolicyGather;
+}
+
+void DeferredNetAPI::set_policy_gather(const uint32_t* indices, const uint32_t* counts)
+{
+    if (referencePolicyGather) {
+        gatherIndices = indices;
+        gatherCounts = counts;
+    }
+}
+
+int DeferredNetAPI::get_numa_node() const
+{
+    if (!is_loaded()) {
+        return NO_NUMA_NODE;
+    }
+    return loader->get_net(phaseIdx, threadIdx)->get_numa_node();
+}
+
+bool DeferredNetAPI::is_loaded() const
+{
+    return loader->is_loaded(phaseIdx);
+}
+
+void DeferredNetAPI::load_model()
+{
+    // the phase networks share the input representation which is read from the model name
+    modelName = referenceModelName;
+    deviceName = referenceDeviceName;
+}
+
+void DeferredNetAPI::load_parameters()
+{
+    // the parameters are loaded by the DeferredPhaseLoader
+}
+
+void DeferredNetAPI::bind_executor()
+{
+    // the executor is bound by the DeferredPhaseLoader
+}
+
+void DeferredNetAPI::init_nn_design()
+{
+    nnDesign.isPolicyMap = referenceDesign.isPolicyMap;
+    nnDesign.hasAuxiliaryOutputs = referenceDesign.hasAuxiliaryOutputs;
+    nnDesign.policyOutputName = referenceDesign.policyOutputName;
+    nnDesign.valueOutputName = referenceDesign.valueOutputName;
+    nnDesign.inputShape = referenceDesign.inputShape;
+    nnDesign.valueOutputShape = referenceDesign.valueOutputShape;
+    nnDesign.policyOutputShape = referenceDesign.policyOutputShape;
+    nnDesign.auxiliaryOutputShape = referenceDesign.auxiliaryOutputShape;
+}
@@ -0,0 +1,160 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: deferrednetapi.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Deferred loading of the phase networks. Only the network of the first game phase is loaded by "isready",
+ * the networks of the remaining phases are loaded in a background thread afterwards.
+ * Until then, their DeferredNetAPI placeholders report is_loaded() == false and the search uses the network
+ * of the nearest loaded phase instead (see NeuralNetAPIUser::get_phase_net_index()).
+ */
+
+#ifndef DEFERREDNETAPI_H
+#define DEFERREDNETAPI_H
+
+#include "neuralnetapi.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+// thread index of the network with batch size 1 (netSingleVector)
+const size_t DEFERRED_SINGLE_NET = size_t(-1);
+
+/**
+ * @brief The DeferredPhaseLoader class loads the networks of the given phase directories one after another in a background thread.
+ * It owns the loaded networks and is shared by all DeferredNetAPI placeholders, the last one waits for the loading thread.
+ */
+class DeferredPhaseLoader
+{
+public:
+    /**
+     * @brief LoadFunction Loads the networks of a single phase directory into netSingleVector and netBatchesVector (one network per search thread)
+     */
+    typedef std::function<void(const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector,
+                               vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector)> LoadFunction;
+private:
+    struct Phase {
+        string modelDirectory;
+        vector<unique_ptr<NeuralNetAPI>> netSingleVector;
+        vector<vector<unique_ptr<NeuralNetAPI>>> netBatchesVector;
+        std::atomic<bool> loaded{false};
+    };
+    vector<unique_ptr<Phase>> phases;
+    LoadFunction loadFunction;
+    // representation of the first phase network which all deferred networks must share
+    uint_fast32_t nbInputValues;
+    uint_fast32_t nbPolicyValues;
+    bool isPolicyMap;
+    Version version;
+    bool supportsPolicyGather;
+    std::atomic<bool> stopLoading;
+    std::thread loadingThread;
+
+    /**
+     * @brief run Loads all phases in order, a phase which fails to load stays unloaded
+     */
+    void run();
+
+    /**
+     * @brief check_representation Throws an invalid_argument exception if the given network doesn't share the representation of the first phase network
+     */
+    void check_representation(const NeuralNetAPI* net) const;
+
+public:
+    /**
+     * @brief DeferredPhaseLoader
+     * @param modelDirectories Phase directories in loading order
+     * @param numberThreads Number of search threads
+     * @param referenceNet Loaded network of the first phase
+     * @param loadFunction Function which loads the networks of a single phase directory
+     */
+    DeferredPhaseLoader(const vector<string>& modelDirectories, size_t numberThreads, const NeuralNetAPI* referenceNet, LoadFunction loadFunction);
+    ~DeferredPhaseLoader();
+    DeferredPhaseLoader(const DeferredPhaseLoader&) = delete;
+
+    /**
+     * @brief start Starts the background thread, it must be called once after the placeholders have been created
+     */
+    void start();
+
+    /**
+     * @brief is_loaded Returns true if all networks of the given phase have been loaded
+     * @param phaseIdx Index in modelDirectories
+     */
+    bool is_loaded(size_t phaseIdx) const;
+
+    /**
+     * @brief get_net Returns a loaded network of the given phase (requires is_loaded(phaseIdx))
+     * @param phaseIdx Index in modelDirectories
+     * @param threadIdx Index of the search thread or DEFERRED_SINGLE_NET
+     */
+    NeuralNetAPI* get_net(size_t phaseIdx, size_t threadIdx) const;
+};
+
+/**
+ * @brief The DeferredNetAPI class is the placeholder of a phase network which is loaded by a DeferredPhaseLoader.
+ * It describes the network by the design of the first phase network and forwards the predictions once the network has been loaded.
+ */
+class DeferredNetAPI : public NeuralNetAPI
+{
+private:
+    shared_ptr<DeferredPhaseLoader> loader;
+    size_t phaseIdx;
+    size_t threadIdx;
+    const nn_api::NeuralNetDesign referenceDesign;
+    const string referenceModelName;
+    const string referenceDeviceName;
+    const bool referencePolicyGather;
+
+public:
+    /**
+     * @brief DeferredNetAPI
+     * @param loader Loader of the phase network
+     * @param phaseIdx Phase index of the loader
+     * @param threadIdx Index of the search thread or DEFERRED_SINGLE_NET
+     * @param referenceNet Loaded first phase network of the same search thread, it is only accessed in the constructor
+     * @param modelDirectory Phase directory which defines the game phase of the placeholder
+     */
+    DeferredNetAPI(shared_ptr<DeferredPhaseLoader> loader, size_t phaseIdx, size_t threadIdx, const NeuralNetAPI* referenceNet, const string& modelDirectory);
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void wait() override;
+    bool supports_policy_gather() const override;
+    void set_policy_gather(const uint32_t* indices, const uint32_t* counts) override;
+    int get_numa_node() const override;
+    bool is_loaded() const override;
+
+private:
+    /**
+     * @brief prepare_net Passes the number of positions and the policy indices of the next prediction to the loaded network
+     */
+    NeuralNetAPI* prepare_net();
+
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+};
+
+#endif // DEFERREDNETAPI_H
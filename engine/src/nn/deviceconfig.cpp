@@ -0,0 +1,160 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: deviceconfig.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "deviceconfig.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+// removes leading and trailing whitespace
+static string trim(const string& str)
+{
+    const size_t first = str.find_first_not_of(" \t");
+    if (first == string::npos) {
+        return "";
+    }
+    return str.substr(first, str.find_last_not_of(" \t") - first + 1);
+}
+
+// parses an integer setting which must be at least minValue
+static size_t parse_number(const string& key, const string& value, long minValue)
+{
+    size_t processed = 0;
+    long number = 0;
+    try {
+        number = stol(value, &processed);
+    }
+    catch (const exception&) {
+        processed = 0;
+    }
+    if (value.empty() || processed != value.size() || number < minValue) {
+        throw invalid_argument("Invalid value '" + value + "' of the device setting " + key);
+    }
+    return size_t(number);
+}
+
+bool is_device_uuid(const string& name)
+{
+    return name.rfind("GPU-", 0) == 0 || name.rfind("MIG-", 0) == 0;
+}
+
+vector<DeviceSpec> parse_device_config(const string& config, size_t defaultThreads, unsigned int defaultBatchSize, const string& defaultPrecision)
+{
+    vector<DeviceSpec> devices;
+    size_t numberUuids = 0;
+    istringstream entries(config);
+    string entry;
+    while (getline(entries, entry, ';')) {
+        entry = trim(entry);
+        if (entry.empty()) {
+            continue;
+        }
+        const size_t separator = entry.find(':');
+        DeviceSpec device = {trim(entry.substr(0, separator)), 0, defaultThreads, defaultBatchSize, defaultPrecision, false};
+        if (device.name.empty()) {
+            throw invalid_argument("Missing device in '" + entry + "'");
+        }
+        if (is_device_uuid(device.name)) {
+            // the UUIDs are enumerated in the order of CUDA_VISIBLE_DEVICES
+            device.deviceId = int(numberUuids++);
+        }
+        else {
+            device.deviceId = int(parse_number("device", device.name, 0));
+        }
+        if (separator != string::npos) {
+            istringstream settings(entry.substr(separator + 1));
+            string setting;
+            while (getline(settings, setting, ',')) {
+                const size_t assignment = setting.find('=');
+                if (assignment == string::npos) {
+                    throw invalid_argument("Missing '=' in the device setting '" + trim(setting) + "'");
+                }
+                const string key = trim(setting.substr(0, assignment));
+                const string value = trim(setting.substr(assignment + 1));
+                if (key == "threads") {
+                    device.threads = parse_number(key, value, 1);
+                }
+                else if (key == "batch") {
+                    device.batchSize = (unsigned int)parse_number(key, value, 1);
+                    device.explicitBatchSize = true;
+                }
+                else if (key == "precision") {
+                    device.precision = value;
+                }
+                else {
+                    throw invalid_argument("Unknown device setting '" + key + "'");
+                }
+            }
+        }
+        devices.push_back(device);
+    }
+    if (numberUuids != 0 && numberUuids != devices.size()) {
+        throw invalid_argument("Device indices and UUIDs can't be mixed");
+    }
+    return devices;
+}
+
+bool set_visible_devices(const vector<DeviceSpec>& devices)
+{
+    if (devices.empty() || !is_device_uuid(devices.front().name)) {
+        return true;
+    }
+    string visibleDevices;
+    for (const DeviceSpec& device : devices) {
+        visibleDevices += (visibleDevices.empty() ? "" : ",") + device.name;
+    }
+    const char* currentValue = getenv("CUDA_VISIBLE_DEVICES");
+    if (currentValue != nullptr) {
+        return visibleDevices == currentValue;
+    }
+#ifdef _WIN32
+    _putenv_s("CUDA_VISIBLE_DEVICES", visibleDevices.c_str());
+#else
+    setenv("CUDA_VISIBLE_DEVICES", visibleDevices.c_str(), 1);
+#endif
+    return true;
+}
+
+double get_mps_share()
+{
+    const char* percentage = getenv("CUDA_MPS_ACTIVE_THREAD_PERCENTAGE");
+    if (percentage == nullptr) {
+        return 1.0;
+    }
+    const double share = atof(percentage) / 100.0;
+    return share > 0 && share < 1 ? share : 1.0;
+}
+
+void scale_batch_sizes(vector<DeviceSpec>& devices, double factor)
+{
+    for (DeviceSpec& device : devices) {
+        if (!device.explicitBatchSize) {
+            device.batchSize = max((unsigned int)lround(device.batchSize * factor), 1U);
+        }
+    }
+}
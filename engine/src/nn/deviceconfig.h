@@ -0,0 +1,97 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: deviceconfig.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Explicit configuration of the inference devices given by the UCI option "Device_Config".
+ * The configuration is a ';' separated list of devices, each optionally followed by ':' and ',' separated settings, e.g.
+ * "0:threads=3,batch=32,precision=float16;1:threads=1,batch=8".
+ * A device is either a CUDA device index or a GPU or MIG UUID ("GPU-..." or "MIG-..."). UUIDs are made visible to the
+ * process by CUDA_VISIBLE_DEVICES in the given order, so that MIG partitions can be addressed individually.
+ */
+
+#ifndef DEVICECONFIG_H
+#define DEVICECONFIG_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief The DeviceSpec struct holds the settings of a single inference device
+ */
+struct DeviceSpec {
+    // device identifier as given in the configuration (index or UUID)
+    string name;
+    // device index which is passed to the back-end
+    int deviceId;
+    // number of search threads which run their networks on this device
+    size_t threads;
+    // batch size of the networks on this device
+    unsigned int batchSize;
+    // inference precision of the networks on this device
+    string precision;
+    // true if the batch size has been given explicitly and must not be scaled
+    bool explicitBatchSize;
+};
+
+/**
+ * @brief is_device_uuid Returns true if the device identifier is a GPU or MIG UUID
+ */
+bool is_device_uuid(const string& name);
+
+/**
+ * @brief parse_device_config Parses a device configuration, all settings which aren't given use the default values.
+ * Throws an invalid_argument exception for syntax errors, unknown settings and for mixing indices and UUIDs.
+ * @param config Device configuration
+ * @param defaultThreads Number of search threads
+ * @param defaultBatchSize Batch size
+ * @param defaultPrecision Inference precision
+ * @return Device specifications in the given order
+ */
+vector<DeviceSpec> parse_device_config(const string& config, size_t defaultThreads, unsigned int defaultBatchSize, const string& defaultPrecision);
+
+/**
+ * @brief set_visible_devices Sets CUDA_VISIBLE_DEVICES to the UUIDs of the devices. It only takes effect if CUDA hasn't been
+ * initialized yet, i.e. before the first network is loaded.
+ * @param devices Device specifications
+ * @return False if the devices are addressed by UUIDs and CUDA_VISIBLE_DEVICES was already set to a different value
+ */
+bool set_visible_devices(const vector<DeviceSpec>& devices);
+
+/**
+ * @brief get_mps_share Returns the fraction of the GPU which is available to this process if it is a client of the
+ * CUDA Multi-Process Service (MPS). The share is given by CUDA_MPS_ACTIVE_THREAD_PERCENTAGE.
+ * @return Fraction in (0, 1] (1 if MPS isn't used or the process isn't restricted)
+ */
+double get_mps_share();
+
+/**
+ * @brief scale_batch_sizes Scales the batch sizes which haven't been given explicitly by a factor (at least 1)
+ * @param devices Device specifications
+ * @param factor Scaling factor (e.g. get_mps_share())
+ */
+void scale_batch_sizes(vector<DeviceSpec>& devices, double factor);
+
+#endif // DEVICECONFIG_H
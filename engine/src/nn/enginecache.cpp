@@ -0,0 +1,145 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: enginecache.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "enginecache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+uint64_t hash_bytes(const char* data, size_t size, uint64_t hash)
+{
+    for (size_t idx = 0; idx < size; ++idx) {
+        hash ^= uint8_t(data[idx]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t hash_file(const string& filePath)
+{
+    ifstream inputFile(filePath, ifstream::binary);
+    if (!inputFile) {
+        return 0;
+    }
+    uint64_t hash = 14695981039346656037ULL;
+    vector<char> chunk(1 << 20);
+    while (inputFile) {
+        inputFile.read(chunk.data(), chunk.size());
+        hash = hash_bytes(chunk.data(), size_t(inputFile.gcount()), hash);
+    }
+    return hash;
+}
+
+string get_engine_key(const string& engineDescription)
+{
+    stringstream ss;
+    ss << hex;
+    ss.width(16);
+    ss.fill('0');
+    ss << hash_bytes(engineDescription.data(), engineDescription.size());
+    return ss.str();
+}
+
+string get_engine_cache_path(const string& cacheDirectory, const string& engineDescription)
+{
+    return cacheDirectory + "engine-" + get_engine_key(engineDescription) + ".trt";
+}
+
+string get_timing_cache_path(const string& cacheDirectory, const string& deviceDescription)
+{
+    return cacheDirectory + "timing-" + get_engine_key(deviceDescription) + ".cache";
+}
+
+bool is_valid_cache_entry(const string& cacheDirectory, const string& engineDescription)
+{
+    ifstream manifest(cacheDirectory + ENGINE_CACHE_MANIFEST);
+    if (!manifest) {
+        return false;
+    }
+    // line format: "<key> <file size> <description>", the last matching entry is valid
+    const string key = get_engine_key(engineDescription);
+    bool found = false;
+    size_t recordedSize = 0;
+    string line;
+    while (getline(manifest, line)) {
+        istringstream is(line);
+        string entryKey;
+        size_t entrySize;
+        if (!(is >> entryKey >> entrySize) || entryKey != key) {
+            continue;
+        }
+        string entryDescription;
+        getline(is >> ws, entryDescription);
+        if (entryDescription == engineDescription) {
+            found = true;
+            recordedSize = entrySize;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    error_code errorCode;
+    const uintmax_t fileSize = filesystem::file_size(get_engine_cache_path(cacheDirectory, engineDescription), errorCode);
+    return !errorCode && fileSize == recordedSize;
+}
+
+bool write_file_atomic(const string& filePath, const void* buffer, size_t bufferSize)
+{
+    // unique suffix, so that concurrent writers of the same entry don't share the temporary file
+    random_device rd;
+    const string tmpFilePath = filePath + ".tmp" + to_string(rd());
+    {
+        ofstream outputFile(tmpFilePath, ofstream::binary);
+        outputFile.write(static_cast<const char*>(buffer), bufferSize);
+        if (!outputFile) {
+            remove(tmpFilePath.c_str());
+            return false;
+        }
+    }
+    error_code errorCode;
+    filesystem::rename(tmpFilePath, filePath, errorCode);
+    if (errorCode) {
+        remove(tmpFilePath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool write_cache_entry(const string& cacheDirectory, const string& engineDescription, const void* buffer, size_t bufferSize)
+{
+    error_code errorCode;
+    filesystem::create_directories(cacheDirectory, errorCode);
+    if (errorCode || !write_file_atomic(get_engine_cache_path(cacheDirectory, engineDescription), buffer, bufferSize)) {
+        return false;
+    }
+    // a single line is appended with one write call, so entries of concurrent processes don't interleave
+    const string line = get_engine_key(engineDescription) + " " + to_string(bufferSize) + " " + engineDescription + "\n";
+    ofstream manifest(cacheDirectory + ENGINE_CACHE_MANIFEST, ofstream::app);
+    manifest.write(line.data(), line.size());
+    return bool(manifest);
+}
@@ -0,0 +1,113 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: enginecache.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Content addressed cache for serialized inference engines.
+ * Each engine is stored as "engine-<key>.trt" where the key is a hash of a textual description of everything the
+ * engine depends on (model file content, GPU, library versions, precision, batch sizes).
+ * The manifest file of the cache directory lists the description and file size of every entry and is used to validate
+ * an engine file before it is loaded. All files are written atomically, so several processes can share one cache.
+ */
+
+#ifndef ENGINECACHE_H
+#define ENGINECACHE_H
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// name of the manifest file inside the cache directory
+#define ENGINE_CACHE_MANIFEST "manifest.txt"
+
+/**
+ * @brief hash_bytes Computes the 64 bit FNV-1a hash of a memory block
+ * @param data Pointer to the data
+ * @param size Number of bytes
+ * @param hash Start value which allows hashing several blocks in sequence
+ * @return Hash value
+ */
+uint64_t hash_bytes(const char* data, size_t size, uint64_t hash=14695981039346656037ULL);
+
+/**
+ * @brief hash_file Computes the hash of a file content
+ * @param filePath Path to the file
+ * @return Hash value or 0 if the file couldn't be read
+ */
+uint64_t hash_file(const string& filePath);
+
+/**
+ * @brief get_engine_key Returns the cache key of an engine description as a hex string
+ * @param engineDescription Single line description of the engine
+ * @return 16 hex digits
+ */
+string get_engine_key(const string& engineDescription);
+
+/**
+ * @brief get_engine_cache_path Returns the file path of an engine in the cache directory
+ * @param cacheDirectory Cache directory (ending with '/')
+ * @param engineDescription Single line description of the engine
+ * @return File path
+ */
+string get_engine_cache_path(const string& cacheDirectory, const string& engineDescription);
+
+/**
+ * @brief get_timing_cache_path Returns the file path of the kernel timing cache in the cache directory.
+ * The timing cache only depends on the device and library versions, so it is shared by all models, precisions and batch sizes.
+ * @param cacheDirectory Cache directory (ending with '/')
+ * @param deviceDescription Single line description of the device and library versions
+ * @return File path
+ */
+string get_timing_cache_path(const string& cacheDirectory, const string& deviceDescription);
+
+/**
+ * @brief is_valid_cache_entry Checks if the manifest of the cache directory contains an entry with exactly this description
+ * and if the engine file exists with the recorded size
+ * @param cacheDirectory Cache directory (ending with '/')
+ * @param engineDescription Single line description of the engine
+ * @return True, if the engine file can be loaded
+ */
+bool is_valid_cache_entry(const string& cacheDirectory, const string& engineDescription);
+
+/**
+ * @brief write_cache_entry Writes the engine buffer atomically to the cache directory and appends it to the manifest.
+ * The cache directory is created if it doesn't exist.
+ * @param cacheDirectory Cache directory (ending with '/')
+ * @param engineDescription Single line description of the engine
+ * @param buffer Serialized engine
+ * @param bufferSize Size of the serialized engine in bytes
+ * @return True on success
+ */
+bool write_cache_entry(const string& cacheDirectory, const string& engineDescription, const void* buffer, size_t bufferSize);
+
+/**
+ * @brief write_file_atomic Writes a buffer to a temporary file in the target directory and renames it afterwards,
+ * so that readers never see a partially written file.
+ * @param filePath Target path
+ * @param buffer Pointer to the buffer
+ * @param bufferSize Memory size of the buffer
+ * @return True on success
+ */
+bool write_file_atomic(const string& filePath, const void* buffer, size_t bufferSize);
+
+#endif // ENGINECACHE_H
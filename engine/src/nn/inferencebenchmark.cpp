@@ -0,0 +1,134 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: inferencebenchmark.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "inferencebenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include "neuralnetapiuser.h"
+#include "../util/benchmarkreport.h"
+
+InferenceMeasurement measure_inference(NeuralNetAPI* net, size_t warmupIterations, size_t iterations, const string& precision)
+{
+    float* inputPlanes = nullptr;
+    float* valueOutputs = nullptr;
+    float* probOutputs = nullptr;
+    float* auxiliaryOutputs = nullptr;
+    allocate_buffers(net, inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+    std::fill_n(inputPlanes, net->get_batch_size() * net->get_nb_input_values_total(), 0.0f);
+
+    for (size_t it = 0; it < warmupIterations; ++it) {
+        net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+    }
+    InferenceMeasurement measurement;
+    measurement.batchSize = net->get_batch_size();
+    measurement.precision = precision;
+    measurement.hasStageTimings = net->set_stage_timing(true);
+    vector<double> latenciesMS;
+    latenciesMS.reserve(iterations);
+    for (size_t it = 0; it < iterations; ++it) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+        latenciesMS.emplace_back(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1000.0);
+        if (measurement.hasStageTimings) {
+            const StageTimings timings = net->get_stage_timings();
+            measurement.stageTimings.hostToDeviceMS += timings.hostToDeviceMS;
+            measurement.stageTimings.computeMS += timings.computeMS;
+            measurement.stageTimings.deviceToHostMS += timings.deviceToHostMS;
+        }
+    }
+    net->set_stage_timing(false);
+    free_buffers(net, inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+
+    const size_t numberMeasurements = max(iterations, size_t(1));
+    measurement.latencyMeanMS = accumulate(latenciesMS.begin(), latenciesMS.end(), 0.0) / numberMeasurements;
+    measurement.latencyP50MS = percentile(latenciesMS, 0.5);
+    measurement.latencyP90MS = percentile(latenciesMS, 0.9);
+    measurement.latencyP99MS = percentile(latenciesMS, 0.99);
+    measurement.throughput = measurement.latencyMeanMS == 0 ? 0 : measurement.batchSize * 1000.0 / measurement.latencyMeanMS;
+    measurement.stageTimings.hostToDeviceMS /= numberMeasurements;
+    measurement.stageTimings.computeMS /= numberMeasurements;
+    measurement.stageTimings.deviceToHostMS /= numberMeasurements;
+    return measurement;
+}
+
+vector<size_t> distribute_threads(const vector<double>& throughputs, size_t numberThreads)
+{
+    const size_t numberDevices = throughputs.size();
+    vector<size_t> threadCounts(numberDevices, 0);
+    if (numberDevices == 0) {
+        return threadCounts;
+    }
+    const double totalThroughput = accumulate(throughputs.begin(), throughputs.end(), 0.0);
+    if (totalThroughput <= 0 || numberThreads < numberDevices) {
+        // fall back to an even distribution
+        for (size_t idx = 0; idx < numberThreads; ++idx) {
+            ++threadCounts[idx % numberDevices];
+        }
+        return threadCounts;
+    }
+    // one thread is reserved for each device, the others are assigned proportionally
+    const size_t freeThreads = numberThreads - numberDevices;
+    vector<double> remainders(numberDevices);
+    size_t assignedThreads = 0;
+    for (size_t idx = 0; idx < numberDevices; ++idx) {
+        const double share = freeThreads * throughputs[idx] / totalThroughput;
+        threadCounts[idx] = 1 + size_t(share);
+        remainders[idx] = share - size_t(share);
+        assignedThreads += size_t(share);
+    }
+    vector<size_t> order(numberDevices);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return remainders[lhs] > remainders[rhs]; });
+    for (size_t idx = 0; assignedThreads < freeThreads; ++idx, ++assignedThreads) {
+        ++threadCounts[order[idx % numberDevices]];
+    }
+    return threadCounts;
+}
+
+void print_inference_measurement_header()
+{
+    cout << setw(10) << "precision" << setw(8) << "batch" << setw(10) << "mean_ms" << setw(10) << "p50_ms" << setw(10) << "p90_ms"
+         << setw(10) << "p99_ms" << setw(12) << "pos/s" << setw(10) << "h2d_ms" << setw(12) << "compute_ms" << setw(10) << "d2h_ms" << endl;
+}
+
+void print_inference_measurement(const InferenceMeasurement& measurement)
+{
+    cout << fixed << setprecision(3)
+         << setw(10) << measurement.precision << setw(8) << measurement.batchSize
+         << setw(10) << measurement.latencyMeanMS << setw(10) << measurement.latencyP50MS << setw(10) << measurement.latencyP90MS
+         << setw(10) << measurement.latencyP99MS << setw(12) << setprecision(0) << measurement.throughput << setprecision(3);
+    if (measurement.hasStageTimings) {
+        cout << setw(10) << measurement.stageTimings.hostToDeviceMS << setw(12) << measurement.stageTimings.computeMS
+             << setw(10) << measurement.stageTimings.deviceToHostMS;
+    }
+    else {
+        cout << setw(10) << "-" << setw(12) << "-" << setw(10) << "-";
+    }
+    cout << defaultfloat << setprecision(6) << endl;
+}
@@ -0,0 +1,81 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: inferencebenchmark.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Latency and throughput measurement of a single network instance which is used by the "inference" command
+ * to sweep batch sizes and precisions.
+ */
+
+#ifndef INFERENCEBENCHMARK_H
+#define INFERENCEBENCHMARK_H
+
+#include "neuralnetapi.h"
+
+/**
+ * @brief The InferenceMeasurement struct holds the results of measure_inference()
+ */
+struct InferenceMeasurement {
+    unsigned int batchSize;
+    string precision;
+    double latencyMeanMS;
+    double latencyP50MS;
+    double latencyP90MS;
+    double latencyP99MS;
+    // evaluated positions per second
+    double throughput;
+    // mean stage durations (only valid if hasStageTimings is true)
+    bool hasStageTimings;
+    StageTimings stageTimings;
+};
+
+/**
+ * @brief measure_inference Runs warmup iterations followed by timed predictions on dummy input planes
+ * @param net Network
+ * @param warmupIterations Number of predictions which are not measured
+ * @param iterations Number of measured predictions
+ * @param precision Precision of the network (only used for the report)
+ * @return Measurement
+ */
+InferenceMeasurement measure_inference(NeuralNetAPI* net, size_t warmupIterations, size_t iterations, const string& precision);
+
+/**
+ * @brief distribute_threads Distributes the search threads over devices in proportion to their throughput.
+ * Every device gets at least one thread if there are enough threads, the remainder is assigned by the largest fractional parts.
+ * @param throughputs Measured throughput of each device
+ * @param numberThreads Total number of search threads
+ * @return Number of threads of each device
+ */
+vector<size_t> distribute_threads(const vector<double>& throughputs, size_t numberThreads);
+
+/**
+ * @brief print_inference_measurement Prints a single table row of a measurement
+ */
+void print_inference_measurement(const InferenceMeasurement& measurement);
+
+/**
+ * @brief print_inference_measurement_header Prints the header of the table of print_inference_measurement()
+ */
+void print_inference_measurement_header();
+
+#endif // INFERENCEBENCHMARK_H
@@ -0,0 +1,488 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: inferencerecording.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "inferencerecording.h"
+#include <algorithm>
+#include <stdexcept>
+#include "nullapi.h"
+#include "planepacking.h"
+#include "stateobj.h"
+#include "../util/communication.h"
+#include "../util/halfconversion.h"
+
+namespace {
+template <typename T>
+void write_value(std::ofstream& file, T value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void write_values(std::ofstream& file, const T* values, size_t numberValues)
+{
+    file.write(reinterpret_cast<const char*>(values), numberValues * sizeof(T));
+}
+
+void write_string(std::ofstream& file, const std::string& value)
+{
+    write_value(file, uint32_t(value.size()));
+    file.write(value.data(), value.size());
+}
+
+template <typename T>
+T read_value(std::ifstream& file)
+{
+    T value;
+    if (!file.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::invalid_argument("The inference recording is truncated");
+    }
+    return value;
+}
+
+template <typename T>
+void read_values(std::ifstream& file, T* values, size_t numberValues)
+{
+    if (!file.read(reinterpret_cast<char*>(values), numberValues * sizeof(T))) {
+        throw std::invalid_argument("The inference recording is truncated");
+    }
+}
+
+std::string read_string(std::ifstream& file)
+{
+    std::string value(read_value<uint32_t>(file), '\0');
+    read_values(file, &value[0], value.size());
+    return value;
+}
+
+// rounds the outputs to the precision in which they are recorded
+void round_to_half(float* values, size_t numberValues)
+{
+    for (size_t idx = 0; idx < numberValues; ++idx) {
+        values[idx] = half_to_float_scalar(float_to_half_scalar(values[idx]));
+    }
+}
+}
+
+InferenceRecording::InferenceRecording():
+    nextDecisionIdx(0),
+    missedPositions(0)
+{
+}
+
+void InferenceRecording::set_record_file(const std::string& fileName)
+{
+    lock_guard<mutex> lock(mtx);
+    if (fileName == recordFileName) {
+        return;
+    }
+    if (recordFile.is_open()) {
+        recordFile.close();
+    }
+    recordFileName = fileName;
+    recordedDirectories.clear();
+    if (fileName.empty()) {
+        return;
+    }
+    recordFile.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!recordFile) {
+        recordFileName = "";
+        throw std::invalid_argument("The inference recording file " + fileName + " can't be opened");
+    }
+    write_value(recordFile, uint32_t(INFERENCE_RECORDING_MAGIC));
+    write_value(recordFile, uint32_t(INFERENCE_RECORDING_VERSION));
+}
+
+void InferenceRecording::set_replay_file(const std::string& fileName)
+{
+    lock_guard<mutex> lock(mtx);
+    if (fileName == replayFileName) {
+        return;
+    }
+    replayNets.clear();
+    replayDecisions.clear();
+    nextDecisionIdx = 0;
+    missedPositions = 0;
+    replayFileName = "";
+    if (!fileName.empty()) {
+        load_replay(fileName);
+        replayFileName = fileName;
+    }
+}
+
+bool InferenceRecording::is_recording() const
+{
+    return !recordFileName.empty();
+}
+
+bool InferenceRecording::is_replaying() const
+{
+    return !replayFileName.empty();
+}
+
+uint32_t InferenceRecording::register_net(const NeuralNetAPI& net)
+{
+    lock_guard<mutex> lock(mtx);
+    const string modelDirectory = net.get_model_directory();
+    auto it = std::find(recordedDirectories.begin(), recordedDirectories.end(), modelDirectory);
+    if (it != recordedDirectories.end()) {
+        return uint32_t(it - recordedDirectories.begin());
+    }
+    const uint32_t netId = uint32_t(recordedDirectories.size());
+    recordedDirectories.push_back(modelDirectory);
+    write_value(recordFile, uint8_t('N'));
+    write_value(recordFile, netId);
+    write_string(recordFile, modelDirectory);
+    write_string(recordFile, net.get_model_name());
+    write_value(recordFile, uint32_t(net.get_nb_input_values_total()));
+    write_value(recordFile, uint32_t(net.get_nb_policy_values()));
+    write_value(recordFile, uint32_t(net.get_nb_auxiliary_outputs()));
+    write_value(recordFile, uint8_t(net.is_policy_map()));
+    return netId;
+}
+
+void InferenceRecording::write_batch(uint32_t netId, const NeuralNetAPI& net, const float* inputPlanes, const float* valueOutput, const float* probOutputs,
+                                     const float* auxiliaryOutputs, size_t numberPositions)
+{
+    const size_t nbInputValues = net.get_nb_input_values_total();
+    const size_t nbPolicyValues = net.get_nb_policy_values();
+    const size_t nbAuxiliaryOutputs = net.get_nb_auxiliary_outputs();
+    const size_t nbPlanes = nbInputValues % PACKED_PLANE_SIZE == 0 ? nbInputValues / PACKED_PLANE_SIZE : 0;
+    // the conversions are done before the file is locked
+    vector<uint64_t> masks(nbPlanes * numberPositions);
+    vector<float> planeValues(nbPlanes * numberPositions);
+    vector<uint8_t> isPacked(numberPositions);
+    vector<uint16_t> policies(nbPolicyValues * numberPositions);
+    vector<uint16_t> auxiliaries(nbAuxiliaryOutputs * numberPositions, 0);
+    for (size_t idx = 0; idx < numberPositions; ++idx) {
+        isPacked[idx] = nbPlanes != 0 && pack_planes(inputPlanes + idx * nbInputValues, nbPlanes, masks.data() + idx * nbPlanes,
+                                                     planeValues.data() + idx * nbPlanes);
+    }
+    float_to_half(probOutputs, policies.data(), policies.size());
+    if (auxiliaryOutputs != nullptr) {
+        float_to_half(auxiliaryOutputs, auxiliaries.data(), auxiliaries.size());
+    }
+
+    lock_guard<mutex> lock(mtx);
+    write_value(recordFile, uint8_t('B'));
+    write_value(recordFile, netId);
+    write_value(recordFile, uint32_t(numberPositions));
+    for (size_t idx = 0; idx < numberPositions; ++idx) {
+        write_value(recordFile, isPacked[idx]);
+        if (isPacked[idx]) {
+            write_values(recordFile, masks.data() + idx * nbPlanes, nbPlanes);
+            write_values(recordFile, planeValues.data() + idx * nbPlanes, nbPlanes);
+        }
+        else {
+            write_values(recordFile, inputPlanes + idx * nbInputValues, nbInputValues);
+        }
+        write_value(recordFile, valueOutput[idx]);
+        write_values(recordFile, policies.data() + idx * nbPolicyValues, nbPolicyValues);
+        write_values(recordFile, auxiliaries.data() + idx * nbAuxiliaryOutputs, nbAuxiliaryOutputs);
+    }
+}
+
+void InferenceRecording::add_decision(const std::string& decision)
+{
+    lock_guard<mutex> lock(mtx);
+    if (recordFile.is_open()) {
+        write_value(recordFile, uint8_t('D'));
+        write_string(recordFile, decision);
+        // the recording can be copied while the engine is running
+        recordFile.flush();
+    }
+    if (!is_replaying()) {
+        return;
+    }
+    if (nextDecisionIdx >= replayDecisions.size()) {
+        info_string("replay: decision", to_string(nextDecisionIdx) + " wasn't recorded");
+    }
+    else if (replayDecisions[nextDecisionIdx] != decision) {
+        info_string("replay: decision", to_string(nextDecisionIdx) + " differs, recorded: " + replayDecisions[nextDecisionIdx]);
+    }
+    if (missedPositions != 0) {
+        info_string("replay:", to_string(missedPositions.load()) + " positions weren't recorded");
+    }
+    ++nextDecisionIdx;
+}
+
+const ReplayNet* InferenceRecording::get_replay_net(const std::string& modelDirectory) const
+{
+    for (const std::unique_ptr<ReplayNet>& replayNet : replayNets) {
+        if (replayNet->modelDirectory == modelDirectory) {
+            return replayNet.get();
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> InferenceRecording::get_replay_directories(const std::string& modelDirectory) const
+{
+    std::vector<std::string> directories;
+    for (const std::unique_ptr<ReplayNet>& replayNet : replayNets) {
+        if (replayNet->modelDirectory.compare(0, modelDirectory.size(), modelDirectory) == 0) {
+            directories.push_back(replayNet->modelDirectory);
+        }
+    }
+    std::sort(directories.begin(), directories.end());
+    return directories;
+}
+
+void InferenceRecording::count_missed_position()
+{
+    ++missedPositions;
+}
+
+size_t InferenceRecording::get_missed_positions() const
+{
+    return missedPositions;
+}
+
+void InferenceRecording::load_replay(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) {
+        throw std::invalid_argument("The inference recording " + fileName + " can't be opened");
+    }
+    if (read_value<uint32_t>(file) != INFERENCE_RECORDING_MAGIC) {
+        throw std::invalid_argument(fileName + " isn't an inference recording");
+    }
+    if (read_value<uint32_t>(file) != INFERENCE_RECORDING_VERSION) {
+        throw std::invalid_argument("The inference recording " + fileName + " has an unsupported format version");
+    }
+    vector<uint64_t> masks;
+    vector<float> planeValues;
+    vector<float> inputPlanes;
+    size_t numberPositions = 0;
+    int type;
+    while ((type = file.get()) != std::ifstream::traits_type::eof()) {
+        if (type == 'N') {
+            const uint32_t netId = read_value<uint32_t>(file);
+            if (netId != replayNets.size()) {
+                throw std::invalid_argument("The inference recording " + fileName + " has an invalid network id");
+            }
+            std::unique_ptr<ReplayNet> replayNet = std::make_unique<ReplayNet>();
+            replayNet->modelDirectory = read_string(file);
+            replayNet->modelName = read_string(file);
+            replayNet->nbInputValues = read_value<uint32_t>(file);
+            replayNet->nbPolicyValues = read_value<uint32_t>(file);
+            replayNet->nbAuxiliaryOutputs = read_value<uint32_t>(file);
+            replayNet->isPolicyMap = read_value<uint8_t>(file) != 0;
+            replayNets.push_back(std::move(replayNet));
+        }
+        else if (type == 'B') {
+            const uint32_t netId = read_value<uint32_t>(file);
+            if (netId >= replayNets.size()) {
+                throw std::invalid_argument("The inference recording " + fileName + " has an invalid network id");
+            }
+            ReplayNet& replayNet = *replayNets[netId];
+            const size_t nbPlanes = replayNet.nbInputValues / PACKED_PLANE_SIZE;
+            masks.resize(nbPlanes);
+            planeValues.resize(nbPlanes);
+            inputPlanes.resize(replayNet.nbInputValues);
+            const uint32_t batchPositions = read_value<uint32_t>(file);
+            for (uint32_t idx = 0; idx < batchPositions; ++idx) {
+                if (read_value<uint8_t>(file) != 0) {
+                    read_values(file, masks.data(), nbPlanes);
+                    read_values(file, planeValues.data(), nbPlanes);
+                    unpack_planes(masks.data(), planeValues.data(), inputPlanes.data(), nbPlanes);
+                }
+                else {
+                    read_values(file, inputPlanes.data(), inputPlanes.size());
+                }
+                const size_t outputIdx = replayNet.values.size();
+                replayNet.values.push_back(read_value<float>(file));
+                replayNet.policies.resize(replayNet.policies.size() + replayNet.nbPolicyValues);
+                read_values(file, replayNet.policies.data() + outputIdx * replayNet.nbPolicyValues, replayNet.nbPolicyValues);
+                replayNet.auxiliaryOutputs.resize(replayNet.auxiliaryOutputs.size() + replayNet.nbAuxiliaryOutputs);
+                read_values(file, replayNet.auxiliaryOutputs.data() + outputIdx * replayNet.nbAuxiliaryOutputs, replayNet.nbAuxiliaryOutputs);
+                // repeated positions keep their first outputs which are identical for deterministic networks
+                replayNet.positions.emplace(hash_input_planes(inputPlanes.data(), inputPlanes.size(), 0), outputIdx);
+            }
+            numberPositions += batchPositions;
+        }
+        else if (type == 'D') {
+            replayDecisions.push_back(read_string(file));
+        }
+        else {
+            throw std::invalid_argument("The inference recording " + fileName + " has an unknown record type");
+        }
+    }
+    info_string("replay:", to_string(replayNets.size()) + " networks, " + to_string(numberPositions) + " positions and " +
+                to_string(replayDecisions.size()) + " decisions");
+}
+
+InferenceRecording& inference_recording()
+{
+    static InferenceRecording recording;
+    return recording;
+}
+
+RecordingAPI::RecordingAPI(std::unique_ptr<NeuralNetAPI> recordedNet):
+    NeuralNetAPI("recording", 0, recordedNet->get_batch_size(), recordedNet->get_model_directory(), false),
+    net(std::move(recordedNet)),
+    inputPlanes(nullptr),
+    valueOutput(nullptr),
+    probOutputs(nullptr),
+    auxiliaryOutputs(nullptr)
+{
+    initialize();
+    netId = inference_recording().register_net(*this);
+}
+
+void RecordingAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+    wait();
+}
+
+void RecordingAPI::predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    this->inputPlanes = inputPlanes;
+    this->valueOutput = valueOutput;
+    this->probOutputs = probOutputs;
+    this->auxiliaryOutputs = auxiliaryOutputs;
+    net->set_number_positions(numberPositions);
+    net->predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+}
+
+void RecordingAPI::wait()
+{
+    net->wait();
+    if (probOutputs == nullptr) {
+        // there is no pending prediction
+        return;
+    }
+    round_to_half(probOutputs, numberPositions * nbPolicyValues);
+    if (auxiliaryOutputs != nullptr) {
+        round_to_half(auxiliaryOutputs, numberPositions * nbNNAuxiliaryOutputs);
+    }
+    inference_recording().write_batch(netId, *this, inputPlanes, valueOutput, probOutputs, auxiliaryOutputs, numberPositions);
+    probOutputs = nullptr;
+}
+
+float* RecordingAPI::allocate_host_buffer(size_t numberValues)
+{
+    return net->allocate_host_buffer(numberValues);
+}
+
+void RecordingAPI::free_host_buffer(float* buffer)
+{
+    net->free_host_buffer(buffer);
+}
+
+int RecordingAPI::get_numa_node() const
+{
+    return net->get_numa_node();
+}
+
+void RecordingAPI::load_model()
+{
+    modelName = net->get_model_name();
+    deviceName = net->get_device_name();
+}
+
+void RecordingAPI::load_parameters()
+{
+    // the parameters are held by the recorded network
+}
+
+void RecordingAPI::bind_executor()
+{
+    // the executor is held by the recorded network
+}
+
+void RecordingAPI::init_nn_design()
+{
+    nnDesign = net->get_nn_design();
+}
+
+ReplayAPI::ReplayAPI(const ReplayNet* replayNet, unsigned int batchSize):
+    NeuralNetAPI("replay", 0, batchSize, replayNet->modelDirectory, false),
+    replayNet(replayNet)
+{
+    initialize();
+    if (nbNNInputValues != replayNet->nbInputValues) {
+        throw std::invalid_argument("The inference recording of " + replayNet->modelDirectory + " uses a different input representation");
+    }
+}
+
+void ReplayAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    for (size_t batchIdx = 0; batchIdx < numberPositions; ++batchIdx) {
+        float* policy = probOutputs + batchIdx * nbPolicyValues;
+        float* auxiliary = auxiliaryOutputs == nullptr ? nullptr : auxiliaryOutputs + batchIdx * nbNNAuxiliaryOutputs;
+        auto it = replayNet->positions.find(hash_input_planes(inputPlanes + batchIdx * nbNNInputValues, nbNNInputValues, 0));
+        if (it == replayNet->positions.end()) {
+            inference_recording().count_missed_position();
+            valueOutput[batchIdx] = 0;
+            std::fill_n(policy, nbPolicyValues, 1.0f / nbPolicyValues);
+            if (auxiliary != nullptr) {
+                std::fill_n(auxiliary, nbNNAuxiliaryOutputs, 0.0f);
+            }
+            continue;
+        }
+        valueOutput[batchIdx] = replayNet->values[it->second];
+        half_to_float(replayNet->policies.data() + it->second * nbPolicyValues, policy, nbPolicyValues);
+        if (auxiliary != nullptr) {
+            half_to_float(replayNet->auxiliaryOutputs.data() + it->second * nbNNAuxiliaryOutputs, auxiliary, nbNNAuxiliaryOutputs);
+        }
+    }
+}
+
+void ReplayAPI::load_model()
+{
+    modelName = replayNet->modelName;
+    deviceName = "replay";
+}
+
+void ReplayAPI::load_parameters()
+{
+    // the outputs are held by the recording
+}
+
+void ReplayAPI::bind_executor()
+{
+    // there is no executor
+}
+
+void ReplayAPI::init_nn_design()
+{
+    nnDesign.isPolicyMap = replayNet->isPolicyMap;
+    nnDesign.inputShape.nbDims = 4;
+    nnDesign.inputShape.v[0] = batchSize;
+    nnDesign.inputShape.v[1] = StateConstants::NB_CHANNELS_TOTAL();
+    nnDesign.inputShape.v[2] = StateConstants::BOARD_HEIGHT();
+    nnDesign.inputShape.v[3] = StateConstants::BOARD_WIDTH();
+    nnDesign.valueOutputShape.nbDims = 2;
+    nnDesign.valueOutputShape.v[0] = batchSize;
+    nnDesign.valueOutputShape.v[1] = 1;
+    nnDesign.policyOutputShape.nbDims = 2;
+    nnDesign.policyOutputShape.v[0] = batchSize;
+    nnDesign.policyOutputShape.v[1] = replayNet->nbPolicyValues;
+    nnDesign.hasAuxiliaryOutputs = replayNet->nbAuxiliaryOutputs != 0;
+    nnDesign.auxiliaryOutputShape.nbDims = 2;
+    nnDesign.auxiliaryOutputShape.v[0] = batchSize;
+    nnDesign.auxiliaryOutputShape.v[1] = replayNet->nbAuxiliaryOutputs;
+}
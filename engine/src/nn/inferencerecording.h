@@ -0,0 +1,225 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: inferencerecording.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Recording and replay of the inference traffic of the search.
+ * In recording mode every network is wrapped by a RecordingAPI which appends each mini-batch (packed input planes and outputs)
+ * to the recording file, the agent adds its decisions. In replay mode the networks are replaced by ReplayAPIs which answer
+ * with the recorded outputs, so a search can be re-run and profiled on any machine without the model or a GPU.
+ *
+ * File format (native byte order):
+ * header: uint32 magic, uint32 format version
+ * records: uint8 type followed by
+ *   'N' (network): uint32 id, string directory, string model name, uint32 input values, uint32 policy values,
+ *                  uint32 auxiliary outputs, uint8 policy map
+ *   'B' (batch): uint32 network id, uint32 positions, for every position:
+ *                uint8 packed, input planes (uint64 masks and float values of every plane if packed, float values otherwise),
+ *                float value, float16 policy, float16 auxiliary outputs
+ *   'D' (decision): string
+ * Strings are stored as uint32 length and characters.
+ */
+
+#ifndef INFERENCERECORDING_H
+#define INFERENCERECORDING_H
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "neuralnetapi.h"
+
+#define INFERENCE_RECORDING_MAGIC 0x52494143  // "CAIR"
+#define INFERENCE_RECORDING_VERSION 1
+
+/**
+ * @brief The ReplayNet struct holds the recorded outputs of a single network
+ */
+struct ReplayNet
+{
+    std::string modelDirectory;
+    std::string modelName;
+    uint32_t nbInputValues = 0;
+    uint32_t nbPolicyValues = 0;
+    uint32_t nbAuxiliaryOutputs = 0;
+    bool isPolicyMap = false;
+    // hash of the input planes -> index of the outputs
+    std::unordered_map<uint64_t, size_t> positions;
+    std::vector<float> values;
+    std::vector<uint16_t> policies;
+    std::vector<uint16_t> auxiliaryOutputs;
+};
+
+/**
+ * @brief The InferenceRecording class manages the recording file or the loaded replay of the process
+ */
+class InferenceRecording
+{
+private:
+    std::mutex mtx;
+    std::ofstream recordFile;
+    std::string recordFileName;
+    // model directory of every recorded network id
+    std::vector<std::string> recordedDirectories;
+
+    std::string replayFileName;
+    std::vector<std::unique_ptr<ReplayNet>> replayNets;
+    std::vector<std::string> replayDecisions;
+    size_t nextDecisionIdx;
+    std::atomic<size_t> missedPositions;
+
+public:
+    InferenceRecording();
+    InferenceRecording(const InferenceRecording&) = delete;
+    InferenceRecording& operator=(const InferenceRecording&) = delete;
+
+    /**
+     * @brief set_record_file Starts a new recording if the file name isn't empty and stops the recording otherwise
+     */
+    void set_record_file(const std::string& fileName);
+
+    /**
+     * @brief set_replay_file Loads the given recording for the replay or disables the replay for an empty file name.
+     * A recording which is already loaded isn't read again. Throws an invalid_argument exception if the file can't be parsed.
+     */
+    void set_replay_file(const std::string& fileName);
+
+    bool is_recording() const;
+    bool is_replaying() const;
+
+    /**
+     * @brief register_net Returns the id of the network in the recording and writes its description when it's recorded first
+     * @param net Recorded network (must be initialized)
+     */
+    uint32_t register_net(const NeuralNetAPI& net);
+
+    /**
+     * @brief write_batch Appends a mini-batch to the recording
+     * @param netId Id of the network which has evaluated the batch
+     * @param net Recorded network
+     * @param inputPlanes Input planes of all positions
+     * @param valueOutput Value of every position
+     * @param probOutputs Policy of every position
+     * @param auxiliaryOutputs Auxiliary outputs or nullptr
+     * @param numberPositions Number of used batch entries
+     */
+    void write_batch(uint32_t netId, const NeuralNetAPI& net, const float* inputPlanes, const float* valueOutput, const float* probOutputs,
+                     const float* auxiliaryOutputs, size_t numberPositions);
+
+    /**
+     * @brief add_decision Records a decision of the search or compares it with the next recorded decision during a replay
+     * @param decision Description of the decision, e.g. the position and the best move
+     */
+    void add_decision(const std::string& decision);
+
+    /**
+     * @brief get_replay_net Returns the recorded network of the given directory, nullptr if it wasn't recorded
+     */
+    const ReplayNet* get_replay_net(const std::string& modelDirectory) const;
+
+    /**
+     * @brief get_replay_directories Returns the sorted directories of the recorded networks which are the given directory or lie below it
+     */
+    std::vector<std::string> get_replay_directories(const std::string& modelDirectory) const;
+
+    /**
+     * @brief count_missed_position Counts a position of the replay which wasn't recorded
+     */
+    void count_missed_position();
+
+    size_t get_missed_positions() const;
+
+private:
+    void load_replay(const std::string& fileName);
+};
+
+/**
+ * @brief inference_recording Returns the recording which is shared by all networks of the process
+ */
+InferenceRecording& inference_recording();
+
+/**
+ * @brief The RecordingAPI class forwards all predictions to a network and records them.
+ * The outputs are rounded to float16 before they are passed to the search, so that the replay reproduces them exactly.
+ */
+class RecordingAPI : public NeuralNetAPI
+{
+private:
+    std::unique_ptr<NeuralNetAPI> net;
+    uint32_t netId;
+    float* inputPlanes;
+    float* valueOutput;
+    float* probOutputs;
+    float* auxiliaryOutputs;
+
+public:
+    /**
+     * @brief RecordingAPI
+     * @param net Network which runs the predictions (must not use policy gathering)
+     */
+    RecordingAPI(std::unique_ptr<NeuralNetAPI> net);
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void wait() override;
+    float* allocate_host_buffer(size_t numberValues) override;
+    void free_host_buffer(float* buffer) override;
+    int get_numa_node() const override;
+
+private:
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+};
+
+/**
+ * @brief The ReplayAPI class answers the predictions with the recorded outputs of a network.
+ * Positions which weren't recorded get a uniform policy and a value of zero.
+ */
+class ReplayAPI : public NeuralNetAPI
+{
+private:
+    const ReplayNet* replayNet;
+
+public:
+    /**
+     * @brief ReplayAPI
+     * @param replayNet Recorded network
+     * @param batchSize Constant batch size which is used for inference
+     */
+    ReplayAPI(const ReplayNet* replayNet, unsigned int batchSize);
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+
+private:
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+};
+
+#endif // INFERENCERECORDING_H
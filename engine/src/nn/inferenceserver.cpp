@@ -0,0 +1,332 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: inferenceserver.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "inferenceserver.h"
+#include <algorithm>
+#include <chrono>
+#include "../util/tracerecorder.h"
+#include "../util/metrics.h"
+
+InferenceWorker::InferenceWorker(const vector<unique_ptr<NeuralNetAPI>>& nets, InferenceServer* server, bool isOverflow):
+    NeuralNetAPIUser(nets),
+    server(server),
+    isOverflow(isOverflow)
+{
+}
+
+void InferenceWorker::run()
+{
+    trace_recorder().set_thread_name(isOverflow ? "InferenceOverflowWorker" : "InferenceWorker");
+    while (true) {
+        requests.clear();
+        const size_t numberPositions = isOverflow ? server->collect_overflow_requests(requests) : server->collect_requests(requests);
+        if (numberPositions == 0) {
+            return;
+        }
+        if (isOverflow) {
+            metrics().add(METRIC_NN_OVERFLOW_POSITIONS, numberPositions);
+        }
+        evaluate_requests(numberPositions);
+    }
+}
+
+void InferenceWorker::evaluate_requests(size_t numberPositions)
+{
+    NeuralNetAPI* net = nets.front();
+    const size_t nbInputValues = net->get_nb_input_values_total();
+    const size_t nbPolicyValues = net->get_nb_policy_values();
+    const size_t nbAuxiliaryOutputs = net->has_auxiliary_outputs() ? net->get_nb_auxiliary_outputs() : 0;
+
+    // gather
+    size_t offset = 0;
+    for (InferenceRequest* request : requests) {
+        std::copy_n(request->inputPlanes, request->numberPositions * nbInputValues, inputPlanes + offset * nbInputValues);
+        offset += request->numberPositions;
+    }
+    assert(offset == numberPositions);
+
+    net->set_number_positions(numberPositions);
+    {
+        TRACE_SCOPE("server_predict");
+        net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+    }
+
+    // scatter
+    offset = 0;
+    for (InferenceRequest* request : requests) {
+        std::copy_n(valueOutputs + offset, request->numberPositions, request->valueOutputs);
+        std::copy_n(probOutputs + offset * nbPolicyValues, request->numberPositions * nbPolicyValues, request->probOutputs);
+        if (nbAuxiliaryOutputs != 0 && request->auxiliaryOutputs != nullptr) {
+            std::copy_n(auxiliaryOutputs + offset * nbAuxiliaryOutputs, request->numberPositions * nbAuxiliaryOutputs, request->auxiliaryOutputs);
+        }
+        offset += request->numberPositions;
+        {
+            lock_guard<mutex> lock(request->mtx);
+            request->done = true;
+        }
+        request->cv.notify_one();
+    }
+}
+
+InferenceServer::InferenceServer(vector<unique_ptr<NeuralNetAPI>>& nets, size_t timeoutUS, vector<unique_ptr<NeuralNetAPI>> overflowNets,
+                                 size_t overflowLatencyUS):
+    queuedPositions(0),
+    isRunning(true),
+    timeoutUS(timeoutUS),
+    overflowLatencyUS(overflowLatencyUS),
+    maxBatchSize(nets.front()->get_batch_size())
+{
+    const size_t numberPrimaryWorkers = nets.size();
+    for (vector<unique_ptr<NeuralNetAPI>>* netList : {&nets, &overflowNets}) {
+        for (unique_ptr<NeuralNetAPI>& net : *netList) {
+            if (net->get_batch_size() != maxBatchSize) {
+                throw invalid_argument("All networks of the inference server must have the same batch size.");
+            }
+            workerNets.emplace_back();
+            workerNets.back().emplace_back(std::move(net));
+        }
+    }
+    nets.clear();
+    for (size_t idx = 0; idx < workerNets.size(); ++idx) {
+        workers.emplace_back(make_unique<InferenceWorker>(workerNets[idx], this, idx >= numberPrimaryWorkers));
+    }
+    for (unique_ptr<InferenceWorker>& worker : workers) {
+        workerThreads.emplace_back(&InferenceWorker::run, worker.get());
+    }
+    info_string("inference server workers:", numberPrimaryWorkers);
+    if (workers.size() > numberPrimaryWorkers) {
+        info_string("inference server overflow workers:", to_string(workers.size() - numberPrimaryWorkers) + " on " +
+                    workerNets.back().front()->get_device_name());
+    }
+    info_string("inference server batch size:", maxBatchSize);
+}
+
+InferenceServer::~InferenceServer()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        isRunning = false;
+    }
+    cv.notify_all();
+    overflowCv.notify_all();
+    for (thread& workerThread : workerThreads) {
+        workerThread.join();
+    }
+}
+
+void InferenceServer::submit(InferenceRequest* request)
+{
+    if (request->numberPositions > maxBatchSize) {
+        throw invalid_argument("The batch size of an inference request must not exceed the batch size of the inference server.");
+    }
+    request->done = false;
+    request->submitTime = chrono::steady_clock::now();
+    {
+        lock_guard<mutex> lock(mtx);
+        queue.push_back(request);
+        queuedPositions += request->numberPositions;
+    }
+    cv.notify_one();
+    overflowCv.notify_one();
+}
+
+void pop_fair_share_requests(deque<InferenceRequest*>& queue, size_t maxBatchSize, vector<InferenceRequest*>& requests, size_t& numberPositions)
+{
+    if (queue.empty()) {
+        return;
+    }
+    const size_t firstGroup = queue.front()->group;
+    if (all_of(queue.begin(), queue.end(), [firstGroup](const InferenceRequest* request) { return request->group == firstGroup; })) {
+        // a single client is served in submission order without the rounds
+        while (!queue.empty() && numberPositions + queue.front()->numberPositions <= maxBatchSize) {
+            numberPositions += queue.front()->numberPositions;
+            requests.emplace_back(queue.front());
+            queue.pop_front();
+        }
+        return;
+    }
+    vector<size_t> roundGroups;
+    bool isTaken = true;
+    while (isTaken && !queue.empty() && numberPositions < maxBatchSize) {
+        // one round takes the oldest request of each group
+        isTaken = false;
+        roundGroups.clear();
+        for (auto it = queue.begin(); it != queue.end();) {
+            InferenceRequest* request = *it;
+            if (find(roundGroups.begin(), roundGroups.end(), request->group) != roundGroups.end()) {
+                ++it;
+                continue;
+            }
+            // later requests of the group must wait for this one
+            roundGroups.push_back(request->group);
+            if (numberPositions + request->numberPositions > maxBatchSize) {
+                ++it;
+                continue;
+            }
+            numberPositions += request->numberPositions;
+            requests.emplace_back(request);
+            it = queue.erase(it);
+            isTaken = true;
+        }
+    }
+}
+
+void InferenceServer::pop_requests(vector<InferenceRequest*>& requests, size_t& numberPositions)
+{
+    const size_t formerPositions = numberPositions;
+    pop_fair_share_requests(queue, maxBatchSize, requests, numberPositions);
+    queuedPositions -= numberPositions - formerPositions;
+}
+
+size_t InferenceServer::collect_requests(vector<InferenceRequest*>& requests)
+{
+    unique_lock<mutex> lock(mtx);
+    cv.wait(lock, [this]{ return !queue.empty() || !isRunning; });
+    if (!isRunning) {
+        return 0;
+    }
+    const auto deadline = chrono::steady_clock::now() + chrono::microseconds(timeoutUS);
+    size_t numberPositions = 0;
+    while (true) {
+        pop_requests(requests, numberPositions);
+        if (!queue.empty() || numberPositions == maxBatchSize || !isRunning) {
+            // the batch is full
+            break;
+        }
+        if (!cv.wait_until(lock, deadline, [this]{ return !queue.empty() || !isRunning; })) {
+            // timeout
+            break;
+        }
+    }
+    return numberPositions;
+}
+
+size_t InferenceServer::collect_overflow_requests(vector<InferenceRequest*>& requests)
+{
+    unique_lock<mutex> lock(mtx);
+    while (isRunning) {
+        if (queue.empty()) {
+            overflowCv.wait(lock);
+            continue;
+        }
+        // an idle primary worker would have taken the requests already, so waiting requests mean that all of them are busy
+        const auto overdue = queue.front()->submitTime + chrono::microseconds(overflowLatencyUS);
+        if (queuedPositions >= maxBatchSize || chrono::steady_clock::now() >= overdue) {
+            size_t numberPositions = 0;
+            pop_requests(requests, numberPositions);
+            return numberPositions;
+        }
+        overflowCv.wait_until(lock, overdue);
+    }
+    return 0;
+}
+
+NeuralNetAPI* InferenceServer::get_net() const
+{
+    return workerNets.front().front().get();
+}
+
+InferenceClientAPI::InferenceClientAPI(InferenceServer* server, unsigned int batchSize, const string& modelDirectory):
+    NeuralNetAPI("server", 0, batchSize, modelDirectory, false),
+    server(server)
+{
+    if (batchSize > server->get_net()->get_batch_size()) {
+        throw invalid_argument("The batch size of the inference server must be at least as large as the search batch size.");
+    }
+    initialize();
+}
+
+void InferenceClientAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+    wait();
+}
+
+void InferenceClientAPI::predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    request.inputPlanes = inputPlanes;
+    request.valueOutputs = valueOutput;
+    request.probOutputs = probOutputs;
+    request.auxiliaryOutputs = auxiliaryOutputs;
+    request.numberPositions = numberPositions;
+    server->submit(&request);
+}
+
+void InferenceClientAPI::set_group(size_t group)
+{
+    request.group = group;
+}
+
+InferenceServer* InferenceClientAPI::get_server() const
+{
+    return server;
+}
+
+void InferenceClientAPI::wait()
+{
+    unique_lock<mutex> lock(request.mtx);
+    request.cv.wait(lock, [this]{ return request.done; });
+}
+
+int InferenceClientAPI::get_numa_node() const
+{
+    return server->get_net()->get_numa_node();
+}
+
+void InferenceClientAPI::load_model()
+{
+    modelName = server->get_net()->get_model_name();
+    deviceName = server->get_net()->get_device_name();
+}
+
+void InferenceClientAPI::load_parameters()
+{
+    // the parameters are only held by the server
+}
+
+void InferenceClientAPI::bind_executor()
+{
+    // the executor is only held by the server
+}
+
+void InferenceClientAPI::init_nn_design()
+{
+    const nn_api::NeuralNetDesign& serverDesign = server->get_net()->get_nn_design();
+    nnDesign.isPolicyMap = serverDesign.isPolicyMap;
+    nnDesign.hasAuxiliaryOutputs = serverDesign.hasAuxiliaryOutputs;
+    nnDesign.policyOutputName = serverDesign.policyOutputName;
+    nnDesign.valueOutputName = serverDesign.valueOutputName;
+    // the shapes of the server include its batch size
+    nnDesign.inputShape = serverDesign.inputShape;
+    nnDesign.inputShape.v[0] = batchSize;
+    nnDesign.valueOutputShape = serverDesign.valueOutputShape;
+    nnDesign.valueOutputShape.v[0] = batchSize;
+    nnDesign.policyOutputShape = serverDesign.policyOutputShape;
+    nnDesign.policyOutputShape.v[0] = batchSize;
+    nnDesign.auxiliaryOutputShape = serverDesign.auxiliaryOutputShape;
+    if (nnDesign.hasAuxiliaryOutputs) {
+        nnDesign.auxiliaryOutputShape.v[0] = batchSize;
+    }
+}
@@ -0,0 +1,211 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: inferenceserver.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Shared inference server which aggregates the mini-batches of many search threads into larger batches.
+ * Search threads use an InferenceClientAPI as their NeuralNetAPI, which forwards every prediction request to the server.
+ * Each worker of the server owns a neural network with a large batch size and runs in its own thread.
+ * Optional overflow workers run the same model on a secondary device (e.g. the cpu) and only take requests
+ * when the queue holds at least a full batch or the oldest request has exceeded the latency budget.
+ * Every client belongs to a group (e.g. an analysis session) and the batches are filled round robin over the groups,
+ * so that a group with many waiting requests can't starve the others.
+ */
+
+#ifndef INFERENCESERVER_H
+#define INFERENCESERVER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "neuralnetapi.h"
+#include "neuralnetapiuser.h"
+
+/**
+ * @brief The InferenceRequest struct describes a single mini-batch of a client and receives its results
+ */
+struct InferenceRequest
+{
+    float* inputPlanes = nullptr;
+    float* valueOutputs = nullptr;
+    float* probOutputs = nullptr;
+    float* auxiliaryOutputs = nullptr;
+    size_t numberPositions = 0;
+    // fair share group of the client, the requests of a group are served in submission order
+    size_t group = 0;
+    // time at which the request was added to the queue of the server
+    chrono::steady_clock::time_point submitTime;
+
+    mutex mtx;
+    condition_variable cv;
+    bool done = true;
+};
+
+class InferenceServer;
+
+/**
+ * @brief pop_fair_share_requests Moves requests from the queue to the given vector as long as they fit into a batch.
+ * In each round the oldest request of every group is taken, so that all groups get a similar share of the batch.
+ * @param queue Queue of waiting requests in submission order
+ * @param maxBatchSize Maximum number of positions of the batch
+ * @param requests Output vector of requests
+ * @param numberPositions Number of positions of the batch which is increased by the moved requests
+ */
+void pop_fair_share_requests(deque<InferenceRequest*>& queue, size_t maxBatchSize, vector<InferenceRequest*>& requests, size_t& numberPositions);
+
+/**
+ * @brief The InferenceWorker class runs the aggregated batches on its own neural network
+ */
+class InferenceWorker : public NeuralNetAPIUser
+{
+private:
+    InferenceServer* server;
+    vector<InferenceRequest*> requests;
+    // overflow workers only take the requests which the primary workers can't serve in time
+    bool isOverflow;
+public:
+    InferenceWorker(const vector<unique_ptr<NeuralNetAPI>>& nets, InferenceServer* server, bool isOverflow=false);
+
+    /**
+     * @brief run Collects, evaluates and scatters batches until the server is stopped
+     */
+    void run();
+
+private:
+    /**
+     * @brief evaluate_requests Copies the inputs of all collected requests together, runs the network and scatters the results back
+     * @param numberPositions Total number of positions of all requests
+     */
+    void evaluate_requests(size_t numberPositions);
+};
+
+class InferenceServer
+{
+private:
+    vector<vector<unique_ptr<NeuralNetAPI>>> workerNets;
+    vector<unique_ptr<InferenceWorker>> workers;
+    vector<thread> workerThreads;
+
+    deque<InferenceRequest*> queue;
+    // total number of positions of all queued requests
+    size_t queuedPositions;
+    mutex mtx;
+    condition_variable cv;
+    condition_variable overflowCv;
+    bool isRunning;
+    size_t timeoutUS;
+    size_t overflowLatencyUS;
+    size_t maxBatchSize;
+
+    /**
+     * @brief pop_requests Moves requests from the queue to the given vector as long as they fit into a batch (requires the lock)
+     * @param requests Output vector of requests
+     * @param numberPositions Number of positions of the batch which is increased by the moved requests
+     */
+    void pop_requests(vector<InferenceRequest*>& requests, size_t& numberPositions);
+public:
+    /**
+     * @brief InferenceServer
+     * @param nets Neural networks of the workers, all must belong to the same model and have the same batch size.
+     * A worker thread is started for each network.
+     * @param timeoutUS Maximum time in microseconds a worker waits for additional requests after receiving the first request of a batch
+     * @param overflowNets Networks of the overflow workers which run the same model on a different device with the same batch size (may be empty)
+     * @param overflowLatencyUS Time in microseconds a request may wait in the queue before an overflow worker takes it
+     */
+    InferenceServer(vector<unique_ptr<NeuralNetAPI>>& nets, size_t timeoutUS, vector<unique_ptr<NeuralNetAPI>> overflowNets={},
+                    size_t overflowLatencyUS=0);
+    ~InferenceServer();
+    InferenceServer(const InferenceServer&) = delete;
+
+    /**
+     * @brief submit Adds a request to the queue. The request is finished as soon as request->done is true.
+     * @param request Request which must stay valid until it has been finished
+     */
+    void submit(InferenceRequest* request);
+
+    /**
+     * @brief collect_requests Blocks until at least one request is available and collects requests
+     * until the maximum batch size or the timeout has been reached.
+     * @param requests Output vector of requests
+     * @return Total number of positions or 0 if the server has been stopped
+     */
+    size_t collect_requests(vector<InferenceRequest*>& requests);
+
+    /**
+     * @brief collect_overflow_requests Blocks until the primary workers are saturated, i.e. the queue holds at least a full batch
+     * or its oldest request has waited longer than the overflow latency budget,, and collects requests from the front of the queue.
+     * @param requests Output vector of requests
+     * @return Total number of positions or 0 if the server has been stopped
+     */
+    size_t collect_overflow_requests(vector<InferenceRequest*>& requests);
+
+    /**
+     * @brief get_net Returns the network of the first worker which describes the model of the server
+     * @return NeuralNetAPI
+     */
+    NeuralNetAPI* get_net() const;
+};
+
+/**
+ * @brief The InferenceClientAPI class is a NeuralNetAPI which doesn't run the network itself but forwards all requests to an InferenceServer
+ */
+class InferenceClientAPI : public NeuralNetAPI
+{
+private:
+    InferenceServer* server;
+    InferenceRequest request;
+public:
+    /**
+     * @brief InferenceClientAPI
+     * @param server Inference server which runs the network
+     * @param batchSize Maximum number of positions of a single request (must not exceed the batch size of the server)
+     * @param modelDirectory Model directory of the server networks
+     */
+    InferenceClientAPI(InferenceServer* server, unsigned int batchSize, const string& modelDirectory);
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void wait() override;
+    int get_numa_node() const override;
+
+    /**
+     * @brief set_group Sets the fair share group of all following requests of this client
+     * @param group Group id, e.g. the index of an analysis session (default 0)
+     */
+    void set_group(size_t group);
+
+    /**
+     * @brief get_server Returns the inference server which runs the requests of this client
+     * @return Inference server
+     */
+    InferenceServer* get_server() const;
+
+private:
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+};
+
+#endif // INFERENCESERVER_H
@@ -0,0 +1,119 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: layerprecision.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "layerprecision.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include "enginecache.h"
+
+// first line of a layer plan file, it distinguishes an empty plan from a missing or foreign file
+#define LAYER_PLAN_HEADER "# layers which are kept in higher precision"
+
+double get_output_error(const vector<float>& referenceValues, const vector<float>& values,
+                        const vector<float>& referencePolicies, const vector<float>& policies, size_t nbPolicyValues)
+{
+    const size_t numberPositions = referenceValues.size();
+    if (numberPositions == 0) {
+        return 0;
+    }
+    double valueError = 0;
+    double policyError = 0;
+    for (size_t posIdx = 0; posIdx < numberPositions; ++posIdx) {
+        valueError += std::abs(values[posIdx] - referenceValues[posIdx]);
+        double distance = 0;
+        for (size_t idx = posIdx * nbPolicyValues; idx < (posIdx + 1) * nbPolicyValues; ++idx) {
+            distance += std::abs(policies[idx] - referencePolicies[idx]);
+        }
+        policyError += distance * 0.5;
+    }
+    return max(valueError, policyError) / numberPositions;
+}
+
+size_t get_layer_group(size_t layerIdx, size_t numberLayers, size_t numberGroups)
+{
+    return layerIdx * numberGroups / numberLayers;
+}
+
+vector<bool> select_sensitive_groups(size_t numberGroups, double tolerance, const function<double(const vector<bool>&)>& measureError)
+{
+    vector<bool> keepGroups(numberGroups, false);
+    const double lowPrecisionError = measureError(keepGroups);
+    if (lowPrecisionError <= tolerance) {
+        return keepGroups;
+    }
+    vector<double> errorReductions(numberGroups);
+    for (size_t group = 0; group < numberGroups; ++group) {
+        keepGroups[group] = true;
+        errorReductions[group] = lowPrecisionError - measureError(keepGroups);
+        keepGroups[group] = false;
+    }
+    vector<size_t> order(numberGroups);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&errorReductions](size_t a, size_t b) { return errorReductions[a] > errorReductions[b]; });
+
+    for (size_t group : order) {
+        if (errorReductions[group] <= 0) {
+            break;
+        }
+        keepGroups[group] = true;
+        if (measureError(keepGroups) <= tolerance) {
+            break;
+        }
+    }
+    return keepGroups;
+}
+
+string get_layer_plan_path(const string& cacheDirectory, const string& planDescription)
+{
+    return cacheDirectory + "layerplan-" + get_engine_key(planDescription) + ".txt";
+}
+
+bool write_layer_plan(const string& filePath, const vector<string>& layerNames)
+{
+    string content = string(LAYER_PLAN_HEADER) + "\n";
+    for (const string& layerName : layerNames) {
+        content += layerName + "\n";
+    }
+    return write_file_atomic(filePath, content.data(), content.size());
+}
+
+bool read_layer_plan(const string& filePath, vector<string>& layerNames)
+{
+    ifstream planFile(filePath);
+    string line;
+    if (!getline(planFile, line) || line != LAYER_PLAN_HEADER) {
+        return false;
+    }
+    layerNames.clear();
+    while (getline(planFile, line)) {
+        if (!line.empty()) {
+            layerNames.emplace_back(line);
+        }
+    }
+    return true;
+}
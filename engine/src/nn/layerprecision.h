@@ -0,0 +1,103 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: layerprecision.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Automated selection of the layers which are kept in a higher precision for INT8 and FP16 engines.
+ * The compute layers are split into contiguous groups. The sensitivity of each group is measured by the output error of an engine
+ * in which only this group runs in the higher precision. The most sensitive groups are then kept in the higher precision
+ * until the error compared to float32 is within the tolerance. The chosen layers are persisted as a layer plan in the engine cache.
+ */
+
+#ifndef LAYERPRECISION_H
+#define LAYERPRECISION_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// number of contiguous layer groups whose sensitivity is measured, each group costs two engine builds at most
+#define LAYER_PRECISION_GROUPS 8
+// maximum number of calibration positions on which the outputs are compared
+#define LAYER_PRECISION_MAX_POSITIONS 256
+
+/**
+ * @brief get_output_error Returns the deviation of the network outputs from the float32 reference outputs.
+ * This is the maximum of the mean absolute value error and the mean total variation distance of the policies.
+ * @param referenceValues Value outputs of the float32 network
+ * @param values Value outputs of the candidate network
+ * @param referencePolicies Policy outputs of the float32 network (probabilities)
+ * @param policies Policy outputs of the candidate network (probabilities)
+ * @param nbPolicyValues Number of policy values of a single position
+ * @return Output error
+ */
+double get_output_error(const vector<float>& referenceValues, const vector<float>& values,
+                        const vector<float>& referencePolicies, const vector<float>& policies, size_t nbPolicyValues);
+
+/**
+ * @brief get_layer_group Returns the group of a layer when the layers are split into contiguous groups of equal size
+ * @param layerIdx Index of the layer
+ * @param numberLayers Total number of layers
+ * @param numberGroups Number of groups
+ * @return Group index
+ */
+size_t get_layer_group(size_t layerIdx, size_t numberLayers, size_t numberGroups);
+
+/**
+ * @brief select_sensitive_groups Selects the layer groups which are kept in the higher precision.
+ * No group is selected if the error of the low precision network is already within the tolerance. Otherwise the groups are added
+ * in the order of their error reduction until the tolerance is met or no remaining group reduces the error.
+ * @param numberGroups Number of layer groups
+ * @param tolerance Maximum output error (see get_output_error())
+ * @param measureError Builds a network in which the flagged groups are kept in the higher precision and returns its output error
+ * @return Flags of the groups which are kept in the higher precision
+ */
+vector<bool> select_sensitive_groups(size_t numberGroups, double tolerance, const function<double(const vector<bool>&)>& measureError);
+
+/**
+ * @brief get_layer_plan_path Returns the file path of the layer plan in the cache directory
+ * @param cacheDirectory Cache directory (ending with '/')
+ * @param planDescription Single line description of the model, device, precision and tolerance
+ * @return File path
+ */
+string get_layer_plan_path(const string& cacheDirectory, const string& planDescription);
+
+/**
+ * @brief write_layer_plan Writes the names of the layers which are kept in the higher precision atomically to a file
+ * @param filePath Target path
+ * @param layerNames Layer names (can be empty)
+ * @return True on success
+ */
+bool write_layer_plan(const string& filePath, const vector<string>& layerNames);
+
+/**
+ * @brief read_layer_plan Reads a layer plan which was written by write_layer_plan()
+ * @param filePath Path of the layer plan
+ * @param layerNames Returns the layer names
+ * @return False if the file doesn't exist or isn't a layer plan
+ */
+bool read_layer_plan(const string& filePath, vector<string>& layerNames);
+
+#endif // LAYERPRECISION_H
@@ -26,9 +26,33 @@
 #include "mxnetapi.h"
 
 #ifdef MXNET
+#include <mutex>
 #include "../util/communication.h"
 #include "stateobj.h"
 
+namespace {
+/**
+ * @brief The SharedParametersEntry struct holds the parameters of a registry entry. The mutex makes sure that a model is
+ * only loaded once, while different models can be loaded concurrently.
+ */
+struct SharedParametersEntry
+{
+    mutex mtx;
+    weak_ptr<MXNetParameters> parameters;
+};
+
+shared_ptr<SharedParametersEntry> get_shared_parameters_entry(const string& key)
+{
+    static mutex registryMutex;
+    static map<string, shared_ptr<SharedParametersEntry>> registry;
+    lock_guard<mutex> lock(registryMutex);
+    shared_ptr<SharedParametersEntry>& entry = registry[key];
+    if (entry == nullptr) {
+        entry = make_shared<SharedParametersEntry>();
+    }
+    return entry;
+}
+}
 
 MXNetAPI::MXNetAPI(const string& ctx, int deviceID, unsigned int miniBatchSize, const string& modelDirectory, const string& strPrecision, bool tensorRT) :
     NeuralNetAPI(ctx, deviceID, miniBatchSize, modelDirectory, tensorRT),
@@ -54,8 +78,26 @@ MXNetAPI::~MXNetAPI()
 
 void MXNetAPI::custom_initialize()
 {
-    load_model();
-    load_parameters();
+    const string key = to_string(globalCtx.GetDeviceType()) + " " + to_string(globalCtx.GetDeviceId()) + " " + to_string(enableTensorrt) +
+            " " + modelFilePath + " " + parameterFilePath;
+    shared_ptr<SharedParametersEntry> entry = get_shared_parameters_entry(key);
+    {
+        lock_guard<mutex> lock(entry->mtx);
+        sharedParameters = entry->parameters.lock();
+        if (sharedParameters == nullptr) {
+            load_model();
+            load_parameters();
+            sharedParameters = make_shared<MXNetParameters>(MXNetParameters{net, argsMap, auxMap});
+            entry->parameters = sharedParameters;
+        }
+        else {
+            info_string("reuse MXNet parameters of", modelFilePath);
+            // the maps only copy the array handles, the executors of all instances bind the same parameter memory
+            net = sharedParameters->net;
+            argsMap = sharedParameters->argsMap;
+            auxMap = sharedParameters->auxMap;
+        }
+    }
     bind_executor();
     initialize_nn_design();
 }
@@ -201,11 +243,11 @@ void MXNetAPI::predict(float *inputPlanes, float* valueOutput, float* probOutput
     executor->outputs[0].SyncCopyToCPU(valueOutput, batchSize);
     executor->outputs[1].SyncCopyToCPU(probOutputs, get_policy_output_length());
 #ifdef DYNAMIC_NN_ARCH
-    if (has_auxiliary_outputs()) {
+    if (has_auxiliary_outputs() && auxiliaryOutputs != nullptr) {
         executor->outputs[2].SyncCopyToCPU(auxiliaryOutputs, get_nb_auxiliary_outputs()*batchSize);
     }
 #else
-    if (StateConstants::NB_AUXILIARY_OUTPUTS() != 0) {
+    if (StateConstants::NB_AUXILIARY_OUTPUTS() != 0 && auxiliaryOutputs != nullptr) {
          executor->outputs[2].SyncCopyToCPU(auxiliaryOutputs, StateConstants::NB_AUXILIARY_OUTPUTS()*batchSize);
     }
 #endif
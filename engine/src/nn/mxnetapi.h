@@ -36,6 +36,16 @@
 
 using namespace mxnet::cpp;
 
+/**
+ * @brief The MXNetParameters struct holds the symbol and the parameters of a model on a single context.
+ * It is shared by all MXNetAPI instances of the same model and context, independent of their batch size.
+ */
+struct MXNetParameters
+{
+    Symbol net;
+    std::map<std::string, NDArray> argsMap;
+    std::map<std::string, NDArray> auxMap;
+};
 
 /**
  * @brief The MXNetAPI class implements access to the MXNET-C++ back-end for running inference on CPU and GPU.
@@ -50,6 +60,8 @@ private:
     Executor *executor;
     Shape inputShape;
     Context globalCtx = Context::cpu();
+    // keeps the shared parameters alive, argsMap and auxMap refer to the same device memory
+    shared_ptr<MXNetParameters> sharedParameters;
 
 public:
     MXNetAPI(const string& ctx, int deviceID, unsigned int miniBatchSize, const string& modelDirectory,  const string& strPrecision, bool tensorRT);
@@ -103,7 +115,8 @@ private:
 
     /**
      * @brief custom_initialize Use custom ordering here, because initialize() calls initialize_nn_design()
-     * after load_model() which would result in a seg-fault
+     * after load_model() which would result in a seg-fault.
+     * The model and its parameters are only loaded by the first instance of a context, all others reuse them and only bind their own executor.
      */
     void custom_initialize();
 };
@@ -24,8 +24,11 @@
  */
 
 #include "neuralnetapi.h"
+#include "../util/numa.h"
+#include "../util/policykernels.h"
 #include <string>
 #include <regex>
+#include <algorithm>
 
 
 string get_string_ending_with(const vector<string>& stringVector, const string& suffix) {
@@ -54,6 +57,16 @@ string get_file_ending_with(const string& dir, const string& suffix) {
     return retString;
 }
 
+string get_dynamic_onnx_model_name(const string& modelDir)
+{
+    const vector<string> files = get_items_by_elment(get_directory_files(modelDir), "-bsize-", false);
+    const string modelName = get_string_ending_with(files, ".onnx");
+    if (modelName == "") {
+        throw invalid_argument( "The given directory at " + modelDir + " doesn't contain an onnx file with dynamic shape support.");
+    }
+    return modelName;
+}
+
 string get_onnx_model_name(const string& modelDir, int batchSize)
 {
     string modelName = get_file_ending_with(modelDir, "-bsize-" + to_string(batchSize) + ".onnx");
@@ -78,6 +91,16 @@ unsigned int NeuralNetAPI::get_batch_size() const
     return batchSize;
 }
 
+void NeuralNetAPI::set_number_positions(unsigned int value)
+{
+    numberPositions = std::max(1U, std::min(value, batchSize));
+}
+
+const nn_api::NeuralNetDesign& NeuralNetAPI::get_nn_design() const
+{
+    return nnDesign;
+}
+
 void NeuralNetAPI::initialize_nn_design()
 {
     init_nn_design();
@@ -107,12 +130,100 @@ NeuralNetAPI::NeuralNetAPI(const string& ctx, int deviceID, unsigned int batchSi
     nbNNAuxiliaryOutputs(0),  // will be set dynamically in initialize_nn_design()
     nbPolicyValues(0),  // will be set dynamically in initialize_nn_design()
     version(make_version<0,0,0>()),
-    gamePhase(0)
+    gamePhase(0),
+    numberPositions(batchSize),
+    hostPolicyGather(false),
+    gatherIndices(nullptr),
+    gatherCounts(nullptr)
 {
     modelDir = parse_directory(modelDirectory);
     deviceName = ctx + string("_") + to_string(deviceID);
 }
 
+void NeuralNetAPI::predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    predict(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+}
+
+void NeuralNetAPI::wait()
+{
+}
+
+float* NeuralNetAPI::allocate_host_buffer(size_t numberValues)
+{
+    return new float[numberValues];
+}
+
+void NeuralNetAPI::free_host_buffer(float* buffer)
+{
+    delete [] buffer;
+}
+
+bool NeuralNetAPI::supports_policy_gather() const
+{
+    return hostPolicyGather;
+}
+
+void NeuralNetAPI::set_policy_gather(const uint32_t* indices, const uint32_t* counts)
+{
+    if (hostPolicyGather) {
+        gatherIndices = indices;
+        gatherCounts = counts;
+    }
+}
+
+void NeuralNetAPI::enable_host_policy_gather()
+{
+    // the gathered rows wouldn't be smaller than the full policy output
+    hostPolicyGather = get_nb_policy_values() > POLICY_GATHER_STRIDE;
+    if (hostPolicyGather) {
+        gatherPolicyRow.resize(get_nb_policy_values());
+    }
+}
+
+void NeuralNetAPI::copy_policy_outputs(const float* policyOutput, float* probOutputs, size_t numberRows)
+{
+    const size_t nbPolicyValues = get_nb_policy_values();
+    if (gatherIndices == nullptr) {
+        std::copy(policyOutput, policyOutput + numberRows * nbPolicyValues, probOutputs);
+        for (size_t batchIdx = 0; batchIdx < numberRows; ++batchIdx) {
+            apply_softmax(probOutputs + batchIdx * nbPolicyValues, nbPolicyValues);
+        }
+        return;
+    }
+    // the softmax is computed on a single row which stays in the cache, only the legal entries are written to the output
+    for (size_t batchIdx = 0; batchIdx < numberRows; ++batchIdx) {
+        const uint32_t* indices = gatherIndices + batchIdx * POLICY_GATHER_STRIDE;
+        float* gatheredRow = probOutputs + batchIdx * POLICY_GATHER_STRIDE;
+        softmax_policy(policyOutput + batchIdx * nbPolicyValues, gatherPolicyRow.data(), nbPolicyValues);
+        for (size_t idx = 0; idx < gatherCounts[batchIdx]; ++idx) {
+            gatheredRow[idx] = gatherPolicyRow[indices[idx]];
+        }
+    }
+    gatherIndices = nullptr;
+    gatherCounts = nullptr;
+}
+
+int NeuralNetAPI::get_numa_node() const
+{
+    return NO_NUMA_NODE;
+}
+
+bool NeuralNetAPI::is_loaded() const
+{
+    return true;
+}
+
+bool NeuralNetAPI::set_stage_timing(bool enable)
+{
+    return false;
+}
+
+StageTimings NeuralNetAPI::get_stage_timings() const
+{
+    return StageTimings();
+}
+
 bool NeuralNetAPI::is_policy_map() const
 {
     return nnDesign.isPolicyMap;
@@ -129,6 +240,11 @@ string NeuralNetAPI::get_model_name() const
     return modelName;
 }
 
+string NeuralNetAPI::get_model_directory() const
+{
+    return modelDir;
+}
+
 string NeuralNetAPI::get_device_name() const
 {
     return deviceName;
@@ -239,22 +355,5 @@ GamePhase read_game_phase_from_string(const string& modelDir)
 }
 
 void apply_softmax(float* input, size_t size) {
-
-    size_t idx;
-    double maximum = -INFINITY;
-    for (idx = 0; idx < size; ++idx) {
-        if (maximum < input[idx]) {
-            maximum = input[idx];
-        }
-    }
-
-    double sum = 0.0;
-    for (idx = 0; idx < size; ++idx) {
-        sum += exp(input[idx] - maximum);
-    }
-
-    double constant = maximum + log(sum);
-    for (idx = 0; idx < size; ++idx) {
-        input[idx] = exp(input[idx] - constant);
-    }
+    softmax_policy(input, input, size);
 }
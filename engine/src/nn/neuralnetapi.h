@@ -40,6 +40,9 @@
 #include "version.h"
 #include "../stateobj.h"
 
+// row length of the policy output if only the entries of the legal moves are returned (see set_policy_gather())
+#define POLICY_GATHER_STRIDE 256
+
 // http://www.codebind.com/cpp-tutorial/cpp-program-list-files-directory-windows-linux/
 namespace {
 vector<string> get_directory_files(const string& dir) {
@@ -141,6 +144,22 @@ bool check_condition(const T& value, const T& target, const string& valueStr, co
  */
 string get_onnx_model_name(const string& modelDir, int batchSize);
 
+/**
+ * @brief get_dynamic_onnx_model_name Returns the name of the onnx file with dynamic batch size (without "-bsize-" in its name).
+ * Throws an invalid_argument exception if no such file exists.
+ * @param modelDir Model directory
+ * @return Model file name
+ */
+string get_dynamic_onnx_model_name(const string& modelDir);
+
+/**
+ * @brief The StageTimings struct holds the durations of the stages of a single inference in milliseconds
+ */
+struct StageTimings {
+    float hostToDeviceMS = 0;
+    float computeMS = 0;
+    float deviceToHostMS = 0;
+};
 
 /**
  * @brief The NeuralNetAPI class is an abstract class for accessing a neural network back-end and to run inference
@@ -169,6 +188,15 @@ protected:
 
     Version version;
     GamePhase gamePhase;
+    // number of positions of the next prediction which are actually used, the remaining batch entries can be skipped
+    unsigned int numberPositions;
+    // true if the back-end copies only the policy entries of the legal moves from its output buffer (see copy_policy_outputs())
+    bool hostPolicyGather;
+    // policy indices of the next prediction, nullptr for the full policy output
+    const uint32_t* gatherIndices;
+    const uint32_t* gatherCounts;
+    // softmax of a single policy row before its legal entries are gathered
+    vector<float> gatherPolicyRow;
 private:
     /**
      * @brief init_nn_design Infers the input and output shapes of the loaded neural network architectures and
@@ -214,6 +242,12 @@ public:
      */
     string get_model_name() const;
 
+    /**
+     * @brief get_model_directory Returns the directory from which the model has been loaded
+     * @return string
+     */
+    string get_model_directory() const;
+
     /**
      * @brief get_device_name Returns the device name (e.g. gpu_0, or cpu_0)
      * @return string
@@ -232,10 +266,80 @@ public:
      * @param inputPlanes Pointer to the input planes of a single board position
      * @param value Value prediction for the board by the neural network
      * @param probOutputs Policy array of the raw network output (including illegal moves). It's assumend that the memory has already been allocated.
-     * @param auxiliaryOutputs Array of optional auxiliary outputs
+     * @param auxiliaryOutputs Array of optional auxiliary outputs (nullptr if they aren't consumed, their transfer is skipped then)
      */
     virtual void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) = 0;
 
+    /**
+     * @brief predict_async Starts a prediction without waiting for the results.
+     * The given buffers must not be accessed until wait() has returned.
+     * The default implementation runs a blocking predict() for back-ends without asynchronous execution.
+     * @param inputPlanes Pointer to the input planes of a single board position
+     * @param value Value prediction for the board by the neural network
+     * @param probOutputs Policy array of the raw network output (including illegal moves). It's assumend that the memory has already been allocated.
+     * @param auxiliaryOutputs Array of optional auxiliary outputs (nullptr if they aren't consumed, their transfer is skipped then)
+     */
+    virtual void predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs);
+
+    /**
+     * @brief wait Blocks until the last prediction which was started by predict_async() has finished
+     */
+    virtual void wait();
+
+    /**
+     * @brief allocate_host_buffer Allocates host memory for the input planes or the outputs of the network.
+     * Back-ends can override this hook to provide memory which can be transferred faster to the device.
+     * @param numberValues Number of float values
+     * @return Pointer to the buffer which must be released by free_host_buffer()
+     */
+    virtual float* allocate_host_buffer(size_t numberValues);
+
+    /**
+     * @brief free_host_buffer Releases memory which has been allocated by allocate_host_buffer()
+     * @param buffer Host buffer
+     */
+    virtual void free_host_buffer(float* buffer);
+
+    /**
+     * @brief supports_policy_gather Returns true if the back-end can return only the policy entries of the legal moves
+     * @return bool
+     */
+    virtual bool supports_policy_gather() const;
+
+    /**
+     * @brief set_policy_gather Sets the policy indices of the legal moves for the next prediction.
+     * The policy output then contains for each position a row of POLICY_GATHER_STRIDE values with the entries of the legal moves
+     * in the given order. The setting applies to a single prediction only.
+     * @param indices POLICY_GATHER_STRIDE indices for each position, nullptr returns the full policy output
+     * @param counts Number of legal moves for each position (at most POLICY_GATHER_STRIDE)
+     */
+    virtual void set_policy_gather(const uint32_t* indices, const uint32_t* counts);
+
+    /**
+     * @brief get_numa_node Returns the NUMA node to which the inference device is attached
+     * @return NUMA node index or NO_NUMA_NODE if it is unknown (e.g. for the CPU back-ends)
+     */
+    virtual int get_numa_node() const;
+
+    /**
+     * @brief is_loaded Returns false while the weights of a deferred network are still being loaded (see DeferredNetAPI)
+     * @return bool
+     */
+    virtual bool is_loaded() const;
+
+    /**
+     * @brief set_stage_timing Enables measuring the host to device transfer, the computation and the device to host transfer of each inference.
+     * This costs a few events per inference and disables CUDA graphs, so it is only meant for benchmarking.
+     * @param enable True to enable the measurement
+     * @return True if the back-end supports the measurement
+     */
+    virtual bool set_stage_timing(bool enable);
+
+    /**
+     * @brief get_stage_timings Returns the stage durations of the last finished inference (requires set_stage_timing(true))
+     */
+    virtual StageTimings get_stage_timings() const;
+
     /**
      * @brief is_neural_network_valid Runs validation checks of the neural network architecture by comparing input and output shape of the loaded graph to the pre-defined constants.
      * @return True, if neural network is valid else false.
@@ -292,6 +396,19 @@ public:
 
     unsigned int get_batch_size() const;
 
+    /**
+     * @brief set_number_positions Sets the number of valid positions for the following predictions.
+     * Back-ends with dynamic batch support only evaluate these positions, all others always evaluate the full batch.
+     * @param value Number of positions, will be clipped to [1, batchSize]
+     */
+    void set_number_positions(unsigned int value);
+
+    /**
+     * @brief get_nn_design Returns the input and output description of the loaded neural network
+     * @return NeuralNetDesign
+     */
+    const nn_api::NeuralNetDesign& get_nn_design() const;
+
     /**
      * @brief initialize Initializes the neural net api using the template method pattern
      */
@@ -308,6 +425,22 @@ protected:
      * @brief initialize_nn_design Template method pattern which calls init_nn_design() and does post processing
      */
     void initialize_nn_design();
+
+    /**
+     * @brief enable_host_policy_gather Enables copy_policy_outputs() to gather the legal entries if the policy output is larger than POLICY_GATHER_STRIDE.
+     * Must be called after initialize().
+     */
+    void enable_host_policy_gather();
+
+    /**
+     * @brief copy_policy_outputs Copies the policy logits of the back-end output buffer into probOutputs and applies the softmax.
+     * If policy indices have been set by set_policy_gather(), only the legal entries are written in rows of POLICY_GATHER_STRIDE values.
+     * The policy indices are reset afterwards.
+     * @param policyOutput Output buffer of the back-end
+     * @param probOutputs Policy output of the prediction
+     * @param numberRows Number of rows to copy
+     */
+    void copy_policy_outputs(const float* policyOutput, float* probOutputs, size_t numberRows);
 };
 
 /**
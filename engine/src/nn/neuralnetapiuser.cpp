@@ -25,19 +25,88 @@
 
 #include "neuralnetapiuser.h"
 #include "stateobj.h"
-#ifdef TENSORRT
-#include "NvInfer.h"
-#include <cuda_runtime_api.h>
-#include "common.h"
+#include <algorithm>
+#include "../util/tracerecorder.h"
+#include "../util/metrics.h"
+#include "../util/memorystats.h"
+
+/**
+ * @brief get_nb_auxiliary_values Returns the number of auxiliary output values of a single position
+ */
+static size_t get_nb_auxiliary_values(const NeuralNetAPI* net)
+{
+#ifdef DYNAMIC_NN_ARCH
+    return net->has_auxiliary_outputs() ? net->get_nb_auxiliary_outputs() : 0;
+#else
+    return StateConstants::NB_AUXILIARY_OUTPUTS();
+#endif
+}
+
+/**
+ * @brief get_buffers_memory_size Returns the number of bytes of the host buffers of allocate_buffers()
+ */
+static int64_t get_buffers_memory_size(const NeuralNetAPI* net, bool useAuxiliaryOutputs)
+{
+    const size_t nbAuxiliaryValues = useAuxiliaryOutputs ? get_nb_auxiliary_values(net) : 0;
+    return int64_t(net->get_batch_size() * (net->get_nb_input_values_total() + 1 + net->get_nb_policy_values() + nbAuxiliaryValues) * sizeof(float));
+}
+
+void allocate_buffers(NeuralNetAPI* net, float*& inputPlanes, float*& valueOutputs, float*& probOutputs, float*& auxiliaryOutputs, bool useAuxiliaryOutputs)
+{
+    memory_stats().add(MEMORY_BATCH_BUFFERS, get_buffers_memory_size(net, useAuxiliaryOutputs));
+    inputPlanes = net->allocate_host_buffer(net->get_batch_size() * net->get_nb_input_values_total());
+    valueOutputs = net->allocate_host_buffer(net->get_batch_size());
+    probOutputs = net->allocate_host_buffer(net->get_batch_size() * net->get_nb_policy_values());
+    if (!useAuxiliaryOutputs) {
+        return;
+    }
+#ifdef DYNAMIC_NN_ARCH
+    if (net->has_auxiliary_outputs()) {
+        auxiliaryOutputs = net->allocate_host_buffer(net->get_batch_size() * net->get_nb_auxiliary_outputs());
+    }
+#else
+    if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
+        auxiliaryOutputs = net->allocate_host_buffer(net->get_batch_size() * StateConstants::NB_AUXILIARY_OUTPUTS());
+    }
 #endif
+}
+
+void free_buffers(NeuralNetAPI* net, float* inputPlanes, float* valueOutputs, float* probOutputs, float* auxiliaryOutputs)
+{
+    memory_stats().add(MEMORY_BATCH_BUFFERS, -get_buffers_memory_size(net, auxiliaryOutputs != nullptr));
+    net->free_host_buffer(inputPlanes);
+    net->free_host_buffer(valueOutputs);
+    net->free_host_buffer(probOutputs);
+    if (auxiliaryOutputs != nullptr) {
+        net->free_host_buffer(auxiliaryOutputs);
+    }
+}
 
-NeuralNetAPIUser::NeuralNetAPIUser(const vector<unique_ptr<NeuralNetAPI>>& netsNew) :
-    auxiliaryOutputs(nullptr)
+NeuralNetAPIUser::NeuralNetAPIUser(const vector<unique_ptr<NeuralNetAPI>>& netsNew, bool doubleBuffering, bool useAuxiliaryOutputs, bool hasFastNet) :
+    fastNetIndex(NO_FAST_NET),
+    auxiliaryOutputs(nullptr),
+    doubleBuffering(doubleBuffering),
+    pendingInputPlanes(nullptr),
+    pendingValueOutputs(nullptr),
+    pendingProbOutputs(nullptr),
+    pendingAuxiliaryOutputs(nullptr),
+    policyGatherValid(false),
+    pendingPolicyGatherValid(false),
+    isSplitBatch(false),
+    splitValueOutputs(nullptr),
+    splitProbOutputs(nullptr),
+    splitAuxiliaryOutputs(nullptr),
+    lastLatencyUS(0)
 {
     for (size_t idx = 0; idx < netsNew.size(); idx++) {
         nets.push_back(netsNew[idx].get());
     }
     numPhases = nets.size();
+    if (hasFastNet && nets.size() > 1) {
+        // the fast network isn't assigned to a game phase
+        --numPhases;
+        fastNetIndex = uint8_t(numPhases);
+    }
     for (unsigned int i = 0; i < numPhases; i++)
     {
         GamePhase phaseOfNetI = nets[i]->get_game_phase();
@@ -47,58 +116,141 @@ NeuralNetAPIUser::NeuralNetAPIUser(const vector<unique_ptr<NeuralNetAPI>>& netsN
     }
     
     // allocate memory for all predictions and results
-#ifdef TENSORRT
-#ifdef DYNAMIC_NN_ARCH
-    CHECK(cudaMallocHost((void**) &inputPlanes, nets.front()->get_batch_size() * nets.front()->get_nb_input_values_total() * sizeof(float)));
-#else
-     CHECK(cudaMallocHost((void**) &inputPlanes, nets.front()->get_batch_size() * StateConstants::NB_VALUES_TOTAL() * sizeof(float)));
-#endif
-    CHECK(cudaMallocHost((void**) &valueOutputs, nets.front()->get_batch_size() * sizeof(float)));
-    CHECK(cudaMallocHost((void**) &probOutputs, nets.front()->get_batch_size() * nets.front()->get_nb_policy_values() * sizeof(float)));
-    if (nets.front()->has_auxiliary_outputs()) {
-        CHECK(cudaMallocHost((void**) &auxiliaryOutputs, nets.front()->get_batch_size() * nets.front()->get_nb_auxiliary_outputs() * sizeof(float)));
+    allocate_buffers(nets.front(), inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs, useAuxiliaryOutputs);
+    if (doubleBuffering) {
+        allocate_buffers(nets.front(), pendingInputPlanes, pendingValueOutputs, pendingProbOutputs, pendingAuxiliaryOutputs, useAuxiliaryOutputs);
     }
-#else
-    inputPlanes = new float[nets.front()->get_batch_size() * nets.front()->get_nb_input_values_total()];
-    valueOutputs = new float[nets.front()->get_batch_size()];
-    probOutputs = new float[nets.front()->get_batch_size() * nets.front()->get_nb_policy_values()];
-#ifdef DYNAMIC_NN_ARCH
-    if (nets.front()->has_auxiliary_outputs()) {
-        auxiliaryOutputs = new float[nets.front()->get_batch_size() * nets.front()->get_nb_auxiliary_outputs()];
+    if (nets.front()->supports_policy_gather()) {
+        policyIndices.resize(nets.front()->get_batch_size() * POLICY_GATHER_STRIDE);
+        policyIndexCounts.resize(nets.front()->get_batch_size());
+        if (doubleBuffering) {
+            pendingPolicyIndices.resize(policyIndices.size());
+            pendingPolicyIndexCounts.resize(policyIndexCounts.size());
+        }
     }
-#else
-    if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
-         auxiliaryOutputs = new float[nets.front()->get_batch_size() * StateConstants::NB_AUXILIARY_OUTPUTS()];
+    phaseSlots.resize(nets.size());
+    if (nets.size() > 1) {
+        phaseInputPlanes.resize(nets.size(), nullptr);
+        phaseValueOutputs.resize(nets.size(), nullptr);
+        phaseProbOutputs.resize(nets.size(), nullptr);
+        phaseAuxiliaryOutputs.resize(nets.size(), nullptr);
+        for (size_t idx = 0; idx < nets.size(); ++idx) {
+            allocate_buffers(nets[idx], phaseInputPlanes[idx], phaseValueOutputs[idx], phaseProbOutputs[idx], phaseAuxiliaryOutputs[idx], useAuxiliaryOutputs);
+        }
     }
-#endif
-#endif
 }
 
 NeuralNetAPIUser::~NeuralNetAPIUser()
 {
-#ifdef TENSORRT
-    CHECK(cudaFreeHost(inputPlanes));
-    CHECK(cudaFreeHost(valueOutputs));
-    CHECK(cudaFreeHost(probOutputs));
-#ifdef DYNAMIC_NN_ARCH
-    if (nets.front()->has_auxiliary_outputs()) {
-#else
-    if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
-#endif
-        CHECK(cudaFreeHost(auxiliaryOutputs));
+    free_buffers(nets.front(), inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+    if (doubleBuffering) {
+        free_buffers(nets.front(), pendingInputPlanes, pendingValueOutputs, pendingProbOutputs, pendingAuxiliaryOutputs);
     }
-#else
-    delete [] inputPlanes;
-    delete [] valueOutputs;
-    delete [] probOutputs;
-#ifdef DYNAMIC_NN_ARCH
-    if (nets.front()->has_auxiliary_outputs()) {
-#else
-    if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
-#endif
-        delete [] auxiliaryOutputs;
+    for (size_t idx = 0; idx < phaseInputPlanes.size(); ++idx) {
+        free_buffers(nets[idx], phaseInputPlanes[idx], phaseValueOutputs[idx], phaseProbOutputs[idx], phaseAuxiliaryOutputs[idx]);
     }
-#endif
+}
+
+void NeuralNetAPIUser::predict_phases_async(float* batchInputPlanes, float* batchValueOutputs, float* batchProbOutputs, float* batchAuxiliaryOutputs,
+                                            const uint8_t* slotNetIndices, size_t numberSlots, bool& gatherValid, const uint32_t* gatherIndices, const uint32_t* gatherCounts)
+{
+    TRACE_SCOPE("predict_async");
+    predictStart = std::chrono::steady_clock::now();
+    metrics().add(METRIC_NN_BATCHES, 1);
+    metrics().add(METRIC_NN_POSITIONS, numberSlots);
+    metrics().add(METRIC_NN_BATCH_CAPACITY, nets.front()->get_batch_size());
+    activeNets.clear();
+    isSplitBatch = false;
+    size_t netIdx = 0;
+    if (nets.size() > 1) {
+        for (vector<uint32_t>& slots : phaseSlots) {
+            slots.clear();
+        }
+        for (uint32_t slot = 0; slot < numberSlots; ++slot) {
+            phaseSlots[slotNetIndices[slot]].emplace_back(slot);
+        }
+        isSplitBatch = std::count_if(phaseSlots.begin(), phaseSlots.end(), [](const vector<uint32_t>& slots) { return !slots.empty(); }) > 1;
+        netIdx = slotNetIndices[0];
+    }
+
+    if (!isSplitBatch) {
+        nets[netIdx]->set_number_positions(numberSlots);
+        if (gatherValid) {
+            nets[netIdx]->set_policy_gather(gatherIndices, gatherCounts);
+        }
+        nets[netIdx]->predict_async(batchInputPlanes, batchValueOutputs, batchProbOutputs, batchAuxiliaryOutputs);
+        activeNets.emplace_back(netIdx);
+        return;
+    }
+
+    // the gathered policy indices are stored by row of the full mini-batch
+    gatherValid = false;
+    splitValueOutputs = batchValueOutputs;
+    splitProbOutputs = batchProbOutputs;
+    splitAuxiliaryOutputs = batchAuxiliaryOutputs;
+    const size_t nbInputValues = nets.front()->get_nb_input_values_total();
+    for (netIdx = 0; netIdx < nets.size(); ++netIdx) {
+        const vector<uint32_t>& slots = phaseSlots[netIdx];
+        if (slots.empty()) {
+            continue;
+        }
+        for (size_t idx = 0; idx < slots.size(); ++idx) {
+            std::copy(batchInputPlanes + slots[idx] * nbInputValues, batchInputPlanes + (slots[idx] + 1) * nbInputValues,
+                      phaseInputPlanes[netIdx] + idx * nbInputValues);
+        }
+        nets[netIdx]->set_number_positions(slots.size());
+        nets[netIdx]->predict_async(phaseInputPlanes[netIdx], phaseValueOutputs[netIdx], phaseProbOutputs[netIdx], phaseAuxiliaryOutputs[netIdx]);
+        activeNets.emplace_back(netIdx);
+    }
+}
+
+void NeuralNetAPIUser::wait_phases()
+{
+    TRACE_SCOPE("wait_predict");
+    const size_t nbPolicyValues = nets.front()->get_nb_policy_values();
+    const size_t nbAuxiliaryValues = get_nb_auxiliary_values(nets.front());
+    for (size_t netIdx : activeNets) {
+        nets[netIdx]->wait();
+        if (!isSplitBatch) {
+            continue;
+        }
+        const vector<uint32_t>& slots = phaseSlots[netIdx];
+        for (size_t idx = 0; idx < slots.size(); ++idx) {
+            const size_t slot = slots[idx];
+            splitValueOutputs[slot] = phaseValueOutputs[netIdx][idx];
+            std::copy(phaseProbOutputs[netIdx] + idx * nbPolicyValues, phaseProbOutputs[netIdx] + (idx + 1) * nbPolicyValues,
+                      splitProbOutputs + slot * nbPolicyValues);
+            if (splitAuxiliaryOutputs != nullptr && nbAuxiliaryValues != 0) {
+                std::copy(phaseAuxiliaryOutputs[netIdx] + idx * nbAuxiliaryValues, phaseAuxiliaryOutputs[netIdx] + (idx + 1) * nbAuxiliaryValues,
+                          splitAuxiliaryOutputs + slot * nbAuxiliaryValues);
+            }
+        }
+    }
+    activeNets.clear();
+    lastLatencyUS = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - predictStart).count();
+    metrics().observe_nn_latency(lastLatencyUS);
+}
+
+size_t NeuralNetAPIUser::get_phase_net_index(GamePhase phase) const
+{
+    const size_t netIdx = phaseToNetsIndex.at(phase);
+    if (nets[netIdx]->is_loaded()) {
+        return netIdx;
+    }
+    for (GamePhase distance = 1; distance < numPhases; ++distance) {
+        if (phase >= distance) {
+            auto it = phaseToNetsIndex.find(phase - distance);
+            if (it != phaseToNetsIndex.end() && nets[it->second]->is_loaded()) {
+                return it->second;
+            }
+        }
+        auto it = phaseToNetsIndex.find(phase + distance);
+        if (it != phaseToNetsIndex.end() && nets[it->second]->is_loaded()) {
+            return it->second;
+        }
+    }
+    // the first network is always loaded
+    return 0;
 }
 
 void NeuralNetAPIUser::run_inference(uint_fast16_t iterations)
@@ -108,6 +260,18 @@ void NeuralNetAPIUser::run_inference(uint_fast16_t iterations)
     }
 }
 
+void NeuralNetAPIUser::swap_buffers()
+{
+    assert(doubleBuffering);
+    std::swap(inputPlanes, pendingInputPlanes);
+    std::swap(valueOutputs, pendingValueOutputs);
+    std::swap(probOutputs, pendingProbOutputs);
+    std::swap(auxiliaryOutputs, pendingAuxiliaryOutputs);
+    std::swap(policyIndices, pendingPolicyIndices);
+    std::swap(policyIndexCounts, pendingPolicyIndexCounts);
+    std::swap(policyGatherValid, pendingPolicyGatherValid);
+}
+
 unsigned int NeuralNetAPIUser::get_num_phases() const
 {
     return numPhases;
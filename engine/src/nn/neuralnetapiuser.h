@@ -29,6 +29,20 @@
 #define NEURALNETAPIUSER_H
 
 #include "neuralnetapi.h"
+#include <chrono>
+
+/**
+ * @brief allocate_buffers Allocates the memory for the input planes and all network outputs of a single mini-batch
+ * @param useAuxiliaryOutputs If false, auxiliaryOutputs stays a nullptr and the back-ends skip the transfer of the auxiliary outputs
+ */
+void allocate_buffers(NeuralNetAPI* net, float*& inputPlanes, float*& valueOutputs, float*& probOutputs, float*& auxiliaryOutputs, bool useAuxiliaryOutputs=true);
+
+/**
+ * @brief free_buffers Releases the memory which has been allocated by allocate_buffers()
+ */
+void free_buffers(NeuralNetAPI* net, float* inputPlanes, float* valueOutputs, float* probOutputs, float* auxiliaryOutputs);
+
+const uint8_t NO_FAST_NET = uint8_t(-1);
 
 /**
  * @brief The NeuralNetAPIUser class is a utility class which handles memory allocation and de-allocation.
@@ -40,6 +54,8 @@ protected:
     vector<NeuralNetAPI*> nets; // vector of net objects
     unsigned int numPhases;
     std::map<GamePhase, int> phaseToNetsIndex;  // maps a GamePhase to the index of the net that should be used
+    // index of the fast network which evaluates the new leaves of the two-tier evaluation behind the phase networks (NO_FAST_NET if unused)
+    uint8_t fastNetIndex;
 
     // inputPlanes stores the plane representation of all newly expanded nodes of a single mini-batch
     float* inputPlanes;
@@ -49,8 +65,85 @@ protected:
     float* probOutputs;
     float* auxiliaryOutputs;
 
+    // second buffer set which is used for the mini-batch in flight, only allocated if doubleBuffering is true
+    bool doubleBuffering;
+    float* pendingInputPlanes;
+    float* pendingValueOutputs;
+    float* pendingProbOutputs;
+    float* pendingAuxiliaryOutputs;
+
+    // policy indices of the legal moves (POLICY_GATHER_STRIDE per position) and their number for each position of the mini-batch,
+    // only used if the network supports policy gathering
+    vector<uint32_t> policyIndices;
+    vector<uint32_t> policyIndexCounts;
+    // false if a position of the mini-batch has more legal moves than POLICY_GATHER_STRIDE
+    bool policyGatherValid;
+    vector<uint32_t> pendingPolicyIndices;
+    vector<uint32_t> pendingPolicyIndexCounts;
+    bool pendingPolicyGatherValid;
+
+    // contiguous input and output buffers for each network, only allocated if several game phases are used
+    vector<float*> phaseInputPlanes;
+    vector<float*> phaseValueOutputs;
+    vector<float*> phaseProbOutputs;
+    vector<float*> phaseAuxiliaryOutputs;
+    // rows of the mini-batch in flight for each network and the networks which are currently running
+    vector<vector<uint32_t>> phaseSlots;
+    vector<size_t> activeNets;
+    // output buffers of the mini-batch in flight which receive the results of the partitions
+    bool isSplitBatch;
+    float* splitValueOutputs;
+    float* splitProbOutputs;
+    float* splitAuxiliaryOutputs;
+    // launch time of the mini-batch in flight for the latency metric
+    std::chrono::steady_clock::time_point predictStart;
+    // latency of the last finished mini-batch in microseconds
+    uint64_t lastLatencyUS;
+
+    /**
+     * @brief swap_buffers Exchanges the current buffer set with the pending buffer set (requires doubleBuffering)
+     */
+    void swap_buffers();
+
+    /**
+     * @brief predict_phases_async Starts the inference of a mini-batch. If the mini-batch contains positions of several game phases,
+     * it is partitioned and each partition is sent to the network of its phase. The partitions run concurrently.
+     * @param batchInputPlanes Input planes of the mini-batch
+     * @param batchValueOutputs Value output buffer of the mini-batch
+     * @param batchProbOutputs Policy output buffer of the mini-batch
+     * @param batchAuxiliaryOutputs Auxiliary output buffer of the mini-batch
+     * @param slotNetIndices Network index of each row
+     * @param numberSlots Number of rows
+     * @param gatherValid True if only the policy entries of the legal moves are requested, it is reset if the mini-batch is split
+     * @param gatherIndices Policy indices of the legal moves for each row
+     * @param gatherCounts Number of legal moves for each row
+     */
+    void predict_phases_async(float* batchInputPlanes, float* batchValueOutputs, float* batchProbOutputs, float* batchAuxiliaryOutputs,
+                              const uint8_t* slotNetIndices, size_t numberSlots, bool& gatherValid, const uint32_t* gatherIndices, const uint32_t* gatherCounts);
+
+    /**
+     * @brief wait_phases Waits for the networks which were started by predict_phases_async() and merges the results of the partitions
+     * back into the rows of the mini-batch
+     */
+    void wait_phases();
+
+    /**
+     * @brief get_phase_net_index Returns the index of the network of the given game phase.
+     * If this network is still being loaded (see DeferredNetAPI), the network of the nearest loaded phase is returned, the earlier phase on ties.
+     * @param phase Game phase
+     * @return Index in nets
+     */
+    size_t get_phase_net_index(GamePhase phase) const;
+
 public:
-    NeuralNetAPIUser(const vector<unique_ptr<NeuralNetAPI>>& netsNew);
+    /**
+     * @brief NeuralNetAPIUser
+     * @param netsNew Neural network objects
+     * @param doubleBuffering If true, a second set of input and output buffers is allocated for asynchronous inference
+     * @param useAuxiliaryOutputs False if the auxiliary outputs of the network are never consumed
+     * @param hasFastNet True if the last network is the fast network of the two-tier evaluation and not a phase network
+     */
+    NeuralNetAPIUser(const vector<unique_ptr<NeuralNetAPI>>& netsNew, bool doubleBuffering=false, bool useAuxiliaryOutputs=true, bool hasFastNet=false);
     ~NeuralNetAPIUser();
     NeuralNetAPIUser(NeuralNetAPIUser&) = delete;
 
@@ -0,0 +1,127 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: nullapi.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "nullapi.h"
+#include <cstring>
+#include <thread>
+#include "stateobj.h"
+#include "../util/randomgen.h"
+
+NullAPI::NullAPI(unsigned int batchSize, size_t latencyUS, uint64_t seed):
+    NeuralNetAPI("null", 0, batchSize, "null/", false),
+    latency(latencyUS),
+    seed(seed)
+{
+    initialize();
+}
+
+void NullAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+    wait();
+}
+
+void NullAPI::predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    launchTime = std::chrono::steady_clock::now();
+    fill_outputs(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+}
+
+void NullAPI::wait()
+{
+    // the search thread can prepare the next batch in the meantime, like with an asynchronous device
+    if (latency.count() != 0) {
+        std::this_thread::sleep_until(launchTime + latency);
+    }
+}
+
+void NullAPI::fill_outputs(const float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) const
+{
+    for (size_t batchIdx = 0; batchIdx < numberPositions; ++batchIdx) {
+        FastRandom random(hash_input_planes(inputPlanes + batchIdx * nbNNInputValues, nbNNInputValues, seed));
+        valueOutput[batchIdx] = random.uniform() * 2 - 1;
+        float* policy = probOutputs + batchIdx * nbPolicyValues;
+        float sum = 0;
+        for (size_t idx = 0; idx < nbPolicyValues; ++idx) {
+            policy[idx] = random.uniform() + 1e-3f;
+            sum += policy[idx];
+        }
+        for (size_t idx = 0; idx < nbPolicyValues; ++idx) {
+            policy[idx] /= sum;
+        }
+        if (nbNNAuxiliaryOutputs != 0 && auxiliaryOutputs != nullptr) {
+            std::fill_n(auxiliaryOutputs + batchIdx * nbNNAuxiliaryOutputs, nbNNAuxiliaryOutputs, 0.0f);
+        }
+    }
+}
+
+void NullAPI::load_model()
+{
+    // the name carries the current input representation which is parsed by initialize_nn_design()
+    const Version version = StateConstants::CURRENT_VERSION();
+    modelName = "null-v" + std::to_string(version::get_major(version)) + "." + std::to_string(version::get_minor(version));
+}
+
+void NullAPI::load_parameters()
+{
+    // there are no parameters
+}
+
+void NullAPI::bind_executor()
+{
+    // there is no executor
+}
+
+void NullAPI::init_nn_design()
+{
+    nnDesign.isPolicyMap = false;
+    nnDesign.inputShape.nbDims = 4;
+    nnDesign.inputShape.v[0] = batchSize;
+    nnDesign.inputShape.v[1] = StateConstants::NB_CHANNELS_TOTAL();
+    nnDesign.inputShape.v[2] = StateConstants::BOARD_HEIGHT();
+    nnDesign.inputShape.v[3] = StateConstants::BOARD_WIDTH();
+    nnDesign.valueOutputShape.nbDims = 2;
+    nnDesign.valueOutputShape.v[0] = batchSize;
+    nnDesign.valueOutputShape.v[1] = 1;
+    nnDesign.policyOutputShape.nbDims = 2;
+    nnDesign.policyOutputShape.v[0] = batchSize;
+    nnDesign.policyOutputShape.v[1] = StateConstants::NB_LABELS();
+    nnDesign.hasAuxiliaryOutputs = StateConstants::NB_AUXILIARY_OUTPUTS() != 0;
+    nnDesign.auxiliaryOutputShape.nbDims = 2;
+    nnDesign.auxiliaryOutputShape.v[0] = batchSize;
+    nnDesign.auxiliaryOutputShape.v[1] = StateConstants::NB_AUXILIARY_OUTPUTS();
+}
+
+uint64_t hash_input_planes(const float* inputPlanes, size_t numberValues, uint64_t seed)
+{
+    uint64_t hash = 14695981039346656037ULL ^ seed;
+    for (size_t idx = 0; idx < numberValues; ++idx) {
+        uint32_t bits;
+        std::memcpy(&bits, inputPlanes + idx, sizeof(bits));
+        hash = (hash ^ bits) * 1099511628211ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,81 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: nullapi.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Back-end without a neural network for measuring the CPU side of the search (selection, input encoding, backup).
+ * It returns pseudo-random values and policies which only depend on the input planes, so that repeated runs
+ * visit the same tree, and optionally delays the results by a simulated inference latency.
+ */
+
+#ifndef NULLAPI_H
+#define NULLAPI_H
+
+#include "neuralnetapi.h"
+#include <chrono>
+
+/**
+ * @brief The NullAPI class implements a NeuralNetAPI which doesn't load a model and answers instantly or after a fixed latency
+ */
+class NullAPI : public NeuralNetAPI
+{
+private:
+    // simulated time between the launch of a batch and the availability of its results
+    std::chrono::microseconds latency;
+    std::chrono::steady_clock::time_point launchTime;
+    uint64_t seed;
+
+public:
+    /**
+     * @brief NullAPI
+     * @param batchSize Constant batch size which is used for inference
+     * @param latencyUS Simulated inference latency in microseconds (0 for instant results)
+     * @param seed Seed which is mixed into the hash of the input planes
+     */
+    NullAPI(unsigned int batchSize, size_t latencyUS=0, uint64_t seed=0);
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void wait() override;
+
+private:
+    /**
+     * @brief fill_outputs Writes the pseudo-random outputs of all used batch entries
+     */
+    void fill_outputs(const float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) const;
+
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+};
+
+/**
+ * @brief hash_input_planes Returns a 64-bit FNV-1a hash of the bit patterns of the given input values
+ * @param inputPlanes Input planes of a single position
+ * @param numberValues Number of input values
+ * @param seed Initial value which is mixed into the hash
+ */
+uint64_t hash_input_planes(const float* inputPlanes, size_t numberValues, uint64_t seed);
+
+#endif // NULLAPI_H
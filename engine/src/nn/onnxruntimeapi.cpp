@@ -0,0 +1,210 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: onnxruntimeapi.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#ifdef ONNXRUNTIME
+#include "onnxruntimeapi.h"
+#include "stateobj.h"
+#ifdef _WIN32
+#include <dml_provider_factory.h>
+#endif
+
+namespace {
+Ort::Env& get_env()
+{
+    static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "CrazyAra");
+    return env;
+}
+
+// ONNX Runtime expects wide character paths on Windows
+std::basic_string<ORTCHAR_T> to_ort_path(const string& path)
+{
+    return std::basic_string<ORTCHAR_T>(path.begin(), path.end());
+}
+}
+
+OnnxRuntimeAPI::OnnxRuntimeAPI(int deviceID, unsigned int batchSize, const string& modelDirectory, const string& executionProvider,
+                               const string& precision, const string& cacheDirectory, size_t threadsNNInference):
+    NeuralNetAPI(executionProvider == "cpu" ? "cpu" : "gpu", deviceID, batchSize, modelDirectory, false),
+    executionProvider(executionProvider),
+    precision(precision),
+    cacheDirectory(cacheDirectory == "" ? modelDir : parse_directory(cacheDirectory)),
+    threadsNNInference(threadsNNInference),
+    valueOutputIdx(nnDesign.valueOutputIdx),
+    policyOutputIdx(nnDesign.policyOutputIdx),
+    auxiliaryOutputIdx(nnDesign.auxiliaryOutputIdx)
+{
+    modelName = get_onnx_model_name(modelDir, batchSize);
+    modelFilePath = modelDir + modelName;
+    initialize();
+    enable_host_policy_gather();
+}
+
+string OnnxRuntimeAPI::get_optimized_model_path() const
+{
+    return cacheDirectory + modelName.substr(0, modelName.size() - string(".onnx").size()) + "-ort-" + executionProvider + ".onnx";
+}
+
+void OnnxRuntimeAPI::append_execution_provider(Ort::SessionOptions& sessionOptions)
+{
+    if (executionProvider == "cpu") {
+        sessionOptions.SetIntraOpNumThreads(int(threadsNNInference));
+        return;
+    }
+    if (executionProvider == "tensorrt") {
+        // the TensorRT engines are cached by the execution provider itself
+        const OrtApi& api = Ort::GetApi();
+        OrtTensorRTProviderOptionsV2* tensorrtOptions = nullptr;
+        Ort::ThrowOnError(api.CreateTensorRTProviderOptions(&tensorrtOptions));
+        const string deviceIdString = to_string(deviceID);
+        const vector<const char*> keys = {"device_id", "trt_fp16_enable", "trt_engine_cache_enable", "trt_engine_cache_path"};
+        const vector<const char*> values = {deviceIdString.c_str(), precision == "float16" ? "1" : "0", "1", cacheDirectory.c_str()};
+        Ort::ThrowOnError(api.UpdateTensorRTProviderOptions(tensorrtOptions, keys.data(), values.data(), keys.size()));
+        sessionOptions.AppendExecutionProvider_TensorRT_V2(*tensorrtOptions);
+        api.ReleaseTensorRTProviderOptions(tensorrtOptions);
+    }
+    if (executionProvider == "cuda" || executionProvider == "tensorrt") {
+        // CUDA runs the nodes which aren't supported by TensorRT
+        OrtCUDAProviderOptions cudaOptions;
+        cudaOptions.device_id = deviceID;
+        sessionOptions.AppendExecutionProvider_CUDA(cudaOptions);
+        return;
+    }
+    if (executionProvider == "directml") {
+#ifdef _WIN32
+        // DirectML doesn't support memory patterns and parallel execution
+        sessionOptions.DisableMemPattern();
+        sessionOptions.SetExecutionMode(ORT_SEQUENTIAL);
+        Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_DML(sessionOptions, deviceID));
+        return;
+#else
+        throw invalid_argument("The DirectML execution provider is only available on Windows.");
+#endif
+    }
+    throw invalid_argument("Unknown execution provider: " + executionProvider);
+}
+
+void OnnxRuntimeAPI::load_model()
+{
+    Ort::SessionOptions sessionOptions;
+    append_execution_provider(sessionOptions);
+
+    string sessionModelPath = modelFilePath;
+    if (executionProvider == "tensorrt") {
+        // TensorRT optimises the original graph
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+    }
+    else if (file_exists(get_optimized_model_path())) {
+        info_string("load optimised graph from", get_optimized_model_path());
+        sessionModelPath = get_optimized_model_path();
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+    }
+    else {
+        info_string("optimise graph and save it to", get_optimized_model_path());
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        sessionOptions.SetOptimizedModelFilePath(to_ort_path(get_optimized_model_path()).c_str());
+    }
+    session = make_unique<Ort::Session>(get_env(), to_ort_path(sessionModelPath).c_str(), sessionOptions);
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    for (size_t idx = 0; idx < session->GetOutputCount(); ++idx) {
+        outputNames.emplace_back(session->GetOutputNameAllocated(idx, allocator).get());
+        if (outputNames.back() == nnDesign.valueOutputName) {
+            valueOutputIdx = int(idx);
+        }
+        else if (outputNames.back() == nnDesign.policyOutputName) {
+            policyOutputIdx = int(idx);
+        }
+        else if (outputNames.back() == nnDesign.auxiliaryOutputName) {
+            auxiliaryOutputIdx = int(idx);
+        }
+    }
+}
+
+void OnnxRuntimeAPI::load_parameters()
+{
+    // the parameters are loaded together with the session
+}
+
+void OnnxRuntimeAPI::init_nn_design()
+{
+    set_shape(nnDesign.inputShape, session->GetInputTypeInfo(nnDesign.inputIdx).GetTensorTypeAndShapeInfo().GetShape(), batchSize);
+    set_shape(nnDesign.valueOutputShape, session->GetOutputTypeInfo(valueOutputIdx).GetTensorTypeAndShapeInfo().GetShape(), batchSize);
+    set_shape(nnDesign.policyOutputShape, session->GetOutputTypeInfo(policyOutputIdx).GetTensorTypeAndShapeInfo().GetShape(), batchSize);
+    nnDesign.hasAuxiliaryOutputs = outputNames.size() > 2;
+    if (nnDesign.hasAuxiliaryOutputs) {
+        set_shape(nnDesign.auxiliaryOutputShape, session->GetOutputTypeInfo(auxiliaryOutputIdx).GetTensorTypeAndShapeInfo().GetShape(), batchSize);
+    }
+    nnDesign.isPolicyMap = unsigned(nnDesign.policyOutputShape.v[1]) != StateConstants::NB_LABELS();
+}
+
+void OnnxRuntimeAPI::bind_executor()
+{
+    inputData.resize(nnDesign.inputShape.flatten());
+    valueData.resize(nnDesign.valueOutputShape.flatten());
+    policyData.resize(nnDesign.policyOutputShape.flatten());
+    if (nnDesign.hasAuxiliaryOutputs) {
+        auxiliaryData.resize(nnDesign.auxiliaryOutputShape.flatten());
+    }
+
+    // the buffers are bound once and reused for all predictions, ONNX Runtime copies them from and to the device
+    const Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    auto create_tensor = [&memoryInfo](vector<float>& data, const nn_api::Shape& shape) {
+        const vector<int64_t> dims(shape.v, shape.v + shape.nbDims);
+        return Ort::Value::CreateTensor<float>(memoryInfo, data.data(), data.size(), dims.data(), dims.size());
+    };
+    Ort::AllocatorWithDefaultOptions allocator;
+    ioBinding = make_unique<Ort::IoBinding>(*session);
+    ioBinding->BindInput(session->GetInputNameAllocated(nnDesign.inputIdx, allocator).get(), create_tensor(inputData, nnDesign.inputShape));
+    ioBinding->BindOutput(outputNames[valueOutputIdx].c_str(), create_tensor(valueData, nnDesign.valueOutputShape));
+    ioBinding->BindOutput(outputNames[policyOutputIdx].c_str(), create_tensor(policyData, nnDesign.policyOutputShape));
+    if (nnDesign.hasAuxiliaryOutputs) {
+        ioBinding->BindOutput(outputNames[auxiliaryOutputIdx].c_str(), create_tensor(auxiliaryData, nnDesign.auxiliaryOutputShape));
+    }
+}
+
+void OnnxRuntimeAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    std::copy(inputPlanes, inputPlanes + numberPositions * get_nb_input_values_total(), inputData.begin());
+    session->Run(Ort::RunOptions{nullptr}, *ioBinding);
+
+    // copy the outputs to the given pointers
+    std::copy(valueData.begin(), valueData.begin() + numberPositions, valueOutput);
+    if (nnDesign.hasAuxiliaryOutputs && auxiliaryOutputs != nullptr) {
+        std::copy(auxiliaryData.begin(), auxiliaryData.begin() + numberPositions * get_nb_auxiliary_outputs(), auxiliaryOutputs);
+    }
+    // the onnx files contain the policy logits
+    copy_policy_outputs(policyData.data(), probOutputs, numberPositions);
+}
+
+void set_shape(nn_api::Shape& shape, const vector<int64_t>& dims, unsigned int batchSize)
+{
+    shape.nbDims = dims.size();
+    for (int idx = 0; idx < shape.nbDims; ++idx) {
+        shape.v[idx] = dims[idx] < 0 ? int(batchSize) : int(dims[idx]);
+    }
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: onnxruntimeapi.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * This file describes the ONNX Runtime interface for CrazyAra networks.
+ * It runs the same onnx files as the TensorRT backend on a configurable execution provider
+ * (CPU, CUDA, TensorRT or DirectML), which makes it usable on Windows and AMD GPUs as well.
+ * More information about ONNX Runtime can be found at:
+ * https://onnxruntime.ai/docs/api/c/
+ * https://onnxruntime.ai/docs/execution-providers/
+ */
+
+#ifndef ONNXRUNTIMEAPI_H
+#define ONNXRUNTIMEAPI_H
+
+#ifdef ONNXRUNTIME
+#include "neuralnetapi.h"
+#include <memory>
+#include <onnxruntime_cxx_api.h>
+
+/**
+ * @brief The OnnxRuntimeAPI class provides a compatible interface to use CrazyAra networks in the ONNX format using ONNX Runtime.
+ * The input and output buffers are allocated once and bound to the session via IO binding.
+ */
+class OnnxRuntimeAPI : public NeuralNetAPI
+{
+private:
+    unique_ptr<Ort::Session> session;
+    unique_ptr<Ort::IoBinding> ioBinding;
+    // "cpu", "cuda", "tensorrt" or "directml"
+    string executionProvider;
+    string precision;
+    string cacheDirectory;
+    size_t threadsNNInference;
+
+    vector<string> outputNames;
+    int valueOutputIdx;
+    int policyOutputIdx;
+    int auxiliaryOutputIdx;
+
+    vector<float> inputData;
+    vector<float> valueData;
+    vector<float> policyData;
+    vector<float> auxiliaryData;
+public:
+    /**
+     * @brief OnnxRuntimeAPI
+     * @param deviceID Device ID of the GPU (unused for the CPU)
+     * @param batchSize Batch size
+     * @param modelDirectory Directory which contains the onnx file
+     * @param executionProvider Execution provider: "cpu", "cuda", "tensorrt" or "directml" (Windows only)
+     * @param precision "float32" or "float16" (only used by the TensorRT execution provider)
+     * @param cacheDirectory Directory for the optimised graphs and the TensorRT engines. An empty string uses the model directory.
+     * @param threadsNNInference Number of CPU threads for the inference on the CPU
+     */
+    OnnxRuntimeAPI(int deviceID, unsigned int batchSize, const string& modelDirectory, const string& executionProvider,
+                   const string& precision, const string& cacheDirectory, size_t threadsNNInference);
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+
+private:
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+
+    /**
+     * @brief append_execution_provider Registers the configured execution provider in the session options
+     * @param sessionOptions Session options of the model
+     */
+    void append_execution_provider(Ort::SessionOptions& sessionOptions);
+
+    /**
+     * @brief get_optimized_model_path Returns the file path of the cached optimised graph for the configured execution provider
+     * @return string
+     */
+    string get_optimized_model_path() const;
+};
+
+/**
+ * @brief set_shape Converter function from the ONNX Runtime shape to nn_api::Shape. Dynamic dimensions are replaced by the batch size.
+ * @param shape Shape object to be set
+ * @param dims Dimensions of the tensor
+ * @param batchSize Batch size
+ */
+void set_shape(nn_api::Shape& shape, const vector<int64_t>& dims, unsigned int batchSize);
+
+#endif
+
+#endif // ONNXRUNTIMEAPI_H
@@ -26,16 +26,114 @@
 #ifdef OPENVINO
 #include "openvinoapi.h"
 #include "stateobj.h"
+#include "enginecache.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <sstream>
 
+namespace {
+ov::Core& get_core()
+{
+    static ov::Core core;
+    return core;
+}
+
+/**
+ * @brief get_compiled_model Returns the compiled model for the given key and compiles it if no other instance holds it
+ * @param key Model file, device, batch size, number of streams and precision
+ * @param model Model which is compiled if necessary
+ * @param device OpenVINO device
+ * @param threadsNNInference Total number of inference threads
+ * @param numberStreams Number of execution streams
+ * @param precision Inference precision of the OpenVinoAPI
+ * @param cacheDirectory Directory of the compiled model cache (empty to disable it)
+ * @return Shared compiled model
+ */
+std::shared_ptr<ov::CompiledModel> get_compiled_model(const string& key, const std::shared_ptr<ov::Model>& model, const string& device, size_t threadsNNInference,
+                                                      size_t numberStreams, const string& precision, const string& cacheDirectory)
+{
+    static std::mutex mtx;
+    static std::map<string, std::weak_ptr<ov::CompiledModel>> compiledModels;
+    std::lock_guard<std::mutex> lock(mtx);
 
-OpenVinoAPI::OpenVinoAPI(int deviceID, unsigned int batchSize, const string &modelDirectory, size_t threadsNNInference):
-    NeuralNetAPI("cpu", deviceID, batchSize, modelDirectory, true),
+    std::shared_ptr<ov::CompiledModel> compiledModel = compiledModels[key].lock();
+    if (compiledModel == nullptr) {
+        ov::AnyMap config;
+        const string deviceFamily = get_device_family(device);
+        // the input and output types stay at float32, only the internal computation uses the inference precision
+        if (deviceFamily == "cpu") {
+            // the thread count is only supported by the CPU plugin
+            config.insert(ov::inference_num_threads(threadsNNInference));
+            config.insert(ov::hint::inference_precision(precision == "bfloat16" ? ov::element::bf16 : ov::element::f32));
+        }
+        else if (deviceFamily == "gpu") {
+            config.insert(ov::hint::inference_precision(precision == "float32" ? ov::element::f32 : ov::element::f16));
+        }
+        if (deviceFamily == "npu") {
+            // the NPU compiles a single static graph per model and executes its requests in order
+            config.insert(ov::hint::performance_mode(ov::hint::PerformanceMode::LATENCY));
+        }
+        else if (numberStreams > 1) {
+            info_string("OpenVINO streams:", numberStreams);
+            config.insert(ov::hint::performance_mode(ov::hint::PerformanceMode::THROUGHPUT));
+            config.insert(ov::num_streams(numberStreams));
+        }
+        if (!cacheDirectory.empty()) {
+            // the plugin loads a compiled model of the same configuration from this directory or stores the new one
+            config.insert(ov::cache_dir(cacheDirectory));
+        }
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        compiledModel = std::make_shared<ov::CompiledModel>(get_core().compile_model(model, device, config));
+        info_elapsed_time("OpenVINO compile time (" + device + "):", start, chrono::steady_clock::now());
+        compiledModels[key] = compiledModel;
+    }
+    return compiledModel;
+}
+}
+
+OpenVinoAPI::OpenVinoAPI(int deviceID, unsigned int batchSize, const string &modelDirectory, size_t threadsNNInference, size_t numberStreams,
+                         const string& precision, const string& device, const string& cacheDirectory):
+    NeuralNetAPI(get_device_family(device), deviceID, batchSize, modelDirectory, true),
     rawInputData(nullptr),
-    threadsNNInference(threadsNNInference)
+    threadsNNInference(threadsNNInference),
+    numberStreams(std::max(numberStreams, size_t(1))),
+    precision(precision),
+    device(device),
+    useHostTensors(false),
+    pendingValueOutput(nullptr),
+    pendingProbOutputs(nullptr)
 {
     modelName = get_onnx_model_name(modelDir, batchSize);
     modelFilePath = modelDir + "/" + modelName;
+    if (precision == "int8") {
+        const string int8ModelPath = get_int8_model_path();
+        if (file_exists(int8ModelPath)) {
+            modelFilePath = int8ModelPath;
+        }
+        else {
+            info_string_important("No quantised model found at", int8ModelPath, "-> fallback to float32. Run quantize_openvino.py to create it.");
+            this->precision = "float32";
+        }
+    }
+    if (cacheDirectory != "<none>") {
+        modelCacheDirectory = get_model_cache_directory(cacheDirectory.empty() ? modelDir : parse_directory(cacheDirectory));
+    }
     initialize();
+    enable_host_policy_gather();
+}
+
+string OpenVinoAPI::get_int8_model_path() const
+{
+    return modelDir + modelName.substr(0, modelName.size() - string(".onnx").size()) + "-int8.xml";
+}
+
+string OpenVinoAPI::get_model_cache_directory(const string& cacheDirectory) const
+{
+    stringstream description;
+    description << hex << hash_file(modelFilePath) << " " << device << " " << ov::get_openvino_version().buildNumber;
+    return cacheDirectory + "openvino-" + get_engine_key(description.str()) + "/";
 }
 
 void OpenVinoAPI::set_nn_value_policy_shape()
@@ -62,7 +160,7 @@ void OpenVinoAPI::init_nn_design()
 void OpenVinoAPI::load_model()
 {
     // load the model architecture
-    model = core.read_model(modelFilePath);
+    model = get_core().read_model(modelFilePath);
     // set the batch size
     if (model->is_dynamic()) {
         model->get_parameters()[nnDesign.inputIdx]->set_layout("NCHW");
@@ -72,14 +170,15 @@ void OpenVinoAPI::load_model()
 
 void OpenVinoAPI::load_parameters()
 {
-    // load the model to the device
-    compiledModel = core.compile_model(model, "CPU", ov::inference_num_threads(threadsNNInference));
+    // load the model to the device, the search threads share the compiled model and use one infer request each
+    compiledModel = get_compiled_model(modelFilePath + "-" + device + "-bsize-" + to_string(batchSize) + "-streams-" + to_string(numberStreams) + "-" + precision,
+                                       model, device, threadsNNInference, numberStreams, precision, modelCacheDirectory);
 }
 
 void OpenVinoAPI::bind_executor()
 {
     // create an infer request
-    inferRequest = compiledModel.create_infer_request();
+    inferRequest = compiledModel->create_infer_request();
 
     // allocate required objects before the actual inference
     ov::element::Type inputType = ov::element::f32;
@@ -87,18 +186,62 @@ void OpenVinoAPI::bind_executor()
                             unsigned(nnDesign.inputShape.v[2]),
                             unsigned(nnDesign.inputShape.v[3])};
 
-    inputTensor = ov::Tensor(inputType, inputShape);
+    if (get_device_family(device) != "cpu") {
+        useHostTensors = create_host_tensors(inputShape);
+    }
+    if (!useHostTensors) {
+        inputTensor = ov::Tensor(inputType, inputShape);
+        inferRequest.set_input_tensor(inputTensor);
+    }
     rawInputData = (float*)inputTensor.data();
-    inferRequest.set_input_tensor(inputTensor);
+}
+
+bool OpenVinoAPI::create_host_tensors(const ov::Shape& inputShape)
+{
+    try {
+        ov::RemoteContext context = compiledModel->get_context();
+        inputTensor = context.create_host_tensor(ov::element::f32, inputShape);
+        inferRequest.set_input_tensor(inputTensor);
+        // the outputs are written by the device into host memory which is read by wait()
+        for (size_t outputIdx = 0; outputIdx < compiledModel->outputs().size(); ++outputIdx) {
+            const ov::Output<const ov::Node>& output = compiledModel->output(outputIdx);
+            inferRequest.set_output_tensor(outputIdx, context.create_host_tensor(output.get_element_type(), output.get_shape()));
+        }
+    }
+    catch (const ov::Exception& e) {
+        info_string("OpenVINO host tensors aren't supported on", device + ", fallback to plain tensors:", e.what());
+        return false;
+    }
+    return true;
 }
 
 void OpenVinoAPI::predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs)
+{
+    predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+    wait();
+}
+
+void OpenVinoAPI::predict_async(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs)
 {
     // copy over the input planes into the raw data cotainer
     std::copy(inputPlanes, inputPlanes + batchSize * get_nb_input_values_total(), rawInputData);
 
-    // run the request synchronously
-    inferRequest.infer();
+    pendingValueOutput = valueOutput;
+    pendingProbOutputs = probOutputs;
+    // the request is executed on a free stream of the compiled model
+    inferRequest.start_async();
+}
+
+void OpenVinoAPI::wait()
+{
+    if (pendingValueOutput == nullptr) {
+        return;
+    }
+    inferRequest.wait();
+    float* valueOutput = pendingValueOutput;
+    float* probOutputs = pendingProbOutputs;
+    pendingValueOutput = nullptr;
+    pendingProbOutputs = nullptr;
 
     // process outputs
     const ov::Tensor& outputTensorValue = inferRequest.get_output_tensor(nnDesign.valueOutputIdx);
@@ -109,11 +252,32 @@ void OpenVinoAPI::predict(float *inputPlanes, float *valueOutput, float *probOut
 
     // copy the outputs to the given pointers
     std::copy(outputBufferValue, outputBufferValue + batchSize, valueOutput);
-    std::copy(outputBufferPolicy, outputBufferPolicy + get_policy_output_length(), probOutputs);
+    // gathered rows are only requested for the used positions
+    copy_policy_outputs(outputBufferPolicy, probOutputs, gatherIndices != nullptr ? numberPositions : batchSize);
+}
 
-    for (unsigned int batchIdx = 0; batchIdx < batchSize; ++batchIdx) {
-        apply_softmax(probOutputs + batchIdx * nnDesign.policyOutputShape.v[1], nnDesign.policyOutputShape.v[1]);
+string get_openvino_device(const string& context, int deviceID)
+{
+    if (context == "gpu") {
+        return "GPU." + to_string(deviceID);
+    }
+    if (context == "npu") {
+        return "NPU";
+    }
+    return "CPU";
+}
+
+string get_device_family(const string& device)
+{
+    // e.g. "GPU.1" or "GPU.0.1" for a tile of a GPU
+    const string type = device.substr(0, device.find('.'));
+    if (type == "CPU" || type == "GPU" || type == "NPU") {
+        string family = type;
+        std::transform(family.begin(), family.end(), family.begin(), ::tolower);
+        return family;
     }
+    // virtual devices like "AUTO" or "HETERO:GPU,CPU"
+    return "auto";
 }
 
 void set_shape(nn_api::Shape& shape, const InferenceEngine::SizeVector& sizeVector)
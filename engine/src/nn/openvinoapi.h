@@ -26,6 +26,10 @@
  * More information about OpenVino can be found at:
  * https://github.com/openvinotoolkit/openvino
  * https://docs.openvinotoolkit.org/latest/openvino_docs_IE_DG_Integrate_with_customer_application_new_API.html
+ *
+ * Besides the CPU, the model can be compiled for Intel GPUs/iGPUs ("GPU.<id>") and NPUs ("NPU").
+ * On these devices the input and output tensors are allocated by the remote context of the device in host memory
+ * which the device accesses directly (e.g. USM host memory of an iGPU), so the plugin doesn't stage them in extra copies.
  */
 
 #ifndef OPENVINOAPI_H
@@ -35,6 +39,7 @@
 #include "neuralnetapi.h"
 
 #include <ie_core.hpp>
+#include <memory>
 #include "openvino/openvino.hpp"
 
 
@@ -44,16 +49,47 @@
 class OpenVinoAPI : public NeuralNetAPI
 {
 private:
-    ov::Core core;
     std::shared_ptr<ov::Model> model;
-    ov::CompiledModel compiledModel;
+    // compiled model which is shared by all instances of the same model file and batch size
+    std::shared_ptr<ov::CompiledModel> compiledModel;
     ov::InferRequest inferRequest;
 
     ov::Tensor inputTensor;
     float* rawInputData;
     size_t threadsNNInference;
+    size_t numberStreams;
+    // "float32", "float16", "bfloat16" or "int8"
+    string precision;
+    // OpenVINO device name, e.g. "CPU", "GPU.0", "NPU" or "AUTO"
+    string device;
+    // true if the tensors of the request were allocated by the remote context of the device
+    bool useHostTensors;
+    // directory of the compiled models of this model file and device (empty if the cache is disabled)
+    string modelCacheDirectory;
+
+    // output buffers of the request which was started by predict_async()
+    float* pendingValueOutput;
+    float* pendingProbOutputs;
 public:
-    OpenVinoAPI(int deviceID, unsigned int batchSize, const string &modelDirectory, size_t threadsNNInference);
+    /**
+     * @brief OpenVinoAPI
+     * @param deviceID Device ID (unused for the CPU)
+     * @param batchSize Batch size
+     * @param modelDirectory Directory which contains the onnx file
+     * @param threadsNNInference Total number of CPU threads for the inference
+     * @param numberStreams Number of execution streams of the compiled model. For more than one stream, the infer requests of
+     * all instances are executed concurrently in throughput mode.
+     * @param precision Inference precision: "float32", "float16" (GPU), "bfloat16" (uses AMX on supported CPUs) or "int8".
+     * The GPU runs in float16 unless "float32" is requested, the NPU always uses its native precision.
+     * For "int8" the quantised IR "<model>-int8.xml" next to the onnx file is loaded which is created by
+     * DeepCrazyhouse/src/quanitzation/quantize_openvino.py.
+     * @param device OpenVINO device on which the model is compiled
+     * @param cacheDirectory Directory of the compiled model cache, "" for the model directory and "<none>" to disable the cache.
+     * The compiled models are stored in the sub directory get_model_cache_directory() which is keyed by the model file content and device,
+     * so the next start loads them instead of compiling the model again.
+     */
+    OpenVinoAPI(int deviceID, unsigned int batchSize, const string &modelDirectory, size_t threadsNNInference, size_t numberStreams=1,
+                const string& precision="float32", const string& device="CPU", const string& cacheDirectory="<none>");
 
     // NeuralNetAPI interface
 private:
@@ -64,8 +100,29 @@ private:
 
     // helper methods
     void set_nn_value_policy_shape();
+
+    /**
+     * @brief get_int8_model_path Returns the file path of the quantised IR for the current onnx file
+     * @return string
+     */
+    string get_int8_model_path() const;
+
+    /**
+     * @brief get_model_cache_directory Returns the cache sub directory for the current model file, device and OpenVINO version
+     * @param cacheDirectory Root directory of the cache (ending with '/')
+     * @return Directory path ending with '/'
+     */
+    string get_model_cache_directory(const string& cacheDirectory) const;
+
+    /**
+     * @brief create_host_tensors Replaces the input and output tensors of the request by tensors of the remote context of the device
+     * @return False if the device has no remote context (e.g. the CPU)
+     */
+    bool create_host_tensors(const ov::Shape& inputShape);
 public:
     void predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs) override;
+    void predict_async(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs) override;
+    void wait() override;
 };
 
 /**
@@ -75,6 +132,18 @@ public:
  */
 void set_shape(nn_api::Shape& shape, const InferenceEngine::SizeVector& sizeVector);
 
+/**
+ * @brief get_openvino_device Returns the OpenVINO device name for the given UCI context, e.g. "GPU.1" for "gpu" and device ID 1
+ * @param context "cpu", "gpu" or "npu"
+ * @param deviceID Device ID of the GPU
+ */
+string get_openvino_device(const string& context, int deviceID);
+
+/**
+ * @brief get_device_family Returns the lower case device type of an OpenVINO device name, e.g. "gpu" for "GPU.1"
+ */
+string get_device_family(const string& device);
+
 #endif
 
 #endif // OPENVINOAPI_H
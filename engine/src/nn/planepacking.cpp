@@ -0,0 +1,59 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: planepacking.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "planepacking.h"
+
+bool pack_planes(const float* planes, size_t numberPlanes, uint64_t* masks, float* values)
+{
+    for (size_t planeIdx = 0; planeIdx < numberPlanes; ++planeIdx) {
+        const float* plane = planes + planeIdx * PACKED_PLANE_SIZE;
+        uint64_t mask = 0;
+        float value = 0.0f;
+        for (size_t sq = 0; sq < PACKED_PLANE_SIZE; ++sq) {
+            if (plane[sq] != 0.0f) {
+                if (mask == 0) {
+                    value = plane[sq];
+                }
+                else if (plane[sq] != value) {
+                    return false;
+                }
+                mask |= uint64_t(1) << sq;
+            }
+        }
+        masks[planeIdx] = mask;
+        values[planeIdx] = value;
+    }
+    return true;
+}
+
+void unpack_planes(const uint64_t* masks, const float* values, float* planes, size_t numberPlanes)
+{
+    for (size_t planeIdx = 0; planeIdx < numberPlanes; ++planeIdx) {
+        float* plane = planes + planeIdx * PACKED_PLANE_SIZE;
+        for (size_t sq = 0; sq < PACKED_PLANE_SIZE; ++sq) {
+            plane[sq] = ((masks[planeIdx] >> sq) & 1) ? values[planeIdx] : 0.0f;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: planepacking.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Compact transfer format for the input planes of 8x8 boards.
+ * Every plane is described by a 64 bit mask of its non-zero squares and the value of these squares.
+ * This covers the binary piece planes as well as the constant feature planes and reduces the amount of data
+ * which is copied to the device from 256 to 12 bytes per plane. The planes are expanded again on the device.
+ */
+
+#ifndef PLANEPACKING_H
+#define PLANEPACKING_H
+
+#include <cstddef>
+#include <cstdint>
+
+// number of squares of a plane which can be packed into a single mask
+#define PACKED_PLANE_SIZE 64
+
+/**
+ * @brief pack_planes Converts the float planes into masks and values.
+ * Packing fails if a plane contains more than one distinct non-zero value (e.g. the attack planes of older input versions).
+ * @param planes Input planes, PACKED_PLANE_SIZE values for each plane
+ * @param numberPlanes Number of planes (batch size times number of channels)
+ * @param masks Output masks, one for each plane
+ * @param values Output values, one for each plane
+ * @return True on success, the outputs are undefined otherwise
+ */
+bool pack_planes(const float* planes, size_t numberPlanes, uint64_t* masks, float* values);
+
+/**
+ * @brief unpack_planes Expands packed planes into float planes on the host
+ * @param masks Masks, one for each plane
+ * @param values Values, one for each plane
+ * @param planes Output planes, PACKED_PLANE_SIZE values for each plane
+ * @param numberPlanes Number of planes
+ */
+void unpack_planes(const uint64_t* masks, const float* values, float* planes, size_t numberPlanes);
+
+#ifdef CUDA_KERNELS
+#include <cuda_runtime_api.h>
+
+/**
+ * @brief unpack_planes_on_device Expands packed planes into float planes on the device (implemented in planeunpack.cu)
+ * @param masks Device pointer to the masks
+ * @param values Device pointer to the values
+ * @param planes Device pointer to the output planes
+ * @param numberPlanes Number of planes
+ * @param stream Stream on which the kernel is launched
+ */
+void unpack_planes_on_device(const uint64_t* masks, const float* values, float* planes, size_t numberPlanes, cudaStream_t stream);
+#endif
+
+#endif // PLANEPACKING_H
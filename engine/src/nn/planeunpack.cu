@@ -0,0 +1,46 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: planeunpack.cu
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "planepacking.h"
+
+// each thread writes a single square
+__global__ void unpack_planes_kernel(const uint64_t* masks, const float* values, float* planes, size_t numberValues)
+{
+    const size_t idx = size_t(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (idx >= numberValues) {
+        return;
+    }
+    const size_t planeIdx = idx / PACKED_PLANE_SIZE;
+    const size_t sq = idx % PACKED_PLANE_SIZE;
+    planes[idx] = ((masks[planeIdx] >> sq) & 1) ? values[planeIdx] : 0.0f;
+}
+
+void unpack_planes_on_device(const uint64_t* masks, const float* values, float* planes, size_t numberPlanes, cudaStream_t stream)
+{
+    const size_t numberValues = numberPlanes * PACKED_PLANE_SIZE;
+    const unsigned int threadsPerBlock = 256;
+    const unsigned int numberBlocks = unsigned((numberValues + threadsPerBlock - 1) / threadsPerBlock);
+    unpack_planes_kernel<<<numberBlocks, threadsPerBlock, 0, stream>>>(masks, values, planes, numberValues);
+}
@@ -0,0 +1,56 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: policygather.cu
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "policygather.h"
+#include <cuda_fp16.h>
+
+// one block per row, the threads of a block iterate over the legal moves of the row
+template <typename T>
+__global__ void gather_policy_kernel(const T* policy, const uint32_t* indices, const uint32_t* counts, float* gathered,
+                                     size_t nbPolicyValues, size_t stride)
+{
+    const size_t row = blockIdx.x;
+    const uint32_t count = counts[row];
+    for (uint32_t k = threadIdx.x; k < count; k += blockDim.x) {
+        gathered[row * stride + k] = float(policy[row * nbPolicyValues + indices[row * stride + k]]);
+    }
+}
+
+void gather_policy_on_device(const void* policy, bool isHalf, const uint32_t* indices, const uint32_t* counts, float* gathered,
+                             size_t numberRows, size_t nbPolicyValues, size_t stride, cudaStream_t stream)
+{
+    if (numberRows == 0) {
+        return;
+    }
+    const unsigned int threadsPerBlock = 64;
+    if (isHalf) {
+        gather_policy_kernel<__half><<<unsigned(numberRows), threadsPerBlock, 0, stream>>>(static_cast<const __half*>(policy), indices, counts,
+                                                                                           gathered, nbPolicyValues, stride);
+    }
+    else {
+        gather_policy_kernel<float><<<unsigned(numberRows), threadsPerBlock, 0, stream>>>(static_cast<const float*>(policy), indices, counts,
+                                                                                          gathered, nbPolicyValues, stride);
+    }
+}
@@ -0,0 +1,55 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: policygather.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Device side selection of the policy entries of the legal moves.
+ * The search uploads the policy indices of the legal moves for each position and only these entries are copied back
+ * to the host in rows of POLICY_GATHER_STRIDE values instead of the full policy output.
+ */
+
+#ifndef POLICYGATHER_H
+#define POLICYGATHER_H
+
+#ifdef CUDA_KERNELS
+#include <cstddef>
+#include <cstdint>
+#include <cuda_runtime_api.h>
+
+/**
+ * @brief gather_policy_on_device Copies policy[row * nbPolicyValues + indices[row * stride + k]] to gathered[row * stride + k]
+ * for all k < counts[row]
+ * @param policy Device pointer to the policy output of the network
+ * @param isHalf True, if the policy output is stored in half precision
+ * @param indices Device pointer to the policy indices of the legal moves
+ * @param counts Device pointer to the number of legal moves of each row
+ * @param gathered Device pointer to the gathered float32 output
+ * @param numberRows Number of positions
+ * @param nbPolicyValues Number of policy values of a single position
+ * @param stride Row length of the indices and the gathered output
+ * @param stream Stream on which the kernel is launched
+ */
+void gather_policy_on_device(const void* policy, bool isHalf, const uint32_t* indices, const uint32_t* counts, float* gathered,
+                             size_t numberRows, size_t nbPolicyValues, size_t stride, cudaStream_t stream);
+#endif
+
+#endif // POLICYGATHER_H
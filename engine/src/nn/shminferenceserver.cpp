@@ -0,0 +1,439 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: shminferenceserver.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#ifdef __linux__
+#include "shminferenceserver.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "The futex words must be plain 32 bit integers");
+
+namespace {
+// the futex words are shared between processes, so the non private operations are used
+inline void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, const timespec* timeout)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<uint32_t>* word, int numberWaiters)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, numberWaiters, nullptr, nullptr, 0);
+}
+
+inline size_t align_cache_line(size_t numberBytes)
+{
+    return (numberBytes + 63) & ~size_t(63);
+}
+
+inline timespec to_timespec(chrono::nanoseconds duration)
+{
+    timespec timeout;
+    timeout.tv_sec = duration.count() / 1000000000;
+    timeout.tv_nsec = duration.count() % 1000000000;
+    return timeout;
+}
+
+void copy_string(char* target, const string& source)
+{
+    strncpy(target, source.c_str(), SHM_SERVER_MODEL_NAME_LENGTH - 1);
+    target[SHM_SERVER_MODEL_NAME_LENGTH - 1] = '\0';
+}
+}
+
+ShmSlot* get_shm_slot(ShmHeader* header, uint32_t slotIdx)
+{
+    return reinterpret_cast<ShmSlot*>(reinterpret_cast<char*>(header) + align_cache_line(sizeof(ShmHeader)) + slotIdx * header->slotSize);
+}
+
+void get_shm_slot_data(ShmHeader* header, uint32_t slotIdx, float*& inputPlanes, float*& valueOutputs, float*& probOutputs, float*& auxiliaryOutputs)
+{
+    inputPlanes = reinterpret_cast<float*>(reinterpret_cast<char*>(get_shm_slot(header, slotIdx)) + align_cache_line(sizeof(ShmSlot)));
+    valueOutputs = inputPlanes + header->slotBatchSize * header->nbInputValues;
+    probOutputs = valueOutputs + header->slotBatchSize;
+    auxiliaryOutputs = probOutputs + header->slotBatchSize * header->nbPolicyValues;
+}
+
+ShmInferenceWorker::ShmInferenceWorker(const vector<unique_ptr<NeuralNetAPI>>& nets, ShmInferenceServer* server):
+    NeuralNetAPIUser(nets),
+    server(server)
+{
+}
+
+void ShmInferenceWorker::run()
+{
+    while (true) {
+        slotIndices.clear();
+        const size_t numberPositions = server->collect_slots(slotIndices);
+        if (numberPositions == 0) {
+            return;
+        }
+        evaluate_slots(numberPositions);
+    }
+}
+
+void ShmInferenceWorker::evaluate_slots(size_t numberPositions)
+{
+    NeuralNetAPI* net = nets.front();
+    ShmHeader* header = server->get_header();
+    const size_t nbInputValues = header->nbInputValues;
+    const size_t nbPolicyValues = header->nbPolicyValues;
+    const size_t nbAuxiliaryOutputs = header->nbAuxiliaryValues;
+    float* slotInputPlanes;
+    float* slotValueOutputs;
+    float* slotProbOutputs;
+    float* slotAuxiliaryOutputs;
+
+    // gather
+    size_t offset = 0;
+    for (uint32_t slotIdx : slotIndices) {
+        const size_t slotPositions = get_shm_slot(header, slotIdx)->numberPositions;
+        get_shm_slot_data(header, slotIdx, slotInputPlanes, slotValueOutputs, slotProbOutputs, slotAuxiliaryOutputs);
+        std::copy_n(slotInputPlanes, slotPositions * nbInputValues, inputPlanes + offset * nbInputValues);
+        offset += slotPositions;
+    }
+    assert(offset == numberPositions);
+
+    net->set_number_positions(numberPositions);
+    net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+
+    // scatter
+    offset = 0;
+    for (uint32_t slotIdx : slotIndices) {
+        ShmSlot* slot = get_shm_slot(header, slotIdx);
+        const size_t slotPositions = slot->numberPositions;
+        get_shm_slot_data(header, slotIdx, slotInputPlanes, slotValueOutputs, slotProbOutputs, slotAuxiliaryOutputs);
+        std::copy_n(valueOutputs + offset, slotPositions, slotValueOutputs);
+        std::copy_n(probOutputs + offset * nbPolicyValues, slotPositions * nbPolicyValues, slotProbOutputs);
+        if (nbAuxiliaryOutputs != 0) {
+            std::copy_n(auxiliaryOutputs + offset * nbAuxiliaryOutputs, slotPositions * nbAuxiliaryOutputs, slotAuxiliaryOutputs);
+        }
+        offset += slotPositions;
+        slot->state.store(SHM_SLOT_DONE, std::memory_order_release);
+        futex_wake(&slot->state, 1);
+    }
+}
+
+ShmInferenceServer::ShmInferenceServer(const string& name, vector<unique_ptr<NeuralNetAPI>>& nets, size_t numberSlots, size_t slotBatchSize, size_t timeoutUS):
+    name(name),
+    header(nullptr),
+    segmentSize(0),
+    timeoutUS(timeoutUS),
+    maxBatchSize(nets.front()->get_batch_size()),
+    nextSlot(0)
+{
+    for (unique_ptr<NeuralNetAPI>& net : nets) {
+        if (net->get_batch_size() != maxBatchSize) {
+            throw invalid_argument("All networks of the inference server must have the same batch size.");
+        }
+    }
+    if (slotBatchSize > maxBatchSize) {
+        throw invalid_argument("The batch size of the inference server must be at least as large as the search batch size.");
+    }
+    const NeuralNetAPI* serverNet = nets.front().get();
+    const nn_api::NeuralNetDesign& design = serverNet->get_nn_design();
+    const size_t nbAuxiliaryValues = serverNet->has_auxiliary_outputs() ? serverNet->get_nb_auxiliary_outputs() : 0;
+    const size_t slotSize = align_cache_line(align_cache_line(sizeof(ShmSlot)) +
+                                             slotBatchSize * (serverNet->get_nb_input_values_total() + 1 + serverNet->get_nb_policy_values() + nbAuxiliaryValues) * sizeof(float));
+    segmentSize = align_cache_line(sizeof(ShmHeader)) + numberSlots * slotSize;
+
+    // a stale segment of a server which has crashed is replaced
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd == -1) {
+        throw invalid_argument("The shared memory segment " + name + " couldn't be created: " + strerror(errno));
+    }
+    if (ftruncate(fd, off_t(segmentSize)) == -1) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw invalid_argument("The shared memory segment " + name + " couldn't be resized: " + strerror(errno));
+    }
+    void* memory = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw invalid_argument("The shared memory segment " + name + " couldn't be mapped: " + strerror(errno));
+    }
+
+    header = new (memory) ShmHeader;
+    header->numberSlots = numberSlots;
+    header->slotBatchSize = slotBatchSize;
+    header->nbInputValues = serverNet->get_nb_input_values_total();
+    header->nbPolicyValues = serverNet->get_nb_policy_values();
+    header->nbAuxiliaryValues = nbAuxiliaryValues;
+    header->slotSize = slotSize;
+    header->inputShape = design.inputShape;
+    header->valueOutputShape = design.valueOutputShape;
+    header->policyOutputShape = design.policyOutputShape;
+    header->auxiliaryOutputShape = design.auxiliaryOutputShape;
+    header->isPolicyMap = design.isPolicyMap;
+    header->hasAuxiliaryOutputs = design.hasAuxiliaryOutputs;
+    copy_string(header->modelName, serverNet->get_model_name());
+    copy_string(header->deviceName, serverNet->get_device_name());
+    header->doorbell.store(0, std::memory_order_relaxed);
+    header->isRunning.store(1, std::memory_order_relaxed);
+    for (uint32_t slotIdx = 0; slotIdx < numberSlots; ++slotIdx) {
+        new (get_shm_slot(header, slotIdx)) ShmSlot;
+        get_shm_slot(header, slotIdx)->state.store(SHM_SLOT_FREE, std::memory_order_relaxed);
+    }
+    // the magic number is written last, so that clients only attach to a fully initialized segment
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SHM_SERVER_MAGIC;
+
+    for (unique_ptr<NeuralNetAPI>& net : nets) {
+        workerNets.emplace_back();
+        workerNets.back().emplace_back(std::move(net));
+    }
+    nets.clear();
+    for (const vector<unique_ptr<NeuralNetAPI>>& netVector : workerNets) {
+        workers.emplace_back(make_unique<ShmInferenceWorker>(netVector, this));
+    }
+    for (unique_ptr<ShmInferenceWorker>& worker : workers) {
+        workerThreads.emplace_back(&ShmInferenceWorker::run, worker.get());
+    }
+    info_string("shared memory inference server:", name);
+    info_string("inference server workers:", workers.size());
+    info_string("inference server slots:", numberSlots);
+    info_string("inference server batch size:", maxBatchSize);
+}
+
+ShmInferenceServer::~ShmInferenceServer()
+{
+    header->isRunning.store(0, std::memory_order_release);
+    header->doorbell.fetch_add(1, std::memory_order_release);
+    futex_wake(&header->doorbell, INT_MAX);
+    for (thread& workerThread : workerThreads) {
+        workerThread.join();
+    }
+    // the clients notice the stopped server on their next request
+    for (uint32_t slotIdx = 0; slotIdx < header->numberSlots; ++slotIdx) {
+        futex_wake(&get_shm_slot(header, slotIdx)->state, INT_MAX);
+    }
+    munmap(header, segmentSize);
+    shm_unlink(name.c_str());
+}
+
+size_t ShmInferenceServer::collect_slots(vector<uint32_t>& slotIndices)
+{
+    const uint32_t numberSlots = header->numberSlots;
+    const uint32_t firstSlot = nextSlot.fetch_add(1, std::memory_order_relaxed) % numberSlots;
+    chrono::steady_clock::time_point deadline;
+    size_t numberPositions = 0;
+    while (true) {
+        const uint32_t doorbell = header->doorbell.load(std::memory_order_acquire);
+        if (!header->isRunning.load(std::memory_order_acquire)) {
+            return numberPositions;
+        }
+        bool isFull = false;
+        for (uint32_t offset = 0; offset < numberSlots; ++offset) {
+            const uint32_t slotIdx = (firstSlot + offset) % numberSlots;
+            ShmSlot* slot = get_shm_slot(header, slotIdx);
+            uint32_t state = slot->state.load(std::memory_order_acquire);
+            if (state != SHM_SLOT_SUBMITTED) {
+                continue;
+            }
+            if (numberPositions + slot->numberPositions > maxBatchSize) {
+                isFull = true;
+                continue;
+            }
+            // other workers compete for the same slots
+            if (slot->state.compare_exchange_strong(state, SHM_SLOT_RUNNING, std::memory_order_acq_rel)) {
+                if (numberPositions == 0) {
+                    deadline = chrono::steady_clock::now() + chrono::microseconds(timeoutUS);
+                }
+                numberPositions += slot->numberPositions;
+                slotIndices.emplace_back(slotIdx);
+            }
+        }
+        if (isFull || numberPositions == maxBatchSize) {
+            break;
+        }
+        if (numberPositions == 0) {
+            futex_wait(&header->doorbell, doorbell, nullptr);
+            continue;
+        }
+        const auto remaining = deadline - chrono::steady_clock::now();
+        if (remaining <= chrono::nanoseconds(0)) {
+            // timeout
+            break;
+        }
+        const timespec timeout = to_timespec(remaining);
+        futex_wait(&header->doorbell, doorbell, &timeout);
+    }
+    return numberPositions;
+}
+
+ShmHeader* ShmInferenceServer::get_header() const
+{
+    return header;
+}
+
+ShmClientAPI::ShmClientAPI(const string& name, unsigned int batchSize, const string& modelDirectory):
+    NeuralNetAPI("shm", 0, batchSize, modelDirectory, false),
+    name(name),
+    header(nullptr),
+    segmentSize(0),
+    slotIdx(0),
+    slot(nullptr),
+    outputValue(nullptr),
+    outputProbs(nullptr),
+    outputAuxiliary(nullptr)
+{
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1) {
+        throw invalid_argument("The shared memory inference server " + name + " couldn't be opened: " + strerror(errno));
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1 || size_t(fileStat.st_size) < sizeof(ShmHeader)) {
+        close(fd);
+        throw invalid_argument("The shared memory inference server " + name + " hasn't been initialized.");
+    }
+    segmentSize = size_t(fileStat.st_size);
+    void* memory = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        throw invalid_argument("The shared memory inference server " + name + " couldn't be mapped: " + strerror(errno));
+    }
+    header = static_cast<ShmHeader*>(memory);
+    if (header->magic != SHM_SERVER_MAGIC || !header->isRunning.load(std::memory_order_acquire)) {
+        munmap(header, segmentSize);
+        throw invalid_argument("The shared memory inference server " + name + " isn't running.");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (batchSize > header->slotBatchSize) {
+        munmap(header, segmentSize);
+        throw invalid_argument("The slot batch size of the shared memory inference server must be at least as large as the search batch size.");
+    }
+    for (slotIdx = 0; slotIdx < header->numberSlots; ++slotIdx) {
+        uint32_t expected = SHM_SLOT_FREE;
+        if (get_shm_slot(header, slotIdx)->state.compare_exchange_strong(expected, SHM_SLOT_OWNED, std::memory_order_acq_rel)) {
+            slot = get_shm_slot(header, slotIdx);
+            break;
+        }
+    }
+    if (slot == nullptr) {
+        munmap(header, segmentSize);
+        throw invalid_argument("All slots of the shared memory inference server " + name + " are in use.");
+    }
+    initialize();
+}
+
+ShmClientAPI::~ShmClientAPI()
+{
+    slot->state.store(SHM_SLOT_FREE, std::memory_order_release);
+    munmap(header, segmentSize);
+}
+
+void ShmClientAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+    wait();
+}
+
+void ShmClientAPI::predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    float* slotInputPlanes;
+    float* slotValueOutputs;
+    float* slotProbOutputs;
+    float* slotAuxiliaryOutputs;
+    get_shm_slot_data(header, slotIdx, slotInputPlanes, slotValueOutputs, slotProbOutputs, slotAuxiliaryOutputs);
+    std::copy_n(inputPlanes, numberPositions * nbNNInputValues, slotInputPlanes);
+    outputValue = valueOutput;
+    outputProbs = probOutputs;
+    outputAuxiliary = auxiliaryOutputs;
+    slot->numberPositions = numberPositions;
+    slot->state.store(SHM_SLOT_SUBMITTED, std::memory_order_release);
+    header->doorbell.fetch_add(1, std::memory_order_release);
+    futex_wake(&header->doorbell, 1);
+}
+
+void ShmClientAPI::wait()
+{
+    const timespec timeout = to_timespec(chrono::milliseconds(100));
+    uint32_t state;
+    while ((state = slot->state.load(std::memory_order_acquire)) != SHM_SLOT_DONE) {
+        if (!header->isRunning.load(std::memory_order_acquire)) {
+            throw runtime_error("The shared memory inference server " + name + " has been stopped.");
+        }
+        futex_wait(&slot->state, state, &timeout);
+    }
+    float* slotInputPlanes;
+    float* slotValueOutputs;
+    float* slotProbOutputs;
+    float* slotAuxiliaryOutputs;
+    get_shm_slot_data(header, slotIdx, slotInputPlanes, slotValueOutputs, slotProbOutputs, slotAuxiliaryOutputs);
+    std::copy_n(slotValueOutputs, numberPositions, outputValue);
+    std::copy_n(slotProbOutputs, numberPositions * nbPolicyValues, outputProbs);
+    if (header->nbAuxiliaryValues != 0 && outputAuxiliary != nullptr) {
+        std::copy_n(slotAuxiliaryOutputs, numberPositions * header->nbAuxiliaryValues, outputAuxiliary);
+    }
+    slot->state.store(SHM_SLOT_OWNED, std::memory_order_release);
+}
+
+void ShmClientAPI::load_model()
+{
+    modelName = header->modelName;
+    deviceName = name + string("_") + header->deviceName;
+}
+
+void ShmClientAPI::load_parameters()
+{
+    // the parameters are only held by the server
+}
+
+void ShmClientAPI::bind_executor()
+{
+    // the executor is only held by the server
+}
+
+void ShmClientAPI::init_nn_design()
+{
+    nnDesign.isPolicyMap = header->isPolicyMap;
+    nnDesign.hasAuxiliaryOutputs = header->hasAuxiliaryOutputs;
+    // the shapes of the server include its batch size
+    nnDesign.inputShape = header->inputShape;
+    nnDesign.inputShape.v[0] = batchSize;
+    nnDesign.valueOutputShape = header->valueOutputShape;
+    nnDesign.valueOutputShape.v[0] = batchSize;
+    nnDesign.policyOutputShape = header->policyOutputShape;
+    nnDesign.policyOutputShape.v[0] = batchSize;
+    nnDesign.auxiliaryOutputShape = header->auxiliaryOutputShape;
+    if (nnDesign.hasAuxiliaryOutputs) {
+        nnDesign.auxiliaryOutputShape.v[0] = batchSize;
+    }
+}
+
+#endif
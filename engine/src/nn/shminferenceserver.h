@@ -0,0 +1,200 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: shminferenceserver.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Inference server which is shared by several engine processes on the same machine (e.g. selfplay fleets).
+ * The server process owns the neural networks and exposes them over a POSIX shared memory segment.
+ * Each client network (ShmClientAPI) claims a slot of the segment, writes its input planes into the slot and
+ * waits on a futex for the outputs. The workers of the server merge the submitted slots of all processes into large batches.
+ */
+
+#ifndef SHMINFERENCESERVER_H
+#define SHMINFERENCESERVER_H
+
+#ifdef __linux__
+#include <atomic>
+#include <thread>
+#include "neuralnetapi.h"
+#include "neuralnetapiuser.h"
+
+// identifies a shared memory segment of the inference server ("CRAS")
+#define SHM_SERVER_MAGIC 0x43524153
+#define SHM_SERVER_MODEL_NAME_LENGTH 256
+
+/**
+ * @brief The ShmSlotState enum describes the life cycle of a slot. A client owns its slot from its creation until its destruction.
+ */
+enum ShmSlotState : uint32_t {
+    SHM_SLOT_FREE,
+    SHM_SLOT_OWNED,
+    SHM_SLOT_SUBMITTED,
+    SHM_SLOT_RUNNING,
+    SHM_SLOT_DONE
+};
+
+/**
+ * @brief The ShmSlot struct is the header of a slot. It is followed by the input planes and the output buffers of the slot.
+ */
+struct alignas(64) ShmSlot
+{
+    std::atomic<uint32_t> state;
+    uint32_t numberPositions;
+};
+
+/**
+ * @brief The ShmHeader struct is located at the beginning of the shared memory segment and describes the network of the server
+ */
+struct alignas(64) ShmHeader
+{
+    uint32_t magic;
+    uint32_t numberSlots;
+    uint32_t slotBatchSize;
+    uint32_t nbInputValues;
+    uint32_t nbPolicyValues;
+    uint32_t nbAuxiliaryValues;
+    uint64_t slotSize;
+    nn_api::Shape inputShape;
+    nn_api::Shape valueOutputShape;
+    nn_api::Shape policyOutputShape;
+    nn_api::Shape auxiliaryOutputShape;
+    uint32_t isPolicyMap;
+    uint32_t hasAuxiliaryOutputs;
+    char modelName[SHM_SERVER_MODEL_NAME_LENGTH];
+    char deviceName[SHM_SERVER_MODEL_NAME_LENGTH];
+    // incremented by the clients for every submitted slot, the workers wait on it
+    std::atomic<uint32_t> doorbell;
+    std::atomic<uint32_t> isRunning;
+};
+
+class ShmInferenceServer;
+
+/**
+ * @brief The ShmInferenceWorker class evaluates the submitted slots on its own neural network
+ */
+class ShmInferenceWorker : public NeuralNetAPIUser
+{
+private:
+    ShmInferenceServer* server;
+    vector<uint32_t> slotIndices;
+public:
+    ShmInferenceWorker(const vector<unique_ptr<NeuralNetAPI>>& nets, ShmInferenceServer* server);
+
+    /**
+     * @brief run Collects, evaluates and scatters batches until the server is stopped
+     */
+    void run();
+
+private:
+    /**
+     * @brief evaluate_slots Copies the inputs of all collected slots together, runs the network and scatters the results back
+     * @param numberPositions Total number of positions of all slots
+     */
+    void evaluate_slots(size_t numberPositions);
+};
+
+class ShmInferenceServer
+{
+private:
+    string name;
+    ShmHeader* header;
+    size_t segmentSize;
+    vector<vector<unique_ptr<NeuralNetAPI>>> workerNets;
+    vector<unique_ptr<ShmInferenceWorker>> workers;
+    vector<thread> workerThreads;
+    size_t timeoutUS;
+    size_t maxBatchSize;
+    // next slot which is checked first by collect_slots() to serve the clients in a round robin fashion
+    std::atomic<uint32_t> nextSlot;
+public:
+    /**
+     * @brief ShmInferenceServer Creates the shared memory segment and starts a worker thread for each network
+     * @param name Name of the shared memory segment (e.g. "/crazyara")
+     * @param nets Neural networks of the workers, all must belong to the same model and have the same batch size
+     * @param numberSlots Maximum number of client networks
+     * @param slotBatchSize Maximum number of positions of a single client request
+     * @param timeoutUS Maximum time in microseconds a worker waits for additional requests after receiving the first request of a batch
+     */
+    ShmInferenceServer(const string& name, vector<unique_ptr<NeuralNetAPI>>& nets, size_t numberSlots, size_t slotBatchSize, size_t timeoutUS);
+    ~ShmInferenceServer();
+    ShmInferenceServer(const ShmInferenceServer&) = delete;
+
+    /**
+     * @brief collect_slots Blocks until at least one slot has been submitted and collects slots
+     * until the maximum batch size or the timeout has been reached
+     * @param slotIndices Output vector of slot indices
+     * @return Total number of positions or 0 if the server has been stopped
+     */
+    size_t collect_slots(vector<uint32_t>& slotIndices);
+
+    ShmHeader* get_header() const;
+};
+
+/**
+ * @brief The ShmClientAPI class is a NeuralNetAPI which forwards all requests to a ShmInferenceServer of a different process
+ */
+class ShmClientAPI : public NeuralNetAPI
+{
+private:
+    string name;
+    ShmHeader* header;
+    size_t segmentSize;
+    uint32_t slotIdx;
+    ShmSlot* slot;
+    float* outputValue;
+    float* outputProbs;
+    float* outputAuxiliary;
+public:
+    /**
+     * @brief ShmClientAPI Attaches to the shared memory segment and claims a free slot
+     * @param name Name of the shared memory segment
+     * @param batchSize Maximum number of positions of a single request (must not exceed the slot batch size of the server)
+     * @param modelDirectory Model directory which is used to derive the game phase
+     */
+    ShmClientAPI(const string& name, unsigned int batchSize, const string& modelDirectory);
+    ~ShmClientAPI();
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void wait() override;
+
+private:
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+};
+
+/**
+ * @brief get_shm_slot Returns the slot header for a given slot index
+ */
+ShmSlot* get_shm_slot(ShmHeader* header, uint32_t slotIdx);
+
+/**
+ * @brief get_shm_slot_data Returns the buffers of a slot: input planes, value outputs, policy outputs and auxiliary outputs
+ */
+void get_shm_slot_data(ShmHeader* header, uint32_t slotIdx, float*& inputPlanes, float*& valueOutputs, float*& probOutputs, float*& auxiliaryOutputs);
+
+#endif
+
+#endif // SHMINFERENCESERVER_H
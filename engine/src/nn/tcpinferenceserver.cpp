@@ -0,0 +1,481 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: tcpinferenceserver.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#ifndef _WIN32
+#include "tcpinferenceserver.h"
+#include "planepacking.h"
+#include "../util/tcpsocket.h"
+#include <chrono>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+void copy_string(char* target, const string& source)
+{
+    strncpy(target, source.c_str(), REMOTE_MODEL_NAME_LENGTH - 1);
+    target[REMOTE_MODEL_NAME_LENGTH - 1] = '\0';
+}
+
+// number of bytes of the input planes of a request in a given format
+size_t get_input_size(const RemoteModelInfo& modelInfo, size_t numberPositions, RemoteFormat format)
+{
+    const size_t numberValues = numberPositions * modelInfo.nbInputValues;
+    if (format == REMOTE_FORMAT_PACKED) {
+        return numberValues / PACKED_PLANE_SIZE * (sizeof(uint64_t) + sizeof(float));
+    }
+    return numberValues * sizeof(float);
+}
+
+// number of bytes of the outputs of a response
+size_t get_output_size(const RemoteModelInfo& modelInfo, size_t numberPositions)
+{
+    return numberPositions * (1 + modelInfo.nbPolicyValues + modelInfo.nbAuxiliaryValues) * sizeof(float);
+}
+}
+
+TcpInferenceServer::TcpInferenceServer(int port, vector<unique_ptr<NeuralNetAPI>>& nets, size_t timeoutUS):
+    server(make_unique<InferenceServer>(nets, timeoutUS)),
+    listenFd(-1),
+    isRunning(true)
+{
+    const NeuralNetAPI* net = server->get_net();
+    const nn_api::NeuralNetDesign& design = net->get_nn_design();
+    memset(&modelInfo, 0, sizeof(modelInfo));
+    modelInfo.magic = REMOTE_PROTOCOL_MAGIC;
+    modelInfo.maxBatchSize = net->get_batch_size();
+    modelInfo.nbInputValues = net->get_nb_input_values_total();
+    modelInfo.nbPolicyValues = net->get_nb_policy_values();
+    modelInfo.nbAuxiliaryValues = net->has_auxiliary_outputs() ? net->get_nb_auxiliary_outputs() : 0;
+    modelInfo.isPolicyMap = design.isPolicyMap;
+    modelInfo.hasAuxiliaryOutputs = design.hasAuxiliaryOutputs;
+    modelInfo.inputShape = design.inputShape;
+    modelInfo.valueOutputShape = design.valueOutputShape;
+    modelInfo.policyOutputShape = design.policyOutputShape;
+    modelInfo.auxiliaryOutputShape = design.auxiliaryOutputShape;
+    copy_string(modelInfo.modelName, net->get_model_name());
+    copy_string(modelInfo.deviceName, net->get_device_name());
+
+    listenFd = listen_on_port(port);
+    acceptThread = thread(&TcpInferenceServer::accept_connections, this);
+    info_string("remote inference server listening on port", port);
+}
+
+TcpInferenceServer::~TcpInferenceServer()
+{
+    isRunning = false;
+    // wakes up the blocking accept()
+    shutdown(listenFd, SHUT_RDWR);
+    acceptThread.join();
+    close(listenFd);
+    lock_guard<mutex> lock(mtx);
+    for (unique_ptr<TcpServerConnection>& connection : connections) {
+        shutdown(connection->fd, SHUT_RDWR);
+        close_connection(connection.get());
+    }
+    connections.clear();
+}
+
+void TcpInferenceServer::accept_connections()
+{
+    while (isRunning) {
+        const int fd = accept(listenFd, nullptr, nullptr);
+        if (!isRunning) {
+            if (fd != -1) {
+                close(fd);
+            }
+            return;
+        }
+        if (fd == -1) {
+            // e.g. the limit of open files has been reached
+            this_thread::sleep_for(chrono::milliseconds(10));
+            continue;
+        }
+        set_no_delay(fd);
+        if (!send_all(fd, reinterpret_cast<const char*>(&modelInfo), sizeof(modelInfo))) {
+            close(fd);
+            continue;
+        }
+
+        lock_guard<mutex> lock(mtx);
+        // release the connections of disconnected clients
+        for (auto it = connections.begin(); it != connections.end();) {
+            if ((*it)->isFinished) {
+                close_connection(it->get());
+                it = connections.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        connections.emplace_back(make_unique<TcpServerConnection>());
+        TcpServerConnection* connection = connections.back().get();
+        connection->fd = fd;
+        connection->reader = thread(&TcpInferenceServer::read_requests, this, connection);
+        connection->writer = thread(&TcpInferenceServer::write_responses, this, connection);
+        info_string("remote inference clients:", connections.size());
+    }
+}
+
+void TcpInferenceServer::read_requests(TcpServerConnection* connection)
+{
+    vector<uint64_t> masks;
+    vector<float> values;
+    RemoteFrameHeader header;
+    while (recv_all(connection->fd, &header, sizeof(header))) {
+        if (header.numberPositions == 0 || header.numberPositions > modelInfo.maxBatchSize || header.format > REMOTE_FORMAT_PACKED ||
+                (header.format == REMOTE_FORMAT_PACKED && modelInfo.nbInputValues % PACKED_PLANE_SIZE != 0) ||
+                header.numberBytes != get_input_size(modelInfo, header.numberPositions, RemoteFormat(header.format))) {
+            info_string("invalid remote inference request, closing connection");
+            break;
+        }
+
+        TcpServerRequest* request;
+        {
+            unique_lock<mutex> lock(connection->mtx);
+            if (connection->freeRequests.empty() && connection->requests.size() < REMOTE_MAX_REQUESTS_IN_FLIGHT) {
+                connection->requests.emplace_back(make_unique<TcpServerRequest>());
+                TcpServerRequest* newRequest = connection->requests.back().get();
+                newRequest->inputPlanes.resize(modelInfo.maxBatchSize * modelInfo.nbInputValues);
+                newRequest->valueOutputs.resize(modelInfo.maxBatchSize);
+                newRequest->probOutputs.resize(modelInfo.maxBatchSize * modelInfo.nbPolicyValues);
+                newRequest->auxiliaryOutputs.resize(modelInfo.maxBatchSize * modelInfo.nbAuxiliaryValues);
+                connection->freeRequests.emplace_back(newRequest);
+            }
+            connection->cv.wait(lock, [connection]{ return !connection->freeRequests.empty(); });
+            request = connection->freeRequests.back();
+            connection->freeRequests.pop_back();
+        }
+
+        const size_t numberValues = header.numberPositions * modelInfo.nbInputValues;
+        bool isReceived;
+        if (header.format == REMOTE_FORMAT_PACKED) {
+            const size_t numberPlanes = numberValues / PACKED_PLANE_SIZE;
+            masks.resize(numberPlanes);
+            values.resize(numberPlanes);
+            isReceived = recv_all(connection->fd, masks.data(), numberPlanes * sizeof(uint64_t)) &&
+                    recv_all(connection->fd, values.data(), numberPlanes * sizeof(float));
+            if (isReceived) {
+                unpack_planes(masks.data(), values.data(), request->inputPlanes.data(), numberPlanes);
+            }
+        }
+        else {
+            isReceived = recv_all(connection->fd, request->inputPlanes.data(), numberValues * sizeof(float));
+        }
+        if (!isReceived) {
+            lock_guard<mutex> lock(connection->mtx);
+            connection->freeRequests.emplace_back(request);
+            break;
+        }
+
+        request->requestId = header.requestId;
+        request->request.inputPlanes = request->inputPlanes.data();
+        request->request.valueOutputs = request->valueOutputs.data();
+        request->request.probOutputs = request->probOutputs.data();
+        request->request.auxiliaryOutputs = modelInfo.nbAuxiliaryValues != 0 ? request->auxiliaryOutputs.data() : nullptr;
+        request->request.numberPositions = header.numberPositions;
+        server->submit(&request->request);
+        {
+            lock_guard<mutex> lock(connection->mtx);
+            connection->requestsInFlight.push_back(request);
+        }
+        connection->cv.notify_all();
+    }
+    // stops the writer from sending further responses
+    shutdown(connection->fd, SHUT_RDWR);
+    {
+        lock_guard<mutex> lock(connection->mtx);
+        connection->isReaderFinished = true;
+    }
+    connection->cv.notify_all();
+}
+
+void TcpInferenceServer::write_responses(TcpServerConnection* connection)
+{
+    vector<char> frame;
+    bool isConnected = true;
+    while (true) {
+        TcpServerRequest* request;
+        {
+            unique_lock<mutex> lock(connection->mtx);
+            connection->cv.wait(lock, [connection]{ return !connection->requestsInFlight.empty() || connection->isReaderFinished; });
+            if (connection->requestsInFlight.empty()) {
+                break;
+            }
+            request = connection->requestsInFlight.front();
+            connection->requestsInFlight.pop_front();
+        }
+        {
+            // the request must not be reused before the inference server has finished it
+            unique_lock<mutex> lock(request->request.mtx);
+            request->request.cv.wait(lock, [request]{ return request->request.done; });
+        }
+
+        if (isConnected) {
+            const size_t numberPositions = request->request.numberPositions;
+            RemoteFrameHeader header;
+            header.requestId = request->requestId;
+            header.numberPositions = numberPositions;
+            header.format = REMOTE_FORMAT_FLOAT;
+            header.numberBytes = get_output_size(modelInfo, numberPositions);
+            frame.resize(sizeof(header) + header.numberBytes);
+            char* data = frame.data();
+            memcpy(data, &header, sizeof(header));
+            data += sizeof(header);
+            memcpy(data, request->valueOutputs.data(), numberPositions * sizeof(float));
+            data += numberPositions * sizeof(float);
+            memcpy(data, request->probOutputs.data(), numberPositions * modelInfo.nbPolicyValues * sizeof(float));
+            data += numberPositions * modelInfo.nbPolicyValues * sizeof(float);
+            memcpy(data, request->auxiliaryOutputs.data(), numberPositions * modelInfo.nbAuxiliaryValues * sizeof(float));
+            if (!send_all(connection->fd, frame.data(), frame.size())) {
+                isConnected = false;
+                shutdown(connection->fd, SHUT_RDWR);
+            }
+        }
+        {
+            lock_guard<mutex> lock(connection->mtx);
+            connection->freeRequests.emplace_back(request);
+        }
+        connection->cv.notify_all();
+    }
+    connection->isFinished = true;
+}
+
+void TcpInferenceServer::close_connection(TcpServerConnection* connection)
+{
+    connection->reader.join();
+    connection->writer.join();
+    close(connection->fd);
+}
+
+RemoteConnection::RemoteConnection(const string& address):
+    address(address),
+    fd(-1),
+    isBroken(false)
+{
+    fd = connect_to_address(address);
+    if (fd == -1) {
+        throw invalid_argument("The remote inference server " + address + " couldn't be reached.");
+    }
+    // the requests are small and latency bound
+    set_no_delay(fd);
+    if (!recv_all(fd, &modelInfo, sizeof(modelInfo)) || modelInfo.magic != REMOTE_PROTOCOL_MAGIC) {
+        close(fd);
+        throw invalid_argument("The remote inference server " + address + " uses a different protocol version.");
+    }
+    info_string("connected to remote inference server", address);
+    receiver = thread(&RemoteConnection::receive_responses, this);
+}
+
+RemoteConnection::~RemoteConnection()
+{
+    shutdown(fd, SHUT_RDWR);
+    receiver.join();
+    close(fd);
+}
+
+uint32_t RemoteConnection::register_request(InferenceRequest* request)
+{
+    lock_guard<mutex> lock(mtx);
+    requests.emplace_back(request);
+    return uint32_t(requests.size() - 1);
+}
+
+void RemoteConnection::send_frame(InferenceRequest* request, const char* frame, size_t numberBytes)
+{
+    {
+        lock_guard<mutex> lock(request->mtx);
+        request->done = false;
+    }
+    // fail_requests() sets the flag before releasing the requests
+    if (isBroken) {
+        request->done = true;
+        throw runtime_error("The connection to the remote inference server " + address + " has been lost.");
+    }
+    lock_guard<mutex> lock(sendMtx);
+    if (!send_all(fd, frame, numberBytes)) {
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+const RemoteModelInfo& RemoteConnection::get_model_info() const
+{
+    return modelInfo;
+}
+
+const string& RemoteConnection::get_address() const
+{
+    return address;
+}
+
+bool RemoteConnection::is_broken() const
+{
+    return isBroken;
+}
+
+void RemoteConnection::receive_responses()
+{
+    vector<float> auxiliaryDiscard;
+    RemoteFrameHeader header;
+    while (recv_all(fd, &header, sizeof(header))) {
+        InferenceRequest* request = nullptr;
+        {
+            lock_guard<mutex> lock(mtx);
+            if (header.requestId < requests.size()) {
+                request = requests[header.requestId];
+            }
+        }
+        const size_t numberPositions = header.numberPositions;
+        if (request == nullptr || numberPositions != request->numberPositions || header.numberBytes != get_output_size(modelInfo, numberPositions)) {
+            info_string("invalid remote inference response, closing connection");
+            break;
+        }
+        float* auxiliaryOutputs = request->auxiliaryOutputs;
+        if (auxiliaryOutputs == nullptr) {
+            auxiliaryDiscard.resize(numberPositions * modelInfo.nbAuxiliaryValues);
+            auxiliaryOutputs = auxiliaryDiscard.data();
+        }
+        if (!recv_all(fd, request->valueOutputs, numberPositions * sizeof(float)) ||
+                !recv_all(fd, request->probOutputs, numberPositions * modelInfo.nbPolicyValues * sizeof(float)) ||
+                !recv_all(fd, auxiliaryOutputs, numberPositions * modelInfo.nbAuxiliaryValues * sizeof(float))) {
+            break;
+        }
+        {
+            lock_guard<mutex> lock(request->mtx);
+            request->done = true;
+        }
+        request->cv.notify_one();
+    }
+    fail_requests();
+}
+
+void RemoteConnection::fail_requests()
+{
+    isBroken = true;
+    lock_guard<mutex> lock(mtx);
+    for (InferenceRequest* request : requests) {
+        {
+            lock_guard<mutex> requestLock(request->mtx);
+            request->done = true;
+        }
+        request->cv.notify_all();
+    }
+}
+
+RemoteClientAPI::RemoteClientAPI(shared_ptr<RemoteConnection> connection, unsigned int batchSize, const string& modelDirectory):
+    NeuralNetAPI("remote", 0, batchSize, modelDirectory, false),
+    connection(connection),
+    requestId(connection->register_request(&request)),
+    usePackedPlanes(false)
+{
+    if (batchSize > connection->get_model_info().maxBatchSize) {
+        throw invalid_argument("The batch size of the remote inference server must be at least as large as the search batch size.");
+    }
+    initialize();
+    usePackedPlanes = nbNNInputValues % PACKED_PLANE_SIZE == 0;
+    frame.resize(sizeof(RemoteFrameHeader) + batchSize * nbNNInputValues * sizeof(float));
+}
+
+void RemoteClientAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+    wait();
+}
+
+void RemoteClientAPI::predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    RemoteFrameHeader header;
+    header.requestId = requestId;
+    header.numberPositions = numberPositions;
+    header.format = REMOTE_FORMAT_FLOAT;
+    char* payload = frame.data() + sizeof(header);
+    const size_t numberValues = numberPositions * nbNNInputValues;
+    if (usePackedPlanes) {
+        const size_t numberPlanes = numberValues / PACKED_PLANE_SIZE;
+        if (pack_planes(inputPlanes, numberPlanes, reinterpret_cast<uint64_t*>(payload),
+                        reinterpret_cast<float*>(payload + numberPlanes * sizeof(uint64_t)))) {
+            header.format = REMOTE_FORMAT_PACKED;
+        }
+    }
+    if (header.format == REMOTE_FORMAT_FLOAT) {
+        // fallback for planes with more than one distinct non-zero value
+        memcpy(payload, inputPlanes, numberValues * sizeof(float));
+    }
+    header.numberBytes = get_input_size(connection->get_model_info(), numberPositions, RemoteFormat(header.format));
+    memcpy(frame.data(), &header, sizeof(header));
+
+    request.valueOutputs = valueOutput;
+    request.probOutputs = probOutputs;
+    request.auxiliaryOutputs = auxiliaryOutputs;
+    request.numberPositions = numberPositions;
+    connection->send_frame(&request, frame.data(), sizeof(header) + header.numberBytes);
+}
+
+void RemoteClientAPI::wait()
+{
+    unique_lock<mutex> lock(request.mtx);
+    request.cv.wait(lock, [this]{ return request.done; });
+    if (connection->is_broken()) {
+        throw runtime_error("The connection to the remote inference server " + connection->get_address() + " has been lost.");
+    }
+}
+
+void RemoteClientAPI::load_model()
+{
+    const RemoteModelInfo& modelInfo = connection->get_model_info();
+    modelName = modelInfo.modelName;
+    deviceName = connection->get_address() + string("_") + modelInfo.deviceName;
+}
+
+void RemoteClientAPI::load_parameters()
+{
+    // the parameters are only held by the server
+}
+
+void RemoteClientAPI::bind_executor()
+{
+    // the executor is only held by the server
+}
+
+void RemoteClientAPI::init_nn_design()
+{
+    const RemoteModelInfo& modelInfo = connection->get_model_info();
+    nnDesign.isPolicyMap = modelInfo.isPolicyMap;
+    nnDesign.hasAuxiliaryOutputs = modelInfo.hasAuxiliaryOutputs;
+    // the shapes of the server include its batch size
+    nnDesign.inputShape = modelInfo.inputShape;
+    nnDesign.inputShape.v[0] = batchSize;
+    nnDesign.valueOutputShape = modelInfo.valueOutputShape;
+    nnDesign.valueOutputShape.v[0] = batchSize;
+    nnDesign.policyOutputShape = modelInfo.policyOutputShape;
+    nnDesign.policyOutputShape.v[0] = batchSize;
+    nnDesign.auxiliaryOutputShape = modelInfo.auxiliaryOutputShape;
+    if (nnDesign.hasAuxiliaryOutputs) {
+        nnDesign.auxiliaryOutputShape.v[0] = batchSize;
+    }
+}
+
+#endif
@@ -0,0 +1,254 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: tcpinferenceserver.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Remote inference over TCP, so that the search and the neural network can run on different machines.
+ * The server side forwards all received requests to an InferenceServer which merges them into large batches.
+ * The client side (RemoteClientAPI) shares a single connection between all networks of a process and pipelines their requests:
+ * Every request carries the id of its client and the responses are dispatched by a receiver thread.
+ * The input planes are transferred in the packed plane format (see planepacking.h) whenever possible.
+ * The binary protocol uses the native byte order, so that client and server must run on the same architecture.
+ */
+
+#ifndef TCPINFERENCESERVER_H
+#define TCPINFERENCESERVER_H
+
+#ifndef _WIN32
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include "neuralnetapi.h"
+#include "inferenceserver.h"
+
+// identifies the protocol and its version ("CRA1")
+#define REMOTE_PROTOCOL_MAGIC 0x31415243
+#define REMOTE_MODEL_NAME_LENGTH 256
+// maximum number of requests of a single connection which are evaluated at the same time by the server
+#define REMOTE_MAX_REQUESTS_IN_FLIGHT 256
+
+/**
+ * @brief The RemoteFormat enum describes the encoding of the input planes of a request
+ */
+enum RemoteFormat : uint32_t {
+    REMOTE_FORMAT_FLOAT,
+    REMOTE_FORMAT_PACKED
+};
+
+/**
+ * @brief The RemoteModelInfo struct is sent by the server after a client has connected and describes its network
+ */
+struct RemoteModelInfo
+{
+    uint32_t magic;
+    uint32_t maxBatchSize;
+    uint32_t nbInputValues;
+    uint32_t nbPolicyValues;
+    uint32_t nbAuxiliaryValues;
+    uint32_t isPolicyMap;
+    uint32_t hasAuxiliaryOutputs;
+    nn_api::Shape inputShape;
+    nn_api::Shape valueOutputShape;
+    nn_api::Shape policyOutputShape;
+    nn_api::Shape auxiliaryOutputShape;
+    char modelName[REMOTE_MODEL_NAME_LENGTH];
+    char deviceName[REMOTE_MODEL_NAME_LENGTH];
+};
+
+/**
+ * @brief The RemoteFrameHeader struct precedes every request and every response.
+ * A request is followed by its input planes, a response by the value, policy and auxiliary outputs.
+ */
+struct RemoteFrameHeader
+{
+    uint32_t requestId;
+    uint32_t numberPositions;
+    uint32_t format;
+    // size of the data which follows the header
+    uint32_t numberBytes;
+};
+
+/**
+ * @brief The TcpServerRequest struct holds a request of a connection while it is evaluated by the inference server
+ */
+struct TcpServerRequest
+{
+    InferenceRequest request;
+    uint32_t requestId = 0;
+    vector<float> inputPlanes;
+    vector<float> valueOutputs;
+    vector<float> probOutputs;
+    vector<float> auxiliaryOutputs;
+};
+
+/**
+ * @brief The TcpServerConnection struct describes a client connection. The reader thread submits the received requests,
+ * the writer thread sends the responses in the order of the requests.
+ */
+struct TcpServerConnection
+{
+    int fd = -1;
+    thread reader;
+    thread writer;
+    mutex mtx;
+    condition_variable cv;
+    deque<TcpServerRequest*> requestsInFlight;
+    vector<unique_ptr<TcpServerRequest>> requests;
+    vector<TcpServerRequest*> freeRequests;
+    bool isReaderFinished = false;
+    std::atomic<bool> isFinished{false};
+};
+
+class TcpInferenceServer
+{
+private:
+    unique_ptr<InferenceServer> server;
+    RemoteModelInfo modelInfo;
+    int listenFd;
+    thread acceptThread;
+    std::atomic<bool> isRunning;
+    mutex mtx;
+    list<unique_ptr<TcpServerConnection>> connections;
+public:
+    /**
+     * @brief TcpInferenceServer Creates an inference server for the given networks and starts listening on the given port
+     * @param port TCP port
+     * @param nets Neural networks of the workers, all must belong to the same model and have the same batch size
+     * @param timeoutUS Maximum time in microseconds a worker waits for additional requests after receiving the first request of a batch
+     */
+    TcpInferenceServer(int port, vector<unique_ptr<NeuralNetAPI>>& nets, size_t timeoutUS);
+    ~TcpInferenceServer();
+    TcpInferenceServer(const TcpInferenceServer&) = delete;
+
+private:
+    /**
+     * @brief accept_connections Accepts new clients until the server is stopped
+     */
+    void accept_connections();
+
+    /**
+     * @brief read_requests Receives the requests of a connection and submits them to the inference server
+     */
+    void read_requests(TcpServerConnection* connection);
+
+    /**
+     * @brief write_responses Waits for the submitted requests of a connection and sends their results
+     */
+    void write_responses(TcpServerConnection* connection);
+
+    /**
+     * @brief close_connection Waits for the threads of a connection and closes its socket
+     */
+    void close_connection(TcpServerConnection* connection);
+};
+
+/**
+ * @brief The RemoteConnection class is a connection to a TcpInferenceServer which is shared by all clients of a process
+ */
+class RemoteConnection
+{
+private:
+    string address;
+    int fd;
+    RemoteModelInfo modelInfo;
+    thread receiver;
+    mutex sendMtx;
+    mutex mtx;
+    vector<InferenceRequest*> requests;
+    std::atomic<bool> isBroken;
+public:
+    /**
+     * @brief RemoteConnection Connects to a server and receives the description of its network
+     * @param address Server address in the form "<host>:<port>"
+     */
+    RemoteConnection(const string& address);
+    ~RemoteConnection();
+    RemoteConnection(const RemoteConnection&) = delete;
+
+    /**
+     * @brief register_request Registers the request of a client which is reused for all its predictions
+     * @return Request id
+     */
+    uint32_t register_request(InferenceRequest* request);
+
+    /**
+     * @brief send_frame Sends a complete request frame. The request is finished as soon as request->done is true.
+     * @param request Registered request of the client
+     * @param frame Frame header followed by the input planes
+     * @param numberBytes Size of the frame in bytes
+     */
+    void send_frame(InferenceRequest* request, const char* frame, size_t numberBytes);
+
+    const RemoteModelInfo& get_model_info() const;
+    const string& get_address() const;
+    bool is_broken() const;
+
+private:
+    /**
+     * @brief receive_responses Writes the received results into the output buffers of the requests until the connection is closed
+     */
+    void receive_responses();
+
+    /**
+     * @brief fail_requests Marks the connection as broken and releases all waiting clients
+     */
+    void fail_requests();
+};
+
+/**
+ * @brief The RemoteClientAPI class is a NeuralNetAPI which forwards all requests to a TcpInferenceServer on a different machine
+ */
+class RemoteClientAPI : public NeuralNetAPI
+{
+private:
+    shared_ptr<RemoteConnection> connection;
+    InferenceRequest request;
+    uint32_t requestId;
+    bool usePackedPlanes;
+    vector<char> frame;
+public:
+    /**
+     * @brief RemoteClientAPI
+     * @param connection Connection to the server which can be shared with other clients
+     * @param batchSize Maximum number of positions of a single request (must not exceed the batch size of the server)
+     * @param modelDirectory Model directory which is used to derive the game phase
+     */
+    RemoteClientAPI(shared_ptr<RemoteConnection> connection, unsigned int batchSize, const string& modelDirectory);
+
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void wait() override;
+
+private:
+    void load_model() override;
+    void load_parameters() override;
+    void bind_executor() override;
+    void init_nn_design() override;
+};
+
+#endif
+
+#endif // TCPINFERENCESERVER_H
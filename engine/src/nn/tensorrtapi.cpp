@@ -26,12 +26,25 @@
 #ifdef TENSORRT
 #include "tensorrtapi.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include "EntropyCalibrator.h"
+#include "enginecache.h"
+#include "layerprecision.h"
+#include "planepacking.h"
+#include "policygather.h"
+#include "../util/halfconversion.h"
+#include "../util/numa.h"
+#include "../util/memorystats.h"
 #include "stateobj.h"
 #include "../util/communication.h"
 #ifdef SF_DEPENDENCY
@@ -40,23 +53,148 @@
 
 using namespace sample;
 
-TensorrtAPI::TensorrtAPI(int deviceID, unsigned int batchSize, const string &modelDirectory, const string& strPrecision):
+namespace {
+/**
+ * @brief The SharedEngineEntry struct holds an engine of the registry. The mutex makes sure that an engine is only built once,
+ * while engines for different keys can be loaded concurrently.
+ */
+struct SharedEngineEntry
+{
+    mutex mtx;
+    weak_ptr<ICudaEngine> engine;
+};
+
+shared_ptr<SharedEngineEntry> get_shared_engine_entry(const string& key)
+{
+    static mutex registryMutex;
+    static map<string, shared_ptr<SharedEngineEntry>> registry;
+    lock_guard<mutex> lock(registryMutex);
+    shared_ptr<SharedEngineEntry>& entry = registry[key];
+    if (entry == nullptr) {
+        entry = make_shared<SharedEngineEntry>();
+    }
+    return entry;
+}
+
+#if !defined(MODE_POMMERMAN) && !defined(MODE_OPEN_SPIEL) && !defined(MODE_XIANGQI) && !defined(MODE_STRATEGO) && !defined (MODE_BOARDGAMES)
+/**
+ * @brief create_calibration_stream Returns a stream of single position batches from the calibration file or the built-in sample games
+ */
+ChessBatchStream* create_calibration_stream(const string& calibrationFile)
+{
+    if (!calibrationFile.empty()) {
+        info_string("stream calibration positions from", calibrationFile);
+        return new ChessBatchStream(1, INT8_CALIBRATION_MAX_POSITIONS, calibrationFile);
+    }
+#ifdef MODE_CHESS
+    return new ChessBatchStream(1, 104);
+#elif defined MODE_CRAZYHOUSE
+    return new ChessBatchStream(1, 232);
+#else
+    return nullptr;
+#endif
+}
+#endif
+}
+
+TensorrtAPI::TensorrtAPI(int deviceID, unsigned int batchSize, const string &modelDirectory, const string& strPrecision, bool useCudaGraph,
+                         bool dynamicBatchProfiles, const string& engineCacheDirectory, bool packedInputPlanes, bool halfIO,
+                         bool gatherPolicy, const string& calibrationFile, bool searchLayerPrecision, double layerPrecisionTolerance):
     NeuralNetAPI("gpu", deviceID, batchSize, modelDirectory, true),
     idxInput(nnDesign.inputIdx),
     idxValueOutput(nnDesign.valueOutputIdx + nnDesign.nbInputs),
     idxPolicyOutput(nnDesign.policyOutputIdx + nnDesign.nbInputs),
     idxAuxiliaryOutput(nnDesign.auxiliaryOutputIdx + nnDesign.nbInputs),
     precision(str_to_precision(strPrecision)),
-    generatedTrtFromONNX(false)
+    generatedTrtFromONNX(false),
+    zeroCopy(false),
+    useCudaGraph(useCudaGraph),
+    packedInputPlanes(packedInputPlanes),
+    packedMasks(nullptr),
+    packedValues(nullptr),
+    devicePackedMasks(nullptr),
+    devicePackedValues(nullptr),
+    halfIO(halfIO),
+    halfInput(false),
+    halfHostBuffers{nullptr, nullptr, nullptr, nullptr},
+    pendingOutputs{nullptr, nullptr, nullptr, nullptr},
+    pendingBatchSize(0),
+    gatherPolicy(gatherPolicy),
+    gatherIndices(nullptr),
+    gatherCounts(nullptr),
+    hostGatherIndices(nullptr),
+    hostGatherCounts(nullptr),
+    deviceGatherIndices(nullptr),
+    deviceGatherCounts(nullptr),
+    deviceGatheredPolicy(nullptr),
+    pendingGathered(false),
+    stageTiming(false),
+    stageEvents{nullptr, nullptr, nullptr, nullptr},
+    calibrationFile(calibrationFile),
+    searchLayerPrecision(searchLayerPrecision),
+    layerPrecisionTolerance(layerPrecisionTolerance),
+    deviceMemorySize(0),
+    bindingsPerProfile(0)
 {
     // select the requested device
     cudaSetDevice(deviceID);
+    cudaDeviceProp deviceProp;
+    CHECK(cudaGetDeviceProperties(&deviceProp, deviceID));
+    zeroCopy = deviceProp.integrated && deviceProp.canMapHostMemory;
+    if (zeroCopy) {
+        info_string("use zero copy buffers for integrated device", deviceID);
+    }
+#ifndef CUDA_KERNELS
+    if (packedInputPlanes) {
+        info_string_important("Packed input planes require a build with CUDA_KERNELS.");
+    }
+    if (gatherPolicy) {
+        info_string_important("Policy gathering requires a build with CUDA_KERNELS.");
+    }
+    this->packedInputPlanes = false;
+    this->gatherPolicy = false;
+#endif
+    if (zeroCopy) {
+        // the device reads the host buffer directly, so there is nothing to gain
+        this->packedInputPlanes = false;
+        this->halfIO = false;
+        this->gatherPolicy = false;
+    }
+    // packed planes are expanded on the device, so the input binding stays float32
+    halfInput = this->halfIO && !this->packedInputPlanes;
+#ifdef TENSORRT7
+    if (dynamicBatchProfiles) {
+        info_string_important("Dynamic batch profiles require TensorRT 8 or newer.");
+        dynamicBatchProfiles = false;
+    }
+#endif
+#if defined(MODE_POMMERMAN) || defined(MODE_OPEN_SPIEL) || defined(MODE_XIANGQI) || defined(MODE_STRATEGO) || defined (MODE_BOARDGAMES)
+    if (searchLayerPrecision) {
+        info_string_important("The layer precision search requires the chess calibration positions.");
+        this->searchLayerPrecision = false;
+    }
+#endif
+    if (precision == float32) {
+        // all layers already run in float32
+        this->searchLayerPrecision = false;
+    }
     // in ONNX, the model architecture and parameters are in the same file
-    modelName = get_onnx_model_name(modelDir, batchSize);
+    if (dynamicBatchProfiles) {
+        profileBatchSizes = get_profile_batch_sizes(batchSize);
+        modelName = get_dynamic_onnx_model_name(modelDir);
+    }
+    else {
+        profileBatchSizes = {batchSize};
+        modelName = get_onnx_model_name(modelDir, batchSize);
+    }
 
     modelFilePath = modelDir + modelName;
     info_string("onnx file:", modelFilePath);
-    trtFilePath = generate_trt_file_path(modelDir, batchSize, precision, deviceID);
+    engineCacheDir = engineCacheDirectory.empty() ? modelDir : parse_directory(engineCacheDirectory);
+    engineDescription = get_engine_description(deviceProp);
+    layerPlanPath = get_layer_plan_path(engineCacheDir, get_layer_plan_description(deviceProp));
+    trtFilePath = get_engine_cache_path(engineCacheDir, engineDescription);
+    timingCachePath = get_timing_cache_path(engineCacheDir, get_device_description(deviceProp));
     gLogger.setReportableSeverity(nvinfer1::ILogger::Severity::kERROR);
 
     initialize();
@@ -64,6 +202,10 @@ TensorrtAPI::TensorrtAPI(int deviceID, unsigned int batchSize, const string &mod
 
 TensorrtAPI::~TensorrtAPI()
 {
+    memory_stats().add(MEMORY_DEVICE, -int64_t(deviceMemorySize));
+    for (CudaGraphEntry& entry : cudaGraphs) {
+        CHECK(cudaGraphExecDestroy(entry.graphExec));
+    }
     CHECK(cudaFree(deviceMemory[idxInput]));
     CHECK(cudaFree(deviceMemory[idxValueOutput]));
     CHECK(cudaFree(deviceMemory[idxPolicyOutput]));
@@ -74,13 +216,47 @@ TensorrtAPI::~TensorrtAPI()
 #endif
         CHECK(cudaFree(deviceMemory[idxAuxiliaryOutput]));
     }
+    for (uint16_t* buffer : halfHostBuffers) {
+        if (buffer != nullptr) {
+            CHECK(cudaFreeHost(buffer));
+        }
+    }
+    if (hostGatherIndices != nullptr) {
+        CHECK(cudaFreeHost(hostGatherIndices));
+        CHECK(cudaFreeHost(hostGatherCounts));
+        CHECK(cudaFree(deviceGatherIndices));
+        CHECK(cudaFree(deviceGatherCounts));
+        CHECK(cudaFree(deviceGatheredPolicy));
+    }
+    if (packedMasks != nullptr) {
+        CHECK(cudaFreeHost(packedMasks));
+        CHECK(cudaFreeHost(packedValues));
+        CHECK(cudaFree(devicePackedMasks));
+        CHECK(cudaFree(devicePackedValues));
+    }
+    for (cudaEvent_t event : stageEvents) {
+        if (event != nullptr) {
+            CHECK(cudaEventDestroy(event));
+        }
+    }
     CHECK(cudaStreamDestroy(stream));
 }
 
 void TensorrtAPI::load_model()
 {
+    // all instances on the same device share the engine and its weights, only the execution contexts and streams are created per instance
+    shared_ptr<SharedEngineEntry> entry = get_shared_engine_entry(to_string(deviceID) + " " + engineDescription);
+    lock_guard<mutex> lock(entry->mtx);
+    engine = entry->engine.lock();
+    if (engine != nullptr) {
+        info_string("reuse TensorRT engine on device", deviceID);
+        return;
+    }
     // load an engine from file or build an engine from the ONNX network
-    engine = shared_ptr<nvinfer1::ICudaEngine>(get_cuda_engine(), samplesCommon::InferDeleter());
+    ICudaEngine* newEngine = get_cuda_engine();
+    const shared_ptr<IRuntime> engineRuntime = runtime;
+    engine = shared_ptr<nvinfer1::ICudaEngine>(newEngine, [engineRuntime](ICudaEngine* ptr) { samplesCommon::InferDeleter()(ptr); });
+    entry->engine = engine;
 }
 
 void TensorrtAPI::load_parameters()
@@ -128,7 +304,9 @@ bool TensorrtAPI::retrieve_indices_by_name(bool verbose)
 void TensorrtAPI::init_nn_design()
 {
 #ifndef TENSORRT10
-    nnDesign.hasAuxiliaryOutputs = engine->getNbBindings() > 3;
+    // the bindings are repeated for each optimization profile
+    bindingsPerProfile = engine->getNbBindings() / engine->getNbOptimizationProfiles();
+    nnDesign.hasAuxiliaryOutputs = bindingsPerProfile > 3;
     if (!retrieve_indices_by_name(generatedTrtFromONNX)) {
         info_string_important("Fallback to default indices.");
         idxInput = nnDesign.inputIdx;
@@ -159,124 +337,499 @@ void TensorrtAPI::init_nn_design()
 
 void TensorrtAPI::bind_executor()
 {
-    // create an exectution context for applying inference
-    context = SampleUniquePtr<nvinfer1::IExecutionContext>(engine->createExecutionContext());
-    Dims inputDims;
-    set_dims(inputDims, nnDesign.inputShape);
+    CHECK(cudaStreamCreate(&stream));
+
+    // create an exectution context for applying inference for each optimization profile
+    for (size_t profileIdx = 0; profileIdx < profileBatchSizes.size(); ++profileIdx) {
+        contexts.emplace_back(engine->createExecutionContext());
+        SampleUniquePtr<nvinfer1::IExecutionContext>& context = contexts.back();
+        Dims inputDims;
+        set_dims(inputDims, nnDesign.inputShape);
+        inputDims.d[0] = profileBatchSizes[profileIdx];
 #ifdef TENSORRT10
-    context->setInputShape(nnDesign.inputLayerName.c_str(), inputDims);
+        context->setOptimizationProfileAsync(profileIdx, stream);
+        context->setInputShape(nnDesign.inputLayerName.c_str(), inputDims);
 #else
-    context->setBindingDimensions(0, inputDims);
+#ifndef TENSORRT7
+        context->setOptimizationProfileAsync(profileIdx, stream);
+#endif
+        context->setBindingDimensions(profileIdx * bindingsPerProfile + idxInput, inputDims);
 #endif
+    }
+    CHECK(cudaStreamSynchronize(stream));
+    // the activation memory of each context (the weights of the shared engine aren't counted)
+    add_device_memory(contexts.size() * engine->getDeviceMemorySize());
 
     // create buffers object with respect to the engine and batch size
-    CHECK(cudaStreamCreate(&stream));
+    const size_t inputElementSize = halfInput ? sizeof(uint16_t) : sizeof(float);
+    const size_t outputElementSize = halfIO ? sizeof(uint16_t) : sizeof(float);
 #ifdef DYNAMIC_NN_ARCH
-    memorySizes[idxInput] = batchSize * get_nb_input_values_total() * sizeof(float);
+    memorySizes[idxInput] = batchSize * get_nb_input_values_total() * inputElementSize;
 #else
-    memorySizes[idxInput] = batchSize * StateConstants::NB_VALUES_TOTAL() * sizeof(float);
+    memorySizes[idxInput] = batchSize * StateConstants::NB_VALUES_TOTAL() * inputElementSize;
 #endif
-    memorySizes[idxValueOutput] = batchSize * sizeof(float);
-    memorySizes[idxPolicyOutput] = batchSize * get_nb_policy_values() * sizeof(float);
+    memorySizes[idxValueOutput] = batchSize * outputElementSize;
+    memorySizes[idxPolicyOutput] = batchSize * get_nb_policy_values() * outputElementSize;
 #ifdef DYNAMIC_NN_ARCH
     if (nnDesign.hasAuxiliaryOutputs) {
-        memorySizes[idxAuxiliaryOutput] = batchSize * get_nb_auxiliary_outputs() * sizeof (float);
+        memorySizes[idxAuxiliaryOutput] = batchSize * get_nb_auxiliary_outputs() * outputElementSize;
 #else
     if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
-        memorySizes[idxAuxiliaryOutput] = batchSize * StateConstants::NB_AUXILIARY_OUTPUTS() * sizeof (float);
+        memorySizes[idxAuxiliaryOutput] = batchSize * StateConstants::NB_AUXILIARY_OUTPUTS() * outputElementSize;
 #endif
         CHECK(cudaMalloc(&deviceMemory[idxAuxiliaryOutput], memorySizes[idxAuxiliaryOutput]));
+        add_device_memory(memorySizes[idxAuxiliaryOutput]);
+        if (halfIO) {
+            CHECK(cudaHostAlloc((void**)&halfHostBuffers[idxAuxiliaryOutput], memorySizes[idxAuxiliaryOutput], cudaHostAllocDefault));
+        }
+    }
+    if (halfInput) {
+        CHECK(cudaHostAlloc((void**)&halfHostBuffers[idxInput], memorySizes[idxInput], cudaHostAllocDefault));
+    }
+    if (halfIO) {
+        CHECK(cudaHostAlloc((void**)&halfHostBuffers[idxValueOutput], memorySizes[idxValueOutput], cudaHostAllocDefault));
+        CHECK(cudaHostAlloc((void**)&halfHostBuffers[idxPolicyOutput], memorySizes[idxPolicyOutput], cudaHostAllocDefault));
     }
     CHECK(cudaMalloc(&deviceMemory[idxInput], memorySizes[idxInput]));
     CHECK(cudaMalloc(&deviceMemory[idxValueOutput], memorySizes[idxValueOutput]));
     CHECK(cudaMalloc(&deviceMemory[idxPolicyOutput], memorySizes[idxPolicyOutput]));
+    add_device_memory(memorySizes[idxInput] + memorySizes[idxValueOutput] + memorySizes[idxPolicyOutput]);
+
+    if (gatherPolicy && get_nb_policy_values() <= POLICY_GATHER_STRIDE) {
+        // the gathered rows wouldn't be smaller than the full policy output
+        gatherPolicy = false;
+    }
+    if (gatherPolicy) {
+        CHECK(cudaHostAlloc((void**)&hostGatherIndices, batchSize * POLICY_GATHER_STRIDE * sizeof(uint32_t), cudaHostAllocDefault));
+        CHECK(cudaHostAlloc((void**)&hostGatherCounts, batchSize * sizeof(uint32_t), cudaHostAllocDefault));
+        CHECK(cudaMalloc(&deviceGatherIndices, batchSize * POLICY_GATHER_STRIDE * sizeof(uint32_t)));
+        CHECK(cudaMalloc(&deviceGatherCounts, batchSize * sizeof(uint32_t)));
+        CHECK(cudaMalloc(&deviceGatheredPolicy, batchSize * POLICY_GATHER_STRIDE * sizeof(float)));
+        add_device_memory(batchSize * (POLICY_GATHER_STRIDE * (sizeof(uint32_t) + sizeof(float)) + sizeof(uint32_t)));
+    }
+
+    if (packedInputPlanes) {
+        if (nnDesign.inputShape.v[2] * nnDesign.inputShape.v[3] != PACKED_PLANE_SIZE) {
+            info_string_important("Packed input planes are only supported for 8x8 boards.");
+            packedInputPlanes = false;
+            return;
+        }
+        const size_t numberPlanes = batchSize * nnDesign.inputShape.v[1];
+        CHECK(cudaHostAlloc((void**)&packedMasks, numberPlanes * sizeof(uint64_t), cudaHostAllocDefault));
+        CHECK(cudaHostAlloc((void**)&packedValues, numberPlanes * sizeof(float), cudaHostAllocDefault));
+        CHECK(cudaMalloc(&devicePackedMasks, numberPlanes * sizeof(uint64_t)));
+        CHECK(cudaMalloc(&devicePackedValues, numberPlanes * sizeof(float)));
+        add_device_memory(numberPlanes * (sizeof(uint64_t) + sizeof(float)));
+    }
+}
+
+void TensorrtAPI::add_device_memory(size_t numberBytes)
+{
+    deviceMemorySize += numberBytes;
+    memory_stats().add(MEMORY_DEVICE, int64_t(numberBytes));
+}
+
+bool TensorrtAPI::supports_policy_gather() const
+{
+    return gatherPolicy;
+}
+
+void TensorrtAPI::set_policy_gather(const uint32_t* indices, const uint32_t* counts)
+{
+    gatherIndices = indices;
+    gatherCounts = counts;
+}
+
+int TensorrtAPI::get_numa_node() const
+{
+    char pciBusId[32];
+    if (cudaDeviceGetPCIBusId(pciBusId, sizeof(pciBusId), deviceID) != cudaSuccess) {
+        return NO_NUMA_NODE;
+    }
+    return get_numa_node_of_pci_device(pciBusId);
+}
+
+bool TensorrtAPI::set_stage_timing(bool enable)
+{
+    cudaSetDevice(deviceID);
+    if (enable && stageEvents[0] == nullptr) {
+        for (cudaEvent_t& event : stageEvents) {
+            CHECK(cudaEventCreate(&event));
+        }
+    }
+    stageTiming = enable;
+    return true;
+}
+
+StageTimings TensorrtAPI::get_stage_timings() const
+{
+    return lastStageTimings;
+}
+
+bool TensorrtAPI::pack_input_planes(const float* inputPlanes, size_t profileIdx)
+{
+    return pack_planes(inputPlanes, profileBatchSizes[profileIdx] * nnDesign.inputShape.v[1], packedMasks, packedValues);
 }
 
 void TensorrtAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+{
+    predict_async(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs);
+    wait();
+}
+
+bool TensorrtAPI::map_host_buffer(float* hostBuffer, void*& devicePointer) const
+{
+    if (!zeroCopy || hostBuffer == nullptr) {
+        return false;
+    }
+    void* mappedPointer;
+    if (cudaHostGetDevicePointer(&mappedPointer, hostBuffer, 0) != cudaSuccess) {
+        // the buffer hasn't been allocated by allocate_host_buffer(), reset the error state
+        cudaGetLastError();
+        return false;
+    }
+    devicePointer = mappedPointer;
+    return true;
+}
+
+float* TensorrtAPI::allocate_host_buffer(size_t numberValues)
+{
+    float* buffer;
+    CHECK(cudaHostAlloc((void**) &buffer, numberValues * sizeof(float), zeroCopy ? cudaHostAllocMapped : cudaHostAllocDefault));
+    return buffer;
+}
+
+void TensorrtAPI::free_host_buffer(float* buffer)
+{
+    CHECK(cudaFreeHost(buffer));
+}
+
+size_t TensorrtAPI::select_profile() const
+{
+    for (size_t profileIdx = 0; profileIdx < profileBatchSizes.size(); ++profileIdx) {
+        if (profileBatchSizes[profileIdx] >= numberPositions) {
+            return profileIdx;
+        }
+    }
+    return profileBatchSizes.size() - 1;
+}
+
+const CudaGraphEntry* TensorrtAPI::get_cuda_graph(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t profileIdx, bool packed,
+                                                   bool gathered)
+{
+    for (const CudaGraphEntry& entry : cudaGraphs) {
+        if (entry.hostBuffers[0] == inputPlanes && entry.hostBuffers[1] == valueOutput &&
+                entry.hostBuffers[2] == probOutputs && entry.hostBuffers[3] == auxiliaryOutputs && entry.profileIdx == profileIdx &&
+                entry.gathered == gathered) {
+            return &entry;
+        }
+    }
+    // run once without capturing, so that TensorRT finishes all lazy initialisations before the capture
+    enqueue_inference(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs, profileIdx, packed, gathered);
+    CHECK(cudaStreamSynchronize(stream));
+
+    cudaGraph_t graph;
+    CHECK(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+    enqueue_inference(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs, profileIdx, packed, gathered);
+    if (cudaStreamEndCapture(stream, &graph) != cudaSuccess) {
+        cudaGetLastError();
+        info_string_important("CUDA graph capture failed, fallback to regular inference.");
+        useCudaGraph = false;
+        return nullptr;
+    }
+    CudaGraphEntry entry = {{inputPlanes, valueOutput, probOutputs, auxiliaryOutputs}, profileIdx, gathered, nullptr};
+    const cudaError_t status = cudaGraphInstantiateWithFlags(&entry.graphExec, graph, 0);
+    CHECK(cudaGraphDestroy(graph));
+    if (status != cudaSuccess) {
+        cudaGetLastError();
+        info_string_important("CUDA graph instantiation failed, fallback to regular inference.");
+        useCudaGraph = false;
+        return nullptr;
+    }
+    cudaGraphs.emplace_back(entry);
+    return &cudaGraphs.back();
+}
+
+void TensorrtAPI::predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
 {
     // select the requested device
     cudaSetDevice(deviceID);
-    // copy input planes from host to device
-    CHECK(cudaMemcpyAsync(deviceMemory[idxInput], inputPlanes, memorySizes[idxInput],
-                          cudaMemcpyHostToDevice, stream));
+    const size_t profileIdx = select_profile();
+    // the packed and half precision buffers are filled on the host before the launch, so they are also valid for replaying a graph
+    const bool packed = packedInputPlanes && pack_input_planes(inputPlanes, profileIdx);
+    if (halfInput) {
+        float_to_half(inputPlanes, halfHostBuffers[idxInput], profileBatchSizes[profileIdx] * get_nb_input_values_total());
+    }
+    // the indices are staged in pinned memory, the rows of unused positions don't gather anything
+    const bool gathered = gatherPolicy && gatherIndices != nullptr;
+    if (gathered) {
+        const size_t profileBatchSize = profileBatchSizes[profileIdx];
+        std::copy_n(gatherIndices, numberPositions * POLICY_GATHER_STRIDE, hostGatherIndices);
+        std::copy_n(gatherCounts, numberPositions, hostGatherCounts);
+        std::fill(hostGatherCounts + numberPositions, hostGatherCounts + profileBatchSize, 0);
+    }
+    gatherIndices = nullptr;
+    gatherCounts = nullptr;
+    pendingGathered = gathered;
+    if (halfIO) {
+        pendingOutputs[idxValueOutput] = valueOutput;
+        pendingOutputs[idxPolicyOutput] = probOutputs;
+        pendingOutputs[idxAuxiliaryOutput] = auxiliaryOutputs;
+        pendingBatchSize = profileBatchSizes[profileIdx];
+    }
+    // the captured graphs always copy the packed planes if packing is enabled
+    if (useCudaGraph && !stageTiming && packed == packedInputPlanes) {
+        const CudaGraphEntry* entry = get_cuda_graph(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs, profileIdx, packed, gathered);
+        if (entry != nullptr) {
+            CHECK(cudaGraphLaunch(entry->graphExec, stream));
+            return;
+        }
+    }
+    enqueue_inference(inputPlanes, valueOutput, probOutputs, auxiliaryOutputs, profileIdx, packed, gathered);
+}
 
-#ifdef TENSORRT10
-    context->setTensorAddress(nnDesign.inputLayerName.c_str(), deviceMemory[idxInput]);
-    context->setTensorAddress(nnDesign.valueOutputName.c_str(), deviceMemory[idxValueOutput]);
-    context->setTensorAddress(nnDesign.policySoftmaxOutputName.c_str(), deviceMemory[idxPolicyOutput]);
+void TensorrtAPI::enqueue_inference(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t profileIdx, bool packed,
+                                    bool gathered)
+{
+    SampleUniquePtr<nvinfer1::IExecutionContext>& context = contexts[profileIdx];
+    // only the part of the buffers which belongs to the batch size of the profile is transferred
+    const size_t profileBatchSize = profileBatchSizes[profileIdx];
+    const size_t inputSize = memorySizes[idxInput] / batchSize * profileBatchSize;
+    const size_t valueSize = memorySizes[idxValueOutput] / batchSize * profileBatchSize;
+    const size_t policySize = memorySizes[idxPolicyOutput] / batchSize * profileBatchSize;
+
+    void* bindings[4] = {deviceMemory[0], deviceMemory[1], deviceMemory[2], deviceMemory[3]};
+    const bool mappedInput = map_host_buffer(inputPlanes, bindings[idxInput]);
+    const bool mappedValue = map_host_buffer(valueOutput, bindings[idxValueOutput]);
+    const bool mappedPolicy = map_host_buffer(probOutputs, bindings[idxPolicyOutput]);
 #ifdef DYNAMIC_NN_ARCH
-    if (has_auxiliary_outputs()) {
+    const bool useAuxiliaryOutputs = has_auxiliary_outputs();
 #else
-    if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
+    const bool useAuxiliaryOutputs = StateConstants::NB_AUXILIARY_OUTPUTS();
+#endif
+    // the engine always computes the auxiliary outputs, but they are only transferred if the caller consumes them
+    const bool copyAuxiliaryOutputs = useAuxiliaryOutputs && auxiliaryOutputs != nullptr;
+    const bool mappedAuxiliary = copyAuxiliaryOutputs && map_host_buffer(auxiliaryOutputs, bindings[idxAuxiliaryOutput]);
+    const size_t auxiliarySize = useAuxiliaryOutputs ? memorySizes[idxAuxiliaryOutput] / batchSize * profileBatchSize : 0;
+
+    if (stageTiming) {
+        CHECK(cudaEventRecord(stageEvents[0], stream));
+    }
+    // copy input planes from host to device
+#ifdef CUDA_KERNELS
+    if (packed) {
+        const size_t numberPlanes = profileBatchSize * nnDesign.inputShape.v[1];
+        CHECK(cudaMemcpyAsync(devicePackedMasks, packedMasks, numberPlanes * sizeof(uint64_t),
+                              cudaMemcpyHostToDevice, stream));
+        CHECK(cudaMemcpyAsync(devicePackedValues, packedValues, numberPlanes * sizeof(float),
+                              cudaMemcpyHostToDevice, stream));
+        unpack_planes_on_device((const uint64_t*)devicePackedMasks, (const float*)devicePackedValues, (float*)bindings[idxInput],
+                                numberPlanes, stream);
+    }
+    else
 #endif
-        context->setTensorAddress(nnDesign.auxiliaryOutputName.c_str(), deviceMemory[idxAuxiliaryOutput]);
+    if (!mappedInput) {
+        CHECK(cudaMemcpyAsync(bindings[idxInput], halfInput ? (void*)halfHostBuffers[idxInput] : (void*)inputPlanes, inputSize,
+                              cudaMemcpyHostToDevice, stream));
+    }
+
+#ifdef TENSORRT10
+    context->setTensorAddress(nnDesign.inputLayerName.c_str(), bindings[idxInput]);
+    context->setTensorAddress(nnDesign.valueOutputName.c_str(), bindings[idxValueOutput]);
+    context->setTensorAddress(nnDesign.policySoftmaxOutputName.c_str(), bindings[idxPolicyOutput]);
+    if (useAuxiliaryOutputs) {
+        context->setTensorAddress(nnDesign.auxiliaryOutputName.c_str(), bindings[idxAuxiliaryOutput]);
     }
 #endif
 
+    if (stageTiming) {
+        CHECK(cudaEventRecord(stageEvents[1], stream));
+    }
     // run inference for given data
 #ifdef TENSORRT10
     context->enqueueV3(stream);
 #else
-    context->enqueueV2(deviceMemory, stream, nullptr);
+    // the binding indices of profile k are shifted by k * bindingsPerProfile
+    vector<void*> profileBindings(engine->getNbBindings(), nullptr);
+    for (int idx = 0; idx < bindingsPerProfile; ++idx) {
+        profileBindings[profileIdx * bindingsPerProfile + idx] = bindings[idx];
+    }
+    context->enqueueV2(profileBindings.data(), stream, nullptr);
 #endif
+    if (stageTiming) {
+        CHECK(cudaEventRecord(stageEvents[2], stream));
+    }
 
     // copy output from device back to host
-    CHECK(cudaMemcpyAsync(valueOutput, deviceMemory[idxValueOutput],
-                          memorySizes[idxValueOutput], cudaMemcpyDeviceToHost, stream));
-    CHECK(cudaMemcpyAsync(probOutputs, deviceMemory[idxPolicyOutput],
-                          memorySizes[idxPolicyOutput], cudaMemcpyDeviceToHost, stream));
-#ifdef DYNAMIC_NN_ARCH
-    if (has_auxiliary_outputs()) {
-#else
-    if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
+    // in half precision mode the outputs are copied into the staging buffers and converted in wait()
+    if (!mappedValue) {
+        CHECK(cudaMemcpyAsync(halfIO ? (void*)halfHostBuffers[idxValueOutput] : (void*)valueOutput, bindings[idxValueOutput],
+                              valueSize, cudaMemcpyDeviceToHost, stream));
+    }
+#ifdef CUDA_KERNELS
+    if (gathered) {
+        CHECK(cudaMemcpyAsync(deviceGatherIndices, hostGatherIndices, profileBatchSize * POLICY_GATHER_STRIDE * sizeof(uint32_t),
+                              cudaMemcpyHostToDevice, stream));
+        CHECK(cudaMemcpyAsync(deviceGatherCounts, hostGatherCounts, profileBatchSize * sizeof(uint32_t),
+                              cudaMemcpyHostToDevice, stream));
+        gather_policy_on_device(bindings[idxPolicyOutput], halfIO, (const uint32_t*)deviceGatherIndices, (const uint32_t*)deviceGatherCounts,
+                                (float*)deviceGatheredPolicy, profileBatchSize, get_nb_policy_values(), POLICY_GATHER_STRIDE, stream);
+        CHECK(cudaMemcpyAsync(probOutputs, deviceGatheredPolicy, profileBatchSize * POLICY_GATHER_STRIDE * sizeof(float),
+                              cudaMemcpyDeviceToHost, stream));
+    }
+    else
 #endif
-        CHECK(cudaMemcpyAsync(auxiliaryOutputs, deviceMemory[idxAuxiliaryOutput],
-                              memorySizes[idxAuxiliaryOutput], cudaMemcpyDeviceToHost, stream));
+    if (!mappedPolicy) {
+        CHECK(cudaMemcpyAsync(halfIO ? (void*)halfHostBuffers[idxPolicyOutput] : (void*)probOutputs, bindings[idxPolicyOutput],
+                              policySize, cudaMemcpyDeviceToHost, stream));
+    }
+    if (copyAuxiliaryOutputs && !mappedAuxiliary) {
+        CHECK(cudaMemcpyAsync(halfIO ? (void*)halfHostBuffers[idxAuxiliaryOutput] : (void*)auxiliaryOutputs, bindings[idxAuxiliaryOutput],
+                              auxiliarySize, cudaMemcpyDeviceToHost, stream));
     }
+    if (stageTiming) {
+        CHECK(cudaEventRecord(stageEvents[3], stream));
+    }
+}
+
+void TensorrtAPI::wait()
+{
+    cudaSetDevice(deviceID);
     cudaStreamSynchronize(stream);
+    if (stageTiming) {
+        CHECK(cudaEventElapsedTime(&lastStageTimings.hostToDeviceMS, stageEvents[0], stageEvents[1]));
+        CHECK(cudaEventElapsedTime(&lastStageTimings.computeMS, stageEvents[1], stageEvents[2]));
+        CHECK(cudaEventElapsedTime(&lastStageTimings.deviceToHostMS, stageEvents[2], stageEvents[3]));
+    }
+    if (halfIO && pendingBatchSize != 0) {
+        half_to_float(halfHostBuffers[idxValueOutput], pendingOutputs[idxValueOutput], pendingBatchSize);
+        if (!pendingGathered) {
+            half_to_float(halfHostBuffers[idxPolicyOutput], pendingOutputs[idxPolicyOutput], pendingBatchSize * get_nb_policy_values());
+        }
+        if (halfHostBuffers[idxAuxiliaryOutput] != nullptr && pendingOutputs[idxAuxiliaryOutput] != nullptr) {
+            half_to_float(halfHostBuffers[idxAuxiliaryOutput], pendingOutputs[idxAuxiliaryOutput], pendingBatchSize * get_nb_auxiliary_outputs());
+        }
+        pendingBatchSize = 0;
+    }
 }
 
-ICudaEngine* TensorrtAPI::create_cuda_engine_from_onnx()
+string TensorrtAPI::get_calibration_cache_path() const
 {
-    info_string("Building TensorRT engine...");
-    info_string("This may take a few minutes...");
-    // create an engine builder
-    SampleUniquePtr<IBuilder> builder = SampleUniquePtr<IBuilder>(createInferBuilder(gLogger.getTRTLogger()));
-#ifndef TENSORRT10
-    builder->setMaxBatchSize(int(batchSize));
-#endif
+    stringstream ss;
+    ss << engineCacheDir << "calibration-" << hex << hash_file(modelFilePath);
+    if (!calibrationFile.empty()) {
+        ss << "-" << hash_file(calibrationFile);
+    }
+    ss << ".table";
+    return ss.str();
+}
 
-    // create an ONNX network object
+string TensorrtAPI::get_device_description(const cudaDeviceProp& deviceProp) const
+{
+    string gpuName = deviceProp.name;
+    replace(gpuName.begin(), gpuName.end(), ' ', '_');
+    int cudaVersion = 0;
+    cudaRuntimeGetVersion(&cudaVersion);
+    stringstream ss;
+    ss << "gpu=" << gpuName << " sm=" << deviceProp.major << "." << deviceProp.minor
+       << " trt=" << getInferLibVersion() << " cuda=" << cudaVersion;
+    return ss.str();
+}
+
+string TensorrtAPI::get_engine_description(const cudaDeviceProp& deviceProp) const
+{
+    stringstream ss;
+    ss << "model=" << modelName << " onnx=" << hex << hash_file(modelFilePath) << dec
+       << " " << get_device_description(deviceProp)
+       << " precision=" << precision_to_str(precision) << " io=" << (halfIO ? (halfInput ? "float16" : "float16-output") : "float32")
+       << " profiles=";
+    for (size_t idx = 0; idx < profileBatchSizes.size(); ++idx) {
+        ss << (idx == 0 ? "" : ",") << profileBatchSizes[idx];
+    }
+    if (precision == int8 && !calibrationFile.empty()) {
+        ss << " calibration=" << hex << hash_file(calibrationFile) << dec;
+    }
+    if (searchLayerPrecision) {
+        ss << " layers=" << get_engine_key(get_layer_plan_description(deviceProp));
+    }
+    return ss.str();
+}
+
+string TensorrtAPI::get_layer_plan_description(const cudaDeviceProp& deviceProp) const
+{
+    stringstream ss;
+    ss << "model=" << modelName << " onnx=" << hex << hash_file(modelFilePath) << dec
+       << " " << get_device_description(deviceProp)
+       << " precision=" << precision_to_str(precision) << " tolerance=" << layerPrecisionTolerance;
+    if (precision == int8 && !calibrationFile.empty()) {
+        ss << " calibration=" << hex << hash_file(calibrationFile) << dec;
+    }
+    return ss.str();
+}
+
+bool TensorrtAPI::parse_onnx_model(SampleUniquePtr<IBuilder>& builder, SampleUniquePtr<nvinfer1::INetworkDefinition>& network,
+                                   SampleUniquePtr<nvonnxparser::IParser>& parser) const
+{
     const uint32_t explicitBatch = 1U << static_cast<uint32_t>(NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
-    auto network = SampleUniquePtr<nvinfer1::INetworkDefinition>(builder->createNetworkV2(explicitBatch));
+    network = SampleUniquePtr<nvinfer1::INetworkDefinition>(builder->createNetworkV2(explicitBatch));
 
     // conversion of ONNX model to TensorRT
     // parse the ONNX model file along with logger object for reporting info
-    SampleUniquePtr<nvonnxparser::IParser> parser = SampleUniquePtr<nvonnxparser::IParser>(nvonnxparser::createParser(*network, gLogger.getTRTLogger()));
+    parser = SampleUniquePtr<nvonnxparser::IParser>(nvonnxparser::createParser(*network, gLogger.getTRTLogger()));
     if (!parser->parseFromFile(modelFilePath.c_str(), static_cast<int>(gLogger.getReportableSeverity())))
     {
         gLogger.log(nvinfer1::ILogger::Severity::kERROR, "failed to parse onnx file");
         for (int32_t idx = 0; idx < parser->getNbErrors(); ++idx) {
             std::cout << parser->getError(idx)->desc() << std::endl;
         }
+        return false;
+    }
+    return true;
+}
+
+ICudaEngine* TensorrtAPI::create_cuda_engine_from_onnx()
+{
+    info_string("Building TensorRT engine...");
+    info_string("This may take a few minutes...");
+    // create an engine builder
+    SampleUniquePtr<IBuilder> builder = SampleUniquePtr<IBuilder>(createInferBuilder(gLogger.getTRTLogger()));
+#ifndef TENSORRT10
+    builder->setMaxBatchSize(int(batchSize));
+#endif
+
+    // the layer plan is determined before the final build, because the search builds its own candidate engines
+    const vector<string> layerPlan = searchLayerPrecision ? get_layer_plan() : vector<string>();
+
+    // create an ONNX network object
+    SampleUniquePtr<nvinfer1::INetworkDefinition> network;
+    SampleUniquePtr<nvonnxparser::IParser> parser;
+    if (!parse_onnx_model(builder, network, parser)) {
         exit(EXIT_FAILURE);
         return nullptr;
     }
-    configure_network(network);
+    configure_network(network, halfIO);
     
     SampleUniquePtr<nvinfer1::IBuilderConfig> config = SampleUniquePtr<nvinfer1::IBuilderConfig>(builder->createBuilderConfig());
     unique_ptr<IInt8Calibrator> calibrator;
     unique_ptr<IBatchStream> calibrationStream;
     set_config_settings(config, calibrator, calibrationStream);
+    apply_layer_plan(network, config, layerPlan);
+#ifndef TENSORRT7
+    // reuse the kernel timings of previous builds, so that only new layer configurations are profiled
+    unique_ptr<ITimingCache> timingCache = load_timing_cache(config);
+#endif
 
-    IOptimizationProfile* profile = builder->createOptimizationProfile();
+    // each profile has a fixed batch size, so that the kernels are tuned for exactly this size
+    for (unsigned int profileBatchSize : profileBatchSizes) {
+        IOptimizationProfile* profile = builder->createOptimizationProfile();
 
-    Dims inputDims = network->getInput(0)->getDimensions();
-    inputDims.d[0] = batchSize;
-    profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kMIN, inputDims);
-    profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kOPT, inputDims);
-    profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kMAX, inputDims);
-    config->addOptimizationProfile(profile);
+        Dims inputDims = network->getInput(0)->getDimensions();
+        inputDims.d[0] = profileBatchSize;
+        profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kMIN, inputDims);
+        profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kOPT, inputDims);
+        profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kMAX, inputDims);
+        config->addOptimizationProfile(profile);
+    }
 
 #ifdef TENSORRT10
     nnDesign.hasAuxiliaryOutputs = network->getNbOutputs() > 2;
@@ -287,7 +840,10 @@ ICudaEngine* TensorrtAPI::create_cuda_engine_from_onnx()
     return builder->buildEngineWithConfig(*network, *config);
 #else
     SampleUniquePtr<IHostMemory> serializedModel{builder->buildSerializedNetwork(*network, *config)};
-    runtime = SampleUniquePtr<IRuntime>(createInferRuntime(sample::gLogger.getTRTLogger()));
+    if (serializedModel) {
+        save_timing_cache(config);
+    }
+    runtime = shared_ptr<IRuntime>(createInferRuntime(sample::gLogger.getTRTLogger()), samplesCommon::InferDeleter());
 
     // build an engine from the serialized model
     return runtime->deserializeCudaEngine(serializedModel->data(), serializedModel->size());;
@@ -297,17 +853,29 @@ ICudaEngine* TensorrtAPI::create_cuda_engine_from_onnx()
 ICudaEngine* TensorrtAPI::get_cuda_engine() {
     ICudaEngine* engine{nullptr};
 
-    // try to read an engine from file
+    // try to read an engine from the cache, the manifest entry must match the description and the file size
     size_t bufferSize;
-    const char* buffer = read_buffer(trtFilePath, bufferSize);
+    const char* buffer = nullptr;
+    if (is_valid_cache_entry(engineCacheDir, engineDescription)) {
+        buffer = read_buffer(trtFilePath, bufferSize);
+    }
+    else {
+        info_string("no valid engine in cache for:", engineDescription);
+    }
     if (buffer) {
         info_string("deserialize engine:", trtFilePath);
-        runtime = unique_ptr<IRuntime, samplesCommon::InferDeleter>{createInferRuntime(gLogger)};
+        runtime = shared_ptr<IRuntime>(createInferRuntime(gLogger), samplesCommon::InferDeleter());
 #ifdef TENSORRT7
         engine = runtime->deserializeCudaEngine(buffer, bufferSize, nullptr);
 #else
         engine = runtime->deserializeCudaEngine(buffer, bufferSize);
+        if (engine && size_t(engine->getNbOptimizationProfiles()) != profileBatchSizes.size()) {
+            info_string("cached engine has an unexpected number of optimization profiles:", trtFilePath);
+            delete engine;
+            engine = nullptr;
+        }
 #endif
+        delete [] buffer;
     }
 
     if (!engine) {
@@ -321,11 +889,12 @@ ICudaEngine* TensorrtAPI::get_cuda_engine() {
         if (engine) {
             info_string("serialize engine:", trtFilePath);
             // serialized engines are not portable across platforms or TensorRT versions
-            // engines are specific to the exact GPU model they were built on
+            // engines are specific to the exact GPU model they were built on, therefore both are part of the cache key
             unique_ptr<IHostMemory, samplesCommon::InferDeleter> enginePlan{engine->serialize()};
             // export engine for future uses
-            // write engine to file
-            write_buffer(enginePlan->data(), enginePlan->size(), trtFilePath);
+            if (!write_cache_entry(engineCacheDir, engineDescription, enginePlan->data(), enginePlan->size())) {
+                info_string_important("Failed to write the engine to the cache directory", engineCacheDir);
+            }
         }
     }
     return engine;
@@ -345,13 +914,10 @@ void TensorrtAPI::set_config_settings(SampleUniquePtr<nvinfer1::IBuilderConfig>&
     case int8:
         config->setFlag(BuilderFlag::kINT8);
         info_string("run INT8 quantization calibration");
-#ifdef MODE_CHESS
-        calibrationStream.reset(new ChessBatchStream(1, 104));
-#elif defined MODE_CRAZYHOUSE
-        calibrationStream.reset(new ChessBatchStream(1, 232));
-#endif
 #if !defined(MODE_POMMERMAN) && !defined(MODE_OPEN_SPIEL) && !defined(MODE_XIANGQI) && !defined(MODE_STRATEGO) && !defined (MODE_BOARDGAMES)
-        calibrator.reset(new Int8EntropyCalibrator2<ChessBatchStream>(*(dynamic_cast<ChessBatchStream*>(calibrationStream.get())), 0, "model", "data"));
+        calibrationStream.reset(create_calibration_stream(calibrationFile));
+        // the calibration table is reused for later engine builds of the same model and calibration data
+        calibrator.reset(new ChessInt8Calibrator(*(dynamic_cast<ChessBatchStream*>(calibrationStream.get())), get_calibration_cache_path()));
 #endif
         config->setInt8Calibrator(calibrator.get());
         // samplesCommon::setAllTensorScales(network.get(), 127.0f, 127.0f); -> unavailable for TensorRT >= 8.2.0.6
@@ -359,7 +925,52 @@ void TensorrtAPI::set_config_settings(SampleUniquePtr<nvinfer1::IBuilderConfig>&
     }
 }
 
-void TensorrtAPI::configure_network(SampleUniquePtr<nvinfer1::INetworkDefinition> &network)
+#ifndef TENSORRT7
+unique_ptr<ITimingCache> TensorrtAPI::load_timing_cache(SampleUniquePtr<nvinfer1::IBuilderConfig>& config) const
+{
+    string buffer;
+    ifstream timingCacheFile(timingCachePath, ios::binary);
+    if (timingCacheFile) {
+        buffer.assign(istreambuf_iterator<char>(timingCacheFile), istreambuf_iterator<char>());
+        info_string("load timing cache:", timingCachePath);
+    }
+    unique_ptr<ITimingCache> timingCache(config->createTimingCache(buffer.data(), buffer.size()));
+    if (!timingCache && !buffer.empty()) {
+        // the file is corrupt or has been written by another TensorRT version, start with an empty cache
+        info_string("invalid timing cache:", timingCachePath);
+        timingCache.reset(config->createTimingCache(nullptr, 0));
+    }
+    if (timingCache) {
+        config->setTimingCache(*timingCache, false);
+    }
+    return timingCache;
+}
+
+void TensorrtAPI::save_timing_cache(SampleUniquePtr<nvinfer1::IBuilderConfig>& config) const
+{
+    ITimingCache* timingCache = config->getTimingCache();
+    if (timingCache == nullptr) {
+        return;
+    }
+    // another process may have updated the file during the build, so keep its timings as well
+    ifstream timingCacheFile(timingCachePath, ios::binary);
+    if (timingCacheFile) {
+        const string buffer((istreambuf_iterator<char>(timingCacheFile)), istreambuf_iterator<char>());
+        unique_ptr<ITimingCache> fileCache(config->createTimingCache(buffer.data(), buffer.size()));
+        if (fileCache) {
+            timingCache->combine(*fileCache, true);
+        }
+    }
+    unique_ptr<IHostMemory, samplesCommon::InferDeleter> serializedCache{timingCache->serialize()};
+    error_code errorCode;
+    filesystem::create_directories(engineCacheDir, errorCode);
+    if (serializedCache == nullptr || !write_file_atomic(timingCachePath, serializedCache->data(), serializedCache->size())) {
+        info_string_important("Failed to write the timing cache", timingCachePath);
+    }
+}
+#endif
+
+void TensorrtAPI::configure_network(SampleUniquePtr<nvinfer1::INetworkDefinition> &network, bool useHalfIO)
 {
     // add a softmax layer to the ONNX model
     int policyOutputIdx = -1;
@@ -379,23 +990,265 @@ void TensorrtAPI::configure_network(SampleUniquePtr<nvinfer1::INetworkDefinition
     // set the softmax axis to 1
     softmaxLayer->setAxes(1 << 1);
 
-    // set precision of the first and last layers to float32
-    // 0 is the input layer, 1 the value output and 2 the policy output layer
-//    fix_layer_precision(network->getLayer(0), nvinfer1::DataType::kFLOAT);
-//    fix_layer_precision(softmaxLayer, nvinfer1::DataType::kFLOAT);
-//    fix_layer_precision(network->getLayer(1), nvinfer1::DataType::kFLOAT);
-//    fix_layer_precision(network->getLayer(2), nvinfer1::DataType::kFLOAT);
-
     // set the softmax layer output as the new output
     network->unmarkOutput(*network->getOutput(policyOutputIdx));
     network->markOutput(*softmaxLayer->getOutput(0));
     softmaxLayer->getOutput(0)->setName(nnDesign.policySoftmaxOutputName.c_str());
+
+    if (useHalfIO) {
+        if (halfInput) {
+            network->getInput(0)->setType(nvinfer1::DataType::kHALF);
+        }
+        for (int idx = 0; idx < network->getNbOutputs(); ++idx) {
+            network->getOutput(idx)->setType(nvinfer1::DataType::kHALF);
+        }
+    }
+}
+
+vector<string> TensorrtAPI::get_layer_plan()
+{
+    vector<string> layerNames;
+    if (read_layer_plan(layerPlanPath, layerNames)) {
+        info_string("load layer plan:", layerPlanPath);
+        return layerNames;
+    }
+    info_string("search the layers which stay in higher precision...");
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    layerNames = search_layer_plan();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    info_elapsed_time("Elapsed time for the layer precision search:", begin, end);
+    info_string("layers in higher precision:", layerNames.size());
+
+    error_code errorCode;
+    filesystem::create_directories(engineCacheDir, errorCode);
+    if (!write_layer_plan(layerPlanPath, layerNames)) {
+        info_string_important("Failed to write the layer plan", layerPlanPath);
+    }
+    return layerNames;
+}
+
+vector<string> TensorrtAPI::search_layer_plan()
+{
+#if !defined(MODE_POMMERMAN) && !defined(MODE_OPEN_SPIEL) && !defined(MODE_XIANGQI) && !defined(MODE_STRATEGO) && !defined (MODE_BOARDGAMES)
+    // collect the calibration positions in a single batch
+    unique_ptr<ChessBatchStream> calibrationStream(create_calibration_stream(calibrationFile));
+    if (calibrationStream == nullptr) {
+        return {};
+    }
+    const size_t nbInputValues = StateConstants::NB_VALUES_TOTAL();
+    vector<float> inputs;
+    while (inputs.size() < LAYER_PRECISION_MAX_POSITIONS * nbInputValues && calibrationStream->next()) {
+        const float* batch = calibrationStream->getBatch();
+        inputs.insert(inputs.end(), batch, batch + nbInputValues);
+    }
+    const int numberPositions = int(inputs.size() / nbInputValues);
+    if (numberPositions == 0) {
+        return {};
+    }
+
+    // the compute layers are the candidates, the remaining layers follow the precision of their inputs
+    SampleUniquePtr<IBuilder> builder = SampleUniquePtr<IBuilder>(createInferBuilder(gLogger.getTRTLogger()));
+    SampleUniquePtr<nvinfer1::INetworkDefinition> network;
+    SampleUniquePtr<nvonnxparser::IParser> parser;
+    if (!parse_onnx_model(builder, network, parser)) {
+        return {};
+    }
+    vector<string> candidates;
+    for (int idx = 0; idx < network->getNbLayers(); ++idx) {
+        ILayer* layer = network->getLayer(idx);
+        switch (layer->getType()) {
+        case LayerType::kCONVOLUTION:
+#ifndef TENSORRT10
+        case LayerType::kFULLY_CONNECTED:
+#endif
+        case LayerType::kMATRIX_MULTIPLY:
+            candidates.emplace_back(layer->getName());
+            break;
+        default:
+            break;
+        }
+    }
+    if (candidates.empty()) {
+        return {};
+    }
+    const size_t numberGroups = min(size_t(LAYER_PRECISION_GROUPS), candidates.size());
+
+    shared_ptr<IRuntime> searchRuntime;
+    vector<float> referenceValues;
+    vector<float> referencePolicies;
+    SampleUniquePtr<ICudaEngine> referenceEngine = build_search_engine(float32, {}, numberPositions, searchRuntime);
+    if (referenceEngine == nullptr) {
+        return {};
+    }
+    run_search_engine(*referenceEngine, inputs, numberPositions, referenceValues, referencePolicies);
+    referenceEngine.reset();
+    const size_t nbPolicyValues = referencePolicies.size() / numberPositions;
+
+    auto get_group_layers = [&](const vector<bool>& keepGroups) {
+        vector<string> layerNames;
+        for (size_t idx = 0; idx < candidates.size(); ++idx) {
+            if (keepGroups[get_layer_group(idx, candidates.size(), numberGroups)]) {
+                layerNames.emplace_back(candidates[idx]);
+            }
+        }
+        return layerNames;
+    };
+    auto measure_error = [&](const vector<bool>& keepGroups) {
+        SampleUniquePtr<ICudaEngine> candidateEngine = build_search_engine(precision, get_group_layers(keepGroups), numberPositions, searchRuntime);
+        if (candidateEngine == nullptr) {
+            return numeric_limits<double>::infinity();
+        }
+        vector<float> values;
+        vector<float> policies;
+        run_search_engine(*candidateEngine, inputs, numberPositions, values, policies);
+        const double error = get_output_error(referenceValues, values, referencePolicies, policies, nbPolicyValues);
+        info_string("layer groups in higher precision:", to_string(count(keepGroups.begin(), keepGroups.end(), true)) + " output error: " + to_string(error));
+        return error;
+    };
+    return get_group_layers(select_sensitive_groups(numberGroups, layerPrecisionTolerance, measure_error));
+#else
+    return {};
+#endif
+}
+
+void TensorrtAPI::apply_layer_plan(SampleUniquePtr<nvinfer1::INetworkDefinition>& network, SampleUniquePtr<nvinfer1::IBuilderConfig>& config,
+                                   const vector<string>& layerNames) const
+{
+    if (layerNames.empty() || precision == float32) {
+        return;
+    }
+    const set<string> planLayers(layerNames.begin(), layerNames.end());
+    const nvinfer1::DataType dataType = precision == int8 ? nvinfer1::DataType::kHALF : nvinfer1::DataType::kFLOAT;
+    for (int idx = 0; idx < network->getNbLayers(); ++idx) {
+        ILayer* layer = network->getLayer(idx);
+        if (planLayers.find(layer->getName()) != planLayers.end()) {
+            fix_layer_precision(layer, dataType);
+        }
+    }
+    if (precision == int8) {
+        config->setFlag(BuilderFlag::kFP16);
+    }
+    // without this flag the builder may still pick a faster lower precision kernel for the fixed layers
+#ifdef TENSORRT7
+    config->setFlag(BuilderFlag::kSTRICT_TYPES);
+#else
+    config->setFlag(BuilderFlag::kOBEY_PRECISION_CONSTRAINTS);
+#endif
+}
+
+SampleUniquePtr<ICudaEngine> TensorrtAPI::build_search_engine(Precision searchPrecision, const vector<string>& layerNames, int numberPositions,
+                                                              shared_ptr<IRuntime>& searchRuntime)
+{
+    SampleUniquePtr<IBuilder> builder = SampleUniquePtr<IBuilder>(createInferBuilder(gLogger.getTRTLogger()));
+#ifndef TENSORRT10
+    builder->setMaxBatchSize(numberPositions);
+#endif
+    SampleUniquePtr<nvinfer1::INetworkDefinition> network;
+    SampleUniquePtr<nvonnxparser::IParser> parser;
+    if (!parse_onnx_model(builder, network, parser)) {
+        return nullptr;
+    }
+    // the outputs are compared in float32, so the bindings don't add a conversion error
+    configure_network(network, false);
+
+    SampleUniquePtr<nvinfer1::IBuilderConfig> config = SampleUniquePtr<nvinfer1::IBuilderConfig>(builder->createBuilderConfig());
+    unique_ptr<IInt8Calibrator> calibrator;
+    unique_ptr<IBatchStream> calibrationStream;
+    if (searchPrecision != float32) {
+        // the calibration table is only computed for the first candidate and read from the cache afterwards
+        set_config_settings(config, calibrator, calibrationStream);
+        apply_layer_plan(network, config, layerNames);
+    }
+#ifndef TENSORRT7
+    unique_ptr<ITimingCache> timingCache = load_timing_cache(config);
+#endif
+    IOptimizationProfile* profile = builder->createOptimizationProfile();
+    Dims inputDims = network->getInput(0)->getDimensions();
+    inputDims.d[0] = numberPositions;
+    profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kMIN, inputDims);
+    profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kOPT, inputDims);
+    profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kMAX, inputDims);
+    config->addOptimizationProfile(profile);
+
+#ifdef TENSORRT7
+    return SampleUniquePtr<ICudaEngine>(builder->buildEngineWithConfig(*network, *config));
+#else
+    SampleUniquePtr<IHostMemory> serializedModel{builder->buildSerializedNetwork(*network, *config)};
+    if (!serializedModel) {
+        return nullptr;
+    }
+    save_timing_cache(config);
+    if (searchRuntime == nullptr) {
+        searchRuntime = shared_ptr<IRuntime>(createInferRuntime(sample::gLogger.getTRTLogger()), samplesCommon::InferDeleter());
+    }
+    return SampleUniquePtr<ICudaEngine>(searchRuntime->deserializeCudaEngine(serializedModel->data(), serializedModel->size()));
+#endif
+}
+
+void TensorrtAPI::run_search_engine(ICudaEngine& searchEngine, const vector<float>& inputs, int numberPositions,
+                                    vector<float>& values, vector<float>& policies) const
+{
+    SampleUniquePtr<nvinfer1::IExecutionContext> context(searchEngine.createExecutionContext());
+#ifdef TENSORRT10
+    const int numberTensors = searchEngine.getNbIOTensors();
+    Dims inputDims = searchEngine.getTensorShape(nnDesign.inputLayerName.c_str());
+    inputDims.d[0] = numberPositions;
+    context->setInputShape(nnDesign.inputLayerName.c_str(), inputDims);
+#else
+    const int numberTensors = searchEngine.getNbBindings();
+    const int inputBinding = searchEngine.getBindingIndex(nnDesign.inputLayerName.c_str());
+    Dims inputDims = searchEngine.getBindingDimensions(inputBinding);
+    inputDims.d[0] = numberPositions;
+    context->setBindingDimensions(inputBinding, inputDims);
+#endif
+    vector<void*> buffers(numberTensors, nullptr);
+    vector<size_t> volumes(numberTensors);
+    for (int idx = 0; idx < numberTensors; ++idx) {
+#ifdef TENSORRT10
+        const char* name = searchEngine.getIOTensorName(idx);
+        volumes[idx] = samplesCommon::volume(context->getTensorShape(name));
+#else
+        const char* name = searchEngine.getBindingName(idx);
+        volumes[idx] = samplesCommon::volume(context->getBindingDimensions(idx));
+#endif
+        CHECK(cudaMalloc(&buffers[idx], volumes[idx] * sizeof(float)));
+        if (nnDesign.inputLayerName == name) {
+            CHECK(cudaMemcpy(buffers[idx], inputs.data(), volumes[idx] * sizeof(float), cudaMemcpyHostToDevice));
+        }
+#ifdef TENSORRT10
+        context->setTensorAddress(name, buffers[idx]);
+#endif
+    }
+
+#ifdef TENSORRT10
+    cudaStream_t searchStream;
+    CHECK(cudaStreamCreate(&searchStream));
+    context->enqueueV3(searchStream);
+    CHECK(cudaStreamSynchronize(searchStream));
+    CHECK(cudaStreamDestroy(searchStream));
+#else
+    context->executeV2(buffers.data());
+#endif
+
+    for (int idx = 0; idx < numberTensors; ++idx) {
+#ifdef TENSORRT10
+        const string name = searchEngine.getIOTensorName(idx);
+#else
+        const string name = searchEngine.getBindingName(idx);
+#endif
+        vector<float>* output = name == nnDesign.valueOutputName ? &values : name == nnDesign.policySoftmaxOutputName ? &policies : nullptr;
+        if (output != nullptr) {
+            output->resize(volumes[idx]);
+            CHECK(cudaMemcpy(output->data(), buffers[idx], volumes[idx] * sizeof(float), cudaMemcpyDeviceToHost));
+        }
+        CHECK(cudaFree(buffers[idx]));
+    }
 }
 
 void write_buffer(void* buffer, size_t bufferSize, const string& filePath) {
-    std::ofstream outputFile(filePath,std::ofstream::binary);
-    outputFile.write((const char*) buffer, bufferSize);
-    outputFile.close();
+    if (!write_file_atomic(filePath, buffer, bufferSize)) {
+        info_string("error writing file buffer:", filePath);
+    }
 }
 
 const char* read_buffer(const string& filePath, size_t& bufferSize) {
@@ -417,6 +1270,7 @@ const char* read_buffer(const string& filePath, size_t& bufferSize) {
     inputFile.read(buffer, bufferSize);
     if (!inputFile) {
         info_string("error reading file buffer:", filePath);
+        delete [] buffer;
         return nullptr;
     }
 
@@ -432,10 +1286,16 @@ void fix_layer_precision(ILayer *layer, nvinfer1::DataType dataType)
     }
 }
 
-string generate_trt_file_path(const string &modelDirectory, unsigned int batchSize, Precision precision, int deviceID)
+vector<unsigned int> get_profile_batch_sizes(unsigned int batchSize)
 {
-    return modelDirectory + "model-bsize" + to_string(batchSize) + "-" +
-            precision_to_str(precision)+ "-" + to_string(deviceID) + ".trt";
+    vector<unsigned int> profileBatchSizes = {1};
+    for (unsigned int profileBatchSize = 8; profileBatchSize < batchSize; profileBatchSize *= 2) {
+        profileBatchSizes.emplace_back(profileBatchSize);
+    }
+    if (batchSize > 1) {
+        profileBatchSizes.emplace_back(batchSize);
+    }
+    return profileBatchSizes;
 }
 
 Precision str_to_precision(const string &strPrecision)
@@ -40,6 +40,7 @@
 #include "parserOnnxConfig.h"
 
 #include "NvInfer.h"
+#include "NvOnnxParser.h"
 #include <cuda_runtime_api.h>
 #include "BatchStream.h"
 
@@ -52,6 +53,16 @@ enum Precision {
     int8
 };
 
+/**
+ * @brief The CudaGraphEntry struct stores a captured inference graph for a fixed set of host buffers
+ */
+struct CudaGraphEntry {
+    float* hostBuffers[4];
+    size_t profileIdx;
+    bool gathered;
+    cudaGraphExec_t graphExec;
+};
+
 template <typename T>
     using SampleUniquePtr = std::unique_ptr<T, samplesCommon::InferDeleter>;
 
@@ -76,11 +87,66 @@ private:
 
     // tensorRT runtime engine
     string trtFilePath;
+    // the engine file is stored in this directory under a key which is derived from the engine description
+    string engineCacheDir;
+    string engineDescription;
+    // kernel timings of previous engine builds on the same device type, they are stored in the engine cache directory
+    string timingCachePath;
+    // engine which is shared by all instances on the same device with the same engine description
     std::shared_ptr<nvinfer1::ICudaEngine> engine;
-    SampleUniquePtr<nvinfer1::IExecutionContext> context;
-    SampleUniquePtr<IRuntime> runtime;
+    // batch sizes of the optimization profiles in ascending order, the last entry is the full batch size
+    vector<unsigned int> profileBatchSizes;
+    // one execution context for each optimization profile
+    vector<SampleUniquePtr<nvinfer1::IExecutionContext>> contexts;
+    // number of bindings of a single optimization profile (only used before TensorRT 10)
+    int bindingsPerProfile;
+    // the runtime is kept alive by the deleter of the engine as long as the engine is shared with other instances
+    std::shared_ptr<IRuntime> runtime;
     cudaStream_t stream;
     bool generatedTrtFromONNX;
+    // true on devices which share the memory with the host (e.g. Jetson), the network then reads and writes the host buffers directly
+    bool zeroCopy;
+    // if true, the copy and inference calls are captured once per host buffer set as a CUDA graph and replayed afterwards
+    bool useCudaGraph;
+    vector<CudaGraphEntry> cudaGraphs;
+    // if true, the input planes are transferred as a mask and a value per plane and expanded on the device
+    bool packedInputPlanes;
+    uint64_t* packedMasks;
+    float* packedValues;
+    void* devicePackedMasks;
+    void* devicePackedValues;
+    // if true, the outputs (and the input unless it is packed) are transferred in half precision
+    bool halfIO;
+    bool halfInput;
+    // pinned half precision staging buffers on the host
+    uint16_t* halfHostBuffers[4];
+    // output buffers and batch size of the last inference which are filled from the staging buffers in wait()
+    float* pendingOutputs[4];
+    size_t pendingBatchSize;
+    // if true, only the policy entries of the legal moves are copied back to the host
+    bool gatherPolicy;
+    const uint32_t* gatherIndices;
+    const uint32_t* gatherCounts;
+    uint32_t* hostGatherIndices;
+    uint32_t* hostGatherCounts;
+    void* deviceGatherIndices;
+    void* deviceGatherCounts;
+    void* deviceGatheredPolicy;
+    bool pendingGathered;
+    // events before the input transfer, after the input transfer, after the execution and after the output transfer
+    bool stageTiming;
+    cudaEvent_t stageEvents[4];
+    StageTimings lastStageTimings;
+    // EPD file with the positions for the INT8 calibration (the sample games are used if empty)
+    string calibrationFile;
+    // if true, the layers which stay in a higher precision in INT8 and FP16 engines are selected by a sensitivity search
+    bool searchLayerPrecision;
+    // maximum deviation from the float32 outputs which is accepted by the search (see get_output_error())
+    double layerPrecisionTolerance;
+    // the selected layers are stored as a layer plan in the engine cache directory
+    string layerPlanPath;
+    // bytes of the buffers and execution contexts on the device which have been added to the memory statistics
+    size_t deviceMemorySize;
 public:
     /**
      * @brief TensorrtAPI
@@ -89,11 +155,31 @@ public:
      * @param modelDirectory Directory where the network architecture is stored (.json file) and
      * where parameters a.k.a weights of the neural are stored (.params file) are stored
      * @param precision Inference precision type. Available options: float32, float16, int8 (float32 is default).
+     * @param useCudaGraph If true, the inference is replayed as a CUDA graph
+     * @param dynamicBatchProfiles If true, a single engine with optimization profiles for smaller batch sizes is built from the dynamic onnx model
+     * @param engineCacheDirectory Directory where the serialized engines are cached (the model directory is used if empty)
+     * @param packedInputPlanes If true, the input planes are packed on the host and expanded on the device (requires CUDA_KERNELS)
+     * @param halfIO If true, the input and output bindings of the network use half precision
+     * @param gatherPolicy If true, set_policy_gather() is supported (requires CUDA_KERNELS)
+     * @param calibrationFile EPD file which is streamed for the INT8 calibration (the built-in sample games are used if empty)
+     * @param searchLayerPrecision If true, the layers which stay in a higher precision are selected by comparing candidate engines to float32
+     * @param layerPrecisionTolerance Maximum output error of the selected layer plan (see get_output_error())
      */
-    TensorrtAPI(int deviceID, unsigned int batchSize, const string& modelDirectory, const string& strPrecision);
+    TensorrtAPI(int deviceID, unsigned int batchSize, const string& modelDirectory, const string& strPrecision, bool useCudaGraph=false,
+                bool dynamicBatchProfiles=false, const string& engineCacheDirectory="", bool packedInputPlanes=false, bool halfIO=false,
+                bool gatherPolicy=false, const string& calibrationFile="", bool searchLayerPrecision=false, double layerPrecisionTolerance=0.01);
     ~TensorrtAPI();
 
     void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict_async(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void wait() override;
+    float* allocate_host_buffer(size_t numberValues) override;
+    void free_host_buffer(float* buffer) override;
+    bool supports_policy_gather() const override;
+    void set_policy_gather(const uint32_t* indices, const uint32_t* counts) override;
+    int get_numa_node() const override;
+    bool set_stage_timing(bool enable) override;
+    StageTimings get_stage_timings() const override;
 
 #ifndef TENSORRT10
     /**
@@ -105,12 +191,91 @@ public:
 #endif
 
 private:
+    /**
+     * @brief map_host_buffer Returns the device address of a mapped host buffer in zero copy mode
+     * @param hostBuffer Host buffer
+     * @param devicePointer Device address, will only be changed if the buffer is mapped
+     * @return True, if the device can access the host buffer directly
+     */
+    bool map_host_buffer(float* hostBuffer, void*& devicePointer) const;
+
+    /**
+     * @brief enqueue_inference Enqueues the input copy, the inference and the output copies on the stream
+     * @param profileIdx Index of the optimization profile to use
+     * @param packed If true, the packed input planes are copied and expanded instead of the input planes
+     * @param gathered If true, only the policy entries of the legal moves are copied back
+     */
+    void enqueue_inference(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t profileIdx, bool packed,
+                           bool gathered);
+
+    /**
+     * @brief get_cuda_graph Returns the graph for the given host buffers and profile and captures a new one if needed
+     * @return Pointer to the graph or nullptr if capturing failed
+     */
+    const CudaGraphEntry* get_cuda_graph(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t profileIdx, bool packed,
+                                         bool gathered);
+
+    /**
+     * @brief pack_input_planes Packs the input planes of the given profile into the pinned packed buffers
+     * @return True, if all planes could be packed
+     */
+    bool pack_input_planes(const float* inputPlanes, size_t profileIdx);
+
+    /**
+     * @brief select_profile Returns the smallest optimization profile which fits the current number of positions
+     * @return Profile index
+     */
+    size_t select_profile() const;
+
+    /**
+     * @brief add_device_memory Adds allocated device memory to deviceMemorySize and the memory statistics
+     * @param numberBytes Number of allocated bytes
+     */
+    void add_device_memory(size_t numberBytes);
+
     void load_model() override;
     void load_parameters() override;
     void bind_executor() override;
 
     void init_nn_design() override;
 
+    /**
+     * @brief get_engine_description Describes everything the serialized engine depends on. It is used as the cache key.
+     * @param deviceProp Properties of the selected device
+     * @return Single line description
+     */
+    string get_engine_description(const cudaDeviceProp& deviceProp) const;
+
+    /**
+     * @brief get_device_description Describes the device and the library versions. It is used as the key of the timing cache.
+     * @param deviceProp Properties of the selected device
+     * @return Single line description
+     */
+    string get_device_description(const cudaDeviceProp& deviceProp) const;
+
+    /**
+     * @brief get_calibration_cache_path Returns the path of the INT8 calibration table which is keyed by the hash of the model and the calibration data
+     * @return File path
+     */
+    string get_calibration_cache_path() const;
+
+    /**
+     * @brief get_layer_plan_description Describes everything the layer plan depends on. It is used as the key of the layer plan.
+     * @param deviceProp Properties of the selected device
+     * @return Single line description
+     */
+    string get_layer_plan_description(const cudaDeviceProp& deviceProp) const;
+
+    /**
+     * @brief parse_onnx_model Creates a network definition from the ONNX model file
+     * @param builder Engine builder
+     * @param network Returns the network definition
+     * @param parser Returns the parser which holds the weights of the network and must outlive the engine build
+     * @return True on success
+     */
+    bool parse_onnx_model(SampleUniquePtr<IBuilder>& builder, SampleUniquePtr<nvinfer1::INetworkDefinition>& network,
+                          SampleUniquePtr<nvonnxparser::IParser>& parser) const;
+
     /**
      * @brief createCudaEngineFromONNX Creates a new cuda engine from a onnx model architecture
      * @return ICudaEngine*
@@ -134,12 +299,75 @@ private:
                              unique_ptr<IInt8Calibrator>& calibrator,
                              unique_ptr<IBatchStream>& calibrationStream);
 
+#ifndef TENSORRT7
+    /**
+     * @brief load_timing_cache Creates the timing cache of the builder configuration from the timing cache file.
+     * An empty timing cache is created if the file doesn't exist or can't be read.
+     * @param config Configuration object
+     * @return Timing cache which must outlive the engine build
+     */
+    unique_ptr<ITimingCache> load_timing_cache(SampleUniquePtr<nvinfer1::IBuilderConfig>& config) const;
+
+    /**
+     * @brief save_timing_cache Merges the timings of the last build with the current content of the timing cache file
+     * (which may have been updated by other processes meanwhile) and writes it back atomically
+     * @param config Configuration object which was used for the build
+     */
+    void save_timing_cache(SampleUniquePtr<nvinfer1::IBuilderConfig>& config) const;
+#endif
+
 
     /**
      * @brief configure_network Adds a softmax layer and extracts the I/O-dimensions of the network
      * @param network ONNX network object
+     * @param useHalfIO If true, the bindings use half precision (see halfIO and halfInput)
+     */
+    void configure_network(SampleUniquePtr<nvinfer1::INetworkDefinition>& network, bool useHalfIO);
+
+    /**
+     * @brief get_layer_plan Returns the names of the layers which stay in a higher precision.
+     * The plan is read from the cache directory or searched and stored if there is none yet.
+     * @return Layer names
+     */
+    vector<string> get_layer_plan();
+
+    /**
+     * @brief search_layer_plan Measures the sensitivity of contiguous groups of compute layers on the calibration positions
+     * and selects the groups which stay in a higher precision (see select_sensitive_groups())
+     * @return Layer names
+     */
+    vector<string> search_layer_plan();
+
+    /**
+     * @brief apply_layer_plan Fixes the precision of the given layers to float16 for INT8 engines or to float32 for FP16 engines
+     * @param network Network definition
+     * @param config Configuration object
+     * @param layerNames Names of the layers which stay in a higher precision
+     */
+    void apply_layer_plan(SampleUniquePtr<nvinfer1::INetworkDefinition>& network, SampleUniquePtr<nvinfer1::IBuilderConfig>& config,
+                          const vector<string>& layerNames) const;
+
+    /**
+     * @brief build_search_engine Builds an engine with float32 bindings and a single profile for the layer precision search
+     * @param searchPrecision Precision of the engine
+     * @param layerNames Names of the layers which stay in a higher precision
+     * @param numberPositions Batch size of the profile
+     * @param searchRuntime Runtime which deserializes the engine, it must outlive the engine
+     * @return Engine or nullptr if the build failed
+     */
+    SampleUniquePtr<ICudaEngine> build_search_engine(Precision searchPrecision, const vector<string>& layerNames, int numberPositions,
+                                                     shared_ptr<IRuntime>& searchRuntime);
+
+    /**
+     * @brief run_search_engine Runs the positions through an engine of build_search_engine()
+     * @param searchEngine Engine
+     * @param inputs Input planes of all positions
+     * @param numberPositions Number of positions
+     * @param values Returns the value outputs
+     * @param policies Returns the policy outputs
      */
-    void configure_network(SampleUniquePtr<nvinfer1::INetworkDefinition>& network);
+    void run_search_engine(ICudaEngine& searchEngine, const vector<float>& inputs, int numberPositions,
+                           vector<float>& values, vector<float>& policies) const;
 };
 
 /**
@@ -181,14 +409,11 @@ string precision_to_str(Precision precision);
 Precision str_to_precision( const string& strPrecision);
 
 /**
- * @brief generate_trt_file_path Generates the trt file path based on the given parameters
- * @param modelDirectory Directoy where the ONNX file is located
- * @param batchSize Batch size to use for inference
- * @param precision Precision
- * @param deviceID Computing device
- * @return trt-file-path (string)
+ * @brief get_profile_batch_sizes Returns the batch sizes for the optimization profiles: 1, 8, 16, 32, ... up to the given batch size
+ * @param batchSize Maximum batch size
+ * @return Ascending batch sizes, the last entry is always batchSize
  */
-string generate_trt_file_path(const string &modelDirectory, unsigned int batchSize, Precision precision, int deviceID);
+vector<unsigned int> get_profile_batch_sizes(unsigned int batchSize);
 
 /**
  * @brief set_shape Converter function from nvinfer1::Dims to nn_api::Shape
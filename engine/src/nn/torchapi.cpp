@@ -26,10 +26,16 @@
 #ifdef TORCH
 #include "torchapi.h"
 #include "stateobj.h"
+#ifdef TORCH_CUDA
+#include <c10/cuda/CUDAGuard.h>
+#endif
 
-TorchAPI::TorchAPI(const string& ctx, int deviceID, unsigned int miniBatchSize, const string &modelDirectory):
+TorchAPI::TorchAPI(const string& ctx, int deviceID, unsigned int miniBatchSize, const string &modelDirectory, bool useHalfPrecision,
+                   bool useChannelsLast):
     NeuralNetAPI(ctx, deviceID, miniBatchSize, modelDirectory, false),
-    device(torch::kCPU)
+    device(torch::kCPU),
+    useHalfPrecision(useHalfPrecision),
+    useChannelsLast(useChannelsLast)
 {
     modelFilePath = modelDir + "model-bsize-" + to_string(batchSize) + ".pt";
     if (ctx == "cpu" || ctx == "CPU") {
@@ -44,26 +50,45 @@ TorchAPI::TorchAPI(const string& ctx, int deviceID, unsigned int miniBatchSize,
 
 void TorchAPI::predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs)
 {
-    // Create a vector of inputs.
-    std::vector<torch::jit::IValue> inputs = {torch::from_blob(inputPlanes, {batchSize, StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH()}, device)};
+    // disables the autograd tracking and the version counters of the tensors
+    c10::InferenceMode guard;
+#ifdef TORCH_CUDA
+    c10::optional<c10::cuda::CUDAStreamGuard> streamGuard;
+    if (stream) {
+        streamGuard.emplace(*stream);
+    }
+#endif
+    std::copy(inputPlanes, inputPlanes + numberPositions * get_nb_input_values_total(), hostInput.data_ptr<float>());
+    if (deviceInput.data_ptr() != hostInput.data_ptr()) {
+        // converts the precision and the memory format on the device
+        deviceInput.copy_(hostInput, true);
+    }
 
-    // Execute the model and turn its output into a tensor.
-    auto output = module.forward(inputs).toList();
+    const auto output = module.forward({deviceInput}).toList();
 
-    const float* torchValuePt = output.get(0).toTensor().data_ptr<float>();
-    std::copy(torchValuePt, torchValuePt+batchSize, valueOutput);
-    const float* torchPolicyPt = torch::softmax(output.get(1).toTensor(), 1).data_ptr<float>();
-    std::copy(torchPolicyPt, torchPolicyPt+get_policy_output_length(), probOutputs);
-#ifdef DYNAMIC_NN_ARCH
-    if (has_auxiliary_outputs()) {
-#else
-    if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
-#endif
-        const float* torchAuxiliaryPt = output.get(2).toTensor().data_ptr<float>();
-        std::copy(torchAuxiliaryPt, torchAuxiliaryPt+get_nb_auxiliary_outputs()*batchSize, auxiliaryOutputs);
+    // the blocking copies synchronize the stream of this instance
+    copy_output(output.get(nnDesign.valueOutputIdx).toTensor(), valueOutput, nnDesign.valueOutputShape);
+    copy_output(output.get(nnDesign.policyOutputIdx).toTensor(), probOutputs, nnDesign.policyOutputShape);
+    if (has_auxiliary_outputs() && auxiliaryOutputs != nullptr) {
+        copy_output(output.get(nnDesign.auxiliaryOutputIdx).toTensor(), auxiliaryOutputs, nnDesign.auxiliaryOutputShape);
+    }
+    for (unsigned int batchIdx = 0; batchIdx < numberPositions; ++batchIdx) {
+        apply_softmax(probOutputs + batchIdx * get_nb_policy_values(), get_nb_policy_values());
     }
 }
 
+void TorchAPI::copy_output(const at::Tensor& output, float* buffer, const nn_api::Shape& shape)
+{
+    vector<int64_t> sizes(shape.v, shape.v + shape.nbDims);
+    sizes[0] = numberPositions;
+    torch::from_blob(buffer, sizes, torch::TensorOptions().dtype(torch::kFloat32)).copy_(output.narrow(0, 0, numberPositions));
+}
+
+torch::TensorOptions TorchAPI::get_input_options() const
+{
+    return torch::TensorOptions().device(device).dtype(useHalfPrecision ? torch::kFloat16 : torch::kFloat32);
+}
+
 void TorchAPI::load_model()
 {
     try {
@@ -73,6 +98,17 @@ void TorchAPI::load_model()
     catch (const c10::Error& e) {
       std::cerr << "error loading the model: " <<  modelFilePath << std::endl;
     }
+    module.eval();
+    if (useHalfPrecision) {
+        module.to(torch::kFloat16);
+    }
+    if (useChannelsLast) {
+        for (at::Tensor parameter : module.parameters()) {
+            if (parameter.dim() == 4) {
+                parameter.set_data(parameter.contiguous(at::MemoryFormat::ChannelsLast));
+            }
+        }
+    }
 }
 
 void TorchAPI::load_parameters()
@@ -82,16 +118,28 @@ void TorchAPI::load_parameters()
 
 void TorchAPI::bind_executor()
 {
-    // pass
+    const vector<int64_t> inputSizes(nnDesign.inputShape.v, nnDesign.inputShape.v + nnDesign.inputShape.nbDims);
+    // pinned memory allows asynchronous copies to the device
+    hostInput = torch::zeros(inputSizes, torch::TensorOptions().dtype(torch::kFloat32).pinned_memory(device.is_cuda()));
+    if (device.is_cuda() || useHalfPrecision || useChannelsLast) {
+        deviceInput = torch::zeros(inputSizes, get_input_options().memory_format(useChannelsLast ? at::MemoryFormat::ChannelsLast : at::MemoryFormat::Contiguous));
+    }
+    else {
+        deviceInput = hostInput;
+    }
+#ifdef TORCH_CUDA
+    if (device.is_cuda()) {
+        stream = c10::cuda::getStreamFromPool(false, deviceID);
+    }
+#endif
 }
 
 void TorchAPI::init_nn_design()
 {
-    float* inputPlanes = new float[batchSize*StateConstants::NB_VALUES_TOTAL()];
-
+    c10::InferenceMode guard;
     // Create a vector of inputs.
     const at::IntArrayRef inputShape = {batchSize, StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH()};
-    std::vector<torch::jit::IValue> inputs = {torch::from_blob(inputPlanes, inputShape, device)};
+    std::vector<torch::jit::IValue> inputs = {torch::zeros(inputShape, get_input_options())};
 
     auto output = module.forward(inputs).toList();
 
@@ -33,6 +33,9 @@
 
 #include "neuralnetapi.h"
 #include <torch/script.h>
+#ifdef TORCH_CUDA
+#include <c10/cuda/CUDAStream.h>
+#endif
 
 /**
  * @brief The TorchAPI class implements access to the Lib Torch-C++ back-end for running inference on CPU and GPU for torchscript models.
@@ -42,8 +45,27 @@ class TorchAPI : public NeuralNetAPI
 private:
     torch::jit::script::Module module;
     torch::Device device;
+    bool useHalfPrecision;
+    bool useChannelsLast;
+    // pre-allocated input tensors: the host tensor uses pinned memory for the GPU, the device tensor has the precision and memory format of the model
+    torch::Tensor hostInput;
+    torch::Tensor deviceInput;
+#ifdef TORCH_CUDA
+    // every instance runs on its own stream, so that the search threads don't serialize on the default stream
+    c10::optional<c10::cuda::CUDAStream> stream;
+#endif
 public:
-    TorchAPI(const string& ctx, int deviceID, unsigned int miniBatchSize, const string& modelDirectory);
+    /**
+     * @brief TorchAPI
+     * @param ctx Context, "cpu" or "gpu"
+     * @param deviceID Device ID of the GPU
+     * @param miniBatchSize Batch size
+     * @param modelDirectory Directory which contains the torchscript file "model-bsize-<batchSize>.pt"
+     * @param useHalfPrecision Converts the model and its inputs to float16
+     * @param useChannelsLast Uses the channels-last memory format for the weights and the inputs of the convolutions
+     */
+    TorchAPI(const string& ctx, int deviceID, unsigned int miniBatchSize, const string& modelDirectory, bool useHalfPrecision=false,
+             bool useChannelsLast=false);
 
     // NeuralNetAPI interface
     void predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs) override;
@@ -53,6 +75,21 @@ protected:
     void load_parameters() override;
     void bind_executor() override;
     void init_nn_design() override;
+
+private:
+    /**
+     * @brief get_input_options Returns the tensor options of the model inputs
+     * @return Tensor options
+     */
+    torch::TensorOptions get_input_options() const;
+
+    /**
+     * @brief copy_output Copies the first numberPositions rows of an output into the given buffer without a temporary tensor
+     * @param output Output of the model
+     * @param buffer Target buffer on the host
+     * @param shape Shape of the output
+     */
+    void copy_output(const at::Tensor& output, float* buffer, const nn_api::Shape& shape);
 };
 
 /**
@@ -26,9 +26,60 @@
 #include "node.h"
 #include <limits.h>
 #include "util/blazeutil.h" // get_dirichlet_noise()
+#include "util/puctselection.h"
+#include "util/policykernels.h"
 #include "constants.h"
 #include "../util/communication.h"
 #include "evalinfo.h"
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+#include "util/tablebaseprober.h"
+#include "agents/util/treeexport.h"
+#include "util/memorystats.h"
+#ifdef MCTS_COMPACT_LEAVES
+#include "util/halfconversion.h"
+#endif
+
+#ifdef MCTS_ALIGNED_NODES
+// layout test: the read-mostly fields of a node occupy the first cache line(s) and the written fields start on the next one
+struct NodeLayout {
+    static_assert(alignof(Node) == CACHE_LINE_SIZE, "The hot fields of Node must be aligned to a cache line");
+    static_assert(alignof(NodeData) == CACHE_LINE_SIZE, "The hot fields of NodeData must be aligned to a cache line");
+    static_assert(sizeof(Node) % CACHE_LINE_SIZE == 0, "Consecutive nodes must not share a cache line");
+    static_assert(offsetof(Node, mtx) % CACHE_LINE_SIZE == 0 && offsetof(Node, mtx) >= offsetof(Node, d) + sizeof(Node::d),
+                  "The mutex of Node must start the cache line after the read-mostly fields");
+    static_assert(offsetof(Node, realVisitsSum) / CACHE_LINE_SIZE == offsetof(Node, mtx) / CACHE_LINE_SIZE &&
+                  offsetof(Node, valueSum) / CACHE_LINE_SIZE == offsetof(Node, mtx) / CACHE_LINE_SIZE,
+                  "The visits and the value sum of Node must share the cache line of its mutex");
+    static_assert(offsetof(NodeData, freeVisits) % CACHE_LINE_SIZE == 0 && offsetof(NodeData, freeVisits) >= offsetof(NodeData, nodeTypes) + sizeof(NodeData::nodeTypes),
+                  "The visit counters of NodeData must start the cache line after the child vectors");
+    static_assert(offsetof(NodeData, visitSum) / CACHE_LINE_SIZE == offsetof(NodeData, freeVisits) / CACHE_LINE_SIZE,
+                  "The visit counters of NodeData must share a cache line");
+};
+#endif
+
+/**
+ * @brief add_node_memory_stats Adds (sign 1) or removes (sign -1) the memory of a node and its node data to the memory statistics.
+ * The counters are only approximate while vectors grow.
+ */
+static void add_node_memory_stats(const Node* node, int64_t sign)
+{
+    const int64_t nodeDataMemorySize = int64_t(node->get_node_data_memory_size());
+    memory_stats().add(MEMORY_NODES, sign * (int64_t(node->get_memory_size()) - nodeDataMemorySize));
+    memory_stats().add(MEMORY_NODE_DATA, sign * nodeDataMemorySize);
+}
+
+#ifndef MCTS_NODE_POOL
+// child nodes of destroyed nodes which are released by the outermost destructor call of the current thread
+struct NodeReleaseQueue {
+    vector<NodeLink> pendingNodes;
+    size_t yieldInterval = 0;
+    bool isReleasing = false;
+};
+static thread_local NodeReleaseQueue nodeReleaseQueue;
+#endif
 
 
 bool Node::is_sorted() const
@@ -59,7 +110,7 @@ uint8_t Node::get_virtual_loss_counter(ChildIdx childIdx) const
 bool Node::has_transposition_child_node()
 {
     for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-        const Node* childNode = it->get();
+        const Node* childNode = get_node_ptr(*it);
         if (childNode != nullptr && childNode->is_transposition()) {
             return true;
         }
@@ -75,34 +126,76 @@ StateObj* Node::get_state() const
 
 void Node::set_auxiliary_outputs(const float* auxiliaryOutputs)
 {
-    state->set_auxiliary_outputs(auxiliaryOutputs);
+    // the outputs of a leaf with a released state are dropped, the in-tree states ignore them anyway
+    if (state != nullptr) {
+        state->set_auxiliary_outputs(auxiliaryOutputs);
+    }
+}
+
+#ifdef MCTS_RELEASE_LEAF_STATES
+unique_ptr<StateObj> Node::release_state()
+{
+    if (state != nullptr) {
+        memory_stats().add(MEMORY_STATES, -int64_t(sizeof(StateObj)));
+    }
+    return std::move(state);
+}
+
+void Node::set_state(StateObj* newState)
+{
+    if (state != nullptr) {
+        delete newState;
+        return;
+    }
+    state = unique_ptr<StateObj>(newState);
+    memory_stats().add(MEMORY_STATES, sizeof(StateObj));
 }
 #endif
+#endif
 
 Node::Node(StateObj* state, const SearchSettings* searchSettings):
-    legalActions(state->legal_actions()),
     key(state->hash_key()),
-    valueSum(0),
     d(nullptr),
     #ifdef MCTS_STORE_STATES
     state(state),
     #endif
+    #ifdef MCTS_COMPACT_LEAVES
+    numberCompactChildNodes(0),
+    hasCompactActions(false),
+    #endif
+    #ifdef MCTS_PARTIAL_SORT
+    numberSortedChildNodes(0),
+    #endif
+    valueSum(0),
     realVisitsSum(0),
-    pliesFromNull(state->steps_from_null()),
     numberParentNodes(1),
+    pliesFromNull(state->steps_from_null()),
     isTerminal(false),
     isTablebase(false),
     hasNNResults(false),
+    isFastEvaluation(false),
     sorted(false)
 {
-    // specify the number of direct child nodes of this node
-    check_for_terminal(state);
+    if (state->is_draw_by_rule()) {
+        // the legal moves of a drawn position aren't needed
+        mark_as_terminal();
+        mark_as_draw();
+    }
+    else {
+        // the legal actions are generated once and shared by the terminal check, the policy mapping and the move selection
+        legalActions = state->legal_actions();
+        check_for_terminal(state);
+    }
 #ifdef MCTS_TB_SUPPORT
     if (searchSettings->useTablebase && !isTerminal) {
         check_for_tablebase_wdl(state);
     }
 #endif
     policyProbSmall.resize(legalActions.size());
+    add_node_memory_stats(this, 1);
+#ifdef MCTS_STORE_STATES
+    memory_stats().add(MEMORY_STATES, sizeof(StateObj));
+#endif
 }
 
 bool Node::solved_win(const Node* childNode, const SearchSettings* searchSettings) const
@@ -138,8 +231,8 @@ bool Node::at_least_one_drawn_child() const
 {
     bool atLeastOneDrawnChild = false;
     for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-        const Node* childNode = it->get();
-        if (!childNode->is_playout_node() || (childNode->d->nodeType != DRAW && childNode->d->nodeType != WIN)) {
+        const Node* childNode = get_node_ptr(*it);
+        if (childNode == nullptr || !childNode->is_playout_node() || (childNode->d->nodeType != DRAW && childNode->d->nodeType != WIN)) {
             return false;
         }
         if (childNode->d->nodeType == DRAW) {
@@ -267,8 +360,8 @@ void Node::define_end_ply_for_solved_terminal(const Node* childNode)
     if (d->nodeType == LOSS) {
         // choose the longest pv line
         for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-            const Node* curChildNode = it->get();
-            if (curChildNode->d->endInPly+1 > d->endInPly) {
+            const Node* curChildNode = get_node_ptr(*it);
+            if (curChildNode != nullptr && curChildNode->d->endInPly+1 > d->endInPly) {
                 d->endInPly = curChildNode->d->endInPly+1;
             }
         }
@@ -277,8 +370,8 @@ void Node::define_end_ply_for_solved_terminal(const Node* childNode)
     if (d->nodeType == DRAW) {
         // choose the shortest pv line for draws
         for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-            const Node* curChildNode = it->get();
-            if (curChildNode->d->nodeType == DRAW && curChildNode->d->endInPly+1 < d->endInPly) {
+            const Node* curChildNode = get_node_ptr(*it);
+            if (curChildNode != nullptr && curChildNode->d->nodeType == DRAW && curChildNode->d->endInPly+1 < d->endInPly) {
                 d->endInPly = curChildNode->d->endInPly+1;
             }
         }
@@ -301,7 +394,7 @@ void Node::mcts_policy_based_on_wins(DynamicVector<double> &mctsPolicy, const Se
     mctsPolicy = 0;
     ChildIdx childIdx = 0;
     for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-        const Node* childNode = it->get();
+        const Node* childNode = get_node_ptr(*it);
         if (childNode != nullptr && childNode->d != nullptr) {
             switch (searchSettings->searchPlayerMode) {
             case MODE_TWO_PLAYER:
@@ -326,7 +419,7 @@ void Node::mcts_policy_based_on_losses(DynamicVector<double> &mctsPolicy) const
     ChildIdx longestChildIdx = 0;
     size_t endInPly = 0;
     for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-        const Node* childNode = it->get();
+        const Node* childNode = get_node_ptr(*it);
         if (childNode != nullptr && childNode->d != nullptr) {
             if (childNode->d->endInPly > endInPly) {
                 endInPly = childNode->d->endInPly;
@@ -344,7 +437,7 @@ void Node::prune_losses_in_mcts_policy(DynamicVector<double> &mctsPolicy, const
     if (d->numberUnsolvedChildNodes != get_number_child_nodes() && !is_loss_node_type(d->nodeType)) {
         // set all entries which lead to a WIN of the opponent to zero
         for (size_t childIdx = 0; childIdx < d->noVisitIdx; ++childIdx) {
-            const Node* childNode = d->childNodes[childIdx].get();
+            const Node* childNode = get_node_ptr(d->childNodes[childIdx]);
             if (childNode != nullptr && childNode->is_playout_node()) {
                 switch (searchSettings->searchPlayerMode) {
                 case MODE_TWO_PLAYER:
@@ -364,7 +457,7 @@ void Node::prune_losses_in_mcts_policy(DynamicVector<double> &mctsPolicy, const
 
 bool Node::solve_for_terminal(ChildIdx childIdx, const SearchSettings* searchSettings)
 {
-    const Node* childNode = d->childNodes[childIdx].get();
+    const Node* childNode = get_node_ptr(d->childNodes[childIdx]);
 
     if (!childNode->is_playout_node()) {
         return false;
@@ -459,37 +552,159 @@ bool Node::is_root_node() const
 
 Node::~Node()
 {
+    add_node_memory_stats(this, -1);
+#ifdef MCTS_STORE_STATES
+    if (state != nullptr) {
+        memory_stats().add(MEMORY_STATES, -int64_t(sizeof(StateObj)));
+    }
+#endif
+#ifndef MCTS_NODE_POOL
+    if (d == nullptr) {
+        return;
+    }
+    // the child links are moved out to avoid a recursive destruction of the subtree
+    for (NodeLink& childNode : d->childNodes) {
+        if (childNode != nullptr) {
+            nodeReleaseQueue.pendingNodes.emplace_back(std::move(childNode));
+        }
+    }
+    if (nodeReleaseQueue.isReleasing) {
+        return;
+    }
+    nodeReleaseQueue.isReleasing = true;
+    size_t releasedNodes = 0;
+    while (!nodeReleaseQueue.pendingNodes.empty()) {
+        NodeLink childNode = std::move(nodeReleaseQueue.pendingNodes.back());
+        nodeReleaseQueue.pendingNodes.pop_back();
+        // the node is only destroyed if no other parent node or search thread holds a reference
+        childNode = nullptr;
+        if (nodeReleaseQueue.yieldInterval != 0 && ++releasedNodes % nodeReleaseQueue.yieldInterval == 0) {
+            this_thread::yield();
+        }
+    }
+    nodeReleaseQueue.isReleasing = false;
+#endif
 }
 
 void Node::sort_moves_by_probabilities()
 {
+#ifdef MCTS_PARTIAL_SORT
+    // most moves of large move lists are never visited
+    extend_sorted_moves(PARTIAL_SORT_STEP);
+#else
     auto p = sort_permutation(policyProbSmall, std::greater<float>());
     apply_permutation_in_place(policyProbSmall, p);
     apply_permutation_in_place(legalActions, p);
+#endif
     sorted = true;
 }
 
+#ifdef MCTS_PARTIAL_SORT
+void Node::extend_sorted_moves(size_t numberSorted)
+{
+    const size_t numberChildNodes = legalActions.size();
+    numberSorted = min(numberSorted, numberChildNodes);
+    if (numberSorted <= numberSortedChildNodes) {
+        return;
+    }
+    vector<pair<float, Action>> moves(numberChildNodes - numberSortedChildNodes);
+    for (size_t idx = numberSortedChildNodes; idx < numberChildNodes; ++idx) {
+        moves[idx - numberSortedChildNodes] = {policyProbSmall[idx], legalActions[idx]};
+    }
+    partial_sort(moves.begin(), moves.begin() + (numberSorted - numberSortedChildNodes), moves.end(),
+                 [](const pair<float, Action>& a, const pair<float, Action>& b) { return a.first > b.first; });
+    for (size_t idx = numberSortedChildNodes; idx < numberChildNodes; ++idx) {
+        policyProbSmall[idx] = moves[idx - numberSortedChildNodes].first;
+        legalActions[idx] = moves[idx - numberSortedChildNodes].second;
+    }
+    numberSortedChildNodes = uint16_t(numberSorted);
+}
+#endif
+
+void Node::sort_unvisited_moves()
+{
+#ifdef MCTS_PARTIAL_SORT
+    const size_t numberSorted = numberSortedChildNodes;
+    numberSortedChildNodes = min(numberSortedChildNodes, d->noVisitIdx);
+    extend_sorted_moves(numberSorted);
+#else
+    const size_t numberChildNodes = legalActions.size();
+    if (d->noVisitIdx >= numberChildNodes) {
+        return;
+    }
+    vector<pair<float, Action>> moves(numberChildNodes - d->noVisitIdx);
+    for (size_t idx = d->noVisitIdx; idx < numberChildNodes; ++idx) {
+        moves[idx - d->noVisitIdx] = {policyProbSmall[idx], legalActions[idx]};
+    }
+    sort(moves.begin(), moves.end(), [](const pair<float, Action>& a, const pair<float, Action>& b) { return a.first > b.first; });
+    for (size_t idx = d->noVisitIdx; idx < numberChildNodes; ++idx) {
+        policyProbSmall[idx] = moves[idx - d->noVisitIdx].first;
+        legalActions[idx] = moves[idx - d->noVisitIdx].second;
+    }
+#endif
+}
+
 Action Node::get_action(ChildIdx childIdx) const
 {
+#ifdef MCTS_COMPACT_LEAVES
+    if (hasCompactActions) {
+        return Action(compactData[numberCompactChildNodes + childIdx]);
+    }
+#endif
     return legalActions[childIdx];
 }
 
 Node *Node::get_child_node(ChildIdx childIdx) const
 {
-    return d->childNodes[childIdx].get();
+    return get_node_ptr(d->childNodes[childIdx]);
+}
+
+NodeLink Node::detach_child_node(ChildIdx childIdx)
+{
+#ifdef MCTS_NODE_POOL
+    const NodeLink link = d->childNodes[childIdx];
+    d->childNodes[childIdx] = NO_NODE_IDX;
+    return link;
+#else
+    return atomic_exchange(&d->childNodes[childIdx], shared_ptr<Node>());
+#endif
+}
+
+size_t Node::get_node_data_memory_size() const
+{
+    return d == nullptr ? 0 : d->get_memory_size();
+}
+
+size_t Node::get_memory_size() const
+{
+    size_t memorySize = sizeof(Node) + legalActions.capacity() * sizeof(Action) + policyProbSmall.capacity() * sizeof(float);
+    if (d != nullptr) {
+        memorySize += d->get_memory_size();
+    }
+#ifdef MCTS_COMPACT_LEAVES
+    if (compactData != nullptr) {
+        memorySize += numberCompactChildNodes * (hasCompactActions ? 2 : 1) * sizeof(uint16_t);
+    }
+#endif
+    return memorySize;
 }
 
 shared_ptr<Node> Node::get_child_node_shared(ChildIdx childIdx) const
 {
+#ifdef MCTS_NODE_POOL
+    // non-owning handle: the node is freed by the garbage collector once it has no parent nodes left
+    return shared_ptr<Node>(get_child_node(childIdx), [](Node*){});
+#else
     return d->childNodes[childIdx];
+#endif
 }
 
-vector<shared_ptr<Node>>::const_iterator Node::get_node_it_begin() const
+vector<NodeLink>::const_iterator Node::get_node_it_begin() const
 {
     return d->childNodes.begin();
 }
 
-vector<shared_ptr<Node>>::const_iterator Node::get_node_it_end() const
+vector<NodeLink>::const_iterator Node::get_node_it_end() const
 {
     return d->childNodes.end();
 }
@@ -506,6 +721,25 @@ bool Node::has_nn_results() const
 
 void Node::apply_virtual_loss_to_child(ChildIdx childIdx, const SearchSettings* searchSettings)
 {
+#ifdef MCTS_ATOMIC_BACKUP
+    // the backups of other threads don't hold the mutex, so all statistics are changed atomically
+    const uint32_t childVisits = atomic_load(d->childNumberVisits[childIdx]);
+    switch (get_virtual_style(searchSettings, childVisits)) {
+    case VIRTUAL_LOSS:
+        atomic_update(d->qValues[childIdx], [childVisits](float qValue) {
+            return float((double(qValue) * childVisits - 1) / double(childVisits + 1)); });
+        break;
+    case VIRTUAL_OFFSET:
+        atomic_update(d->qValues[childIdx], [searchSettings](float qValue) {
+            return float(qValue - searchSettings->virtualOffsetStrenght); });
+    case VIRTUAL_VISIT: ;  // ignore
+    case VIRTUAL_MIX: ;  // unreachable
+    }
+    // the virtual loss counter is incremented first, so the number of real visits is never overestimated
+    atomic_fetch_add(d->virtualLossCounter[childIdx], uint8_t(1));
+    atomic_fetch_add(d->childNumberVisits[childIdx], 1U);
+    atomic_fetch_add(d->visitSum, 1U);
+#else
     // update the stats of the parent node
     // make it look like if one has lost X games from this node forward where X is the virtual loss value
     // temporarily reduce the attraction of this node by applying a virtual loss /
@@ -526,6 +760,7 @@ void Node::apply_virtual_loss_to_child(ChildIdx childIdx, const SearchSettings*
 
     // increment virtual loss counter
     update_virtual_loss_counter<true>(childIdx);
+#endif
 }
 
 float Node::get_q_value(ChildIdx childIdx) const
@@ -535,7 +770,7 @@ float Node::get_q_value(ChildIdx childIdx) const
 
 DynamicVector<float> Node::get_q_values() const
 {
-    return d->qValues;
+    return DynamicVector<float>(d->qValues);
 }
 
 void Node::set_q_value(ChildIdx childIdx, float value)
@@ -543,6 +778,20 @@ void Node::set_q_value(ChildIdx childIdx, float value)
     d->qValues[childIdx] = value;
 }
 
+bool Node::blend_q_value(ChildIdx childIdx, float targetValue, float weight)
+{
+    if (get_virtual_loss_counter(childIdx) != 0 || get_child_number_visits(childIdx) == 0) {
+        return false;
+    }
+#ifdef MCTS_ATOMIC_BACKUP
+    atomic_update(d->qValues[childIdx], [targetValue, weight](float qValue) {
+        return qValue + weight * (targetValue - qValue); });
+#else
+    d->qValues[childIdx] += weight * (targetValue - d->qValues[childIdx]);
+#endif
+    return true;
+}
+
 ChildIdx Node::get_best_q_idx() const
 {
     return argmax(d->qValues);
@@ -560,18 +809,26 @@ vector<ChildIdx> Node::get_q_idx_over_thresh(float qThresh)
 
 void Node::reserve_full_memory()
 {
+    const size_t memorySize = d->get_memory_size();
     const size_t numberChildNodes = get_number_child_nodes();
     d->childNumberVisits.reserve(numberChildNodes);
     d->qValues.reserve(numberChildNodes);
     d->childNodes.reserve(numberChildNodes);
     d->virtualLossCounter.reserve(numberChildNodes);
     d->nodeTypes.reserve(numberChildNodes);
+    memory_stats().add(MEMORY_NODE_DATA, int64_t(d->get_memory_size()) - int64_t(memorySize));
 }
 
 void Node::increment_no_visit_idx()
 {
     if (d->noVisitIdx < get_number_child_nodes()) {
         ++d->noVisitIdx;
+#ifdef MCTS_PARTIAL_SORT
+        if (d->noVisitIdx > numberSortedChildNodes) {
+            // the moves behind noVisitIdx don't have child nodes yet and can be reordered
+            extend_sorted_moves(numberSortedChildNodes + PARTIAL_SORT_STEP);
+        }
+#endif
         if (d->noVisitIdx == PRESERVED_ITEMS) {
             reserve_full_memory();
         }
@@ -589,6 +846,9 @@ void Node::fully_expand_node()
         d->noVisitIdx = get_number_child_nodes();
         // keep this exact order
         sorted = true;
+#ifdef MCTS_PARTIAL_SORT
+        numberSortedChildNodes = uint16_t(get_number_child_nodes());
+#endif
     }
 }
 
@@ -628,20 +888,75 @@ Key Node::hash_key() const
 
 size_t Node::get_number_child_nodes() const
 {
+#ifdef MCTS_COMPACT_LEAVES
+    if (compactData != nullptr) {
+        return numberCompactChildNodes;
+    }
+#endif
     return legalActions.size();
 }
 
 void Node::prepare_node_for_visits()
 {
+#ifdef MCTS_COMPACT_LEAVES
+    expand_compact_leaf();
+#endif
     sort_moves_by_probabilities();
     if (d == nullptr) {  // mark_tablebase() initializes the NodeData
         init_node_data();
     }
+    if (isFastEvaluation) {
+        // no value has been backed up through the node yet
+        d->fastValue = get_value();
+    }
 #ifdef MCTS_STORE_STATES
     state->prepare_action();
 #endif
 }
 
+#ifdef MCTS_COMPACT_LEAVES
+void Node::compact_leaf()
+{
+    const size_t numberChildNodes = legalActions.size();
+    if (d != nullptr || compactData != nullptr || numberChildNodes == 0) {
+        return;
+    }
+    const size_t memorySize = get_memory_size();
+    hasCompactActions = std::all_of(legalActions.begin(), legalActions.end(), [](Action action) {
+        return action >= 0 && action <= Action(UINT16_MAX);
+    });
+    compactData = make_unique<uint16_t[]>(numberChildNodes * (hasCompactActions ? 2 : 1));
+    numberCompactChildNodes = uint16_t(numberChildNodes);
+    float_to_half(policyProbSmall.data(), compactData.get(), numberChildNodes);
+    policyProbSmall.clear();
+    policyProbSmall.shrinkToFit();
+    if (hasCompactActions) {
+        std::copy(legalActions.begin(), legalActions.end(), compactData.get() + numberChildNodes);
+        vector<Action>().swap(legalActions);
+    }
+    memory_stats().add(MEMORY_NODES, int64_t(get_memory_size()) - int64_t(memorySize));
+}
+
+void Node::expand_compact_leaf()
+{
+    if (compactData == nullptr) {
+        return;
+    }
+    const size_t memorySize = get_memory_size();
+    const size_t numberChildNodes = numberCompactChildNodes;
+    if (hasCompactActions) {
+        legalActions.resize(numberChildNodes);
+        std::copy_n(compactData.get() + numberChildNodes, numberChildNodes, legalActions.begin());
+        hasCompactActions = false;
+    }
+    policyProbSmall.resize(numberChildNodes);
+    half_to_float(compactData.get(), policyProbSmall.data(), numberChildNodes);
+    compactData.reset();
+    numberCompactChildNodes = 0;
+    memory_stats().add(MEMORY_NODES, int64_t(get_memory_size()) - int64_t(memorySize));
+}
+#endif
+
 uint32_t Node::get_visits() const
 {
     return d->visitSum;
@@ -652,31 +967,139 @@ uint32_t Node::get_real_visits(ChildIdx childIdx) const
     return d->childNumberVisits[childIdx] - d->virtualLossCounter[childIdx];
 }
 
-void backup_collision(const SearchSettings* searchSettings, const Trajectory& trajectory) {
+void backup_collision(const SearchSettings* searchSettings, TrajectoryView trajectory) {
     for (auto it = trajectory.rbegin(); it != trajectory.rend(); ++it) {
+        LOCK_DEPTH(size_t(trajectory.rend() - it) - 1);
         it->node->revert_virtual_loss(it->childIdx, searchSettings);
     }
 }
 
-void Node::revert_virtual_loss(ChildIdx childIdx, const SearchSettings* searchSettings)
+void Node::revert_virtual_loss(ChildIdx childIdx, const SearchSettings* searchSettings, uint_fast32_t numberReverts)
 {
+#ifdef MCTS_ATOMIC_BACKUP
+    for (uint_fast32_t revert = 0; revert < numberReverts; ++revert) {
+        const uint32_t childVisits = atomic_load(d->childNumberVisits[childIdx]);
+        switch (get_virtual_style(searchSettings, childVisits)) {
+        case VIRTUAL_LOSS:
+            atomic_update(d->qValues[childIdx], [childVisits](float qValue) {
+                return float((double(qValue) * childVisits + 1) / (childVisits - 1)); });
+            break;
+        case VIRTUAL_OFFSET:
+            atomic_update(d->qValues[childIdx], [searchSettings](float qValue) {
+                return float(qValue + searchSettings->virtualOffsetStrenght); });
+        case VIRTUAL_MIX: ; // ignore
+        case VIRTUAL_VISIT: ; // ignore
+        }
+        atomic_fetch_sub(d->childNumberVisits[childIdx], 1U);
+        atomic_fetch_sub(d->visitSum, 1U);
+        atomic_fetch_sub(d->virtualLossCounter[childIdx], uint8_t(1));
+    }
+#else
     lock();
-    switch (get_virtual_style(searchSettings, d->childNumberVisits[childIdx])) {
+    for (uint_fast32_t revert = 0; revert < numberReverts; ++revert) {
+        switch (get_virtual_style(searchSettings, d->childNumberVisits[childIdx])) {
+        case VIRTUAL_LOSS:
+            d->qValues[childIdx] = (double(d->qValues[childIdx]) * d->childNumberVisits[childIdx] + 1) / (d->childNumberVisits[childIdx] - 1);
+            break;
+        case VIRTUAL_OFFSET:
+            d->qValues[childIdx] += searchSettings->virtualOffsetStrenght;
+        case VIRTUAL_MIX: ; // ignore
+        case VIRTUAL_VISIT: ; // ignore
+        }
+        --d->childNumberVisits[childIdx];
+        --d->visitSum;
+
+        // decrement virtual loss counter
+        update_virtual_loss_counter<false>(childIdx);
+    }
+    unlock();
+#endif
+}
+
+/**
+ * @brief get_correction_visits Returns the number of visits over which a value correction of a child node is spread.
+ * A virtual loss is part of the averaged Q-value until it is reverted, the other virtual styles only average the real visits.
+ */
+static uint32_t get_correction_visits(uint32_t childVisits, uint8_t virtualLoss, const SearchSettings* searchSettings)
+{
+    if (virtualLoss != 0 && get_virtual_style(searchSettings, childVisits) == VIRTUAL_LOSS) {
+        return childVisits;
+    }
+    return childVisits - virtualLoss;
+}
+
+void Node::correct_value(float delta)
+{
+#ifdef MCTS_ATOMIC_BACKUP
+    atomic_update(valueSum, [delta](double sum) { return sum + delta; });
+#else
+    valueSum += delta;
+#endif
+}
+
+void Node::correct_child_value(ChildIdx childIdx, float delta, const SearchSettings* searchSettings)
+{
+#ifdef MCTS_ATOMIC_BACKUP
+    atomic_update(valueSum, [delta](double sum) { return sum + delta; });
+    const uint32_t visits = get_correction_visits(atomic_load(d->childNumberVisits[childIdx]), atomic_load(d->virtualLossCounter[childIdx]), searchSettings);
+    if (visits != 0) {
+        atomic_update(d->qValues[childIdx], [delta, visits](float qValue) { return float(qValue + double(delta) / visits); });
+    }
+#else
+    lock();
+    valueSum += delta;
+    const uint32_t visits = get_correction_visits(d->childNumberVisits[childIdx], d->virtualLossCounter[childIdx], searchSettings);
+    if (visits != 0) {
+        d->qValues[childIdx] += double(delta) / visits;
+    }
+    unlock();
+#endif
+}
+
+#ifdef MCTS_ATOMIC_BACKUP
+void Node::revert_virtual_loss_and_update_atomic(ChildIdx childIdx, float value, const SearchSettings* searchSettings)
+{
+    atomic_update(valueSum, [value](double sum) { return sum + value; });
+    atomic_fetch_add(realVisitsSum, 1U);
+
+    const uint32_t childVisits = atomic_load(d->childNumberVisits[childIdx]);
+    // decrementing the virtual loss counter claims the next real visit of this child
+    const uint8_t virtualLoss = atomic_fetch_sub(d->virtualLossCounter[childIdx], uint8_t(1));
+    assert(virtualLoss != 0);
+    assert(childVisits != 0);
+
+    if (childVisits == 1) {
+        // set new Q-value based on return
+        // (the initialization of the Q-value was by Q_INIT which we don't want to recover.)
+        atomic_store(d->qValues[childIdx], value);
+        return;
+    }
+    // number of real visits before this update
+    const double childRealVisits = childVisits - virtualLoss;
+    switch(get_virtual_style(searchSettings, childVisits)) {
     case VIRTUAL_LOSS:
-        d->qValues[childIdx] = (double(d->qValues[childIdx]) * d->childNumberVisits[childIdx] + 1) / (d->childNumberVisits[childIdx] - 1);
+        atomic_update(d->qValues[childIdx], [childVisits, value](float qValue) {
+            return float((double(qValue) * childVisits + 1 + value) / childVisits); });
+        break;
+    case VIRTUAL_VISIT:
+        atomic_update(d->qValues[childIdx], [childRealVisits, value](float qValue) {
+            return float((double(qValue) * childRealVisits + value) / (childRealVisits + 1)); });
         break;
     case VIRTUAL_OFFSET:
-        d->qValues[childIdx] += searchSettings->virtualOffsetStrenght;
-    case VIRTUAL_MIX: ; // ignore
-    case VIRTUAL_VISIT: ; // ignore
+        atomic_update(d->qValues[childIdx], [childRealVisits, virtualLoss, value, searchSettings](float qValue) {
+            const double newQVal = double(qValue) + virtualLoss * searchSettings->virtualOffsetStrenght;
+            return float((newQVal * childRealVisits + value) / (childRealVisits + 1.0) - (virtualLoss-1) * searchSettings->virtualOffsetStrenght); });
+    case VIRTUAL_MIX: ;
+        // unreachable
     }
-    --d->childNumberVisits[childIdx];
-    --d->visitSum;
+}
 
-    // decrement virtual loss counter
-    update_virtual_loss_counter<false>(childIdx);
-    unlock();
+bool Node::is_child_solved(ChildIdx childIdx) const
+{
+    const Node* childNode = get_node_ptr(d->childNodes[childIdx]);
+    return childNode != nullptr && childNode->is_playout_node() && childNode->d->nodeType != UNSOLVED;
 }
+#endif
 
 bool Node::is_playout_node() const
 {
@@ -721,19 +1144,34 @@ void Node::set_value(float value)
 
 Node* Node::add_new_node_to_tree(MapWithMutex* mapWithMutex, StateObj* newState, ChildIdx childIdx, const SearchSettings* searchSettings, bool& transposition)
 {
+    const Key newKey = newState->hash_key();
     if(searchSettings->useMCGS) {
-        mapWithMutex->mtx.lock();
-        HashMap::const_iterator it = mapWithMutex->hashTable.find(newState->hash_key());
-        if (it != mapWithMutex->hashTable.end()) {
-            shared_ptr<Node> transpositionNode = it->second.lock();
-            Node* tranpositionNode = get_child_node(childIdx);
+        HashShard& shard = mapWithMutex->get_shard(newKey);
+        shard.mtx.lock();
+        HashMap::const_iterator it = shard.hashTable.find(newKey);
+        if (it != shard.hashTable.end()) {
+#ifdef MCTS_NODE_POOL
+            Node* tranpositionNode = node_pool().get(it->second.node);
+            if (tranpositionNode != nullptr) {
+                if(is_transposition_verified(tranpositionNode, newState)) {
+                    // the parent counter is increased before releasing the hash table lock,
+                    // otherwise the garbage collector could free the node in the meantime
+                    tranpositionNode->lock();
+                    tranpositionNode->add_transposition_parent_node();
+                    tranpositionNode->unlock();
+                    d->childNodes[childIdx] = it->second.node;
+                    shard.mtx.unlock();
+#else
+            shared_ptr<Node> transpositionNode = it->second.node.lock();
+            Node* tranpositionNode = transpositionNode.get();
             if (tranpositionNode != nullptr) {
                 if(is_transposition_verified(tranpositionNode, newState)) {
                     d->childNodes[childIdx] = atomic_load(&transpositionNode);
-                    mapWithMutex->mtx.unlock();
+                    shard.mtx.unlock();
                     tranpositionNode->lock();
                     tranpositionNode->add_transposition_parent_node();
                     tranpositionNode->unlock();
+#endif
                     switch (searchSettings->searchPlayerMode) {
                     case MODE_TWO_PLAYER:
                         if (tranpositionNode->is_playout_node() && tranpositionNode->get_node_type() == LOSS) {
@@ -746,19 +1184,24 @@ Node* Node::add_new_node_to_tree(MapWithMutex* mapWithMutex, StateObj* newState,
                 }
             }
         }
-        mapWithMutex->mtx.unlock();
+        shard.mtx.unlock();
     }
 
     // connect the Node to the parent
+#ifdef MCTS_NODE_POOL
+    d->childNodes[childIdx] = node_pool().new_node(newState, searchSettings);
+#else
     shared_ptr<Node> newNode = make_shared<Node>(newState, searchSettings);
     atomic_store(&d->childNodes[childIdx], newNode);
+#endif
     if (searchSettings->useMCGS) {
-        mapWithMutex->mtx.lock();
-        mapWithMutex->hashTable.insert({d->childNodes[childIdx]->hash_key(), d->childNodes[childIdx]});
-        mapWithMutex->mtx.unlock();
+        HashShard& shard = mapWithMutex->get_shard(newKey);
+        shard.mtx.lock();
+        mapWithMutex->insert(shard, newKey, d->childNodes[childIdx]);
+        shard.mtx.unlock();
     }
     transposition = false;
-    return d->childNodes[childIdx].get();
+    return get_node_ptr(d->childNodes[childIdx]);
 }
 
 void Node::add_transposition_parent_node()
@@ -811,9 +1254,96 @@ float Node::updated_value_eval() const
 
 std::vector<Action> Node::get_legal_actions() const
 {
+#ifdef MCTS_COMPACT_LEAVES
+    if (hasCompactActions) {
+        return vector<Action>(compactData.get() + numberCompactChildNodes, compactData.get() + 2 * numberCompactChildNodes);
+    }
+#endif
     return legalActions;
 }
 
+float Node::get_prior(ChildIdx childIdx) const
+{
+#ifdef MCTS_COMPACT_LEAVES
+    if (compactData != nullptr) {
+        return half_to_float_scalar(compactData[childIdx]);
+    }
+#endif
+    return policyProbSmall[childIdx];
+}
+
+void Node::restore_from_snapshot(const TreeNodeRecord& nodeRecord, const TreeNodeStateRecord& stateRecord, const TreeEdgeRecord* edges)
+{
+    add_node_memory_stats(this, -1);
+    // the value of a node without visits is undefined
+    valueSum = nodeRecord.visits == 0 ? 0.0 : double(nodeRecord.value) * nodeRecord.visits;
+    realVisitsSum = nodeRecord.visits;
+
+    if ((stateRecord.flags & TREE_SNAPSHOT_NN_RESULTS) && !isTerminal) {
+        vector<Action> actions(nodeRecord.numberEdges);
+        for (size_t idx = 0; idx < actions.size(); ++idx) {
+            actions[idx] = Action(edges[idx].action);
+        }
+        vector<Action> sortedActions = actions;
+        vector<Action> sortedLegalActions = legalActions;
+        std::sort(sortedActions.begin(), sortedActions.end());
+        std::sort(sortedLegalActions.begin(), sortedLegalActions.end());
+        if (sortedActions != sortedLegalActions) {
+            throw runtime_error("The stored moves of a snapshot node don't match the legal moves of its position.");
+        }
+        legalActions = std::move(actions);
+        for (size_t idx = 0; idx < legalActions.size(); ++idx) {
+            policyProbSmall[idx] = edges[idx].prior;
+        }
+    }
+    hasNNResults = stateRecord.flags & TREE_SNAPSHOT_NN_RESULTS;
+
+    if ((stateRecord.flags & TREE_SNAPSHOT_NODE_DATA) && !isTerminal) {
+        if (stateRecord.noVisitIdx > legalActions.size()) {
+            throw runtime_error("The number of visited moves of a snapshot node exceeds its legal moves.");
+        }
+        if (d == nullptr) {  // tablebase nodes already have node data
+            init_node_data();
+        }
+        if (stateRecord.noVisitIdx >= PRESERVED_ITEMS) {
+            reserve_full_memory();
+        }
+        while (d->childNodes.size() < stateRecord.noVisitIdx) {
+            d->add_empty_node();
+        }
+        d->noVisitIdx = stateRecord.noVisitIdx;
+        for (ChildIdx childIdx = 0; childIdx < d->noVisitIdx; ++childIdx) {
+            d->childNumberVisits[childIdx] = edges[childIdx].visits;
+            d->qValues[childIdx] = edges[childIdx].qValue;
+        }
+        d->visitSum = stateRecord.visitSum;
+        d->freeVisits = stateRecord.freeVisits;
+        d->checkmateIdx = stateRecord.checkmateIdx;
+        d->endInPly = stateRecord.endInPly;
+        d->nodeType = NodeType(nodeRecord.nodeType);
+        d->inspected = stateRecord.flags & TREE_SNAPSHOT_INSPECTED;
+        // the moves are stored in the order of the node, the visited moves are always part of the sorted range
+        sorted = stateRecord.flags & TREE_SNAPSHOT_SORTED;
+#ifdef MCTS_PARTIAL_SORT
+        numberSortedChildNodes = sorted ? d->noVisitIdx : 0;
+#endif
+#ifdef MCTS_STORE_STATES
+        state->prepare_action();
+#endif
+    }
+    add_node_memory_stats(this, 1);
+}
+
+void Node::restore_child_node(ChildIdx childIdx, const NodeLink& link)
+{
+    d->childNodes[childIdx] = link;
+    const Node* childNode = get_node_ptr(link);
+    if (childNode->is_playout_node() && childNode->is_solved() && d->nodeTypes[childIdx] == UNSOLVED) {
+        --d->numberUnsolvedChildNodes;
+        d->nodeTypes[childIdx] = childNode->d->nodeType;
+    }
+}
+
 int Node::get_checkmate_idx() const
 {
     return d->checkmateIdx;
@@ -821,7 +1351,7 @@ int Node::get_checkmate_idx() const
 
 DynamicVector<uint32_t> Node::get_child_number_visits() const
 {
-    return d->childNumberVisits;
+    return DynamicVector<uint32_t>(d->childNumberVisits);
 }
 
 uint32_t Node::get_child_number_visits(ChildIdx childIdx) const
@@ -829,11 +1359,58 @@ uint32_t Node::get_child_number_visits(ChildIdx childIdx) const
     return d->childNumberVisits[childIdx];
 }
 
+void Node::get_most_visited_children(vector<ChildIdx>& childIndices, size_t number, vector<uint32_t>& visits) const
+{
+    childIndices.clear();
+    visits.clear();
+#ifdef MCTS_ATOMIC_BACKUP
+    const ChildIdx numberVisited = atomic_load(d->noVisitIdx);
+#else
+    const ChildIdx numberVisited = d->noVisitIdx;
+#endif
+    for (ChildIdx childIdx = 0; childIdx < numberVisited; ++childIdx) {
+#ifdef MCTS_ATOMIC_BACKUP
+        const uint32_t childVisits = atomic_load(d->childNumberVisits[childIdx]);
+#else
+        const uint32_t childVisits = d->childNumberVisits[childIdx];
+#endif
+        if (childIndices.size() == number && (number == 0 || childVisits <= visits.back())) {
+            continue;
+        }
+        // insertion into the small sorted list, the lower index wins for equal visits
+        size_t pos = visits.size();
+        while (pos > 0 && visits[pos-1] < childVisits) {
+            --pos;
+        }
+        childIndices.insert(childIndices.begin() + pos, childIdx);
+        visits.insert(visits.begin() + pos, childVisits);
+        if (childIndices.size() > number) {
+            childIndices.pop_back();
+            visits.pop_back();
+        }
+    }
+}
+
 void Node::enable_has_nn_results()
 {
     hasNNResults = true;
 }
 
+bool Node::is_fast_evaluation() const
+{
+    return isFastEvaluation;
+}
+
+void Node::set_fast_evaluation(bool value)
+{
+    isFastEvaluation = value;
+}
+
+float Node::get_fast_value() const
+{
+    return d->fastValue;
+}
+
 uint16_t Node::plies_from_null() const
 {
     return pliesFromNull;
@@ -861,7 +1438,9 @@ uint32_t Node::get_free_visits() const
 
 void Node::init_node_data(size_t numberNodes)
 {
+    const size_t memorySize = get_node_data_memory_size();
     d = make_unique<NodeData>(numberNodes);
+    memory_stats().add(MEMORY_NODE_DATA, int64_t(get_node_data_memory_size()) - int64_t(memorySize));
 }
 
 void Node::init_node_data()
@@ -907,7 +1486,7 @@ void Node::check_for_terminal(StateObj* pos)
 void Node::check_for_tablebase_wdl(StateObj* state)
 {
     Tablebase::ProbeState result;
-    Tablebase::WDLScore wdlScore = state->check_for_tablebase_wdl(result);
+    Tablebase::WDLScore wdlScore = tablebase_prober().probe(state, result);
 
     if (result != Tablebase::FAIL) {
         mark_as_tablebase();
@@ -939,7 +1518,11 @@ void Node::make_to_root()
 
 void Node::lock()
 {
+#ifdef MCTS_LOCK_STATS
+    mtx.lock_as(get_node_lock_class(is_root_node()));
+#else
     mtx.lock();
+#endif
 }
 
 void Node::unlock()
@@ -955,32 +1538,57 @@ void Node::apply_dirichlet_noise_to_prior_policy(const SearchSettings* searchSet
 
 void Node::apply_temperature_to_prior_policy(float temperature)
 {
-    apply_temperature(policyProbSmall, temperature);
+    temperature_policy(policyProbSmall.data(), policyProbSmall.data(), policyProbSmall.size(), temperature);
 }
 
-void Node::set_probabilities_for_moves(const float *data, bool mirrorPolicy)
+template <MirrorType m>
+void set_probabilities_for_actions(const float *data, const vector<Action>& legalActions, DynamicVector<float>& policyProbSmall)
 {
-    // allocate sufficient memory -> is assumed that it has already been done
-    assert(legalActions.size() == policyProbSmall.size());
     for (size_t mvIdx = 0; mvIdx < legalActions.size(); ++mvIdx) {
         // retrieve vector index from look-up table
         // set the right prob value
         // accessing the data on the raw floating point vector is faster
         // than calling policyProb.At(batchIdx, vectorIdx)
-        if (mirrorPolicy) {
-            // use mirrored action_to_index
-            policyProbSmall[mvIdx] = data[StateConstants::action_to_index<normal,mirrored>(legalActions[mvIdx])];
+        policyProbSmall[mvIdx] = data[StateConstants::action_to_index<normal,m>(legalActions[mvIdx])];
+    }
+}
+
+void Node::set_probabilities_for_moves(const float *data, bool mirrorPolicy)
+{
+    // allocate sufficient memory -> is assumed that it has already been done
+    assert(legalActions.size() == policyProbSmall.size());
+    // the mirror decision is made once per node instead of once per move
+    if (mirrorPolicy) {
+        set_probabilities_for_actions<mirrored>(data, legalActions, policyProbSmall);
+    }
+    else {
+        set_probabilities_for_actions<notMirrored>(data, legalActions, policyProbSmall);
+    }
+}
+
+void Node::fill_policy_indices(uint32_t* indices, bool mirrorPolicy) const
+{
+    if (mirrorPolicy) {
+        for (size_t mvIdx = 0; mvIdx < legalActions.size(); ++mvIdx) {
+            indices[mvIdx] = StateConstants::action_to_index<normal,mirrored>(legalActions[mvIdx]);
         }
-        else {
-            // use non-mirrored action_to_index
-            policyProbSmall[mvIdx] = data[StateConstants::action_to_index<normal,notMirrored>(legalActions[mvIdx])];
+    }
+    else {
+        for (size_t mvIdx = 0; mvIdx < legalActions.size(); ++mvIdx) {
+            indices[mvIdx] = StateConstants::action_to_index<normal,notMirrored>(legalActions[mvIdx]);
         }
     }
 }
 
+void Node::set_gathered_probabilities(const float* data)
+{
+    assert(legalActions.size() == policyProbSmall.size());
+    std::copy_n(data, legalActions.size(), policyProbSmall.begin());
+}
+
 void Node::apply_softmax_to_policy()
 {
-    policyProbSmall = softmax(policyProbSmall);
+    softmax_policy(policyProbSmall.data(), policyProbSmall.data(), policyProbSmall.size());
 }
 
 //void Node::mark_enhanced_moves(const Board* pos, const SearchSettings* searchSettings)
@@ -1064,7 +1672,7 @@ DynamicVector<float> Node::get_current_u_values(const SearchSettings* searchSett
 
 Node* Node::get_child_node(ChildIdx childIdx)
 {
-    return d->childNodes[childIdx].get();
+    return get_node_ptr(d->childNodes[childIdx]);
 }
 
 void Node::get_mcts_policy(DynamicVector<double>& mctsPolicy, ChildIdx& bestMoveIdx, const SearchSettings* searchSettings) const
@@ -1115,8 +1723,9 @@ void Node::get_principal_variation(vector<Action>& pv, const SearchSettings* sea
         curNode->lock();
         size_t childIdx = get_best_action_index(curNode, true, searchSettings);
         pv.push_back(curNode->get_action(childIdx));
+        Node* nextNode = get_node_ptr(curNode->d->childNodes[childIdx]);
         curNode->unlock();
-        curNode = curNode->d->childNodes[childIdx].get();
+        curNode = nextNode;
     }
 }
 
@@ -1131,7 +1740,7 @@ size_t get_best_action_index(const Node *curNode, bool fast, const SearchSetting
         size_t longestPVlength = 0;
         size_t childIdx = 0;
         for (size_t idx = 0; idx < curNode->get_number_child_nodes(); ++idx) {
-            if (curNode->get_child_node(idx)->get_end_in_ply() > longestPVlength) {
+            if (curNode->get_child_node(idx) != nullptr && curNode->get_child_node(idx)->get_end_in_ply() > longestPVlength) {
                 longestPVlength = curNode->get_child_node(idx)->get_end_in_ply();
                 childIdx = idx;
             }
@@ -1163,7 +1772,13 @@ ChildIdx Node::select_child_node(const SearchSettings* searchSettings)
     // find the move according to the q- and u-values for each move
     // calculate the current u values
     // it's not worth to save the u values as a node attribute because u is updated every time n_sum changes
+#ifdef SEARCH_UCT
     return argmax(d->qValues + get_current_u_values(searchSettings));
+#else
+    // fused Q+U argmax without temporary vectors, equivalent to argmax(d->qValues + get_current_u_values(searchSettings))
+    const float uFactor = get_current_cput(d->visitSum, searchSettings) * sqrt(d->visitSum);
+    return argmax_q_plus_u(d->qValues.data(), policyProbSmall.data(), d->childNumberVisits.data(), d->noVisitIdx, uFactor);
+#endif
 }
 
 NodeSplit Node::select_child_nodes(const SearchSettings* searchSettings, uint_fast16_t budget)
@@ -1273,17 +1888,18 @@ void Node::print_node_statistics(const StateObj* state, const vector<size_t>& cu
              << setw(9) << policyProbSmall[childIdx] << " | "
              << setw(10) << max(q, -9.9999999) << " | "
              << setw(5) << value_to_centipawn(q) << " | ";
-        if (childIdx < get_no_visit_idx() && d->childNodes[childIdx] != nullptr && d->childNodes[childIdx]->d != nullptr && d->childNodes[childIdx]->get_node_type() != UNSOLVED) {
+        const Node* childNode = childIdx < get_no_visit_idx() ? get_child_node(childIdx) : nullptr;
+        if (childNode != nullptr && childNode->d != nullptr && childNode->get_node_type() != UNSOLVED) {
             string nodeTypeToPrint;
             switch (searchSettings->searchPlayerMode) {
                 case MODE_TWO_PLAYER:
-                nodeTypeToPrint = node_type_to_string(flip_node_type(NodeType(d->childNodes[childIdx]->d->nodeType)));
+                nodeTypeToPrint = node_type_to_string(flip_node_type(NodeType(childNode->d->nodeType)));
                 break;
             case MODE_SINGLE_PLAYER:
-                nodeTypeToPrint = node_type_to_string(NodeType(d->childNodes[childIdx]->d->nodeType));
+                nodeTypeToPrint = node_type_to_string(NodeType(childNode->d->nodeType));
 
             }
-            cout << setfill(' ') << setw(4) << nodeTypeToPrint << " in " << setfill('0') << setw(2) << d->childNodes[childIdx]->d->endInPly+1;
+            cout << setfill(' ') << setw(4) << nodeTypeToPrint << " in " << setfill('0') << setw(2) << childNode->d->endInPly+1;
         }
         else {
             cout << setfill(' ') << setw(9) << node_type_to_string(UNSOLVED);
@@ -1345,3 +1961,207 @@ bool is_transposition_verified(const Node* node, const StateObj* state) {
             node->plies_from_null() == state->steps_from_null() &&
             state->number_repetitions() == 0;
 }
+
+size_t get_node_memory_usage()
+{
+    return memory_stats().get(MEMORY_NODES) + memory_stats().get(MEMORY_NODE_DATA);
+}
+
+#ifndef MCTS_NODE_POOL
+void set_node_release_yield_interval(size_t interval)
+{
+    nodeReleaseQueue.yieldInterval = interval;
+}
+#endif
+
+MapWithMutex::MapWithMutex():
+    shards(make_unique<HashShard[]>(1)),
+    numberShards(1),
+    shardCapacity(DEFAULT_HASH_SIZE),
+    generation(0),
+    sweepShardIdx(0),
+    sweepBucketIdx(0)
+{
+    // the bucket memory is only reserved in init()
+}
+
+MapWithMutex::~MapWithMutex()
+{
+    memory_stats().add(MEMORY_HASH_TABLE, -int64_t(get_memory_size()));
+}
+
+void MapWithMutex::init(size_t numberShards, size_t capacity)
+{
+    memory_stats().add(MEMORY_HASH_TABLE, -int64_t(get_memory_size()));
+    // round down to the next power of two for masking the hash key
+    size_t shardsPowerOfTwo = 1;
+    while (shardsPowerOfTwo * 2 <= numberShards) {
+        shardsPowerOfTwo *= 2;
+    }
+    this->numberShards = shardsPowerOfTwo;
+    shardCapacity = max(capacity / shardsPowerOfTwo, size_t(1));
+    shards = make_unique<HashShard[]>(shardsPowerOfTwo);
+    for (size_t idx = 0; idx < shardsPowerOfTwo; ++idx) {
+        shards[idx].hashTable.reserve(shardCapacity);
+    }
+    sweepShardIdx = 0;
+    sweepBucketIdx = 0;
+    memory_stats().add(MEMORY_HASH_TABLE, int64_t(get_memory_size()));
+}
+
+bool MapWithMutex::insert(HashShard& shard, Key key, const NodeRef& node)
+{
+    if (shard.hashTable.size() >= shardCapacity) {
+        age_shard(shard);
+        if (shard.hashTable.size() >= shardCapacity) {
+            return false;
+        }
+    }
+    if (shard.hashTable.insert({key, HashEntry{node, generation}}).second) {
+        memory_stats().add(MEMORY_HASH_TABLE, HASH_ENTRY_MEMORY_SIZE);
+        return true;
+    }
+    return false;
+}
+
+void MapWithMutex::age_shard(HashShard& shard)
+{
+    const size_t numberEntries = shard.hashTable.size();
+    age_entries(shard);
+    memory_stats().add(MEMORY_HASH_TABLE, -int64_t(numberEntries - shard.hashTable.size()) * HASH_ENTRY_MEMORY_SIZE);
+}
+
+void MapWithMutex::age_entries(HashShard& shard)
+{
+#ifndef MCTS_NODE_POOL
+    // nodes of former searches which are still reachable are kept as long as possible
+    for (auto it = shard.hashTable.begin(); it != shard.hashTable.end(); ) {
+        if (it->second.node.expired()) {
+            it = shard.hashTable.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    if (shard.hashTable.size() < shardCapacity) {
+        return;
+    }
+#endif
+    for (auto it = shard.hashTable.begin(); it != shard.hashTable.end(); ) {
+        if (it->second.generation != generation) {
+            it = shard.hashTable.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void MapWithMutex::new_generation()
+{
+    ++generation;
+}
+
+size_t MapWithMutex::size()
+{
+    size_t numberEntries = 0;
+    for (size_t idx = 0; idx < numberShards; ++idx) {
+        lock_guard<HashMutex> lock(shards[idx].mtx);
+        numberEntries += shards[idx].hashTable.size();
+    }
+    return numberEntries;
+}
+
+void MapWithMutex::clear()
+{
+    for (size_t idx = 0; idx < numberShards; ++idx) {
+        lock_guard<HashMutex> lock(shards[idx].mtx);
+        memory_stats().add(MEMORY_HASH_TABLE, -int64_t(shards[idx].hashTable.size()) * HASH_ENTRY_MEMORY_SIZE);
+        shards[idx].hashTable.clear();
+    }
+}
+
+size_t MapWithMutex::remove_expired_entries()
+{
+    size_t removedEntries = 0;
+#ifndef MCTS_NODE_POOL
+    // the node pool removes the entries of freed nodes itself
+    for (size_t idx = 0; idx < numberShards; ++idx) {
+        size_t bucketCount;
+        {
+            lock_guard<HashMutex> lock(shards[idx].mtx);
+            bucketCount = shards[idx].hashTable.bucket_count();
+        }
+        for (size_t bucketIdx = 0; bucketIdx < bucketCount; bucketIdx += HASH_SWEEP_BUCKETS) {
+            removedEntries += sweep_buckets(shards[idx], bucketIdx, bucketIdx + HASH_SWEEP_BUCKETS);
+        }
+    }
+#endif
+    return removedEntries;
+}
+
+size_t MapWithMutex::sweep_expired_entries(size_t numberBuckets)
+{
+#ifdef MCTS_NODE_POOL
+    return 0;
+#else
+    unique_lock<mutex> sweepLock(sweepMtx, try_to_lock);
+    if (!sweepLock.owns_lock()) {
+        return 0;
+    }
+    const size_t removedEntries = sweep_buckets(shards[sweepShardIdx], sweepBucketIdx, sweepBucketIdx + numberBuckets);
+    sweepBucketIdx += numberBuckets;
+    size_t bucketCount;
+    {
+        lock_guard<HashMutex> lock(shards[sweepShardIdx].mtx);
+        bucketCount = shards[sweepShardIdx].hashTable.bucket_count();
+    }
+    if (sweepBucketIdx >= bucketCount) {
+        sweepBucketIdx = 0;
+        sweepShardIdx = (sweepShardIdx + 1) % numberShards;
+    }
+    return removedEntries;
+#endif
+}
+
+size_t MapWithMutex::sweep_buckets(HashShard& shard, size_t beginIdx, size_t endIdx)
+{
+    size_t removedEntries = 0;
+#ifndef MCTS_NODE_POOL
+    lock_guard<HashMutex> lock(shard.mtx);
+    HashMap& hashTable = shard.hashTable;
+    // the buckets are stable because the shards never grow beyond their reserved capacity
+    endIdx = min(endIdx, hashTable.bucket_count());
+    for (size_t bucketIdx = beginIdx; bucketIdx < endIdx; ++bucketIdx) {
+        for (auto it = hashTable.begin(bucketIdx); it != hashTable.end(bucketIdx); ) {
+            if (it->second.node.expired()) {
+                // the local iterators don't support erase, erasing by key keeps the iterators of the other entries valid
+                const Key key = it->first;
+                ++it;
+                hashTable.erase(key);
+                ++removedEntries;
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+    memory_stats().add(MEMORY_HASH_TABLE, -int64_t(removedEntries) * HASH_ENTRY_MEMORY_SIZE);
+#endif
+    return removedEntries;
+}
+
+float MapWithMutex::get_load_factor()
+{
+    return float(size()) / (numberShards * shardCapacity);
+}
+
+size_t MapWithMutex::get_memory_size()
+{
+    size_t memorySize = 0;
+    for (size_t idx = 0; idx < numberShards; ++idx) {
+        lock_guard<HashMutex> lock(shards[idx].mtx);
+        memorySize += shards[idx].hashTable.bucket_count() * sizeof(void*) + shards[idx].hashTable.size() * HASH_ENTRY_MEMORY_SIZE;
+    }
+    return memorySize;
+}
@@ -29,6 +29,7 @@
 #define NODE_H
 
 #include <iostream>
+#include <iterator>
 #include <mutex>
 #include <unordered_map>
 
@@ -37,6 +38,11 @@
 
 #include "agents/config/searchsettings.h"
 #include "nodedata.h"
+#include "util/instrumentedmutex.h"
+#include "util/prefetch.h"
+#ifdef MCTS_ATOMIC_BACKUP
+#include "util/atomicutil.h"
+#endif
 
 
 using blaze::HybridVector;
@@ -52,13 +58,194 @@ struct NodeAndIdx {
         node(node), childIdx(childIdx) {}
 };
 using Trajectory = vector<NodeAndIdx>;
-using HashMap = unordered_map<Key, weak_ptr<Node>> ;
-// wrapper for unordered_map with a mutex for thread safe access
-struct MapWithMutex {
-    mutex mtx;
+
+/**
+ * @brief The TrajectoryView struct is a non-owning view of a trajectory which is stored in a Trajectory or a TrajectoryArena
+ */
+struct TrajectoryView {
+    const NodeAndIdx* first;
+    size_t length;
+    TrajectoryView(const Trajectory& trajectory) :
+        first(trajectory.data()), length(trajectory.size()) {}
+    TrajectoryView(const NodeAndIdx* first, size_t length) :
+        first(first), length(length) {}
+
+    const NodeAndIdx* begin() const { return first; }
+    const NodeAndIdx* end() const { return first + length; }
+    std::reverse_iterator<const NodeAndIdx*> rbegin() const { return std::reverse_iterator<const NodeAndIdx*>(end()); }
+    std::reverse_iterator<const NodeAndIdx*> rend() const { return std::reverse_iterator<const NodeAndIdx*>(begin()); }
+    size_t size() const { return length; }
+    const NodeAndIdx& operator[](size_t idx) const { return first[idx]; }
+};
+
+/**
+ * @brief The TrajectoryArena class stores the trajectories of a mini-batch back to back in a single buffer.
+ * The memory is kept after clear(), so no allocations are done once the buffers have grown to the usual batch size.
+ * The views which are returned by operator[] are invalidated by the next add() call.
+ */
+class TrajectoryArena
+{
+private:
+    struct Span {
+        uint32_t offset;
+        uint32_t length;
+    };
+    vector<NodeAndIdx> nodes;
+    vector<Span> spans;
+public:
+    /**
+     * @brief reserve Preallocates the memory for the given number of trajectories with the given average depth
+     */
+    void reserve(size_t numberTrajectories, size_t depth) {
+        nodes.reserve(numberTrajectories * depth);
+        spans.reserve(numberTrajectories);
+    }
+    void add(TrajectoryView trajectory) {
+        spans.push_back({uint32_t(nodes.size()), uint32_t(trajectory.size())});
+        nodes.insert(nodes.end(), trajectory.begin(), trajectory.end());
+    }
+    TrajectoryView operator[](size_t idx) const {
+        return TrajectoryView(nodes.data() + spans[idx].offset, spans[idx].length);
+    }
+    size_t size() const { return spans.size(); }
+    void clear() {
+        nodes.clear();
+        spans.clear();
+    }
+};
+#ifdef MCTS_NODE_POOL
+using NodeRef = NodeIdx;
+#else
+using NodeRef = weak_ptr<Node>;
+#endif
+
+struct HashEntry {
+    NodeRef node;
+    // search generation in which the entry was inserted
+    uint32_t generation;
+};
+using HashMap = unordered_map<Key, HashEntry> ;
+// approximate memory of a hash table entry including the next pointer and the cached hash of the list node
+#define HASH_ENTRY_MEMORY_SIZE int64_t(sizeof(HashMap::value_type) + 2 * sizeof(void*))
+
+typedef ProfiledMutex<LOCK_HASH_SHARD> HashMutex;
+
+// part of the hash table which is protected by its own mutex
+struct HashShard {
+    HashMutex mtx;
     HashMap hashTable;
-    ~MapWithMutex() {
+};
+
+/**
+ * @brief The MapWithMutex struct is the transposition table which is shared by all search threads.
+ * It is split into independent shards, each with its own mutex, based on the upper bits of the hash key.
+ * Every shard reserves its buckets at initialization and never holds more than shardCapacity entries,
+ * so the table doesn't rehash during search. If a shard is full, expired entries are removed first and entries of former searches only if this doesn't suffice,
+ * so the nodes of the old tree stay available for transpositions until the memory is needed.
+ * Entries whose nodes have been freed are also swept incrementally in steps of HASH_SWEEP_BUCKETS buckets between the search iterations.
+ */
+struct MapWithMutex {
+    unique_ptr<HashShard[]> shards;
+    size_t numberShards;
+    size_t shardCapacity;
+    uint32_t generation;
+    // position of the incremental sweep, guarded by sweepMtx
+    mutex sweepMtx;
+    size_t sweepShardIdx;
+    size_t sweepBucketIdx;
+
+    MapWithMutex();
+    ~MapWithMutex();
+
+    /**
+     * @brief init Allocates the shards and reserves the bucket memory
+     * @param numberShards Number of shards, will be rounded down to a power of two
+     * @param capacity Maximum number of entries of the full table
+     */
+    void init(size_t numberShards, size_t capacity);
+
+    /**
+     * @brief get_shard Returns the shard for the given hash key. The shard mutex must be locked before accessing its hash table.
+     * @param key Hash key
+     * @return Hash shard
+     */
+    inline HashShard& get_shard(Key key) {
+        return shards[(key >> 32) & (numberShards - 1)];
     }
+
+    /**
+     * @brief insert Inserts a new entry into the given shard if the key isn't stored yet. The shard mutex must be locked by the caller.
+     * @param shard Shard which belongs to the key
+     * @param key Hash key
+     * @param node Node reference
+     * @return True, if the entry has been inserted, false if the key already existed or the shard is full
+     */
+    bool insert(HashShard& shard, Key key, const NodeRef& node);
+
+    /**
+     * @brief new_generation Increments the generation counter, should be called before each new search
+     */
+    void new_generation();
+
+    /**
+     * @brief size Returns the number of entries over all shards
+     * @return size_t
+     */
+    size_t size();
+
+    /**
+     * @brief clear Removes all entries of all shards
+     */
+    void clear();
+
+    /**
+     * @brief remove_expired_entries Removes the entries of all shards whose nodes have already been freed.
+     * The shards are locked for at most HASH_SWEEP_BUCKETS buckets at a time, so the search threads can continue meanwhile.
+     * @return Number of removed entries
+     */
+    size_t remove_expired_entries();
+
+    /**
+     * @brief sweep_expired_entries Continues the incremental sweep over all shards and removes the expired entries of the next buckets.
+     * Returns immediately if another thread is sweeping at the moment.
+     * @param numberBuckets Maximum number of buckets which are visited
+     * @return Number of removed entries
+     */
+    size_t sweep_expired_entries(size_t numberBuckets);
+
+    /**
+     * @brief get_load_factor Returns the number of entries relative to the capacity of the table
+     * @return Value in [0,1]
+     */
+    float get_load_factor();
+
+    /**
+     * @brief get_memory_size Returns the number of bytes of the buckets and entries of all shards
+     * @return size_t
+     */
+    size_t get_memory_size();
+
+private:
+    /**
+     * @brief age_shard Removes the expired entries from a full shard and all entries of former generations if the shard is still full
+     * @param shard Hash shard with locked mutex
+     */
+    void age_shard(HashShard& shard);
+
+    /**
+     * @brief age_entries Removes the entries for age_shard() without updating the memory statistics
+     * @param shard Hash shard with locked mutex
+     */
+    void age_entries(HashShard& shard);
+
+    /**
+     * @brief sweep_buckets Removes the expired entries of the given buckets while holding the shard mutex
+     * @param shard Hash shard
+     * @param beginIdx First bucket
+     * @param endIdx End bucket (exclusive), will be clipped to the bucket count
+     * @return Number of removed entries
+     */
+    size_t sweep_buckets(HashShard& shard, size_t beginIdx, size_t endIdx);
 };
 
 
@@ -80,10 +267,24 @@ struct NodeAndBudget {
     uint_fast16_t budget;
     StateObj* curState;
     Trajectory curTrajectory;
+    NodeAndBudget() :
+        node(nullptr), budget(0), curState(nullptr) {}
     NodeAndBudget(Node* node, uint_fast16_t budget, StateObj* state) :
         node(node), budget(budget), curState(state) {}
 };
 
+/**
+ * @brief get_node_ptr Returns a raw pointer to the node of a child link or a nullptr if the link is empty
+ * @param link Child node link
+ * @return Node pointer
+ */
+inline Node* get_node_ptr(const NodeLink& link);
+
+// records of the tree snapshot format (see agents/util/treeexport.h)
+struct TreeNodeRecord;
+struct TreeNodeStateRecord;
+struct TreeEdgeRecord;
+
 inline VirtualStyle get_virtual_style(const SearchSettings* searchSettings, uint_fast32_t visits) {
     if (searchSettings->virtualStyle == VIRTUAL_MIX) {
         if (visits > searchSettings->virtualMixThreshold) {
@@ -97,31 +298,49 @@ inline VirtualStyle get_virtual_style(const SearchSettings* searchSettings, uint
 class Node
 {
 private:
-    mutex mtx;
-
+    // read-mostly fields which are accessed by every thread during the selection
     DynamicVector<float> policyProbSmall;
     vector<Action> legalActions;
     Key key;
 
-    // singular values
-    // valueSum stores the sum of all incoming value evaluations
-    double valueSum;
-
     unique_ptr<NodeData> d;
 #ifdef MCTS_STORE_STATES
+    // with MCTS_RELEASE_LEAF_STATES only set for nodes which have been passed by a simulation
     unique_ptr<StateObj> state;
 #endif
+#ifdef MCTS_COMPACT_LEAVES
+    // half precision priors followed by the 16-bit legal actions of a leaf node (nullptr if the node isn't compacted)
+    unique_ptr<uint16_t[]> compactData;
+    uint16_t numberCompactChildNodes;
+    bool hasCompactActions;
+#endif
+#ifdef MCTS_PARTIAL_SORT
+    // the first numberSortedChildNodes moves are sorted by their prior and have higher priors than all remaining moves
+    uint16_t numberSortedChildNodes;
+#endif
+
+    // fields which are written during the backup, with MCTS_ALIGNED_NODES they start on their own cache line
+    // (lock() classifies the acquisitions by the depth of the node when building with MCTS_LOCK_STATS)
+    NODE_HOT_FIELDS ProfiledMutex<LOCK_ROOT_NODE> mtx;
 
+    // singular values
+    // valueSum stores the sum of all incoming value evaluations
+    double valueSum;
     uint32_t realVisitsSum;
+    uint16_t numberParentNodes;
 
     // identifiers
     uint16_t pliesFromNull;
-
-    uint16_t numberParentNodes;
     bool isTerminal;
     bool isTablebase;
     bool hasNNResults;
+    // true if the node was evaluated by the fast network of the two-tier evaluation and hasn't been refined by the main network yet
+    bool isFastEvaluation;
     bool sorted;
+#ifdef MCTS_ALIGNED_NODES
+    // checks the placement of the hot fields (see node.cpp)
+    friend struct NodeLayout;
+#endif
 
 public:
     /**
@@ -153,6 +372,38 @@ public:
 
     ChildIdx select_child_node(const SearchSettings* searchSettings);
 
+    /**
+     * @brief prefetch_child_node Prefetches the child node which has been selected, so it is loaded while the virtual loss is applied.
+     * Only active when building with MCTS_PREFETCH.
+     * @param childIdx Index of the selected child node
+     */
+    void prefetch_child_node(ChildIdx childIdx) const {
+#ifdef MCTS_PREFETCH
+        const Node* childNode = get_child_node(childIdx);
+        if (childNode != nullptr) {
+            PREFETCH(childNode);
+            PREFETCH(&childNode->mtx);
+        }
+#endif
+    }
+
+    /**
+     * @brief prefetch_statistics Prefetches the child statistics and the prior policy which are read by the next selection of this node.
+     * Only active when building with MCTS_PREFETCH.
+     */
+    void prefetch_statistics() const {
+#ifdef MCTS_PREFETCH
+        if (d != nullptr) {
+            PREFETCH(&d->freeVisits);
+            const size_t numberChildNodes = d->noVisitIdx;
+            prefetch_range(d->qValues.data(), numberChildNodes * sizeof(float));
+            prefetch_range(d->childNumberVisits.data(), numberChildNodes * sizeof(uint32_t));
+            prefetch_range(d->virtualLossCounter.data(), numberChildNodes * sizeof(uint8_t));
+            prefetch_range(policyProbSmall.data(), numberChildNodes * sizeof(float));
+        }
+#endif
+    }
+
     /**
      * @brief select_child_nodes Selects multiple nodes at once
      * @param searchSettings Search settings struct
@@ -199,8 +450,64 @@ public:
     template<bool freeBackup>
     void revert_virtual_loss_and_update(ChildIdx childIdx, float value, const SearchSettings* searchSettings, bool solveForTerminal)
     {
+#ifdef MCTS_ATOMIC_BACKUP
+        // the mutex is only required if the node might be solved by its child node
+        const bool useLock = solveForTerminal && is_child_solved(childIdx);
+        if (useLock) {
+            lock();
+        }
+        revert_virtual_loss_and_update_atomic(childIdx, value, searchSettings);
+        if (freeBackup) {
+            atomic_fetch_add(d->freeVisits, 1U);
+        }
+        if (useLock) {
+            solve_for_terminal(childIdx, searchSettings);
+            unlock();
+        }
+#else
         lock();
+        update_child_statistics<freeBackup>(childIdx, value, searchSettings);
+        if (solveForTerminal) {
+            solve_for_terminal(childIdx, searchSettings);
+        }
+        unlock();
+#endif
+    }
 
+    /**
+     * @brief revert_virtual_loss_and_update Applies the backups of several simulations through the same child node.
+     * The node is only locked once and the statistics are updated in the same way as by consecutive single backups.
+     * @param childIdx Index to the child node to update
+     * @param values Value evaluations to backpropagate
+     * @param numberValues Number of values
+     * @param searchSettings Pointer to the search settings struct
+     */
+    template<bool freeBackup>
+    void revert_virtual_loss_and_update(ChildIdx childIdx, const float* values, size_t numberValues, const SearchSettings* searchSettings, bool solveForTerminal)
+    {
+#ifdef MCTS_ATOMIC_BACKUP
+        for (size_t idx = 0; idx < numberValues; ++idx) {
+            revert_virtual_loss_and_update<freeBackup>(childIdx, values[idx], searchSettings, solveForTerminal);
+        }
+#else
+        lock();
+        for (size_t idx = 0; idx < numberValues; ++idx) {
+            update_child_statistics<freeBackup>(childIdx, values[idx], searchSettings);
+        }
+        if (solveForTerminal) {
+            solve_for_terminal(childIdx, searchSettings);
+        }
+        unlock();
+#endif
+    }
+
+#ifndef MCTS_ATOMIC_BACKUP
+    /**
+     * @brief update_child_statistics Reverts the virtual loss of a single simulation and adds its value, the node must be locked by the caller
+     */
+    template<bool freeBackup>
+    void update_child_statistics(ChildIdx childIdx, float value, const SearchSettings* searchSettings)
+    {
         valueSum += value;
         ++realVisitsSum;
 
@@ -239,17 +546,50 @@ public:
         if (freeBackup) {
             ++d->freeVisits;
         }
-        if (solveForTerminal) {
-            solve_for_terminal(childIdx, searchSettings);
-        }
-        unlock();
     }
+#endif
+
+#ifdef MCTS_ATOMIC_BACKUP
+    /**
+     * @brief revert_virtual_loss_and_update_atomic Lock-free version of revert_virtual_loss_and_update() which updates
+     * the statistics with atomic operations. Each update takes the number of real visits from the virtual loss counter
+     * which it decrements itself. Concurrent updates of the same child can therefore be applied in a different order
+     * than their visits and the Q-value may deviate marginally from the exact mean.
+     * @param childIdx Index to the child node to update
+     * @param value Specifies the value evaluation to backpropagate
+     * @param searchSettings Pointer to the search settings struct
+     */
+    void revert_virtual_loss_and_update_atomic(ChildIdx childIdx, float value, const SearchSettings* searchSettings);
+
+    /**
+     * @brief is_child_solved Returns true if the given child node has been solved and might solve the node itself
+     * @param childIdx Child index
+     * @return bool
+     */
+    bool is_child_solved(ChildIdx childIdx) const;
+#endif
 
     /**
      * @brief revert_virtual_loss Reverts the virtual loss for a target node
      * @param childIdx Index to the child node to update
+     * @param numberReverts Number of collisions through this child node which are reverted under a single lock
+     */
+    void revert_virtual_loss(ChildIdx childIdx, const SearchSettings* searchSettings, uint_fast32_t numberReverts = 1);
+
+    /**
+     * @brief correct_value Replaces a former value evaluation of the node itself in its value sum, the node must be locked by the caller
+     * @param delta Difference between the new and the former evaluation
+     */
+    void correct_value(float delta);
+
+    /**
+     * @brief correct_child_value Replaces a former value evaluation which was backed up through the given child node.
+     * The difference is spread over the visits of the child, pending virtual losses of the child are taken into account.
+     * @param childIdx Index of the child node
+     * @param delta Difference between the new and the former evaluation from the perspective of this node
+     * @param searchSettings Pointer to the search settings struct
      */
-    void revert_virtual_loss(ChildIdx childIdx, const SearchSettings* searchSettings);
+    void correct_child_value(ChildIdx childIdx, float delta, const SearchSettings* searchSettings);
 
     bool is_playout_node() const;
 
@@ -265,8 +605,28 @@ public:
     Node* get_child_node(ChildIdx childIdx) const;
     shared_ptr<Node> get_child_node_shared(ChildIdx childIdx) const;
 
-    vector<shared_ptr<Node>>::const_iterator get_node_it_begin() const;
-    vector<shared_ptr<Node>>::const_iterator get_node_it_end() const;
+    /**
+     * @brief detach_child_node Removes the link to the given child node but keeps the visits and Q-value of the edge.
+     * The child node is expanded again if its edge is selected later on. Must be called while holding the lock of this node.
+     * @param childIdx Child index
+     * @return Former link to the child node which must be released by the caller
+     */
+    NodeLink detach_child_node(ChildIdx childIdx);
+
+    /**
+     * @brief get_memory_size Returns the number of bytes which are allocated for this node (excluding its child nodes)
+     * @return size_t
+     */
+    size_t get_memory_size() const;
+
+    /**
+     * @brief get_node_data_memory_size Returns the number of bytes which are allocated for the node data (0 if it hasn't been created yet)
+     * @return size_t
+     */
+    size_t get_node_data_memory_size() const;
+
+    vector<NodeLink>::const_iterator get_node_it_begin() const;
+    vector<NodeLink>::const_iterator get_node_it_end() const;
 
 
     bool is_terminal() const;
@@ -294,11 +654,42 @@ public:
 
     void prepare_node_for_visits();
 
+#ifdef MCTS_COMPACT_LEAVES
+    /**
+     * @brief compact_leaf Stores the priors of a leaf node in half precision and its legal actions as 16-bit values
+     * if all actions fit into this range. The float policy and the action vector are released afterwards.
+     * Nodes which already have node data (e.g. terminals or tablebase positions) are left unchanged.
+     */
+    void compact_leaf();
+
     /**
-     * @brief sort_nodes_by_probabilities Sorts all child nodes in ascending order based on their probability value
+     * @brief expand_compact_leaf Restores the float policy and the legal actions of a compacted leaf node.
+     * This is called on the second visit of the node in prepare_node_for_visits().
+     */
+    void expand_compact_leaf();
+#endif
+
+    /**
+     * @brief sort_nodes_by_probabilities Sorts all child nodes in ascending order based on their probability value.
+     * With MCTS_PARTIAL_SORT only the first PARTIAL_SORT_STEP moves are sorted and the sorted range is extended by increment_no_visit_idx().
      */
     void sort_moves_by_probabilities();
 
+#ifdef MCTS_PARTIAL_SORT
+    /**
+     * @brief extend_sorted_moves Moves the highest priors of the unsorted moves in descending order to the end of the sorted range
+     * by a partial (heap) selection. The order of the remaining moves is unspecified.
+     * @param numberSorted Number of moves which are sorted afterwards
+     */
+    void extend_sorted_moves(size_t numberSorted);
+#endif
+
+    /**
+     * @brief sort_unvisited_moves Sorts the moves which haven't been added to the child nodes yet (starting from noVisitIdx) by their prior again.
+     * This is required after the priors of an expanded node have been replaced.
+     */
+    void sort_unvisited_moves();
+
     /**
      * @brief make_to_root Makes the node to the current root node by setting its parent to a nullptr
      */
@@ -346,6 +737,19 @@ public:
 
     void set_probabilities_for_moves(const float *data, bool mirrorPolicy);
 
+    /**
+     * @brief fill_policy_indices Writes the policy index of each legal move in the order of the child nodes
+     * @param indices Output array with at least get_number_child_nodes() entries
+     * @param mirrorPolicy Decides if the mirrored policy look-up table is used
+     */
+    void fill_policy_indices(uint32_t* indices, bool mirrorPolicy) const;
+
+    /**
+     * @brief set_gathered_probabilities Sets the prior policy from a row which only contains the entries of the legal moves
+     * @param data Policy entries in the order of fill_policy_indices()
+     */
+    void set_gathered_probabilities(const float* data);
+
     void apply_softmax_to_policy();
 
     /**
@@ -397,6 +801,30 @@ public:
     std::vector<Action> get_legal_actions() const;
     int get_checkmate_idx() const;
 
+    /**
+     * @brief get_prior Returns the prior probability of the given child which is also available for compacted leaf nodes
+     * @param childIdx Child index
+     * @return float
+     */
+    float get_prior(ChildIdx childIdx) const;
+
+    /**
+     * @brief restore_from_snapshot Restores the statistics of a node which has been newly created for the position of a snapshot node.
+     * The legal actions are reordered to the stored edge order and the node data is recreated for all visited child nodes.
+     * The child nodes themselves are connected afterwards by restore_child_node().
+     * @param nodeRecord Node record of the snapshot
+     * @param stateRecord State record of the snapshot
+     * @param edges First edge record of the node
+     */
+    void restore_from_snapshot(const TreeNodeRecord& nodeRecord, const TreeNodeStateRecord& stateRecord, const TreeEdgeRecord* edges);
+
+    /**
+     * @brief restore_child_node Connects a restored child node and marks the child as solved if its node type is known
+     * @param childIdx Child index
+     * @param link Link to the restored node
+     */
+    void restore_child_node(ChildIdx childIdx, const NodeLink& link);
+
     /**
      * @brief get_mcts_policy Returns the final policy after the mcts search which is used for move selection, in most cases argmax(mctsPolicy).
      * Depending on the searchSettings, Q-values will be taken into account for creating this.
@@ -423,7 +851,28 @@ public:
     DynamicVector<uint32_t> get_child_number_visits() const;
     uint32_t get_child_number_visits(ChildIdx childIdx) const;
 
+    /**
+     * @brief get_most_visited_children Returns the indices of the most visited child nodes in descending order of their visits.
+     * The visits are read with relaxed atomic loads without locking the node.
+     * The cost is linear in the number of visited child nodes and the number of requested indices.
+     * @param childIndices Output indices (at most number entries)
+     * @param number Number of requested indices
+     * @param visits Visits of the returned child nodes
+     */
+    void get_most_visited_children(vector<ChildIdx>& childIndices, size_t number, vector<uint32_t>& visits) const;
+
     void enable_has_nn_results();
+
+    /**
+     * @brief is_fast_evaluation Returns true if the node was evaluated by the fast network and hasn't been refined by the main network yet
+     */
+    bool is_fast_evaluation() const;
+    void set_fast_evaluation(bool value);
+
+    /**
+     * @brief get_fast_value Returns the value of the fast network evaluation, it is recorded by prepare_node_for_visits()
+     */
+    float get_fast_value() const;
     uint16_t plies_from_null() const;
     bool is_tablebase() const;
     NodeType get_node_type() const;
@@ -457,6 +906,16 @@ public:
      */
     void set_q_value(ChildIdx idx, float value);
 
+    /**
+     * @brief blend_q_value Moves the Q-value of a visited child towards the given value, e.g. the Q-value of the same move in another search tree.
+     * Children with pending virtual losses are left unchanged. The node must be locked by the caller.
+     * @param childIdx Child index
+     * @param targetValue Value to move towards
+     * @param weight Fraction of the difference which is applied
+     * @return True, if the Q-value has been changed
+     */
+    bool blend_q_value(ChildIdx childIdx, float targetValue, float weight);
+
     /**
      * @brief get_best_q_idx Return the child index with the highest Q-value
      * @return Index of child with maximum Q-value
@@ -535,6 +994,17 @@ public:
      * @param auxiliaryOutputs Auxiliary outputs of the neural network for the corresponding state
      */
     void set_auxiliary_outputs(const float* auxiliaryOutputs);
+#ifdef MCTS_RELEASE_LEAF_STATES
+    /**
+     * @brief release_state Returns the ownership of the state of a new leaf node. The node keeps no state until set_state() is called.
+     */
+    unique_ptr<StateObj> release_state();
+
+    /**
+     * @brief set_state Takes the ownership of the given state if the node has no state yet, otherwise the given state is deleted
+     */
+    void set_state(StateObj* newState);
+#endif
 #endif
 
     uint32_t get_number_of_nodes() const;
@@ -621,8 +1091,8 @@ private:
     bool only_child_nodes_of_one_kind() const
     {
         for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-            const Node* childNode = it->get();
-            if (childNode->d->nodeType != nodeType) {
+            const Node* childNode = get_node_ptr(*it);
+            if (childNode == nullptr || childNode->d->nodeType != nodeType) {
                 return false;
             }
         }
@@ -803,7 +1273,7 @@ bool is_terminal_value(float value);
  * @param searchSettings Search settings struct
  * @param trajectory Trajectory on how to get to the given collision
  */
-void backup_collision(const SearchSettings* searchSettings, const Trajectory& trajectory);
+void backup_collision(const SearchSettings* searchSettings, TrajectoryView trajectory);
 
 float get_transposition_backup_value(uint_fast32_t transposVisits, double transposQValue, double masterQValue);
 
@@ -817,9 +1287,10 @@ float get_transposition_backup_value(uint_fast32_t transposVisits, double transp
  * @param solveForTerminal Decides if the terminal solver will be used
  */
 template <bool freeBackup>
-void backup_value(float value, const SearchSettings* searchSettings, const Trajectory& trajectory, bool solveForTerminal) {
+void backup_value(float value, const SearchSettings* searchSettings, TrajectoryView trajectory, bool solveForTerminal) {
     double targetQValue = 0;
     for (auto it = trajectory.rbegin(); it != trajectory.rend(); ++it) {
+        LOCK_DEPTH(size_t(trajectory.rend() - it) - 1);
         if (targetQValue != 0) {
             const uint_fast32_t transposVisits = it->node->get_real_visits(it->childIdx);
             if (transposVisits != 0) {
@@ -850,4 +1321,39 @@ void backup_value(float value, const SearchSettings* searchSettings, const Traje
  */
 bool is_transposition_verified(const Node* node, const StateObj* state);
 
+/**
+ * @brief get_node_memory_usage Returns the number of bytes which are currently allocated for all nodes of the process
+ * @return size_t
+ */
+size_t get_node_memory_usage();
+
+#ifndef MCTS_NODE_POOL
+/**
+ * @brief set_node_release_yield_interval Sets after how many released nodes the calling thread yields while it destroys a subtree.
+ * The child nodes of a destroyed node are released iteratively, so deep trees don't overflow the stack.
+ * @param interval Number of released nodes between two yields (0 disables yielding, which is the default for every thread)
+ */
+void set_node_release_yield_interval(size_t interval);
+#endif
+
+#ifdef MCTS_NODE_POOL
+inline Node* NodePool::get(NodeIdx idx) const
+{
+    return blocks[idx >> NODE_POOL_BLOCK_BITS] + (idx & (NODE_POOL_BLOCK_SIZE - 1));
+}
+
+inline Node* get_node_ptr(const NodeLink& link)
+{
+    if (link == NO_NODE_IDX) {
+        return nullptr;
+    }
+    return node_pool().get(link);
+}
+#else
+inline Node* get_node_ptr(const NodeLink& link)
+{
+    return link.get();
+}
+#endif
+
 #endif // NODE_H
@@ -33,12 +33,18 @@ void NodeData::add_empty_node()
     append(qValues, Q_INIT);
     append(virtualLossCounter, uint8_t(0));
     append(nodeTypes, UNSOLVED);
-    childNodes.emplace_back(nullptr);
+    childNodes.emplace_back();
 }
 
 void NodeData::reserve_initial_space()
 {
+#if defined(MCTS_NODE_ARENA) || defined(MCTS_ATOMIC_BACKUP)
+    // reallocations would leave unused memory behind in the arena chunk
+    // and the lock-free backups rely on the child statistics never being moved
+    const int initSize = numberUnsolvedChildNodes;
+#else
     const int initSize = min(PRESERVED_ITEMS, int(numberUnsolvedChildNodes));
+#endif
 
     // # visit count of all its child nodes
     childNumberVisits.reserve(initSize);
@@ -54,12 +60,20 @@ void NodeData::reserve_initial_space()
     add_empty_node();
 }
 
+size_t NodeData::get_memory_size() const
+{
+    return sizeof(NodeData) + childNumberVisits.capacity() * sizeof(uint32_t) + qValues.capacity() * sizeof(float) +
+            childNodes.capacity() * sizeof(NodeLink) + virtualLossCounter.capacity() * sizeof(uint8_t) +
+            nodeTypes.capacity() * sizeof(NodeType);
+}
+
 NodeData::NodeData():
     freeVisits(0),
     visitSum(0),
     checkmateIdx(NO_CHECKMATE),
     endInPly(0),
     noVisitIdx(1),
+    fastValue(0),
     nodeType(UNSOLVED),
     inspected(false)
 {
@@ -33,11 +33,31 @@
 #include <unordered_map>
 #include <blaze/Math.h>
 #include "agents/config/searchsettings.h"
+#include "constants.h"
+#ifdef MCTS_NODE_ARENA
+#include "util/nodearena.h"
+#endif
+#ifdef MCTS_NODE_POOL
+#include "nodepool.h"
+#endif
 
 using blaze::HybridVector;
 using blaze::DynamicVector;
 using namespace std;
 
+#ifdef MCTS_NODE_ARENA
+#include <blaze/system/Version.h>
+#if BLAZE_MAJOR_VERSION < 3 || (BLAZE_MAJOR_VERSION == 3 && BLAZE_MINOR_VERSION < 8)
+#error "MCTS_NODE_ARENA requires Blaze 3.8 or newer for the custom allocator of DynamicVector."
+#endif
+// the child arrays of a node are allocated from the thread local arena chunk and are placed next to each other
+template <typename T>
+using NodeVector = DynamicVector<T, blaze::defaultTransposeFlag, ArenaAllocator<T>>;
+#else
+template <typename T>
+using NodeVector = DynamicVector<T>;
+#endif
+
 
 enum NodeType : uint8_t {
     WIN,
@@ -82,24 +102,41 @@ bool is_unsolved_or_tablebase(NodeType nodeType);
 
 class Node;
 
+// the frequently written fields of Node and NodeData are separated from their read-mostly fields by this alignment
+#ifdef MCTS_ALIGNED_NODES
+#define NODE_HOT_FIELDS alignas(CACHE_LINE_SIZE)
+#else
+#define NODE_HOT_FIELDS
+#endif
+
+#ifdef MCTS_NODE_POOL
+// child nodes are addressed by their index in the node pool
+using NodeLink = NodeIdx;
+#else
+using NodeLink = shared_ptr<Node>;
+#endif
+
 /**
  * @brief The NodeData struct stores the member variables for all expanded child nodes which have at least been visited two times
  */
 struct NodeData
 {
-    DynamicVector<uint32_t> childNumberVisits;
-    DynamicVector<float> qValues;
-    vector<shared_ptr<Node>> childNodes;
-    DynamicVector<uint8_t> virtualLossCounter;
-    DynamicVector<NodeType> nodeTypes;
-
-    uint32_t freeVisits;
+    NodeVector<uint32_t> childNumberVisits;
+    NodeVector<float> qValues;
+    vector<NodeLink> childNodes;
+    NodeVector<uint8_t> virtualLossCounter;
+    NodeVector<NodeType> nodeTypes;
+
+    // the following counters are written on every visit
+    NODE_HOT_FIELDS uint32_t freeVisits;
     uint32_t visitSum;
 
     uint16_t checkmateIdx;
     uint16_t endInPly;
     uint16_t noVisitIdx;
     uint16_t numberUnsolvedChildNodes;
+    // value of the fast network evaluation which is replaced when the node is refined by the main network
+    float fastValue;
 
     NodeType nodeType;
     bool inspected;
@@ -108,6 +145,15 @@ struct NodeData
 
     auto get_q_values();
 
+#ifdef MCTS_NODE_ARENA
+    static void* operator new(size_t numberBytes) {
+        return arena_allocate(numberBytes);
+    }
+    static void operator delete(void* ptr) {
+        arena_deallocate(ptr);
+    }
+#endif
+
 public:
     /**
      * @brief add_empty_node Adds a new empty node to its child nodes
@@ -115,9 +161,16 @@ public:
     void add_empty_node();
 
     /**
-     * @brief reserve_initial_space Reserves memory for PRESERVED_ITEMS number of child nodes
+     * @brief reserve_initial_space Reserves memory for PRESERVED_ITEMS number of child nodes.
+     * If MCTS_NODE_ARENA is defined, the memory for all child nodes is reserved at once within the arena.
      */
     void reserve_initial_space();
+
+    /**
+     * @brief get_memory_size Returns the number of bytes which are allocated for the node data including its child arrays
+     * @return size_t
+     */
+    size_t get_memory_size() const;
 };
 
 
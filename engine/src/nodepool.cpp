@@ -0,0 +1,104 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: nodepool.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#ifdef MCTS_NODE_POOL
+#include "nodepool.h"
+#include "node.h"
+#include <new>
+#include "util/largepages.h"
+
+NodePool::NodePool():
+    numberBlocks(0),
+    nextIdx(NO_NODE_IDX + 1)
+{
+}
+
+NodePool::~NodePool()
+{
+    // the remaining nodes are not destroyed because the pool is only released at program exit
+    for (size_t idx = 0; idx < numberBlocks; ++idx) {
+        large_page_free(blocks[idx], sizeof(Node) * NODE_POOL_BLOCK_SIZE);
+    }
+}
+
+NodeIdx NodePool::get_free_idx()
+{
+    if (!freeIndices.empty()) {
+        const NodeIdx idx = freeIndices.back();
+        freeIndices.pop_back();
+        return idx;
+    }
+    if ((size_t(nextIdx) >> NODE_POOL_BLOCK_BITS) == numberBlocks) {
+        if (numberBlocks == NODE_POOL_MAX_BLOCKS) {
+            throw std::bad_alloc();
+        }
+        // the nodes may be aligned to cache lines (MCTS_ALIGNED_NODES), the blocks can be backed by huge pages
+        blocks[numberBlocks] = static_cast<Node*>(large_page_allocate(sizeof(Node) * NODE_POOL_BLOCK_SIZE, alignof(Node)));
+        ++numberBlocks;
+    }
+    return nextIdx++;
+}
+
+NodeIdx NodePool::new_node(StateObj* state, const SearchSettings* searchSettings)
+{
+    mtx.lock();
+    const NodeIdx idx = get_free_idx();
+    mtx.unlock();
+    new (get(idx)) Node(state, searchSettings);
+    return idx;
+}
+
+void NodePool::free_node(NodeIdx idx)
+{
+    get(idx)->~Node();
+    mtx.lock();
+    freeIndices.emplace_back(idx);
+    mtx.unlock();
+}
+
+NodeIdx NodePool::get_idx(const Node* node)
+{
+    lock_guard<mutex> lock(mtx);
+    for (size_t blockIdx = 0; blockIdx < numberBlocks; ++blockIdx) {
+        if (node >= blocks[blockIdx] && node < blocks[blockIdx] + NODE_POOL_BLOCK_SIZE) {
+            return NodeIdx((blockIdx << NODE_POOL_BLOCK_BITS) + (node - blocks[blockIdx]));
+        }
+    }
+    return NO_NODE_IDX;
+}
+
+size_t NodePool::get_number_nodes()
+{
+    lock_guard<mutex> lock(mtx);
+    return nextIdx - (NO_NODE_IDX + 1) - freeIndices.size();
+}
+
+NodePool& node_pool()
+{
+    static NodePool pool;
+    return pool;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: nodepool.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Pool which stores all nodes of the search trees in large blocks when building with MCTS_NODE_POOL.
+ * Nodes are addressed by 32-bit indices instead of shared pointers. The life time of a node is defined
+ * by its number of parent nodes which are tracked explicitly and the nodes are freed by the garbage collector thread.
+ */
+
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#ifdef MCTS_NODE_POOL
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class Node;
+class StateObj;
+struct SearchSettings;
+
+using NodeIdx = uint32_t;
+
+// index 0 is reserved as the empty link, so that a value initialized NodeIdx() doesn't point to a node
+#define NO_NODE_IDX 0
+// number of nodes of a single pool block (2^16)
+#define NODE_POOL_BLOCK_BITS 16
+#define NODE_POOL_BLOCK_SIZE (1 << NODE_POOL_BLOCK_BITS)
+// maximum number of blocks (2^16 * 2^16 = 2^32 nodes)
+#define NODE_POOL_MAX_BLOCKS (1 << 16)
+
+/**
+ * @brief The NodePool class allocates nodes in blocks of NODE_POOL_BLOCK_SIZE and recycles the slots of freed nodes.
+ * Allocated blocks are kept until the program ends. Looking up a node by its index doesn't require a lock.
+ */
+class NodePool
+{
+private:
+    std::mutex mtx;
+    Node* blocks[NODE_POOL_MAX_BLOCKS];
+    size_t numberBlocks;
+    NodeIdx nextIdx;
+    std::vector<NodeIdx> freeIndices;
+
+    /**
+     * @brief get_free_idx Returns an unused slot index and allocates a new block if necessary
+     * @return Node index
+     */
+    NodeIdx get_free_idx();
+
+public:
+    NodePool();
+    ~NodePool();
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    /**
+     * @brief new_node Creates a new node in the pool
+     * @param state Corresponding state object
+     * @param searchSettings Pointer to the searchSettings
+     * @return Index of the newly created node
+     */
+    NodeIdx new_node(StateObj* state, const SearchSettings* searchSettings);
+
+    /**
+     * @brief free_node Destroys the node and makes its slot available again
+     * @param idx Node index
+     */
+    void free_node(NodeIdx idx);
+
+    /**
+     * @brief get Returns the node for a given index (defined in node.h because the complete Node type is needed)
+     * @param idx Node index (must not be NO_NODE_IDX)
+     * @return Node pointer
+     */
+    inline Node* get(NodeIdx idx) const;
+
+    /**
+     * @brief get_idx Returns the index of a node which has been allocated in the pool
+     * @param node Node pointer
+     * @return Node index or NO_NODE_IDX if the node doesn't belong to the pool
+     */
+    NodeIdx get_idx(const Node* node);
+
+    /**
+     * @brief get_number_nodes Returns the number of nodes which are currently in use
+     * @return size_t
+     */
+    size_t get_number_nodes();
+};
+
+/**
+ * @brief node_pool Returns the node pool which is shared by all search trees of the process
+ * @return Reference to the node pool
+ */
+NodePool& node_pool();
+
+#endif
+
+#endif // NODEPOOL_H
@@ -0,0 +1,292 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: crazyarapy.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Python bindings of the engine (build with -DBUILD_PYTHON_BINDINGS=ON).
+ * The input planes are written directly into the memory of the returned NumPy arrays and the policies are returned as
+ * NumPy views on the evaluation results, so neither of them is copied between C++ and Python.
+ *
+ * Usage:
+ * import crazyara
+ * engine = crazyara.Engine()
+ * engine.set_option("Model_Directory", "model/ClassicAra/chess/")
+ * state = crazyara.State(engine.variant, crazyara.start_fen(engine.variant))
+ * result = engine.mcts_agent.search(state, nodes=800)
+ * planes = crazyara.get_state_planes([state])
+ */
+
+#ifdef BUILD_PYTHON_BINDINGS
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+
+#include "uci/crazyara.h"
+#include "stateobj.h"
+#include "../evalinfo.h"
+#ifdef USE_RL
+#include "rl/traindataloader.h"
+#endif
+
+namespace py = pybind11;
+
+/**
+ * @brief policy_view Returns a NumPy view on the policy of an evaluation result which keeps the result alive
+ * @param evalInfo Evaluation result which is owned by Python
+ * @param owner Python object of the evaluation result
+ * @return Array of the probabilities of the legal moves
+ */
+py::array_t<double> policy_view(EvalInfo& evalInfo, py::handle owner)
+{
+    return py::array_t<double>({evalInfo.policyProbSmall.size()}, {sizeof(double)}, evalInfo.policyProbSmall.data(), owner);
+}
+
+/**
+ * @brief fill_state_planes Writes the input planes of the given states into a (N, C, H, W) float32 array
+ * @param states Positions
+ * @param normalize True, if the planes are normalized
+ * @param version Version of the input representation
+ * @param planes Output array, it must be C-contiguous and have the size of all planes of the states
+ */
+void fill_state_planes(const vector<const StateObj*>& states, bool normalize, Version version, py::array_t<float, py::array::c_style>& planes)
+{
+    const size_t numberInputValues = StateConstants::NB_VALUES_TOTAL();
+    if (size_t(planes.size()) != states.size() * numberInputValues) {
+        throw invalid_argument("The output array must have " + to_string(states.size() * numberInputValues) + " values.");
+    }
+    float* inputPlanes = planes.mutable_data();
+    py::gil_scoped_release release;
+    for (size_t idx = 0; idx < states.size(); ++idx) {
+        states[idx]->get_state_planes(normalize, inputPlanes + idx * numberInputValues, version);
+    }
+}
+
+/**
+ * @brief to_states Clones the given positions because the agents take ownership of their states
+ * @param states Positions
+ * @return Deep copies of the positions
+ */
+vector<unique_ptr<StateObj>> to_states(const vector<const StateObj*>& states)
+{
+    vector<unique_ptr<StateObj>> clones;
+    clones.reserve(states.size());
+    for (const StateObj* state : states) {
+        clones.emplace_back(unique_ptr<StateObj>(state->clone()));
+    }
+    return clones;
+}
+
+/**
+ * @brief to_eval_infos Moves the evaluation results into Python objects
+ */
+py::list to_eval_infos(vector<EvalInfo>& evalInfos)
+{
+    py::list results;
+    for (EvalInfo& evalInfo : evalInfos) {
+        results.append(py::cast(std::move(evalInfo)));
+    }
+    return results;
+}
+
+#ifdef USE_RL
+/**
+ * @brief The LoadedBatch struct returns a batch to its loader when the last NumPy view on it is released
+ */
+struct LoadedBatch
+{
+    shared_ptr<TrainDataLoader> loader;
+    unique_ptr<TrainBatch> batch;
+
+    ~LoadedBatch() {
+        loader->release_batch(std::move(batch));
+    }
+};
+
+/**
+ * @brief batch_to_dict Returns the arrays of a batch as NumPy views which share the ownership of the batch
+ */
+py::dict batch_to_dict(const shared_ptr<TrainDataLoader>& loader, unique_ptr<TrainBatch> batch)
+{
+    const size_t batchSize = batch->batchSize;
+    TrainBatch* data = batch.get();
+    py::capsule owner(new LoadedBatch{loader, std::move(batch)}, [](void* ptr) { delete static_cast<LoadedBatch*>(ptr); });
+    py::dict arrays;
+    arrays["x"] = py::array_t<float>({batchSize, loader->get_number_channels(), loader->get_board_height(), loader->get_board_width()}, data->x, owner);
+    arrays["y_policy"] = py::array_t<float>({batchSize, loader->get_number_labels()}, data->yPolicy, owner);
+    arrays["y_value"] = py::array_t<float>({batchSize}, data->yValue, owner);
+    arrays["y_best_move_q"] = py::array_t<float>({batchSize}, data->yBestMoveQ, owner);
+    arrays["plys_to_end"] = py::array_t<float>({batchSize}, data->plysToEnd, owner);
+    arrays["phase_vector"] = py::array_t<float>({batchSize}, data->phaseVector, owner);
+    return arrays;
+}
+#endif
+
+PYBIND11_MODULE(crazyara, m) {
+    m.doc() = "Python bindings of the CrazyAra search, networks and environments";
+
+    m.def("make_version", [](VersionType major, VersionType minor, VersionType patch) { return make_version(major, minor, patch); },
+          "Returns the version of an input representation", py::arg("major"), py::arg("minor"), py::arg("patch"));
+    m.def("start_fen", [](int variant) { return StateConstants::start_fen(variant); },
+          "Returns the starting position of the given variant", py::arg("variant"));
+    m.def("variant_to_int", [](const string& variant) { return StateConstants::variant_to_int(variant); },
+          "Returns the integer representation of a variant name", py::arg("variant"));
+    m.def("input_shape", []() {
+        return py::make_tuple(StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH());
+    }, "Returns the shape (C, H, W) of the input planes of a single position");
+    m.def("get_state_planes", [](const vector<const StateObj*>& states, bool normalize, Version version, py::object out) {
+        py::array_t<float, py::array::c_style> planes = out.is_none() ?
+                    py::array_t<float, py::array::c_style>({states.size(), size_t(StateConstants::NB_CHANNELS_TOTAL()),
+                                                            size_t(StateConstants::BOARD_HEIGHT()), size_t(StateConstants::BOARD_WIDTH())}) :
+                    out.cast<py::array_t<float, py::array::c_style>>();
+        fill_state_planes(states, normalize, version, planes);
+        return planes;
+    }, "Returns the input planes of the given states as a (N, C, H, W) float32 array.\n"
+       "If out is given, the planes are written into this array instead of a new one.",
+          py::arg("states"), py::arg("normalize") = true, py::arg("version") = StateConstants::CURRENT_VERSION(), py::arg("out") = py::none());
+
+    py::enum_<TerminalType>(m, "TerminalType")
+            .value("LOSS", TERMINAL_LOSS)
+            .value("DRAW", TERMINAL_DRAW)
+            .value("WIN", TERMINAL_WIN)
+            .value("CUSTOM", TERMINAL_CUSTOM)
+            .value("NONE", TERMINAL_NONE);
+
+    py::class_<StateObj>(m, "State")
+            .def(py::init([](int variant, const string& fen, bool isChess960) {
+                     unique_ptr<StateObj> state = make_unique<StateObj>();
+                     state->set(fen, isChess960, variant);
+                     return state;
+                 }), py::arg("variant"), py::arg("fen"), py::arg("is_chess960") = false)
+            .def("set", &StateObj::set, py::arg("fen"), py::arg("is_chess960"), py::arg("variant"))
+            .def("fen", &StateObj::fen)
+            .def("legal_actions", &StateObj::legal_actions)
+            .def("do_action", &StateObj::do_action, py::arg("action"))
+            .def("undo_action", &StateObj::undo_action, py::arg("action"))
+            .def("side_to_move", &StateObj::side_to_move)
+            .def("hash_key", &StateObj::hash_key)
+            .def("number_repetitions", &StateObj::number_repetitions)
+            .def("gives_check", &StateObj::gives_check, py::arg("action"))
+            .def("uci_to_action", [](const StateObj& state, string uciStr) { return state.uci_to_action(uciStr); }, py::arg("uci"))
+            .def("action_to_uci", [](const StateObj& state, Action action) { return StateConstants::action_to_uci(action, state.is_chess960()); },
+                 py::arg("action"))
+            .def("action_to_san", [](const StateObj& state, Action action) { return state.action_to_san(action, state.legal_actions()); },
+                 py::arg("action"))
+            .def("is_terminal", [](const StateObj& state) {
+                float customTerminalValue = 0;
+                const TerminalType terminal = state.is_terminal(state.legal_actions().size(), customTerminalValue);
+                return py::make_tuple(terminal, customTerminalValue);
+            }, "Returns the terminal type and the value of custom terminals")
+            .def("clone", [](const StateObj& state) { return unique_ptr<StateObj>(state.clone()); })
+            .def("get_state_planes", [](const StateObj& state, bool normalize, Version version) {
+                py::array_t<float, py::array::c_style> planes({size_t(StateConstants::NB_CHANNELS_TOTAL()), size_t(StateConstants::BOARD_HEIGHT()),
+                                                               size_t(StateConstants::BOARD_WIDTH())});
+                fill_state_planes({&state}, normalize, version, planes);
+                return planes;
+            }, py::arg("normalize") = true, py::arg("version") = StateConstants::CURRENT_VERSION())
+            .def("__repr__", &StateObj::fen);
+
+    py::class_<EvalInfo>(m, "EvalInfo")
+            .def_readonly("legal_moves", &EvalInfo::legalMoves)
+            .def_readonly("best_move", &EvalInfo::bestMove)
+            .def_readonly("nodes", &EvalInfo::nodes)
+            .def_readonly("depth", &EvalInfo::depth)
+            .def_readonly("sel_depth", &EvalInfo::selDepth)
+            .def_readonly("pv", &EvalInfo::pv)
+            .def_property_readonly("value", [](const EvalInfo& evalInfo) { return evalInfo.bestMoveQ.empty() ? 0.0f : evalInfo.bestMoveQ.front(); })
+            .def_property_readonly("centipawns", [](const EvalInfo& evalInfo) { return evalInfo.centipawns.empty() ? 0 : evalInfo.centipawns.front(); })
+            .def_property_readonly("policy", [](py::object self) { return policy_view(self.cast<EvalInfo&>(), self); },
+                                   "Probabilities of the legal moves as a view on the result (in the order of legal_moves)")
+            .def_property_readonly("elapsed_time_ms", &EvalInfo::calculate_elapsed_time_ms);
+
+    py::class_<RawNetAgent>(m, "RawNetAgent")
+            .def("evaluate", [](RawNetAgent& agent, const vector<const StateObj*>& states) {
+                vector<unique_ptr<StateObj>> clones = to_states(states);
+                vector<EvalInfo> evalInfos;
+                {
+                    py::gil_scoped_release release;
+                    agent.evaluate_states(clones, evalInfos);
+                }
+                return to_eval_infos(evalInfos);
+            }, "Evaluates the given states with a single network prediction each", py::arg("states"));
+
+    py::class_<MCTSAgent>(m, "MCTSAgent")
+            .def("search", [](MCTSAgent& agent, const StateObj& state, size_t nodes, int movetime) {
+                unique_ptr<StateObj> searchState(state.clone());
+                SearchLimits limits;
+                limits.nodes = nodes;
+                limits.movetime = movetime;
+                EvalInfo evalInfo;
+                {
+                    py::gil_scoped_release release;
+                    agent.set_search_settings(searchState.get(), &limits, &evalInfo);
+                    agent.evaluate_board_state();
+                }
+                return evalInfo;
+            }, "Runs a search on the given state until the node or time limit is reached", py::arg("state"), py::arg("nodes") = 0, py::arg("movetime") = 0)
+            .def("clear_game_history", &MCTSAgent::clear_game_history)
+            .def("apply_move_to_tree", &MCTSAgent::apply_move_to_tree, py::arg("move"), py::arg("own_move"));
+
+    py::class_<CrazyAra>(m, "Engine")
+            .def(py::init([]() {
+                     unique_ptr<CrazyAra> engine = make_unique<CrazyAra>();
+                     engine->init();
+                     return engine;
+                 }))
+            .def("set_option", [](CrazyAra& engine, const string& name, py::object value) { engine.set_option(name, py::str(value)); },
+                 py::arg("name"), py::arg("value"))
+            .def("is_ready", [](CrazyAra& engine) {
+                py::gil_scoped_release release;
+                return engine.get_mcts_agent() != nullptr;
+            }, "Loads the networks in case they haven't been loaded yet")
+            .def_property_readonly("variant", &CrazyAra::get_variant)
+            .def_property_readonly("mcts_agent", &CrazyAra::get_mcts_agent, py::return_value_policy::reference_internal)
+            .def_property_readonly("raw_agent", &CrazyAra::get_raw_agent, py::return_value_policy::reference_internal)
+            .def("evaluate", [](CrazyAra& engine, const vector<const StateObj*>& states) {
+                vector<unique_ptr<StateObj>> clones = to_states(states);
+                vector<EvalInfo> evalInfos;
+                {
+                    py::gil_scoped_release release;
+                    engine.evaluate_states(clones, evalInfos);
+                }
+                return to_eval_infos(evalInfos);
+            }, "Evaluates the given states in mini-batches of the batched networks without a search", py::arg("states"));
+
+#ifdef USE_RL
+    py::class_<TrainDataLoader, shared_ptr<TrainDataLoader>>(m, "TrainDataLoader")
+            .def(py::init<const vector<string>&, size_t, size_t, size_t, bool, float, size_t, uint64_t>(),
+                 py::arg("file_paths"), py::arg("batch_size"), py::arg("number_threads") = 4, py::arg("prefetch_batches") = 8,
+                 py::arg("shuffle") = true, py::arg("mirror_probability") = 0.0f, py::arg("chunks_per_group") = 8, py::arg("seed") = 42)
+            .def("next_batch", [](const shared_ptr<TrainDataLoader>& loader) {
+                unique_ptr<TrainBatch> batch;
+                {
+                    py::gil_scoped_release release;
+                    batch = loader->next_batch();
+                }
+                return batch_to_dict(loader, std::move(batch));
+            }, "Returns the next batch as a dict with the keys of get_numpy_arrays().\n"
+               "The arrays are views on the batch buffer which is reused after all of them have been released.")
+            .def_property_readonly("number_samples", &TrainDataLoader::get_number_samples)
+            .def_property_readonly("epoch", &TrainDataLoader::get_epoch);
+#endif
+}
+#endif
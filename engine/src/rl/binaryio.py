@@ -91,6 +91,18 @@ class BinaryIO:
         self.proc.stdin.flush()
         self.read_output(b"readyok\n", check_error=True)
 
+    def reload_model(self, model_dir: str):
+        """
+        Tells the binary to load the network of the given directory in the background.
+        The new network is swapped in before the next search, so that the binary doesn't need to be restarted.
+        The next "selfplay" or "arena" command waits until the network has been loaded.
+        :param model_dir: Model directory of the new network
+        :return:
+        """
+        logging.info(f'Reloading network from {model_dir} ...')
+        self.proc.stdin.write(b"reloadmodel %b\n" % bytes(model_dir, encoding="utf-8"))
+        self.proc.stdin.flush()
+
     def read_output(self, last_line=b"readyok\n", check_error=True):
         """
         Reads the output of a process pip until the given last line has been reached.
@@ -0,0 +1,206 @@
+"""
+@file: coordinator.py
+Created on 15.10.2026
+@project: CrazyAra
+@author: queensgambit
+
+Coordinator of a distributed selfplay cluster. The engines are started once with the "worker <host>:<port>" command
+(see coordinatorclient.h) and stay connected over all generations. Each worker receives the current UCI options and model,
+generates selfplay games in small jobs and plays arena games when a contender is evaluated.
+The games are streamed by the workers to the replay buffer service (see replaybuffer.py) given by "Selfplay_Publish_Address".
+
+Usage:
+coordinator = Coordinator(port=5556, games_per_job=16)
+coordinator.set_option("Nodes", 800)
+coordinator.set_option("Selfplay_Publish_Address", "trainer:5555")
+coordinator.set_model("model/ClassicAra/chess/")
+coordinator.start()
+...
+result = coordinator.run_arena("model_contender/ClassicAra/chess/", nb_games=100)
+if result["replace"]:
+    coordinator.set_model("model_contender/ClassicAra/chess/")
+"""
+
+import logging
+import socket
+import threading
+import time
+
+IDLE_INTERVAL_S = 1
+
+
+class ArenaJob:
+    """
+    Arena games of a single contender which are distributed over the workers in chunks
+    """
+
+    def __init__(self, contender_dir, nb_games):
+        self.contender_dir = contender_dir
+        self.nb_open_games = nb_games
+        self.nb_running_games = 0
+        self.wins = 0
+        self.draws = 0
+        self.losses = 0
+        self.finished = threading.Event()
+
+
+class Coordinator:
+    """
+    Distributes selfplay and arena jobs to all connected workers
+    """
+
+    def __init__(self, host="0.0.0.0", port=5556, games_per_job=16, arena_games_per_job=4):
+        """
+        :param host: Interface to listen on
+        :param port: Port to listen on
+        :param games_per_job: Number of selfplay games of a single job, a new model is swapped in between two jobs
+        :param arena_games_per_job: Number of arena games which are sent to a worker at once
+        """
+        self.host = host
+        self.port = port
+        self.games_per_job = games_per_job
+        self.arena_games_per_job = arena_games_per_job
+        self.options = {}
+        self.model_dir = None
+        self.arena_job = None
+        self.nb_selfplay_games = 0
+        self.workers = set()
+        self.lock = threading.Lock()
+        self.server_socket = None
+
+    def start(self):
+        """
+        Starts accepting workers in a background thread
+        """
+        self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server_socket.bind((self.host, self.port))
+        self.server_socket.listen()
+        threading.Thread(target=self._accept_workers, daemon=True).start()
+        logging.info("Coordinator is listening on %s:%d", self.host, self.port)
+
+    def set_option(self, name, value):
+        """
+        Sets a UCI option on all current and future workers before their next job
+        """
+        with self.lock:
+            self.options[name] = str(value)
+
+    def set_model(self, model_dir):
+        """
+        Switches all workers to the given model directory. The workers load it in the background and swap it in before their next job.
+        """
+        with self.lock:
+            self.model_dir = model_dir
+
+    def run_arena(self, contender_dir, nb_games, timeout=None):
+        """
+        Plays arena games of the contender against the current model on all workers. Selfplay is paused meanwhile.
+        :return: Dictionary with the number of "wins", "draws" and "losses" of the contender and the decision "replace"
+        """
+        job = ArenaJob(contender_dir, nb_games)
+        with self.lock:
+            self.arena_job = job
+        job.finished.wait(timeout)
+        with self.lock:
+            self.arena_job = None
+        nb_games = job.wins + job.draws + job.losses
+        score = (job.wins + 0.5 * job.draws) / nb_games if nb_games > 0 else 0
+        return {"wins": job.wins, "draws": job.draws, "losses": job.losses, "replace": score > 0.5}
+
+    def get_number_workers(self):
+        with self.lock:
+            return len(self.workers)
+
+    def get_number_selfplay_games(self):
+        with self.lock:
+            return self.nb_selfplay_games
+
+    def _accept_workers(self):
+        while True:
+            connection, address = self.server_socket.accept()
+            threading.Thread(target=self._serve_worker, args=(connection, address), daemon=True).start()
+
+    def _serve_worker(self, connection, address):
+        """
+        Sends the jobs to a single worker until its connection is lost
+        """
+        reader = connection.makefile("r")
+        registration = reader.readline().split()
+        name = registration[1] if len(registration) > 1 else str(address)
+        logging.info("Worker %s connected from %s", name, address)
+        with self.lock:
+            self.workers.add(name)
+        worker_options = {}
+        worker_model_dir = None
+
+        def execute(command):
+            connection.sendall((command + "\n").encode())
+            reply = reader.readline()
+            if not reply:
+                raise ConnectionError("connection closed")
+            if reply.startswith("error"):
+                logging.warning("Worker %s: %s", name, reply.strip())
+            return reply.split()
+
+        try:
+            while True:
+                with self.lock:
+                    options = dict(self.options)
+                    model_dir = self.model_dir
+                for option_name, value in options.items():
+                    if worker_options.get(option_name) != value:
+                        execute(f"setoption name {option_name} value {value}")
+                        worker_options[option_name] = value
+                if model_dir is not None and model_dir != worker_model_dir:
+                    execute(f"reloadmodel {model_dir}")
+                    worker_model_dir = model_dir
+
+                job, nb_games = self._take_arena_games()
+                if job is not None:
+                    self._run_arena_games(execute, job, nb_games)
+                elif model_dir is not None:
+                    reply = execute(f"selfplay {self.games_per_job}")
+                    if reply[0] == "done":
+                        with self.lock:
+                            self.nb_selfplay_games += self.games_per_job
+                else:
+                    time.sleep(IDLE_INTERVAL_S)
+        except (ConnectionError, OSError) as e:
+            logging.warning("Worker %s disconnected: %s", name, e)
+        finally:
+            with self.lock:
+                self.workers.discard(name)
+            connection.close()
+
+    def _take_arena_games(self):
+        """
+        Reserves the next chunk of open arena games
+        :return: Arena job and number of games or (None, 0) if there are no open games
+        """
+        with self.lock:
+            job = self.arena_job
+            if job is None or job.nb_open_games == 0:
+                return None, 0
+            nb_games = min(self.arena_games_per_job, job.nb_open_games)
+            job.nb_open_games -= nb_games
+            job.nb_running_games += nb_games
+            return job, nb_games
+
+    def _run_arena_games(self, execute, job, nb_games):
+        try:
+            reply = execute(f"arena {nb_games} {job.contender_dir}")
+        except (ConnectionError, OSError):
+            # another worker plays the games of the lost worker
+            with self.lock:
+                job.nb_open_games += nb_games
+                job.nb_running_games -= nb_games
+            raise
+        with self.lock:
+            job.nb_running_games -= nb_games
+            if reply[0] == "arena":
+                job.wins += int(reply[1])
+                job.draws += int(reply[2])
+                job.losses += int(reply[3])
+            if job.nb_open_games == 0 and job.nb_running_games == 0:
+                job.finished.set()
@@ -0,0 +1,112 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+ * @file: coordinatorclient.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#if defined(USE_RL) && !defined(_WIN32)
+#include "coordinatorclient.h"
+#include <unistd.h>
+#include <thread>
+#include <chrono>
+#include <sys/socket.h>
+#include "../util/tcpsocket.h"
+#include "../util/communication.h"
+
+CoordinatorClient::CoordinatorClient(const string& address, const string& registration):
+    address(address),
+    registration(registration),
+    fd(-1)
+{
+}
+
+CoordinatorClient::~CoordinatorClient()
+{
+    disconnect();
+}
+
+void CoordinatorClient::disconnect()
+{
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+    pending.clear();
+}
+
+void CoordinatorClient::connect_to_coordinator()
+{
+    disconnect();
+    bool isFirstAttempt = true;
+    while (true) {
+        fd = connect_to_address(address);
+        if (fd != -1 && send_line(registration)) {
+            info_string("registered at the coordinator", address);
+            return;
+        }
+        disconnect();
+        if (isFirstAttempt) {
+            info_string_important("Warning: The coordinator", address, "couldn't be reached. Retrying every", COORDINATOR_RECONNECT_INTERVAL_S, "seconds.");
+            isFirstAttempt = false;
+        }
+        this_thread::sleep_for(chrono::seconds(COORDINATOR_RECONNECT_INTERVAL_S));
+    }
+}
+
+bool CoordinatorClient::read_line(string& line)
+{
+    char buffer[4096];
+    size_t lineEnd;
+    while ((lineEnd = pending.find('\n')) == string::npos) {
+        if (fd == -1) {
+            return false;
+        }
+        const ssize_t numberBytes = recv(fd, buffer, sizeof(buffer), 0);
+        if (numberBytes <= 0) {
+            disconnect();
+            return false;
+        }
+        pending.append(buffer, size_t(numberBytes));
+    }
+    line = pending.substr(0, lineEnd);
+    if (line.size() != 0 && line.back() == '\r') {
+        line.pop_back();
+    }
+    pending.erase(0, lineEnd + 1);
+    return true;
+}
+
+bool CoordinatorClient::send_line(const string& line)
+{
+    if (fd == -1) {
+        return false;
+    }
+    const string message = line + "\n";
+    if (!send_all(fd, message.data(), message.size())) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+#endif
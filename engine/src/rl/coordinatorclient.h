@@ -0,0 +1,87 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: coordinatorclient.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Line based connection of a selfplay worker ("worker" command) to the coordinator of a distributed selfplay cluster (see rl/coordinator.py).
+ * After connecting the worker sends "register <name> <variant>". The coordinator answers with engine commands, one per line,
+ * e.g. "setoption name Nodes value 800", "reloadmodel <dir>", "selfplay <games>" or "arena <games> [<contender dir>]".
+ * Every command is acknowledged with a single result line once it has been executed.
+ */
+
+#ifndef COORDINATORCLIENT_H
+#define COORDINATORCLIENT_H
+
+#if defined(USE_RL) && !defined(_WIN32)
+#include <string>
+
+// time between two attempts to reach the coordinator
+#define COORDINATOR_RECONNECT_INTERVAL_S 5
+
+class CoordinatorClient
+{
+private:
+    std::string address;
+    std::string registration;
+    int fd;
+    // received bytes which don't form a full line yet
+    std::string pending;
+
+    /**
+     * @brief disconnect Closes the current connection
+     */
+    void disconnect();
+
+public:
+    /**
+     * @brief CoordinatorClient
+     * @param address Address of the coordinator in the form <host>:<port>
+     * @param registration Registration line which is sent after every (re-)connect
+     */
+    CoordinatorClient(const std::string& address, const std::string& registration);
+    ~CoordinatorClient();
+    CoordinatorClient(const CoordinatorClient&) = delete;
+    CoordinatorClient& operator=(const CoordinatorClient&) = delete;
+
+    /**
+     * @brief connect_to_coordinator Blocks until the coordinator has been reached and the registration has been sent
+     */
+    void connect_to_coordinator();
+
+    /**
+     * @brief read_line Blocks until the next line has been received
+     * @param line Received line without the line break
+     * @return False if the connection has been lost
+     */
+    bool read_line(std::string& line);
+
+    /**
+     * @brief send_line Sends a single line, the line break is appended
+     * @param line Line without a line break
+     * @return False if the connection has been lost
+     */
+    bool send_line(const std::string& line);
+};
+#endif
+
+#endif // COORDINATORCLIENT_H
@@ -20,7 +20,7 @@ from DeepCrazyhouse.configs.main_config import main_config
 from engine.src.rl.rl_utils import create_dir, move_all_files
 
 
-def compress_zarr_dataset(data, file_path, compression='lz4', clevel=5, start_idx=0, end_idx=0):
+def compress_zarr_dataset(data, file_path, compression='lz4', clevel=5, start_idx=0, end_idx=0, attrs=None):
     """
     Loads in a zarr data set and exports it with a given compression type and level
     :param data: Zarr data set which will be compressed
@@ -30,6 +30,7 @@ def compress_zarr_dataset(data, file_path, compression='lz4', clevel=5, start_id
     :param start_idx: Starting index of data to be exported.
     :param end_idx: If end_idx != 0 the data set will be exported to the specified index,
     excluding the sample at end_idx (e.g. end_idx = len(x) will export it fully)
+    :param attrs: Attributes of the data set (e.g. the format_version of the packed export format) which are kept
     :return: True if a NaN value was detected
     """
     compressor = Blosc(cname=compression, clevel=clevel, shuffle=Blosc.SHUFFLE)
@@ -37,6 +38,8 @@ def compress_zarr_dataset(data, file_path, compression='lz4', clevel=5, start_id
     # open a dataset file and create arrays
     store = zarr.ZipStore(file_path, mode="w")
     zarr_file = zarr.group(store=store, overwrite=True)
+    if attrs is not None:
+        zarr_file.attrs.update(attrs)
 
     nan_detected = False
     for key in data.keys():
@@ -194,11 +197,13 @@ class FileIO:
         :param device_name: The currently active device name (context_device-id)
         :return:
         """
-        data = zarr.load(self.binary_dir + "data_" + device_name + ".zarr")
+        data_path = self.binary_dir + "data_" + device_name + ".zarr"
+        data = zarr.load(data_path)
+        attrs = zarr.open_group(data_path, mode="r").attrs.asdict()
 
         export_dir, time_stamp = self.create_export_dir(device_name)
         zarr_path = export_dir + time_stamp + ".zip"
-        nan_detected = compress_zarr_dataset(data, zarr_path, start_idx=0)
+        nan_detected = compress_zarr_dataset(data, zarr_path, start_idx=0, attrs=attrs)
         if nan_detected is True:
             logging.error("NaN value detected in file %s.zip" % time_stamp)
             new_export_dir = self.binary_dir + time_stamp
@@ -245,7 +250,11 @@ class FileIO:
         :param export_dir: Export directory for the newly generated data
         :param device_name: The currently active device name (context_device-id)
         """
-        file_names = ["games_" + device_name + ".pgn",
+        pgn_file_name = "games_" + device_name + ".pgn"
+        if not os.path.exists(self.binary_dir + pgn_file_name):
+            # the engine writes compressed games if "Selfplay_PGN_Compression" is enabled
+            pgn_file_name += ".gz"
+        file_names = [pgn_file_name,
                       "gameIdx_" + device_name + ".txt"]
         for file_name in file_names:
             os.rename(self.binary_dir + file_name, export_dir + file_name)
@@ -0,0 +1,234 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: openingbook.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#ifdef USE_RL
+#include "openingbook.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "../util/communication.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+struct EPDIndexHeader {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t fileSize;
+    int64_t modificationTime;
+    uint64_t numberLines;
+};
+}
+
+OpeningBook::OpeningBook(const string& filePath, int sampling):
+    fileData(nullptr),
+    fileSize(0),
+    sampling(sampling),
+    permutationIdx(0),
+    prng(random_device()())
+{
+    map_file(filePath);
+    const string indexPath = filePath + ".idx";
+    const int64_t modificationTime = int64_t(std::filesystem::last_write_time(filePath).time_since_epoch().count());
+    if (!load_index(indexPath, modificationTime)) {
+        build_index(indexPath, modificationTime);
+    }
+    if (lineOffsets.empty()) {
+        throw invalid_argument("Given epd file: " + filePath + " doesn't contain any position.");
+    }
+
+    if (sampling == EPD_SAMPLING_WEIGHTED) {
+        vector<double> weights(lineOffsets.size());
+        for (size_t idx = 0; idx < lineOffsets.size(); ++idx) {
+            parse_epd_line(get_line(idx), weights[idx]);
+        }
+        weightDistribution = discrete_distribution<size_t>(weights.begin(), weights.end());
+    }
+    else if (sampling == EPD_SAMPLING_WITHOUT_REPLACEMENT) {
+        permutation.resize(lineOffsets.size());
+        for (size_t idx = 0; idx < permutation.size(); ++idx) {
+            permutation[idx] = idx;
+        }
+        shuffle(permutation.begin(), permutation.end(), prng);
+    }
+    info_string("Loaded epd file:", filePath, "(" + to_string(lineOffsets.size()) + " positions)");
+}
+
+OpeningBook::~OpeningBook()
+{
+#ifndef _WIN32
+    if (fileData != nullptr) {
+        munmap(const_cast<char*>(fileData), fileSize);
+    }
+#endif
+}
+
+void OpeningBook::map_file(const string& filePath)
+{
+#ifndef _WIN32
+    const int fd = open(filePath.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fd == -1 || fstat(fd, &fileStat) == -1 || fileStat.st_size == 0) {
+        if (fd != -1) {
+            close(fd);
+        }
+        throw invalid_argument("Given epd file: " + filePath + " could not be opened.");
+    }
+    fileSize = size_t(fileStat.st_size);
+    void* data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw invalid_argument("Given epd file: " + filePath + " couldn't be mapped into memory.");
+    }
+    fileData = static_cast<const char*>(data);
+    // the lines are accessed at random
+    madvise(data, fileSize, MADV_RANDOM);
+#else
+    ifstream file(filePath, ios::binary);
+    if (!file.is_open()) {
+        throw invalid_argument("Given epd file: " + filePath + " could not be opened.");
+    }
+    fileContent.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    fileData = fileContent.data();
+    fileSize = fileContent.size();
+#endif
+}
+
+bool OpeningBook::load_index(const string& indexPath, int64_t modificationTime)
+{
+    ifstream indexFile(indexPath, ios::binary);
+    if (!indexFile.is_open()) {
+        return false;
+    }
+    EPDIndexHeader header;
+    if (!indexFile.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != EPD_INDEX_MAGIC ||
+            header.fileSize != fileSize || header.modificationTime != modificationTime) {
+        return false;
+    }
+    lineOffsets.resize(header.numberLines);
+    if (!indexFile.read(reinterpret_cast<char*>(lineOffsets.data()), streamsize(header.numberLines * sizeof(uint64_t)))) {
+        lineOffsets.clear();
+        return false;
+    }
+    return true;
+}
+
+void OpeningBook::build_index(const string& indexPath, int64_t modificationTime)
+{
+    lineOffsets.clear();
+    size_t lineStart = 0;
+    while (lineStart < fileSize) {
+        const char* lineEnd = static_cast<const char*>(memchr(fileData + lineStart, '\n', fileSize - lineStart));
+        const size_t lineEndOffset = lineEnd == nullptr ? fileSize : size_t(lineEnd - fileData);
+        // skip empty lines
+        if (lineEndOffset > lineStart && !(lineEndOffset == lineStart + 1 && fileData[lineStart] == '\r')) {
+            lineOffsets.emplace_back(lineStart);
+        }
+        lineStart = lineEndOffset + 1;
+    }
+
+    // the index is only a cache, a read-only directory is not an error
+    ofstream indexFile(indexPath, ios::binary | ios::trunc);
+    if (!indexFile.is_open()) {
+        return;
+    }
+    const EPDIndexHeader header = {EPD_INDEX_MAGIC, 0, fileSize, modificationTime, lineOffsets.size()};
+    indexFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    indexFile.write(reinterpret_cast<const char*>(lineOffsets.data()), streamsize(lineOffsets.size() * sizeof(uint64_t)));
+}
+
+string OpeningBook::get_line(size_t lineIdx) const
+{
+    const size_t lineStart = lineOffsets[lineIdx];
+    const char* lineEnd = static_cast<const char*>(memchr(fileData + lineStart, '\n', fileSize - lineStart));
+    size_t lineLength = (lineEnd == nullptr ? fileSize : size_t(lineEnd - fileData)) - lineStart;
+    if (lineLength > 0 && fileData[lineStart + lineLength - 1] == '\r') {
+        --lineLength;
+    }
+    return string(fileData + lineStart, lineLength);
+}
+
+size_t OpeningBook::sample_line_idx()
+{
+    switch (sampling) {
+    case EPD_SAMPLING_WEIGHTED:
+        return weightDistribution(prng);
+    case EPD_SAMPLING_WITHOUT_REPLACEMENT:
+        if (permutationIdx == permutation.size()) {
+            shuffle(permutation.begin(), permutation.end(), prng);
+            permutationIdx = 0;
+        }
+        return permutation[permutationIdx++];
+    default:
+        return uniform_int_distribution<size_t>(0, lineOffsets.size() - 1)(prng);
+    }
+}
+
+string OpeningBook::get_random_fen()
+{
+    size_t lineIdx;
+    {
+        lock_guard<mutex> lock(mtx);
+        lineIdx = sample_line_idx();
+    }
+    double weight;
+    return parse_epd_line(get_line(lineIdx), weight);
+}
+
+size_t OpeningBook::size() const
+{
+    return lineOffsets.size();
+}
+
+string parse_epd_line(const string& line, double& weight)
+{
+    weight = 1.0;
+    string fen = line;
+    const size_t weightPos = fen.find(" weight ");
+    if (weightPos != string::npos) {
+        try {
+            weight = stod(fen.substr(weightPos + 8));
+        } catch (const exception&) {
+            throw invalid_argument("Invalid weight operation in epd line: " + line);
+        }
+        fen = fen.substr(0, weightPos);
+    }
+    // remove last ";" and trailing white spaces
+    while (!fen.empty() && (fen.back() == ';' || fen.back() == ' ')) {
+        fen.pop_back();
+    }
+    return fen;
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: openingbook.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Memory mapped EPD file with a line offset index for sampling the starting positions of the selfplay games.
+ * The index is cached next to the EPD file as "<epd file>.idx" and rebuilt if the EPD file changes.
+ */
+
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#ifdef USE_RL
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+// every line is sampled with the same probability
+#define EPD_SAMPLING_UNIFORM 0
+// lines are sampled according to their "weight <value>;" operation (1 if missing)
+#define EPD_SAMPLING_WEIGHTED 1
+// all lines are sampled once in a random order before a line is repeated
+#define EPD_SAMPLING_WITHOUT_REPLACEMENT 2
+
+// identifies the cached index file
+#define EPD_INDEX_MAGIC 0x58444945
+
+/**
+ * @brief The OpeningBook class maps an EPD file into memory once and samples random lines in O(1) (O(log n) for weighted sampling).
+ * A single instance can be shared by all concurrent selfplay games.
+ */
+class OpeningBook
+{
+private:
+    const char* fileData;
+    size_t fileSize;
+#ifdef _WIN32
+    std::string fileContent;
+#endif
+    // start offset of every non-empty line
+    std::vector<uint64_t> lineOffsets;
+    int sampling;
+    std::discrete_distribution<size_t> weightDistribution;
+    std::vector<size_t> permutation;
+    size_t permutationIdx;
+    std::mt19937_64 prng;
+    std::mutex mtx;
+
+    /**
+     * @brief map_file Maps the EPD file into memory
+     * @param filePath Path of the EPD file
+     */
+    void map_file(const std::string& filePath);
+
+    /**
+     * @brief load_index Loads the line offsets from the index file if it belongs to the current EPD file
+     * @param indexPath Path of the index file
+     * @param modificationTime Modification time of the EPD file
+     * @return True on success
+     */
+    bool load_index(const std::string& indexPath, int64_t modificationTime);
+
+    /**
+     * @brief build_index Scans the EPD file for all non-empty lines and tries to store the index on disk
+     * @param indexPath Path of the index file
+     * @param modificationTime Modification time of the EPD file
+     */
+    void build_index(const std::string& indexPath, int64_t modificationTime);
+
+    /**
+     * @brief get_line Returns the line with the given index without the trailing line break
+     */
+    std::string get_line(size_t lineIdx) const;
+
+    /**
+     * @brief sample_line_idx Returns the index of the next line according to the sampling strategy (mtx must be locked)
+     */
+    size_t sample_line_idx();
+
+public:
+    /**
+     * @brief OpeningBook
+     * @param filePath Path of the EPD file with one position per line
+     * @param sampling EPD_SAMPLING_UNIFORM, EPD_SAMPLING_WEIGHTED or EPD_SAMPLING_WITHOUT_REPLACEMENT
+     */
+    OpeningBook(const std::string& filePath, int sampling=EPD_SAMPLING_UNIFORM);
+    ~OpeningBook();
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    /**
+     * @brief get_random_fen Returns the fen of a random line without the trailing ";" and the weight operation.
+     * This method is thread-safe.
+     * @return fen string
+     */
+    std::string get_random_fen();
+
+    /**
+     * @brief size Returns the number of positions of the EPD file
+     */
+    size_t size() const;
+};
+
+/**
+ * @brief parse_epd_line Splits an EPD line into its position and its optional weight operation
+ * @param line EPD line, e.g. "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - weight 2.5;"
+ * @param weight Is set to the weight of the line (1 if the line has no weight operation)
+ * @return fen string without the weight operation and the trailing ";"
+ */
+std::string parse_epd_line(const std::string& line, double& weight);
+
+#endif
+
+#endif // OPENINGBOOK_H
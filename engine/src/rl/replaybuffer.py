@@ -0,0 +1,136 @@
+"""
+@file: replaybuffer.py
+Created on 14.10.2026
+@project: CrazyAra
+@author: queensgambit
+
+Replay buffer service which receives the finished selfplay games of engines started with the UCI option
+"Selfplay_Publish_Address" set to <host>:<port> of this service.
+Each connection starts with a shard header followed by game records in the shard record layout (see shardwriter.h).
+The most recent games are kept in memory and can be sampled by the trainer with get_dataset().
+
+Usage:
+buffer = ReplayBuffer(port=5555, max_samples=1000000)
+buffer.start()
+...
+pgn_dataset_arrays_dict = buffer.get_dataset()
+"""
+
+import collections
+import logging
+import socket
+import threading
+
+from engine.src.rl.shardio import SHARD_HEADER_SIZE, read_header, parse_records, games_to_arrays
+
+RECV_SIZE = 1 << 20
+
+
+class ReplayBuffer:
+    """
+    Collects the published games of all connected engines in a bounded first-in-first-out buffer
+    """
+
+    def __init__(self, host="0.0.0.0", port=5555, max_samples=1000000):
+        """
+        :param host: Interface to listen on
+        :param port: Port to listen on
+        :param max_samples: Maximum number of samples which are kept, the oldest games are discarded first
+        """
+        self.host = host
+        self.port = port
+        self.max_samples = max_samples
+        self.games = collections.deque()
+        self.nb_samples = 0
+        self.nb_received_games = 0
+        self.header = None
+        self.lock = threading.Lock()
+        self.server_socket = None
+
+    def start(self):
+        """
+        Starts accepting connections in a background thread
+        """
+        self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server_socket.bind((self.host, self.port))
+        self.server_socket.listen()
+        threading.Thread(target=self._accept_connections, daemon=True).start()
+        logging.info("Replay buffer is listening on %s:%d", self.host, self.port)
+
+    def _accept_connections(self):
+        while True:
+            connection, address = self.server_socket.accept()
+            logging.info("New publisher connected from %s", address)
+            threading.Thread(target=self._receive_games, args=(connection,), daemon=True).start()
+
+    def _receive_games(self, connection):
+        """
+        Receives the header and all subsequent game records of a single publisher
+        """
+        data = bytearray()
+        header = None
+        offset = 0
+        with connection:
+            while True:
+                chunk = connection.recv(RECV_SIZE)
+                if not chunk:
+                    break
+                data += chunk
+                if header is None:
+                    if len(data) < SHARD_HEADER_SIZE:
+                        continue
+                    header = read_header(bytes(data[:SHARD_HEADER_SIZE]))
+                    if not self._check_header(header):
+                        break
+                    offset = SHARD_HEADER_SIZE
+                games, offset = parse_records(bytes(data), header, offset)
+                if games:
+                    self._add_games(games)
+                # discard the parsed records
+                del data[:offset]
+                offset = 0
+        logging.info("Publisher disconnected")
+
+    def _check_header(self, header):
+        """
+        Returns True if the header matches the header of the previously connected publishers
+        """
+        with self.lock:
+            if self.header is None:
+                self.header = header
+                return True
+            if self.header != header:
+                logging.warning("Rejected publisher with a different export format: %s", header)
+                return False
+            return True
+
+    def _add_games(self, games):
+        with self.lock:
+            for game in games:
+                # copy the game to release the receive buffer
+                game = {name: column.copy() for name, column in game.items()}
+                self.games.append(game)
+                self.nb_samples += len(game["y_value"])
+                self.nb_received_games += 1
+            while self.nb_samples > self.max_samples and len(self.games) > 1:
+                self.nb_samples -= len(self.games.popleft()["y_value"])
+
+    def get_number_samples(self):
+        """
+        Returns the number of samples which are currently stored
+        """
+        with self.lock:
+            return self.nb_samples
+
+    def get_dataset(self):
+        """
+        Returns all stored games
+        :return: pgn_dataset_arrays_dict with the same keys as get_numpy_arrays() or None if no game has been received
+        """
+        with self.lock:
+            if not self.games:
+                return None
+            games = list(self.games)
+            header = self.header
+        return games_to_arrays(games, header)
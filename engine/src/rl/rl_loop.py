@@ -94,7 +94,8 @@ class RLLoop:
 
     def check_for_new_model(self):
         """
-        Checks if the current neural network generator has been updated and restarts the executable if this is the case
+        Checks if the current neural network generator has been updated and reloads the network in the running executable
+        if this is the case
         :return:
         """
 
@@ -108,10 +109,11 @@ class RLLoop:
             model_name = self.file_io.get_current_model_tar_file()
             if model_name != "" and model_name != self.model_name:
                 logging.info("Loading new model: %s" % model_name)
+                self.model_name = model_name
 
-            self.binary_io.stop_process()
+            # the binary keeps its engines and caches and swaps in the new network before the next game
+            self.binary_io.reload_model(self.file_io.model_dir)
             self.rtpt.step()
-            self.initialize()
 
     def check_for_enough_train_data(self, number_files_to_update):
         """
@@ -0,0 +1,94 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: samplepublisher.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#if defined(USE_RL) && !defined(_WIN32)
+#include "samplepublisher.h"
+#include <unistd.h>
+#include "traindataexporter.h"
+#include "../util/tcpsocket.h"
+#include "../util/communication.h"
+
+SamplePublisher::SamplePublisher(const string& address, int exportFormat, size_t sparsePolicySize):
+    address(address),
+    fd(-1),
+    header(make_shard_header(exportFormat, sparsePolicySize)),
+    numberDroppedGames(0)
+{
+    lastConnectAttempt = chrono::steady_clock::now();
+    if (!connect_to_service()) {
+        info_string_important("Warning: The replay buffer service", address, "couldn't be reached. Games are dropped until it is available.");
+    }
+}
+
+SamplePublisher::~SamplePublisher()
+{
+    disconnect();
+}
+
+bool SamplePublisher::connect_to_service()
+{
+    lastConnectAttempt = chrono::steady_clock::now();
+    fd = connect_to_address(address);
+    if (fd == -1) {
+        return false;
+    }
+    if (!send_all(fd, reinterpret_cast<const char*>(&header), sizeof(ShardHeader))) {
+        disconnect();
+        return false;
+    }
+    info_string("publishing the selfplay games to", address);
+    return true;
+}
+
+void SamplePublisher::disconnect()
+{
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+void SamplePublisher::publish_game(const TrainGameSamples& game)
+{
+    if (game.gameValue.size() == 0) {
+        return;
+    }
+    if (fd == -1 && chrono::steady_clock::now() - lastConnectAttempt >= chrono::seconds(PUBLISHER_RECONNECT_INTERVAL_S)) {
+        connect_to_service();
+    }
+    if (fd != -1) {
+        serialize_game_record(header, game, record);
+        if (send_all(fd, record.data(), record.size())) {
+            return;
+        }
+        info_string_important("Warning: The connection to the replay buffer service", address, "has been lost.");
+        disconnect();
+    }
+    if (++numberDroppedGames % 100 == 1) {
+        info_string_important("Warning: Dropped", numberDroppedGames, "games which couldn't be published.");
+    }
+}
+#endif
@@ -0,0 +1,85 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: samplepublisher.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Publishes the finished selfplay games to a replay buffer service over TCP.
+ * The stream uses the layout of the streaming shards (see shardwriter.h): after connecting a ShardHeader is sent,
+ * followed by one record for each game. Index and footer are omitted because the stream is never closed.
+ */
+
+#ifndef SAMPLEPUBLISHER_H
+#define SAMPLEPUBLISHER_H
+
+#if defined(USE_RL) && !defined(_WIN32)
+#include <chrono>
+#include <string>
+#include <vector>
+#include "shardwriter.h"
+
+// minimum time between two attempts to reach the replay buffer service after the connection has been lost
+#define PUBLISHER_RECONNECT_INTERVAL_S 5
+
+class SamplePublisher
+{
+private:
+    std::string address;
+    int fd;
+    ShardHeader header;
+    std::vector<char> record;
+    std::chrono::steady_clock::time_point lastConnectAttempt;
+    size_t numberDroppedGames;
+
+    /**
+     * @brief connect_to_service Opens the connection and sends the header
+     * @return True on success
+     */
+    bool connect_to_service();
+
+    /**
+     * @brief disconnect Closes the current connection
+     */
+    void disconnect();
+
+public:
+    /**
+     * @brief SamplePublisher
+     * @param address Address of the replay buffer service in the form <host>:<port>
+     * @param exportFormat EXPORT_FORMAT_DENSE or EXPORT_FORMAT_PACKED
+     * @param sparsePolicySize Number of policy pairs of each sample in the packed format
+     */
+    SamplePublisher(const std::string& address, int exportFormat, size_t sparsePolicySize);
+    ~SamplePublisher();
+    SamplePublisher(const SamplePublisher&) = delete;
+    SamplePublisher& operator=(const SamplePublisher&) = delete;
+
+    /**
+     * @brief publish_game Sends a finished game to the replay buffer service.
+     * If the service can't be reached, the game is dropped and a new connection is attempted for a later game.
+     * @param game Samples of the game, the game result must already be applied
+     */
+    void publish_game(const TrainGameSamples& game);
+};
+#endif
+
+#endif // SAMPLEPUBLISHER_H
@@ -30,9 +30,14 @@
 #include "thread.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <thread>
 #include "state.h"
 #include "util/blazeutil.h"
 #include "util/randomgen.h"
+#include "util/metrics.h"
+#include "util/devicemonitor.h"
+#include "util/bufferedfilewriter.h"
 
 
 void play_move_and_update(const EvalInfo& evalInfo, StateObj* state, GamePGN& gamePGN, Result& gameResult)
@@ -55,30 +60,6 @@ void play_move_and_update(const EvalInfo& evalInfo, StateObj* state, GamePGN& ga
 }
 
 
-string load_random_fen(string filepath)
-{
-    if (filepath == "<empty>" or filepath == "") {
-        return "";
-    }
-    std::ifstream myfile (filepath);
-    // https://stackoverflow.com/questions/33532108/pick-a-random-line-from-text-file-in-c
-    std::random_device seed;
-    std::mt19937 prng(seed());
-    std::string line;
-    std::string result;
-    for(std::size_t n = 0; std::getline(myfile, line); n++) {
-        std::uniform_int_distribution<> dist(0, n);
-        if (dist(prng) < 1)
-            result = line;
-    }
-    // remove last ";"
-    if (result.back() == ';') {
-        result.pop_back();
-    }
-    return result;
-}
-
-
 SelfPlay::SelfPlay(RawNetAgent* rawAgent, MCTSAgent* mctsAgent, const SearchSettings* searchSettings, SearchLimits* searchLimits, const PlaySettings* playSettings,
                    const RLSettings* rlSettings, OptionsMap& options):
     rawAgent(rawAgent), mctsAgent(mctsAgent), searchSettings(searchSettings), searchLimits(searchLimits), playSettings(playSettings),
@@ -115,15 +96,22 @@ SelfPlay::SelfPlay(RawNetAgent* rawAgent, MCTSAgent* mctsAgent, const SearchSett
     this->exporter = new TrainDataExporter(string("data_") + mctsAgent->get_device_name() + string(".zarr"),
                                            mctsAgent->get_num_phases(),
                                            searchSettings->gamePhaseDefinition,
-                                           rlSettings->numberChunks, rlSettings->chunkSize);
-    filenamePGNSelfplay = string("games_") + mctsAgent->get_device_name() + string(".pgn");
-    filenamePGNArena = string("arena_games_")+ mctsAgent->get_device_name() + string(".pgn");
+                                           rlSettings->numberChunks, rlSettings->chunkSize,
+                                           rlSettings->compressionCodec, rlSettings->compressionLevel, rlSettings->exportQueueSize,
+                                           rlSettings->exportFormat, rlSettings->sparsePolicySize,
+                                           rlSettings->streamDirectory, rlSettings->shardSizeMB * 1024 * 1024, rlSettings->publishAddress);
+    // the games are compressed as gzip members which are appended to the same file
+    const string pgnFileEnding = rlSettings->compressPGN ? ".pgn.gz" : ".pgn";
+    filenamePGNSelfplay = string("games_") + mctsAgent->get_device_name() + pgnFileEnding;
+    filenamePGNArena = string("arena_games_")+ mctsAgent->get_device_name() + pgnFileEnding;
     fileNameGameIdx = string("gameIdx_") + mctsAgent->get_device_name() + string(".txt");
 
+    if (rlSettings->epdFilePath != "<empty>" && rlSettings->epdFilePath != "") {
+        openingBook = make_unique<OpeningBook>(rlSettings->epdFilePath, rlSettings->epdSampling);
+    }
+
     // delete content of files
-    ofstream pgnFile;
-    pgnFile.open(filenamePGNSelfplay, std::ios_base::trunc);
-    pgnFile.close();
+    buffered_file_writer().truncate(filenamePGNSelfplay);
     ofstream idxFile;
     idxFile.open(fileNameGameIdx, std::ios_base::trunc);
     idxFile.close();
@@ -136,6 +124,16 @@ SelfPlay::SelfPlay(RawNetAgent* rawAgent, MCTSAgent* mctsAgent, const SearchSett
 SelfPlay::~SelfPlay()
 {
     delete exporter;
+    // the games and tournament results of the command are complete when it returns
+    buffered_file_writer().flush();
+}
+
+string SelfPlay::get_starting_fen()
+{
+    if (openingBook == nullptr) {
+        return "";
+    }
+    return openingBook->get_random_fen();
 }
 
 void SelfPlay::adjust_node_count(SearchLimits* searchLimits, int randInt)
@@ -150,14 +148,14 @@ bool SelfPlay::is_quick_search() {
     if (rlSettings->quickSearchProbability < 0.01f) {
         return false;
     }
-    return float(rand()) / RAND_MAX < rlSettings->quickSearchProbability;
+    return thread_random().uniform() < rlSettings->quickSearchProbability;
 }
 
 bool SelfPlay::is_resignation_allowed() {
     if (rlSettings->resignProbability < 0.01f) {
         return false;
     }
-    return float(rand()) / RAND_MAX < rlSettings->resignProbability;
+    return thread_random().uniform() < rlSettings->resignProbability;
 }
 
 void SelfPlay::check_for_resignation(const bool allowResingation, const EvalInfo &evalInfo, const StateObj* state, Result &gameResult)
@@ -175,70 +173,143 @@ void SelfPlay::check_for_resignation(const bool allowResingation, const EvalInfo
     }
 }
 
-void SelfPlay::reset_search_params(bool isQuickSearch)
+GameAdjudication SelfPlay::init_adjudication() const
+{
+    GameAdjudication adjudication;
+    adjudication.allowTablebase = thread_random().uniform() < rlSettings->tbAdjudicationProbability;
+    adjudication.allowDraw = rlSettings->drawAdjudicationPlies != 0 && thread_random().uniform() < rlSettings->drawAdjudicationProbability;
+    adjudication.allowMaxPlies = rlSettings->maxGamePlies != 0 && thread_random().uniform() < rlSettings->maxPliesProbability;
+    return adjudication;
+}
+
+void SelfPlay::check_for_adjudication(GameAdjudication& adjudication, const EvalInfo& evalInfo, StateObj* state, size_t numberPlies, Result& gameResult) const
 {
-    searchLimits->nodes = backupNodes;
+    if (gameResult != NO_RESULT) {
+        return;
+    }
+    if (adjudication.allowTablebase) {
+        Tablebase::ProbeState result;
+        const Tablebase::WDLScore wdlScore = state->check_for_tablebase_wdl(result);
+        if (result != Tablebase::FAIL) {
+            // the score is given from the point of view of the side to move, cursed wins and blessed losses are draws by the 50 move rule
+            switch (wdlScore) {
+            case Tablebase::WDLWin:
+                gameResult = state->side_to_move() == WHITE ? WHITE_WIN : BLACK_WIN;
+                break;
+            case Tablebase::WDLLoss:
+                gameResult = state->side_to_move() == WHITE ? BLACK_WIN : WHITE_WIN;
+                break;
+            default:
+                gameResult = DRAWN;
+            }
+            return;
+        }
+    }
+    if (adjudication.allowDraw) {
+        adjudication.drawPlies = std::abs(evalInfo.bestMoveQ[0]) <= rlSettings->drawAdjudicationThreshold ? adjudication.drawPlies + 1 : 0;
+        if (adjudication.drawPlies >= rlSettings->drawAdjudicationPlies) {
+            gameResult = DRAWN;
+            return;
+        }
+    }
+    if (adjudication.allowMaxPlies && numberPlies >= rlSettings->maxGamePlies) {
+        gameResult = DRAWN;
+    }
+}
+
+void SelfPlay::set_quick_search_params(SelfPlayGame& game)
+{
+    if (game.quickAgent != nullptr) {
+        game.mctsAgent = game.quickAgent;
+    }
+    game.searchLimits.nodes = rlSettings->quickSearchNodes;
+    game.mctsAgent->update_q_value_weight(rlSettings->quickSearchQValueWeight);
+    game.mctsAgent->update_dirichlet_epsilon(rlSettings->quickDirichletEpsilon);
+}
+
+void SelfPlay::reset_search_params(SelfPlayGame& game, bool isQuickSearch)
+{
+    game.searchLimits.nodes = backupNodes;
     if (isQuickSearch) {
-        mctsAgent->update_q_value_weight(backupQValueWeight);
-        mctsAgent->update_dirichlet_epsilon(backupDirichletEpsilon);
+        game.mctsAgent->update_q_value_weight(backupQValueWeight);
+        game.mctsAgent->update_dirichlet_epsilon(backupDirichletEpsilon);
+        game.mctsAgent = game.fullAgent;
     }
 }
 
-void SelfPlay::generate_game(int variant, bool verbose)
+void SelfPlay::generate_game(SelfPlayGame& game, int variant, bool verbose)
 {
     chrono::steady_clock::time_point gameStartTime = chrono::steady_clock::now();
 
     size_t ply = size_t(random_exponential<float>(1.0f/playSettings->meanInitPly) + 0.5f);
     ply = clip_ply(ply, playSettings->maxInitPly);
 
-    srand(unsigned(int(time(nullptr))));
+    // the remaining users of rand() follow the seed of the thread generator
+    srand(unsigned(thread_random()()));
     // load position from file if epd filepath was set
-    string startingFen = load_random_fen(rlSettings->epdFilePath);
-    unique_ptr<StateObj> state = init_starting_state_from_raw_policy(*rawAgent, ply, gamePGN, variant, is960, rlSettings->rawPolicyProbabilityTemperature, startingFen);
+    string startingFen = get_starting_fen();
+    unique_ptr<StateObj> state;
+    {
+        lock_guard<mutex> lock(rawAgentMtx);
+        state = init_starting_state_from_raw_policy(*rawAgent, ply, game.gamePGN, variant, is960, rlSettings->rawPolicyProbabilityTemperature, startingFen);
+    }
     EvalInfo evalInfo;
     Result gameResult;
-    exporter->new_game();
+    game.samples.new_game();
 
     size_t generatedSamples = 0;
     const bool allowResignation = is_resignation_allowed();
+    GameAdjudication adjudication = init_adjudication();
+    bool isAdjudicated = false;
     do {
-        searchLimits->startTime = now();
-        const int randInt = rand();
+        game.searchLimits.startTime = now();
+        const int randInt = int(thread_random()() >> 33);
         const bool isQuickSearch = is_quick_search();
 
         if (isQuickSearch) {
-            searchLimits->nodes = rlSettings->quickSearchNodes;
-            mctsAgent->update_q_value_weight(rlSettings->quickSearchQValueWeight);
-            mctsAgent->update_dirichlet_epsilon(rlSettings->quickDirichletEpsilon);
+            set_quick_search_params(game);
         }
-        adjust_node_count(searchLimits, randInt);
-        mctsAgent->set_search_settings(state.get(), searchLimits, &evalInfo);
-        mctsAgent->perform_action();
+        adjust_node_count(&game.searchLimits, randInt);
+        game.mctsAgent->set_search_settings(state.get(), &game.searchLimits, &evalInfo);
+        game.mctsAgent->perform_action();
         if (rlSettings->reuseTreeForSelpay) {
-            mctsAgent->apply_move_to_tree(evalInfo.bestMove, true);
+            game.mctsAgent->apply_move_to_tree(evalInfo.bestMove, true);
         }
 
         if (!isQuickSearch && !exporter->is_file_full()) {
             if (rlSettings->lowPolicyClipThreshold > 0) {
                 sharpen_distribution(evalInfo.policyProbSmall, rlSettings->lowPolicyClipThreshold);
             }
-            exporter->save_sample(state.get(), evalInfo);
+            exporter->save_sample(game.samples, state.get(), evalInfo);
             ++generatedSamples;
         }
-        play_move_and_update(evalInfo, state.get(), gamePGN, gameResult);
-        reset_search_params(isQuickSearch);
-        check_for_resignation(allowResignation, evalInfo, state.get(), gameResult);
+        play_move_and_update(evalInfo, state.get(), game.gamePGN, gameResult);
+        reset_search_params(game, isQuickSearch);
+        if (gameResult == NO_RESULT) {
+            check_for_resignation(allowResignation, evalInfo, state.get(), gameResult);
+            check_for_adjudication(adjudication, evalInfo, state.get(), game.gamePGN.gameMoves.size(), gameResult);
+            isAdjudicated = gameResult != NO_RESULT;
+        }
     }
     while(gameResult == NO_RESULT);
 
     // export all training samples of the generated game
-    exporter->export_game_samples(gameResult);
+    exporter->export_game_samples(game.samples, gameResult);
+    metrics().add(METRIC_SELFPLAY_GAMES, 1);
+    if (isAdjudicated) {
+        metrics().add(METRIC_SELFPLAY_ADJUDICATED_GAMES, 1);
+    }
+    metrics().add(METRIC_SELFPLAY_SAMPLES, generatedSamples);
 
-    set_game_result_to_pgn(gameResult);
-    write_game_to_pgn(filenamePGNSelfplay, verbose);
-    clean_up(gamePGN, mctsAgent);
+    set_game_result_to_pgn(game.gamePGN, gameResult);
+    write_game_to_pgn(game.gamePGN, filenamePGNSelfplay, verbose);
+    clean_up(game.gamePGN, game.mctsAgent);
+    if (game.quickAgent != nullptr) {
+        game.quickAgent->clear_game_history();
+    }
 
     // measure time statistics
+    lock_guard<mutex> lock(outputMtx);
     if (verbose) {
         const float elapsedTimeMin = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - gameStartTime).count() / 60000.f;
         speed_statistic_report(elapsedTimeMin, generatedSamples);
@@ -246,8 +317,9 @@ void SelfPlay::generate_game(int variant, bool verbose)
     ++gameIdx;
 }
 
-Result SelfPlay::generate_arena_game(MCTSAgent* whitePlayer, MCTSAgent* blackPlayer, int variant, bool verbose, const string& fen)
+Result SelfPlay::generate_arena_game(ArenaGame& game, MCTSAgent* whitePlayer, MCTSAgent* blackPlayer, int variant, bool verbose, const string& fen)
 {
+    GamePGN& gamePGN = game.gamePGN;
     gamePGN.white = whitePlayer->get_name();
     gamePGN.black = blackPlayer->get_name();
     unique_ptr<StateObj> state = make_unique<StateObj>();
@@ -267,8 +339,9 @@ Result SelfPlay::generate_arena_game(MCTSAgent* whitePlayer, MCTSAgent* blackPla
     MCTSAgent* passivePlayer;
     // preserve the current active states
     Result gameResult;
+    GameAdjudication adjudication = init_adjudication();
     do {
-        searchLimits->startTime = now();
+        game.searchLimits.startTime = now();
         if (state->side_to_move() == WHITE) {
             activePlayer = whitePlayer;
             passivePlayer = blackPlayer;
@@ -277,17 +350,18 @@ Result SelfPlay::generate_arena_game(MCTSAgent* whitePlayer, MCTSAgent* blackPla
             activePlayer = blackPlayer;
             passivePlayer = whitePlayer;
         }
-        activePlayer->set_search_settings(state.get(), searchLimits, &evalInfo);
+        activePlayer->set_search_settings(state.get(), &game.searchLimits, &evalInfo);
         activePlayer->perform_action();
         activePlayer->apply_move_to_tree(evalInfo.bestMove, true);
         if (state->steps_from_null() != 0) {
             passivePlayer->apply_move_to_tree(evalInfo.bestMove, false);
         }
         play_move_and_update(evalInfo, state.get(), gamePGN, gameResult);
+        check_for_adjudication(adjudication, evalInfo, state.get(), gamePGN.gameMoves.size(), gameResult);
     }
     while(gameResult == NO_RESULT);
-    set_game_result_to_pgn(gameResult);
-    write_game_to_pgn(filenamePGNArena, verbose);
+    set_game_result_to_pgn(gamePGN, gameResult);
+    write_game_to_pgn(gamePGN, filenamePGNArena, verbose);
     clean_up(gamePGN, whitePlayer);
     blackPlayer->clear_game_history();
     return gameResult;
@@ -299,18 +373,18 @@ void clean_up(GamePGN& gamePGN, MCTSAgent* mctsAgent)
     mctsAgent->clear_game_history();
 }
 
-void SelfPlay::write_game_to_pgn(const std::string& pgnFileName, bool verbose)
+void SelfPlay::write_game_to_pgn(const GamePGN& gamePGN, const std::string& pgnFileName, bool verbose)
 {
-    ofstream pgnFile;
-    pgnFile.open(pgnFileName, std::ios_base::app);
+    stringstream pgnRecord;
+    pgnRecord << gamePGN << endl;
+    buffered_file_writer().append(pgnFileName, pgnRecord.str());
     if (verbose) {
+        lock_guard<mutex> lock(outputMtx);
         cout << endl << gamePGN << endl;
     }
-    pgnFile << gamePGN << endl;
-    pgnFile.close();
 }
 
-void SelfPlay::set_game_result_to_pgn(Result res)
+void SelfPlay::set_game_result_to_pgn(GamePGN& gamePGN, Result res)
 {
     gamePGN.result = result[res];
 }
@@ -334,6 +408,9 @@ void SelfPlay::speed_statistic_report(float elapsedTimeMin, size_t generatedSamp
          << setw(13) << gameIdx << '|'
          << setw(13) << gamesPerMin << '|'
          << setw(13) << samplesPerMin << endl << endl;
+    if (device_monitor().is_running()) {
+        cout << device_samples_report(device_monitor().get_latest_samples()) << endl;
+    }
 }
 
 void SelfPlay::export_number_generated_games() const
@@ -345,56 +422,138 @@ void SelfPlay::export_number_generated_games() const
 }
 
 
-void SelfPlay::go(size_t numberOfGames, int variant)
+void SelfPlay::generate_games(SelfPlayGame& game, size_t numberOfGames, int variant, std::atomic<size_t>& startedGames)
 {
-    reset_speed_statistics();
-    gamePGN.white = mctsAgent->get_name();
-    gamePGN.black = mctsAgent->get_name();
-
     if (numberOfGames == 0) {
         while(!exporter->is_file_full()) {
-            generate_game(variant, true);
+            generate_game(game, variant, true);
         }
     }
     else {
-        for (size_t idx = 0; idx < numberOfGames; ++idx) {
-            generate_game(variant, true);
+        while (startedGames++ < numberOfGames) {
+            generate_game(game, variant, true);
         }
     }
+}
+
+void SelfPlay::go(size_t numberOfGames, int variant, const vector<MCTSAgent*>& concurrentAgents, const vector<MCTSAgent*>& quickAgents)
+{
+    reset_speed_statistics();
+    vector<SelfPlayGame> games(concurrentAgents.size() + 1);
+    for (size_t idx = 0; idx < games.size(); ++idx) {
+        SelfPlayGame& game = games[idx];
+        game.mctsAgent = idx == 0 ? mctsAgent : concurrentAgents[idx-1];
+        game.fullAgent = game.mctsAgent;
+        game.quickAgent = idx < quickAgents.size() ? quickAgents[idx] : nullptr;
+        game.searchLimits = *searchLimits;
+        game.gamePGN = gamePGN;
+        game.gamePGN.white = game.mctsAgent->get_name();
+        game.gamePGN.black = game.mctsAgent->get_name();
+    }
+
+    std::atomic<size_t> startedGames(0);
+    if (games.size() == 1) {
+        generate_games(games[0], numberOfGames, variant, startedGames);
+    }
+    else {
+        // every game is advanced by its own thread, the searches are batched by the shared evaluator
+        vector<std::thread> gameThreads;
+        for (SelfPlayGame& game : games) {
+            gameThreads.emplace_back(&SelfPlay::generate_games, this, std::ref(game), numberOfGames, variant, std::ref(startedGames));
+        }
+        for (std::thread& gameThread : gameThreads) {
+            gameThread.join();
+        }
+    }
+    // the training data and the games must be complete before the selfplay command returns
+    exporter->flush();
+    buffered_file_writer().flush();
     export_number_generated_games();
 }
 
-TournamentResult SelfPlay::go_arena(MCTSAgent *mctsContender, size_t numberOfGames, int variant)
+void SelfPlay::update_arena_result(Result gameResult, bool isContenderWhite, TournamentResult& tournamentResult, std::atomic<bool>& isDecided)
 {
-    TournamentResult tournamentResult;
-    tournamentResult.playerA = mctsContender->get_name();
-    tournamentResult.playerB = mctsAgent->get_name();
-    Result gameResult;
+    lock_guard<mutex> lock(outputMtx);
+    if (gameResult == DRAWN) {
+        ++tournamentResult.numberDraws;
+    }
+    else if ((gameResult == WHITE_WIN) == isContenderWhite) {
+        ++tournamentResult.numberWins;
+    }
+    else {
+        ++tournamentResult.numberLosses;
+    }
+    cout << "Arena progress: " << tournamentResult;
+    if (rlSettings->arenaSPRT) {
+        cout << " LLR: " << std::setprecision(3) << sprt_llr(tournamentResult, rlSettings->sprtElo0, rlSettings->sprtElo1);
+        const SPRTDecision decision = sprt_decision(tournamentResult, rlSettings->sprtElo0, rlSettings->sprtElo1, rlSettings->sprtAlpha, rlSettings->sprtBeta);
+        if (decision != SPRT_CONTINUE && !isDecided) {
+            isDecided = true;
+            cout << endl << "SPRT decided: " << (decision == SPRT_H1 ? "H1" : "H0");
+        }
+    }
+    cout << endl;
+}
 
-    for (size_t idx = 0; idx < numberOfGames; ++idx) {
-        if (idx % 2 == 0) {
-            string startFen = load_random_fen(rlSettings->epdFilePath);
-            // use default or in case of chess960 a random starting position
-            gameResult = generate_arena_game(mctsContender, mctsAgent, variant, true, startFen);
-            if (gameResult == WHITE_WIN) {
-                ++tournamentResult.numberWins;
-            }
-            else if (gameResult == BLACK_WIN){
-                ++tournamentResult.numberLosses;
-            }
+void SelfPlay::generate_arena_games(ArenaGame& game, size_t numberOfGames, int variant, std::atomic<size_t>& startedGames,
+                                    TournamentResult& tournamentResult, std::atomic<bool>& isDecided)
+{
+    while (!isDecided) {
+        // both games of a pair are played by the same thread to use the same starting position with swapped colors
+        const size_t gameIdx = startedGames.fetch_add(2);
+        if (gameIdx >= numberOfGames) {
+            return;
         }
-        else {
-            // use same starting position as before stored via gamePGN.fen
-            gameResult = generate_arena_game(mctsAgent, mctsContender, variant, true, gamePGN.fen);
-            if (gameResult == BLACK_WIN) {
-                ++tournamentResult.numberWins;
-            }
-            else if (gameResult == WHITE_WIN){
-                ++tournamentResult.numberLosses;
-            }
+        // use default or in case of chess960 a random starting position
+        Result gameResult = generate_arena_game(game, game.contender, game.producer, variant, true, get_starting_fen());
+        update_arena_result(gameResult, true, tournamentResult, isDecided);
+        if (gameIdx + 1 >= numberOfGames || isDecided) {
+            return;
+        }
+        // use same starting position as before stored via gamePGN.fen
+        const string startFen = game.gamePGN.fen;
+        gameResult = generate_arena_game(game, game.producer, game.contender, variant, true, startFen);
+        update_arena_result(gameResult, false, tournamentResult, isDecided);
+    }
+}
+
+TournamentResult SelfPlay::go_arena(MCTSAgent *mctsContender, size_t numberOfGames, int variant,
+                                    const vector<pair<MCTSAgent*, MCTSAgent*>>& concurrentAgents)
+{
+    vector<pair<MCTSAgent*, MCTSAgent*>> agents = {{mctsAgent, mctsContender}};
+    agents.insert(agents.end(), concurrentAgents.begin(), concurrentAgents.end());
+    return play_arena(agents, numberOfGames, variant);
+}
+
+TournamentResult SelfPlay::play_arena(const vector<pair<MCTSAgent*, MCTSAgent*>>& agents, size_t numberOfGames, int variant)
+{
+    TournamentResult tournamentResult;
+    tournamentResult.playerA = agents[0].second->get_name();
+    tournamentResult.playerB = agents[0].first->get_name();
+
+    vector<ArenaGame> games(agents.size());
+    for (size_t idx = 0; idx < games.size(); ++idx) {
+        ArenaGame& game = games[idx];
+        game.producer = agents[idx].first;
+        game.contender = agents[idx].second;
+        game.searchLimits = *searchLimits;
+        game.gamePGN = gamePGN;
+    }
+
+    std::atomic<size_t> startedGames(0);
+    std::atomic<bool> isDecided(false);
+    if (games.size() == 1) {
+        generate_arena_games(games[0], numberOfGames, variant, startedGames, tournamentResult, isDecided);
+    }
+    else {
+        // every pair of agents plays in its own thread, the searches are batched by the shared evaluators
+        vector<std::thread> gameThreads;
+        for (ArenaGame& game : games) {
+            gameThreads.emplace_back(&SelfPlay::generate_arena_games, this, std::ref(game), numberOfGames, variant,
+                                     std::ref(startedGames), std::ref(tournamentResult), std::ref(isDecided));
         }
-        if (gameResult == DRAWN) {
-            ++tournamentResult.numberDraws;
+        for (std::thread& gameThread : gameThreads) {
+            gameThread.join();
         }
     }
     return tournamentResult;
@@ -446,16 +605,16 @@ unique_ptr<StateObj> init_starting_state_from_fixed_move(GamePGN &gamePGN, int v
 size_t clip_ply(size_t ply, size_t maxPly)
 {
     if (ply > maxPly) {
-        return size_t(rand()) % maxPly;
+        return thread_random().bounded(uint32_t(maxPly));
     }
     return ply;
 }
 
 void apply_raw_policy_temp(EvalInfo &eval, float rawPolicyProbTemp)
 {
-    if (float(rand()) / RAND_MAX < rawPolicyProbTemp) {
+    if (thread_random().uniform() < rawPolicyProbTemp) {
         float temp = 2.0f;
-        const float prob = float(rand()) / INT_MAX;
+        const float prob = thread_random().uniform();
         if (prob < 0.05f) {
             temp = 10.0f;
         }
@@ -32,8 +32,11 @@
 #include "../agents/rawnetagent.h"
 #include "gamepgn.h"
 #include "tournamentresult.h"
+#include "openingbook.h"
 #include "../agents/config/rlsettings.h"
 #include "../stateobj.h"
+#include <atomic>
+#include <mutex>
 #ifdef SF_DEPENDENCY
 #include "uci.h"
 using namespace UCI;
@@ -55,13 +58,43 @@ void play_move_and_update(const EvalInfo& evalInfo, StateObj* state, GamePGN& ga
 
 
 /**
- * @brief load_random_fen Returns a random fen string from a epd file defined by its file path.
- * If the filepath is "" or "<empty>" an empty string will be returned.
- * @param filepath Points to the location of the epd file.
- * @return fen string
+ * @brief The SelfPlayGame struct holds everything which belongs to a single game of concurrent self play.
+ * Each game is searched by its own MCTSAgent and buffers its samples until the game result is known.
+ * If quickAgent is set, the quick searches are done by it instead of fullAgent, mctsAgent points to the agent of the current search.
  */
-string load_random_fen(string filepath);
+struct SelfPlayGame
+{
+    MCTSAgent* mctsAgent = nullptr;
+    MCTSAgent* fullAgent = nullptr;
+    MCTSAgent* quickAgent = nullptr;
+    SearchLimits searchLimits;
+    GamePGN gamePGN;
+    TrainGameSamples samples;
+};
 
+/**
+ * @brief The ArenaGame struct holds everything which belongs to a pair of arena games which are played concurrently to other pairs.
+ * Both agents of a pair are used exclusively by the thread which plays the pair.
+ */
+struct ArenaGame
+{
+    MCTSAgent* producer = nullptr;
+    MCTSAgent* contender = nullptr;
+    SearchLimits searchLimits;
+    GamePGN gamePGN;
+};
+
+/**
+ * @brief The GameAdjudication struct holds the adjudication rules which have been enabled for the current game
+ * and the number of consecutive plies within the draw band
+ */
+struct GameAdjudication
+{
+    bool allowTablebase = false;
+    bool allowDraw = false;
+    bool allowMaxPlies = false;
+    size_t drawPlies = 0;
+};
 
 class SelfPlay
 {
@@ -75,6 +108,8 @@ private:
     OptionsMap& options;
     GamePGN gamePGN;
     TrainDataExporter* exporter;
+    // starting positions of the games, nullptr if no epd file is given
+    unique_ptr<OpeningBook> openingBook;
     string filenamePGNSelfplay;
     string filenamePGNArena;
     string fileNameGameIdx;
@@ -85,6 +120,10 @@ private:
     float backupDirichletEpsilon;
     float backupQValueWeight;
     bool is960;
+    // guards the shared raw agent which samples the opening moves
+    mutex rawAgentMtx;
+    // guards the pgn file, the speed statistics and stdout
+    mutex outputMtx;
 
 public:
     /**
@@ -105,29 +144,85 @@ public:
      * @brief go Starts the self play game generation for a given number of games
      * @param numberOfGames Number of games to generate
      * @param int variant to generate games for
+     * @param concurrentAgents Additional MCTSAgents which each generate games in their own thread next to mctsAgent.
+     * Every agent must use an own SearchSettings object. All agents should share the same batched evaluator (InferenceServer).
+     * @param quickAgents Agents for the quick searches of mctsAgent followed by the ones of concurrentAgents, typically with a smaller batch size.
+     * If empty, the quick searches are done by the same agents as the full searches.
      */
-    void go(size_t numberOfGames, int variant);
+    void go(size_t numberOfGames, int variant, const vector<MCTSAgent*>& concurrentAgents = {}, const vector<MCTSAgent*>& quickAgents = {});
 
     /**
      * @brief go_arena Starts comparision matches between the original mctsAgent with the old NN weights and
-     * the mctsContender which uses the new updated wieghts
+     * the mctsContender which uses the new updated wieghts.
+     * The current result is printed after every game. If the SPRT is enabled in the RLSettings,
+     * no new games are started as soon as the test is decided.
      * @param mctsContender MCTSAgent using different NN weights
-     * @param numberOfGames Number of games to compare
+     * @param numberOfGames Maximum number of games to compare
      * @param int variant to generate games for
+     * @param concurrentAgents Additional pairs of (producer, contender) agents which each play game pairs in their own thread
      * @return Score in respect to the contender, as floating point number.
      *  Wins give 1.0 points, 0.5 for draw, 0.0 for loss.
      */
-    TournamentResult go_arena(MCTSAgent *mctsContender, size_t numberOfGames, int variant);
+    TournamentResult go_arena(MCTSAgent *mctsContender, size_t numberOfGames, int variant,
+                              const vector<pair<MCTSAgent*, MCTSAgent*>>& concurrentAgents = {});
+
+    /**
+     * @brief play_arena Plays an arena match between arbitrary agents, every pair of agents plays in its own thread.
+     * Several matches can be played at the same time by calling this method from different threads.
+     * @param agents Pairs of (producer, contender) agents, all producers and all contenders must use the same networks
+     * @param numberOfGames Maximum number of games to play
+     * @param variant Current chess variant
+     * @return Result with respect to the contender
+     */
+    TournamentResult play_arena(const vector<pair<MCTSAgent*, MCTSAgent*>>& agents, size_t numberOfGames, int variant);
 
 private:
     /**
      * @brief generate_game Generates a new game in self play mode
+     * @param game Agent, search limits, pgn and sample buffer of the game
+     * @param variant Current chess variant
+     */
+    void generate_game(SelfPlayGame& game, int variant, bool verbose);
+
+    /**
+     * @brief generate_games Generates games until the given number of games has been started by all threads or until the export file is full
+     * @param game Agent, search limits, pgn and sample buffer which is reused for every game of this thread
+     * @param numberOfGames Number of games to generate in total. If 0, games are generated until the export file is full.
      * @param variant Current chess variant
+     * @param startedGames Number of games which have been started over all threads
      */
-    void generate_game(int variant, bool verbose);
+    void generate_games(SelfPlayGame& game, size_t numberOfGames, int variant, std::atomic<size_t>& startedGames);
+
+    /**
+     * @brief get_starting_fen Returns a random position of the epd file or an empty string if no epd file is given
+     * @return fen string
+     */
+    string get_starting_fen();
+
+    /**
+     * @brief generate_arena_games Plays pairs of games with swapped colors until numberOfGames have been started or the SPRT is decided
+     * @param game Agents, search limits and pgn of this thread
+     * @param numberOfGames Maximum number of games over all threads
+     * @param variant Current chess variant
+     * @param startedGames Number of games which have been started over all threads
+     * @param tournamentResult Result which is shared by all threads
+     * @param isDecided Is set to true if the SPRT has been decided
+     */
+    void generate_arena_games(ArenaGame& game, size_t numberOfGames, int variant, std::atomic<size_t>& startedGames,
+                              TournamentResult& tournamentResult, std::atomic<bool>& isDecided);
+
+    /**
+     * @brief update_arena_result Adds a finished game to the tournament result, prints the current result and checks the SPRT
+     * @param gameResult Result of the finished game
+     * @param isContenderWhite True if the contender played the white pieces
+     * @param tournamentResult Result which is shared by all threads
+     * @param isDecided Is set to true if the SPRT has been decided
+     */
+    void update_arena_result(Result gameResult, bool isContenderWhite, TournamentResult& tournamentResult, std::atomic<bool>& isDecided);
 
     /**
      * @brief generate_arena_game Generates a game of the current NN weights vs the new acquired weights
+     * @param game Search limits and pgn of the game
      * @param whitePlayer MCTSAgent which will play with the white pieces
      * @param blackPlayer MCTSAgent which will play with the black pieces
      * @param variant Current chess variant
@@ -135,20 +230,22 @@ private:
      * The fen will be stored in gamePGN.fen.
      * @param verbose If true the games will printed to stdout
      */
-    Result generate_arena_game(MCTSAgent *whitePlayer, MCTSAgent *blackPlayer, int variant, bool verbose, const string& fen);
+    Result generate_arena_game(ArenaGame& game, MCTSAgent *whitePlayer, MCTSAgent *blackPlayer, int variant, bool verbose, const string& fen);
 
     /**
      * @brief write_game_to_pgn Writes the game log to a pgn file
+     * @param gamePGN Game to export
      * @param pngFileName Filename to export
      * @param verbose If true, game will also be printed to stdout
      */
-    void write_game_to_pgn(const std::string& pngFileName, bool verbose);
+    void write_game_to_pgn(const GamePGN& gamePGN, const std::string& pngFileName, bool verbose);
 
     /**
      * @brief set_game_result Sets the game result to the gamePGN object
+     * @param gamePGN Game which has finished
      * @param res Game result
      */
-    void set_game_result_to_pgn(Result res);
+    void set_game_result_to_pgn(GamePGN& gamePGN, Result res);
 
     /**
      * @brief reset_speed_statistics Resets the interal measurements for gameIdx, gamesPerMin and samplesPerMin
@@ -194,10 +291,35 @@ private:
     void check_for_resignation(const bool allowResignation, const EvalInfo& evalInfo, const StateObj* position, Result& gameResult);
 
     /**
-     * @brief reset_search_params Resets all search parameters to their initial values
+     * @brief init_adjudication Enables each adjudication rule independently with its probability,
+     * so that the remaining games show the network how these positions are played out
+     * @return Adjudication of a new game
+     */
+    GameAdjudication init_adjudication() const;
+
+    /**
+     * @brief check_for_adjudication Modifies gameResult if the position is in the tablebases, the game stayed in the draw band for long enough
+     * or the maximum number of plies has been reached. Only the rules which are enabled in the adjudication are applied.
+     * @param adjudication Adjudication of the current game
+     * @param evalInfo Evaluation struct
+     * @param state Game state. It is expected that the evalBestMove has already been applied.
+     * @param numberPlies Number of plies of the game including the opening plies
+     * @param gameResult Game result which may be modified
+     */
+    void check_for_adjudication(GameAdjudication& adjudication, const EvalInfo& evalInfo, StateObj* state, size_t numberPlies, Result& gameResult) const;
+
+    /**
+     * @brief set_quick_search_params Switches the game to the quick agent, if any, and sets the parameters of a quick search
+     * @param game Game whose search limits and agent are set
+     */
+    void set_quick_search_params(SelfPlayGame& game);
+
+    /**
+     * @brief reset_search_params Resets all search parameters to their initial values and switches back to the agent of the full searches
+     * @param game Game whose search limits and agent are reset
      * @param Signals if a quick search was done
      */
-    void reset_search_params(bool isQuickSearch);
+    void reset_search_params(SelfPlayGame& game, bool isQuickSearch);
 };
 #endif
 
@@ -0,0 +1,148 @@
+"""
+@file: shardio.py
+Created on 14.10.2026
+@project: CrazyAra
+@author: queensgambit
+
+Reader for the append-only streaming shards which are written by the engine if the UCI option
+"Selfplay_Stream_Directory" is set (see shardwriter.h for a description of the format).
+Shards can be read while they are still written: only complete game records are returned together with the
+offset at which the next call should continue.
+"""
+
+import glob
+import os
+import numpy as np
+
+from DeepCrazyhouse.src.domain.util import unpack_planes, densify_policy
+
+SHARD_MAGIC = 0x48534143
+SHARD_RECORD_MAGIC = 0x52534143
+SHARD_FOOTER_MAGIC = 0x46534143
+SHARD_HEADER_SIZE = 32
+SHARD_RECORD_HEADER_SIZE = 16
+SHARD_FOOTER_SIZE = 16
+EXPORT_FORMAT_PACKED = 2
+
+
+def _padded_size(nb_bytes):
+    return (nb_bytes + 7) & ~7
+
+
+def read_header(data):
+    """
+    Parses the shard header (also sent at the start of a connection by the sample publisher)
+    :param data: Memory mapped shard or received bytes
+    :return: dict with the header fields
+    """
+    fields = np.frombuffer(data, dtype="<u4", count=8, offset=0)
+    if fields[0] != SHARD_MAGIC:
+        raise ValueError("The given file is not a shard.")
+    keys = ["magic", "version", "export_format", "nb_channels", "board_height", "board_width", "nb_labels",
+            "sparse_policy_size"]
+    return dict(zip(keys, [int(field) for field in fields]))
+
+
+def _get_columns(header):
+    """
+    Returns the name, dtype and number of values per sample for each column of a record
+    """
+    if header["export_format"] == EXPORT_FORMAT_PACKED:
+        columns = [("x_plane_masks", "<u8", header["nb_channels"]),
+                   ("x_plane_values", "<i2", header["nb_channels"]),
+                   ("y_policy_indices", "<u2", header["sparse_policy_size"]),
+                   ("y_policy_probs", "<f4", header["sparse_policy_size"])]
+    else:
+        columns = [("x", "<i2", header["nb_channels"] * header["board_height"] * header["board_width"]),
+                   ("y_policy", "<f4", header["nb_labels"])]
+    return columns + [("y_value", "<i2", 1), ("y_best_move_q", "<f4", 1), ("plys_to_end", "<i2", 1),
+                      ("phase_vector", "<i2", 1)]
+
+
+def is_shard_closed(file_path):
+    """
+    Returns True if the shard has been closed by the engine and won't be extended anymore
+    """
+    data = np.memmap(file_path, dtype=np.uint8, mode="r")
+    if len(data) < SHARD_HEADER_SIZE + SHARD_FOOTER_SIZE:
+        return False
+    return int(np.frombuffer(data, dtype="<u4", count=1, offset=len(data) - 4)[0]) == SHARD_FOOTER_MAGIC
+
+
+def parse_records(data, header, start_offset=0):
+    """
+    Parses all complete game records of a buffer which start at or after start_offset
+    :param data: Memory mapped shard or received bytes
+    :param header: Header of the shard or connection
+    :param start_offset: Offset of the first record
+    :return: list of dicts with one array per column, offset of the first incomplete record
+    """
+    columns = _get_columns(header)
+    games = []
+    offset = start_offset
+    while offset + SHARD_RECORD_HEADER_SIZE <= len(data):
+        magic, nb_samples = np.frombuffer(data, dtype="<u4", count=2, offset=offset)
+        nb_bytes = int(np.frombuffer(data, dtype="<u8", count=1, offset=offset + 8)[0])
+        if magic != SHARD_RECORD_MAGIC or offset + SHARD_RECORD_HEADER_SIZE + nb_bytes > len(data):
+            # index of a closed shard or a record which is still written
+            break
+        column_offset = offset + SHARD_RECORD_HEADER_SIZE
+        game = {}
+        for name, dtype, nb_values in columns:
+            count = int(nb_samples) * nb_values
+            game[name] = np.frombuffer(data, dtype=dtype, count=count, offset=column_offset).reshape(int(nb_samples), -1)
+            column_offset += _padded_size(count * np.dtype(dtype).itemsize)
+        games.append(game)
+        offset += SHARD_RECORD_HEADER_SIZE + nb_bytes
+    return games, offset
+
+
+def games_to_arrays(games, header):
+    """
+    Concatenates parsed game records
+    :param games: Games returned by parse_records()
+    :param header: Header of the shard or connection
+    :return: pgn_dataset_arrays_dict with the same keys as get_numpy_arrays()
+    """
+    columns = _get_columns(header)
+    arrays = {name: np.concatenate([game[name] for game in games]) for name, _, _ in columns}
+    if header["export_format"] == EXPORT_FORMAT_PACKED:
+        x = unpack_planes(arrays["x_plane_masks"], arrays["x_plane_values"], header["board_height"],
+                          header["board_width"])
+        y_policy = densify_policy(arrays["y_policy_indices"], arrays["y_policy_probs"], header["nb_labels"])
+    else:
+        x = arrays["x"].reshape(-1, header["nb_channels"], header["board_height"], header["board_width"])
+        y_policy = arrays["y_policy"]
+
+    game_lengths = [len(game["y_value"]) for game in games]
+    pgn_dataset_arrays_dict = {"start_indices": np.cumsum([0] + game_lengths[:-1]).astype(np.int32),
+                               "x": x,
+                               "y_value": arrays["y_value"].reshape(-1),
+                               "y_policy": y_policy,
+                               "plys_to_end": arrays["plys_to_end"].reshape(-1),
+                               "y_best_move_q": arrays["y_best_move_q"].reshape(-1),
+                               "phase_vector": arrays["phase_vector"].reshape(-1)}
+    return pgn_dataset_arrays_dict
+
+
+def read_shard(file_path, start_offset=SHARD_HEADER_SIZE):
+    """
+    Reads all complete game records of a shard which start at or after start_offset
+    :param file_path: Path of the shard
+    :param start_offset: Offset of the first record to read (use the returned offset of the previous call for polling)
+    :return: pgn_dataset_arrays_dict with the same keys as get_numpy_arrays() (or None if no new record is available),
+     offset of the next record
+    """
+    data = np.memmap(file_path, dtype=np.uint8, mode="r")
+    header = read_header(data)
+    games, offset = parse_records(data, header, start_offset)
+    if len(games) == 0:
+        return None, offset
+    return games_to_arrays(games, header), offset
+
+
+def get_shard_paths(stream_dir):
+    """
+    Returns all shards of the given stream directory sorted by their modification time
+    """
+    return sorted(glob.glob(os.path.join(stream_dir, "*.shard")), key=os.path.getmtime)
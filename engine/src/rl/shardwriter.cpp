@@ -0,0 +1,176 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: shardwriter.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#ifdef USE_RL
+#include "shardwriter.h"
+#include <ctime>
+#include <cstring>
+#include <stdexcept>
+#include "traindataexporter.h"
+#include "../nn/neuralnetapi.h"
+#include "../util/communication.h"
+
+// number of bytes of a column including its padding
+inline size_t padded_size(size_t numberBytes)
+{
+    return (numberBytes + 7) & ~size_t(7);
+}
+
+template <typename T>
+size_t column_size(const xt::xarray<T>& column, size_t numberSamples)
+{
+    return numberSamples == 0 ? 0 : padded_size(column.size() * sizeof(T));
+}
+
+// copies a column into the record and pads it with zeros
+template <typename T>
+char* write_column(char* target, const xt::xarray<T>& column)
+{
+    const size_t numberBytes = column.size() * sizeof(T);
+    memcpy(target, column.data(), numberBytes);
+    memset(target + numberBytes, 0, padded_size(numberBytes) - numberBytes);
+    return target + padded_size(numberBytes);
+}
+
+ShardHeader make_shard_header(int exportFormat, size_t sparsePolicySize)
+{
+    ShardHeader header;
+    header.magic = SHARD_MAGIC;
+    header.version = SHARD_VERSION;
+    header.exportFormat = uint32_t(exportFormat);
+    header.nbChannels = uint32_t(StateConstants::NB_CHANNELS_TOTAL());
+    header.boardHeight = uint32_t(StateConstants::BOARD_HEIGHT());
+    header.boardWidth = uint32_t(StateConstants::BOARD_WIDTH());
+    header.nbLabels = uint32_t(StateConstants::NB_LABELS());
+    header.sparsePolicySize = uint32_t(sparsePolicySize);
+    return header;
+}
+
+void serialize_game_record(const ShardHeader& header, const TrainGameSamples& game, vector<char>& record)
+{
+    const size_t numberSamples = game.gameValue.size();
+    ShardRecordHeader recordHeader;
+    recordHeader.magic = SHARD_RECORD_MAGIC;
+    recordHeader.numberSamples = uint32_t(numberSamples);
+    if (header.exportFormat == EXPORT_FORMAT_PACKED) {
+        recordHeader.numberBytes = column_size(game.gamePlaneMasks, numberSamples) + column_size(game.gamePlaneValues, numberSamples) +
+                column_size(game.gamePolicyIndices, numberSamples) + column_size(game.gamePolicyProbs, numberSamples);
+    }
+    else {
+        recordHeader.numberBytes = column_size(game.gameX, numberSamples) + column_size(game.gamePolicy, numberSamples);
+    }
+    recordHeader.numberBytes += column_size(game.gameValue, numberSamples) + column_size(game.gameBestMoveQ, numberSamples) +
+            column_size(game.gamePlysToEnd, numberSamples) + column_size(game.gamePhaseVector, numberSamples);
+
+    record.resize(sizeof(ShardRecordHeader) + recordHeader.numberBytes);
+    memcpy(record.data(), &recordHeader, sizeof(ShardRecordHeader));
+    if (numberSamples == 0) {
+        return;
+    }
+    char* target = record.data() + sizeof(ShardRecordHeader);
+    if (header.exportFormat == EXPORT_FORMAT_PACKED) {
+        target = write_column(target, game.gamePlaneMasks);
+        target = write_column(target, game.gamePlaneValues);
+        target = write_column(target, game.gamePolicyIndices);
+        target = write_column(target, game.gamePolicyProbs);
+    }
+    else {
+        target = write_column(target, game.gameX);
+        target = write_column(target, game.gamePolicy);
+    }
+    target = write_column(target, game.gameValue);
+    target = write_column(target, game.gameBestMoveQ);
+    target = write_column(target, game.gamePlysToEnd);
+    write_column(target, game.gamePhaseVector);
+}
+
+ShardWriter::ShardWriter(const string& directory, const string& filePrefix, uint64_t maxShardBytes, int exportFormat, size_t sparsePolicySize):
+    filePrefix(parse_directory(directory) + filePrefix + "_" + to_string(time(nullptr))),
+    maxShardBytes(maxShardBytes),
+    header(make_shard_header(exportFormat, sparsePolicySize)),
+    shardIdx(0),
+    offset(0)
+{
+}
+
+ShardWriter::~ShardWriter()
+{
+    close_shard();
+}
+
+void ShardWriter::open_shard()
+{
+    const string fileName = filePrefix + "_" + to_string(shardIdx++) + ".shard";
+    file.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("The shard " + fileName + " could not be created.");
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(ShardHeader));
+    offset = sizeof(ShardHeader);
+    index.clear();
+    info_string("created shard", fileName);
+}
+
+void ShardWriter::append_game(const TrainGameSamples& game)
+{
+    const size_t numberSamples = game.gameValue.size();
+    if (numberSamples == 0) {
+        return;
+    }
+    if (!file.is_open()) {
+        open_shard();
+    }
+    serialize_game_record(header, game, record);
+
+    // the record header states the size of the record, readers only use records which are completely available
+    file.write(record.data(), record.size());
+    file.flush();
+    if (!file.good()) {
+        throw runtime_error("Writing to the current shard failed.");
+    }
+
+    index.push_back({offset, numberSamples});
+    offset += record.size();
+    if (offset >= maxShardBytes) {
+        close_shard();
+    }
+}
+
+void ShardWriter::close_shard()
+{
+    if (!file.is_open()) {
+        return;
+    }
+    ShardFooter footer;
+    footer.indexOffset = offset;
+    footer.numberGames = uint32_t(index.size());
+    footer.magic = SHARD_FOOTER_MAGIC;
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(ShardIndexEntry));
+    file.write(reinterpret_cast<const char*>(&footer), sizeof(ShardFooter));
+    file.close();
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: shardwriter.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Append-only streaming format for the generated training data.
+ * A shard starts with a ShardHeader followed by one record for each game. Every record consists of a
+ * ShardRecordHeader and the sample columns of the game. When a shard exceeds its maximum size, it is closed with an index
+ * of all records and a ShardFooter and a new shard is started. Readers can memory map a shard while it is still written
+ * by scanning the complete records. Finished shards can be indexed by their footer directly.
+ *
+ * Column order of a record (each column padded to 8 bytes):
+ *  EXPORT_FORMAT_DENSE: x (int16), y_policy (float32), y_value (int16), y_best_move_q (float32), plys_to_end (int16), phase_vector (int16)
+ *  EXPORT_FORMAT_PACKED: x_plane_masks (uint64), x_plane_values (int16), y_policy_indices (uint16), y_policy_probs (float32),
+ *                        y_value (int16), y_best_move_q (float32), plys_to_end (int16), phase_vector (int16)
+ */
+
+#ifndef SHARDWRITER_H
+#define SHARDWRITER_H
+
+#ifdef USE_RL
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct TrainGameSamples;
+
+// magic numbers of the shard structures ("CASH", "CASR", "CASF" in little endian)
+#define SHARD_MAGIC 0x48534143
+#define SHARD_RECORD_MAGIC 0x52534143
+#define SHARD_FOOTER_MAGIC 0x46534143
+#define SHARD_VERSION 1
+
+/**
+ * @brief The ShardHeader struct describes the sample layout of all records of a shard
+ */
+struct ShardHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t exportFormat;
+    uint32_t nbChannels;
+    uint32_t boardHeight;
+    uint32_t boardWidth;
+    uint32_t nbLabels;
+    uint32_t sparsePolicySize;
+};
+
+/**
+ * @brief The ShardRecordHeader struct precedes the columns of a single game
+ */
+struct ShardRecordHeader
+{
+    uint32_t magic;
+    uint32_t numberSamples;
+    // number of bytes of the columns following the header
+    uint64_t numberBytes;
+};
+
+/**
+ * @brief The ShardIndexEntry struct describes the position of a record in a closed shard
+ */
+struct ShardIndexEntry
+{
+    uint64_t offset;
+    uint64_t numberSamples;
+};
+
+/**
+ * @brief The ShardFooter struct is the last structure of a closed shard and points to the record index
+ */
+struct ShardFooter
+{
+    uint64_t indexOffset;
+    uint32_t numberGames;
+    uint32_t magic;
+};
+
+static_assert(sizeof(ShardHeader) == 32 && sizeof(ShardRecordHeader) == 16 && sizeof(ShardIndexEntry) == 16 && sizeof(ShardFooter) == 16,
+              "The shard structures must not contain padding");
+
+/**
+ * @brief make_shard_header Returns the header for the sample layout of the current game environment
+ * @param exportFormat EXPORT_FORMAT_DENSE or EXPORT_FORMAT_PACKED
+ * @param sparsePolicySize Number of policy pairs of each sample in the packed format
+ * @return Shard header
+ */
+ShardHeader make_shard_header(int exportFormat, size_t sparsePolicySize);
+
+/**
+ * @brief serialize_game_record Serializes a finished game into a record (ShardRecordHeader followed by the columns)
+ * @param header Header which describes the sample layout
+ * @param game Samples of the game, the game result must already be applied
+ * @param record Output buffer which is resized to the size of the record
+ */
+void serialize_game_record(const ShardHeader& header, const TrainGameSamples& game, std::vector<char>& record);
+
+class ShardWriter
+{
+private:
+    std::string filePrefix;
+    uint64_t maxShardBytes;
+    ShardHeader header;
+    std::ofstream file;
+    size_t shardIdx;
+    uint64_t offset;
+    std::vector<ShardIndexEntry> index;
+    std::vector<char> record;
+
+    /**
+     * @brief open_shard Creates the next shard file and writes its header
+     */
+    void open_shard();
+
+public:
+    /**
+     * @brief ShardWriter
+     * @param directory Directory in which the shards are created
+     * @param filePrefix Prefix of the shard file names (e.g. "data_gpu_0"). The start time and the shard index are appended.
+     * @param maxShardBytes A shard is closed after the first record which exceeds this size
+     * @param exportFormat EXPORT_FORMAT_DENSE or EXPORT_FORMAT_PACKED
+     * @param sparsePolicySize Number of policy pairs of each sample in the packed format
+     */
+    ShardWriter(const std::string& directory, const std::string& filePrefix, uint64_t maxShardBytes, int exportFormat, size_t sparsePolicySize);
+    ~ShardWriter();
+    ShardWriter(const ShardWriter&) = delete;
+    ShardWriter& operator=(const ShardWriter&) = delete;
+
+    /**
+     * @brief append_game Appends the samples of a finished game as a new record and flushes it to disk
+     * @param game Samples of the game, the game result must already be applied
+     */
+    void append_game(const TrainGameSamples& game);
+
+    /**
+     * @brief close_shard Writes the index and the footer of the current shard and closes the file
+     */
+    void close_shard();
+};
+#endif
+
+#endif // SHARDWRITER_H
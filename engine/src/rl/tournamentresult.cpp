@@ -25,6 +25,9 @@
 
 #include "tournamentresult.h"
 #include <iomanip>
+#include <cmath>
+#include <sstream>
+#include "util/bufferedfilewriter.h"
 
 TournamentResult::TournamentResult() :
     numberWins(0),
@@ -54,10 +57,36 @@ std::ostream &operator<<(std::ostream &os, const TournamentResult &result)
 
 void write_tournament_result_to_csv(const TournamentResult &result, const string &csvFileName)
 {
-    ofstream csvFile;
+    stringstream csvLine;
     const char delim = ',';
-    csvFile.open(csvFileName, std::ios_base::app);
-    csvFile << result.playerA << delim << result.playerB << delim
-         << result.numberWins << delim << result.numberDraws << delim << result.numberLosses << endl;
-    csvFile.close();
+    csvLine << result.playerA << delim << result.playerB << delim
+            << result.numberWins << delim << result.numberDraws << delim << result.numberLosses << endl;
+    buffered_file_writer().append(csvFileName, csvLine.str());
+}
+
+double sprt_llr(const TournamentResult& result, double elo0, double elo1)
+{
+    const double numberGames = result.numberGames();
+    if (result.numberWins == 0 || result.numberLosses == 0) {
+        // the variance can't be estimated reliably without wins and losses
+        return 0;
+    }
+    const double score = (result.numberWins + 0.5 * result.numberDraws) / numberGames;
+    const double variance = (result.numberWins * pow(1.0 - score, 2) + result.numberDraws * pow(0.5 - score, 2) +
+                             result.numberLosses * pow(score, 2)) / numberGames;
+    const double score0 = 1.0 / (1.0 + pow(10.0, -elo0 / 400.0));
+    const double score1 = 1.0 / (1.0 + pow(10.0, -elo1 / 400.0));
+    return numberGames * (score1 - score0) * (2 * score - score0 - score1) / (2 * variance);
+}
+
+SPRTDecision sprt_decision(const TournamentResult& result, double elo0, double elo1, double alpha, double beta)
+{
+    const double llr = sprt_llr(result, elo0, elo1);
+    if (llr >= log((1 - beta) / alpha)) {
+        return SPRT_H1;
+    }
+    if (llr <= log(beta / (1 - alpha))) {
+        return SPRT_H0;
+    }
+    return SPRT_CONTINUE;
 }
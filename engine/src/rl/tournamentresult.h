@@ -61,6 +61,35 @@ struct TournamentResult {
      float score() const;
 };
 
+enum SPRTDecision {
+    SPRT_CONTINUE,
+    // the first player isn't stronger than elo0 (null hypothesis accepted)
+    SPRT_H0,
+    // the first player is at least elo1 stronger (alternative hypothesis accepted)
+    SPRT_H1
+};
+
+/**
+ * @brief sprt_llr Computes the log-likelihood ratio of the sequential probability ratio test using a normal approximation
+ * of the trinomial game outcomes (as used by fishtest).
+ * @param result Current tournament result with respect to the first player
+ * @param elo0 Elo difference of the null hypothesis
+ * @param elo1 Elo difference of the alternative hypothesis
+ * @return Log-likelihood ratio (0 if there are no decisive games yet)
+ */
+double sprt_llr(const TournamentResult& result, double elo0, double elo1);
+
+/**
+ * @brief sprt_decision Decides the sequential probability ratio test
+ * @param result Current tournament result with respect to the first player
+ * @param elo0 Elo difference of the null hypothesis
+ * @param elo1 Elo difference of the alternative hypothesis
+ * @param alpha False positive rate
+ * @param beta False negative rate
+ * @return SPRT_CONTINUE if more games are needed, otherwise the accepted hypothesis
+ */
+SPRTDecision sprt_decision(const TournamentResult& result, double elo0, double elo1, double alpha, double beta);
+
 /**
  * @brief operator << Returns ostream for trounament result summary in the form
  *  "<PLAYER_A>-<PLAYER_B>: <NUMBER_WINS> - <NUMBER_DRAWS> - <NUMBER_LOSSES> [<SCORE>]"
@@ -72,6 +101,7 @@ extern std::ostream& operator<<(std::ostream& os, const TournamentResult& result
 
 /**
  * @brief write_tournament_result_to_csv Appends the result of the tournamet to a given csvFile.
+ * The line is buffered by buffered_file_writer() and written in the background.
  * <playerA>,<playerB>,<numberWinsA>,<numberDrawsA>,<numberLossesA>,
  * @param csvFileName Filename of the csv
  */
@@ -25,130 +25,313 @@
 
 #ifdef USE_RL
 #include "traindataexporter.h"
+#include "shardwriter.h"
+#include "samplepublisher.h"
 #include <inttypes.h>
 #include "../util/communication.h"
 #include "stateobj.h"
+#include "xtensor/xview.hpp"
+#include "../nn/planepacking.h"
+#include <algorithm>
+#include <numeric>
+#include <filesystem>
+
+/**
+ * @brief truncate_samples Keeps only the first numberSamples entries along the sample axis
+ * @param samples Sample array of a single game
+ * @param numberSamples Number of samples to keep
+ */
+template <typename T>
+void truncate_samples(xt::xarray<T>& samples, size_t numberSamples)
+{
+    xt::xarray<T> truncated = xt::view(samples, xt::range(0, numberSamples));
+    samples = std::move(truncated);
+}
 
-void TrainDataExporter::save_sample(const StateObj* pos, const EvalInfo& eval)
+/**
+ * @brief append_sample Appends a single sample to the array of the current game
+ * @param gameArray Array of the current game
+ * @param sample Sample with a first dimension of size 1
+ * @param firstMove True if the sample is the first sample of the game
+ */
+template <typename T>
+void append_sample(xt::xarray<T>& gameArray, const xt::xarray<T>& sample, bool firstMove)
 {
-    if (startIdx+curSampleIdx >= numberSamples) {
+    if (firstMove) {
+        gameArray = sample;
+    }
+    else {
+        gameArray = xt::concatenate(xtuple(gameArray, sample));
+    }
+}
+
+TrainGameSamples::TrainGameSamples():
+    firstMove(true),
+    curSampleIdx(0)
+{
+}
+
+void TrainGameSamples::new_game()
+{
+    firstMove = true;
+    curSampleIdx = 0;
+}
+
+void TrainDataExporter::save_sample(TrainGameSamples& game, const StateObj* pos, const EvalInfo& eval)
+{
+    if (!isStreaming && startIdx+game.curSampleIdx >= numberSamples) {
         info_string("Extended number of maximum samples");
         return;
     }
-    save_planes(pos);
-    save_policy(eval.legalMoves, eval.policyProbSmall, pos->mirror_policy(pos->side_to_move()));
-    save_best_move_q(eval);
-    save_side_to_move(Color(pos->side_to_move()));
-    save_cur_sample_index();
-    save_cur_phase(pos);
-    ++curSampleIdx;
+    save_planes(game, pos);
+    save_policy(game, eval.legalMoves, eval.policyProbSmall, pos->mirror_policy(pos->side_to_move()));
+    save_best_move_q(game, eval);
+    save_side_to_move(game, Color(pos->side_to_move()));
+    save_cur_sample_index(game);
+    save_cur_phase(game, pos);
+    ++game.curSampleIdx;
     // value will be set later in export_game_result()
-    firstMove = false;
+    game.firstMove = false;
 }
 
-void TrainDataExporter::save_best_move_q(const EvalInfo &eval)
+void TrainDataExporter::save_best_move_q(TrainGameSamples& game, const EvalInfo &eval)
 {
     // Q value of "best" move (a.k.a selected move after mcts search)
     xt::xarray<float> qArray({ 1 }, eval.bestMoveQ[0]);
 
-    if (firstMove) {
-        gameBestMoveQ = qArray;
+    if (game.firstMove) {
+        game.gameBestMoveQ = qArray;
     }
     else {
         // concatenate the sample to array for the current game
-        gameBestMoveQ = xt::concatenate(xtuple(gameBestMoveQ, qArray));
+        game.gameBestMoveQ = xt::concatenate(xtuple(game.gameBestMoveQ, qArray));
     }
 }
 
-void TrainDataExporter::save_side_to_move(Color col)
+void TrainDataExporter::save_side_to_move(TrainGameSamples& game, Color col)
 {
     // in the case of WHITE a +1 is saved else -1 for BLACK
     xt::xarray<int16_t> valueArray({ 1 }, -(col * 2 - 1));
 
-    if (firstMove) {
-        gameValue = valueArray;
+    if (game.firstMove) {
+        game.gameValue = valueArray;
     }
     else {
         // concatenate the sample to array for the current game
-        gameValue = xt::concatenate(xtuple(gameValue, valueArray));
+        game.gameValue = xt::concatenate(xtuple(game.gameValue, valueArray));
     }
 }
 
-void TrainDataExporter::save_cur_sample_index()
+void TrainDataExporter::save_cur_sample_index(TrainGameSamples& game)
 {
-    // curSampleIdx aka ply/half-move, starting from 0
-    xt::xarray<int16_t> idxArray({ 1 }, curSampleIdx);
+    // game.curSampleIdx aka ply/half-move, starting from 0
+    xt::xarray<int16_t> idxArray({ 1 }, game.curSampleIdx);
 
-    if (firstMove) {
-        gamePlysToEnd = idxArray;
+    if (game.firstMove) {
+        game.gamePlysToEnd = idxArray;
     }
     else {
         // concatenate the sample to array for the current game
-        gamePlysToEnd = xt::concatenate(xtuple(gamePlysToEnd, idxArray));
+        game.gamePlysToEnd = xt::concatenate(xtuple(game.gamePlysToEnd, idxArray));
     }
 }
 
-void TrainDataExporter::save_cur_phase(const StateObj* pos)
+void TrainDataExporter::save_cur_phase(TrainGameSamples& game, const StateObj* pos)
 {
     // curGamePhase, starting from 0
     xt::xarray<int16_t> phaseArray({ 1 }, pos->get_phase(numPhases, gamePhaseDefinition));
 
-    if (firstMove) {
-        gamePhaseVector = phaseArray;
+    if (game.firstMove) {
+        game.gamePhaseVector = phaseArray;
     }
     else {
         // concatenate the sample to array for the current game
-        gamePhaseVector = xt::concatenate(xtuple(gamePhaseVector, phaseArray));
+        game.gamePhaseVector = xt::concatenate(xtuple(game.gamePhaseVector, phaseArray));
     }
 }
 
-void TrainDataExporter::export_game_samples(Result result) {
-    if (startIdx >= numberSamples) {
+void TrainDataExporter::export_game_samples(TrainGameSamples& game, Result result) {
+    // game value update
+    apply_result_to_value(game, result);
+    apply_result_to_plys_to_end(game);
+
+    unique_lock<mutex> lock(mtx);
+    jobFinished.wait(lock, [this]{ return exportQueue.size() < maxQueueSize; });
+    if (!isStreaming && startIdx >= numberSamples) {
         info_string("Extended number of maximum samples");
         return;
     }
+    // concurrently generated games may have buffered more samples than the file has left
+    const size_t numberGameSamples = isStreaming ? game.curSampleIdx : std::min(game.curSampleIdx, numberSamples - startIdx);
+    if (numberGameSamples < game.curSampleIdx) {
+        truncate_game(game, numberGameSamples);
+    }
 
-    // game value update
-    apply_result_to_value(result);
-    apply_result_to_plys_to_end();
+    // the buffers are handed over to the writer thread, so that the caller can continue with the next game immediately
+    exportQueue.emplace_back();
+    ExportJob& job = exportQueue.back();
+    job.samples = std::move(game);
+    job.startIdx = startIdx;
+    startIdx += numberGameSamples;
+    job.nextGameIdx = ++gameIdx;
+    job.nextStartIdx = startIdx;
+    game = TrainGameSamples();
+    lock.unlock();
+    jobAvailable.notify_one();
+}
+
+void TrainDataExporter::truncate_game(TrainGameSamples& game, size_t numberSamples) const
+{
+    if (exportFormat == EXPORT_FORMAT_PACKED) {
+        truncate_samples(game.gamePlaneMasks, numberSamples);
+        truncate_samples(game.gamePlaneValues, numberSamples);
+        truncate_samples(game.gamePolicyIndices, numberSamples);
+        truncate_samples(game.gamePolicyProbs, numberSamples);
+    }
+    else {
+        truncate_samples(game.gameX, numberSamples);
+        truncate_samples(game.gamePolicy, numberSamples);
+    }
+    truncate_samples(game.gameValue, numberSamples);
+    truncate_samples(game.gameBestMoveQ, numberSamples);
+    truncate_samples(game.gamePlysToEnd, numberSamples);
+    truncate_samples(game.gamePhaseVector, numberSamples);
+}
 
+void TrainDataExporter::write_game_samples(const ExportJob& job)
+{
+    const TrainGameSamples& game = job.samples;
+    if (isStreaming) {
+#ifndef _WIN32
+        if (publisher != nullptr) {
+            publisher->publish_game(game);
+        }
+#endif
+        if (shardWriter != nullptr) {
+            shardWriter->append_game(game);
+        }
+        return;
+    }
     // write value to roi
-    z5::types::ShapeType offset = { startIdx };
-    z5::types::ShapeType offsetPlanes = { startIdx, 0, 0, 0 };
-    z5::multiarray::writeSubarray<int16_t>(dx, gameX, offsetPlanes.begin());
-    z5::multiarray::writeSubarray<int16_t>(dValue, gameValue, offset.begin());
-    z5::multiarray::writeSubarray<float>(dbestMoveQ, gameBestMoveQ, offset.begin());
-    z5::types::ShapeType offsetPolicy = { startIdx, 0 };
-    z5::multiarray::writeSubarray<float>(dPolicy, gamePolicy, offsetPolicy.begin());
-    z5::multiarray::writeSubarray<int16_t>(dPlysToEnd, gamePlysToEnd, offset.begin());
-    z5::multiarray::writeSubarray<int16_t>(dPhaseVector, gamePhaseVector, offset.begin());
-
-    startIdx += curSampleIdx;
-    gameIdx++;
-    save_start_idx();
+    z5::types::ShapeType offset = { job.startIdx };
+    z5::types::ShapeType offsetMatrix = { job.startIdx, 0 };
+    if (exportFormat == EXPORT_FORMAT_PACKED) {
+        z5::multiarray::writeSubarray<PlaneMaskType>(dPlaneMasks, game.gamePlaneMasks, offsetMatrix.begin());
+        z5::multiarray::writeSubarray<PlaneValueType>(dPlaneValues, game.gamePlaneValues, offsetMatrix.begin());
+        z5::multiarray::writeSubarray<PolicyIndexType>(dPolicyIndices, game.gamePolicyIndices, offsetMatrix.begin());
+        z5::multiarray::writeSubarray<PolicyProbType>(dPolicyProbs, game.gamePolicyProbs, offsetMatrix.begin());
+    }
+    else {
+        z5::types::ShapeType offsetPlanes = { job.startIdx, 0, 0, 0 };
+        z5::multiarray::writeSubarray<PlaneValueType>(dx, game.gameX, offsetPlanes.begin());
+        z5::multiarray::writeSubarray<PolicyProbType>(dPolicy, game.gamePolicy, offsetMatrix.begin());
+    }
+    z5::multiarray::writeSubarray<ValueTargetType>(dValue, game.gameValue, offset.begin());
+    z5::multiarray::writeSubarray<BestMoveQType>(dbestMoveQ, game.gameBestMoveQ, offset.begin());
+    z5::multiarray::writeSubarray<PlysToEndType>(dPlysToEnd, game.gamePlysToEnd, offset.begin());
+    z5::multiarray::writeSubarray<PhaseType>(dPhaseVector, game.gamePhaseVector, offset.begin());
+    save_start_idx(job.nextGameIdx, job.nextStartIdx);
+}
+
+void TrainDataExporter::run_writer()
+{
+    unique_lock<mutex> lock(mtx);
+    while (true) {
+        jobAvailable.wait(lock, [this]{ return !exportQueue.empty() || !isRunning; });
+        if (exportQueue.empty()) {
+            // the exporter is destroyed and all games have been written
+            return;
+        }
+        ExportJob job = std::move(exportQueue.front());
+        exportQueue.pop_front();
+        isWriting = true;
+        lock.unlock();
+        jobFinished.notify_all();
+        try {
+            write_game_samples(job);
+        }
+        catch (const exception& e) {
+            info_string_important("Writing the training samples failed:", e.what());
+        }
+        lock.lock();
+        isWriting = false;
+        jobFinished.notify_all();
+    }
+}
+
+void TrainDataExporter::flush()
+{
+    unique_lock<mutex> lock(mtx);
+    jobFinished.wait(lock, [this]{ return exportQueue.empty() && !isWriting; });
 }
 
-TrainDataExporter::TrainDataExporter(const string& fileName, unsigned int numPhases, GamePhaseDefinition gamePhaseDefinition, size_t numberChunks, size_t chunkSize):
+TrainDataExporter::TrainDataExporter(const string& fileName, unsigned int numPhases, GamePhaseDefinition gamePhaseDefinition, size_t numberChunks, size_t chunkSize,
+                                     const string& compressionCodec, int compressionLevel, size_t maxQueueSize,
+                                     int exportFormat, size_t sparsePolicySize, const string& streamDirectory, size_t shardSizeBytes,
+                                     const string& publishAddress):
     numPhases(numPhases),
     gamePhaseDefinition(gamePhaseDefinition),
     numberChunks(numberChunks),
     chunkSize(chunkSize),
     numberSamples(numberChunks * chunkSize),
-    firstMove(true),
+    exportFormat(exportFormat),
+    sparsePolicySize(sparsePolicySize),
     gameIdx(0),
     startIdx(0),
-    curSampleIdx(0)
+    maxQueueSize(std::max(size_t(1), maxQueueSize)),
+    isStreaming(streamDirectory != "" || publishAddress != ""),
+    isWriting(false),
+    isRunning(true)
 {
+    if (exportFormat == EXPORT_FORMAT_PACKED) {
+        if (StateConstants::BOARD_HEIGHT() * StateConstants::BOARD_WIDTH() != PACKED_PLANE_SIZE) {
+            throw invalid_argument("The packed export format requires a board with " + to_string(PACKED_PLANE_SIZE) + " squares.");
+        }
+        if (StateConstants::NB_LABELS() >= UINT16_MAX) {
+            throw invalid_argument("The packed export format requires less than " + to_string(UINT16_MAX) + " policy labels.");
+        }
+    }
+    if (isStreaming) {
+        if (publishAddress != "") {
+#ifndef _WIN32
+            publisher = make_unique<SamplePublisher>(publishAddress, exportFormat, sparsePolicySize);
+#else
+            throw invalid_argument("Publishing the selfplay games is not supported on Windows.");
+#endif
+        }
+        if (streamDirectory != "") {
+            std::filesystem::create_directories(streamDirectory);
+            const string filePrefix = std::filesystem::path(fileName).stem().string();
+            shardWriter = make_unique<ShardWriter>(streamDirectory, filePrefix, shardSizeBytes, exportFormat, sparsePolicySize);
+        }
+        writerThread = thread(&TrainDataExporter::run_writer, this);
+        return;
+    }
     // get handle to a File on the filesystem
     z5::filesystem::handle::File file(fileName);
 
+    if (file.exists() && read_export_format(file) != exportFormat) {
+        info_string_important("Warning: Export file uses a different export format. It will be replaced");
+        std::filesystem::remove_all(fileName);
+    }
     if (file.exists()) {
         info_string_important("Warning: Export file already exists. It will be overwritten");
         open_dataset_from_file(file);
     }
     else {
-        create_new_dataset_file(file);
+        create_new_dataset_file(file, compressionCodec, compressionLevel);
     }
+    writerThread = thread(&TrainDataExporter::run_writer, this);
+}
+
+TrainDataExporter::~TrainDataExporter()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        isRunning = false;
+    }
+    jobAvailable.notify_all();
+    writerThread.join();
 }
 
 size_t TrainDataExporter::get_number_samples() const
@@ -158,20 +341,18 @@ size_t TrainDataExporter::get_number_samples() const
 
 bool TrainDataExporter::is_file_full()
 {
-    return startIdx >= numberSamples;
+    return !isStreaming && startIdx >= numberSamples;
 }
 
-void TrainDataExporter::new_game()
-{
-    firstMove = true;
-    curSampleIdx = 0;
-}
-
-void TrainDataExporter::save_planes(const StateObj *pos)
+void TrainDataExporter::save_planes(TrainGameSamples& game, const StateObj *pos)
 {
     // x / plane representation
     float inputPlanes[StateConstants::NB_VALUES_TOTAL()];
     pos->get_state_planes(false, inputPlanes, StateConstants::CURRENT_VERSION());
+    if (exportFormat == EXPORT_FORMAT_PACKED) {
+        save_packed_planes(game, inputPlanes);
+        return;
+    }
     // write array to roi
     xt::xarray<int16_t>::shape_type planesShape = { 1, StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH()};
     xt::xarray<int16_t> planes(planesShape);
@@ -179,97 +360,192 @@ void TrainDataExporter::save_planes(const StateObj *pos)
         planes.data()[idx] = int16_t(inputPlanes[idx]);
     }
 
-    if (firstMove) {
-        gameX = planes;
+    if (game.firstMove) {
+        game.gameX = planes;
     }
     else {
         // concatenate the sample to array for the current game
-        gameX = xt::concatenate(xtuple(gameX, planes));
+        game.gameX = xt::concatenate(xtuple(game.gameX, planes));
     }
 }
 
-void TrainDataExporter::save_policy(const vector<Action>& legalMoves, const DynamicVector<float>& policyProbSmall, bool mirrorPolicy)
+void TrainDataExporter::save_packed_planes(TrainGameSamples& game, const float* inputPlanes)
 {
-    assert(legalMoves.size() == policyProbSmall.size());
+    const size_t nbChannels = StateConstants::NB_CHANNELS_TOTAL();
+    xt::xarray<uint64_t> masks({ 1, nbChannels });
+    vector<float> values(nbChannels);
+    if (!pack_planes(inputPlanes, nbChannels, masks.data(), values.data())) {
+        throw runtime_error("The input representation contains planes with several distinct values and can't be exported in the packed format.");
+    }
+    xt::xarray<int16_t> planeValues({ 1, nbChannels });
+    for (size_t idx = 0; idx < nbChannels; ++idx) {
+        planeValues.data()[idx] = int16_t(values[idx]);
+    }
+    append_sample(game.gamePlaneMasks, masks, game.firstMove);
+    append_sample(game.gamePlaneValues, planeValues, game.firstMove);
+}
 
-    xt::xarray<float>::shape_type shapePolicy = { 1, StateConstants::NB_LABELS() };
-    xt::xarray<float> policy(shapePolicy, 0);
+void TrainDataExporter::save_sparse_policy(TrainGameSamples& game, const vector<size_t>& policyIndices, const DynamicVector<float>& policyProbSmall)
+{
+    vector<size_t> moveIndices;
+    for (size_t idx = 0; idx < policyIndices.size(); ++idx) {
+        if (policyProbSmall[idx] != 0) {
+            moveIndices.emplace_back(idx);
+        }
+    }
+    float probSum = 1.0f;
+    if (moveIndices.size() > sparsePolicySize) {
+        // keep the most likely moves
+        std::partial_sort(moveIndices.begin(), moveIndices.begin() + sparsePolicySize, moveIndices.end(),
+                          [&](size_t lhs, size_t rhs) { return policyProbSmall[lhs] > policyProbSmall[rhs]; });
+        moveIndices.resize(sparsePolicySize);
+        probSum = std::accumulate(moveIndices.begin(), moveIndices.end(), 0.0f, [&](float sum, size_t idx) { return sum + policyProbSmall[idx]; });
+    }
+
+    xt::xarray<uint16_t> indices({ 1, sparsePolicySize }, uint16_t(StateConstants::NB_LABELS()));
+    xt::xarray<float> probs({ 1, sparsePolicySize }, 0.0f);
+    for (size_t idx = 0; idx < moveIndices.size(); ++idx) {
+        indices.data()[idx] = uint16_t(policyIndices[moveIndices[idx]]);
+        probs.data()[idx] = policyProbSmall[moveIndices[idx]] / probSum;
+    }
+    append_sample(game.gamePolicyIndices, indices, game.firstMove);
+    append_sample(game.gamePolicyProbs, probs, game.firstMove);
+}
 
+void TrainDataExporter::save_policy(TrainGameSamples& game, const vector<Action>& legalMoves, const DynamicVector<float>& policyProbSmall, bool mirrorPolicy)
+{
+    assert(legalMoves.size() == policyProbSmall.size());
+
+    vector<size_t> policyIndices(legalMoves.size());
     for (size_t idx = 0; idx < legalMoves.size(); ++idx) {
-        size_t policyIdx;
         if (mirrorPolicy) {
-            policyIdx = StateConstants::action_to_index<classic, mirrored>(legalMoves[idx]);
+            policyIndices[idx] = StateConstants::action_to_index<classic, mirrored>(legalMoves[idx]);
         }
         else {
-            policyIdx = StateConstants::action_to_index<classic, notMirrored>(legalMoves[idx]);
+            policyIndices[idx] = StateConstants::action_to_index<classic, notMirrored>(legalMoves[idx]);
         }
-        policy[policyIdx] = policyProbSmall[idx];
+    }
+    if (exportFormat == EXPORT_FORMAT_PACKED) {
+        save_sparse_policy(game, policyIndices, policyProbSmall);
+        return;
     }
 
-    if (firstMove) {
-        gamePolicy = policy;
+    xt::xarray<float>::shape_type shapePolicy = { 1, StateConstants::NB_LABELS() };
+    xt::xarray<float> policy(shapePolicy, 0);
+    for (size_t idx = 0; idx < legalMoves.size(); ++idx) {
+        policy[policyIndices[idx]] = policyProbSmall[idx];
+    }
+
+    if (game.firstMove) {
+        game.gamePolicy = policy;
     }
     else {
         // concatenate the sample to array for the current game
-        gamePolicy = xt::concatenate(xtuple(gamePolicy, policy));
+        game.gamePolicy = xt::concatenate(xtuple(game.gamePolicy, policy));
     }
 }
 
-void TrainDataExporter::save_start_idx()
+void TrainDataExporter::save_start_idx(size_t nextGameIdx, size_t nextStartIdx)
 {
     // gameStartIdx
     // write value to roi
-    z5::types::ShapeType offsetStartIdx = { gameIdx };
-    xt::xarray<int32_t> arrayGameStartIdx({ 1 }, int32_t(startIdx));
-    z5::multiarray::writeSubarray<int32_t>(dStartIndex, arrayGameStartIdx, offsetStartIdx.begin());
+    z5::types::ShapeType offsetStartIdx = { nextGameIdx };
+    xt::xarray<StartIndexType> arrayGameStartIdx({ 1 }, StartIndexType(nextStartIdx));
+    z5::multiarray::writeSubarray<StartIndexType>(dStartIndex, arrayGameStartIdx, offsetStartIdx.begin());
 }
 
 void TrainDataExporter::open_dataset_from_file(const z5::filesystem::handle::File& file)
 {
-    dStartIndex = z5::openDataset(file, "start_indices");
-    dx = z5::openDataset(file, "x");
-    dValue = z5::openDataset(file, "y_value");
-    dPolicy = z5::openDataset(file, "y_policy");
-    dbestMoveQ = z5::openDataset(file, "y_best_move_q");
-    dPlysToEnd = z5::openDataset(file, "plys_to_end");
-    dPhaseVector = z5::openDataset(file, "phase_vector");
+    dStartIndex = z5::openDataset(file, DATASET_START_INDICES);
+    if (exportFormat == EXPORT_FORMAT_PACKED) {
+        dPlaneMasks = z5::openDataset(file, DATASET_PLANE_MASKS);
+        dPlaneValues = z5::openDataset(file, DATASET_PLANE_VALUES);
+        dPolicyIndices = z5::openDataset(file, DATASET_POLICY_INDICES);
+        dPolicyProbs = z5::openDataset(file, DATASET_POLICY_PROBS);
+    }
+    else {
+        dx = z5::openDataset(file, DATASET_X);
+        dPolicy = z5::openDataset(file, DATASET_POLICY);
+    }
+    dValue = z5::openDataset(file, DATASET_VALUE);
+    dbestMoveQ = z5::openDataset(file, DATASET_BEST_MOVE_Q);
+    dPlysToEnd = z5::openDataset(file, DATASET_PLYS_TO_END);
+    dPhaseVector = z5::openDataset(file, DATASET_PHASE_VECTOR);
 }
 
-void TrainDataExporter::create_new_dataset_file(const z5::filesystem::handle::File &file)
+int TrainDataExporter::read_export_format(const z5::filesystem::handle::File& file) const
+{
+    nlohmann::json attributes;
+    z5::readAttributes(file, attributes);
+    // data sets without a version have been exported in the dense format
+    return attributes.value(ATTRIBUTE_FORMAT_VERSION, EXPORT_FORMAT_DENSE);
+}
+
+void TrainDataExporter::create_new_dataset_file(const z5::filesystem::handle::File &file, const string& compressionCodec, int compressionLevel)
 {
     // create the file in zarr format
     const bool createAsZarr = true;
     z5::createFile(file, createAsZarr);
 
+    string compressor = "raw";
+    z5::types::CompressionOptions compressionOptions;
+    if (compressionCodec != "none") {
+#ifdef WITH_BLOSC
+        compressor = "blosc";
+        compressionOptions["codec"] = compressionCodec;
+        compressionOptions["level"] = compressionLevel;
+        compressionOptions["shuffle"] = 1;
+#else
+        throw invalid_argument("Compressing the training data requires a build with blosc support (USE_BLOSC).");
+#endif
+    }
+
+    // the readers need the format version and the dense shapes for restoring the planes and the policy
+    nlohmann::json attributes;
+    attributes[ATTRIBUTE_FORMAT_VERSION] = exportFormat;
+    attributes[ATTRIBUTE_BOARD_HEIGHT] = StateConstants::BOARD_HEIGHT();
+    attributes[ATTRIBUTE_BOARD_WIDTH] = StateConstants::BOARD_WIDTH();
+    attributes[ATTRIBUTE_NB_LABELS] = StateConstants::NB_LABELS();
+    z5::writeAttributes(file, attributes);
+
     // create a new zarr dataset
-    std::vector<size_t> shape = { numberSamples, StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH() };
-    std::vector<size_t> chunks = { chunkSize, StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH() };
-    dStartIndex = z5::createDataset(file, "start_indices", "int32", { numberSamples }, { chunkSize });
-    dx = z5::createDataset(file, "x", "int16", shape, chunks);
-    dValue = z5::createDataset(file, "y_value", "int16", { numberSamples }, { chunkSize });
-    dPolicy = z5::createDataset(file, "y_policy", "float32", { numberSamples, StateConstants::NB_LABELS() }, { chunkSize, StateConstants::NB_LABELS() });
-    dbestMoveQ = z5::createDataset(file, "y_best_move_q", "float32", { numberSamples }, { chunkSize });
-    dPlysToEnd = z5::createDataset(file, "plys_to_end", "int16", { numberSamples }, { chunkSize });
-    dPhaseVector = z5::createDataset(file, "phase_vector", "int16", { numberSamples }, { chunkSize });
-
-    save_start_idx();
+    dStartIndex = z5::createDataset(file, DATASET_START_INDICES, "int32", { numberSamples }, { chunkSize }, compressor, compressionOptions);
+    if (exportFormat == EXPORT_FORMAT_PACKED) {
+        const size_t nbChannels = StateConstants::NB_CHANNELS_TOTAL();
+        dPlaneMasks = z5::createDataset(file, DATASET_PLANE_MASKS, "uint64", { numberSamples, nbChannels }, { chunkSize, nbChannels }, compressor, compressionOptions);
+        dPlaneValues = z5::createDataset(file, DATASET_PLANE_VALUES, "int16", { numberSamples, nbChannels }, { chunkSize, nbChannels }, compressor, compressionOptions);
+        dPolicyIndices = z5::createDataset(file, DATASET_POLICY_INDICES, "uint16", { numberSamples, sparsePolicySize }, { chunkSize, sparsePolicySize }, compressor, compressionOptions);
+        dPolicyProbs = z5::createDataset(file, DATASET_POLICY_PROBS, "float32", { numberSamples, sparsePolicySize }, { chunkSize, sparsePolicySize }, compressor, compressionOptions);
+    }
+    else {
+        std::vector<size_t> shape = { numberSamples, StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH() };
+        std::vector<size_t> chunks = { chunkSize, StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH() };
+        dx = z5::createDataset(file, DATASET_X, "int16", shape, chunks, compressor, compressionOptions);
+        dPolicy = z5::createDataset(file, DATASET_POLICY, "float32", { numberSamples, StateConstants::NB_LABELS() }, { chunkSize, StateConstants::NB_LABELS() }, compressor, compressionOptions);
+    }
+    dValue = z5::createDataset(file, DATASET_VALUE, "int16", { numberSamples }, { chunkSize }, compressor, compressionOptions);
+    dbestMoveQ = z5::createDataset(file, DATASET_BEST_MOVE_Q, "float32", { numberSamples }, { chunkSize }, compressor, compressionOptions);
+    dPlysToEnd = z5::createDataset(file, DATASET_PLYS_TO_END, "int16", { numberSamples }, { chunkSize }, compressor, compressionOptions);
+    dPhaseVector = z5::createDataset(file, DATASET_PHASE_VECTOR, "int16", { numberSamples }, { chunkSize }, compressor, compressionOptions);
+
+    save_start_idx(0, 0);
 }
 
-void TrainDataExporter::apply_result_to_value(Result result)
+void TrainDataExporter::apply_result_to_value(TrainGameSamples& game, Result result)
 {
     // value
     if (result == BLACK_WIN) {
-        gameValue *= -1;
+        game.gameValue *= -1;
     }
     else if (result == DRAWN) {
-        gameValue *= 0;
+        game.gameValue *= 0;
     }
 }
 
-void TrainDataExporter::apply_result_to_plys_to_end()
+void TrainDataExporter::apply_result_to_plys_to_end(TrainGameSamples& game)
 {
-    gamePlysToEnd -= curSampleIdx;
-    gamePlysToEnd *= -1;
+    game.gamePlysToEnd -= game.curSampleIdx;
+    game.gamePlysToEnd *= -1;
 }
 
 #endif
@@ -30,6 +30,11 @@
 
 #ifdef USE_RL
 #include <string>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <condition_variable>
 
 #include "nlohmann/json.hpp"
 #include "xtensor/xarray.hpp"
@@ -44,6 +49,52 @@
 #include "constants.h"
 #include "node.h"
 #include "evalinfo.h"
+#include "traindatalayout.h"
+
+/**
+ * @brief The TrainGameSamples struct buffers the training samples of a single game until the game result is known.
+ * Every concurrently generated game owns a separate buffer while the TrainDataExporter stays the only writer of the data set.
+ */
+struct TrainGameSamples
+{
+    xt::xarray<int16_t> gameX;
+    xt::xarray<int16_t> gameValue;
+    xt::xarray<float> gamePolicy;
+    xt::xarray<float> gameBestMoveQ;
+    xt::xarray<int16_t> gamePlysToEnd;
+    xt::xarray<int16_t> gamePhaseVector;
+    // packed export format: non-zero squares and value of each plane, sparse policy entries
+    xt::xarray<uint64_t> gamePlaneMasks;
+    xt::xarray<int16_t> gamePlaneValues;
+    xt::xarray<uint16_t> gamePolicyIndices;
+    xt::xarray<float> gamePolicyProbs;
+    bool firstMove;
+    // current sample index of the current game
+    size_t curSampleIdx;
+
+    TrainGameSamples();
+
+    /**
+     * @brief new_game Sets firstMove to true and resets the sample index
+     */
+    void new_game();
+};
+
+/**
+ * @brief The ExportJob struct describes a finished game which waits to be written by the writer thread
+ */
+struct ExportJob
+{
+    TrainGameSamples samples;
+    // sample index of the first sample of the game
+    size_t startIdx;
+    // game index and start index of the following game which are stored in "start_indices"
+    size_t nextGameIdx;
+    size_t nextStartIdx;
+};
+
+class ShardWriter;
+class SamplePublisher;
 
 class TrainDataExporter
 {
@@ -60,66 +111,126 @@ private:
     std::unique_ptr<z5::Dataset> dbestMoveQ;
     std::unique_ptr<z5::Dataset> dPlysToEnd;
     std::unique_ptr<z5::Dataset> dPhaseVector;
-
-    xt::xarray<int16_t> gameX;
-    xt::xarray<int16_t> gameValue;
-    xt::xarray<float> gamePolicy;
-    xt::xarray<float> gameBestMoveQ;
-    xt::xarray<int16_t> gamePlysToEnd;
-    xt::xarray<int16_t> gamePhaseVector;
-    bool firstMove;
+    std::unique_ptr<z5::Dataset> dPlaneMasks;
+    std::unique_ptr<z5::Dataset> dPlaneValues;
+    std::unique_ptr<z5::Dataset> dPolicyIndices;
+    std::unique_ptr<z5::Dataset> dPolicyProbs;
+    // EXPORT_FORMAT_DENSE or EXPORT_FORMAT_PACKED
+    int exportFormat;
+    // number of (index, probability) pairs which are stored for each sample in the packed format
+    size_t sparsePolicySize;
+    // appends the games to streaming shards instead of the preallocated zarr file if set
+    std::unique_ptr<ShardWriter> shardWriter;
+#ifndef _WIN32
+    // sends the games to a replay buffer service if set
+    std::unique_ptr<SamplePublisher> publisher;
+#endif
 
     // current number of games - 1
     size_t gameIdx;
     // current sample index to insert
-    size_t startIdx;
-    // current sample index of the current game
-    size_t curSampleIdx;
+    std::atomic<size_t> startIdx;
+    // guards the export queue and the reservation of sample indices
+    std::mutex mtx;
+    // finished games which are written to disk by the writer thread in their order of reservation
+    std::deque<ExportJob> exportQueue;
+    size_t maxQueueSize;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobFinished;
+    // true if the games are streamed to shards or a replay buffer service without a sample limit
+    bool isStreaming;
+    bool isWriting;
+    bool isRunning;
+    // single writer of the data set, compresses the chunks without blocking the search
+    std::thread writerThread;
 
     /**
      * @brief export_planes Exports the board in plane representation (x)
+     * @param game Sample buffer of the current game
      * @param pos Board position to export
      */
-    void save_planes(const StateObj* pos);
+    void save_planes(TrainGameSamples& game, const StateObj* pos);
+
+    /**
+     * @brief save_packed_planes Exports the board as a bit mask and a value for each plane
+     * @param game Sample buffer of the current game
+     * @param inputPlanes Plane representation of the board
+     */
+    void save_packed_planes(TrainGameSamples& game, const float* inputPlanes);
 
     /**
      * @brief save_policy Saves the policy (e.g. mctsPolicy) to the matrix
+     * @param game Sample buffer of the current game
      * @param legalMoves List of legal moves
      * @param policyProbSmall Probability for each move
      * @param mirrorPolicy Decides if the policy should be mirrored
      */
-    void save_policy(const vector<Action>& legalMoves, const DynamicVector<float>& policyProbSmall, bool mirrorPolicy);
+    void save_policy(TrainGameSamples& game, const vector<Action>& legalMoves, const DynamicVector<float>& policyProbSmall, bool mirrorPolicy);
+
+    /**
+     * @brief save_sparse_policy Saves the non-zero policy entries as (index, probability) pairs.
+     * If there are more than sparsePolicySize entries, only the most likely ones are kept and renormalized.
+     * Unused pairs are filled with the index NB_LABELS() and a probability of 0.
+     * @param game Sample buffer of the current game
+     * @param policyIndices Policy index for each move
+     * @param policyProbSmall Probability for each move
+     */
+    void save_sparse_policy(TrainGameSamples& game, const vector<size_t>& policyIndices, const DynamicVector<float>& policyProbSmall);
+
+    /**
+     * @brief truncate_game Keeps only the first numberSamples samples of the game
+     * @param game Sample buffer of the current game
+     * @param numberSamples Number of samples to keep
+     */
+    void truncate_game(TrainGameSamples& game, size_t numberSamples) const;
 
     /**
      * @brief save_best_move_q Saves the Q-value of the move which was selected after MCTS search(Optional training sample feature)
+     * @param game Sample buffer of the current game
      * @param eval Filled EvalInfo struct after mcts search
      */
-    void save_best_move_q(const EvalInfo& eval);
+    void save_best_move_q(TrainGameSamples& game, const EvalInfo& eval);
 
     /**
      * @brief save_side_to_move Saves the current side to move as a +1 for WHITE and -1 for BLACK.
      * The current side to move is either WHITE(0) or BLACK(1).
      * Later if WHITE won the game the value array is inverted.
      * For a draw it will be multiplied by 0.
+     * @param game Sample buffer of the current game
      * @param col current side to move
      */
-    void save_side_to_move(Color col);
+    void save_side_to_move(TrainGameSamples& game, Color col);
 
     /**
      * @brief save_cur_sample_index Saves the current sample index, i.e. the ply index which is resetted to 0 before each game.
+     * @param game Sample buffer of the current game
      */
-    void save_cur_sample_index();
+    void save_cur_sample_index(TrainGameSamples& game);
 
     /**
      * @brief save_cur_phase Saves the current phase id for the current position.
+     * @param game Sample buffer of the current game
      * @param pos Current position
      */
-    void save_cur_phase(const StateObj* pos);
+    void save_cur_phase(TrainGameSamples& game, const StateObj* pos);
 
     /**
-     * @brief save_start_idx Saves the current starting index where the next game starts to the game array
+     * @brief save_start_idx Saves the starting index where the next game starts to the game array
+     * @param nextGameIdx Index of the next game
+     * @param nextStartIdx Sample index of the first sample of the next game
      */
-    void save_start_idx();
+    void save_start_idx(size_t nextGameIdx, size_t nextStartIdx);
+
+    /**
+     * @brief write_game_samples Writes the samples of a finished game to the data set
+     * @param job Finished game
+     */
+    void write_game_samples(const ExportJob& job);
+
+    /**
+     * @brief run_writer Main loop of the writer thread which writes the queued games until the exporter is destroyed
+     */
+    void run_writer();
 
     /**
      * @brief open_dataset_from_file Reads a previously exported training set back into memory
@@ -127,24 +238,35 @@ private:
      */
     void open_dataset_from_file(const z5::filesystem::handle::File& file);
 
+    /**
+     * @brief read_export_format Returns the export format of an existing data set
+     * @param file filesystem handle
+     * @return EXPORT_FORMAT_DENSE or EXPORT_FORMAT_PACKED
+     */
+    int read_export_format(const z5::filesystem::handle::File& file) const;
+
     /**
      * @brief open_dataset_from_file Creates a new zarr data set given a filesystem handle
      * @param file filesystem handle
+     * @param compressionCodec Blosc codec which is used for compressing the chunks or "none"
+     * @param compressionLevel Compression level of the codec
      */
-    void create_new_dataset_file(const z5::filesystem::handle::File& file);
+    void create_new_dataset_file(const z5::filesystem::handle::File& file, const string& compressionCodec, int compressionLevel);
 
     /**
      * @brief apply_result_to_value Inverts the gameValue array if WHITE lost the game.
      * In the case of a draw, all entries are set to 0.
+     * @param game Sample buffer of the current game
      * @param result Possible values DRAWN, WHITE_WIN, BLACK_WIN,
      */
-    void apply_result_to_value(Result result);
+    void apply_result_to_value(TrainGameSamples& game, Result result);
 
     /**
      * @brief apply_result_to_plys_to_end Converts the ply index information into plys-to-end
      *  by subtracting the final ply and multiplying by -1.
+     * @param game Sample buffer of the current game
      */
-    void apply_result_to_plys_to_end();
+    void apply_result_to_plys_to_end(TrainGameSamples& game);
 
 public:
     /**
@@ -155,35 +277,56 @@ public:
      * @param numberChunks Defines how many chunks a single file should contain.
      * The product of the number of chunks and its chunk size yields the total number of samples of a file.
      * @param chunkSize Defines the chunk size of a single chunk
+     * @param compressionCodec Blosc codec ("lz4", "zstd", "zlib", "blosclz") which is used for compressing new data sets or "none"
+     * @param compressionLevel Compression level of the codec (0-9)
+     * @param maxQueueSize Maximum number of finished games which wait to be written.
+     * export_game_samples() blocks if more games are waiting.
+     * @param exportFormat EXPORT_FORMAT_DENSE or EXPORT_FORMAT_PACKED. The packed format requires 8x8 boards and
+     * an input representation in which every plane has at most one distinct non-zero value.
+     * @param sparsePolicySize Number of (index, probability) pairs for each sample in the packed format
+     * @param streamDirectory If not empty, the games are appended to streaming shards in this directory (see shardwriter.h)
+     * without a sample limit instead of being exported to the zarr file
+     * @param shardSizeBytes Size after which a new shard is started
+     * @param publishAddress If not empty, the games are sent to the replay buffer service at <host>:<port> (see samplepublisher.h).
+     * Can be combined with streamDirectory. The zarr file isn't used in this case.
      */
-    TrainDataExporter(const string& fileNameExport, unsigned int numPhases, GamePhaseDefinition gamePhaseDefinition, size_t numberChunks=200, size_t chunkSize=128);
+    TrainDataExporter(const string& fileNameExport, unsigned int numPhases, GamePhaseDefinition gamePhaseDefinition, size_t numberChunks=200, size_t chunkSize=128,
+                      const string& compressionCodec="none", int compressionLevel=5, size_t maxQueueSize=4,
+                      int exportFormat=EXPORT_FORMAT_DENSE, size_t sparsePolicySize=256,
+                      const string& streamDirectory="", size_t shardSizeBytes=256*1024*1024, const string& publishAddress="");
+    ~TrainDataExporter();
 
     /**
      * @brief export_pos Saves a given board position, policy and Q-value to the specific game arrays
+     * @param game Sample buffer of the current game
      * @param pos Current board position
      * @param eval Filled EvalInfo struct after mcts search
      */
-    void save_sample(const StateObj* pos, const EvalInfo& eval);
+    void save_sample(TrainGameSamples& game, const StateObj* pos, const EvalInfo& eval);
 
     /**
      * @brief export_game_samples Assigns the game result, (Monte-Carlo value result) to every training sample.
      * The value is inversed after each step and export all training samples of a single game.
+     * The method is thread-safe. Samples which exceed the remaining capacity of the file are discarded.
+     * The samples are moved to the queue of the writer thread and the game buffer is empty afterwards.
+     * @param game Sample buffer of the finished game
      * @param result Game match result: LOST, DRAW, WON
      */
-    void export_game_samples(Result result);
+    void export_game_samples(TrainGameSamples& game, Result result);
+
+    /**
+     * @brief flush Blocks until all queued games have been written to disk
+     */
+    void flush();
 
     size_t get_number_samples() const;
 
     /**
-     * @brief is_file_full Returns true if the exported data set contains as many samples as initially specified, else false
+     * @brief is_file_full Returns true if the exported data set contains as many samples as initially specified, else false.
+     * Streaming shards are never full.
      * @return bool
      */
     bool is_file_full();
-
-    /**
-     * @brief new_game Sets firstMove to true
-     */
-    void new_game();
 };
 #endif
 
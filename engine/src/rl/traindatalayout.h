@@ -0,0 +1,76 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: traindatalayout.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Layout of the zarr data sets which are written by the TrainDataExporter and read by the TrainDataLoader.
+ * Both sides use these definitions, so the writer and the reader can't drift apart.
+ *
+ * Data sets of a file (the first dimension is the sample index):
+ *  EXPORT_FORMAT_DENSE: x (int16, C x H x W), y_policy (float32, NB_LABELS)
+ *  EXPORT_FORMAT_PACKED: x_plane_masks (uint64, C), x_plane_values (int16, C),
+ *                        y_policy_indices (uint16, sparse policy size), y_policy_probs (float32, sparse policy size)
+ *  both: start_indices (int32), y_value (int16), y_best_move_q (float32), plys_to_end (int16), phase_vector (int16)
+ */
+
+#ifndef TRAINDATALAYOUT_H
+#define TRAINDATALAYOUT_H
+
+#include <cstdint>
+
+// version of the default export format storing dense int16 planes and the full policy vector
+#define EXPORT_FORMAT_DENSE 1
+// version of the export format storing a bit mask and a value for each plane and (index, probability) pairs of the policy
+#define EXPORT_FORMAT_PACKED 2
+
+// data set names
+#define DATASET_START_INDICES "start_indices"
+#define DATASET_X "x"
+#define DATASET_POLICY "y_policy"
+#define DATASET_PLANE_MASKS "x_plane_masks"
+#define DATASET_PLANE_VALUES "x_plane_values"
+#define DATASET_POLICY_INDICES "y_policy_indices"
+#define DATASET_POLICY_PROBS "y_policy_probs"
+#define DATASET_VALUE "y_value"
+#define DATASET_BEST_MOVE_Q "y_best_move_q"
+#define DATASET_PLYS_TO_END "plys_to_end"
+#define DATASET_PHASE_VECTOR "phase_vector"
+
+// file attributes which describe the dense shapes of the planes and the policy
+#define ATTRIBUTE_FORMAT_VERSION "format_version"
+#define ATTRIBUTE_BOARD_HEIGHT "board_height"
+#define ATTRIBUTE_BOARD_WIDTH "board_width"
+#define ATTRIBUTE_NB_LABELS "nb_labels"
+
+// element types of the data sets
+typedef int32_t StartIndexType;
+typedef int16_t PlaneValueType;
+typedef uint64_t PlaneMaskType;
+typedef float PolicyProbType;
+typedef uint16_t PolicyIndexType;
+typedef int16_t ValueTargetType;
+typedef float BestMoveQType;
+typedef int16_t PlysToEndType;
+typedef int16_t PhaseType;
+
+#endif // TRAINDATALAYOUT_H
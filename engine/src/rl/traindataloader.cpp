@@ -0,0 +1,486 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: traindataloader.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#ifdef USE_RL
+#include "traindataloader.h"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include "nlohmann/json.hpp"
+#include "xtensor/xarray.hpp"
+#include "z5/factory.hxx"
+#include "z5/attributes.hxx"
+#include "z5/multiarray/xtensor_access.hxx"
+#include "../nn/planepacking.h"
+#include "../util/communication.h"
+#include "environments/chess_related/outputrepresentation.h"
+#ifdef TENSORRT
+#include <cuda_runtime_api.h>
+#endif
+
+using namespace std;
+
+TrainBatch::TrainBatch(size_t batchSize, size_t numberInputValues, size_t numberLabels):
+    batchSize(batchSize),
+    numberValues(batchSize * (numberInputValues + numberLabels + 4))
+{
+#ifdef TENSORRT
+    // pinned memory allows asynchronous copies to the device
+    if (cudaHostAlloc((void**)&buffer, numberValues * sizeof(float), cudaHostAllocDefault) != cudaSuccess) {
+        throw runtime_error("Couldn't allocate pinned memory for a training batch.");
+    }
+#else
+    buffer = new float[numberValues];
+#endif
+    x = buffer;
+    yPolicy = x + batchSize * numberInputValues;
+    yValue = yPolicy + batchSize * numberLabels;
+    yBestMoveQ = yValue + batchSize;
+    plysToEnd = yBestMoveQ + batchSize;
+    phaseVector = plysToEnd + batchSize;
+}
+
+TrainBatch::~TrainBatch()
+{
+#ifdef TENSORRT
+    cudaFreeHost(buffer);
+#else
+    delete[] buffer;
+#endif
+}
+
+/**
+ * @brief read_column Reads the values of the samples [start, start + numberSamples) of a data set and converts them to float
+ * @param dataset Data set
+ * @param start First sample
+ * @param numberSamples Number of samples
+ * @param valuesPerSample Number of values of each sample
+ * @param output Output array
+ */
+template<typename T>
+void read_column(const unique_ptr<z5::Dataset>& dataset, size_t start, size_t numberSamples, size_t valuesPerSample, float* output)
+{
+    xt::xarray<T> values;
+    if (dataset->dimension() == 1) {
+        values = xt::xarray<T>::from_shape({ numberSamples });
+    }
+    else {
+        values = xt::xarray<T>::from_shape({ numberSamples, valuesPerSample });
+    }
+    z5::types::ShapeType offset(dataset->dimension(), 0);
+    offset[0] = start;
+    z5::multiarray::readSubarray<T>(dataset, values, offset.begin());
+    std::copy(values.data(), values.data() + values.size(), output);
+}
+
+/**
+ * @brief copy_sample Copies a sample of the store into a batch
+ */
+void copy_sample(const SampleStore& store, size_t sampleIdx, size_t numberInputValues, size_t numberLabels, TrainBatch& batch, size_t batchIdx)
+{
+    std::copy_n(store.x.data() + sampleIdx * numberInputValues, numberInputValues, batch.x + batchIdx * numberInputValues);
+    std::copy_n(store.yPolicy.data() + sampleIdx * numberLabels, numberLabels, batch.yPolicy + batchIdx * numberLabels);
+    batch.yValue[batchIdx] = store.yValue[sampleIdx];
+    batch.yBestMoveQ[batchIdx] = store.yBestMoveQ[sampleIdx];
+    batch.plysToEnd[batchIdx] = store.plysToEnd[sampleIdx];
+    batch.phaseVector[batchIdx] = store.phaseVector[sampleIdx];
+}
+
+/**
+ * @brief resize_store Changes the number of samples of the store
+ */
+void resize_store(SampleStore& store, size_t numberSamples, size_t numberInputValues, size_t numberLabels)
+{
+    store.x.resize(numberSamples * numberInputValues);
+    store.yPolicy.resize(numberSamples * numberLabels);
+    store.yValue.resize(numberSamples);
+    store.yBestMoveQ.resize(numberSamples);
+    store.plysToEnd.resize(numberSamples);
+    store.phaseVector.resize(numberSamples);
+    store.numberSamples = numberSamples;
+}
+
+TrainDataLoader::TrainDataLoader(const vector<string>& filePaths, size_t batchSize, size_t numberThreads, size_t prefetchBatches,
+                                 bool shuffle, float mirrorProbability, size_t chunksPerGroup, uint64_t seed):
+    batchSize(batchSize),
+    numberChannels(0),
+    boardHeight(0),
+    boardWidth(0),
+    numberLabels(0),
+    shuffle(shuffle),
+    mirrorProbability(mirrorProbability),
+    chunksPerGroup(max(chunksPerGroup, size_t(1))),
+    maxBatches(prefetchBatches + numberThreads),
+    nextChunkIdx(0),
+    epoch(0),
+    generator(seed),
+    numberAllocatedBatches(0),
+    isRunning(true)
+{
+    if (filePaths.empty()) {
+        throw invalid_argument("The training data loader requires at least one file.");
+    }
+    if (batchSize == 0 || numberThreads == 0) {
+        throw invalid_argument("The batch size and the number of threads of the training data loader must be positive.");
+    }
+    files.reserve(filePaths.size());
+    for (size_t idx = 0; idx < filePaths.size(); ++idx) {
+        open_file(filePaths[idx], idx == 0);
+    }
+    for (size_t fileIdx = 0; fileIdx < files.size(); ++fileIdx) {
+        const size_t numberChunks = (files[fileIdx].numberSamples + files[fileIdx].chunkSize - 1) / files[fileIdx].chunkSize;
+        for (size_t chunkIdx = 0; chunkIdx < numberChunks; ++chunkIdx) {
+            chunkOrder.emplace_back(fileIdx, chunkIdx);
+        }
+    }
+    if (get_number_samples() < batchSize) {
+        throw invalid_argument("The training data contains fewer samples than a single batch.");
+    }
+    if (mirrorProbability > 0) {
+        init_mirrored_policy_indices();
+    }
+    if (shuffle) {
+        std::shuffle(chunkOrder.begin(), chunkOrder.end(), generator);
+    }
+    for (size_t idx = 0; idx < numberThreads; ++idx) {
+        workers.emplace_back(&TrainDataLoader::run_worker, this, idx);
+    }
+}
+
+TrainDataLoader::~TrainDataLoader()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        isRunning = false;
+    }
+    batchReleased.notify_all();
+    batchReady.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void TrainDataLoader::open_file(const string& filePath, bool isFirstFile)
+{
+    TrainDataFile file;
+    file.handle = make_unique<z5::filesystem::handle::File>(filePath);
+    if (!file.handle->exists()) {
+        throw invalid_argument("The training data file " + filePath + " doesn't exist.");
+    }
+    nlohmann::json attributes;
+    z5::readAttributes(*file.handle, attributes);
+    // data sets without a version have been exported in the dense format
+    file.exportFormat = attributes.value(ATTRIBUTE_FORMAT_VERSION, EXPORT_FORMAT_DENSE);
+
+    size_t channels, height, width, labels;
+    if (file.exportFormat == EXPORT_FORMAT_PACKED) {
+        file.dPlaneMasks = z5::openDataset(*file.handle, DATASET_PLANE_MASKS);
+        file.dPlaneValues = z5::openDataset(*file.handle, DATASET_PLANE_VALUES);
+        file.dPolicyIndices = z5::openDataset(*file.handle, DATASET_POLICY_INDICES);
+        file.dPolicyProbs = z5::openDataset(*file.handle, DATASET_POLICY_PROBS);
+        channels = file.dPlaneMasks->shape()[1];
+        height = attributes.value(ATTRIBUTE_BOARD_HEIGHT, 8);
+        width = attributes.value(ATTRIBUTE_BOARD_WIDTH, 8);
+        if (!attributes.contains(ATTRIBUTE_NB_LABELS) || height * width != PACKED_PLANE_SIZE) {
+            throw invalid_argument("The packed training data file " + filePath + " is missing the number of labels or doesn't use 8x8 boards.");
+        }
+        labels = attributes[ATTRIBUTE_NB_LABELS].get<size_t>();
+    }
+    else {
+        file.dx = z5::openDataset(*file.handle, DATASET_X);
+        file.dPolicy = z5::openDataset(*file.handle, DATASET_POLICY);
+        channels = file.dx->shape()[1];
+        height = file.dx->shape()[2];
+        width = file.dx->shape()[3];
+        labels = file.dPolicy->shape()[1];
+    }
+    file.dValue = z5::openDataset(*file.handle, DATASET_VALUE);
+    file.dBestMoveQ = z5::openDataset(*file.handle, DATASET_BEST_MOVE_Q);
+    file.dPlysToEnd = z5::openDataset(*file.handle, DATASET_PLYS_TO_END);
+    file.dPhaseVector = z5::openDataset(*file.handle, DATASET_PHASE_VECTOR);
+    file.numberSamples = file.dValue->shape()[0];
+    file.chunkSize = file.dValue->defaultChunkShape()[0];
+
+    if (isFirstFile) {
+        numberChannels = channels;
+        boardHeight = height;
+        boardWidth = width;
+        numberLabels = labels;
+    }
+    else if (channels != numberChannels || height != boardHeight || width != boardWidth || labels != numberLabels) {
+        throw invalid_argument("The training data file " + filePath + " uses a different shape of the planes or the policy than the previous files.");
+    }
+    files.emplace_back(std::move(file));
+}
+
+void TrainDataLoader::init_mirrored_policy_indices()
+{
+    if (OutputRepresentation::LABELS.empty()) {
+        OutputRepresentation::init_labels();
+    }
+    if (OutputRepresentation::LABELS.size() != numberLabels || boardWidth != 8) {
+        throw invalid_argument("Mirroring requires training data with the policy labels of the current variant.");
+    }
+    unordered_map<string, int> labelIndices;
+    for (size_t idx = 0; idx < numberLabels; ++idx) {
+        labelIndices[OutputRepresentation::LABELS[idx]] = int(idx);
+    }
+    mirroredPolicyIndices.resize(numberLabels);
+    for (size_t idx = 0; idx < numberLabels; ++idx) {
+        // the files of the origin and the destination square (a drop such as "P@e4" only has a destination)
+        string label = OutputRepresentation::LABELS[idx];
+        for (size_t charIdx : {0, 2}) {
+            if (charIdx < label.size() && label[charIdx] >= 'a' && label[charIdx] <= 'h') {
+                label[charIdx] = char('h' - (label[charIdx] - 'a'));
+            }
+        }
+        const auto it = labelIndices.find(label);
+        mirroredPolicyIndices[idx] = it == labelIndices.end() ? -1 : it->second;
+    }
+}
+
+bool TrainDataLoader::get_next_chunks(vector<pair<size_t, size_t>>& chunks, uint64_t& seed)
+{
+    lock_guard<mutex> lock(mtx);
+    if (!isRunning) {
+        return false;
+    }
+    chunks.clear();
+    for (size_t idx = 0; idx < chunksPerGroup; ++idx) {
+        if (nextChunkIdx == chunkOrder.size()) {
+            ++epoch;
+            nextChunkIdx = 0;
+            if (shuffle) {
+                std::shuffle(chunkOrder.begin(), chunkOrder.end(), generator);
+            }
+        }
+        chunks.emplace_back(chunkOrder[nextChunkIdx++]);
+    }
+    seed = generator();
+    return true;
+}
+
+void TrainDataLoader::read_chunk(const TrainDataFile& file, size_t chunkIdx, SampleStore& store) const
+{
+    const size_t start = chunkIdx * file.chunkSize;
+    const size_t numberSamples = min(file.chunkSize, file.numberSamples - start);
+    const size_t numberInputValues = numberChannels * boardHeight * boardWidth;
+    const size_t offset = store.numberSamples;
+    resize_store(store, offset + numberSamples, numberInputValues, numberLabels);
+    float* x = store.x.data() + offset * numberInputValues;
+    float* policy = store.yPolicy.data() + offset * numberLabels;
+
+    if (file.exportFormat == EXPORT_FORMAT_PACKED) {
+        const size_t numberPlanes = numberSamples * numberChannels;
+        xt::xarray<PlaneMaskType> masks = xt::xarray<PlaneMaskType>::from_shape({ numberSamples, numberChannels });
+        z5::types::ShapeType offsetMatrix = { start, 0 };
+        z5::multiarray::readSubarray<PlaneMaskType>(file.dPlaneMasks, masks, offsetMatrix.begin());
+        vector<float> values(numberPlanes);
+        read_column<PlaneValueType>(file.dPlaneValues, start, numberSamples, numberChannels, values.data());
+        unpack_planes(masks.data(), values.data(), x, numberPlanes);
+
+        // unused pairs are marked by the index numberLabels
+        const size_t sparsePolicySize = file.dPolicyIndices->shape()[1];
+        vector<float> indices(numberSamples * sparsePolicySize);
+        vector<float> probs(numberSamples * sparsePolicySize);
+        read_column<PolicyIndexType>(file.dPolicyIndices, start, numberSamples, sparsePolicySize, indices.data());
+        read_column<PolicyProbType>(file.dPolicyProbs, start, numberSamples, sparsePolicySize, probs.data());
+        std::fill_n(policy, numberSamples * numberLabels, 0.0f);
+        for (size_t sampleIdx = 0; sampleIdx < numberSamples; ++sampleIdx) {
+            for (size_t pairIdx = 0; pairIdx < sparsePolicySize; ++pairIdx) {
+                const size_t policyIdx = size_t(indices[sampleIdx * sparsePolicySize + pairIdx]);
+                if (policyIdx < numberLabels) {
+                    policy[sampleIdx * numberLabels + policyIdx] = probs[sampleIdx * sparsePolicySize + pairIdx];
+                }
+            }
+        }
+    }
+    else {
+        xt::xarray<PlaneValueType> planes = xt::xarray<PlaneValueType>::from_shape({ numberSamples, numberChannels, boardHeight, boardWidth });
+        z5::types::ShapeType offsetPlanes = { start, 0, 0, 0 };
+        z5::multiarray::readSubarray<PlaneValueType>(file.dx, planes, offsetPlanes.begin());
+        std::copy(planes.data(), planes.data() + planes.size(), x);
+        read_column<PolicyProbType>(file.dPolicy, start, numberSamples, numberLabels, policy);
+    }
+    read_column<ValueTargetType>(file.dValue, start, numberSamples, 1, store.yValue.data() + offset);
+    read_column<BestMoveQType>(file.dBestMoveQ, start, numberSamples, 1, store.yBestMoveQ.data() + offset);
+    read_column<PlysToEndType>(file.dPlysToEnd, start, numberSamples, 1, store.plysToEnd.data() + offset);
+    read_column<PhaseType>(file.dPhaseVector, start, numberSamples, 1, store.phaseVector.data() + offset);
+}
+
+bool TrainDataLoader::mirror_sample(float* x, float* policy) const
+{
+    for (size_t idx = 0; idx < numberLabels; ++idx) {
+        if (policy[idx] != 0 && mirroredPolicyIndices[idx] == -1) {
+            return false;
+        }
+    }
+    for (size_t row = 0; row < numberChannels * boardHeight; ++row) {
+        std::reverse(x + row * boardWidth, x + (row + 1) * boardWidth);
+    }
+    thread_local vector<float> mirroredPolicy;
+    mirroredPolicy.assign(numberLabels, 0.0f);
+    for (size_t idx = 0; idx < numberLabels; ++idx) {
+        if (policy[idx] != 0) {
+            mirroredPolicy[mirroredPolicyIndices[idx]] = policy[idx];
+        }
+    }
+    std::copy(mirroredPolicy.begin(), mirroredPolicy.end(), policy);
+    return true;
+}
+
+unique_ptr<TrainBatch> TrainDataLoader::acquire_batch()
+{
+    unique_lock<mutex> lock(mtx);
+    batchReleased.wait(lock, [this]{ return !isRunning || !freeBatches.empty() || numberAllocatedBatches < maxBatches; });
+    if (!isRunning) {
+        return nullptr;
+    }
+    if (!freeBatches.empty()) {
+        unique_ptr<TrainBatch> batch = std::move(freeBatches.back());
+        freeBatches.pop_back();
+        return batch;
+    }
+    ++numberAllocatedBatches;
+    lock.unlock();
+    return make_unique<TrainBatch>(batchSize, numberChannels * boardHeight * boardWidth, numberLabels);
+}
+
+void TrainDataLoader::run_worker(size_t workerIdx)
+{
+    const size_t numberInputValues = numberChannels * boardHeight * boardWidth;
+    SampleStore store;
+    SampleStore remainingSamples;
+    vector<pair<size_t, size_t>> chunks;
+    vector<size_t> order;
+    uint64_t seed;
+    mt19937_64 randomEngine;
+    uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+    try {
+        while (get_next_chunks(chunks, seed)) {
+            randomEngine.seed(seed + workerIdx);
+            for (const pair<size_t, size_t>& chunk : chunks) {
+                read_chunk(files[chunk.first], chunk.second, store);
+            }
+            order.resize(store.numberSamples);
+            iota(order.begin(), order.end(), 0);
+            if (shuffle) {
+                std::shuffle(order.begin(), order.end(), randomEngine);
+            }
+            size_t usedSamples = 0;
+            for (; usedSamples + batchSize <= store.numberSamples; usedSamples += batchSize) {
+                unique_ptr<TrainBatch> batch = acquire_batch();
+                if (batch == nullptr) {
+                    return;
+                }
+                for (size_t batchIdx = 0; batchIdx < batchSize; ++batchIdx) {
+                    copy_sample(store, order[usedSamples + batchIdx], numberInputValues, numberLabels, *batch, batchIdx);
+                    if (mirrorProbability > 0 && distribution(randomEngine) < mirrorProbability) {
+                        mirror_sample(batch->x + batchIdx * numberInputValues, batch->yPolicy + batchIdx * numberLabels);
+                    }
+                }
+                lock_guard<mutex> lock(mtx);
+                readyBatches.emplace_back(std::move(batch));
+                batchReady.notify_one();
+            }
+            // the remaining samples are mixed with the samples of the next chunks
+            resize_store(remainingSamples, 0, numberInputValues, numberLabels);
+            for (size_t idx = usedSamples; idx < store.numberSamples; ++idx) {
+                const size_t sampleIdx = order[idx];
+                remainingSamples.x.insert(remainingSamples.x.end(), store.x.begin() + sampleIdx * numberInputValues, store.x.begin() + (sampleIdx + 1) * numberInputValues);
+                remainingSamples.yPolicy.insert(remainingSamples.yPolicy.end(), store.yPolicy.begin() + sampleIdx * numberLabels, store.yPolicy.begin() + (sampleIdx + 1) * numberLabels);
+                remainingSamples.yValue.emplace_back(store.yValue[sampleIdx]);
+                remainingSamples.yBestMoveQ.emplace_back(store.yBestMoveQ[sampleIdx]);
+                remainingSamples.plysToEnd.emplace_back(store.plysToEnd[sampleIdx]);
+                remainingSamples.phaseVector.emplace_back(store.phaseVector[sampleIdx]);
+                ++remainingSamples.numberSamples;
+            }
+            std::swap(store, remainingSamples);
+        }
+    }
+    catch (const exception& e) {
+        info_string_important("Training data loader worker failed:", e.what());
+        lock_guard<mutex> lock(mtx);
+        workerError = e.what();
+        batchReady.notify_all();
+    }
+}
+
+unique_ptr<TrainBatch> TrainDataLoader::next_batch()
+{
+    unique_lock<mutex> lock(mtx);
+    batchReady.wait(lock, [this]{ return !readyBatches.empty() || workerError != ""; });
+    if (readyBatches.empty()) {
+        throw runtime_error("The training data couldn't be loaded: " + workerError);
+    }
+    unique_ptr<TrainBatch> batch = std::move(readyBatches.front());
+    readyBatches.pop_front();
+    return batch;
+}
+
+void TrainDataLoader::release_batch(unique_ptr<TrainBatch> batch)
+{
+    lock_guard<mutex> lock(mtx);
+    freeBatches.emplace_back(std::move(batch));
+    batchReleased.notify_one();
+}
+
+size_t TrainDataLoader::get_number_samples() const
+{
+    size_t numberSamples = 0;
+    for (const TrainDataFile& file : files) {
+        numberSamples += file.numberSamples;
+    }
+    return numberSamples;
+}
+
+size_t TrainDataLoader::get_epoch()
+{
+    lock_guard<mutex> lock(mtx);
+    return epoch;
+}
+
+size_t TrainDataLoader::get_number_channels() const
+{
+    return numberChannels;
+}
+
+size_t TrainDataLoader::get_board_height() const
+{
+    return boardHeight;
+}
+
+size_t TrainDataLoader::get_board_width() const
+{
+    return boardWidth;
+}
+
+size_t TrainDataLoader::get_number_labels() const
+{
+    return numberLabels;
+}
+#endif
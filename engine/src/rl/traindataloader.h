@@ -0,0 +1,230 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: traindataloader.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Loader which prepares shuffled mini-batches of the zarr data sets written by the TrainDataExporter (see traindatalayout.h).
+ * Worker threads decompress different chunks at the same time, mix the samples of several chunks from all given files,
+ * optionally mirror the samples and store the finished batches in (CUDA pinned) host memory until the trainer requests them.
+ * The data sets must be stored as zarr directories. Zipped exports have to be extracted first.
+ */
+
+#ifndef TRAINDATALOADER_H
+#define TRAINDATALOADER_H
+
+#ifdef USE_RL
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <memory>
+#include <condition_variable>
+
+#include "z5/filesystem/handle.hxx"
+#include "z5/dataset.hxx"
+#include "traindatalayout.h"
+
+/**
+ * @brief The TrainBatch struct holds a mini-batch of training samples in a single host buffer.
+ * All targets are converted to float32 and the planes are given as (N, C, H, W).
+ */
+struct TrainBatch
+{
+    size_t batchSize;
+    float* x;
+    float* yPolicy;
+    float* yValue;
+    float* yBestMoveQ;
+    float* plysToEnd;
+    float* phaseVector;
+    // start of the single allocation
+    float* buffer;
+    size_t numberValues;
+
+    TrainBatch(size_t batchSize, size_t numberInputValues, size_t numberLabels);
+    ~TrainBatch();
+    TrainBatch(const TrainBatch&) = delete;
+    TrainBatch& operator=(TrainBatch const&) = delete;
+};
+
+/**
+ * @brief The TrainDataFile struct stores the data sets of a single exported file
+ */
+struct TrainDataFile
+{
+    std::unique_ptr<z5::filesystem::handle::File> handle;
+    std::unique_ptr<z5::Dataset> dx;
+    std::unique_ptr<z5::Dataset> dPolicy;
+    std::unique_ptr<z5::Dataset> dPlaneMasks;
+    std::unique_ptr<z5::Dataset> dPlaneValues;
+    std::unique_ptr<z5::Dataset> dPolicyIndices;
+    std::unique_ptr<z5::Dataset> dPolicyProbs;
+    std::unique_ptr<z5::Dataset> dValue;
+    std::unique_ptr<z5::Dataset> dBestMoveQ;
+    std::unique_ptr<z5::Dataset> dPlysToEnd;
+    std::unique_ptr<z5::Dataset> dPhaseVector;
+    int exportFormat;
+    size_t numberSamples;
+    size_t chunkSize;
+};
+
+/**
+ * @brief The SampleStore struct buffers the decoded samples of a worker thread until they are distributed to batches
+ */
+struct SampleStore
+{
+    std::vector<float> x;
+    std::vector<float> yPolicy;
+    std::vector<float> yValue;
+    std::vector<float> yBestMoveQ;
+    std::vector<float> plysToEnd;
+    std::vector<float> phaseVector;
+    size_t numberSamples = 0;
+};
+
+class TrainDataLoader
+{
+private:
+    std::vector<TrainDataFile> files;
+    size_t batchSize;
+    size_t numberChannels;
+    size_t boardHeight;
+    size_t boardWidth;
+    size_t numberLabels;
+    bool shuffle;
+    float mirrorProbability;
+    // number of chunks whose samples are mixed by a worker before the batches are created
+    size_t chunksPerGroup;
+    size_t maxBatches;
+    // mirrored policy index of each label or -1 if the mirrored move doesn't have a label
+    std::vector<int> mirroredPolicyIndices;
+
+    // (file index, chunk index) of all chunks in the order of the current epoch
+    std::vector<std::pair<size_t, size_t>> chunkOrder;
+    size_t nextChunkIdx;
+    size_t epoch;
+    std::mt19937_64 generator;
+
+    std::mutex mtx;
+    std::deque<std::unique_ptr<TrainBatch>> readyBatches;
+    std::vector<std::unique_ptr<TrainBatch>> freeBatches;
+    size_t numberAllocatedBatches;
+    std::condition_variable batchReady;
+    std::condition_variable batchReleased;
+    bool isRunning;
+    // description of the error which stopped a worker, it is reported by next_batch()
+    std::string workerError;
+    std::vector<std::thread> workers;
+
+    /**
+     * @brief open_file Opens the data sets of an exported file and checks that it matches the previous files
+     * @param filePath Path of the zarr directory
+     * @param isFirstFile True, if the shapes are set by this file
+     */
+    void open_file(const std::string& filePath, bool isFirstFile);
+
+    /**
+     * @brief init_mirrored_policy_indices Maps every policy label to the label of the move with mirrored files
+     */
+    void init_mirrored_policy_indices();
+
+    /**
+     * @brief get_next_chunks Reserves the next chunks of the current epoch and starts a new epoch if needed
+     * @param chunks Output, (file index, chunk index) pairs
+     * @param seed Output, seed for the random numbers of the worker
+     * @return False if the loader is stopped
+     */
+    bool get_next_chunks(std::vector<std::pair<size_t, size_t>>& chunks, uint64_t& seed);
+
+    /**
+     * @brief read_chunk Decompresses a chunk and appends its samples to the store
+     * @param file Data file
+     * @param chunkIdx Index of the chunk
+     * @param store Sample store of the worker
+     */
+    void read_chunk(const TrainDataFile& file, size_t chunkIdx, SampleStore& store) const;
+
+    /**
+     * @brief mirror_sample Flips the files of the planes and the policy of a sample in place
+     * @param x Planes of the sample
+     * @param policy Policy of the sample
+     * @return False if the policy contains a move without mirrored label, the sample is unchanged in this case.
+     */
+    bool mirror_sample(float* x, float* policy) const;
+
+    /**
+     * @brief acquire_batch Returns a free batch buffer and blocks if maxBatches batches are in use
+     * @return Batch or nullptr if the loader is stopped
+     */
+    std::unique_ptr<TrainBatch> acquire_batch();
+
+    /**
+     * @brief run_worker Main loop of a worker thread
+     * @param workerIdx Index of the worker
+     */
+    void run_worker(size_t workerIdx);
+
+public:
+    /**
+     * @brief TrainDataLoader
+     * @param filePaths Paths of the exported zarr directories. All files must use the same planes and policy shapes.
+     * @param batchSize Number of samples of each batch
+     * @param numberThreads Number of worker threads which decompress the chunks
+     * @param prefetchBatches Number of batches which are prepared ahead of the trainer
+     * @param shuffle If true, the chunks are visited in random order and the samples of chunksPerGroup chunks are shuffled
+     * @param mirrorProbability Probability of flipping the files of a sample. The castling planes aren't adjusted,
+     * so the mirroring should only be used for data sets whose rules are symmetric under this flip.
+     * @param chunksPerGroup Number of chunks whose samples are mixed by a worker
+     * @param seed Seed of the random generators
+     */
+    TrainDataLoader(const std::vector<std::string>& filePaths, size_t batchSize, size_t numberThreads=4, size_t prefetchBatches=8,
+                    bool shuffle=true, float mirrorProbability=0, size_t chunksPerGroup=8, uint64_t seed=42);
+    ~TrainDataLoader();
+    TrainDataLoader(const TrainDataLoader&) = delete;
+    TrainDataLoader& operator=(TrainDataLoader const&) = delete;
+
+    /**
+     * @brief next_batch Returns the next prepared batch. Blocks until a batch is available.
+     * The batch must be given back with release_batch() after it has been used.
+     * @return Batch of batchSize samples
+     */
+    std::unique_ptr<TrainBatch> next_batch();
+
+    /**
+     * @brief release_batch Returns the buffer of a batch which is reused for one of the next batches
+     * @param batch Batch returned by next_batch()
+     */
+    void release_batch(std::unique_ptr<TrainBatch> batch);
+
+    size_t get_number_samples() const;
+    size_t get_epoch();
+    size_t get_number_channels() const;
+    size_t get_board_height() const;
+    size_t get_board_width() const;
+    size_t get_number_labels() const;
+};
+#endif
+
+#endif // TRAINDATALOADER_H
@@ -33,6 +33,8 @@
 #include <stdlib.h>
 #include <climits>
 #include "util/blazeutil.h"
+#include "util/numa.h"
+#include "util/metrics.h"
 #include <fstream>
 
 
@@ -41,16 +43,59 @@ size_t SearchThread::get_max_depth() const
     return depthMax;
 }
 
+#ifdef MCTS_UNDO_STATES
+/**
+ * @brief The StateUndoGuard struct reverts the actions of a simulation on the reused search state when the simulation leaves its scope
+ */
+struct StateUndoGuard {
+    StateObj* state;
+    const vector<Action>& actions;
+    Action lastAction;
+
+    ~StateUndoGuard() {
+        state->undo_action(lastAction);
+        for (auto it = actions.rbegin(); it != actions.rend(); ++it) {
+            state->undo_action(*it);
+        }
+    }
+};
+#endif
+
 SearchThread::SearchThread(const vector<unique_ptr<NeuralNetAPI>>& netBatchVector, const SearchSettings* searchSettings, MapWithMutex* mapWithMutex):
-    NeuralNetAPIUser(netBatchVector),
+    NeuralNetAPIUser(netBatchVector, searchSettings->asyncInference, SEARCH_AUXILIARY_OUTPUTS, searchSettings->refineVisits != 0),
     rootNode(nullptr), rootState(nullptr), newState(nullptr),  // will be be set via setter methods
-    newNodes(make_unique<FixedVector<Node*>>(searchSettings->batchSize)),
-    newNodeSideToMove(make_unique<FixedVector<SideToMove>>(searchSettings->batchSize)),
-    transpositionValues(make_unique<FixedVector<float>>(searchSettings->batchSize*2)),
+    batchSize(netBatchVector.front()->get_batch_size()),
+    newNodes(make_unique<FixedVector<Node*>>(batchSize)),
+    newNodeSideToMove(make_unique<FixedVector<SideToMove>>(batchSize)),
+    newNodeCacheKeys(make_unique<FixedVector<Key>>(batchSize)),
+    newNodeSlots(make_unique<FixedVector<uint32_t>>(batchSize)),
+    numberBatchSlots(0),
+    refineCandidate(),
+    refineCandidateDepth(0),
+    multiVisitNodes(make_unique<FixedVector<Node*>>(batchSize)),
+    pendingNodes(make_unique<FixedVector<Node*>>(batchSize)),
+    pendingNodeSideToMove(make_unique<FixedVector<SideToMove>>(batchSize)),
+    pendingNodeCacheKeys(make_unique<FixedVector<Key>>(batchSize)),
+    pendingNodeSlots(make_unique<FixedVector<uint32_t>>(batchSize)),
+    pendingNumberBatchSlots(0),
+    pendingMultiVisitNodes(make_unique<FixedVector<Node*>>(batchSize)),
+    pendingSlotNetIndices(searchSettings->asyncInference ? batchSize : 0, 0),
+    hasPendingBatch(false),
+    transpositionValues(make_unique<FixedVector<float>>(batchSize*2)),
     isRunning(true), mapWithMutex(mapWithMutex), searchSettings(searchSettings),
     tbHits(0), depthSum(0), depthMax(0), visitsPreSearch(0),
-    terminalNodeCache(searchSettings->batchSize*2),
-    reachedTablebases(false)
+    terminalNodeCache(batchSize*2),
+    reachedTablebases(false),
+    numaNode(NO_NUMA_NODE),
+    scheduler(nullptr),
+    threadIdx(0),
+    evalCache(nullptr),
+    nnBook(nullptr),
+    gumbelRoot(nullptr),
+    eventListener(nullptr),
+    batchController(searchSettings->minBatchSize == 0 ? batchSize : min(size_t(searchSettings->minBatchSize), batchSize), batchSize),
+    prng(next_stream_seed()),
+    prefillIdx(0)
 {
     switch (searchSettings->searchPlayerMode) {
     case MODE_SINGLE_PLAYER:
@@ -60,6 +105,11 @@ SearchThread::SearchThread(const vector<unique_ptr<NeuralNetAPI>>& netBatchVecto
     searchLimits = nullptr;  // will be set by set_search_limits() every time before go()
     trajectoryBuffer.reserve(DEPTH_INIT);
     actionsBuffer.reserve(DEPTH_INIT);
+    for (TrajectoryArena* trajectories : {&newTrajectories, &multiVisitTrajectories, &pendingTrajectories, &pendingMultiVisitTrajectories,
+                                          &transpositionTrajectories, &collisionTrajectories, &refineTrajectories, &pendingRefineTrajectories}) {
+        trajectories->reserve(batchSize, DEPTH_INIT);
+    }
+    slotNetIndices.resize(batchSize, 0);
 }
 
 void SearchThread::set_root_node(Node *value)
@@ -88,6 +138,54 @@ void SearchThread::set_reached_tablebases(bool value)
     reachedTablebases = value;
 }
 
+int SearchThread::get_numa_node() const
+{
+    return numaNode;
+}
+
+void SearchThread::set_numa_node(int value)
+{
+    numaNode = value;
+}
+
+const vector<int>& SearchThread::get_search_cpus() const
+{
+    return searchSettings->searchCpus;
+}
+
+void SearchThread::set_scheduler(SubtreeScheduler* value, size_t idx)
+{
+    scheduler = value;
+    threadIdx = idx;
+}
+
+void SearchThread::set_eval_cache(EvalCache* value)
+{
+    evalCache = value;
+}
+
+void SearchThread::set_nn_book(const NNBook* value)
+{
+    nnBook = value;
+}
+
+void SearchThread::set_gumbel_root(GumbelRoot* value)
+{
+    gumbelRoot = value;
+}
+
+void SearchThread::set_event_listener(KillableThread* value)
+{
+    eventListener = value;
+}
+
+void SearchThread::signal_event()
+{
+    if (eventListener != nullptr) {
+        eventListener->signal_event();
+    }
+}
+
 Node* SearchThread::add_new_node_to_tree(StateObj* newState, Node* parentNode, ChildIdx childIdx, NodeBackup& nodeBackup)
 {
     bool transposition;
@@ -121,10 +219,20 @@ const SearchLimits *SearchThread::get_search_limits() const
     return searchLimits;
 }
 
-void random_playout(Node* currentNode, ChildIdx& childIdx)
+void prepare_prefill_child(Node* node, ChildIdx childIdx)
+{
+    if (!node->is_sorted()) {
+        node->prepare_node_for_visits();
+    }
+    while (node->get_no_visit_idx() <= childIdx) {
+        node->increment_no_visit_idx();
+    }
+}
+
+void random_playout(Node* currentNode, ChildIdx& childIdx, FastRandom& prng)
 {
     if (currentNode->is_fully_expanded()) {
-        const size_t idx = rand() % currentNode->get_number_child_nodes();
+        const size_t idx = prng.bounded(uint32_t(currentNode->get_number_child_nodes()));
         if (currentNode->get_child_node(idx) == nullptr || !currentNode->get_child_node(idx)->is_playout_node()) {
             childIdx = idx;
             return;
@@ -144,7 +252,7 @@ void random_playout(Node* currentNode, ChildIdx& childIdx)
 
 Node* SearchThread::get_starting_node(Node* currentNode, NodeDescription& description, ChildIdx& childIdx)
 {
-    size_t depth = get_random_depth();
+    size_t depth = get_random_depth(prng);
     for (uint curDepth = 0; curDepth < depth; ++curDepth) {
         currentNode->lock();
         childIdx = get_best_action_index(currentNode, true, searchSettings);
@@ -155,6 +263,9 @@ Node* SearchThread::get_starting_node(Node* currentNode, NodeDescription& descri
         }
         currentNode->unlock();
         actionsBuffer.emplace_back(currentNode->get_action(childIdx));
+#ifdef MCTS_RELEASE_LEAF_STATES
+        materialize_state(currentNode, childIdx, nextNode);
+#endif
         currentNode = nextNode;
         ++description.depth;
     }
@@ -163,51 +274,92 @@ Node* SearchThread::get_starting_node(Node* currentNode, NodeDescription& descri
 
 Node* SearchThread::get_new_child_to_evaluate(NodeDescription& description)
 {
+    PHASE_TIMER(phaseTimers, PHASE_SELECTION);
     description.depth = 0;
     Node* currentNode = rootNode;
     Node* nextNode;
+    if (workItem.budget != 0) {
+        currentNode = get_work_item_node(description);
+    }
 
-    ChildIdx childIdx = uint16_t(-1);
-    if (searchSettings->epsilonGreedyCounter && rootNode->is_playout_node() && rand() % searchSettings->epsilonGreedyCounter == 0) {
+    const PrefillPath prefillPath = next_prefill_path();
+    ChildIdx childIdx = prefillPath.childIdx;
+    // the rollouts of the prefill are fixed and the Gumbel noise of the root selection replaces the random exploration
+    const bool randomExploration = childIdx == uint16_t(-1) && gumbelRoot == nullptr && rootNode->is_playout_node();
+    if (randomExploration && searchSettings->epsilonGreedyCounter && prng.bounded(searchSettings->epsilonGreedyCounter) == 0) {
         currentNode = get_starting_node(currentNode, description, childIdx);
         currentNode->lock();
-        random_playout(currentNode, childIdx);
+        random_playout(currentNode, childIdx, prng);
         currentNode->unlock();
     }
-    else if (searchSettings->epsilonChecksCounter && rootNode->is_playout_node() && rand() % searchSettings->epsilonChecksCounter == 0) {
+    else if (randomExploration && searchSettings->epsilonChecksCounter && prng.bounded(searchSettings->epsilonChecksCounter) == 0) {
         currentNode = get_starting_node(currentNode, description, childIdx);
         currentNode->lock();
         childIdx = select_enhanced_move(currentNode);
         if (childIdx ==  uint16_t(-1)) {
-            random_playout(currentNode, childIdx);
+            random_playout(currentNode, childIdx, prng);
         }
         currentNode->unlock();
     }
 
     while (true) {
+        LOCK_DEPTH(description.depth);
         currentNode->lock();
         if (childIdx == uint16_t(-1)) {
-            childIdx = currentNode->select_child_node(searchSettings);
+            childIdx = currentNode == rootNode && gumbelRoot != nullptr ? gumbelRoot->select_child(currentNode) : currentNode->select_child_node(searchSettings);
+        }
+        else if (prefillPath.childIdx != uint16_t(-1)) {
+            prepare_prefill_child(currentNode, childIdx);
         }
+        // the memory of the next node is loaded while the current node is updated
+        currentNode->prefetch_child_node(childIdx);
         currentNode->apply_virtual_loss_to_child(childIdx, searchSettings);
         trajectoryBuffer.emplace_back(NodeAndIdx(currentNode, childIdx));
 
         nextNode = currentNode->get_child_node(childIdx);
+        if (nextNode != nullptr) {
+            nextNode->prefetch_statistics();
+        }
         description.depth++;
         if (nextNode == nullptr) {
 #ifdef MCTS_STORE_STATES
-            StateObj* newState = currentNode->get_state()->clone();
+            StateObj* newState;
+            {
+                PHASE_TIMER(phaseTimers, PHASE_STATE_CLONE);
+                newState = currentNode->get_state()->clone();
+            }
 #else
-            newState = unique_ptr<StateObj>(rootState->clone());
+#ifndef MCTS_UNDO_STATES
+            {
+                PHASE_TIMER(phaseTimers, PHASE_STATE_CLONE);
+                newState = unique_ptr<StateObj>(rootState->clone());
+            }
+#endif
             assert(actionsBuffer.size() == description.depth-1);
-            for (Action action : actionsBuffer) {
-                newState->do_action(action);
+#endif
+            {
+                PHASE_TIMER(phaseTimers, PHASE_DO_ACTION);
+#ifndef MCTS_STORE_STATES
+                for (Action action : actionsBuffer) {
+                    newState->do_action(action);
+                }
+#endif
+                newState->do_action(currentNode->get_action(childIdx));
             }
+#ifdef MCTS_UNDO_STATES
+            // the search state is restored to the root state on every return of this branch
+            StateUndoGuard undoGuard{newState.get(), actionsBuffer, currentNode->get_action(childIdx)};
 #endif
-            newState->do_action(currentNode->get_action(childIdx));
-            currentNode->increment_no_visit_idx();
+            if (childIdx + 1 == currentNode->get_no_visit_idx()) {
+                // pruned child nodes are expanded again without extending the range of visited child nodes
+                currentNode->increment_no_visit_idx();
+            }
 #ifdef MCTS_STORE_STATES
             nextNode = add_new_node_to_tree(newState, currentNode, childIdx, description.type);
+#ifdef MCTS_RELEASE_LEAF_STATES
+            // the state of a new leaf is only kept until the leaf is queued, transpositions keep their own state
+            unique_ptr<StateObj> leafState(nextNode->get_state() == newState ? nextNode->release_state().release() : newState);
+#endif
 #else
             nextNode = add_new_node_to_tree(newState.get(), currentNode, childIdx, description.type);
 #endif
@@ -224,14 +376,43 @@ Node* SearchThread::get_new_child_to_evaluate(NodeDescription& description)
                     mapWithMutex->mtx.unlock();
                 }
 #else
-                // fill a new board in the input_planes vector
-                // we shift the index by nbNNInputValues each time
-                newState->get_state_planes(true, inputPlanes + newNodes->size() * nets.front()->get_nb_input_values_total(), nets.front()->get_version());
-                GamePhase currPhase = newState->get_phase(numPhases, searchSettings->gamePhaseDefinition);
-                phaseCountMap[currPhase]++;
+                const Key cacheKey = evalCache != nullptr ? evalCache->get_state_key(*newState) : 0;
+                if (!nextNode->is_tablebase() && newState->number_repetitions() == 0 &&
+                        probe_evaluations(nextNode, *newState, cacheKey, rootState->mirror_policy(newState->side_to_move()))) {
+                    // the position has been evaluated by the neural network before
+#ifdef MCTS_COMPACT_LEAVES
+                    nextNode->compact_leaf();
+#endif
+                    nextNode->enable_has_nn_results();
+                    description.type = NODE_CACHE_HIT;
+                    return nextNode;
+                }
+                bool isDuplicate;
+                const uint32_t batchSlot = get_batch_slot(nextNode, *newState, isDuplicate);
+                newNodeSlots->add_element(batchSlot);
                 // save a reference newly created list in the temporary list for node creation
                 // it will later be updated with the evaluation of the NN
                 newNodeSideToMove->add_element(newState->side_to_move());
+                newNodeCacheKeys->add_element(cacheKey);
+                if (isDuplicate) {
+                    // the result of the first occurrence is shared
+                    description.type = NODE_DUPLICATE;
+                    return nextNode;
+                }
+                // fill a new board in the input_planes vector
+                // we shift the index by nbNNInputValues each time
+                {
+                    PHASE_TIMER(phaseTimers, PHASE_STATE_PLANES);
+                    newState->get_state_planes(true, inputPlanes + batchSlot * nets.front()->get_nb_input_values_total(), nets.front()->get_version());
+                }
+                if (fastNetIndex != NO_FAST_NET) {
+                    // new leaves are evaluated by the fast network and refined once they are visited often enough
+                    slotNetIndices[batchSlot] = fastNetIndex;
+                }
+                else if (nets.size() > 1) {
+                    const GamePhase currPhase = newState->get_phase(numPhases, searchSettings->gamePhaseDefinition);
+                    slotNetIndices[batchSlot] = uint8_t(get_phase_net_index(currPhase));
+                }
 #endif
             }
             return nextNode;
@@ -247,6 +428,8 @@ Node* SearchThread::get_new_child_to_evaluate(NodeDescription& description)
             return nextNode;
         }
         if (nextNode->is_transposition()) {
+            TREE_STATS(TreeStats::increment(treeStats.transpositionChecks));
+            LOCK_DEPTH(description.depth);
             nextNode->lock();
             const uint_fast32_t transposVisits = currentNode->get_real_visits(childIdx);
             const double transposQValue = currentNode->get_transposition_q_value(searchSettings, childIdx, transposVisits);
@@ -265,14 +448,84 @@ Node* SearchThread::get_new_child_to_evaluate(NodeDescription& description)
 #ifndef MCTS_STORE_STATES
         actionsBuffer.emplace_back(currentNode->get_action(childIdx));
 #endif
+#ifdef MCTS_RELEASE_LEAF_STATES
+        materialize_state(currentNode, childIdx, nextNode);
+#endif
+        if (fastNetIndex != NO_FAST_NET && refineCandidate.node == nullptr && nextNode->is_fast_evaluation()) {
+            claim_refinement(nextNode);
+        }
         currentNode = nextNode;
-        childIdx = uint16_t(-1);
+        childIdx = description.depth == 1 ? prefillPath.grandchildIdx : uint16_t(-1);
     }
 }
 
+PrefillPath SearchThread::next_prefill_path()
+{
+    if (prefillIdx == prefillPaths.size() && !prefillChildren.empty() && add_prefill_grandchildren()) {
+        prefillChildren.clear();
+    }
+    if (prefillIdx < prefillPaths.size()) {
+        return prefillPaths[prefillIdx++];
+    }
+    return {uint16_t(-1), uint16_t(-1)};
+}
+
+bool SearchThread::add_prefill_grandchildren()
+{
+    if (searchSettings->rootPrefillTopK == 0) {
+        return true;
+    }
+    vector<Node*> childNodes;
+    rootNode->lock();
+    for (ChildIdx childIdx : prefillChildren) {
+        Node* childNode = rootNode->get_child_node(childIdx);
+        if (childNode != nullptr && !childNode->is_terminal() && !childNode->has_nn_results()) {
+            rootNode->unlock();
+            return false;
+        }
+        childNodes.push_back(childNode);
+    }
+    rootNode->unlock();
+    // the best grandchildren of all children are evaluated first
+    for (ChildIdx grandchildIdx = 0; grandchildIdx < searchSettings->rootPrefillTopK; ++grandchildIdx) {
+        for (size_t idx = 0; idx < prefillChildren.size(); ++idx) {
+            if (childNodes[idx] != nullptr && !childNodes[idx]->is_terminal() && grandchildIdx < childNodes[idx]->get_number_child_nodes()) {
+                prefillPaths.push_back({prefillChildren[idx], grandchildIdx});
+            }
+        }
+    }
+    return true;
+}
+
+void SearchThread::prepare_root_prefill()
+{
+    prefillPaths.clear();
+    prefillChildren.clear();
+    prefillIdx = 0;
+    // the subtree scheduler and the Gumbel root selection distribute the rollouts over the root children themselves
+    if (!searchSettings->rootPrefill || scheduler != nullptr || gumbelRoot != nullptr) {
+        return;
+    }
+    rootNode->lock();
+    const size_t numberChildren = rootNode->get_number_child_nodes();
+    // the relevant children of a reused tree have already been evaluated
+    if (rootNode->get_visits() < numberChildren) {
+        for (size_t childIdx = threadIdx; childIdx < numberChildren; childIdx += searchSettings->threads) {
+            if (childIdx >= rootNode->get_no_visit_idx() || rootNode->get_child_node(childIdx) == nullptr) {
+                prefillPaths.push_back({ChildIdx(childIdx), uint16_t(-1)});
+                prefillChildren.push_back(ChildIdx(childIdx));
+            }
+        }
+    }
+    rootNode->unlock();
+}
+
 void SearchThread::set_root_state(StateObj* value)
 {
     rootState = value;
+#ifdef MCTS_UNDO_STATES
+    newState = unique_ptr<StateObj>(rootState->clone());
+#endif
 }
 
 size_t SearchThread::get_tb_hits() const
@@ -280,45 +533,192 @@ size_t SearchThread::get_tb_hits() const
     return tbHits;
 }
 
+const PhaseTimers& SearchThread::get_phase_timers() const
+{
+    return phaseTimers;
+}
+
+void SearchThread::reset_phase_timers()
+{
+    phaseTimers.reset();
+}
+
+const TreeStats& SearchThread::get_tree_stats() const
+{
+    return treeStats;
+}
+
 void SearchThread::reset_stats()
 {
     tbHits = 0;
     depthMax = 0;
     depthSum = 0;
+    batchController.reset();
+    TREE_STATS(treeStats.reset());
 }
 
-void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutputs, const float* probOutputs, const float* auxiliaryOutputs, Node *node, size_t& tbHits, bool mirrorPolicy, const SearchSettings* searchSettings, bool isRootNodeTB)
+void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutputs, const float* probOutputs, const float* auxiliaryOutputs, Node *node, size_t& tbHits, bool mirrorPolicy, const SearchSettings* searchSettings, bool isRootNodeTB,
+                     size_t gatherStride, EvalCache* evalCache, Key cacheKey)
 {
-    node->set_probabilities_for_moves(get_policy_data_batch(batchIdx, probOutputs, isPolicyMap), mirrorPolicy);
+    if (gatherStride != 0) {
+        node->set_gathered_probabilities(probOutputs + batchIdx * gatherStride);
+    }
+    else {
+        node->set_probabilities_for_moves(get_policy_data_batch(batchIdx, probOutputs, isPolicyMap), mirrorPolicy);
+    }
     node_post_process_policy(node, searchSettings->nodePolicyTemperature, searchSettings);
     node_assign_value(node, valueOutputs, tbHits, batchIdx, isRootNodeTB);
 #ifdef MCTS_STORE_STATES
     node->set_auxiliary_outputs(get_auxiliary_data_batch(batchIdx, auxiliaryOutputs));
+#endif
+    if (evalCache != nullptr) {
+        evalCache->store(node, cacheKey, mirrorPolicy);
+    }
+#ifdef MCTS_COMPACT_LEAVES
+    node->compact_leaf();
 #endif
     node->enable_has_nn_results();
 }
 
 void SearchThread::set_nn_results_to_child_nodes()
 {
-    size_t batchIdx = 0;
+    TRACE_SCOPE("set_nn_results");
+    PHASE_TIMER(phaseTimers, PHASE_SET_NN_RESULTS);
+    const size_t gatherStride = policyGatherValid ? POLICY_GATHER_STRIDE : 0;
+    const bool isFastEvaluation = fastNetIndex != NO_FAST_NET;
+    size_t nodeIdx = 0;
     for (auto node: *newNodes) {
-        fill_nn_results(batchIdx, nets.front()->is_policy_map(), valueOutputs, probOutputs, auxiliaryOutputs, node,
-                        tbHits, rootState->mirror_policy(newNodeSideToMove->get_element(batchIdx)),
-                        searchSettings, rootNode->is_tablebase());
-        ++batchIdx;
+        node->set_fast_evaluation(isFastEvaluation && !node->is_tablebase());
+        // duplicate positions receive the outputs of their shared row, the cache only keeps evaluations of the main network
+        fill_nn_results(newNodeSlots->get_element(nodeIdx), nets.front()->is_policy_map(), valueOutputs, probOutputs, auxiliaryOutputs, node,
+                        tbHits, rootState->mirror_policy(newNodeSideToMove->get_element(nodeIdx)),
+                        searchSettings, rootNode->is_tablebase(), gatherStride, isFastEvaluation ? nullptr : evalCache, newNodeCacheKeys->get_element(nodeIdx));
+        ++nodeIdx;
     }
+    apply_refinements();
+}
+
+void SearchThread::claim_refinement(Node* node)
+{
+    if (numberBatchSlots + 2 > batchSize) {
+        // a row is kept for the leaf of the rollout
+        return;
+    }
+    node->lock();
+    const bool isClaimed = node->is_fast_evaluation() && node->is_sorted() && node->get_real_visits() >= searchSettings->refineVisits;
+    if (isClaimed) {
+        node->set_fast_evaluation(false);
+    }
+    node->unlock();
+    if (!isClaimed) {
+        return;
+    }
+#ifdef MCTS_STORE_STATES
+    unique_ptr<StateObj> refineState(node->get_state()->clone());
+#else
+    unique_ptr<StateObj> refineState(rootState->clone());
+    for (Action action : actionsBuffer) {
+        refineState->do_action(action);
+    }
+#endif
+    refineCandidate = {node, uint32_t(numberBatchSlots++), refineState->side_to_move()};
+    refineCandidateDepth = trajectoryBuffer.size();
+    refineState->get_state_planes(true, inputPlanes + refineCandidate.slot * nets.front()->get_nb_input_values_total(), nets.front()->get_version());
+    slotNetIndices[refineCandidate.slot] = uint8_t(get_phase_net_index(refineState->get_phase(numPhases, searchSettings->gamePhaseDefinition)));
+    if (policyGatherValid) {
+#ifdef MCTS_PARTIAL_SORT
+        // the moves without child nodes may be reordered until the results are applied
+        policyGatherValid = false;
+#else
+        const size_t numberMoves = node->get_number_child_nodes();
+        if (numberMoves > POLICY_GATHER_STRIDE) {
+            policyGatherValid = false;
+            return;
+        }
+        node->fill_policy_indices(policyIndices.data() + refineCandidate.slot * POLICY_GATHER_STRIDE, rootState->mirror_policy(refineCandidate.sideToMove));
+        policyIndexCounts[refineCandidate.slot] = numberMoves;
+#endif
+    }
+}
+
+void SearchThread::finish_refinement(NodeBackup type)
+{
+    if (type == NODE_NEW_NODE || type == NODE_DUPLICATE) {
+        refineRequests.emplace_back(refineCandidate);
+        refineTrajectories.add(TrajectoryView(trajectoryBuffer.data(), refineCandidateDepth));
+    }
+    else {
+        // the rollout didn't add a row after the one of the refinement
+        --numberBatchSlots;
+        refineCandidate.node->lock();
+        refineCandidate.node->set_fast_evaluation(true);
+        refineCandidate.node->unlock();
+    }
+    refineCandidate.node = nullptr;
+}
+
+void SearchThread::apply_refinements()
+{
+    const size_t gatherStride = policyGatherValid ? POLICY_GATHER_STRIDE : 0;
+    for (size_t idx = 0; idx < refineRequests.size(); ++idx) {
+        const RefineRequest& request = refineRequests[idx];
+        Node* node = request.node;
+        node->lock();
+        if (gatherStride != 0) {
+            node->set_gathered_probabilities(probOutputs + request.slot * gatherStride);
+        }
+        else {
+            node->set_probabilities_for_moves(get_policy_data_batch(request.slot, probOutputs, nets.front()->is_policy_map()),
+                                              rootState->mirror_policy(request.sideToMove));
+        }
+        node_post_process_policy(node, searchSettings->nodePolicyTemperature, searchSettings);
+        node->sort_unvisited_moves();
+        float delta = valueOutputs[request.slot] - node->get_fast_value();
+        node->correct_value(delta);
+        node->unlock();
+
+        // the fast evaluation has been backed up through the edges of the trajectory once
+        const TrajectoryView trajectory = refineTrajectories[idx];
+        for (auto it = trajectory.rbegin(); it != trajectory.rend(); ++it) {
+            if (searchSettings->searchPlayerMode == MODE_TWO_PLAYER) {
+                delta = -delta;
+            }
+            it->node->correct_child_value(it->childIdx, delta, searchSettings);
+        }
+    }
+    refineRequests.clear();
+    refineTrajectories.clear();
+}
+
+void SearchThread::reset_new_nodes()
+{
+    newNodeSideToMove->reset_idx();
+    newNodeCacheKeys->reset_idx();
+    newNodeSlots->reset_idx();
+    numberBatchSlots = 0;
 }
 
 void SearchThread::backup_value_outputs()
 {
     backup_values(*newNodes, newTrajectories);
-    newNodeSideToMove->reset_idx();
+    backup_values(*multiVisitNodes, multiVisitTrajectories);
+    reset_new_nodes();
     backup_values(transpositionValues.get(), transpositionTrajectories);
 }
 
 void SearchThread::backup_collisions() {
-    for (size_t idx = 0; idx < collisionTrajectories.size(); ++idx) {
-        backup_collision(searchSettings, collisionTrajectories[idx]);
+    PHASE_TIMER(phaseTimers, PHASE_BACKUP_COLLISIONS);
+    metrics().add(METRIC_COLLISIONS, collisionTrajectories.size());
+    if (searchSettings->batchBackup) {
+        for (size_t idx = 0; idx < collisionTrajectories.size(); ++idx) {
+            batchBackup.add_collision(collisionTrajectories[idx]);
+        }
+        batchBackup.apply(searchSettings);
+    }
+    else {
+        for (size_t idx = 0; idx < collisionTrajectories.size(); ++idx) {
+            backup_collision(searchSettings, collisionTrajectories[idx]);
+        }
     }
     collisionTrajectories.clear();
 }
@@ -346,100 +746,292 @@ size_t SearchThread::get_avg_depth()
 
 void SearchThread::create_mini_batch()
 {
+    TRACE_SCOPE("create_mini_batch");
     // select nodes to add to the mini-batch
     NodeDescription description;
     size_t numTerminalNodes = 0;
+    policyGatherValid = !policyIndices.empty();
+    batchSlotMap.clear();
+    batchLeaves.clear();
 
-    while (!newNodes->is_full() &&
-           collisionTrajectories.size() != searchSettings->batchSize &&
+    const size_t fillTarget = batchController.get_fill_target();
+    while (newNodes->size() < fillTarget &&
+           collisionTrajectories.size() != batchSize &&
+           !multiVisitNodes->is_full() &&
            !transpositionValues->is_full() &&
            numTerminalNodes < terminalNodeCache) {
 
         trajectoryBuffer.clear();
         actionsBuffer.clear();
+        if (scheduler != nullptr && workItem.budget == 0) {
+            // falls back to a rollout from the root node if no item is available
+            scheduler->get_work_item(threadIdx, workItem);
+        }
         Node* newNode = get_new_child_to_evaluate(description);
+        if (refineCandidate.node != nullptr) {
+            finish_refinement(description.type);
+        }
         depthSum += description.depth;
         depthMax = max(depthMax, description.depth);
+        TREE_STATS(treeStats.record_descent(description.depth, description.type == NODE_COLLISION));
 
         if(description.type == NODE_TERMINAL) {
+            TREE_STATS(TreeStats::increment(treeStats.terminals));
             ++numTerminalNodes;
             backup_value<true>(newNode->get_value(), searchSettings, trajectoryBuffer, searchSettings->mctsSolver);
         }
         else if (description.type == NODE_COLLISION) {
-            // store a pointer to the collision node in order to revert the virtual loss of the forward propagation
-            collisionTrajectories.emplace_back(trajectoryBuffer);
+            if (searchSettings->multiVisitCollisions && batchLeaves.count(newNode) != 0) {
+                // the node is evaluated in this mini-batch, so its value is backed up once more instead of reverting the virtual loss
+                multiVisitNodes->add_element(newNode);
+                multiVisitTrajectories.add(trajectoryBuffer);
+            }
+            else {
+                // store a pointer to the collision node in order to revert the virtual loss of the forward propagation
+                collisionTrajectories.add(trajectoryBuffer);
+            }
         }
         else if (description.type == NODE_TRANSPOSITION) {
-            transpositionTrajectories.emplace_back(trajectoryBuffer);
+            TREE_STATS(TreeStats::increment(treeStats.transpositionReturns));
+            transpositionTrajectories.add(trajectoryBuffer);
         }
-        else {  // NODE_NEW_NODE
+        else if (description.type == NODE_CACHE_HIT) {
+            // cache hits are limited like terminals because they don't fill the mini-batch
+            TREE_STATS(TreeStats::increment(treeStats.cacheHits));
+            TREE_STATS(treeStats.record_expansion(description.depth, newNode->get_number_child_nodes()));
+            ++numTerminalNodes;
+            backup_value<false>(newNode->get_value(), searchSettings, trajectoryBuffer, false);
+        }
+        else {  // NODE_NEW_NODE or NODE_DUPLICATE
+            TREE_STATS(treeStats.record_expansion(description.depth, newNode->get_number_child_nodes()));
+            TREE_STATS(TreeStats::increment(treeStats.duplicates, description.type == NODE_DUPLICATE));
+            if (policyGatherValid && description.type == NODE_NEW_NODE) {
+                add_policy_indices(newNode, newNodes->size());
+            }
             newNodes->add_element(newNode);
-            newTrajectories.emplace_back(trajectoryBuffer);
+            newTrajectories.add(trajectoryBuffer);
+            if (searchSettings->multiVisitCollisions) {
+                batchLeaves.insert(newNode);
+            }
         }
     }
 }
 
-size_t SearchThread::select_nn_index()
+Node* SearchThread::get_work_item_node(NodeDescription& description)
 {
-    if (nets.size() == 1) {
-        return 0;
+    trajectoryBuffer = workItem.curTrajectory;
+    for (const NodeAndIdx& nodeAndIdx : workItem.curTrajectory) {
+        actionsBuffer.emplace_back(nodeAndIdx.node->get_action(nodeAndIdx.childIdx));
+#ifdef MCTS_RELEASE_LEAF_STATES
+        materialize_state(nodeAndIdx.node, nodeAndIdx.childIdx, nodeAndIdx.node->get_child_node(nodeAndIdx.childIdx));
+#endif
     }
-    // determine majority class in current batch
-    using pair_type = decltype(phaseCountMap)::value_type;
-    auto pr = std::max_element
-    (
-        std::begin(phaseCountMap), std::end(phaseCountMap),
-        [](const pair_type& p1, const pair_type& p2) {
-            return p1.second < p2.second;
-        }
-    );
+    description.depth = workItem.curTrajectory.size();
+    --workItem.budget;
+    return workItem.node;
+}
 
-    GamePhase majorityPhase = pr->first;
+#ifdef MCTS_RELEASE_LEAF_STATES
+void SearchThread::materialize_state(const Node* parentNode, ChildIdx childIdx, Node* childNode)
+{
+    // a concurrent rollout through a transposition may create the same state
+    childNode->lock();
+    if (childNode->get_state() == nullptr) {
+        PHASE_TIMER(phaseTimers, PHASE_STATE_CLONE);
+        StateObj* childState = parentNode->get_state()->clone();
+        childState->do_action(parentNode->get_action(childIdx));
+        childNode->set_state(childState);
+    }
+    childNode->unlock();
+}
+#endif
+
+void SearchThread::add_policy_indices(const Node* node, size_t nodeIdx)
+{
+    const size_t numberMoves = node->get_number_child_nodes();
+    if (numberMoves > POLICY_GATHER_STRIDE) {
+        // the full policy output is requested for this mini-batch
+        policyGatherValid = false;
+        return;
+    }
+    const size_t batchIdx = newNodeSlots->get_element(nodeIdx);
+    node->fill_policy_indices(policyIndices.data() + batchIdx * POLICY_GATHER_STRIDE,
+                              rootState->mirror_policy(newNodeSideToMove->get_element(nodeIdx)));
+    policyIndexCounts[batchIdx] = numberMoves;
+}
+
+uint32_t SearchThread::get_batch_slot(const Node* node, const StateObj& state, bool& isDuplicate)
+{
+    isDuplicate = false;
+    if (state.number_repetitions() != 0) {
+        // the repetition planes differ from other occurrences of the same position
+        return numberBatchSlots++;
+    }
+    // the plies from null are part of the network input
+    const Key key = node->hash_key() ^ (Key(node->plies_from_null()) * 0x9E3779B97F4A7C15ULL);
+    auto it = batchSlotMap.find(key);
+    if (it != batchSlotMap.end()) {
+        isDuplicate = true;
+        return it->second;
+    }
+    batchSlotMap.emplace(key, numberBatchSlots);
+    return numberBatchSlots++;
+}
 
-    phaseCountMap.clear();
-    return phaseToNetsIndex.at(majorityPhase);
+bool SearchThread::probe_evaluations(Node* node, const StateObj& state, Key cacheKey, bool mirrorPolicy)
+{
+    if (nnBook != nullptr && nnBook->probe(node, state, mirrorPolicy)) {
+        // the book stores the policy before its post-processing
+        node_post_process_policy(node, searchSettings->nodePolicyTemperature, searchSettings);
+        return true;
+    }
+    return evalCache != nullptr && evalCache->probe(node, cacheKey, mirrorPolicy);
 }
 
 void SearchThread::thread_iteration()
 {
     create_mini_batch();
+    TREE_STATS(treeStats.record_batch(newNodes->size(), batchSize));
 #ifndef SEARCH_UCT
+    if (doubleBuffering) {
+        thread_iteration_async();
+        return;
+    }
     if (newNodes->size() != 0) {
-
-        // query the network that corresponds to the majority phase
-        nets[select_nn_index()]->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+        {
+            PHASE_TIMER(phaseTimers, PHASE_PREDICT);
+            // each position is evaluated by the network of its game phase
+            predict_phases_async(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs, slotNetIndices.data(), numberBatchSlots,
+                                 policyGatherValid, policyIndices.data(), policyIndexCounts.data());
+            wait_phases();
+        }
         set_nn_results_to_child_nodes();
     }
+    batchController.update(newNodes->size(), collisionTrajectories.size(), newNodes->size() != 0 ? lastLatencyUS / 1000.0f : 0);
 #endif
     backup_value_outputs();
     backup_collisions();
 }
 
+void SearchThread::swap_batches()
+{
+    swap_buffers();
+    std::swap(newNodes, pendingNodes);
+    std::swap(newNodeSideToMove, pendingNodeSideToMove);
+    std::swap(newNodeCacheKeys, pendingNodeCacheKeys);
+    std::swap(newNodeSlots, pendingNodeSlots);
+    std::swap(numberBatchSlots, pendingNumberBatchSlots);
+    std::swap(slotNetIndices, pendingSlotNetIndices);
+    std::swap(refineRequests, pendingRefineRequests);
+    std::swap(refineTrajectories, pendingRefineTrajectories);
+    std::swap(newTrajectories, pendingTrajectories);
+    std::swap(multiVisitNodes, pendingMultiVisitNodes);
+    std::swap(multiVisitTrajectories, pendingMultiVisitTrajectories);
+}
+
+void SearchThread::thread_iteration_async()
+{
+    // transpositions and collisions don't depend on the neural network and are backpropagated immediately
+    backup_values(transpositionValues.get(), transpositionTrajectories);
+    const size_t numberCollisions = collisionTrajectories.size();
+    backup_collisions();
+
+    {
+        PHASE_TIMER(phaseTimers, PHASE_PREDICT);
+        if (hasPendingBatch) {
+            wait_phases();
+            // the finished mini-batch is swapped into newNodes below
+            batchController.update(pendingNodes->size(), numberCollisions, lastLatencyUS / 1000.0f);
+        }
+        swap_batches();
+        hasPendingBatch = pendingNodes->size() != 0;
+        if (hasPendingBatch) {
+            predict_phases_async(pendingInputPlanes, pendingValueOutputs, pendingProbOutputs, pendingAuxiliaryOutputs, pendingSlotNetIndices.data(),
+                                 pendingNumberBatchSlots, pendingPolicyGatherValid, pendingPolicyIndices.data(), pendingPolicyIndexCounts.data());
+        }
+    }
+    // the finished mini-batch (if any) is now the current one
+    set_nn_results_to_child_nodes();
+    backup_values(*newNodes, newTrajectories);
+    backup_values(*multiVisitNodes, multiVisitTrajectories);
+    reset_new_nodes();
+}
+
+void SearchThread::finish_pending_batch()
+{
+    if (!hasPendingBatch) {
+        return;
+    }
+    {
+        PHASE_TIMER(phaseTimers, PHASE_PREDICT);
+        wait_phases();
+    }
+    swap_batches();
+    hasPendingBatch = false;
+    set_nn_results_to_child_nodes();
+    backup_values(*newNodes, newTrajectories);
+    backup_values(*multiVisitNodes, multiVisitTrajectories);
+    reset_new_nodes();
+}
+
+void SearchThread::release_subtree()
+{
+    release_work_item(searchSettings, workItem);
+}
+
+void SearchThread::sweep_hash_table()
+{
+    mapWithMutex->sweep_expired_entries(HASH_SWEEP_BUCKETS);
+}
+
 void run_search_thread(SearchThread *t)
 {
+    // a partition of the cores between search and inference takes precedence over the NUMA node
+    if (!bind_current_thread_to_cpus(t->get_search_cpus())) {
+        bind_current_thread_to_numa_node(t->get_numa_node());
+    }
+    trace_recorder().set_thread_name("SearchThread");
     t->set_is_running(true);
     t->reset_stats();
+    t->prepare_root_prefill();
     while(t->is_running() && t->nodes_limits_ok() && t->is_root_node_unsolved()) {
         t->thread_iteration();
+        t->sweep_hash_table();
+        t->signal_event();
     }
+    t->finish_pending_batch();
+    t->release_subtree();
     t->set_is_running(false);
+    // node limit, solved root node or stop command
+    t->signal_event();
 }
 
-void SearchThread::backup_values(FixedVector<Node*>& nodes, vector<Trajectory>& trajectories) {
+void SearchThread::backup_values(FixedVector<Node*>& nodes, TrajectoryArena& trajectories) {
+    TRACE_SCOPE("backup_values");
+    PHASE_TIMER(phaseTimers, PHASE_BACKUP_VALUES);
     for (size_t idx = 0; idx < nodes.size(); ++idx) {
         Node* node = nodes.get_element(idx);
 #ifdef MCTS_TB_SUPPORT
         const bool solveForTerminal = searchSettings->mctsSolver && node->is_tablebase();
-        backup_value<false>(node->get_value(), searchSettings, trajectories[idx], solveForTerminal);
 #else
-        backup_value<false>(node->get_value(), searchSettings, trajectories[idx], false);
+        const bool solveForTerminal = false;
 #endif
+        if (searchSettings->batchBackup && !contains_transposition(trajectories[idx])) {
+            batchBackup.add_value(node->get_value(), trajectories[idx], solveForTerminal, searchSettings);
+        }
+        else {
+            backup_value<false>(node->get_value(), searchSettings, trajectories[idx], solveForTerminal);
+        }
+    }
+    if (searchSettings->batchBackup) {
+        batchBackup.apply(searchSettings);
     }
     nodes.reset_idx();
     trajectories.clear();
 }
 
-void SearchThread::backup_values(FixedVector<float>* values, vector<Trajectory>& trajectories) {
+void SearchThread::backup_values(FixedVector<float>* values, TrajectoryArena& trajectories) {
+    PHASE_TIMER(phaseTimers, PHASE_BACKUP_VALUES);
     for (size_t idx = 0; idx < values->size(); ++idx) {
         const float value = values->get_element(idx);
         backup_value<true>(value, searchSettings, trajectories[idx], false);
@@ -494,8 +1086,8 @@ void node_post_process_policy(Node *node, float temperature, const SearchSetting
     node->apply_temperature_to_prior_policy(temperature);
 }
 
-size_t get_random_depth()
+size_t get_random_depth(FastRandom& prng)
 {
-    const int randInt = rand() % 100 + 1;
+    const int randInt = int(prng.bounded(100)) + 1;
     return std::ceil(-std::log2(1 - randInt / 100.0) - 1);
 }
@@ -28,19 +28,40 @@
 #ifndef SEARCHTHREAD_H
 #define SEARCHTHREAD_H
 
+#include <unordered_set>
 #include "node.h"
 #include "constants.h"
 #include "neuralnetapi.h"
 #include "config/searchlimits.h"
 #include "util/fixedvector.h"
 #include "nn/neuralnetapiuser.h"
-
+#include "manager/subtreescheduler.h"
+#include "manager/batchcontroller.h"
+#include "manager/batchbackup.h"
+#include "agents/util/evalcache.h"
+#include "agents/util/nnbook.h"
+#include "agents/util/gumbelroot.h"
+#include "util/phasetimers.h"
+#include "util/treestats.h"
+#include "util/tracerecorder.h"
+#include "util/killablethread.h"
+#include "util/randomgen.h"
+
+
+// the auxiliary outputs of the neural network are only consumed by the states which are stored in the nodes
+#ifdef MCTS_STORE_STATES
+constexpr bool SEARCH_AUXILIARY_OUTPUTS = true;
+#else
+constexpr bool SEARCH_AUXILIARY_OUTPUTS = false;
+#endif
 
 enum NodeBackup : uint8_t {
     NODE_COLLISION,
     NODE_TERMINAL,
     NODE_TRANSPOSITION,
     NODE_NEW_NODE,
+    NODE_DUPLICATE,
+    NODE_CACHE_HIT,
     NODE_UNKNOWN,
 };
 
@@ -51,22 +72,80 @@ struct NodeDescription
     size_t depth;
 };
 
+/**
+ * @brief The RefineRequest struct describes a node which was evaluated by the fast network and is re-evaluated by the main network
+ * in a row of the mini-batch (see SearchSettings::refineVisits)
+ */
+struct RefineRequest
+{
+    Node* node;
+    // row of the network input and output
+    uint32_t slot;
+    SideToMove sideToMove;
+};
+
+/**
+ * @brief The PrefillPath struct describes the first two plies of a rollout of the root prefill (see SearchSettings::rootPrefill)
+ */
+struct PrefillPath
+{
+    ChildIdx childIdx;
+    // uint16_t(-1) if the child node itself is evaluated
+    ChildIdx grandchildIdx;
+};
+
 class SearchThread : public NeuralNetAPIUser
 {
 private:
     Node* rootNode;
     StateObj* rootState;
+    // under MCTS_UNDO_STATES a copy of the root state which is reused for all simulations of the search
     unique_ptr<StateObj> newState;
+    // mini-batch size of the networks of this thread (it may differ between the devices, see Device_Config)
+    const size_t batchSize;
 
     // list of all node objects which have been selected for expansion
     unique_ptr<FixedVector<Node*>> newNodes;
     unique_ptr<FixedVector<SideToMove>> newNodeSideToMove;
-    std::map<GamePhase, size_t> phaseCountMap; // saves counts of all phases in current batch
+    // state keys of the new nodes for the evaluation cache (see EvalCache::get_state_key())
+    unique_ptr<FixedVector<Key>> newNodeCacheKeys;
+    // row of the network input and output for each new node (identical positions share a single row)
+    unique_ptr<FixedVector<uint32_t>> newNodeSlots;
+    size_t numberBatchSlots;
+    // maps the positions of the current mini-batch to their rows
+    unordered_map<Key, uint32_t> batchSlotMap;
+    // network index of the game phase for each row of the current mini-batch
+    vector<uint8_t> slotNetIndices;
     unique_ptr<FixedVector<float>> transpositionValues;
 
-    vector<Trajectory> newTrajectories;
-    vector<Trajectory> transpositionTrajectories;
-    vector<Trajectory> collisionTrajectories;
+    TrajectoryArena newTrajectories;
+    // repeated selections of new nodes of the mini-batch which are backed up with their value (see SearchSettings::multiVisitCollisions)
+    unique_ptr<FixedVector<Node*>> multiVisitNodes;
+    TrajectoryArena multiVisitTrajectories;
+    // new nodes of the mini-batch which is currently collected
+    unordered_set<const Node*> batchLeaves;
+    // nodes of the fast network which are re-evaluated in the current mini-batch and the trajectories to them
+    vector<RefineRequest> refineRequests;
+    TrajectoryArena refineTrajectories;
+    // refinement which has been claimed by the current rollout (its node is a nullptr otherwise) and the length of its trajectory
+    RefineRequest refineCandidate;
+    size_t refineCandidateDepth;
+
+    // mini-batch which is currently evaluated by the neural network when using asynchronous inference
+    unique_ptr<FixedVector<Node*>> pendingNodes;
+    unique_ptr<FixedVector<SideToMove>> pendingNodeSideToMove;
+    unique_ptr<FixedVector<Key>> pendingNodeCacheKeys;
+    unique_ptr<FixedVector<uint32_t>> pendingNodeSlots;
+    size_t pendingNumberBatchSlots;
+    TrajectoryArena pendingTrajectories;
+    unique_ptr<FixedVector<Node*>> pendingMultiVisitNodes;
+    TrajectoryArena pendingMultiVisitTrajectories;
+    vector<uint8_t> pendingSlotNetIndices;
+    vector<RefineRequest> pendingRefineRequests;
+    TrajectoryArena pendingRefineTrajectories;
+    bool hasPendingBatch;
+    TrajectoryArena transpositionTrajectories;
+    TrajectoryArena collisionTrajectories;
 
     Trajectory trajectoryBuffer;
     vector<Action> actionsBuffer;
@@ -82,6 +161,36 @@ private:
     size_t visitsPreSearch;
     uint_fast32_t terminalNodeCache;  // TODO: better add "const" classifier here is possible
     bool reachedTablebases;
+    // NUMA node of the inference device to which the thread is bound during search (NO_NUMA_NODE for no binding)
+    int numaNode;
+    // scheduler which distributes the subtrees (nullptr if every rollout starts at the root node)
+    SubtreeScheduler* scheduler;
+    size_t threadIdx;
+    // subtree of the current rollouts and its remaining budget
+    NodeAndBudget workItem;
+    // cache of former neural network evaluations (nullptr if disabled)
+    EvalCache* evalCache;
+    // network evaluations of the opening positions (nullptr if disabled)
+    const NNBook* nnBook;
+    // sequential halving of the root node (nullptr if the root node uses the PUCT selection)
+    GumbelRoot* gumbelRoot;
+    // thread which is informed after every batch and once the search has ended (nullptr if no thread is waiting)
+    KillableThread* eventListener;
+    // time spent in the main phases of the search (only measured when building with MCTS_PHASE_TIMERS)
+    PhaseTimers phaseTimers;
+    // shape of the tree built since the last reset_stats() call (only recorded when building with MCTS_TREE_STATS)
+    TreeStats treeStats;
+    // number of new nodes which are collected for a mini-batch
+    BatchController batchController;
+    // merged backup of the mini-batch (only used with SearchSettings::batchBackup)
+    BatchBackup batchBackup;
+    // generator for the random exploration, the seed is derived from the base seed by the creation order of the threads
+    FastRandom prng;
+    // rollouts of the root prefill which are started before the regular selection
+    vector<PrefillPath> prefillPaths;
+    size_t prefillIdx;
+    // root children of this thread whose best grandchildren are added to the prefill once the children have been evaluated
+    vector<ChildIdx> prefillChildren;
 public:
     /**
      * @brief SearchThread
@@ -104,6 +213,23 @@ public:
      */
     void thread_iteration();
 
+    /**
+     * @brief finish_pending_batch Waits for the mini-batch which is still evaluated by the neural network and backpropagates its results.
+     * Must be called after the last thread_iteration() when using asynchronous inference.
+     */
+    void finish_pending_batch();
+
+    /**
+     * @brief release_subtree Reverts the virtual loss of the unused budget of the current work item.
+     * Must be called after the last thread_iteration() when using the subtree scheduler.
+     */
+    void release_subtree();
+
+    /**
+     * @brief sweep_hash_table Removes the expired entries of the next HASH_SWEEP_BUCKETS buckets of the hash table (see MapWithMutex::sweep_expired_entries())
+     */
+    void sweep_hash_table();
+
     /**
      * @brief nodes_limits_ok Checks if the searchLimits based on the amount of nodes to search has been reached.
      * In the case the number of nodes is set to zero the limit condition is ignored
@@ -130,6 +256,19 @@ public:
     bool is_running() const;
     void set_is_running(bool value);
     void set_reached_tablebases(bool value);
+    int get_numa_node() const;
+    void set_numa_node(int value);
+    const vector<int>& get_search_cpus() const;
+    void set_scheduler(SubtreeScheduler* value, size_t idx);
+    void set_eval_cache(EvalCache* value);
+    void set_nn_book(const NNBook* value);
+    void set_gumbel_root(GumbelRoot* value);
+    void set_event_listener(KillableThread* value);
+
+    /**
+     * @brief signal_event Informs the event listener that the tree statistics have changed
+     */
+    void signal_event();
 
     /**
      * @brief add_new_node_to_tree Adds a new node to the search by either creating a new node or duplicating an exisiting node in case of transposition usage
@@ -146,6 +285,13 @@ public:
      */
     void reset_stats();
 
+    /**
+     * @brief prepare_root_prefill Assigns every searchSettings->threads-th root child without a child node to this thread if the tree is still small.
+     * These children are evaluated before the first PUCT descent, so the first mini-batches aren't emptied by collisions.
+     * Must be called once at the start of the search.
+     */
+    void prepare_root_prefill();
+
     void set_root_state(StateObj* value);
     size_t get_tb_hits() const;
 
@@ -153,6 +299,17 @@ public:
 
     size_t get_max_depth() const;
 
+    /**
+     * @brief get_phase_timers Returns the time spent in the search phases since the last reset_phase_timers() call
+     */
+    const PhaseTimers& get_phase_timers() const;
+    void reset_phase_timers();
+
+    /**
+     * @brief get_tree_stats Returns the tree statistics of the current or last search (requires MCTS_TREE_STATS)
+     */
+    const TreeStats& get_tree_stats() const;
+
     Node* get_starting_node(Node* currentNode, NodeDescription& description, ChildIdx& childIdx);
 
 private:
@@ -166,6 +323,18 @@ private:
      */
     void backup_value_outputs();
 
+    /**
+     * @brief thread_iteration_async Second part of thread_iteration() for asynchronous inference.
+     * The new mini-batch is sent to the neural network after the former mini-batch has finished
+     * and the results of the former mini-batch are processed while the new one is evaluated.
+     */
+    void thread_iteration_async();
+
+    /**
+     * @brief swap_batches Exchanges the current mini-batch with the pending mini-batch including the network buffers
+     */
+    void swap_batches();
+
     /**
      * @brief backup_collisions Reverts the applied virtual loss for all rollouts which ended in a collision event
      */
@@ -178,8 +347,25 @@ private:
      */
     Node* get_new_child_to_evaluate(NodeDescription& description);
 
-    void backup_values(FixedVector<Node*>& nodes, vector<Trajectory>& trajectories);
-    void backup_values(FixedVector<float>* values, vector<Trajectory>& trajectories);
+    /**
+     * @brief next_prefill_path Returns the next rollout of the root prefill. The grandchildren are added once all prefilled children have been evaluated.
+     * @return Prefill path or uint16_t(-1) as the child index if the regular selection is used
+     */
+    PrefillPath next_prefill_path();
+
+    /**
+     * @brief add_prefill_grandchildren Adds the searchSettings->rootPrefillTopK grandchildren with the highest prior of each prefilled root child
+     * @return False if a prefilled root child is still waiting for its evaluation
+     */
+    bool add_prefill_grandchildren();
+
+    void backup_values(FixedVector<Node*>& nodes, TrajectoryArena& trajectories);
+    void backup_values(FixedVector<float>* values, TrajectoryArena& trajectories);
+
+    /**
+     * @brief reset_new_nodes Clears the side to move and the batch rows of the new nodes after their values have been backpropagated
+     */
+    void reset_new_nodes();
 
     /**
      * @brief select_enhanced_move Selects an enhanced move (e.g. checking move) which has not been explored under given conditions.
@@ -198,16 +384,82 @@ private:
     double get_current_transposition_q_value(const Node* currentNode, ChildIdx childIdx, uint_fast32_t transposVisits);
 
     /**
-     * @brief select_nn_index Returns the index according to the majority phase in the current batch.
-     * If no phases is enabled, 0 will be returned.
-     * @return Majority phase index or 0
+     * @brief add_policy_indices Stores the policy indices of the legal moves of a new node for the gathered policy output.
+     * The gathering is disabled for the current mini-batch if the node has more than POLICY_GATHER_STRIDE legal moves.
+     * @param node Newly expanded node
+     * @param nodeIdx Index of the node in the list of new nodes
+     */
+    void add_policy_indices(const Node* node, size_t nodeIdx);
+
+    /**
+     * @brief get_batch_slot Returns the row of the mini-batch for a new node. A position which is already part of the
+     * current mini-batch reuses its row, otherwise a new row is assigned.
+     * @param node Newly expanded node
+     * @param state State of the new node
+     * @param isDuplicate Returns true if the position is already part of the mini-batch
+     * @return Row index
+     */
+    uint32_t get_batch_slot(const Node* node, const StateObj& state, bool& isDuplicate);
+
+    /**
+     * @brief probe_evaluations Looks up the network outputs of a new node in the NN book and the evaluation cache
+     * @param node Newly expanded node
+     * @param state State of the new node
+     * @param cacheKey State key of the node for the evaluation cache
+     * @param mirrorPolicy Decides if the policy of the node is mirrored
+     * @return True, if the value and policy of the node have been assigned
+     */
+    bool probe_evaluations(Node* node, const StateObj& state, Key cacheKey, bool mirrorPolicy);
+
+    /**
+     * @brief claim_refinement Reserves a row of the mini-batch for the re-evaluation of the given node by the main network
+     * if it was evaluated by the fast network and has reached SearchSettings::refineVisits
+     * @param node Node which is entered by the current rollout, the trajectory and the actions buffer end with the edge to it
+     */
+    void claim_refinement(Node* node);
+
+    /**
+     * @brief finish_refinement Keeps the refinement of the current rollout if the rollout added a position to the mini-batch.
+     * The virtual loss of the rollout then protects the trajectory until the results are applied. Otherwise the refinement is released.
+     * @param type Result of the rollout
+     */
+    void finish_refinement(NodeBackup type);
+
+    /**
+     * @brief apply_refinements Replaces the fast network evaluations of the refined nodes by the outputs of the main network.
+     * The priors are replaced and the difference of the values is corrected along the trajectory to each node.
+     */
+    void apply_refinements();
+
+    /**
+     * @brief get_work_item_node Prepares the trajectory and the actions for a rollout from the subtree of the current work item
+     * and consumes one rollout of its budget
+     * @param description Node description whose depth is set to the depth of the subtree
+     * @return Root node of the subtree
      */
-    size_t select_nn_index();
+    Node* get_work_item_node(NodeDescription& description);
+
+#ifdef MCTS_RELEASE_LEAF_STATES
+    /**
+     * @brief materialize_state Recreates the released state of a child node which is passed by a rollout. The child state is checked and set under the lock of the child node.
+     * @param parentNode Parent node which must own its state
+     * @param childIdx Index of the child node
+     * @param childNode Child node at the given index
+     */
+    void materialize_state(const Node* parentNode, ChildIdx childIdx, Node* childNode);
+#endif
 };
 
 void run_search_thread(SearchThread *t);
 
-void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutputs, const float* probOutputs, const float* auxiliaryOutputs, Node *node, size_t& tbHits, bool mirrorPolicy, const SearchSettings* searchSettings, bool isRootNodeTB);
+/**
+ * @brief fill_nn_results Assigns the network outputs of the given batch index to the node
+ * @param gatherStride Row length of the policy output if it only contains the entries of the legal moves, 0 for the full policy output
+ * @param evalCache Cache in which the results are stored (can be a nullptr)
+ * @param cacheKey State key of the node for the cache (see EvalCache::get_state_key())
+ */
+void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutputs, const float* probOutputs, const float* auxiliaryOutputs, Node *node, size_t& tbHits, bool mirrorPolicy, const SearchSettings* searchSettings, bool isRootNodeTB,
+                     size_t gatherStride=0, EvalCache* evalCache=nullptr, Key cacheKey=0);
 void node_post_process_policy(Node *node, float temperature, const SearchSettings* searchSettings);
 void node_assign_value(Node *node, const float* valueOutputs, size_t& tbHits, size_t batchIdx, bool isRootNodeTB);
 
@@ -215,8 +467,17 @@ void node_assign_value(Node *node, const float* valueOutputs, size_t& tbHits, si
  * @brief random_root_playout Uses random move exploration (epsilon greedy) from the given position. The probability for doing a random move decays by depth.
  * @param currentNode Current node during trajectory
  * @param childIdx Return child index (maybe unchanged)
+ * @param prng Generator of the search thread
+ */
+inline void random_playout(Node* currentNode, ChildIdx& childIdx, FastRandom& prng);
+
+/**
+ * @brief prepare_prefill_child Makes the given child index selectable by extending the range of visited child nodes if necessary.
+ * Must be called while holding the lock of the node.
+ * @param node Node of the rollout
+ * @param childIdx Child index of the prefill
  */
-inline void random_playout(Node* currentNode, ChildIdx& childIdx);
+void prepare_prefill_child(Node* node, ChildIdx childIdx);
 
 /**
  * @brief get_random_depth
@@ -228,8 +489,9 @@ inline void random_playout(Node* currentNode, ChildIdx& childIdx);
  * DEPTH 4: 95 - 97
  * DEPTH 5: 98 - 99
  * DEPTH 6: 100
+ * @param prng Generator of the search thread
  * @return random depth while the probability of choosing higher depths decreases exponetially
  */
-size_t get_random_depth();
+size_t get_random_depth(FastRandom& prng);
 
 #endif // SEARCHTHREAD_H
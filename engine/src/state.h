@@ -408,6 +408,14 @@ public:
      */
     virtual Key hash_key() const = 0;
 
+    /**
+     * @brief colour_symmetric_hash_key Returns a key which is identical for the current position and its colour mirrored counterpart
+     * if both result in the same network input of the given version. The default implementation returns hash_key().
+     * @param version Version of the input representation
+     * @return Key
+     */
+    virtual Key colour_symmetric_hash_key(Version version) const { return hash_key(); }
+
     /**
      * @brief flip Flips the state along the x-axis
      */
@@ -442,6 +450,13 @@ public:
      */
     virtual TerminalType is_terminal(size_t numberLegalMoves, float& customTerminalValue) const = 0;
 
+    /**
+     * @brief is_draw_by_rule Returns true, if the position is a draw for which is_terminal() would return TERMINAL_DRAW independent of the legal moves
+     * (e.g. 3-fold repetition). It allows skipping the move generation for these positions. The default implementation always returns false.
+     * @return bool
+     */
+    virtual bool is_draw_by_rule() const { return false; }
+
     /**
      * @brief gives_check Checks if the current action is a checking move
      * @param action Action
@@ -455,6 +470,13 @@ public:
      */
     virtual void print(std::ostream& os) const = 0;
 
+    /**
+     * @brief could_be_in_tablebase Returns false, if the state can't be found in the loaded tablebases (e.g. because of its number of pieces).
+     * It is checked before the tablebase cache is accessed. The default implementation always returns true.
+     * @return bool
+     */
+    virtual bool could_be_in_tablebase() const { return true; }
+
     /**
      * @brief check_for_tablebase_wdl Checks the current state for a table base entry.
      * Return Tablebase::WDLScoreNone and Tablebase::FAIL if your state doesn't support tablebases.
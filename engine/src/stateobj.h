@@ -30,6 +30,7 @@
 #define STATEOBJ_H
 
 #include <unordered_map>
+#include <type_traits>
 #include <blaze/Math.h>
 #include "state.h"
 #include "constants.h"
@@ -67,6 +68,12 @@ using blaze::DynamicVector;
     using StateConstants = StateConstantsBoard;
 #endif
 
+#ifndef MODE_POMMERMAN
+// the search only uses the concrete state type of the build, so the calls of the state interface are resolved at compile time
+// and can be inlined into the search loop (across translation units with USE_LTO)
+static_assert(std::is_final<StateObj>::value, "The state class of the environment should be declared final.");
+#endif
+
 
 /**
  * @brief get_probs_of_move_list Returns an array in which entry relates to the probability for the given move list.
@@ -0,0 +1,226 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: analysisserver.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#ifndef _WIN32
+#include "analysisserver.h"
+#include <chrono>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "util/communication.h"
+#include "util/positionanalysis.h"
+#include "util/tcpsocket.h"
+
+AnalysisServer::AnalysisServer(int port, const vector<MCTSAgent*>& agents, int variant, bool isChess960, size_t maxNodes):
+    isRunning(true),
+    variant(variant),
+    isChess960(isChess960),
+    maxNodes(maxNodes)
+{
+    for (MCTSAgent* agent : agents) {
+        sessions.emplace_back(make_unique<AnalysisSession>());
+        sessions.back()->agent = agent;
+    }
+    listenFd = listen_on_port(port);
+    acceptThread = thread(&AnalysisServer::accept_connections, this);
+    info_string("analysis server listening on port", port);
+    info_string("analysis server sessions:", sessions.size());
+}
+
+AnalysisServer::~AnalysisServer()
+{
+    isRunning = false;
+    // wakes up the blocking accept()
+    shutdown(listenFd, SHUT_RDWR);
+    acceptThread.join();
+    close(listenFd);
+    {
+        lock_guard<mutex> lock(mtx);
+        for (unique_ptr<AnalysisSession>& session : sessions) {
+            if (session->fd != -1) {
+                // wakes up the blocking recv() and finishes a running search early
+                shutdown(session->fd, SHUT_RDWR);
+                session->agent->stop();
+            }
+        }
+    }
+    for (unique_ptr<AnalysisSession>& session : sessions) {
+        if (session->worker.joinable()) {
+            session->worker.join();
+        }
+    }
+}
+
+size_t AnalysisServer::get_number_active_sessions()
+{
+    lock_guard<mutex> lock(mtx);
+    size_t numberActiveSessions = 0;
+    for (const unique_ptr<AnalysisSession>& session : sessions) {
+        numberActiveSessions += session->fd != -1;
+    }
+    return numberActiveSessions;
+}
+
+void AnalysisServer::accept_connections()
+{
+    while (isRunning) {
+        const int fd = accept(listenFd, nullptr, nullptr);
+        if (!isRunning) {
+            if (fd != -1) {
+                close(fd);
+            }
+            return;
+        }
+        if (fd == -1) {
+            // e.g. the limit of open files has been reached
+            this_thread::sleep_for(chrono::milliseconds(10));
+            continue;
+        }
+        set_no_delay(fd);
+
+        lock_guard<mutex> lock(mtx);
+        AnalysisSession* freeSession = nullptr;
+        for (unique_ptr<AnalysisSession>& session : sessions) {
+            if (session->fd == -1) {
+                freeSession = session.get();
+                break;
+            }
+        }
+        if (freeSession == nullptr) {
+            send_line(fd, "error all analysis sessions are in use");
+            close(fd);
+            continue;
+        }
+        if (freeSession->worker.joinable()) {
+            // the former client has already released the session
+            freeSession->worker.join();
+        }
+        freeSession->fd = fd;
+        freeSession->worker = thread(&AnalysisServer::serve_session, this, freeSession);
+    }
+}
+
+void AnalysisServer::serve_session(AnalysisSession* session)
+{
+    StateObj state;
+    state.set(StateConstants::start_fen(variant), isChess960, variant);
+    // a new client must not see the tree of the former one
+    session->agent->clear_game_history();
+    string pending;
+    string line;
+    while (recv_line(session->fd, pending, line)) {
+        istringstream is(line);
+        string token;
+        is >> skipws >> token;
+        if (token == "quit") {
+            break;
+        }
+        if (token == "") {
+            continue;
+        }
+        if (!send_line(session->fd, execute_command(session, token, is, state))) {
+            break;
+        }
+    }
+    lock_guard<mutex> lock(mtx);
+    close(session->fd);
+    session->fd = -1;
+}
+
+string AnalysisServer::execute_command(AnalysisSession* session, const string& command, istringstream& is, StateObj& state)
+{
+    if (command == "position") {
+        if (!set_position(is, state)) {
+            return "error invalid position";
+        }
+        return "ok";
+    }
+    if (command == "newgame") {
+        session->agent->clear_game_history();
+        state.set(StateConstants::start_fen(variant), isChess960, variant);
+        return "ok";
+    }
+    if (command == "go") {
+        string token;
+        SearchLimits limits;
+        limits.nodes = maxNodes;
+        while (is >> token) {
+            if (token == "nodes") {
+                size_t nodes = 0;
+                is >> nodes;
+                limits.nodes = min(max(nodes, size_t(1)), maxNodes);
+            }
+            else if (token == "movetime") {
+                is >> limits.movetime;
+            }
+        }
+        if (state.legal_actions().empty()) {
+            return "error the position has no legal moves";
+        }
+        limits.startTime = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        EvalInfo evalInfo;
+        session->agent->set_search_settings(&state, &limits, &evalInfo);
+        session->agent->evaluate_board_state();
+        ostringstream json;
+        write_analysis_json(json, AnalysisPosition{"", state.fen(), ""}, evalInfo, evalInfo.calculate_elapsed_time_ms());
+        string reply = json.str();
+        // write_analysis_json terminates the line itself
+        reply.pop_back();
+        return reply;
+    }
+    return "error unknown command " + command;
+}
+
+bool AnalysisServer::set_position(istringstream& is, StateObj& state) const
+{
+    string token, fen;
+    is >> token;
+    if (token == "startpos") {
+        fen = StateConstants::start_fen(variant);
+        is >> token;  // consume "moves" if any
+    }
+    else if (token == "fen") {
+        while (is >> token && token != "moves") {
+            fen += token + " ";
+        }
+        if (fen == "") {
+            return false;
+        }
+        fen.pop_back();
+    }
+    else {
+        return false;
+    }
+    state.set(fen, isChess960, variant);
+    while (is >> token) {
+        const Action action = state.uci_to_action(token);
+        if (action == ACTION_NONE) {
+            return false;
+        }
+        state.do_action(action);
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,118 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: analysisserver.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Multi-session analysis server ("analysisserver" command) which lets many users analyse positions with a single engine process.
+ * Every TCP connection is a session with its own MCTSAgent, search tree and node budget, while all sessions share the loaded networks
+ * and the batched inference server, which fills its batches round robin over the sessions.
+ * The protocol is line based, every command is answered by a single line:
+ * "position [startpos | fen <fen>] [moves <move> ...]" -> "ok"
+ * "go [nodes <n>] [movetime <ms>]" -> JSON line of the evaluation (same format as the "analyse" command)
+ * "newgame" -> "ok", "quit" closes the session. Errors are answered by "error <message>".
+ */
+
+#ifndef ANALYSISSERVER_H
+#define ANALYSISSERVER_H
+
+#ifndef _WIN32
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "agents/mctsagent.h"
+
+/**
+ * @brief The AnalysisSession struct holds the agent and the connection of a single session
+ */
+struct AnalysisSession
+{
+    MCTSAgent* agent = nullptr;
+    // socket of the connected client or -1 if the session is free
+    int fd = -1;
+    thread worker;
+};
+
+class AnalysisServer
+{
+private:
+    vector<unique_ptr<AnalysisSession>> sessions;
+    int listenFd;
+    thread acceptThread;
+    atomic<bool> isRunning;
+    mutex mtx;
+    int variant;
+    bool isChess960;
+    size_t maxNodes;
+
+    /**
+     * @brief accept_connections Assigns every new connection to a free session until the server is stopped
+     */
+    void accept_connections();
+
+    /**
+     * @brief serve_session Executes the commands of a connected client until it quits or disconnects
+     * @param session Session of the client
+     */
+    void serve_session(AnalysisSession* session);
+
+    /**
+     * @brief execute_command Executes a single command of a session
+     * @param session Session of the client
+     * @param command First token of the command line
+     * @param is Remaining arguments of the command line
+     * @param state Current position of the session
+     * @return Reply line without the trailing newline
+     */
+    string execute_command(AnalysisSession* session, const string& command, istringstream& is, StateObj& state);
+
+    /**
+     * @brief set_position Parses the arguments of a "position" command
+     * @param is Command line after the "position" token
+     * @param state Position which is set
+     * @return False if the position or one of its moves couldn't be parsed
+     */
+    bool set_position(istringstream& is, StateObj& state) const;
+
+public:
+    /**
+     * @brief AnalysisServer
+     * @param port Port to listen on
+     * @param agents Agents of the sessions, which must outlive the server. Their number limits the number of concurrent sessions.
+     * @param variant Variant of all sessions
+     * @param isChess960 True for Chess960 castling
+     * @param maxNodes Maximum number of nodes of a single search
+     */
+    AnalysisServer(int port, const vector<MCTSAgent*>& agents, int variant, bool isChess960, size_t maxNodes);
+    ~AnalysisServer();
+    AnalysisServer(const AnalysisServer&) = delete;
+
+    /**
+     * @brief get_number_active_sessions Returns the number of connected clients
+     */
+    size_t get_number_active_sessions();
+};
+#endif
+
+#endif // ANALYSISSERVER_H
@@ -27,6 +27,14 @@
 
 #include <thread>
 #include <fstream>
+#include <future>
+#include <atomic>
+#include <map>
+#include <numeric>
+#include <set>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 #include "mctsagent.h"
 #include "search.h"
 #include "evalinfo.h"
@@ -35,6 +43,26 @@
 #include "optionsuci.h"
 #include "../tests/benchmarkpositions.h"
 #include "util/communication.h"
+#include "util/puctselection.h"
+#include "util/policykernels.h"
+#include "util/tracerecorder.h"
+#include "util/benchmarkreport.h"
+#include "nn/inferencebenchmark.h"
+#include "nn/nullapi.h"
+#include "nn/deferrednetapi.h"
+#include "nn/inferencerecording.h"
+#include "util/perft.h"
+#include "util/tablebaseprober.h"
+#include "util/asyncoutput.h"
+#include "util/memorystats.h"
+#include "util/bufferedfilewriter.h"
+#include "util/devicemonitor.h"
+#include "util/numa.h"
+#include "util/largepages.h"
+#include "agents/util/treeexport.h"
+#include "agents/util/nnbook.h"
+#include "agents/util/rootstatsfeed.h"
+#include "util/positionanalysis.h"
 #if defined(MODE_XIANGQI) || defined(MODE_BOARDGAMES)
 #include "piece.h"
 #endif
@@ -44,6 +72,16 @@
 #include "nn/tensorrtapi.h"
 #elif defined OPENVINO
 #include "nn/openvinoapi.h"
+#elif defined ONNXRUNTIME
+#include "nn/onnxruntimeapi.h"
+#elif defined TORCH
+#include "nn/torchapi.h"
+#elif defined COREML
+#include "nn/coremlapi.h"
+#endif
+#ifdef OPENVINO
+// the OpenVINO back-end also runs the overflow workers of the inference servers of the other back-ends
+#include "nn/openvinoapi.h"
 #endif
 
 
@@ -57,15 +95,23 @@ CrazyAra::CrazyAra():
     searchLimits(SearchLimits()),
     playSettings(PlaySettings()),
     variant(StateConstants::DEFAULT_VARIANT()),
+    isReloadFinished(false),
+    loadedNetworkBytes(0),
     useRawNetwork(false),      // will be initialized in init_search_settings()
     networkLoaded(false),
     ongoingSearch(false),
-    changedUCIoption(false)
+    changedUCIoption(false),
+    positionLatencyMS(0),
+    lastPositionState(nullptr),
+    lastPositionMove(ACTION_NONE)
 {
 }
 
 CrazyAra::~CrazyAra()
 {
+    if (reloadThread.joinable()) {
+        reloadThread.join();
+    }
 }
 
 void CrazyAra::welcome()
@@ -84,6 +130,10 @@ void CrazyAra::uci_loop(int argc, char *argv[])
     for (int i = 1; i < argc; ++i)
         cmd += string(argv[i]) + " ";
 
+    if (Options["Async_Output"]) {
+        start_async_output();
+    }
+
     size_t it = 0;
 
     // this is debug vector which can contain uci commands which will be automatically processed when the executable is launched
@@ -111,6 +161,7 @@ void CrazyAra::uci_loop(int argc, char *argv[])
                  << Options << endl
                  << "uciok" << endl;
         }
+        else if (token == "ponderhit")  ponderhit();
         else if (token == "setoption")  set_uci_option(is, *state.get());
         else if (token == "go")         go(state.get(), is, evalInfo);
         else if (token == "position")   position(state.get(), is);
@@ -120,14 +171,35 @@ void CrazyAra::uci_loop(int argc, char *argv[])
         // Additional custom non-UCI commands, mainly for debugging
         else if (token == "benchmark")  benchmark(is);
         else if (token == "root")       mctsAgent->print_root_node();
+        else if (token == "searchstats") search_stats(is);
+        else if (token == "memstats")   memory_stats_command();
+        else if (token == "perft")      perft(state.get(), is);
+        else if (token == "nnbook")     create_nn_book(state.get(), is);
+        else if (token == "analyse")    analyse(is);
         else if (token == "tree")      export_search_tree(is);
+        else if (token == "savetree")  save_search_tree(is);
+        else if (token == "loadtree")  load_search_tree(state.get(), is);
         else if (token == "flip")       state->flip();
         else if (token == "d")          cout << *(state.get()) << endl;
         else if (token == "activeuci") activeuci();
+        else if (token == "reloadmodel") reload_model(is);
         else if (token == "inference") inference(is);
+        else if (token == "warmup")     warmup();
+        else if (token == "tunecores")  tune_search_cores(is);
+#ifdef __linux__
+        else if (token == "shmserver")  shm_server();
+#endif
+#ifndef _WIN32
+        else if (token == "tcpserver")  tcp_server();
+        else if (token == "analysisserver") analysis_server();
+        else if (token == "distsearch") distributed_search(state.get(), is);
+#endif
 #ifdef USE_RL
         else if (token == "selfplay")   selfplay(is);
         else if (token == "arena")      arena(is);
+#ifndef _WIN32
+        else if (token == "worker")     worker(is);
+#endif
         // Test if the new modes are also usable for chess and others
 
         else if (token == "match")   multimodel_arena(is, "", "", true);
@@ -140,10 +212,12 @@ void CrazyAra::uci_loop(int argc, char *argv[])
     } while (token != "quit" && argc == 1); // Command line args are one-shot
 
     wait_to_finish_last_search();
+    stop_async_output();
 }
 
 void CrazyAra::prepare_search_config_structs()
 {
+    apply_reloaded_model();
     OptionsUCI::init_new_search(searchLimits, Options);
 
     if (changedUCIoption) {
@@ -157,14 +231,35 @@ void CrazyAra::inference(istringstream &is)
 {
     size_t warmupIterations = 100;
     size_t iterations = 3000;
-    string token;
+    vector<unsigned int> batchSizes;
+    vector<string> precisions;
+    string saveFile, token, list;
     while (is >> token) {
         if (token == "warmup") {
             is >> warmupIterations;
         }
-        if (token == "iterations") {
+        else if (token == "iterations") {
             is >> iterations;
         }
+        else if (token == "batch_sizes" && is >> list) {
+            istringstream listStream(list);
+            while (getline(listStream, token, ',')) {
+                batchSizes.emplace_back(stoul(token));
+            }
+        }
+        else if (token == "precisions" && is >> list) {
+            istringstream listStream(list);
+            while (getline(listStream, token, ',')) {
+                precisions.emplace_back(token);
+            }
+        }
+        else if (token == "save") {
+            is >> saveFile;
+        }
+    }
+    if (!batchSizes.empty() || !precisions.empty()) {
+        inference_sweep(batchSizes, precisions, warmupIterations, iterations, saveFile);
+        return;
     }
     info_string("running", warmupIterations, "warmup iteration...");
     info_string("running", iterations, "iterations...");
@@ -180,8 +275,126 @@ void CrazyAra::inference(istringstream &is)
     info_string("Evaluations per second:", (iterations/double(elapsedMS))*1000*searchSettings.batchSize, "nps");
 }
 
+void CrazyAra::inference_sweep(vector<unsigned int> batchSizes, vector<string> precisions, size_t warmupIterations, size_t iterations,
+                               const string& saveFile)
+{
+    const string prevPrecision = string(Options["Precision"]);
+    if (batchSizes.empty()) {
+        batchSizes.emplace_back(searchSettings.batchSize);
+    }
+    if (precisions.empty()) {
+        precisions.emplace_back(prevPrecision);
+    }
+    info_string("sweeping", batchSizes.size() * precisions.size(), "configurations...");
+    print_inference_measurement_header();
+    vector<InferenceMeasurement> measurements;
+    for (const string& precision : precisions) {
+        // the networks read the precision from the options
+        Options["Precision"] = precision;
+        if (string(Options["Precision"]) != precision) {
+            info_string_important("Skipping the precision", precision, "which isn't supported by this build");
+            continue;
+        }
+        for (unsigned int batchSize : batchSizes) {
+            unique_ptr<NeuralNetAPI> net = create_new_net(Options, Options["Model_Directory"], int(Options["First_Device_ID"]), batchSize);
+            measurements.emplace_back(measure_inference(net.get(), warmupIterations, iterations, precision));
+            print_inference_measurement(measurements.back());
+        }
+    }
+    Options["Precision"] = prevPrecision;
+    if (measurements.empty()) {
+        return;
+    }
+
+    // the batch size with the highest throughput which keeps the median latency within twice the latency of the smallest batch
+    const double minLatencyMS = min_element(measurements.begin(), measurements.end(), [](const InferenceMeasurement& a, const InferenceMeasurement& b) {
+        return a.latencyP50MS < b.latencyP50MS; })->latencyP50MS;
+    const InferenceMeasurement* best = nullptr;
+    for (const InferenceMeasurement& measurement : measurements) {
+        const double latencyBudgetMS = max(2 * minLatencyMS, minLatencyMS + 1.0);
+        if (measurement.latencyP50MS <= latencyBudgetMS && (best == nullptr || measurement.throughput > best->throughput)) {
+            best = &measurement;
+        }
+    }
+    info_string("best configuration: precision", best->precision, "batch size " + to_string(best->batchSize));
+    if (saveFile != "") {
+        ofstream file(saveFile, ios_base::trunc);
+        if (!file.is_open()) {
+            info_string_important("Couldn't write the configuration to", saveFile);
+            return;
+        }
+        file << "setoption name Batch_Size value " << best->batchSize << endl
+             << "setoption name Precision value " << best->precision << endl;
+        // the networks of the engine are created again with the new settings at the next "isready"
+        Options["Batch_Size"] = to_string(best->batchSize);
+        Options["Precision"] = best->precision;
+        networkLoaded = false;
+        info_string("configuration written to", saveFile);
+    }
+}
+
+void CrazyAra::tune_search_cores(istringstream& is)
+{
+    size_t moveTimeMS = 1000;
+    is >> moveTimeMS;
+    const size_t numberCores = group_cpus_by_core(get_available_cpus()).size();
+    if (numberCores < 2) {
+        info_string("Partitioning the cores requires at least two physical cores");
+        Options["Search_Cores"] = "0";
+        return;
+    }
+    set<size_t> candidates;
+    for (size_t eighths = 1; eighths < 8; ++eighths) {
+        candidates.insert(min(max(numberCores * eighths / 8, size_t(1)), numberCores - 1));
+    }
+    const string fen = BenchmarkPositions().positions.front().fen;
+    EvalInfo evalInfo;
+    size_t bestCores = 0;
+    double bestNPS = 0;
+    for (size_t searchCores : candidates) {
+        Options["Search_Cores"] = to_string(searchCores);
+        // the agents hold raw pointers to the networks which are replaced
+        mctsAgent.reset();
+        rawAgent.reset();
+        networkLoaded = false;
+        is_ready<false>();
+        mctsAgent->clear_game_history();
+        go(fen, "movetime " + to_string(moveTimeMS), evalInfo);
+        wait_to_finish_last_search();
+        const double nps = evalInfo.calculate_nps();
+        info_string("search cores:", searchCores, "nps: " + to_string(size_t(nps)));
+        if (nps > bestNPS) {
+            bestNPS = nps;
+            bestCores = searchCores;
+        }
+    }
+    Options["Search_Cores"] = to_string(bestCores);
+    mctsAgent.reset();
+    rawAgent.reset();
+    networkLoaded = false;
+    is_ready<false>();
+    info_string("best number of search cores:", bestCores, "of " + to_string(numberCores));
+}
+
+void CrazyAra::warmup()
+{
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    // loading the networks builds all missing engines (compiled models) of the configured devices, batch sizes and inference servers
+    is_ready<false>();
+#ifdef USE_RL
+    if (fs::exists(string(Options["Model_Directory_Contender"]))) {
+        fill_nn_vectors(Options["Model_Directory_Contender"], netSingleContenderVector, netBatchesContenderVector, inferenceServersContender);
+    }
+#endif
+    const chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    info_elapsed_time("warmup finished:", start, end);
+}
+
 void CrazyAra::go(StateObj* state, istringstream &is,  EvalInfo& evalInfo)
 {
+    evalInfo.latency.reset();
+    evalInfo.latency.stageMS[LATENCY_POSITION] = positionLatencyMS;
+    positionLatencyMS = 0;
     wait_to_finish_last_search();
     ongoingSearch = true;
     prepare_search_config_structs();
@@ -199,6 +412,7 @@ void CrazyAra::go(StateObj* state, istringstream &is,  EvalInfo& evalInfo)
         else if (token == "nodes")     is >> searchLimits.nodes;
         else if (token == "movetime")  is >> searchLimits.movetime;
         else if (token == "infinite")  searchLimits.infinite = true;
+        else if (token == "ponder")    searchLimits.ponder = true;
     }
 
     if (useRawNetwork) {
@@ -246,9 +460,17 @@ void CrazyAra::stop_search()
     }
 }
 
+void CrazyAra::ponderhit()
+{
+    if (mctsAgent != nullptr && ongoingSearch) {
+        mctsAgent->ponderhit();
+    }
+}
+
 void CrazyAra::position(StateObj* state, istringstream& is)
 {
     wait_to_finish_last_search();
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
 
     Action action;
     string token, fen;
@@ -268,65 +490,327 @@ void CrazyAra::position(StateObj* state, istringstream& is)
     else
         return;
 
-    state->set(fen, Options["UCI_Chess960"], variant);
+    vector<string> moves;
+    while (is >> token) {
+        moves.push_back(token);
+    }
+    const bool isChess960 = Options["UCI_Chess960"];
+    const string positionStart = fen + " " + to_string(variant) + " " + to_string(isChess960);
+    // GUIs send the full move list with every move, so the moves of the former command are usually still applied to the state
+    const bool extendsLastPosition = state == lastPositionState && positionStart == lastPositionStart &&
+            moves.size() >= lastPositionMoves.size() && equal(lastPositionMoves.begin(), lastPositionMoves.end(), moves.begin()) &&
+            state->fen() == lastPositionFen;
+    size_t moveIdx = 0;
     Action lastMove = ACTION_NONE;
+    if (extendsLastPosition) {
+        moveIdx = lastPositionMoves.size();
+        lastMove = lastPositionMove;
+    }
+    else {
+        state->set(fen, isChess960, variant);
+    }
 
     // Parse move list (if any)
-    while (is >> token && (action = state->uci_to_action(token)) != ACTION_NONE)
+    for (; moveIdx < moves.size() && (action = state->uci_to_action(moves[moveIdx])) != ACTION_NONE; ++moveIdx)
     {
         state->do_action(action);
         lastMove = action;
     }
+    moves.resize(moveIdx);
     // inform the mcts agent of the move, so the tree can potentially be reused later
     if (lastMove != MOVE_NULL && !useRawNetwork) {
         mctsAgent->apply_move_to_tree(lastMove, false);
     }
-    info_string("position", state->fen());
+    lastPositionState = state;
+    lastPositionStart = positionStart;
+    lastPositionMoves = std::move(moves);
+    lastPositionFen = state->fen();
+    lastPositionMove = lastMove;
+    info_string("position", lastPositionFen);
+    positionLatencyMS = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1000.0f;
 }
 
 void CrazyAra::benchmark(istringstream &is)
 {
-    int passedCounter = 0;
-    EvalInfo evalInfo;
+    string suiteFile, jsonFile, token;
+    string budget = "movetime";
+    string budgetValue;
+    size_t warmupRuns = 0;
+    size_t trials = 1;
+    while (is >> token) {
+        if (token == "movetime" || token == "nodes") {
+            budget = token;
+            is >> budgetValue;
+        }
+        else if (token == "suite")  is >> suiteFile;
+        else if (token == "warmup") is >> warmupRuns;
+        else if (token == "trials") is >> trials;
+        else if (token == "json")   is >> jsonFile;
+        // "benchmark <movetime>" of former versions
+        else budgetValue = token;
+    }
     BenchmarkPositions benchmark;
-    string moveTime;
-    is >> moveTime;
-    string goCommand = "go movetime " + moveTime;
-    int totalNPS = 0;
-    int totalDepth = 0;
-    vector<int> nps;
-
-    for (TestPosition pos : benchmark.positions) {
-        go(pos.fen, goCommand, evalInfo);
-        string uciMove = StateConstants::action_to_uci(evalInfo.bestMove, false);
-        if (uciMove != pos.blunderMove) {
-            cout << "passed      -- " << uciMove << " != " << pos.blunderMove << endl;
-            passedCounter++;
+    if (suiteFile != "") {
+        try {
+            benchmark = BenchmarkPositions(suiteFile);
         }
-        else {
-            cout << "failed      -- " << uciMove << " == " << pos.blunderMove << endl;
+        catch (const invalid_argument& e) {
+            info_string_important(e.what());
+            return;
         }
-        cout << "alternative -- ";
-        if (uciMove == pos.alternativeMove) {
-            cout << uciMove << " == " << pos.alternativeMove << endl;
+    }
+    const string goCommand = budgetValue == "" ? benchmark.goCommand : budget + " " + budgetValue;
+    trials = max(trials, size_t(1));
+    ofstream jsonStream;
+    if (jsonFile != "") {
+        jsonStream.open(jsonFile, ios_base::trunc);
+        if (!jsonStream.is_open()) {
+            info_string_important("Couldn't open the benchmark report", jsonFile);
+            return;
         }
-        else {
-            cout << uciMove << " != " << pos.alternativeMove << endl;
+    }
+
+    EvalInfo evalInfo;
+    // the search tree is cleared before each search, so that trials neither depend on their order nor on tree reuse
+    for (size_t idx = 0; idx < warmupRuns; ++idx) {
+        if (mctsAgent != nullptr) {
+            mctsAgent->clear_game_history();
         }
-        const int cur_nps = evalInfo.calculate_nps();
-        totalNPS += cur_nps;
-        totalDepth += evalInfo.depth;
-        nps.push_back(cur_nps);
+        go(benchmark.positions[idx % benchmark.positions.size()].fen, goCommand, evalInfo);
+        wait_to_finish_last_search();
     }
 
-    sort(nps.begin(), nps.end());
+    vector<BenchmarkRun> runs;
+    vector<string> fens;
+    device_monitor().reset_averages();
+    for (size_t positionIdx = 0; positionIdx < benchmark.positions.size(); ++positionIdx) {
+        const TestPosition& pos = benchmark.positions[positionIdx];
+        fens.emplace_back(pos.fen);
+        for (size_t trial = 0; trial < trials; ++trial) {
+            if (mctsAgent != nullptr) {
+                mctsAgent->clear_game_history();
+            }
+            go(pos.fen, goCommand, evalInfo);
+            wait_to_finish_last_search();
+            const string uciMove = StateConstants::action_to_uci(evalInfo.bestMove, false);
+            const bool passed = uciMove != pos.blunderMove && (suiteFile == "" || pos.alternativeMove == "" || uciMove == pos.alternativeMove);
+            runs.push_back({positionIdx, trial, evalInfo.nodes, evalInfo.calculate_nps(), evalInfo.calculate_elapsed_time_ms(),
+                            evalInfo.depth, evalInfo.selDepth, uciMove, passed});
+            cout << (passed ? "passed" : "failed") << "      -- " << uciMove << " (avoid: " << pos.blunderMove
+                 << ", best: " << pos.alternativeMove << ")" << endl;
+        }
+    }
 
+    vector<double> nps, elapsedTimeMS, depth;
+    size_t passedCounter = 0;
+    for (const BenchmarkRun& run : runs) {
+        nps.emplace_back(run.nps);
+        elapsedTimeMS.emplace_back(run.elapsedTimeMS);
+        depth.emplace_back(run.depth);
+        passedCounter += run.passed;
+    }
     cout << endl << "Summary" << endl;
     cout << "----------------------" << endl;
-    cout << "Passed:\t\t" << passedCounter << "/" << benchmark.positions.size() << endl;
-    cout << "NPS (avg):\t" << setw(2) << totalNPS /  benchmark.positions.size() << endl;
-    cout << "NPS (median):\t" << setw(2) << nps[nps.size()/2] << endl;
-    cout << "PV-Depth:\t" << setw(2) << totalDepth /  benchmark.positions.size() << endl;
+    cout << "Passed:\t\t" << passedCounter << "/" << runs.size() << endl;
+    cout << "NPS (avg):\t" << setw(2) << size_t(accumulate(nps.begin(), nps.end(), 0.0) / runs.size()) << endl;
+    cout << "NPS (median):\t" << setw(2) << size_t(percentile(nps, 0.5)) << endl;
+    cout << "NPS (p10/p90):\t" << size_t(percentile(nps, 0.1)) << " / " << size_t(percentile(nps, 0.9)) << endl;
+    cout << "Time ms (p50/p99):\t" << size_t(percentile(elapsedTimeMS, 0.5)) << " / " << size_t(percentile(elapsedTimeMS, 0.99)) << endl;
+    cout << "PV-Depth:\t" << setw(2) << size_t(accumulate(depth.begin(), depth.end(), 0.0) / runs.size()) << endl;
+    const vector<DeviceSample> deviceSamples = device_monitor().get_average_samples();
+    if (!deviceSamples.empty()) {
+        cout << "Devices (avg):" << endl << device_samples_report(deviceSamples);
+    }
+
+    if (jsonStream.is_open()) {
+        const BenchmarkConfig config = {engineName + " " + engineVersion, suiteFile == "" ? "builtin" : suiteFile, "go " + goCommand,
+                                        warmupRuns, trials, size_t(searchSettings.threads), size_t(searchSettings.batchSize),
+                                        netSingleVector.empty() ? "" : netSingleVector.front()->get_device_name(),
+                                        netSingleVector.empty() ? "" : netSingleVector.front()->get_model_name(), deviceSamples};
+        write_benchmark_json(jsonStream, config, fens, runs);
+        info_string("benchmark report written to", jsonFile);
+    }
+}
+
+void CrazyAra::analyse(istringstream &is)
+{
+    string inputFile, outputFile, token;
+    size_t nodes = 1;
+    is >> inputFile >> nodes;
+    while (is >> token) {
+        if (token == "out") is >> outputFile;
+    }
+    if (inputFile == "") {
+        info_string_important("Usage: analyse <file.epd|file.pgn> <nodes> [out <file.jsonl>]");
+        return;
+    }
+    wait_to_finish_last_search();
+    is_ready<false>();
+    prepare_search_config_structs();
+
+    vector<AnalysisPosition> positions;
+    try {
+        positions = read_analysis_positions(inputFile, variant, Options["UCI_Chess960"]);
+    }
+    catch (const invalid_argument& e) {
+        info_string_important(e.what());
+        return;
+    }
+    if (positions.empty()) {
+        info_string_important("The given file doesn't contain any position", inputFile);
+        return;
+    }
+    ofstream outputStream;
+    if (outputFile != "") {
+        outputStream.open(outputFile, ios_base::trunc);
+        if (!outputStream.is_open()) {
+            info_string_important("Couldn't open the analysis output", outputFile);
+            return;
+        }
+    }
+    ostream& os = outputStream.is_open() ? outputStream : cout;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (nodes <= 1) {
+        // a single network evaluation per position: the positions are batched directly without any search
+        const size_t chunkSize = 4096;
+        for (size_t offset = 0; offset < positions.size(); offset += chunkSize) {
+            const size_t chunkEnd = min(positions.size(), offset + chunkSize);
+            vector<unique_ptr<StateObj>> states;
+            for (size_t idx = offset; idx < chunkEnd; ++idx) {
+                states.emplace_back(make_unique<StateObj>());
+                states.back()->set(positions[idx].fen, Options["UCI_Chess960"], variant);
+            }
+            const chrono::steady_clock::time_point chunkStart = chrono::steady_clock::now();
+            vector<EvalInfo> evalInfos;
+            evaluate_states(states, evalInfos);
+            const size_t elapsedTimeMS = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - chunkStart).count();
+            for (size_t idx = offset; idx < chunkEnd; ++idx) {
+                write_analysis_json(os, positions[idx], evalInfos[idx - offset], elapsedTimeMS / states.size());
+            }
+        }
+    }
+    else {
+        // the additional agents share the batched inference servers of the main agent
+        vector<MCTSAgent*> agents = {mctsAgent.get()};
+        ClientAgents clientAgents;
+        const size_t numberAdditionalAgents = min(size_t(int(Options["Analysis_Concurrent_Positions"])), positions.size()) - 1;
+        if (numberAdditionalAgents > 0) {
+            try {
+                create_client_mcts_agents(netBatchesVector, numberAdditionalAgents, MCTSAgentType::kDefault, clientAgents);
+            }
+            catch (const invalid_argument& e) {
+                info_string(e.what());
+                info_string("The positions are analysed one after another. Load the networks with an inference server to analyse them concurrently.");
+            }
+        }
+        for (unique_ptr<MCTSAgent>& agent : clientAgents.agents) {
+            agents.push_back(agent.get());
+        }
+
+        atomic<size_t> nextPositionIdx(0);
+        mutex outputMutex;
+        auto analyse_positions = [&](MCTSAgent* agent) {
+            StateObj state;
+            SearchLimits limits;
+            limits.nodes = nodes;
+            EvalInfo evalInfo;
+            for (size_t idx = nextPositionIdx++; idx < positions.size(); idx = nextPositionIdx++) {
+                state.set(positions[idx].fen, Options["UCI_Chess960"], variant);
+                // the positions are unrelated, so neither the tree nor the repetition history is reused
+                agent->clear_game_history();
+                agent->set_search_settings(&state, &limits, &evalInfo);
+                agent->evaluate_board_state();
+                lock_guard<mutex> lock(outputMutex);
+                write_analysis_json(os, positions[idx], evalInfo, evalInfo.calculate_elapsed_time_ms());
+            }
+        };
+        vector<thread> workers;
+        for (MCTSAgent* agent : agents) {
+            workers.emplace_back(analyse_positions, agent);
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+    const chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    info_string("analysed positions:", positions.size());
+    info_elapsed_time("analysis finished:", start, end);
+}
+
+void CrazyAra::set_option(const string& name, const string& value)
+{
+    istringstream is("name " + name + " value " + value);
+    StateObj state;
+    set_uci_option(is, state);
+}
+
+MCTSAgent* CrazyAra::get_mcts_agent()
+{
+    is_ready<false>();
+    // the settings of the agent are updated with the changed options
+    prepare_search_config_structs();
+    return mctsAgent.get();
+}
+
+RawNetAgent* CrazyAra::get_raw_agent()
+{
+    is_ready<false>();
+    prepare_search_config_structs();
+    return rawAgent.get();
+}
+
+void CrazyAra::evaluate_states(const vector<unique_ptr<StateObj>>& states, vector<EvalInfo>& evalInfos)
+{
+    is_ready<false>();
+    prepare_search_config_structs();
+    RawNetAgent batchAgent(netBatchesVector.empty() ? netSingleVector : netBatchesVector.front(), &playSettings, false, &searchSettings);
+    batchAgent.evaluate_states(states, evalInfos);
+}
+
+int CrazyAra::get_variant() const
+{
+    return StateConstants::variant_to_int(Options["UCI_Variant"]);
+}
+
+void CrazyAra::perft(const StateObj* state, istringstream &is)
+{
+    size_t depth = 1;
+    size_t threads = 1;
+    string token;
+    is >> depth;
+    while (is >> token) {
+        if (token == "threads") {
+            is >> threads;
+        }
+    }
+    const PerftResult result = run_perft(state, max(depth, size_t(1)), max(threads, size_t(1)));
+    for (size_t idx = 0; idx < result.rootActions.size(); ++idx) {
+        cout << StateConstants::action_to_uci(result.rootActions[idx], state->is_chess960()) << ": " << result.rootNodes[idx] << endl;
+    }
+    cout << endl << "Nodes searched: " << result.nodes << endl
+         << "Time (ms):      " << result.elapsedTimeMS << endl
+         << "Nodes/second:   " << result.nps() << endl;
+}
+
+void CrazyAra::create_nn_book(const StateObj* state, istringstream& is)
+{
+    size_t plies = 4;
+    string filePath = "nnbook.bin";
+    is >> plies;
+    is >> filePath;
+    is_ready<false>();
+    prepare_search_config_structs();
+    const vector<unique_ptr<NeuralNetAPI>>& nets = netBatchesVector.empty() ? netSingleVector : netBatchesVector.front();
+    string modelNames;
+    for (const unique_ptr<NeuralNetAPI>& net : nets) {
+        modelNames += net->get_model_name();
+    }
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    NNBookGenerator generator(nets, &searchSettings);
+    const size_t numberPositions = generator.create(state, plies, filePath, modelNames);
+    const size_t elapsedMS = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    info_string("Wrote", numberPositions, "positions to the nn book", filePath, "in", elapsedMS / 1000.0, "s");
 }
 
 void CrazyAra::export_search_tree(istringstream &is)
@@ -334,15 +818,76 @@ void CrazyAra::export_search_tree(istringstream &is)
     string depth, filename;
     is >> depth;
     is >> filename;
-    if (depth == "") {
-        mctsAgent->export_search_tree(2, "tree.gv");
-        return;
+    if (filename == "") {
+        filename = "tree.gv";
+    }
+    try {
+        // the binary export throws if the file can't be written
+        mctsAgent->export_search_tree(depth == "" ? 2 : std::stoi(depth), filename);
+    }
+    catch (const exception& e) {
+        info_string_important(e.what());
+    }
+}
+
+void CrazyAra::save_search_tree(istringstream& is)
+{
+    wait_to_finish_last_search();
+    string filename;
+    is >> filename;
+    if (filename == "") {
+        filename = "tree.snapshot";
+    }
+    try {
+        mctsAgent->save_search_tree(filename);
+    }
+    catch (const exception& e) {
+        info_string_important(e.what());
     }
+}
+
+void CrazyAra::load_search_tree(StateObj* state, istringstream& is)
+{
+    wait_to_finish_last_search();
+    string filename;
+    is >> filename;
     if (filename == "") {
-        mctsAgent->export_search_tree(std::stoi(depth), "tree.gv");
+        filename = "tree.snapshot";
+    }
+    try {
+        const TreeSnapshot snapshot(filename);
+        variant = StateConstants::variant_to_int(Options["UCI_Variant"]);
+        state->set(snapshot.get_fen(), Options["UCI_Chess960"], variant);
+        mctsAgent->load_search_tree(snapshot, state);
+        info_string("position", state->fen());
+    }
+    catch (const exception& e) {
+        info_string_important(e.what());
+    }
+}
+
+void CrazyAra::search_stats(istringstream& is)
+{
+    if (mctsAgent == nullptr) {
+        info_string("You must load the network before you can print the search statistics");
+        return;
+    }
+    string token;
+    is >> token;
+    if (token == "reset") {
+        mctsAgent->reset_search_stats();
         return;
     }
-    mctsAgent->export_search_tree(std::stoi(depth), filename);
+    mctsAgent->print_search_stats();
+}
+
+void CrazyAra::memory_stats_command()
+{
+    cout << memory_stats_report() << endl;
+    if (mctsAgent != nullptr) {
+        cout << "tree nodes      " << setw(12) << (mctsAgent->rootNode == nullptr ? 0 : mctsAgent->rootNode->get_node_count()) << endl
+             << "hash entries    " << setw(12) << mctsAgent->mapWithMutex.size() << endl;
+    }
 }
 
 void CrazyAra::activeuci()
@@ -352,37 +897,282 @@ void CrazyAra::activeuci()
     cout << "readyok" << endl;
 }
 
+void CrazyAra::reload_model(istringstream& is)
+{
+    string modelDirectory;
+    getline(is >> ws, modelDirectory);
+    if (modelDirectory == "") {
+        modelDirectory = string(Options["Model_Directory"]);
+    }
+    if (!networkLoaded) {
+        // the networks are loaded by the next "isready"
+        Options["Model_Directory"] = modelDirectory;
+        return;
+    }
+    if (reloadThread.joinable()) {
+        // replaces a previous reload which hasn't been applied yet
+        reloadThread.join();
+    }
+    reloadNetSingleVector.clear();
+    reloadNetBatchesVector.clear();
+    reloadInferenceServers.clear();
+    reloadModelDirectory = modelDirectory;
+    reloadError.clear();
+    isReloadFinished = false;
+    info_string("loading model in the background from", modelDirectory);
+    reloadThread = thread([this]() {
+        try {
+            fill_nn_vectors(reloadModelDirectory, reloadNetSingleVector, reloadNetBatchesVector, reloadInferenceServers);
+        }
+        catch (const exception& e) {
+            reloadError = e.what();
+        }
+        isReloadFinished = true;
+    });
+}
+
+void CrazyAra::apply_reloaded_model(bool waitForReload)
+{
+    if (!reloadThread.joinable() || (!isReloadFinished && !waitForReload)) {
+        return;
+    }
+    reloadThread.join();
+    if (reloadError != "") {
+        info_string_important("Reloading the model from", reloadModelDirectory, "failed:", reloadError);
+        reloadNetSingleVector.clear();
+        reloadNetBatchesVector.clear();
+        reloadInferenceServers.clear();
+        return;
+    }
+    // the agents hold raw pointers to the networks, the clients of the old inference servers are released before their servers
+    mctsAgent.reset();
+    rawAgent.reset();
+    netSingleVector = std::move(reloadNetSingleVector);
+    netBatchesVector = std::move(reloadNetBatchesVector);
+    inferenceServers = std::move(reloadInferenceServers);
+    Options["Model_Directory"] = reloadModelDirectory;
+    // the cached networks of the directory are outdated now
+    networkCache.clear();
+#ifdef USE_RL
+    quickNetworkKey = "";
+#endif
+    loadedNetworkKey = get_network_cache_key();
+
+    mctsAgent = create_new_mcts_agent(netSingleVector, netBatchesVector, &searchSettings, get_mcts_agent_type());
+    rawAgent = make_unique<RawNetAgent>(netSingleVector, &playSettings, false, &searchSettings);
+    StateConstants::init(mctsAgent->is_policy_map(), Options["UCI_Chess960"]);
+    info_string("swapped in model from", reloadModelDirectory);
+}
+
 #ifdef USE_RL
 void CrazyAra::selfplay(istringstream &is)
 {
-    prepare_search_config_structs();
-    SelfPlay selfPlay(rawAgent.get(), mctsAgent.get(), &searchSettings, &searchLimits, &playSettings, &rlSettings, Options);
     size_t numberOfGames;
     is >> numberOfGames;
-    selfPlay.go(numberOfGames, variant);
+    run_selfplay(numberOfGames);
     cout << "readyok" << endl;
 }
 
-void CrazyAra::arena(istringstream &is)
+void CrazyAra::run_selfplay(size_t numberOfGames)
 {
+    // the games of a generation must be generated by its own network
+    apply_reloaded_model(true);
     prepare_search_config_structs();
     SelfPlay selfPlay(rawAgent.get(), mctsAgent.get(), &searchSettings, &searchLimits, &playSettings, &rlSettings, Options);
-    fill_nn_vectors(Options["Model_Directory_Contender"], netSingleContenderVector, netBatchesContenderVector);
-    mctsAgentContender = create_new_mcts_agent(netSingleContenderVector, netBatchesContenderVector, &searchSettings);
+
+    // every additional game uses its own agent and search settings but the inference servers of the main agent
+    const size_t numberAdditionalGames = rlSettings.concurrentGames - 1;
+    ClientAgents gameAgents;
+    create_client_mcts_agents(netBatchesVector, numberAdditionalGames, MCTSAgentType::kDefault, gameAgents);
+    vector<MCTSAgent*> concurrentAgents;
+    for (const unique_ptr<MCTSAgent>& agent : gameAgents.agents) {
+        concurrentAgents.push_back(agent.get());
+    }
+    if (numberAdditionalGames != 0) {
+        info_string("generating", rlSettings.concurrentGames, "games concurrently");
+    }
+
+    // the quick searches are done by agents with their own networks whose batch size suits the small trees
+    unique_ptr<MCTSAgent> quickAgent;
+    ClientAgents quickGameAgents;
+    vector<MCTSAgent*> quickAgents;
+    if (rlSettings.quickSearchProbability > 0 && load_quick_networks()) {
+        quickAgent = create_new_mcts_agent(quickNetSingleVector, quickNetBatchesVector, &quickSearchSettings);
+        create_client_mcts_agents(quickNetBatchesVector, numberAdditionalGames, MCTSAgentType::kDefault, quickGameAgents, &quickSearchSettings);
+        quickAgents.push_back(quickAgent.get());
+        for (const unique_ptr<MCTSAgent>& agent : quickGameAgents.agents) {
+            quickAgents.push_back(agent.get());
+        }
+        info_string("quick searches with batch size", quickSearchSettings.batchSize, "and", quickSearchSettings.threads, "threads");
+    }
+    selfPlay.go(numberOfGames, variant, concurrentAgents, quickAgents);
+}
+
+bool CrazyAra::load_quick_networks()
+{
+    const int quickBatchSize = Options["Quick_Batch_Size"];
+    if (quickBatchSize == 0) {
+        return false;
+    }
+    const string prevBatchSize = to_string(int(Options["Batch_Size"]));
+    const string prevThreads = to_string(int(Options["Threads"]));
+    const unsigned int prevSearchBatchSize = searchSettings.batchSize;
+    // the networks read the batch size and the number of threads from the options, an explicit Device_Config keeps its own values
+    Options["Batch_Size"] = to_string(quickBatchSize);
+    if (int(Options["Quick_Threads"]) != 0) {
+        Options["Threads"] = to_string(int(Options["Quick_Threads"]));
+    }
+    searchSettings.batchSize = quickBatchSize;
+    quickSearchSettings = searchSettings;
+    quickSearchSettings.threads = get_num_search_threads(Options);
+    quickSearchSettings.minBatchSize = min(quickSearchSettings.minBatchSize, quickSearchSettings.batchSize);
+    const string key = get_network_cache_key();
+    try {
+        if (key != quickNetworkKey) {
+            quickNetworkKey = "";
+            fill_nn_vectors(Options["Model_Directory"], quickNetSingleVector, quickNetBatchesVector, quickInferenceServers);
+            quickNetworkKey = key;
+        }
+    }
+    catch (...) {
+        Options["Batch_Size"] = prevBatchSize;
+        Options["Threads"] = prevThreads;
+        searchSettings.batchSize = prevSearchBatchSize;
+        throw;
+    }
+    Options["Batch_Size"] = prevBatchSize;
+    Options["Threads"] = prevThreads;
+    searchSettings.batchSize = prevSearchBatchSize;
+    return true;
+}
+
+void CrazyAra::arena(istringstream &is)
+{
     size_t numberOfGames;
     is >> numberOfGames;
-    TournamentResult tournamentResult = selfPlay.go_arena(mctsAgentContender.get(), numberOfGames, variant);
+    bool replace;
+    const TournamentResult tournamentResult = run_arena(numberOfGames, replace);
 
     cout << "Arena summary" << endl;
     cout << "Score of Contender vs Producer: " << tournamentResult << endl;
-    if (tournamentResult.score() > 0.5f) {
+    if (replace) {
         cout << "replace" << endl;
     }
     else {
         cout << "keep" << endl;
     }
+}
+
+TournamentResult CrazyAra::run_arena(size_t numberOfGames, bool& replace)
+{
+    // the contender must play against the current network
+    apply_reloaded_model(true);
+    prepare_search_config_structs();
+    SelfPlay selfPlay(rawAgent.get(), mctsAgent.get(), &searchSettings, &searchLimits, &playSettings, &rlSettings, Options);
+    fill_nn_vectors(Options["Model_Directory_Contender"], netSingleContenderVector, netBatchesContenderVector, inferenceServersContender);
+    mctsAgentContender = create_new_mcts_agent(netSingleContenderVector, netBatchesContenderVector, &searchSettings);
+
+    // the additional game pairs share the inference servers of the producer and the contender
+    const size_t numberAdditionalPairs = rlSettings.concurrentGames - 1;
+    ClientAgents producerAgents;
+    ClientAgents contenderAgents;
+    create_client_mcts_agents(netBatchesVector, numberAdditionalPairs, MCTSAgentType::kDefault, producerAgents);
+    create_client_mcts_agents(netBatchesContenderVector, numberAdditionalPairs, MCTSAgentType::kDefault, contenderAgents);
+    vector<pair<MCTSAgent*, MCTSAgent*>> concurrentAgents;
+    for (size_t idx = 0; idx < numberAdditionalPairs; ++idx) {
+        concurrentAgents.emplace_back(producerAgents.agents[idx].get(), contenderAgents.agents[idx].get());
+    }
+    TournamentResult tournamentResult = selfPlay.go_arena(mctsAgentContender.get(), numberOfGames, variant, concurrentAgents);
+
+    const SPRTDecision decision = rlSettings.arenaSPRT ? sprt_decision(tournamentResult, rlSettings.sprtElo0, rlSettings.sprtElo1, rlSettings.sprtAlpha, rlSettings.sprtBeta) : SPRT_CONTINUE;
+    replace = decision == SPRT_H1 || (decision == SPRT_CONTINUE && tournamentResult.score() > 0.5f);
     write_tournament_result_to_csv(tournamentResult, "arena_results.csv");
+    return tournamentResult;
+}
+
+#ifndef _WIN32
+void CrazyAra::worker(istringstream &is)
+{
+    string address;
+    is >> address;
+    if (address == "") {
+        address = string(Options["Selfplay_Coordinator_Address"]);
+    }
+    if (address == "<empty>") {
+        info_string_important("Error: No coordinator address was given (worker <host>:<port> or Selfplay_Coordinator_Address).");
+        return;
+    }
+    if (!is_ready<false>()) {
+        return;
+    }
+    char hostName[256] = "";
+    gethostname(hostName, sizeof(hostName) - 1);
+    CoordinatorClient client(address, string("register ") + hostName + "-" + mctsAgent->get_device_name() + " " + string(Options["UCI_Variant"]));
+    client.connect_to_coordinator();
+
+    StateObj state;
+    string line;
+    while (true) {
+        if (!client.read_line(line)) {
+            info_string_important("Warning: The connection to the coordinator", address, "has been lost.");
+            client.connect_to_coordinator();
+            continue;
+        }
+        istringstream cmd(line);
+        string token;
+        cmd >> skipws >> token;
+        if (token == "quit") {
+            break;
+        }
+        if (token == "") {
+            continue;
+        }
+        // a lost acknowledgement is detected by the next read
+        client.send_line(execute_worker_job(token, cmd, state));
+    }
+    info_string("the coordinator finished the worker");
+}
+
+string CrazyAra::execute_worker_job(const string& token, istringstream& is, StateObj& state)
+{
+    try {
+        if (token == "setoption") {
+            set_uci_option(is, state);
+            return "done setoption";
+        }
+        if (token == "reloadmodel") {
+            // the model is swapped in before the next job, the current one continues with the former networks
+            reload_model(is);
+            return "done reloadmodel";
+        }
+        if (token == "selfplay") {
+            size_t numberOfGames = 1;
+            is >> numberOfGames;
+            is_ready<false>();
+            run_selfplay(numberOfGames);
+            return "done selfplay " + to_string(numberOfGames) + " " + string(Options["Model_Directory"]);
+        }
+        if (token == "arena") {
+            size_t numberOfGames = 1;
+            string contenderDirectory;
+            is >> numberOfGames >> contenderDirectory;
+            if (contenderDirectory != "") {
+                Options["Model_Directory_Contender"] = contenderDirectory;
+            }
+            is_ready<false>();
+            bool replace;
+            const TournamentResult result = run_arena(numberOfGames, replace);
+            return "arena " + to_string(result.numberWins) + " " + to_string(result.numberDraws) + " " + to_string(result.numberLosses)
+                    + (replace ? " replace" : " keep");
+        }
+    }
+    catch (const exception& e) {
+        info_string_important("Error: The job", token, "failed:", e.what());
+        return "error " + token + " " + e.what();
+    }
+    return "error unknown command " + token;
 }
+#endif
 
 void CrazyAra::multimodel_arena(istringstream &is, const string &modelDirectory1, const string &modelDirectory2, bool isModelInInputStream)
 {
@@ -393,6 +1183,7 @@ void CrazyAra::multimodel_arena(istringstream &is, const string &modelDirectory1
     int type;
     int folder;
     is >> type;
+    const MCTSAgentType type1 = static_cast<MCTSAgentType>(type);
     string modelDir1 = modelDirectory1;
     if (isModelInInputStream)
     {
@@ -402,11 +1193,12 @@ void CrazyAra::multimodel_arena(istringstream &is, const string &modelDirectory1
     auto mcts1 = create_new_mcts_agent(netSingleVector, netBatchesVector, &searchSettings, static_cast<MCTSAgentType>(type));
     if (modelDir1 != "")
     {
-        fill_nn_vectors(modelDir1, netSingleVector, netBatchesVector);
+        fill_nn_vectors(modelDir1, netSingleVector, netBatchesVector, inferenceServers);
         mcts1 = create_new_mcts_agent(netSingleVector, netBatchesVector, &searchSettings, static_cast<MCTSAgentType>(type));
     }
 
     is >> type;
+    const MCTSAgentType type2 = static_cast<MCTSAgentType>(type);
     string modelDir2 = modelDirectory2;
     if (isModelInInputStream)
     {
@@ -416,14 +1208,24 @@ void CrazyAra::multimodel_arena(istringstream &is, const string &modelDirectory1
     auto mcts2 = create_new_mcts_agent(netSingleVector, netBatchesVector, &searchSettings, static_cast<MCTSAgentType>(type));
     if (modelDir2 != "")
     {
-        fill_nn_vectors(modelDir2, netSingleContenderVector, netBatchesContenderVector);
+        fill_nn_vectors(modelDir2, netSingleContenderVector, netBatchesContenderVector, inferenceServersContender);
         mcts2 = create_new_mcts_agent(netSingleContenderVector, netBatchesContenderVector, &searchSettings, static_cast<MCTSAgentType>(type));
     }
 
     SelfPlay selfPlay(rawAgent.get(), mcts1.get(), &searchSettings, &searchLimits, &playSettings, &rlSettings, Options);
     size_t numberOfGames;
     is >> numberOfGames;
-    TournamentResult tournamentResult = selfPlay.go_arena(mcts2.get(), numberOfGames, variant);
+
+    const size_t numberAdditionalPairs = rlSettings.concurrentGames - 1;
+    ClientAgents agents1;
+    ClientAgents agents2;
+    create_client_mcts_agents(netBatchesVector, numberAdditionalPairs, type1, agents1);
+    create_client_mcts_agents(modelDir2 != "" ? netBatchesContenderVector : netBatchesVector, numberAdditionalPairs, type2, agents2);
+    vector<pair<MCTSAgent*, MCTSAgent*>> concurrentAgents;
+    for (size_t idx = 0; idx < numberAdditionalPairs; ++idx) {
+        concurrentAgents.emplace_back(agents1.agents[idx].get(), agents2.agents[idx].get());
+    }
+    TournamentResult tournamentResult = selfPlay.go_arena(mcts2.get(), numberOfGames, variant, concurrentAgents);
 
     cout << "Arena summary" << endl;
     cout << "Score of Agent1 vs Agent2: " << tournamentResult << endl;
@@ -432,51 +1234,126 @@ void CrazyAra::multimodel_arena(istringstream &is, const string &modelDirectory1
 
 void CrazyAra::roundrobin(istringstream &is)
 {
-    int type;
-    int numberofgames;
-    is >> numberofgames;
-    struct modelstring
+    size_t numberOfGames;
+    is >> numberOfGames;
+    struct Participant
     {
-        int number_of_mcts_agent;
-        int number_of_model_folder;
+        MCTSAgentType type;
+        int modelFolder;
     };
+    vector<Participant> participants;
+    int type;
+    int folder;
+    while (is >> type >> folder) {
+        participants.push_back({static_cast<MCTSAgentType>(type), folder});
+        info_string("participant", type, "m" + to_string(folder) + "/");
+    }
 
-    int i = 0;
-    std::vector<modelstring> agents;
-    std::vector<int> numbers;
-    while (!is.eof())
-    {
-        is >> type;
-        int tmp1 = type;
-        is >> type;
-
-        modelstring tmp;
-        tmp.number_of_mcts_agent = tmp1;
-        tmp.number_of_model_folder = type;
-        std::cout << "ini " << tmp1 << " " << type << std::endl;
-        agents.push_back(tmp);
-        numbers.push_back(i);
-        i++;
-    }
-
-    std::vector<std::string> combinations = comb(numbers, 2);
-    std::string delimiter = " ";
-    for (int i = 0; i < combinations.size(); i++)
-    {
-        std::string s = combinations[i];
+    // every model is only loaded once and shared by all pairings in which it takes part
+    map<int, LoadedNetworks> networks;
+    for (const Participant& participant : participants) {
+        if (networks.find(participant.modelFolder) == networks.end()) {
+            LoadedNetworks& nets = networks[participant.modelFolder];
+            fill_nn_vectors("m" + to_string(participant.modelFolder) + "/", nets.netSingleVector, nets.netBatchesVector, nets.inferenceServers);
+        }
+    }
+
+    vector<pair<size_t, size_t>> pairings;
+    for (size_t idx1 = 0; idx1 < participants.size(); ++idx1) {
+        for (size_t idx2 = idx1 + 1; idx2 < participants.size(); ++idx2) {
+            pairings.emplace_back(idx1, idx2);
+        }
+    }
+
+    SearchLimits searchLimits;
+    searchLimits.nodes = size_t(Options["Nodes"]);
+    SelfPlay selfPlay(rawAgent.get(), mctsAgent.get(), &searchSettings, &searchLimits, &playSettings, &rlSettings, Options);
 
-        int token1 = std::stoi(s.substr(0, s.find(delimiter)));
-        int token2 = std::stoi(s.substr(2, s.find(delimiter)));
-        std::string comb = std::to_string(agents[token1].number_of_mcts_agent) + " " + std::to_string(agents[token2].number_of_mcts_agent);
-        std::string m1 = "m" + std::to_string(agents[token1].number_of_model_folder) + "/";
-        std::string m2 = "m" + std::to_string(agents[token2].number_of_model_folder) + "/";
-        std::istringstream iss(comb + " " + std::to_string(numberofgames));
-        multimodel_arena(iss, m1, m2, false);
+    // the workers share the inference servers of the loaded models which distribute the requests over all devices
+    const size_t numberWorkers = min(rlSettings.concurrentGames, pairings.size());
+    info_string("playing", pairings.size(), "pairings with " + to_string(numberWorkers) + " workers");
+    atomic<size_t> nextPairing(0);
+    mutex workerMtx;
+    auto create_agent = [&](const Participant& participant, ClientAgents& clientAgents) {
+        LoadedNetworks& nets = networks[participant.modelFolder];
+        if (numberWorkers == 1) {
+            // a single worker can use the loaded networks directly
+            clientAgents.agents.push_back(create_new_mcts_agent(nets.netSingleVector, nets.netBatchesVector, &searchSettings, participant.type));
+        }
+        else {
+            create_client_mcts_agents(nets.netBatchesVector, 1, participant.type, clientAgents);
+        }
+        return clientAgents.agents.back().get();
+    };
+    auto play_pairings = [&]() {
+        size_t pairingIdx;
+        while ((pairingIdx = nextPairing++) < pairings.size()) {
+            ClientAgents agents1;
+            ClientAgents agents2;
+            MCTSAgent* agent1;
+            MCTSAgent* agent2;
+            {
+                lock_guard<mutex> lock(workerMtx);
+                agent1 = create_agent(participants[pairings[pairingIdx].first], agents1);
+                agent2 = create_agent(participants[pairings[pairingIdx].second], agents2);
+            }
+            const TournamentResult tournamentResult = selfPlay.play_arena({{agent1, agent2}}, numberOfGames, variant);
+
+            // the results are written as soon as a pairing is finished
+            lock_guard<mutex> lock(workerMtx);
+            cout << "Arena summary" << endl;
+            cout << "Score of Agent1 vs Agent2: " << tournamentResult << endl;
+            write_tournament_result_to_csv(tournamentResult, "mcts_arena_results.csv");
+        }
+    };
+    vector<thread> workers;
+    for (size_t idx = 0; idx < numberWorkers; ++idx) {
+        workers.emplace_back(play_pairings);
+    }
+    for (thread& worker : workers) {
+        worker.join();
     }
 
+    // the queued arena summaries are written before exit() destroys the static objects
+    flush_async_output();
     exit(0);
 }
 
+#endif
+
+void CrazyAra::fill_client_nn_vectors(const vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector, vector<unique_ptr<NeuralNetAPI>>& clientSingleVector,
+                                      vector<vector<unique_ptr<NeuralNetAPI>>>& clientBatchesVector)
+{
+    clientBatchesVector.resize(netBatchesVector.size());
+    for (size_t threadIdx = 0; threadIdx < netBatchesVector.size(); ++threadIdx) {
+        for (size_t phaseIdx = 0; phaseIdx < netBatchesVector[threadIdx].size(); ++phaseIdx) {
+            const InferenceClientAPI* client = dynamic_cast<const InferenceClientAPI*>(netBatchesVector[threadIdx][phaseIdx].get());
+            if (client == nullptr) {
+                throw invalid_argument("Concurrent selfplay games require networks which are run by the in-process inference server.");
+            }
+            clientBatchesVector[threadIdx].push_back(make_unique<InferenceClientAPI>(client->get_server(), client->get_batch_size(), client->get_model_directory()));
+            if (threadIdx == 0) {
+                clientSingleVector.push_back(make_unique<InferenceClientAPI>(client->get_server(), 1, client->get_model_directory()));
+            }
+        }
+    }
+}
+
+void CrazyAra::create_client_mcts_agents(const vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector, size_t numberAgents, MCTSAgentType type,
+                                         ClientAgents& clientAgents, const SearchSettings* settings)
+{
+    // the agents keep pointers to their settings and networks, so the vectors must not be resized afterwards
+    clientAgents.searchSettings.assign(numberAgents, settings != nullptr ? *settings : searchSettings);
+    clientAgents.netSingleVectors.resize(numberAgents);
+    clientAgents.netBatchesVectors.resize(numberAgents);
+    for (size_t idx = 0; idx < numberAgents; ++idx) {
+        fill_client_nn_vectors(netBatchesVector, clientAgents.netSingleVectors[idx], clientAgents.netBatchesVectors[idx]);
+        clientAgents.agents.push_back(create_new_mcts_agent(clientAgents.netSingleVectors[idx], clientAgents.netBatchesVectors[idx],
+                                                            &clientAgents.searchSettings[idx], type));
+    }
+}
+
+#ifdef USE_RL
 void CrazyAra::init_rl_settings()
 {
     rlSettings.numberChunks = Options["Selfplay_Number_Chunks"];
@@ -490,8 +1367,43 @@ void CrazyAra::init_rl_settings()
     rlSettings.rawPolicyProbabilityTemperature = Options["Centi_Raw_Prob_Temperature"] / 100.0f;
     rlSettings.resignProbability = Options["Centi_Resign_Probability"] / 100.0f;
     rlSettings.resignThreshold = Options["Centi_Resign_Threshold"] / 100.0f;
+    rlSettings.tbAdjudicationProbability = Options["Centi_TB_Adjudication_Probability"] / 100.0f;
+    rlSettings.drawAdjudicationProbability = Options["Centi_Draw_Adjudication_Probability"] / 100.0f;
+    rlSettings.drawAdjudicationPlies = Options["Draw_Adjudication_Plies"];
+    rlSettings.drawAdjudicationThreshold = Options["Centi_Draw_Adjudication_Threshold"] / 100.0f;
+    rlSettings.maxPliesProbability = Options["Centi_Max_Plies_Probability"] / 100.0f;
+    rlSettings.maxGamePlies = Options["Max_Game_Plies"];
     rlSettings.reuseTreeForSelpay = Options["Reuse_Tree"];
+    rlSettings.concurrentGames = Options["Selfplay_Concurrent_Games"];
+    rlSettings.arenaSPRT = Options["Arena_SPRT"];
+    rlSettings.sprtElo0 = Options["Arena_SPRT_Elo0"];
+    rlSettings.sprtElo1 = Options["Arena_SPRT_Elo1"];
+    rlSettings.sprtAlpha = Options["Centi_Arena_SPRT_Alpha"] / 100.0f;
+    rlSettings.sprtBeta = Options["Centi_Arena_SPRT_Beta"] / 100.0f;
+    rlSettings.compressionCodec = string(Options["Selfplay_Compression"]);
+    rlSettings.compressionLevel = Options["Selfplay_Compression_Level"];
+    rlSettings.exportQueueSize = Options["Selfplay_Export_Queue_Size"];
+    rlSettings.exportFormat = string(Options["Selfplay_Export_Format"]) == "packed" ? EXPORT_FORMAT_PACKED : EXPORT_FORMAT_DENSE;
+    rlSettings.sparsePolicySize = Options["Selfplay_Sparse_Policy_Size"];
+    rlSettings.streamDirectory = string(Options["Selfplay_Stream_Directory"]);
+    if (rlSettings.streamDirectory == "<empty>") {
+        rlSettings.streamDirectory = "";
+    }
+    rlSettings.shardSizeMB = Options["Selfplay_Shard_Size_MB"];
+    rlSettings.publishAddress = string(Options["Selfplay_Publish_Address"]);
+    if (rlSettings.publishAddress == "<empty>") {
+        rlSettings.publishAddress = "";
+    }
+#ifdef USE_ZLIB
+    rlSettings.compressPGN = Options["Selfplay_PGN_Compression"];
+#else
+    rlSettings.compressPGN = false;
+#endif
+    buffered_file_writer().set_flush_interval(size_t(Options["Output_Flush_Interval_MS"]));
     rlSettings.epdFilePath = string(Options["EPD_File_Path"]);
+    const string epdSampling = string(Options["EPD_Sampling"]);
+    rlSettings.epdSampling = epdSampling == "weighted" ? EPD_SAMPLING_WEIGHTED :
+                             epdSampling == "without_replacement" ? EPD_SAMPLING_WITHOUT_REPLACEMENT : EPD_SAMPLING_UNIFORM;
     if (rlSettings.epdFilePath != "<empty>" and rlSettings.epdFilePath != "") {
         std::ifstream epdFile (rlSettings.epdFilePath);
         if (!epdFile.is_open()) {
@@ -545,34 +1457,220 @@ void CrazyAra::init()
 #endif
 }
 
-void CrazyAra::fill_single_nn_vector(const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector)
+bool CrazyAra::use_inference_server(OptionsMap& options) const
+{
+#ifdef USE_RL
+    // concurrent selfplay games batch their searches in the shared inference server
+    bool useInferenceServer = bool(options["Inference_Server"]) || int(options["Selfplay_Concurrent_Games"]) > 1 ||
+                              int(options["Analysis_Concurrent_Positions"]) > 1;
+#else
+    bool useInferenceServer = bool(options["Inference_Server"]) || int(options["Analysis_Concurrent_Positions"]) > 1;
+#endif
+#ifdef OPENVINO
+    // the overflow workers take the batches of the search threads which the devices can't serve in time
+    useInferenceServer = useInferenceServer || size_t(options["Overflow_CPU_Workers"]) > 0;
+#endif
+    return useInferenceServer;
+}
+
+void CrazyAra::fill_single_nn_vector(NetLoadSettings& loadSettings, const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector,
+                                     vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector, vector<unique_ptr<InferenceServer>>& inferenceServers,
+                                     vector<size_t>& deviceThreadCounts)
 {
-    unique_ptr<NeuralNetAPI> netSingleTmp = create_new_net(modelDirectory, int(Options["First_Device_ID"]), 1);
-    netSingleTmp->validate_neural_network();
+    OptionsMap& options = loadSettings.options;
+    const vector<DeviceSpec> devices = get_device_specs(options);
+    const size_t numberDevices = devices.size();
+    // total number of search threads over all devices
+    const size_t numberThreads = get_num_search_threads(options);
+    const bool useInferenceServer = use_inference_server(options);
+#ifdef OPENVINO
+    const size_t numberOverflowWorkers = size_t(options["Overflow_CPU_Workers"]);
+#else
+    const size_t numberOverflowWorkers = 0;
+#endif
+#ifdef __linux__
+    const string shmServerName = options["Inference_Server_Shm"];
+    if (shmServerName != "") {
+        // the networks are run by a shared memory inference server of a different process
+        for (size_t idx = 0; idx < numberThreads; ++idx) {
+            netBatchesVector[idx].push_back(make_unique<ShmClientAPI>(shmServerName, loadSettings.batchSize, modelDirectory));
+            netBatchesVector[idx].back()->validate_neural_network();
+        }
+        netSingleVector.push_back(make_unique<ShmClientAPI>(shmServerName, 1, modelDirectory));
+        netSingleVector.back()->validate_neural_network();
+        return;
+    }
+#endif
+#ifndef _WIN32
+    const string remoteAddress = options["Inference_Server_Remote"];
+    if (remoteAddress != "") {
+        // all networks share a single connection to the remote inference server and pipeline their requests
+        shared_ptr<RemoteConnection> connection = make_shared<RemoteConnection>(remoteAddress);
+        for (size_t idx = 0; idx < numberThreads; ++idx) {
+            netBatchesVector[idx].push_back(make_unique<RemoteClientAPI>(connection, loadSettings.batchSize, modelDirectory));
+            netBatchesVector[idx].back()->validate_neural_network();
+        }
+        netSingleVector.push_back(make_unique<RemoteClientAPI>(connection, 1, modelDirectory));
+        netSingleVector.back()->validate_neural_network();
+        return;
+    }
+#endif
+    const size_t numberNets = (useInferenceServer ? numberDevices * (size_t(options["Inference_Server_Workers"]) + numberOverflowWorkers) : numberThreads) + 1;
+
+    // the validation and the progress output of the loading tasks are serialized to keep the log readable
+    mutex logMutex;
+    atomic<size_t> numberLoadedNets(0);
+    auto validate = [&](NeuralNetAPI* net) {
+        lock_guard<mutex> lock(logMutex);
+        net->validate_neural_network();
+        info_string("loaded network", to_string(++numberLoadedNets) + "/" + to_string(numberNets), "from " + modelDirectory);
+    };
+
+    // the first network of each device is used to measure its throughput, the search threads are then distributed in proportion
+    vector<unique_ptr<NeuralNetAPI>> probeNets(numberDevices);
+    if (deviceThreadCounts.empty()) {
+        for (const DeviceSpec& device : devices) {
+            deviceThreadCounts.push_back(device.threads);
+        }
+        // an explicit device configuration takes precedence over the measured throughput
+        if (bool(options["Device_Load_Balancing"]) && string(options["Device_Config"]).empty() && numberDevices > 1 && !useInferenceServer) {
+            vector<double> throughputs(numberDevices);
+            vector<future<void>> probeTasks;
+            for (size_t deviceIdx = 0; deviceIdx < numberDevices; ++deviceIdx) {
+                probeTasks.emplace_back(async(launch::async, [&, deviceIdx]() {
+                    ScopedNumaBinding inferenceBinding(loadSettings.inferenceCpus);
+                    const DeviceSpec& device = devices[deviceIdx];
+                    probeNets[deviceIdx] = create_new_net(options, modelDirectory, device.deviceId, device.batchSize, device.precision);
+                    validate(probeNets[deviceIdx].get());
+                    throughputs[deviceIdx] = measure_inference(probeNets[deviceIdx].get(), 5, 20, options["Precision"]).throughput;
+                }));
+            }
+            for (future<void>& probeTask : probeTasks) {
+                probeTask.wait();
+            }
+            for (future<void>& probeTask : probeTasks) {
+                probeTask.get();
+            }
+            deviceThreadCounts = distribute_threads(throughputs, numberThreads);
+            for (size_t deviceIdx = 0; deviceIdx < numberDevices; ++deviceIdx) {
+                info_string("device", devices[deviceIdx].name, "evaluates " + to_string(size_t(throughputs[deviceIdx])) + " pos/s and runs " +
+                            to_string(deviceThreadCounts[deviceIdx]) + " search threads");
+            }
+        }
+    }
+    vector<size_t> firstThreadIndices(numberDevices, 0);
+    for (size_t deviceIdx = 1; deviceIdx < numberDevices; ++deviceIdx) {
+        firstThreadIndices[deviceIdx] = firstThreadIndices[deviceIdx - 1] + deviceThreadCounts[deviceIdx - 1];
+    }
+
+    // the networks are created in parallel with one task per device
+    vector<unique_ptr<InferenceServer>> deviceServers(numberDevices);
+    vector<future<void>> deviceTasks;
+    for (size_t deviceIdx = 0; deviceIdx < numberDevices; ++deviceIdx) {
+        deviceTasks.emplace_back(async(launch::async, [&, deviceIdx]() {
+            // the thread pools of the back-ends are created with the networks and inherit the affinity of this task
+            ScopedNumaBinding inferenceBinding(loadSettings.inferenceCpus);
+            const DeviceSpec& device = devices[deviceIdx];
+            InferenceServer* server = nullptr;
+            if (useInferenceServer) {
+                // a single server per device and phase runs the large batches of all search threads of this device
+                vector<unique_ptr<NeuralNetAPI>> serverNets;
+                for (size_t i = 0; i < size_t(options["Inference_Server_Workers"]); ++i) {
+                    serverNets.push_back(create_new_net(options, modelDirectory, device.deviceId, options["Inference_Server_Batch_Size"], device.precision));
+                    validate(serverNets.back().get());
+                }
+                vector<unique_ptr<NeuralNetAPI>> overflowNets = create_overflow_nets(options, modelDirectory, options["Inference_Server_Batch_Size"]);
+                for (unique_ptr<NeuralNetAPI>& overflowNet : overflowNets) {
+                    validate(overflowNet.get());
+                }
+                deviceServers[deviceIdx] = make_unique<InferenceServer>(serverNets, options["Inference_Server_Timeout_US"], std::move(overflowNets),
+                                                                        options["Overflow_Latency_US"]);
+                server = deviceServers[deviceIdx].get();
+            }
+            for (size_t i = 0; i < deviceThreadCounts[deviceIdx]; ++i) {
+                unique_ptr<NeuralNetAPI> netBatchesTmp;
+                if (i == 0 && probeNets[deviceIdx] != nullptr) {
+                    netBatchesTmp = std::move(probeNets[deviceIdx]);
+                }
+                else if (server != nullptr) {
+                    netBatchesTmp = make_unique<InferenceClientAPI>(server, device.batchSize, modelDirectory);
+                    lock_guard<mutex> lock(logMutex);
+                    netBatchesTmp->validate_neural_network();
+                }
+                else {
+                    netBatchesTmp = create_new_net(options, modelDirectory, device.deviceId, device.batchSize, device.precision);
+                    validate(netBatchesTmp.get());
+                }
+                netBatchesVector[firstThreadIndices[deviceIdx] + i].push_back(std::move(netBatchesTmp));
+            }
+        }));
+    }
+
+    ScopedNumaBinding inferenceBinding(loadSettings.inferenceCpus);
+    unique_ptr<NeuralNetAPI> netSingleTmp = create_new_net(options, modelDirectory, devices.front().deviceId, 1, devices.front().precision);
+    validate(netSingleTmp.get());
     netSingleVector.push_back(std::move(netSingleTmp));
 
-    size_t idx = 0;
-    for (int deviceId = int(Options["First_Device_ID"]); deviceId <= int(Options["Last_Device_ID"]); ++deviceId) {
-        for (size_t i = 0; i < size_t(Options["Threads"]); ++i) {
-            unique_ptr<NeuralNetAPI> netBatchesTmp = create_new_net(modelDirectory, deviceId, searchSettings.batchSize);
-            netBatchesTmp->validate_neural_network();
-            netBatchesVector[idx].push_back(std::move(netBatchesTmp));
-            ++idx;
+    // rethrows the exceptions of the loading tasks after all of them have finished
+    for (future<void>& deviceTask : deviceTasks) {
+        deviceTask.wait();
+    }
+    for (future<void>& deviceTask : deviceTasks) {
+        deviceTask.get();
+    }
+    for (unique_ptr<InferenceServer>& server : deviceServers) {
+        if (server != nullptr) {
+            inferenceServers.push_back(std::move(server));
         }
     }
 }
 
-void CrazyAra::fill_nn_vectors(const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector)
+void CrazyAra::fill_nn_vectors(const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
+                               vector<unique_ptr<InferenceServer>>& inferenceServers)
 {
+    // the background loader of the deferred phases must not read the settings while they are changed by "setoption"
+    NetLoadSettings loadSettings{Options, searchSettings.batchSize, inferenceCpus};
+    OptionsMap& options = loadSettings.options;
     netSingleVector.clear();
     netBatchesVector.clear();
+    // the servers are released after their clients
+    inferenceServers.clear();
     // threads is the first dimension, the phase are the 2nd dimension
-    netBatchesVector.resize(Options["Threads"] * get_num_gpus(Options));
+    netBatchesVector.resize(get_num_search_threads(options));
+    // the threads per device are determined by the first phase and reused for all others
+    vector<size_t> deviceThreadCounts;
+    if (!set_visible_devices(get_device_specs(options))) {
+        info_string_important("CUDA_VISIBLE_DEVICES is already set and doesn't match the UUIDs of Device_Config");
+    }
+    if (get_mps_share() < 1) {
+        info_string("MPS client with", int(get_mps_share() * 100), "% of the GPU, the batch sizes are reduced accordingly");
+    }
+
+    // a replay uses the recorded directories, the model files aren't needed
+    if (inference_recording().is_replaying()) {
+        const vector<string> replayDirectories = inference_recording().get_replay_directories(modelDirectory);
+        if (replayDirectories.empty()) {
+            throw invalid_argument("The inference recording doesn't contain the network of " + modelDirectory);
+        }
+        for (const string& replayDirectory : replayDirectories) {
+            fill_single_nn_vector(loadSettings, replayDirectory, netSingleVector, netBatchesVector, inferenceServers, deviceThreadCounts);
+        }
+        add_fast_nets(loadSettings, netBatchesVector, inferenceServers, deviceThreadCounts);
+        return;
+    }
+
+    // the null back-end doesn't need a model directory
+    if (bool(options["Null_Backend"])) {
+        fill_single_nn_vector(loadSettings, modelDirectory, netSingleVector, netBatchesVector, inferenceServers, deviceThreadCounts);
+        add_fast_nets(loadSettings, netBatchesVector, inferenceServers, deviceThreadCounts);
+        return;
+    }
 
     // early return if no phases are used
     for (const auto& entry : fs::directory_iterator(modelDirectory)) {
         if (!fs::is_directory(entry.path())) {
-            fill_single_nn_vector(modelDirectory, netSingleVector, netBatchesVector);
+            fill_single_nn_vector(loadSettings, modelDirectory, netSingleVector, netBatchesVector, inferenceServers, deviceThreadCounts);
+            add_fast_nets(loadSettings, netBatchesVector, inferenceServers, deviceThreadCounts);
             return;
         }
         else {
@@ -581,10 +1679,119 @@ void CrazyAra::fill_nn_vectors(const string& modelDirectory, vector<unique_ptr<N
     }
 
     // analyse directory to get num phases
+    vector<string> phaseDirectories;
     for (const auto& entry : fs::directory_iterator(modelDirectory)) {
         std::cout << entry.path().generic_string() << std::endl;
+        phaseDirectories.push_back(entry.path().generic_string());
+    }
+    // the clients of an inference server can't be replaced by deferred networks
+    if (!bool(options["Lazy_Phase_Loading"]) || phaseDirectories.size() == 1 || use_inference_server(options)) {
+        for (const string& phaseDirectory : phaseDirectories) {
+            fill_single_nn_vector(loadSettings, phaseDirectory, netSingleVector, netBatchesVector, inferenceServers, deviceThreadCounts);
+        }
+        add_fast_nets(loadSettings, netBatchesVector, inferenceServers, deviceThreadCounts);
+        return;
+    }
+
+    // only the opening network is loaded now, the later phases follow in the background in the order of the game
+    sort(phaseDirectories.begin(), phaseDirectories.end(), [](const string& lhs, const string& rhs) {
+        return read_game_phase_from_string(parse_directory(lhs)) < read_game_phase_from_string(parse_directory(rhs));
+    });
+    fill_single_nn_vector(loadSettings, phaseDirectories.front(), netSingleVector, netBatchesVector, inferenceServers, deviceThreadCounts);
+    const vector<string> deferredDirectories(phaseDirectories.begin() + 1, phaseDirectories.end());
+    auto loadPhase = [this, deviceThreadCounts, loadSettings](const string& phaseDirectory, vector<unique_ptr<NeuralNetAPI>>& phaseSingleVector,
+            vector<vector<unique_ptr<NeuralNetAPI>>>& phaseBatchesVector) mutable {
+        vector<unique_ptr<InferenceServer>> noServers;
+        vector<size_t> phaseThreadCounts = deviceThreadCounts;
+        fill_single_nn_vector(loadSettings, phaseDirectory, phaseSingleVector, phaseBatchesVector, noServers, phaseThreadCounts);
+    };
+    shared_ptr<DeferredPhaseLoader> loader = make_shared<DeferredPhaseLoader>(deferredDirectories, netBatchesVector.size(),
+                                                                              netBatchesVector.front().front().get(), loadPhase);
+    for (size_t phaseIdx = 0; phaseIdx < deferredDirectories.size(); ++phaseIdx) {
+        for (size_t threadIdx = 0; threadIdx < netBatchesVector.size(); ++threadIdx) {
+            netBatchesVector[threadIdx].push_back(make_unique<DeferredNetAPI>(loader, phaseIdx, threadIdx, netBatchesVector[threadIdx].front().get(),
+                                                                              deferredDirectories[phaseIdx]));
+        }
+        netSingleVector.push_back(make_unique<DeferredNetAPI>(loader, phaseIdx, DEFERRED_SINGLE_NET, netSingleVector.front().get(),
+                                                              deferredDirectories[phaseIdx]));
+    }
+    loader->start();
+    add_fast_nets(loadSettings, netBatchesVector, inferenceServers, deviceThreadCounts);
+}
+
+string CrazyAra::get_network_cache_key() const
+{
+#ifdef SUPPORT960
+    const bool is960 = Options["UCI_Chess960"];
+#else
+    const bool is960 = false;
+#endif
+    return string(Options["Model_Directory"]) + "|" + string(Options["UCI_Variant"]) + "|" + to_string(is960) + "|" +
+            to_string(int(Options["Threads"])) + "|" + to_string(int(Options["Batch_Size"])) + "|" + string(Options["Precision"]) + "|" +
+            to_string(int(Options["First_Device_ID"])) + "|" + to_string(int(Options["Last_Device_ID"])) + "|" + string(Options["Device_Config"]) + "|" +
+            to_string(bool(Options["Root_Parallel"])) + "|" + get_fast_model_directory(Options) + "|" + to_string(bool(Options["Null_Backend"]));
+}
+
+void CrazyAra::load_networks()
+{
+#ifndef _WIN32
+    // the sessions of the analysis server are clients of the former inference servers
+    analysisServer.reset();
+    analysisAgents.reset();
+#endif
+    networkCache.set_budget(size_t(Options["Network_Cache_MB"]) * 1024 * 1024);
+    if (!loadedNetworkKey.empty() && !netSingleVector.empty()) {
+        // the agents hold raw pointers to the networks
+        mctsAgent.reset();
+        rawAgent.reset();
+        LoadedNetworks networks;
+        networks.netSingleVector = std::move(netSingleVector);
+        networks.netBatchesVector = std::move(netBatchesVector);
+        networks.inferenceServers = std::move(inferenceServers);
+        networkCache.put(loadedNetworkKey, loadedNetworkBytes, std::move(networks));
+        netSingleVector.clear();
+        netBatchesVector.clear();
+        inferenceServers.clear();
+    }
+    loadedNetworkKey = get_network_cache_key();
+    LoadedNetworks networks;
+    if (networkCache.take(loadedNetworkKey, networks)) {
+        netSingleVector = std::move(networks.netSingleVector);
+        netBatchesVector = std::move(networks.netBatchesVector);
+        inferenceServers = std::move(networks.inferenceServers);
+        info_string("reused the cached networks of", string(Options["Model_Directory"]));
+    }
+    else {
+        fill_nn_vectors(Options["Model_Directory"], netSingleVector, netBatchesVector, inferenceServers);
+    }
+    size_t numberNetworks = netSingleVector.size();
+    for (const vector<unique_ptr<NeuralNetAPI>>& threadNets : netBatchesVector) {
+        numberNetworks += threadNets.size();
+    }
+    loadedNetworkBytes = estimate_network_memory(Options["Model_Directory"], numberNetworks);
+    if (networkCache.size() != 0) {
+        info_string("network cache:", to_string(networkCache.size()) + " configurations, " + to_string(networkCache.get_memory_bytes() / (1024 * 1024)) + " MB");
+    }
+}
 
-        fill_single_nn_vector(entry.path().generic_string(), netSingleVector, netBatchesVector);
+void CrazyAra::add_fast_nets(NetLoadSettings& loadSettings, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
+                             vector<unique_ptr<InferenceServer>>& inferenceServers, vector<size_t>& deviceThreadCounts)
+{
+    OptionsMap& options = loadSettings.options;
+    const string fastModelDirectory = get_fast_model_directory(options);
+    if (fastModelDirectory.empty()) {
+        return;
+    }
+    // the fast network is appended behind the phase networks of every search thread, a single network isn't needed for it
+    vector<unique_ptr<NeuralNetAPI>> fastNetSingleVector;
+    fill_single_nn_vector(loadSettings, fastModelDirectory, fastNetSingleVector, netBatchesVector, inferenceServers, deviceThreadCounts);
+    const NeuralNetAPI* mainNet = netBatchesVector.front().front().get();
+    const NeuralNetAPI* fastNet = netBatchesVector.front().back().get();
+    // both networks write into the same rows of a mini-batch
+    if (fastNet->get_nb_input_values_total() != mainNet->get_nb_input_values_total() || fastNet->get_nb_policy_values() != mainNet->get_nb_policy_values() ||
+            fastNet->is_policy_map() != mainNet->is_policy_map() || fastNet->get_version() != mainNet->get_version() ||
+            fastNet->supports_policy_gather() != mainNet->supports_policy_gather()) {
+        throw invalid_argument("The network of Fast_Model_Directory doesn't use the input and policy representation of the main network");
     }
 }
 
@@ -605,12 +1812,16 @@ bool CrazyAra::is_ready()
 #ifdef USE_RL
         init_rl_settings();
 #endif
+        start_metrics_exporter();
+        start_device_monitor();
 
-        fill_nn_vectors(Options["Model_Directory"], netSingleVector, netBatchesVector);
+        load_networks();
 
-        mctsAgent = create_new_mcts_agent(netSingleVector, netBatchesVector, &searchSettings);
+        mctsAgent = create_new_mcts_agent(netSingleVector, netBatchesVector, &searchSettings, get_mcts_agent_type());
         rawAgent = make_unique<RawNetAgent>(netSingleVector, &playSettings, false, &searchSettings);
         StateConstants::init(mctsAgent->is_policy_map(), Options["UCI_Chess960"]);
+        info_string("PUCT selection kernel:", puct_selection_kernel_name());
+        info_string("Policy kernel:", policy_kernel_name());
 
         timeoutThread.kill();
         if (timeoutMS != 0) {
@@ -618,8 +1829,20 @@ bool CrazyAra::is_ready()
         }
         hasReplied = timeoutThread.has_replied();
         networkLoaded = true;
+        if (int(Options["Search_Cores"]) == -1) {
+            // the networks are reloaded for every candidate, the tuning runs load with a fixed number of cores
+            istringstream defaultArguments;
+            tune_search_cores(defaultArguments);
+        }
     }
     wait_to_finish_last_search();
+    apply_reloaded_model();
+#ifdef MCTS_TB_SUPPORT
+    if (bool(Options["Tablebase_Warm_Up"]) && searchSettings.useTablebase && string(Options["SyzygyPath"]) != warmedUpSyzygyPath) {
+        warm_up_tablebases(Options["SyzygyPath"]);
+        warmedUpSyzygyPath = string(Options["SyzygyPath"]);
+    }
+#endif
     if (verbose && !hasReplied) {
         cout << "readyok" << endl;
     }
@@ -635,6 +1858,178 @@ void CrazyAra::ucinewgame()
     }
 }
 
+#ifdef __linux__
+void CrazyAra::shm_server()
+{
+    const string name = Options["Inference_Server_Shm"];
+    if (name == "") {
+        info_string_important("The UCI option Inference_Server_Shm must be set to the name of the shared memory segment.");
+        return;
+    }
+    shmServer.reset();
+    vector<unique_ptr<NeuralNetAPI>> serverNets = create_server_nets();
+    shmServer = make_unique<ShmInferenceServer>(name, serverNets, size_t(Options["Inference_Server_Shm_Slots"]),
+                                                size_t(Options["Batch_Size"]), size_t(Options["Inference_Server_Timeout_US"]));
+    info_string("shared memory inference server is running");
+}
+#endif
+
+#ifndef _WIN32
+void CrazyAra::tcp_server()
+{
+    tcpServer.reset();
+    vector<unique_ptr<NeuralNetAPI>> serverNets = create_server_nets();
+    tcpServer = make_unique<TcpInferenceServer>(int(Options["Inference_Server_Port"]), serverNets, size_t(Options["Inference_Server_Timeout_US"]));
+}
+
+void CrazyAra::analysis_server()
+{
+    wait_to_finish_last_search();
+    analysisServer.reset();
+    analysisAgents.reset();
+    if (!is_ready<false>()) {
+        return;
+    }
+    prepare_search_config_structs();
+    const size_t numberSessions = size_t(int(Options["Analysis_Server_Sessions"]));
+    unique_ptr<ClientAgents> agents = make_unique<ClientAgents>();
+    try {
+        create_client_mcts_agents(netBatchesVector, numberSessions, MCTSAgentType::kDefault, *agents);
+    }
+    catch (const invalid_argument& e) {
+        info_string_important(e.what());
+        info_string_important("The analysis server requires the networks to be loaded with \"setoption name Inference_Server value true\" before \"isready\".");
+        return;
+    }
+    vector<MCTSAgent*> sessionAgents;
+    for (size_t idx = 0; idx < numberSessions; ++idx) {
+        // each session is a fair share group of the inference servers, the main agent keeps group 0
+        for (unique_ptr<NeuralNetAPI>& net : agents->netSingleVectors[idx]) {
+            static_cast<InferenceClientAPI*>(net.get())->set_group(idx + 1);
+        }
+        for (vector<unique_ptr<NeuralNetAPI>>& nets : agents->netBatchesVectors[idx]) {
+            for (unique_ptr<NeuralNetAPI>& net : nets) {
+                static_cast<InferenceClientAPI*>(net.get())->set_group(idx + 1);
+            }
+        }
+        sessionAgents.push_back(agents->agents[idx].get());
+    }
+    try {
+        analysisServer = make_unique<AnalysisServer>(int(Options["Analysis_Server_Port"]), sessionAgents, variant, Options["UCI_Chess960"],
+                                                     size_t(int(Options["Analysis_Server_Max_Nodes"])));
+    }
+    catch (const invalid_argument& e) {
+        info_string_important(e.what());
+        return;
+    }
+    analysisAgents = std::move(agents);
+}
+
+void CrazyAra::distributed_search(const StateObj* state, istringstream& is)
+{
+    size_t nodes = 0;
+    is >> nodes;
+    vector<string> addresses;
+    istringstream shards(string(Options["Distributed_Search_Shards"]));
+    string address;
+    while (getline(shards, address, ',')) {
+        if (address != "") {
+            addresses.push_back(address);
+        }
+    }
+    if (nodes == 0 || addresses.empty()) {
+        info_string_important("Usage: distsearch <nodes> with \"setoption name Distributed_Search_Shards value <host>:<port>,...\"");
+        return;
+    }
+    wait_to_finish_last_search();
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    // the priors of the root moves are given by the local network
+    vector<unique_ptr<StateObj>> states;
+    states.emplace_back(unique_ptr<StateObj>(state->clone()));
+    vector<EvalInfo> evalInfos;
+    evaluate_states(states, evalInfos);
+    const EvalInfo& rootInfo = evalInfos.front();
+    if (rootInfo.legalMoves.empty()) {
+        info_string_important("The given position has no legal moves");
+        return;
+    }
+
+    vector<string> rootMoves;
+    vector<float> priors;
+    string drawMove;
+    for (size_t idx = 0; idx < rootInfo.legalMoves.size(); ++idx) {
+        const Action action = rootInfo.legalMoves[idx];
+        const string move = StateConstants::action_to_uci(action, state->is_chess960());
+        unique_ptr<StateObj> childState = unique_ptr<StateObj>(state->clone());
+        childState->do_action(action);
+        float customTerminalValue;
+        const TerminalType terminal = childState->is_terminal(childState->legal_actions().size(), customTerminalValue);
+        if (terminal == TERMINAL_LOSS) {
+            // the opponent is lost, no remote search is needed
+            info_bestmove(move);
+            return;
+        }
+        if (terminal != TERMINAL_NONE) {
+            // only non terminal subtrees are sent to the remote nodes
+            if (terminal == TERMINAL_DRAW) {
+                drawMove = move;
+            }
+            continue;
+        }
+        rootMoves.push_back(move);
+        priors.push_back(float(rootInfo.policyProbSmall[idx]));
+    }
+
+    vector<ShardedRootMove> moves;
+    try {
+        DistributedSearch search(addresses, size_t(int(Options["Distributed_Search_Slots"])), size_t(int(Options["Distributed_Search_Chunk_Nodes"])),
+                                 Options["Centi_CPuct_Init"] / 100.0f);
+        moves = search.run(state->fen(), rootMoves, priors, nodes);
+    }
+    catch (const invalid_argument& e) {
+        info_string_important(e.what());
+        return;
+    }
+    // the most visited subtree is played as in the local search
+    const ShardedRootMove* best = nullptr;
+    size_t totalNodes = 0;
+    for (const ShardedRootMove& move : moves) {
+        info_string(move.move, "nodes " + to_string(move.nodes) + " q " + to_string(move.q), addresses[move.shardIdx]);
+        totalNodes += move.nodes;
+        if (!move.isFailed && move.nodes != 0 && (best == nullptr || move.nodes > best->nodes)) {
+            best = &move;
+        }
+    }
+    const size_t elapsedTimeMS = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    if (best == nullptr || (drawMove != "" && best->q < 0)) {
+        if (drawMove == "") {
+            info_string_important("None of the analysis servers returned a result");
+            return;
+        }
+        cout << "info depth 1 score cp 0 nodes " << totalNodes << " time " << elapsedTimeMS << " pv " << drawMove << endl;
+        info_bestmove(drawMove);
+        return;
+    }
+    cout << "info depth 1 score cp " << value_to_centipawn(best->q) << " nodes " << totalNodes << " time " << elapsedTimeMS
+         << " nps " << totalNodes * 1000 / max(elapsedTimeMS, size_t(1)) << " pv " << best->move << endl;
+    info_bestmove(best->move);
+}
+#endif
+
+vector<unique_ptr<NeuralNetAPI>> CrazyAra::create_server_nets()
+{
+    vector<unique_ptr<NeuralNetAPI>> serverNets;
+    const vector<DeviceSpec> devices = get_device_specs(Options);
+    set_visible_devices(devices);
+    for (const DeviceSpec& device : devices) {
+        for (size_t i = 0; i < size_t(Options["Inference_Server_Workers"]); ++i) {
+            serverNets.push_back(create_new_net(Options, Options["Model_Directory"], device.deviceId, Options["Inference_Server_Batch_Size"], device.precision));
+            serverNets.back()->validate_neural_network();
+        }
+    }
+    return serverNets;
+}
+
 string CrazyAra::engine_info()
 {
     stringstream ss;
@@ -643,23 +2038,74 @@ string CrazyAra::engine_info()
     return ss.str();
 }
 
-unique_ptr<NeuralNetAPI> CrazyAra::create_new_net(const string& modelDirectory, int deviceId, unsigned int batchSize)
+unique_ptr<NeuralNetAPI> CrazyAra::create_new_net(OptionsMap& options, const string& modelDirectory, int deviceId, unsigned int batchSize, const string& precision)
+{
+    if (inference_recording().is_replaying()) {
+        const ReplayNet* replayNet = inference_recording().get_replay_net(modelDirectory);
+        if (replayNet == nullptr) {
+            throw invalid_argument("The inference recording doesn't contain the network of " + modelDirectory);
+        }
+        return make_unique<ReplayAPI>(replayNet, batchSize);
+    }
+    if (inference_recording().is_recording()) {
+        return make_unique<RecordingAPI>(create_backend_net(options, modelDirectory, deviceId, batchSize, precision));
+    }
+    return create_backend_net(options, modelDirectory, deviceId, batchSize, precision);
+}
+
+unique_ptr<NeuralNetAPI> CrazyAra::create_backend_net(OptionsMap& options, const string& modelDirectory, int deviceId, unsigned int batchSize, const string& precision)
 {
+    if (bool(options["Null_Backend"])) {
+        return make_unique<NullAPI>(batchSize, size_t(options["Null_Backend_Latency_US"]));
+    }
+    const string netPrecision = precision.empty() ? string(options["Precision"]) : precision;
 #ifdef MXNET
     #ifdef TENSORRT
-        const bool useTensorRT = bool(Options["Use_TensorRT"]);
+        const bool useTensorRT = bool(options["Use_TensorRT"]);
     #else
         const bool useTensorRT = false;
     #endif
-    return make_unique<MXNetAPI>(Options["Context"], deviceId, batchSize, modelDirectory, Options["Precision"], useTensorRT);
+    return make_unique<MXNetAPI>(options["Context"], deviceId, batchSize, modelDirectory, netPrecision, useTensorRT);
 #elif defined TENSORRT
-    return make_unique<TensorrtAPI>(deviceId, batchSize, modelDirectory, Options["Precision"]);
+    return make_unique<TensorrtAPI>(deviceId, batchSize, modelDirectory, netPrecision, bool(options["Use_CUDA_Graph"]),
+                                    bool(options["Dynamic_Batch_Profiles"]), options["Engine_Cache_Directory"],
+                                    bool(options["Packed_Input_Planes"]), string(options["IO_Precision"]) == "float16",
+                                    bool(options["Gather_Policy"]), options["Calibration_File"], bool(options["Layer_Precision_Search"]),
+                                    int(options["Milli_Layer_Precision_Tolerance"]) / 1000.0);
 #elif defined OPENVINO
-    return make_unique<OpenVinoAPI>(deviceId, batchSize, modelDirectory, Options["Threads_NN_Inference"]);
+    // by default every search thread gets its own execution stream
+    const size_t numberStreams = int(options["OpenVINO_Streams"]) == 0 ? size_t(options["Threads"]) : size_t(options["OpenVINO_Streams"]);
+    // an explicit device like "AUTO" or "HETERO:GPU,CPU" overrides the context
+    const string device = string(options["OpenVINO_Device"]) == "<empty>" ? get_openvino_device(options["Context"], deviceId) : string(options["OpenVINO_Device"]);
+    return make_unique<OpenVinoAPI>(deviceId, batchSize, modelDirectory, options["Threads_NN_Inference"], numberStreams, netPrecision,
+                                    device, options["Engine_Cache_Directory"]);
+#elif defined ONNXRUNTIME
+    return make_unique<OnnxRuntimeAPI>(deviceId, batchSize, modelDirectory, options["Execution_Provider"], netPrecision,
+                                       options["Engine_Cache_Directory"], size_t(options["Threads_NN_Inference"]));
+#elif defined TORCH
+    return make_unique<TorchAPI>(options["Context"], deviceId, batchSize, modelDirectory, netPrecision == "float16",
+                                 bool(options["Channels_Last"]));
+#elif defined COREML
+    return make_unique<CoreMLAPI>(deviceId, batchSize, modelDirectory, options["Context"], netPrecision, options["Engine_Cache_Directory"]);
 #endif
     return nullptr;
 }
 
+vector<unique_ptr<NeuralNetAPI>> CrazyAra::create_overflow_nets(OptionsMap& options, const string& modelDirectory, unsigned int batchSize)
+{
+    vector<unique_ptr<NeuralNetAPI>> overflowNets;
+#ifdef OPENVINO
+    const size_t numberWorkers = size_t(options["Overflow_CPU_Workers"]);
+    for (size_t idx = 0; idx < numberWorkers; ++idx) {
+        // the workers share a compiled model with one execution stream each,
+        // float32 is used because the precision of the primary device may not be supported on the cpu
+        overflowNets.push_back(make_unique<OpenVinoAPI>(0, batchSize, modelDirectory, options["Threads_NN_Inference"], numberWorkers, "float32",
+                                                        "CPU", options["Engine_Cache_Directory"]));
+    }
+#endif
+    return overflowNets;
+}
+
 void CrazyAra::set_uci_option(istringstream &is, StateObj& state)
 {
     // these three UCI-Options may trigger a network reload, keep an eye on them
@@ -668,6 +2114,8 @@ void CrazyAra::set_uci_option(istringstream &is, StateObj& state)
     const string prevUciVariant = Options["UCI_Variant"];
     const int prevFirstDeviceID = Options["First_Device_ID"];
     const int prevLastDeviceID = Options["Last_Device_ID"];
+    const bool prevRootParallel = Options["Root_Parallel"];
+    const string prevDeviceConfig = Options["Device_Config"];
 #ifdef SUPPORT960
     const bool prevIs960 = Options["UCI_Chess960"];
 #else
@@ -683,13 +2131,22 @@ void CrazyAra::set_uci_option(istringstream &is, StateObj& state)
     changedUCIoption = true;
     if (networkLoaded) {
         if (string(Options["Model_Directory"]) != prevModelDir || int(Options["Threads"]) != prevThreads || string(Options["UCI_Variant"]) != prevUciVariant ||
-            int(Options["First_Device_ID"]) != prevFirstDeviceID || int(Options["Last_Device_ID"] != prevLastDeviceID) || prevIs960 != curIs960) {
+            int(Options["First_Device_ID"]) != prevFirstDeviceID || int(Options["Last_Device_ID"] != prevLastDeviceID) || prevIs960 != curIs960 ||
+            bool(Options["Root_Parallel"]) != prevRootParallel || string(Options["Device_Config"]) != prevDeviceConfig) {
             networkLoaded = false;
             is_ready<false>();
         }
     }
 }
 
+CrazyAra::MCTSAgentType CrazyAra::get_mcts_agent_type()
+{
+    if (bool(Options["Root_Parallel"]) && get_num_gpus(Options) > 1) {
+        return MCTSAgentType::kRootParallel;
+    }
+    return MCTSAgentType::kDefault;
+}
+
 unique_ptr<MCTSAgent> CrazyAra::create_new_mcts_agent(vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector, SearchSettings* searchSettings, MCTSAgentType type)
 {
     switch (type) {
@@ -712,10 +2169,13 @@ unique_ptr<MCTSAgent> CrazyAra::create_new_mcts_agent(vector<unique_ptr<NeuralNe
         return make_unique<MCTSAgentBatch>(netSingleVector, netBatchesVector, searchSettings, &playSettings , 5, true);
     case MCTSAgentType::kTrueSight:
         info_string("TYP 6 -> TrueSight");
-        return make_unique<MCTSAgentTrueSight>(netSingleVector, netBatchesVector, searchSettings, &playSettings);
+        return make_unique<MCTSAgentTrueSight>(netSingleVector, netBatchesVector, searchSettings, &playSettings, size_t(int(Options["TrueSight_Determinizations"])));
     case MCTSAgentType::kRandom:
         info_string("TYP 7 -> Random");
         return make_unique<MCTSAgentRandom>(netSingleVector, netBatchesVector, searchSettings, &playSettings);
+    case MCTSAgentType::kRootParallel:
+        info_string("TYP 8 -> Root Parallel");
+        return make_unique<MCTSAgentRootParallel>(netSingleVector, netBatchesVector, searchSettings, &playSettings, get_num_gpus(Options));
     
     default:
       info_string("Unknown MCTSAgentType");
@@ -723,13 +2183,61 @@ unique_ptr<MCTSAgent> CrazyAra::create_new_mcts_agent(vector<unique_ptr<NeuralNe
   }
 }
 
+void CrazyAra::start_metrics_exporter()
+{
+    if (metricsExporter != nullptr) {
+        return;
+    }
+    const int port = Options["Metrics_Port"];
+    const string statsdAddress = string(Options["Metrics_StatsD_Address"]);
+    if (port != 0 || statsdAddress != "<empty>") {
+        metricsExporter = make_unique<MetricsExporter>(port, statsdAddress == "<empty>" ? "" : statsdAddress);
+    }
+}
+
+void CrazyAra::start_device_monitor()
+{
+    const size_t intervalMS = Options["Device_Monitor_Interval_MS"];
+    if (intervalMS == 0) {
+        device_monitor().stop();
+        return;
+    }
+    vector<int> deviceIDs;
+    for (int deviceID = int(Options["First_Device_ID"]); deviceID <= int(Options["Last_Device_ID"]); ++deviceID) {
+        deviceIDs.emplace_back(deviceID);
+    }
+    if (device_monitor().start(deviceIDs, intervalMS)) {
+        info_string("sample the devices every", to_string(intervalMS) + " ms");
+    }
+}
+
 void CrazyAra::init_search_settings()
 {
     validate_device_indices(Options);
+    const string traceFile = string(Options["Trace_File"]);
+    trace_recorder().set_file(traceFile == "<empty>" ? "" : traceFile);
+    const string recordFile = string(Options["Inference_Record_File"]);
+    inference_recording().set_record_file(recordFile == "<empty>" ? "" : recordFile);
+    const string replayFile = string(Options["Inference_Replay_File"]);
+    inference_recording().set_replay_file(replayFile == "<empty>" ? "" : replayFile);
+#ifdef __linux__
+    const string rootStatsName = string(Options["Root_Stats_Shm"]);
+    try {
+        root_stats_feed().open(rootStatsName == "<empty>" ? "" : rootStatsName);
+    }
+    catch (const invalid_argument& e) {
+        info_string(e.what());
+    }
+    searchSettings.rootStatsIntervalMS = Options["Root_Stats_Interval_MS"];
+#endif
+    set_random_seed(uint64_t(int(Options["Random_Seed"])));
     searchSettings.multiPV = Options["MultiPV"];
-    searchSettings.threads = Options["Threads"] * get_num_gpus(Options);
+    searchSettings.threads = get_num_search_threads(Options);
     searchSettings.batchSize = Options["Batch_Size"];
+    searchSettings.minBatchSize = Options["Batch_Size_Min"];
     searchSettings.useMCGS = Options["Search_Type"] == "mcgs";
+    searchSettings.hashShards = Options["Hash_Shards"];
+    searchSettings.hashSize = Options["Hash_Size"];
     if (Options["Search_Player_Mode"] == "two_player") {
         searchSettings.searchPlayerMode = MODE_TWO_PLAYER;
     }
@@ -751,15 +2259,50 @@ void CrazyAra::init_search_settings()
     searchSettings.nodePolicyTemperature = Options["Centi_Node_Temperature"] / 100.0f;
     searchSettings.randomMoveFactor = Options["Centi_Random_Move_Factor"]  / 100.0f;
     searchSettings.allowEarlyStopping = Options["Allow_Early_Stopping"];
+    searchSettings.klStoppingInterval = Options["KL_Stopping_Interval"];
+    searchSettings.klStoppingGain = Options["Micro_KL_Stopping_Gain"] / 1000000.0;
+    searchSettings.asyncInference = Options["Async_Inference"];
+    searchSettings.batchBackup = Options["Batch_Backup"];
+    searchSettings.multiVisitCollisions = Options["Multi_Visit_Collisions"];
+    searchSettings.rootPrefill = Options["Root_Prefill"];
+    searchSettings.rootPrefillTopK = size_t(Options["Root_Prefill_Top_K"]);
+    searchSettings.numaPinning = Options["NUMA_Pinning"];
+    set_large_page_mode(str_to_large_page_mode(Options["Large_Pages"]));
+    searchSettings.searchCpus.clear();
+    inferenceCpus.clear();
+    if (int(Options["Search_Cores"]) > 0) {
+        // SMT siblings stay together, so that search and inference threads never share a physical core
+        split_cores(group_cpus_by_core(get_available_cpus()), size_t(int(Options["Search_Cores"])), searchSettings.searchCpus, inferenceCpus);
+        info_string("search threads run on", searchSettings.searchCpus.size(), "cpus, inference threads on " + to_string(inferenceCpus.size()) + " cpus");
+    }
+    searchSettings.subtreeSplitDepth = Options["Subtree_Split_Depth"];
+    searchSettings.memoryBudget = size_t(Options["Memory_Budget_MB"]) * 1024 * 1024;
+    searchSettings.evalCacheSize = size_t(Options["Eval_Cache_MB"]) * 1024 * 1024;
+    searchSettings.evalCacheSymmetry = Options["Eval_Cache_Symmetry"];
+    searchSettings.nnBookFile = string(Options["NN_Book"]) == "<empty>" ? "" : string(Options["NN_Book"]);
+    searchSettings.refineVisits = get_fast_model_directory(Options).empty() ? 0 : uint32_t(Options["Refine_Visits"]);
     useRawNetwork = Options["Use_Raw_Network"];
     searchSettings.useNPSTimemanager = Options["Use_NPS_Time_Manager"];
+    searchSettings.useStabilityTimeManager = Options["Use_Stability_Time_Manager"];
+    searchSettings.stabilityTimeMin = Options["Centi_Stability_Time_Min"] / 100.0f;
+    searchSettings.stabilityTimeMax = Options["Centi_Stability_Time_Max"] / 100.0f;
+    searchSettings.gumbelRoot = Options["Gumbel_Root"];
+    searchSettings.gumbelTopK = size_t(Options["Gumbel_Top_K"]);
+    searchSettings.gumbelCVisit = int(Options["Gumbel_C_Visit"]);
+    searchSettings.gumbelCScale = Options["Centi_Gumbel_C_Scale"] / 100.0f;
     if (string(Options["SyzygyPath"]).empty() || string(Options["SyzygyPath"]) == "<empty>") {
         searchSettings.useTablebase = false;
     }
     else {
         searchSettings.useTablebase = true;
     }
+#ifdef MCTS_TB_SUPPORT
+    tablebase_prober().init(searchSettings.useTablebase ? size_t(Options["Tablebase_Cache_MB"]) * 1024 * 1024 : 0,
+                            Options["Tablebase_Async_Probing"]);
+#endif
     searchSettings.reuseTree = Options["Reuse_Tree"];
+    searchSettings.reuseTreeMaxNodes = Options["Reuse_Tree_Max_Nodes"];
+    searchSettings.backgroundTreeMaintenance = Options["Background_Tree_Maintenance"];
     searchSettings.mctsSolver = Options["MCTS_Solver"];
     if (Options["Virtual_Style"] == "virtual_loss") {
         searchSettings.virtualStyle = VIRTUAL_LOSS;
@@ -800,9 +2343,44 @@ void CrazyAra::init_play_settings()
 #endif
 }
 
+vector<DeviceSpec> get_device_specs(OptionsMap& option)
+{
+    vector<DeviceSpec> devices;
+    const string config = option["Device_Config"];
+    try {
+        devices = parse_device_config(config, size_t(option["Threads"]), (unsigned int)int(option["Batch_Size"]), option["Precision"]);
+    }
+    catch (const invalid_argument& e) {
+        info_string_important("Invalid Device_Config:", e.what());
+        devices.clear();
+    }
+    if (devices.empty()) {
+        for (int deviceId = int(option["First_Device_ID"]); deviceId <= int(option["Last_Device_ID"]); ++deviceId) {
+            devices.push_back({to_string(deviceId), deviceId, size_t(option["Threads"]), (unsigned int)int(option["Batch_Size"]), option["Precision"], false});
+        }
+    }
+    scale_batch_sizes(devices, get_mps_share());
+    return devices;
+}
+
 size_t get_num_gpus(OptionsMap& option)
 {
-    return size_t(option["Last_Device_ID"] - option["First_Device_ID"] + 1);
+    return get_device_specs(option).size();
+}
+
+size_t get_num_search_threads(OptionsMap& option)
+{
+    size_t numberThreads = 0;
+    for (const DeviceSpec& device : get_device_specs(option)) {
+        numberThreads += device.threads;
+    }
+    return numberThreads;
+}
+
+string get_fast_model_directory(OptionsMap& option)
+{
+    const string fastModelDirectory = option["Fast_Model_Directory"];
+    return fastModelDirectory == "<empty>" ? "" : fastModelDirectory;
 }
 
 void validate_device_indices(OptionsMap& option)
@@ -815,24 +2393,3 @@ void validate_device_indices(OptionsMap& option)
         option["Last_Device_ID"] = option["First_Device_ID"];
     }
 }
-
-std::vector<std::string> comb(std::vector<int> N, int K)
-{
-    std::string bitmask(K, 1); // K leading 1's
-    bitmask.resize(N.size(), 0); // N-K trailing 0's
-    std::vector<std::string> p ;
-    // print integers and permute bitmask
-
-    do {
-        std::string c = "";
-        for (int i = 0; i < N.size(); ++i) // [0..N-1] integers
-        {
-            if (bitmask[i]){
-                c.append(std::to_string(N[i])+ " ");
-            }
-        }
-        p.push_back(c);
-    } while (std::prev_permutation(bitmask.begin(), bitmask.end()));
-
-    return p;
-}
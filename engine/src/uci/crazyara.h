@@ -29,22 +29,33 @@
 #define CRAZYARA_H
 
 #include <iostream>
+#include <atomic>
 
 #include "agents/rawnetagent.h"
 #include "agents/mctsagent.h"
 #include "agents/mctsagentbatch.h"
+#include "agents/mctsagentrootparallel.h"
 #include "agents/randomagent.h"
 #include "agents/mctsagenttruesight.h"
 #include "nn/neuralnetapi.h"
+#include "nn/deviceconfig.h"
+#include "nn/inferenceserver.h"
+#include "nn/shminferenceserver.h"
+#include "nn/tcpinferenceserver.h"
+#include "analysisserver.h"
+#include "distributedsearch.h"
+#include "util/metrics.h"
 #include "agents/config/searchsettings.h"
 #include "agents/config/searchlimits.h"
 #include "agents/config/playsettings.h"
 #include "node.h"
 #include "timeoutreadythread.h"
+#include "networkcache.h"
 #include <filesystem>
 namespace fs = std::filesystem;
 #ifdef USE_RL
 #include "rl/selfplay.h"
+#include "rl/coordinatorclient.h"
 #include "agents/config/rlsettings.h"
 #endif
 #ifdef SF_DEPENDENCY
@@ -57,6 +68,29 @@ using namespace CUSTOM_UCI;
 
 using namespace crazyara;
 
+/**
+ * @brief The ClientAgents struct owns additional MCTSAgents which share the inference servers of an existing set of networks.
+ * Every agent uses its own copy of the search settings.
+ */
+struct ClientAgents
+{
+    vector<SearchSettings> searchSettings;
+    vector<vector<unique_ptr<NeuralNetAPI>>> netSingleVectors;
+    vector<vector<vector<unique_ptr<NeuralNetAPI>>>> netBatchesVectors;
+    vector<unique_ptr<MCTSAgent>> agents;
+};
+
+/**
+ * @brief The NetLoadSettings struct is a snapshot of the settings which are read while the networks are created.
+ * The background loader of the deferred phase networks keeps its own copy, so that a later "setoption" can't change it.
+ */
+struct NetLoadSettings
+{
+    OptionsMap options;
+    unsigned int batchSize;
+    vector<int> inferenceCpus;
+};
+
 class CrazyAra
 {
 private:
@@ -82,12 +116,34 @@ private:
                     string("              ASCII-Art: Joan G. Stark, Chappell, Burton                      \n");
     unique_ptr<RawNetAgent> rawAgent;
     unique_ptr<MCTSAgent> mctsAgent;
+    // optional inference servers which are shared by the search threads (must outlive the client networks)
+    vector<unique_ptr<InferenceServer>> inferenceServers;
     vector<unique_ptr<NeuralNetAPI>> netSingleVector;
     vector<vector<unique_ptr<NeuralNetAPI>>> netBatchesVector;
+#ifdef __linux__
+    // shared memory inference server which is started by the "shmserver" command and serves other engine processes
+    unique_ptr<ShmInferenceServer> shmServer;
+#endif
+#ifndef _WIN32
+    // remote inference server which is started by the "tcpserver" command and serves engines on other machines
+    unique_ptr<TcpInferenceServer> tcpServer;
+    // agents of the sessions of the "analysisserver" command, they share the inference servers of the main agent
+    unique_ptr<ClientAgents> analysisAgents;
+    unique_ptr<AnalysisServer> analysisServer;
+#endif
+    // serves the process wide metrics if "Metrics_Port" or "Metrics_StatsD_Address" is set
+    unique_ptr<MetricsExporter> metricsExporter;
 #ifdef USE_RL
+    vector<unique_ptr<InferenceServer>> inferenceServersContender;
     vector<unique_ptr<NeuralNetAPI>> netSingleContenderVector;
     unique_ptr<MCTSAgent> mctsAgentContender;
     vector<vector<unique_ptr<NeuralNetAPI>>> netBatchesContenderVector;
+    // networks and search settings of the quick searches in selfplay (see Quick_Batch_Size) for the configuration quickNetworkKey
+    vector<unique_ptr<InferenceServer>> quickInferenceServers;
+    vector<unique_ptr<NeuralNetAPI>> quickNetSingleVector;
+    vector<vector<unique_ptr<NeuralNetAPI>>> quickNetBatchesVector;
+    SearchSettings quickSearchSettings;
+    string quickNetworkKey;
     RLSettings rlSettings;
 #endif
     SearchSettings searchSettings;
@@ -96,10 +152,37 @@ private:
     thread mainSearchThread;
     int variant;
 
+    // networks which are loaded in the background by "reloadmodel" and swapped in before the next search
+    thread reloadThread;
+    atomic<bool> isReloadFinished;
+    string reloadModelDirectory;
+    string reloadError;
+    vector<unique_ptr<InferenceServer>> reloadInferenceServers;
+    vector<unique_ptr<NeuralNetAPI>> reloadNetSingleVector;
+    vector<vector<unique_ptr<NeuralNetAPI>>> reloadNetBatchesVector;
+
+    // networks of previously used variants and model directories (see Network_Cache_MB)
+    NetworkCache networkCache;
+    // configuration of the current networks (see get_network_cache_key()) and their estimated device memory
+    string loadedNetworkKey;
+    size_t loadedNetworkBytes;
+
     bool useRawNetwork;
     bool networkLoaded;
     bool ongoingSearch;
     bool changedUCIoption;
+    // time for handling the last "position" command which is reported with the next move
+    float positionLatencyMS;
+    // state, start position and moves of the last "position" command, a following command which extends the moves only applies the new ones
+    const StateObj* lastPositionState;
+    string lastPositionStart;
+    vector<string> lastPositionMoves;
+    string lastPositionFen;
+    Action lastPositionMove;
+    // tablebase path whose files have been read ahead with Tablebase_Warm_Up
+    string warmedUpSyzygyPath;
+    // cpus of the inference threads if the cores are partitioned by Search_Cores (the networks are created on them)
+    vector<int> inferenceCpus;
 
 public:
     CrazyAra();
@@ -153,18 +236,48 @@ public:
 
     /**
      * @brief position Method which is called from the UCI command-line when a new position is described.
-     * This can be a FEN string or the starting position followed by a list of moves
+     * This can be a FEN string or the starting position followed by a list of moves.
+     * If the command extends the moves of the former command on the same state, only the new moves are applied.
      * @param pos Position object which will be set
      * @param is List of command line arguments which describe the position
      */
     void position(StateObj* pos, istringstream& is);
 
     /**
-     * @brief benchmark Runs a list of benchmark position for a given time
-     * @param is Movetime in ms
+     * @brief benchmark Runs a list of benchmark positions with a fixed node or time budget and reports NPS, latency and depth percentiles.
+     * Usage: benchmark [movetime <ms> | nodes <n>] [suite <file.epd>] [warmup <runs>] [trials <n>] [json <file>]
+     * "benchmark <ms>" is still supported. Without "suite" the built-in crazyhouse positions are used.
+     * @param is Command line arguments
      */
     void benchmark(istringstream& is);
 
+    /**
+     * @brief analyse Evaluates all positions of an EPD or PGN file and writes one JSON line per position.
+     * Usage: analyse <file.epd|file.pgn> <nodes> [out <file.jsonl>]
+     * With one node the positions are batched through the network without a search. Otherwise
+     * "Analysis_Concurrent_Positions" searches run at the same time and share the batched inference server.
+     * @param is Command line arguments
+     */
+    void analyse(istringstream& is);
+
+    /**
+     * @brief perft Counts the leaf nodes of the move tree of the current position and prints them for each root move (divide)
+     * together with the speed of the move generation.
+     * Usage: perft <depth> [threads <n>]
+     * @param state Current position
+     * @param is Command line arguments
+     */
+    void perft(const StateObj* state, istringstream& is);
+
+    /**
+     * @brief create_nn_book Evaluates all positions within the given number of plies from the current position with the
+     * batched networks and writes them to a book file which can be loaded with the "NN_Book" option.
+     * Usage: nnbook <plies> <file>
+     * @param state Current position
+     * @param is Command line arguments
+     */
+    void create_nn_book(const StateObj* state, istringstream& is);
+
     /**
      * @brief export_search_tree Exports the current search tree as a graph in a .gv/.dot-file
      * @param is Input stream. If no argument is given:
@@ -172,12 +285,46 @@ public:
      */
     void export_search_tree(istringstream& is);
 
+    /**
+     * @brief save_search_tree Saves the full tree of the last search as a snapshot: "savetree <filename>"
+     * @param is Input stream. If no argument is given, the filename is set to "tree.snapshot"
+     */
+    void save_search_tree(istringstream& is);
+
+    /**
+     * @brief load_search_tree Restores a snapshot and sets the current position to its root position: "loadtree <filename>".
+     * A following "go" continues the search on the restored tree.
+     * @param state Current position
+     * @param is Input stream. If no argument is given, the filename is set to "tree.snapshot"
+     */
+    void load_search_tree(StateObj* state, istringstream& is);
+
+    /**
+     * @brief search_stats Prints the time spent in the main search phases ("searchstats") or resets it ("searchstats reset")
+     * @param is Input stream
+     */
+    void search_stats(istringstream& is);
+
+    /**
+     * @brief memory_stats_command Prints the memory of the nodes, node data, hash tables, stored states, batch buffers and
+     * device buffers of the process in MB ("memstats")
+     */
+    void memory_stats_command();
+
     /**
      * @brief activeuci Prints the currently UCI options currently active in the binary.
      * The output format is "name <uci-option> value <uci-option-value>" followed by "readyok" at the very end.
      */
     void activeuci();
 
+    /**
+     * @brief reload_model Starts loading the networks of the given model directory in the background.
+     * The searches continue with the current networks until the new ones are swapped in by apply_reloaded_model(),
+     * selfplay and arena games wait for the new networks.
+     * @param is Model directory (optional, the UCI option Model_Directory is used by default)
+     */
+    void reload_model(istringstream& is);
+
 #ifdef USE_RL
     /**
      * @brief selfplay Starts self play for a given number of games
@@ -195,6 +342,18 @@ public:
      */
     void arena(istringstream &is);
 
+#ifndef _WIN32
+    /**
+     * @brief worker Runs the engine as a long-running worker of a distributed selfplay cluster: "worker [<host>:<port>]".
+     * The worker registers at the coordinator (UCI option Selfplay_Coordinator_Address by default) and executes the received
+     * "setoption", "reloadmodel", "selfplay <games>" and "arena <games> [<contender dir>]" jobs until "quit" is received.
+     * New models are loaded in the background and swapped in before the next job, so the process is never restarted.
+     * The samples are streamed to the replay buffer given by Selfplay_Publish_Address.
+     * @param is Address of the coordinator (optional)
+     */
+    void worker(istringstream &is);
+#endif
+
    /**
      * @brief multimodel_arena Alternative to the arena method which enables us to define two different models to use in the match and also define the mctsagent types to use.
      * @param is Input string representing both agent types and the number of games to play
@@ -207,6 +366,8 @@ public:
     /**
      * @brief roundrobin is an extension to the multimodel_arena method,
      * enabling the user to additionally define a model directory for each agent.
+     * Every model is loaded once. The pairings are distributed over Selfplay_Concurrent_Games workers
+     * and each result is appended to "mcts_arena_results.csv" as soon as its pairing is finished.
      * @param is Input string with the information about the number of games per match as well as tuples of agent types
      * and model directories. To increase usability the model directories are represented by numbers.
      * The folders with the models should be named m1,m2,...
@@ -217,13 +378,76 @@ public:
      * @brief init_rl_settings Initializes the rl settings used for the mcts agent with the current UCI parameters
      */
     void init_rl_settings();
+
+    /**
+     * @brief run_selfplay Generates the given number of selfplay games with Selfplay_Concurrent_Games games at the same time
+     * @param numberOfGames Number of games to generate
+     */
+    void run_selfplay(size_t numberOfGames);
+
+    /**
+     * @brief load_quick_networks Loads the networks of the quick searches in selfplay with Quick_Batch_Size and Quick_Threads
+     * and sets quickSearchSettings accordingly. The networks are kept as long as the configuration doesn't change.
+     * @return False if no separate networks are used for the quick searches
+     */
+    bool load_quick_networks();
+
+    /**
+     * @brief run_arena Plays the given number of arena games of the contender (Model_Directory_Contender) against the current model
+     * @param numberOfGames Number of games to play
+     * @param replace Returns true if the current model shall be replaced by the contender
+     * @return Result with respect to the contender
+     */
+    TournamentResult run_arena(size_t numberOfGames, bool& replace);
+
+#ifndef _WIN32
+    /**
+     * @brief execute_worker_job Executes a single command which was received from the coordinator
+     * @param token First word of the command
+     * @param is Remaining arguments of the command
+     * @param state Position which is changed by "setoption"
+     * @return Result line for the coordinator
+     */
+    string execute_worker_job(const string& token, istringstream& is, StateObj& state);
+#endif
 #endif
 
+    /**
+     * @brief fill_client_nn_vectors Creates new inference server clients which share the servers of the given networks.
+     * This allows several agents to batch their requests in the same evaluator.
+     * @param netBatchesVector Networks which are run by an InferenceServer
+     * @param clientSingleVector Vector which is filled with a client of batch size 1 for each phase
+     * @param clientBatchesVector Vector which is filled with a client of the same batch size for each network of netBatchesVector
+     */
+    void fill_client_nn_vectors(const vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector, vector<unique_ptr<NeuralNetAPI>>& clientSingleVector,
+                                vector<vector<unique_ptr<NeuralNetAPI>>>& clientBatchesVector);
+
+    /**
+     * @brief create_client_mcts_agents Creates MCTSAgents which share the inference servers of the given networks
+     * @param netBatchesVector Networks which are run by an InferenceServer
+     * @param numberAgents Number of agents to create
+     * @param type Type of the agents
+     * @param clientAgents Is filled with the agents and everything they reference
+     * @param settings Search settings which are copied for every agent, nullptr for the current search settings
+     */
+    void create_client_mcts_agents(const vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector, size_t numberAgents, MCTSAgentType type,
+                                   ClientAgents& clientAgents, const SearchSettings* settings = nullptr);
+
     /**
      * @brief init_search_settings Initializes the search settings with the current UCI parameters
      */
     void init_search_settings();
 
+    /**
+     * @brief start_device_monitor (Re)starts the NVML sampler for the devices First_Device_ID to Last_Device_ID if "Device_Monitor_Interval_MS" is set
+     */
+    void start_device_monitor();
+
+    /**
+     * @brief start_metrics_exporter Starts the metrics exporter once according to the UCI options "Metrics_Port" and "Metrics_StatsD_Address"
+     */
+    void start_metrics_exporter();
+
     /**
      * @brief init_play_settings Initializes the play settings with the current UCI parameters
      */
@@ -239,6 +463,11 @@ public:
      */
     void stop_search();
 
+    /**
+     * @brief ponderhit Continues the current ponder search under the regular time budget after the opponent played the expected move
+     */
+    void ponderhit();
+
     /**
      * @brief prepare_search_config_structs Prepare search configuration structs for new search
      */
@@ -248,7 +477,105 @@ public:
      * @brief inference Runs nn inference for X number times with Y warmups and reports the results.
      */
     void inference(istringstream &is);
+
+    /**
+     * @brief inference_sweep Measures the latency percentiles, the throughput and (if supported) the transfer and compute split
+     * of a fresh network for each combination of batch size and precision.
+     * @param batchSizes Batch sizes (the current Batch_Size if empty)
+     * @param precisions Precisions (the current Precision if empty)
+     * @param warmupIterations Predictions which are not measured
+     * @param iterations Measured predictions for each configuration
+     * @param saveFile If not empty, the best configuration is written as setoption commands to this file and applied to the engine
+     */
+    void inference_sweep(vector<unsigned int> batchSizes, vector<string> precisions, size_t warmupIterations, size_t iterations,
+                         const string& saveFile);
+
+    /**
+     * @brief tune_search_cores Searches the start position of the benchmark for each candidate number of physical search cores,
+     * sets Search_Cores to the one with the highest NPS and reloads the networks with this partition.
+     * Usage: "tunecores [movetime in ms]"
+     */
+    void tune_search_cores(istringstream& is);
+
+    /**
+     * @brief warmup Loads all configured networks, so that missing engines and OpenVINO compiled models are built and cached before the first game
+     */
+    void warmup();
+
+    /**
+     * @brief shm_server Loads the networks of all devices and serves them to other engine processes
+     * over the shared memory segment given by the UCI option Inference_Server_Shm until "quit" is received
+     */
+    void shm_server();
+
+    /**
+     * @brief tcp_server Loads the networks of all devices and serves them to engines on other machines
+     * on the port given by the UCI option Inference_Server_Port until "quit" is received
+     */
+    void tcp_server();
+
+    /**
+     * @brief analysis_server Serves independent analysis sessions over TCP which share the loaded networks and the batched inference server.
+     * The port, the number of sessions and the node budget of a search are given by the UCI options Analysis_Server_Port,
+     * Analysis_Server_Sessions and Analysis_Server_Max_Nodes. The server runs until the networks are reloaded or "quit" is received.
+     */
+    void analysis_server();
+
+    /**
+     * @brief distributed_search Searches the current position on the analysis servers given by the UCI option Distributed_Search_Shards,
+     * each of them owns the subtrees of a part of the root moves (see distributedsearch.h).
+     * Usage: distsearch <nodes>
+     * @param state Current position
+     * @param is Command line arguments
+     */
+    void distributed_search(const StateObj* state, istringstream& is);
+
+    /**
+     * @brief set_option Sets the UCI option with the given name as if "setoption name <name> value <value>" was received
+     * @param name Option name
+     * @param value Option value
+     */
+    void set_option(const string& name, const string& value);
+
+    /**
+     * @brief get_mcts_agent Returns the search agent of the engine. The networks are loaded first if needed.
+     * @return MCTSAgent which is owned by the engine
+     */
+    MCTSAgent* get_mcts_agent();
+
+    /**
+     * @brief get_raw_agent Returns the agent which evaluates a position with a single network prediction.
+     * The networks are loaded first if needed.
+     * @return RawNetAgent which is owned by the engine
+     */
+    RawNetAgent* get_raw_agent();
+
+    /**
+     * @brief evaluate_states Evaluates the given positions in mini-batches of the batched networks without a search
+     * @param states Positions to evaluate
+     * @param evalInfos Output, the network evaluation of each position
+     */
+    void evaluate_states(const vector<unique_ptr<StateObj>>& states, vector<EvalInfo>& evalInfos);
+
+    /**
+     * @brief get_variant Returns the variant of the UCI option UCI_Variant
+     */
+    int get_variant() const;
 private:
+    /**
+     * @brief create_server_nets Creates Inference_Server_Workers networks with the batch size Inference_Server_Batch_Size for every device
+     * @return Networks for a standalone inference server
+     */
+    vector<unique_ptr<NeuralNetAPI>> create_server_nets();
+
+    /**
+     * @brief apply_reloaded_model Replaces the networks and the agents by the networks of a finished reload.
+     * The new agents start with an empty search tree and an empty evaluation cache.
+     * Must only be called between two searches.
+     * @param waitForReload If true, a reload which is still running is awaited, otherwise it is applied before a later search
+     */
+    void apply_reloaded_model(bool waitForReload = false);
+
     /**
      * @brief engine_info Returns a string about the engine version and authors
      * @return string
@@ -265,8 +592,15 @@ private:
     kBatch5_reducedNodes = 5,   // 5 MCTS agents with majority vote at the end. The amount of nodes are splitted between all agents
     kTrueSight = 6,             // True Sight Agent, which uses the perfect information state instead of the imperfect information state
     kRandom = 7,                // plays random legal moves
+    kRootParallel = 8,          // one MCTS agent per GPU, the root statistics of the trees are shared during the search
 };
 
+    /**
+     * @brief get_mcts_agent_type Returns the agent type for the engine's own search based on the UCI option "Root_Parallel"
+     * @return MCTSAgentType
+     */
+    MCTSAgentType get_mcts_agent_type();
+
     /**
      * @brief create_new_mcts_agent Factory method to create a new MCTSAgent when loading new neural network weights
      * @param modelDirectory Directory where the .params and .json files are stored
@@ -279,30 +613,84 @@ private:
      */
     unique_ptr<MCTSAgent> create_new_mcts_agent(vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector, SearchSettings* searchSettings, MCTSAgentType type = MCTSAgentType::kDefault);
 
+    /**
+     * @brief get_network_cache_key Returns the options which determine the loaded networks as a single string
+     */
+    string get_network_cache_key() const;
+
+    /**
+     * @brief load_networks Loads the networks of the current options into netSingleVector, netBatchesVector and inferenceServers.
+     * The previous networks are moved into the network cache and cached networks of the current options are reused.
+     */
+    void load_networks();
+
     /**
      * @brief create_new_net Factory to create and load a new model from a given directory
+     * @param options UCI options of the back-end
      * @param modelDirectory Model directory where the .onnx file is stored.
      * @param deviceId Device index that will be used for inference.
      * @param batchSize Mini batch size used for inference.
+     * @param precision Inference precision (the UCI option Precision is used if empty)
      * @return Pointer to the newly created object
      */
-    unique_ptr<NeuralNetAPI> create_new_net(const string& modelDirectory, int deviceId, unsigned int batchSize);
+    unique_ptr<NeuralNetAPI> create_new_net(OptionsMap& options, const string& modelDirectory, int deviceId, unsigned int batchSize, const string& precision="");
+
+    /**
+     * @brief create_backend_net Creates the network of the compiled back-end or the null back-end without a recording or replay
+     */
+    unique_ptr<NeuralNetAPI> create_backend_net(OptionsMap& options, const string& modelDirectory, int deviceId, unsigned int batchSize, const string& precision);
+
+    /**
+     * @brief create_overflow_nets Creates the cpu networks of the overflow workers of an inference server (requires the OpenVINO back-end)
+     * @param options UCI options of the back-end
+     * @param modelDirectory Model directory where the .onnx file is stored.
+     * @param batchSize Batch size of the inference server
+     * @return Networks for the UCI option Overflow_CPU_Workers, empty if the option is 0 or OpenVINO isn't available
+     */
+    vector<unique_ptr<NeuralNetAPI>> create_overflow_nets(OptionsMap& options, const string& modelDirectory, unsigned int batchSize);
+
+    /**
+     * @brief use_inference_server Returns true if the search threads are clients of in-process inference servers
+     * (UCI options Inference_Server, Selfplay_Concurrent_Games, Analysis_Concurrent_Positions and Overflow_CPU_Workers)
+     */
+    bool use_inference_server(OptionsMap& options) const;
 
     /**
      * @brief fill_single_nn_vector Fills a single phase in netSingleVector and netBatchesVector with a loaded neural network.
+     * @param loadSettings Settings of the networks
      * @param modelDirectory Model directory where the .onnx file is stored.
      * @param netSingleVector Vector of neural networks with batch-size 1
      * @param netBatchesVector Vector of neural networks with batch-size > 1
+     * @param inferenceServers Inference servers which are created if the UCI option Inference_Server is enabled
+     * @param deviceThreadCounts Number of search threads of each device. If empty, it is filled on the first call, either evenly
+     * or in proportion to the measured throughput of the devices if the UCI option Device_Load_Balancing is enabled.
+     * All phases use the same distribution.
      */
-    void fill_single_nn_vector(const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector);
+    void fill_single_nn_vector(NetLoadSettings& loadSettings, const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
+                               vector<unique_ptr<InferenceServer>>& inferenceServers, vector<size_t>& deviceThreadCounts);
+
+    /**
+     * @brief add_fast_nets Appends the network of the UCI option Fast_Model_Directory behind the phase networks of every search thread.
+     * Throws an invalid_argument exception if its input and policy representation differ from the main network.
+     * @param loadSettings Settings of the networks
+     * @param netBatchesVector Vector of neural networks with batch-size > 1
+     * @param inferenceServers Inference servers which are created if the UCI option Inference_Server is enabled
+     * @param deviceThreadCounts Number of search threads of each device
+     */
+    void add_fast_nets(NetLoadSettings& loadSettings, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector, vector<unique_ptr<InferenceServer>>& inferenceServers,
+                       vector<size_t>& deviceThreadCounts);
 
     /**
      * @brief fill_nn_vectors Fills the given neural network vectors with loaded neural network models.
+     * If the UCI option Lazy_Phase_Loading is enabled, only the network of the first game phase is loaded,
+     * the others are loaded in the background and represented by DeferredNetAPI placeholders meanwhile.
      * @param modelDirectory Model directory where the .onnx file is stored.
      * @param netSingleVector Vector of neural networks with batch-size 1
      * @param netBatchesVector Vector of neural networks with batch-size > 1
+     * @param inferenceServers Inference servers which are created if the UCI option Inference_Server is enabled
      */
-    void fill_nn_vectors(const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector);
+    void fill_nn_vectors(const string& modelDirectory, vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector,
+                         vector<unique_ptr<InferenceServer>>& inferenceServers);
 
     /**
      * @brief set_uci_option Updates an UCI option using the given input stream and set changedUCIoption to true.
@@ -314,22 +702,33 @@ private:
 };
 
 /**
- * @brief get_num_gpus Returns the number of GPU based on the UCI settings "First_Device_ID" and "Last_Device_ID"
+ * @brief get_device_specs Returns the inference devices of the UCI option "Device_Config".
+ * If it is empty or invalid, the devices "First_Device_ID" to "Last_Device_ID" with "Threads", "Batch_Size" and "Precision" are used.
+ * The batch sizes which aren't given explicitly are reduced to the share of the GPU if the process is a restricted MPS client.
+ * @return Device specifications
+ */
+vector<DeviceSpec> get_device_specs(OptionsMap& option);
+
+/**
+ * @brief get_num_gpus Returns the number of GPU based on get_device_specs()
  * @return number of gpus
  */
 size_t get_num_gpus(OptionsMap& option);
 
+/**
+ * @brief get_num_search_threads Returns the total number of search threads over all devices of get_device_specs()
+ */
+size_t get_num_search_threads(OptionsMap& option);
+
+/**
+ * @brief get_fast_model_directory Returns the directory of the fast network for the two-tier evaluation (empty if it is disabled)
+ */
+string get_fast_model_directory(OptionsMap& option);
+
 /**
  * @brief validate_device_indices Valdiates if the "Last_Device_ID" >= "First_Device_ID"
  * @param option
  */
 void validate_device_indices(OptionsMap& option);
 
-/**
-* @brief Calculates all combinations of size K out of set N
-* @param N a set of numbers
-* @param K the size of the combination tuples (2 results in all possible number combinations)
-*/
-std::vector<std::string> comb(std::vector<int> N, int K);
-
 #endif // CRAZYARA_H
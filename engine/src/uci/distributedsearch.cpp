@@ -0,0 +1,209 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: distributedsearch.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#ifndef _WIN32
+#include "distributedsearch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include "util/communication.h"
+#include "util/tcpsocket.h"
+
+using namespace std;
+
+size_t select_sharded_move(const vector<ShardedRootMove>& moves, size_t shardIdx, float cpuct)
+{
+    size_t parentVisits = 1;
+    for (const ShardedRootMove& move : moves) {
+        parentVisits += move.nodes + move.pendingNodes;
+    }
+    const float sqrtParentVisits = sqrt(float(parentVisits));
+    size_t bestIdx = moves.size();
+    float bestScore = -numeric_limits<float>::infinity();
+    for (size_t idx = 0; idx < moves.size(); ++idx) {
+        const ShardedRootMove& move = moves[idx];
+        if (move.shardIdx != shardIdx || move.pendingNodes != 0 || move.isFailed) {
+            continue;
+        }
+        const float score = move.q + cpuct * move.prior * sqrtParentVisits / (1 + move.nodes);
+        if (score > bestScore) {
+            bestScore = score;
+            bestIdx = idx;
+        }
+    }
+    return bestIdx;
+}
+
+bool parse_json_number(const string& line, const string& key, double& value)
+{
+    const string field = "\"" + key + "\": ";
+    const size_t pos = line.find(field);
+    if (pos == string::npos) {
+        return false;
+    }
+    const char* start = line.c_str() + pos + field.size();
+    char* end;
+    value = strtod(start, &end);
+    return end != start;
+}
+
+DistributedSearch::DistributedSearch(const vector<string>& addresses, size_t slotsPerShard, size_t chunkNodes, float cpuct):
+    addresses(addresses),
+    slotsPerShard(slotsPerShard),
+    chunkNodes(max(chunkNodes, size_t(1))),
+    cpuct(cpuct),
+    remainingNodes(0)
+{
+    if (addresses.empty()) {
+        throw invalid_argument("The distributed search requires the address of at least one analysis server.");
+    }
+}
+
+DistributedSearch::~DistributedSearch()
+{
+    for (int fd : sessionFds) {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+}
+
+vector<ShardedRootMove> DistributedSearch::run(const string& fen, const vector<string>& rootMoves, const vector<float>& priors, size_t nodes)
+{
+    rootFen = fen;
+    vector<size_t> order(rootMoves.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&priors](size_t lhs, size_t rhs) { return priors[lhs] > priors[rhs]; });
+    moves.clear();
+    for (size_t rank = 0; rank < order.size(); ++rank) {
+        ShardedRootMove move;
+        move.move = rootMoves[order[rank]];
+        move.prior = priors[order[rank]];
+        move.shardIdx = rank % addresses.size();
+        moves.push_back(move);
+    }
+    for (int fd : sessionFds) {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+    sessionFds.assign(moves.size(), -1);
+    pendingBytes.assign(moves.size(), "");
+    remainingNodes = nodes;
+
+    vector<thread> slots;
+    for (size_t shardIdx = 0; shardIdx < addresses.size(); ++shardIdx) {
+        for (size_t slotIdx = 0; slotIdx < slotsPerShard; ++slotIdx) {
+            slots.emplace_back(&DistributedSearch::run_slot, this, shardIdx);
+        }
+    }
+    for (thread& slot : slots) {
+        slot.join();
+    }
+    return moves;
+}
+
+void DistributedSearch::run_slot(size_t shardIdx)
+{
+    while (true) {
+        size_t moveIdx;
+        size_t nodes;
+        {
+            lock_guard<mutex> lock(mtx);
+            if (remainingNodes == 0) {
+                return;
+            }
+            moveIdx = select_sharded_move(moves, shardIdx, cpuct);
+            if (moveIdx == moves.size()) {
+                // all subtrees of the node are searched by other slots or failed
+                return;
+            }
+            nodes = min(chunkNodes, remainingNodes);
+            remainingNodes -= nodes;
+            moves[moveIdx].pendingNodes = nodes;
+        }
+        size_t totalNodes;
+        float q;
+        const bool isSearched = search_move(moveIdx, nodes, totalNodes, q);
+
+        lock_guard<mutex> lock(mtx);
+        ShardedRootMove& move = moves[moveIdx];
+        move.pendingNodes = 0;
+        if (isSearched) {
+            move.nodes = totalNodes;
+            move.q = q;
+        }
+        else {
+            // the budget is spent on the other subtrees
+            info_string("the remote search of", move.move + " on " + addresses[shardIdx] + " failed");
+            move.isFailed = true;
+            remainingNodes += nodes;
+        }
+    }
+}
+
+bool DistributedSearch::search_move(size_t moveIdx, size_t nodes, size_t& totalNodes, float& q)
+{
+    const ShardedRootMove& move = moves[moveIdx];
+    int& fd = sessionFds[moveIdx];
+    string& pending = pendingBytes[moveIdx];
+    string reply;
+    if (fd == -1) {
+        try {
+            fd = connect_to_address(addresses[move.shardIdx]);
+        }
+        catch (const invalid_argument& e) {
+            info_string(e.what());
+            return false;
+        }
+        if (fd == -1) {
+            return false;
+        }
+        set_no_delay(fd);
+        // the session keeps the subtree of the move for all following searches
+        if (!send_line(fd, "position fen " + rootFen + " moves " + move.move) || !recv_line(fd, pending, reply) || reply != "ok") {
+            return false;
+        }
+    }
+    if (!send_line(fd, "go nodes " + to_string(move.nodes + nodes)) || !recv_line(fd, pending, reply)) {
+        return false;
+    }
+    double nodesValue;
+    double qValue;
+    if (!parse_json_number(reply, "nodes", nodesValue) || !parse_json_number(reply, "q", qValue)) {
+        // e.g. the move ends the game or the session reported an error
+        return false;
+    }
+    totalNodes = size_t(nodesValue);
+    // the remote side evaluates the position of the opponent
+    q = -float(qValue);
+    return true;
+}
+#endif
@@ -0,0 +1,137 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: distributedsearch.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Distributed search of a single position over several engine nodes ("distsearch" command).
+ * The tree is sharded by the subtrees of the root moves: each root move is owned by one node, where a session of its
+ * analysis server (see analysisserver.h) keeps the subtree of this move in memory over the whole search.
+ * The root node itself lives on the coordinating engine, which assigns the budget in chunks of nodes to the subtrees with the PUCT formula.
+ * The nodes of a running chunk already count towards the visits of the root, while its subtree is blocked for further chunks
+ * (virtual loss), and the statistics of a subtree are updated asynchronously as soon as its remote search returns.
+ */
+
+#ifndef DISTRIBUTEDSEARCH_H
+#define DISTRIBUTEDSEARCH_H
+
+#ifndef _WIN32
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The ShardedRootMove struct describes the subtree of a root move which is owned by a remote node
+ */
+struct ShardedRootMove
+{
+    // move in uci notation
+    std::string move;
+    float prior = 0;
+    // index of the node which owns the subtree
+    size_t shardIdx = 0;
+    // number of nodes of the remote subtree
+    size_t nodes = 0;
+    // value of the move from the point of view of the side to move at the root
+    float q = -1;
+    // nodes of the running remote search (0 if the subtree isn't searched at the moment)
+    size_t pendingNodes = 0;
+    // the subtree is excluded if its remote session couldn't be used
+    bool isFailed = false;
+};
+
+/**
+ * @brief select_sharded_move Selects the root move whose subtree receives the next chunk of nodes
+ * @param moves Root moves
+ * @param shardIdx Only moves of this node are considered which aren't searched at the moment
+ * @param cpuct Exploration constant of the PUCT formula
+ * @return Index of the move or moves.size() if there is no candidate
+ */
+size_t select_sharded_move(const std::vector<ShardedRootMove>& moves, size_t shardIdx, float cpuct);
+
+/**
+ * @brief parse_json_number Returns the value of a numeric field of a flat JSON line
+ * @param line JSON line
+ * @param key Field name
+ * @param value Output value
+ * @return False if the field doesn't exist
+ */
+bool parse_json_number(const std::string& line, const std::string& key, double& value);
+
+class DistributedSearch
+{
+private:
+    std::vector<std::string> addresses;
+    size_t slotsPerShard;
+    size_t chunkNodes;
+    float cpuct;
+
+    std::string rootFen;
+    std::vector<ShardedRootMove> moves;
+    // remote sessions of the moves (-1 if not connected yet)
+    std::vector<int> sessionFds;
+    std::vector<std::string> pendingBytes;
+    size_t remainingNodes;
+    std::mutex mtx;
+
+    /**
+     * @brief run_slot Runs one remote search of a node at a time until the budget has been used up
+     * @param shardIdx Index of the node
+     */
+    void run_slot(size_t shardIdx);
+
+    /**
+     * @brief search_move Runs a remote search of the subtree of a move with the given number of additional nodes
+     * @param moveIdx Index of the move
+     * @param nodes Number of additional nodes
+     * @param totalNodes Output: nodes of the remote subtree after the search
+     * @param q Output: value of the move from the point of view of the root
+     * @return False if the session failed
+     */
+    bool search_move(size_t moveIdx, size_t nodes, size_t& totalNodes, float& q);
+
+public:
+    /**
+     * @brief DistributedSearch
+     * @param addresses Addresses of the analysis servers in the form <host>:<port>
+     * @param slotsPerShard Number of concurrent remote searches per node
+     * @param chunkNodes Number of nodes of a single remote search
+     * @param cpuct Exploration constant of the root node
+     */
+    DistributedSearch(const std::vector<std::string>& addresses, size_t slotsPerShard, size_t chunkNodes, float cpuct);
+    ~DistributedSearch();
+    DistributedSearch(const DistributedSearch&) = delete;
+
+    /**
+     * @brief run Searches the given position and returns the statistics of all root moves.
+     * The moves are assigned round robin by their prior to the nodes, so that each node owns good and bad candidates.
+     * @param fen Root position
+     * @param rootMoves Legal moves in uci notation
+     * @param priors Prior probabilities of the moves
+     * @param nodes Total budget of nodes
+     * @return Root moves with their statistics
+     */
+    std::vector<ShardedRootMove> run(const std::string& fen, const std::vector<std::string>& rootMoves, const std::vector<float>& priors, size_t nodes);
+};
+#endif
+
+#endif // DISTRIBUTEDSEARCH_H
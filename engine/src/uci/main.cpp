@@ -32,7 +32,7 @@
 #include <iostream>
 #include "crazyara.h"
 
-#ifndef BUILD_TESTS
+#if !defined(BUILD_TESTS) && !defined(BUILD_MICROBENCHMARKS) && !defined(BUILD_PYTHON_BINDINGS)
 int main(int argc, char* argv[]) {
 #ifdef XIANGQI
     variants.init();
@@ -0,0 +1,113 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: networkcache.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "networkcache.h"
+#include <algorithm>
+#include <filesystem>
+
+NetworkCache::NetworkCache():
+    budgetBytes(0),
+    memoryBytes(0)
+{
+}
+
+void NetworkCache::set_budget(size_t budgetBytes)
+{
+    this->budgetBytes = budgetBytes;
+    evict();
+}
+
+void NetworkCache::put(const std::string& key, size_t memoryBytes, LoadedNetworks&& networks)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->key == key) {
+            this->memoryBytes -= it->memoryBytes;
+            entries.erase(it);
+            break;
+        }
+    }
+    if (memoryBytes > budgetBytes) {
+        return;
+    }
+    entries.push_front(Entry{key, memoryBytes, std::move(networks)});
+    this->memoryBytes += memoryBytes;
+    evict();
+}
+
+bool NetworkCache::take(const std::string& key, LoadedNetworks& networks)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->key == key) {
+            networks = std::move(it->networks);
+            memoryBytes -= it->memoryBytes;
+            entries.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void NetworkCache::clear()
+{
+    entries.clear();
+    memoryBytes = 0;
+}
+
+size_t NetworkCache::size() const
+{
+    return entries.size();
+}
+
+size_t NetworkCache::get_memory_bytes() const
+{
+    return memoryBytes;
+}
+
+void NetworkCache::evict()
+{
+    while (!entries.empty() && memoryBytes > budgetBytes) {
+        memoryBytes -= entries.back().memoryBytes;
+        entries.pop_back();
+    }
+}
+
+size_t estimate_network_memory(const std::string& modelDirectory, size_t numberNetworks)
+{
+    size_t weightBytes = 0;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(modelDirectory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        // unreadable files are skipped without stopping the iteration
+        std::error_code fileError;
+        if (!it->is_regular_file(fileError)) {
+            continue;
+        }
+        const uintmax_t fileBytes = it->file_size(fileError);
+        if (!fileError) {
+            weightBytes = std::max(weightBytes, size_t(fileBytes));
+        }
+    }
+    return weightBytes * numberNetworks;
+}
@@ -0,0 +1,116 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: networkcache.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Least recently used cache of loaded networks. Switching the variant or the model directory moves the current networks
+ * into the cache instead of releasing them, so that switching back (e.g. a lichess bot alternating variants between games)
+ * doesn't rebuild the networks. The cache is bounded by an estimate of the device memory of its networks.
+ */
+
+#ifndef NETWORKCACHE_H
+#define NETWORKCACHE_H
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include "nn/neuralnetapi.h"
+#include "nn/inferenceserver.h"
+
+/**
+ * @brief The LoadedNetworks struct owns the networks of a single model directory
+ */
+struct LoadedNetworks
+{
+    // the servers are declared first to be released after their clients
+    vector<unique_ptr<InferenceServer>> inferenceServers;
+    vector<unique_ptr<NeuralNetAPI>> netSingleVector;
+    vector<vector<unique_ptr<NeuralNetAPI>>> netBatchesVector;
+};
+
+/**
+ * @brief The NetworkCache class keeps the networks of recently used configurations ordered by their last use
+ */
+class NetworkCache
+{
+private:
+    struct Entry
+    {
+        std::string key;
+        size_t memoryBytes;
+        LoadedNetworks networks;
+    };
+    // the most recently used entry is at the front
+    std::list<Entry> entries;
+    size_t budgetBytes;
+    size_t memoryBytes;
+
+public:
+    NetworkCache();
+
+    /**
+     * @brief set_budget Sets the memory budget and releases the least recently used networks which exceed it
+     * @param budgetBytes Budget in bytes, 0 disables the cache
+     */
+    void set_budget(size_t budgetBytes);
+
+    /**
+     * @brief put Adds networks which aren't used anymore. Networks which exceed the budget on their own are released.
+     * @param key Configuration from which the networks have been created
+     * @param memoryBytes Estimated device memory of the networks
+     * @param networks Networks which are moved into the cache
+     */
+    void put(const std::string& key, size_t memoryBytes, LoadedNetworks&& networks);
+
+    /**
+     * @brief take Moves the cached networks of the given configuration out of the cache
+     * @return True if networks of the configuration have been cached
+     */
+    bool take(const std::string& key, LoadedNetworks& networks);
+
+    /**
+     * @brief clear Releases all cached networks
+     */
+    void clear();
+
+    size_t size() const;
+    size_t get_memory_bytes() const;
+
+private:
+    /**
+     * @brief evict Releases the least recently used networks until the budget is met
+     */
+    void evict();
+};
+
+/**
+ * @brief estimate_network_memory Returns a rough upper bound of the device memory of the given number of networks.
+ * Every network is assumed to hold a copy of the weights whose size is approximated by the largest model file in the directory.
+ * @param modelDirectory Model directory of the networks
+ * @param numberNetworks Number of loaded networks
+ * @return Memory in bytes
+ */
+size_t estimate_network_memory(const std::string& modelDirectory, size_t numberNetworks);
+
+#endif // NETWORKCACHE_H
@@ -41,11 +41,29 @@
 #endif
 #include "../util/communication.h"
 #include "../nn/neuralnetapi.h"
+#include "../util/tablebaseprober.h"
+#include "../util/asyncoutput.h"
+#include "../constants.h"
 
 using namespace std;
 
 void on_logger(const Option& o) {
+    // the logger must wrap the stream buffer of the terminal, so that the file is also written by the output thread
+    const bool isAsyncOutput = is_async_output_active();
+    stop_async_output();
     CustomLogger::start(o, ifstream::app);
+    if (isAsyncOutput) {
+        start_async_output();
+    }
+}
+
+void on_async_output(const Option& o) {
+    if (o) {
+        start_async_output();
+    }
+    else {
+        stop_async_output();
+    }
 }
 
 // method is based on 3rdparty/Stockfish/misc.cpp
@@ -59,6 +77,9 @@ inline TimePoint current_time() {
 #if !defined(MODE_XIANGQI) && !defined(MODE_BOARDGAMES)
 void on_tb_path(const Option& o) {
     Tablebases::init(UCI::variant_from_name(Options["UCI_Variant"]), Options["SyzygyPath"]);
+#ifdef MCTS_TB_SUPPORT
+    tablebase_prober().clear();
+#endif
 }
 #endif
 #endif
@@ -66,6 +87,16 @@ void on_tb_path(const Option& o) {
 void OptionsUCI::init(OptionsMap &o)
 {
     o["Allow_Early_Stopping"]          << Option(true);
+    o["Analysis_Concurrent_Positions"] << Option(1, 1, 512);
+#ifndef _WIN32
+    o["Analysis_Server_Max_Nodes"]     << Option(100000, 1, 99999999);
+    o["Analysis_Server_Port"]          << Option(5557, 1, 65535);
+    o["Analysis_Server_Sessions"]      << Option(8, 1, 512);
+#endif
+    o["Async_Inference"]               << Option(false);
+    o["Async_Output"]                  << Option(true, on_async_output);
+    o["Background_Tree_Maintenance"]   << Option(true);
+    o["Batch_Backup"]                  << Option(false);
 #ifdef USE_RL
     o["Batch_Size"]                    << Option(8, 1, 8192);
 #else
@@ -78,6 +109,10 @@ void OptionsUCI::init(OptionsMap &o)
     o["Batch_Size"]                    << Option(16, 1, 8192);
 #endif
 #endif
+#endif
+    o["Batch_Size_Min"]                << Option(0, 0, 8192);
+#ifdef TENSORRT
+    o["Calibration_File"]              << Option("");
 #endif
     o["Centi_CPuct_Init"]              << Option(250, 1, 99999);
 #ifdef USE_RL
@@ -88,6 +123,7 @@ void OptionsUCI::init(OptionsMap &o)
     o["Centi_Dirichlet_Alpha"]         << Option(20, 1, 99999);
     o["Centi_Epsilon_Checks"]          << Option(1, 0, 100);
     o["Centi_Epsilon_Greedy"]          << Option(5, 0, 100);
+    o["Centi_Gumbel_C_Scale"]          << Option(100, 1, 99999);
 //    o["Centi_U_Init"]                  << Option(100, 0, 100);         currently disabled
 //    o["Centi_U_Min"]                   << Option(100, 0, 100);         currently disabled
 //    o["U_Base"]                        << Option(1965, 0, 99999);      currently disabled
@@ -104,6 +140,8 @@ void OptionsUCI::init(OptionsMap &o)
     o["Centi_Quantile_Clipping"]       << Option(25, 0, 100);
 #endif
     o["Centi_Random_Move_Factor"]      << Option(0, 0, 99);
+    o["Centi_Stability_Time_Max"]      << Option(200, 100, 1000);
+    o["Centi_Stability_Time_Min"]      << Option(50, 1, 100);
 #ifdef USE_RL
     o["Centi_Temperature"]             << Option(80, 0, 99999);
 #else
@@ -111,44 +149,141 @@ void OptionsUCI::init(OptionsMap &o)
 #endif
     o["Centi_Temperature_Decay"]       << Option(92, 0, 100);
     o["Centi_U_Init_Divisor"]          << Option(100, 1, 99999);
+#ifdef TORCH
+    o["Channels_Last"]                 << Option(false);
+#endif
 #if defined(MXNET) && defined(TENSORRT)
     o["Context"]                       << Option("gpu", {"cpu", "gpu"});
 #elif defined (TORCH)
     o["Context"]                       << Option("gpu", {"cpu", "gpu"});
 #elif defined (TENSORRT)
     o["Context"]                       << Option("gpu", {"gpu"});
+#elif defined (OPENVINO)
+    o["Context"]                       << Option("cpu", {"cpu", "gpu", "npu"});
+#elif defined (COREML)
+    o["Context"]                       << Option("all", {"all", "cpu", "gpu", "ane"});
 #else
     o["Context"]                       << Option("cpu");
 #endif
     o["CPuct_Base"]                    << Option(19652, 1, 99999);
+    o["Device_Config"]                 << Option("");
+    o["Device_Load_Balancing"]         << Option(false);
+    o["Device_Monitor_Interval_MS"]    << Option(0, 0, 60000);
+#ifndef _WIN32
+    o["Distributed_Search_Chunk_Nodes"] << Option(1000, 1, 99999999);
+    o["Distributed_Search_Shards"]     << Option("");
+    o["Distributed_Search_Slots"]      << Option(2, 1, 64);
+#endif
+#ifdef TENSORRT
+    o["Dynamic_Batch_Profiles"]        << Option(false);
+#endif
+#if defined(TENSORRT) || defined(ONNXRUNTIME) || defined(OPENVINO) || defined(COREML)
+    o["Engine_Cache_Directory"]        << Option("");
+#endif
 //    o["Enhance_Captures"]              << Option(false);         currently disabled
+    o["Eval_Cache_MB"]                 << Option(0, 0, 9999999);
+    o["Eval_Cache_Symmetry"]           << Option(true);
+#ifdef ONNXRUNTIME
+    o["Execution_Provider"]            << Option("cuda", {"cpu", "cuda", "tensorrt", "directml"});
+#endif
+    o["Fast_Model_Directory"]          << Option("<empty>");
     o["First_Device_ID"]               << Option(0, 0, 99999);
     o["Fixed_Movetime"]                << Option(0, 0, 99999999);
+#ifdef TENSORRT
+    o["Gather_Policy"]                 << Option(false);
+#endif
+    o["Gumbel_C_Visit"]                << Option(50, 0, 99999);
+    o["Gumbel_Root"]                   << Option(false);
+    o["Gumbel_Top_K"]                  << Option(16, 2, 256);
+    o["Hash_Shards"]                   << Option(64, 1, 4096);
+    o["Hash_Size"]                     << Option(4000000, 1, MAX_HASH_SIZE);
+    o["Inference_Record_File"]         << Option("<empty>");
+    o["Inference_Replay_File"]         << Option("<empty>");
+    o["Inference_Server"]              << Option(false);
+    o["Inference_Server_Batch_Size"]   << Option(256, 1, 8192);
+#ifndef _WIN32
+    o["Inference_Server_Port"]         << Option(5555, 1, 65535);
+    o["Inference_Server_Remote"]       << Option("");
+#endif
+#ifdef __linux__
+    o["Inference_Server_Shm"]          << Option("");
+    o["Inference_Server_Shm_Slots"]    << Option(256, 1, 65536);
+#endif
+    o["Inference_Server_Timeout_US"]   << Option(500, 0, 1000000);
+    o["Inference_Server_Workers"]      << Option(1, 1, 16);
+#ifdef TENSORRT
+    o["IO_Precision"]                  << Option("float32", {"float32", "float16"});
+#endif
+    o["KL_Stopping_Interval"]          << Option(0, 0, 99999999);
+    o["Large_Pages"]                   << Option("off", {"off", "transparent", "explicit"});
     o["Last_Device_ID"]                << Option(0, 0, 99999);
+#ifdef TENSORRT
+    o["Layer_Precision_Search"]        << Option(false);
+#endif
+    o["Lazy_Phase_Loading"]            << Option(false);
     o["Log_File"]                      << Option("", on_logger);
     o["MCTS_Solver"]                   << Option(true);
+    o["Memory_Budget_MB"]              << Option(0, 0, 9999999);
+    o["Metrics_Port"]                  << Option(0, 0, 65535);
+    o["Metrics_StatsD_Address"]        << Option("<empty>");
+    o["Micro_KL_Stopping_Gain"]        << Option(50, 0, 99999999);
+#ifdef TENSORRT
+    o["Milli_Layer_Precision_Tolerance"] << Option(10, 0, 1000);
+#endif
 #if defined(MODE_LICHESS) || defined(MODE_BOARDGAMES)
     o["Model_Directory"]               << Option((string("model/") + engineName + "/" + get_first_variant_with_model()).c_str());
 #else
     o["Model_Directory"]               << Option(string("model/" + engineName + "/" + StateConstants::DEFAULT_UCI_VARIANT()).c_str());
 #endif
     o["Move_Overhead"]                 << Option(20, 0, 5000);
+    o["Multi_Visit_Collisions"]        << Option(false);
     o["MultiPV"]                       << Option(1, 1, 99999);
+    o["Network_Cache_MB"]              << Option(0, 0, 1000000);
 #ifdef USE_RL
     o["Nodes"]                         << Option(800, 0, 99999999);
 #else
     o["Nodes"]                         << Option(0, 0, 99999999);
 #endif
     o["Nodes_Limit"]                   << Option(0, 0, 999999999);
+    o["NN_Book"]                       << Option("<empty>");
+    o["NUMA_Pinning"]                  << Option(false);
+    o["Null_Backend"]                  << Option(false);
+    o["Null_Backend_Latency_US"]       << Option(0, 0, 1000000);
+#ifdef OPENVINO
+    o["OpenVINO_Device"]               << Option("<empty>");
+    o["OpenVINO_Streams"]              << Option(0, 0, 512);
+    o["Overflow_CPU_Workers"]          << Option(0, 0, 64);
+    o["Overflow_Latency_US"]           << Option(2000, 0, 1000000);
+#endif
+    o["Ponder"]                        << Option(false);
 #ifdef TENSORRT
+    o["Packed_Input_Planes"]           << Option(false);
     o["Precision"]                     << Option("float16", {"float32", "float16", "int8"});
+#elif defined OPENVINO
+    o["Precision"]                     << Option("float32", {"float32", "float16", "bfloat16", "int8"});
+#elif defined ONNXRUNTIME
+    o["Precision"]                     << Option("float16", {"float32", "float16"});
+#elif defined TORCH
+    o["Precision"]                     << Option("float32", {"float32", "float16"});
+#elif defined COREML
+    o["Precision"]                     << Option("float16", {"float32", "float16"});
 #else
     o["Precision"]                     << Option("float32", {"float32", "int8"});
 #endif
+    o["Random_Seed"]                   << Option(0, 0, 99999999);
+    o["Refine_Visits"]                 << Option(32, 1, 99999999);
 #ifdef USE_RL
     o["Reuse_Tree"]                    << Option(false);
 #else
     o["Reuse_Tree"]                    << Option(true);
+#endif
+    o["Reuse_Tree_Max_Nodes"]          << Option(0, 0, 99999999);
+    o["Root_Parallel"]                 << Option(false);
+    o["Root_Prefill"]                  << Option(false);
+    o["Root_Prefill_Top_K"]            << Option(0, 0, 64);
+#ifdef __linux__
+    o["Root_Stats_Interval_MS"]        << Option(50, 1, 60000);
+    o["Root_Stats_Shm"]                << Option("<empty>");
 #endif
 #ifdef USE_RL
     o["Temperature_Moves"]             << Option(15, 0, 99999);
@@ -156,12 +291,15 @@ void OptionsUCI::init(OptionsMap &o)
     o["Temperature_Moves"]             << Option(0, 0, 99999);
 #endif
     o["Use_NPS_Time_Manager"]          << Option(true);
+    o["Use_Stability_Time_Manager"]    << Option(false);
 #ifdef TENSORRT
+    o["Use_CUDA_Graph"]                << Option(false);
     o["Use_TensorRT"]                  << Option(true);
 #endif
 #ifdef SUPPORT960
     o["UCI_Chess960"]                  << Option(false);
 #endif
+    o["Search_Cores"]                  << Option(0, -1, 1024);
     o["Search_Type"]                   << Option("mcgs", {"mcgs", "mcts"});
     o["Search_Player_Mode"]            << Option("two_player", {"two_player", "single_player"});
 #ifdef USE_RL
@@ -169,6 +307,7 @@ void OptionsUCI::init(OptionsMap &o)
 #else
     o["Simulations"]                   << Option(0, 0, 99999999);
 #endif
+    o["Subtree_Split_Depth"]           << Option(0, 0, 8);
 #ifdef MODE_STRATEGO
    o["Centi_Temperature"]              << Option(99999, 0, 99999);
    o["Centi_Temperature_Decay"]        << Option(100, 0, 100);
@@ -178,12 +317,19 @@ void OptionsUCI::init(OptionsMap &o)
 #if !defined(MODE_XIANGQI) && !defined(MODE_BOARDGAMES)
     o["SyzygyPath"]                    << Option("<empty>", on_tb_path);
 #endif
+#endif
+#ifdef MCTS_TB_SUPPORT
+    o["Tablebase_Async_Probing"]       << Option(false);
+    o["Tablebase_Cache_MB"]            << Option(16, 0, 99999);
+    o["Tablebase_Warm_Up"]             << Option(false);
 #endif
     o["Threads"]                       << Option(2, 1, 512);
-#ifdef OPENVINO
+#if defined(OPENVINO) || defined(ONNXRUNTIME)
     o["Threads_NN_Inference"]          << Option(8, 1, 512);
 #endif
     o["Timeout_MS"]                    << Option(0, 0, 99999999);
+    o["Trace_File"]                    << Option("<empty>");
+    o["TrueSight_Determinizations"]    << Option(1, 1, 512);
 #ifdef MODE_LICHESS
     o["UCI_Variant"]                   << Option(get_first_variant_with_model().c_str(), StateConstants::available_variants());
 #else
@@ -196,6 +342,14 @@ void OptionsUCI::init(OptionsMap &o)
     o["Game_Phase_Definition"]         << Option("lichess", { "lichess", "movecount"});
     // additional UCI-Options for RL only
 #ifdef USE_RL
+    o["Arena_SPRT"]                    << Option(false);
+    o["Arena_SPRT_Elo0"]               << Option(0, -1000, 1000);
+    o["Arena_SPRT_Elo1"]               << Option(10, -1000, 1000);
+    o["Centi_Arena_SPRT_Alpha"]        << Option(5, 1, 50);
+    o["Centi_Arena_SPRT_Beta"]         << Option(5, 1, 50);
+    o["Centi_Draw_Adjudication_Probability"] << Option(90, 0, 100);
+    o["Centi_Draw_Adjudication_Threshold"] << Option(5, 0, 100);
+    o["Centi_Max_Plies_Probability"]   << Option(100, 0, 100);
     o["Centi_Node_Random_Factor"]      << Option(10, 0, 100);
     o["Centi_Quick_Dirichlet_Epsilon"] << Option(0, 0, 99999);
     o["Centi_Quick_Probability"]       << Option(0, 0, 100);
@@ -203,7 +357,11 @@ void OptionsUCI::init(OptionsMap &o)
     o["Centi_Raw_Prob_Temperature"]    << Option(25, 0, 100);
     o["Centi_Resign_Probability"]      << Option(90, 0, 100);
     o["Centi_Resign_Threshold"]        << Option(-90, -100, 100);
+    o["Centi_TB_Adjudication_Probability"] << Option(90, 0, 100);
+    o["Draw_Adjudication_Plies"]       << Option(0, 0, 99999);
     o["EPD_File_Path"]                 << Option("<empty>");
+    o["EPD_Sampling"]                  << Option("uniform", {"uniform", "weighted", "without_replacement"});
+    o["Max_Game_Plies"]                << Option(0, 0, 99999);
     o["MaxInitPly"]                    << Option(30, 0, 99999);
     o["MeanInitPly"]                   << Option(15, 0, 99999);
 #ifdef MODE_LICHESS
@@ -211,10 +369,26 @@ void OptionsUCI::init(OptionsMap &o)
 #else
     o["Model_Directory_Contender"]     << Option(string("model_contender/" + engineName + "/" + StateConstants::DEFAULT_UCI_VARIANT()).c_str());
 #endif
+    o["Output_Flush_Interval_MS"]      << Option(1000, 1, 600000);
     o["Selfplay_Number_Chunks"]        << Option(640, 1, 99999);
+    o["Selfplay_Publish_Address"]      << Option("<empty>");
+    o["Selfplay_Shard_Size_MB"]        << Option(256, 1, 65536);
     o["Selfplay_Chunk_Size"]           << Option(128, 1, 99999);
+    o["Selfplay_Sparse_Policy_Size"]   << Option(256, 1, 4096);
+    o["Selfplay_Stream_Directory"]     << Option("<empty>");
+    o["Selfplay_Compression"]          << Option("none", {"none", "lz4", "zstd", "zlib", "blosclz"});
+    o["Selfplay_Compression_Level"]    << Option(5, 0, 9);
+    o["Selfplay_Concurrent_Games"]     << Option(1, 1, 512);
+    o["Selfplay_Coordinator_Address"]  << Option("<empty>");
+    o["Selfplay_Export_Format"]        << Option("dense", {"dense", "packed"});
+    o["Selfplay_Export_Queue_Size"]    << Option(4, 1, 1024);
+#ifdef USE_ZLIB
+    o["Selfplay_PGN_Compression"]      << Option(false);
+#endif
     o["Milli_Policy_Clip_Thresh"]      << Option(0, 0, 100);
+    o["Quick_Batch_Size"]              << Option(0, 0, 8192);
     o["Quick_Nodes"]                   << Option(100, 0, 99999);
+    o["Quick_Threads"]                 << Option(0, 0, 512);
 #endif
 }
 
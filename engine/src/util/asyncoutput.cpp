@@ -0,0 +1,313 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: asyncoutput.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "asyncoutput.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct OutputMessage {
+    std::atomic<OutputMessage*> next;
+    std::string text;
+};
+
+/**
+ * @brief The MessageQueue class Intrusive multi-producer single-consumer queue of D. Vyukov.
+ * Pushing is wait-free, only the output thread pops.
+ */
+class MessageQueue
+{
+private:
+    std::atomic<OutputMessage*> head;
+    OutputMessage* tail;
+    OutputMessage stub;
+public:
+    MessageQueue():
+        head(&stub), tail(&stub)
+    {
+        stub.next = nullptr;
+    }
+
+    void push(OutputMessage* message) {
+        message->next.store(nullptr, std::memory_order_relaxed);
+        OutputMessage* prev = head.exchange(message, std::memory_order_acq_rel);
+        prev->next.store(message, std::memory_order_release);
+    }
+
+    /**
+     * @brief pop Returns the oldest message or nullptr if the queue is empty or a push is still in progress
+     */
+    OutputMessage* pop() {
+        OutputMessage* curTail = tail;
+        OutputMessage* next = curTail->next.load(std::memory_order_acquire);
+        if (curTail == &stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail = next;
+            curTail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail = next;
+            return curTail;
+        }
+        if (curTail != head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        push(&stub);
+        next = curTail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail = next;
+            return curTail;
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * @brief get_multi_pv_key Returns the MultiPV index of an "info depth" line or -1 for all other lines
+ */
+int get_multi_pv_key(const std::string& line)
+{
+    if (line.compare(0, 11, "info depth ") != 0) {
+        return -1;
+    }
+    const size_t pos = line.find(" multipv ");
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    return std::atoi(line.c_str() + pos + 9);
+}
+
+class AsyncOutput : public std::streambuf
+{
+private:
+    MessageQueue queue;
+    std::streambuf* sink;
+    std::thread writer;
+    std::atomic<bool> isRunning;
+    std::atomic<bool> isSleeping;
+    std::atomic<uint64_t> pushedMessages;
+    std::atomic<uint64_t> writtenMessages;
+    std::mutex mtx;
+    std::condition_variable cvMessages;
+    std::condition_variable cvWritten;
+
+    static std::string& line_buffer() {
+        thread_local std::string lineBuffer;
+        return lineBuffer;
+    }
+
+    void push_line(std::string& line) {
+        OutputMessage* message = new OutputMessage;
+        message->text.swap(line);
+        queue.push(message);
+        ++pushedMessages;
+        if (isSleeping) {
+            std::lock_guard<std::mutex> lock(mtx);
+            cvMessages.notify_one();
+        }
+    }
+
+    /**
+     * @brief write_batch Writes the given lines to the sink and skips info lines which are replaced by a newer line of the same batch
+     */
+    void write_batch(std::vector<OutputMessage*>& messages) {
+        std::vector<bool> isReplaced(messages.size(), false);
+        std::vector<int> newerKeys;
+        for (size_t idx = messages.size(); idx-- > 0;) {
+            const int key = get_multi_pv_key(messages[idx]->text);
+            if (key == -1) {
+                if (messages[idx]->text.compare(0, 5, "info ") != 0) {
+                    // never move an info line across another command, e.g. "bestmove"
+                    newerKeys.clear();
+                }
+                continue;
+            }
+            for (int newerKey : newerKeys) {
+                if (newerKey == key) {
+                    isReplaced[idx] = true;
+                    break;
+                }
+            }
+            if (!isReplaced[idx]) {
+                newerKeys.emplace_back(key);
+            }
+        }
+        for (size_t idx = 0; idx < messages.size(); ++idx) {
+            if (!isReplaced[idx]) {
+                sink->sputn(messages[idx]->text.data(), std::streamsize(messages[idx]->text.size()));
+            }
+            delete messages[idx];
+        }
+        sink->pubsync();
+        writtenMessages += messages.size();
+        messages.clear();
+        std::lock_guard<std::mutex> lock(mtx);
+        cvWritten.notify_all();
+    }
+
+    void run() {
+        std::vector<OutputMessage*> messages;
+        while (true) {
+            OutputMessage* message;
+            while ((message = queue.pop()) != nullptr) {
+                messages.emplace_back(message);
+            }
+            if (!messages.empty()) {
+                write_batch(messages);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mtx);
+            isSleeping = true;
+            cvMessages.wait(lock, [&]{ return pushedMessages != writtenMessages || !isRunning; });
+            isSleeping = false;
+            if (!isRunning && pushedMessages == writtenMessages) {
+                return;
+            }
+        }
+    }
+
+protected:
+    int overflow(int c) override {
+        if (c == traits_type::eof()) {
+            return traits_type::not_eof(c);
+        }
+        std::string& line = line_buffer();
+        line.push_back(char(c));
+        if (c == '\n') {
+            push_line(line);
+        }
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        std::string& line = line_buffer();
+        const char* end = s + n;
+        while (s != end) {
+            const char* newLine = static_cast<const char*>(std::memchr(s, '\n', size_t(end - s)));
+            if (newLine == nullptr) {
+                line.append(s, end);
+                break;
+            }
+            line.append(s, newLine + 1);
+            push_line(line);
+            s = newLine + 1;
+        }
+        return n;
+    }
+
+    int sync() override {
+        // an explicit flush without a trailing new line is written as it is
+        std::string& line = line_buffer();
+        if (!line.empty()) {
+            push_line(line);
+        }
+        return 0;
+    }
+
+public:
+    AsyncOutput():
+        sink(nullptr), isRunning(false), isSleeping(false), pushedMessages(0), writtenMessages(0)
+    {
+    }
+
+    ~AsyncOutput() {
+        stop();
+    }
+
+    bool is_active() const {
+        return isRunning;
+    }
+
+    void start() {
+        if (isRunning) {
+            return;
+        }
+        std::cout.flush();
+        sink = std::cout.rdbuf();
+        isRunning = true;
+        writer = std::thread(&AsyncOutput::run, this);
+        std::cout.rdbuf(this);
+    }
+
+    void flush() {
+        if (!isRunning) {
+            return;
+        }
+        const uint64_t target = pushedMessages;
+        std::unique_lock<std::mutex> lock(mtx);
+        cvWritten.wait(lock, [&]{ return writtenMessages >= target; });
+    }
+
+    void stop() {
+        if (!isRunning) {
+            return;
+        }
+        std::cout.flush();
+        std::cout.rdbuf(sink);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            isRunning = false;
+            cvMessages.notify_one();
+        }
+        writer.join();
+    }
+};
+
+AsyncOutput& async_output()
+{
+    static AsyncOutput output;
+    return output;
+}
+}
+
+void start_async_output()
+{
+    async_output().start();
+}
+
+void stop_async_output()
+{
+    async_output().stop();
+}
+
+void flush_async_output()
+{
+    async_output().flush();
+}
+
+bool is_async_output_active()
+{
+    return async_output().is_active();
+}
@@ -0,0 +1,58 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: asyncoutput.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Asynchronous std-out which decouples the engine from the read speed of the UCI consumer.
+ * While active, cout is redirected to a stream buffer which collects complete lines per thread and pushes them into a lock-free queue.
+ * A dedicated output thread writes the lines in their push order to the former stream buffer of cout,
+ * so "bestmove" is never written before an "info" line which has been pushed earlier.
+ * Older "info depth" lines of the same MultiPV index which are still queued when a newer one arrives are dropped.
+ */
+
+#ifndef ASYNCOUTPUT_H
+#define ASYNCOUTPUT_H
+
+#include <streambuf>
+
+/**
+ * @brief start_async_output Redirects cout to the output thread, does nothing if it is already active
+ */
+void start_async_output();
+
+/**
+ * @brief stop_async_output Writes all queued lines, stops the output thread and restores the former stream buffer of cout
+ */
+void stop_async_output();
+
+/**
+ * @brief flush_async_output Blocks until all lines which have been pushed so far are written
+ */
+void flush_async_output();
+
+/**
+ * @brief is_async_output_active Returns true if cout is currently redirected to the output thread
+ */
+bool is_async_output_active();
+
+#endif // ASYNCOUTPUT_H
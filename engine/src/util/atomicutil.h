@@ -0,0 +1,99 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: atomicutil.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Relaxed atomic operations on plain variables and vector elements, e.g. the statistics of the node data.
+ * C++17 doesn't provide std::atomic_ref, so the GCC and Clang built-ins are used instead.
+ */
+
+#ifndef ATOMICUTIL_H
+#define ATOMICUTIL_H
+
+#if !defined(__GNUC__)
+#error "The atomic utilities require the __atomic built-ins of GCC or Clang"
+#endif
+
+/**
+ * @brief atomic_load Loads a value atomically
+ * @param variable Variable to load
+ * @return Current value
+ */
+template <typename T>
+inline T atomic_load(const T& variable)
+{
+    T value;
+    __atomic_load(&variable, &value, __ATOMIC_RELAXED);
+    return value;
+}
+
+/**
+ * @brief atomic_store Stores a value atomically
+ * @param variable Variable to store to
+ * @param value New value
+ */
+template <typename T>
+inline void atomic_store(T& variable, T value)
+{
+    __atomic_store(&variable, &value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief atomic_fetch_add Adds a value to an integral variable atomically
+ * @return Value before the addition
+ */
+template <typename T>
+inline T atomic_fetch_add(T& variable, T value)
+{
+    return __atomic_fetch_add(&variable, value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief atomic_fetch_sub Subtracts a value from an integral variable atomically
+ * @return Value before the subtraction
+ */
+template <typename T>
+inline T atomic_fetch_sub(T& variable, T value)
+{
+    return __atomic_fetch_sub(&variable, value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief atomic_update Replaces a (floating point) variable by update(variable) using a compare and swap loop.
+ * The update function may be called several times if other threads modify the variable in the meantime.
+ * @param variable Variable to update
+ * @param update Function which returns the new value for a given old value
+ * @return New value
+ */
+template <typename T, typename F>
+inline T atomic_update(T& variable, F update)
+{
+    T expected = atomic_load(variable);
+    T desired = update(expected);
+    while (!__atomic_compare_exchange(&variable, &expected, &desired, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        desired = update(expected);
+    }
+    return desired;
+}
+
+#endif // ATOMICUTIL_H
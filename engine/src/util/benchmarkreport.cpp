@@ -0,0 +1,239 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: benchmarkreport.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "benchmarkreport.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <thread>
+
+namespace {
+std::string escape_json(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void write_stats(std::ostream& os, const std::vector<double>& values)
+{
+    const double mean = values.empty() ? 0 : std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    os << "{\"mean\": " << mean
+       << ", \"min\": " << percentile(values, 0)
+       << ", \"p10\": " << percentile(values, 0.1)
+       << ", \"p50\": " << percentile(values, 0.5)
+       << ", \"p90\": " << percentile(values, 0.9)
+       << ", \"p99\": " << percentile(values, 0.99)
+       << ", \"max\": " << percentile(values, 1) << "}";
+}
+
+void write_run_stats(std::ostream& os, const std::vector<const BenchmarkRun*>& runs, const std::string& indent)
+{
+    std::vector<double> nps, elapsedTimeMS, depth;
+    for (const BenchmarkRun* run : runs) {
+        nps.emplace_back(run->nps);
+        elapsedTimeMS.emplace_back(run->elapsedTimeMS);
+        depth.emplace_back(run->depth);
+    }
+    os << indent << "\"nps\": ";
+    write_stats(os, nps);
+    os << ",\n" << indent << "\"time_ms\": ";
+    write_stats(os, elapsedTimeMS);
+    os << ",\n" << indent << "\"depth\": ";
+    write_stats(os, depth);
+    os << ",\n" << indent << "\"passed\": "
+       << std::count_if(runs.begin(), runs.end(), [](const BenchmarkRun* run) { return run->passed; });
+}
+}
+
+double percentile(std::vector<double> values, double quantile)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    const double rank = quantile * (values.size() - 1);
+    const size_t lowerIdx = size_t(std::floor(rank));
+    const size_t upperIdx = std::min(lowerIdx + 1, values.size() - 1);
+    return values[lowerIdx] + (rank - lowerIdx) * (values[upperIdx] - values[lowerIdx]);
+}
+
+std::string get_cpu_model()
+{
+    std::ifstream cpuInfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuInfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            const size_t colonPos = line.find(':');
+            if (colonPos != std::string::npos && colonPos + 2 <= line.size()) {
+                return line.substr(colonPos + 2);
+            }
+        }
+    }
+    return "unknown";
+}
+
+std::vector<std::string> get_build_flags()
+{
+    std::vector<std::string> flags;
+#ifdef MXNET
+    flags.emplace_back("MXNET");
+#endif
+#ifdef TENSORRT
+    flags.emplace_back("TENSORRT");
+#endif
+#ifdef TORCH
+    flags.emplace_back("TORCH");
+#endif
+#ifdef OPENVINO
+    flags.emplace_back("OPENVINO");
+#endif
+#ifdef ONNXRUNTIME
+    flags.emplace_back("ONNXRUNTIME");
+#endif
+#ifdef COREML
+    flags.emplace_back("COREML");
+#endif
+#ifdef MODE_CRAZYHOUSE
+    flags.emplace_back("MODE_CRAZYHOUSE");
+#endif
+#ifdef MODE_CHESS
+    flags.emplace_back("MODE_CHESS");
+#endif
+#ifdef MODE_LICHESS
+    flags.emplace_back("MODE_LICHESS");
+#endif
+#ifdef MODE_XIANGQI
+    flags.emplace_back("MODE_XIANGQI");
+#endif
+#ifdef MODE_BOARDGAMES
+    flags.emplace_back("MODE_BOARDGAMES");
+#endif
+#ifdef MODE_STRATEGO
+    flags.emplace_back("MODE_STRATEGO");
+#endif
+#ifdef MODE_OPEN_SPIEL
+    flags.emplace_back("MODE_OPEN_SPIEL");
+#endif
+#ifdef USE_RL
+    flags.emplace_back("USE_RL");
+#endif
+#ifdef SEARCH_UCT
+    flags.emplace_back("SEARCH_UCT");
+#endif
+#ifdef MCTS_TB_SUPPORT
+    flags.emplace_back("MCTS_TB_SUPPORT");
+#endif
+#ifdef MCTS_STORE_STATES
+    flags.emplace_back("MCTS_STORE_STATES");
+#endif
+#ifdef MCTS_NODE_POOL
+    flags.emplace_back("MCTS_NODE_POOL");
+#endif
+#ifdef MCTS_NODE_ARENA
+    flags.emplace_back("MCTS_NODE_ARENA");
+#endif
+#ifdef MCTS_ATOMIC_BACKUP
+    flags.emplace_back("MCTS_ATOMIC_BACKUP");
+#endif
+#ifdef MCTS_COMPACT_LEAVES
+    flags.emplace_back("MCTS_COMPACT_LEAVES");
+#endif
+#ifdef MCTS_ALIGNED_NODES
+    flags.emplace_back("MCTS_ALIGNED_NODES");
+#endif
+#ifdef MCTS_PARTIAL_SORT
+    flags.emplace_back("MCTS_PARTIAL_SORT");
+#endif
+#ifdef MCTS_PHASE_TIMERS
+    flags.emplace_back("MCTS_PHASE_TIMERS");
+#endif
+#ifdef DYNAMIC_NN_ARCH
+    flags.emplace_back("DYNAMIC_NN_ARCH");
+#endif
+#ifdef NDEBUG
+    flags.emplace_back("NDEBUG");
+#endif
+    return flags;
+}
+
+void write_benchmark_json(std::ostream& os, const BenchmarkConfig& config, const std::vector<std::string>& fens, const std::vector<BenchmarkRun>& runs)
+{
+    const std::vector<std::string> flags = get_build_flags();
+    os << "{\n"
+       << "  \"engine\": \"" << escape_json(config.engine) << "\",\n"
+       << "  \"build\": {\"date\": \"" << __DATE__ << "\", \"compiler\": \"" << escape_json(__VERSION__) << "\", \"flags\": [";
+    for (size_t idx = 0; idx < flags.size(); ++idx) {
+        os << (idx == 0 ? "" : ", ") << "\"" << flags[idx] << "\"";
+    }
+    os << "]},\n"
+       << "  \"hardware\": {\"cpu\": \"" << escape_json(get_cpu_model()) << "\", \"hardware_threads\": " << std::thread::hardware_concurrency()
+       << ", \"device\": \"" << escape_json(config.device) << "\", \"gpus\": [";
+    for (size_t idx = 0; idx < config.deviceSamples.size(); ++idx) {
+        const DeviceSample& sample = config.deviceSamples[idx];
+        os << (idx == 0 ? "" : ", ") << "{\"id\": " << sample.deviceID << ", \"utilization\": " << sample.gpuUtilization
+           << ", \"memory_utilization\": " << sample.memoryUtilization << ", \"memory_used_bytes\": " << sample.memoryUsedBytes
+           << ", \"memory_total_bytes\": " << sample.memoryTotalBytes << ", \"sm_clock_mhz\": " << sample.smClockMHz
+           << ", \"memory_clock_mhz\": " << sample.memoryClockMHz << ", \"temperature_c\": " << sample.temperatureC
+           << ", \"throttled\": " << (sample.isThrottled ? "true" : "false") << "}";
+    }
+    os << "]},\n"
+       << "  \"config\": {\"suite\": \"" << escape_json(config.suite) << "\", \"go\": \"" << escape_json(config.goCommand)
+       << "\", \"warmup\": " << config.warmupRuns << ", \"trials\": " << config.trials << ", \"threads\": " << config.threads
+       << ", \"batch_size\": " << config.batchSize << ", \"model\": \"" << escape_json(config.model) << "\"},\n"
+       << "  \"positions\": [\n";
+
+    std::vector<const BenchmarkRun*> allRuns;
+    for (const BenchmarkRun& run : runs) {
+        allRuns.emplace_back(&run);
+    }
+    for (size_t positionIdx = 0; positionIdx < fens.size(); ++positionIdx) {
+        std::vector<const BenchmarkRun*> positionRuns;
+        std::copy_if(allRuns.begin(), allRuns.end(), std::back_inserter(positionRuns),
+                     [positionIdx](const BenchmarkRun* run) { return run->positionIdx == positionIdx; });
+        os << "    {\n      \"fen\": \"" << escape_json(fens[positionIdx]) << "\",\n      \"trials\": [";
+        for (size_t idx = 0; idx < positionRuns.size(); ++idx) {
+            const BenchmarkRun* run = positionRuns[idx];
+            os << (idx == 0 ? "\n" : ",\n")
+               << "        {\"nodes\": " << run->nodes << ", \"nps\": " << run->nps << ", \"time_ms\": " << run->elapsedTimeMS
+               << ", \"depth\": " << run->depth << ", \"seldepth\": " << run->selDepth
+               << ", \"bestmove\": \"" << escape_json(run->bestMove) << "\", \"passed\": " << (run->passed ? "true" : "false") << "}";
+        }
+        os << "\n      ],\n";
+        write_run_stats(os, positionRuns, "      ");
+        os << "\n    }" << (positionIdx + 1 == fens.size() ? "\n" : ",\n");
+    }
+    os << "  ],\n  \"summary\": {\n";
+    write_run_stats(os, allRuns, "    ");
+    os << "\n  }\n}\n";
+}
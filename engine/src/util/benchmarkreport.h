@@ -0,0 +1,97 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: benchmarkreport.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Statistics and machine-readable JSON report of the "benchmark" command, including the hardware and build flags
+ * so that runs of different builds and machines can be compared.
+ */
+
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "devicemonitor.h"
+
+/**
+ * @brief The BenchmarkRun struct holds the measurements of a single search of a benchmark position
+ */
+struct BenchmarkRun {
+    size_t positionIdx;
+    size_t trial;
+    size_t nodes;
+    size_t nps;
+    size_t elapsedTimeMS;
+    size_t depth;
+    size_t selDepth;
+    std::string bestMove;
+    bool passed;
+};
+
+/**
+ * @brief The BenchmarkConfig struct describes the setup of a benchmark run
+ */
+struct BenchmarkConfig {
+    std::string engine;
+    std::string suite;
+    std::string goCommand;
+    size_t warmupRuns;
+    size_t trials;
+    size_t threads;
+    size_t batchSize;
+    std::string device;
+    std::string model;
+    // average device state during the measured runs (empty if the device monitor isn't running)
+    std::vector<DeviceSample> deviceSamples;
+};
+
+/**
+ * @brief percentile Returns the percentile of the given values using linear interpolation between the closest ranks
+ * @param values Unsorted values
+ * @param quantile Quantile in [0,1], e.g. 0.5 for the median
+ * @return Percentile or 0 if values is empty
+ */
+double percentile(std::vector<double> values, double quantile);
+
+/**
+ * @brief get_cpu_model Returns the name of the CPU or "unknown" if it can't be determined
+ */
+std::string get_cpu_model();
+
+/**
+ * @brief get_build_flags Returns the compile definitions which affect the search and the inference backend
+ */
+std::vector<std::string> get_build_flags();
+
+/**
+ * @brief write_benchmark_json Writes all runs, their per position and overall statistics as JSON
+ * @param os Output stream
+ * @param config Benchmark setup
+ * @param fens Positions of the suite
+ * @param runs Measured runs (warmup runs excluded)
+ */
+void write_benchmark_json(std::ostream& os, const BenchmarkConfig& config, const std::vector<std::string>& fens, const std::vector<BenchmarkRun>& runs);
+
+#endif // BENCHMARKREPORT_H
@@ -35,6 +35,7 @@
 #endif
 
 #include <cfloat>
+#include <cmath>
 #include <blaze/Math.h>
 #include <limits>
 #include<climits>
@@ -64,9 +65,12 @@ void append(DynamicVector<T>& vec, T value)
 template <typename T>
 size_t random_choice(const DynamicVector<T>& distribution)
 {
-    const T* prob = distribution.data();
-    discrete_distribution<> d(prob, prob+distribution.size());
-    return size_t(d(generator));
+    // the table keeps its memory between calls of the same thread
+    thread_local AliasTable aliasTable;
+    thread_local vector<float> weights;
+    weights.assign(distribution.begin(), distribution.end());
+    aliasTable.build(weights.data(), weights.size());
+    return aliasTable.sample(thread_random());
 }
 
 /**
@@ -114,10 +118,11 @@ template <typename T>
 DynamicVector<T> get_dirichlet_noise(size_t length, T alpha)
 {
     DynamicVector<T> dirichletNoise(length);
+    std::gamma_distribution<T> distribution(alpha, 1.0f);
+    FastRandom& random = thread_random();
 
     for (size_t i = 0; i < length; ++i) {
-        std::gamma_distribution<T> distribution(alpha, 1.0f);
-        dirichletNoise[i] = distribution(generator);
+        dirichletNoise[i] = distribution(random);
     }
     dirichletNoise /= sum(dirichletNoise);
     return  dirichletNoise;
@@ -177,6 +182,34 @@ void first_and_second_max(const DynamicVector<T>& v, U endIdx, T& firstMax, T& s
 
 }
 
+/**
+ * @brief kl_divergence Returns the Kullback-Leibler divergence KL(p || q) of the two count vectors after normalizing them to distributions
+ * @param p Counts of the new distribution
+ * @param q Counts of the reference distribution of the same size
+ * @return Divergence in nats, infinity if q has no mass on an entry of p or one of the vectors is empty
+ */
+template <typename T>
+double kl_divergence(const DynamicVector<T>& p, const DynamicVector<T>& q)
+{
+    const double sumP = blaze::sum(p);
+    const double sumQ = blaze::sum(q);
+    if (sumP == 0 || sumQ == 0 || p.size() != q.size()) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double divergence = 0;
+    for (size_t idx = 0; idx < p.size(); ++idx) {
+        if (p[idx] == 0) {
+            continue;
+        }
+        if (q[idx] == 0) {
+            return std::numeric_limits<double>::infinity();
+        }
+        const double probP = p[idx] / sumP;
+        divergence += probP * std::log(probP / (q[idx] / sumQ));
+    }
+    return divergence;
+}
+
 /**
  * @brief get_quantile Returns the value+FLT_EPSILON for the given quantil.
  * @param vec Given vector which is assumed to have only positive values and to sum up to 1.
@@ -0,0 +1,180 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: bufferedfilewriter.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "bufferedfilewriter.h"
+#include <chrono>
+#include <fstream>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#include "communication.h"
+
+#ifdef USE_ZLIB
+/**
+ * @brief compress_gzip_member Returns the given text as a complete gzip member
+ */
+static std::string compress_gzip_member(const std::string& text)
+{
+    z_stream stream = {};
+    // a window of 15 bits with 16 added selects the gzip wrapper
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("the zlib compressor couldn't be initialized");
+    }
+    std::string member(deflateBound(&stream, text.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+    stream.avail_in = uInt(text.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&member[0]);
+    stream.avail_out = uInt(member.size());
+    const int status = deflate(&stream, Z_FINISH);
+    member.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        throw std::runtime_error("the zlib compression failed");
+    }
+    return member;
+}
+#endif
+
+bool is_gzip_file_name(const std::string& fileName)
+{
+    return fileName.size() > 3 && fileName.compare(fileName.size() - 3, 3, ".gz") == 0;
+}
+
+BufferedFileWriter::BufferedFileWriter(size_t flushIntervalMS, size_t maxPendingBytes):
+    pendingBytes(0),
+    flushIntervalMS(flushIntervalMS),
+    maxPendingBytes(maxPendingBytes),
+    isRunning(true)
+{
+    writerThread = std::thread(&BufferedFileWriter::run, this);
+}
+
+BufferedFileWriter::~BufferedFileWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        isRunning = false;
+    }
+    cv.notify_one();
+    writerThread.join();
+    write_pending();
+}
+
+void BufferedFileWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (isRunning) {
+        cv.wait_for(lock, std::chrono::milliseconds(flushIntervalMS), [this]{ return !isRunning || pendingBytes >= maxPendingBytes; });
+        lock.unlock();
+        write_pending();
+        lock.lock();
+    }
+}
+
+void BufferedFileWriter::write_pending()
+{
+    std::lock_guard<std::mutex> writeLock(writeMtx);
+    std::map<std::string, std::string> records;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        records.swap(pendingRecords);
+        pendingBytes = 0;
+    }
+    for (const auto& entry : records) {
+        write_records(entry.first, entry.second);
+    }
+}
+
+void BufferedFileWriter::write_records(const std::string& fileName, const std::string& records)
+{
+    try {
+        std::ofstream file(fileName, std::ios_base::app | std::ios_base::binary);
+        if (is_gzip_file_name(fileName)) {
+#ifdef USE_ZLIB
+            const std::string member = compress_gzip_member(records);
+            file.write(member.data(), std::streamsize(member.size()));
+#else
+            throw std::runtime_error("gzip output requires a build with USE_ZLIB");
+#endif
+        }
+        else {
+            file.write(records.data(), std::streamsize(records.size()));
+        }
+        if (!file) {
+            throw std::runtime_error("the file couldn't be written");
+        }
+    }
+    catch (const std::exception& e) {
+        info_string_important("Records for", fileName, "were lost:", e.what());
+    }
+}
+
+void BufferedFileWriter::append(const std::string& fileName, const std::string& record)
+{
+    bool isFull;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pendingRecords[fileName] += record;
+        pendingBytes += record.size();
+        isFull = pendingBytes >= maxPendingBytes;
+    }
+    if (isFull) {
+        cv.notify_one();
+    }
+}
+
+void BufferedFileWriter::truncate(const std::string& fileName)
+{
+    std::lock_guard<std::mutex> writeLock(writeMtx);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = pendingRecords.find(fileName);
+        if (it != pendingRecords.end()) {
+            pendingBytes -= it->second.size();
+            pendingRecords.erase(it);
+        }
+    }
+    std::ofstream file(fileName, std::ios_base::trunc);
+}
+
+void BufferedFileWriter::flush()
+{
+    write_pending();
+}
+
+void BufferedFileWriter::set_flush_interval(size_t intervalMS)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        flushIntervalMS = intervalMS;
+    }
+    cv.notify_one();
+}
+
+BufferedFileWriter& buffered_file_writer()
+{
+    static BufferedFileWriter writer;
+    return writer;
+}
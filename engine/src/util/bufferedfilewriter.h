@@ -0,0 +1,117 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: bufferedfilewriter.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Buffered writer for the text records (pgn games, tournament results) of selfplay, arena and tournament runs.
+ * The playing threads only append their records to an in-memory buffer. A background thread appends the buffered records
+ * of each file in a single open/write/close on a timer or when the buffer exceeds its size limit, which avoids a file access
+ * per game on shared network storage. Files ending with ".gz" are written as a sequence of gzip members (requires USE_ZLIB),
+ * which standard gzip readers decompress as a single stream.
+ */
+
+#ifndef BUFFEREDFILEWRITER_H
+#define BUFFEREDFILEWRITER_H
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class BufferedFileWriter
+{
+private:
+    // buffered records of each file which haven't been written yet
+    std::map<std::string, std::string> pendingRecords;
+    size_t pendingBytes;
+    size_t flushIntervalMS;
+    size_t maxPendingBytes;
+    bool isRunning;
+    // protects the buffered records
+    std::mutex mtx;
+    // serializes the file accesses so that the records of a file are written in their append order
+    std::mutex writeMtx;
+    std::condition_variable cv;
+    std::thread writerThread;
+
+    /**
+     * @brief run Writes the buffered records every flushIntervalMS or as soon as maxPendingBytes are buffered
+     */
+    void run();
+
+    /**
+     * @brief write_pending Writes the buffered records of all files
+     */
+    void write_pending();
+
+    /**
+     * @brief write_records Appends the given records to a file and compresses them if the file name ends with ".gz"
+     */
+    static void write_records(const std::string& fileName, const std::string& records);
+
+public:
+    /**
+     * @brief BufferedFileWriter
+     * @param flushIntervalMS Maximum time in milliseconds until a record is written
+     * @param maxPendingBytes Size of the buffered records which triggers a write before the interval has passed
+     */
+    BufferedFileWriter(size_t flushIntervalMS=1000, size_t maxPendingBytes=1024 * 1024);
+    ~BufferedFileWriter();
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+
+    /**
+     * @brief append Buffers a record for the given file, it is written by the background thread
+     * @param fileName File to which the record is appended
+     * @param record Text of the record
+     */
+    void append(const std::string& fileName, const std::string& record);
+
+    /**
+     * @brief truncate Discards the buffered records of the given file and clears its content
+     * @param fileName File name
+     */
+    void truncate(const std::string& fileName);
+
+    /**
+     * @brief flush Blocks until all records which have been appended so far are written
+     */
+    void flush();
+
+    /**
+     * @brief set_flush_interval Sets the maximum time in milliseconds until a record is written
+     */
+    void set_flush_interval(size_t intervalMS);
+};
+
+/**
+ * @brief buffered_file_writer Returns the writer which is shared by selfplay, the arena and tournaments.
+ * The remaining records are written when the program exits.
+ */
+BufferedFileWriter& buffered_file_writer();
+
+/**
+ * @brief is_gzip_file_name Returns true if the file name ends with ".gz"
+ */
+bool is_gzip_file_name(const std::string& fileName);
+
+#endif // BUFFEREDFILEWRITER_H
@@ -0,0 +1,240 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: devicemonitor.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "devicemonitor.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include "communication.h"
+#ifdef NVML
+#include <nvml.h>
+#endif
+#ifdef TENSORRT
+#include <cuda_runtime_api.h>
+#endif
+
+// the throttle reasons which aren't caused by an idle device or by the application clock setting
+#ifdef NVML
+constexpr unsigned long long THROTTLE_REASONS_MASK = nvmlClocksThrottleReasonSwPowerCap | nvmlClocksThrottleReasonHwSlowdown |
+                                                      nvmlClocksThrottleReasonSwThermalSlowdown | nvmlClocksThrottleReasonHwThermalSlowdown |
+                                                      nvmlClocksThrottleReasonHwPowerBrakeSlowdown;
+#endif
+
+DeviceMonitor::DeviceMonitor():
+    numberSamples(0),
+    isRunning(false)
+{
+}
+
+DeviceMonitor::~DeviceMonitor()
+{
+    stop();
+}
+
+bool DeviceMonitor::start(const std::vector<int>& deviceIDs, size_t intervalMS)
+{
+    stop();
+#ifdef NVML
+    nvmlReturn_t status = nvmlInit_v2();
+    if (status != NVML_SUCCESS) {
+        info_string_important("NVML couldn't be initialized:", nvmlErrorString(status));
+        return false;
+    }
+    this->deviceIDs.clear();
+    handles.clear();
+    for (int deviceID : deviceIDs) {
+        nvmlDevice_t handle;
+#ifdef TENSORRT
+        // the CUDA and the NVML enumeration differ if CUDA_VISIBLE_DEVICES is set, the PCI bus id is the same in both
+        char pciBusID[32];
+        if (cudaDeviceGetPCIBusId(pciBusID, sizeof(pciBusID), deviceID) != cudaSuccess) {
+            info_string_important("No PCI bus id for device", deviceID);
+            continue;
+        }
+        status = nvmlDeviceGetHandleByPciBusId_v2(pciBusID, &handle);
+#else
+        status = nvmlDeviceGetHandleByIndex_v2(unsigned(deviceID), &handle);
+#endif
+        if (status != NVML_SUCCESS) {
+            info_string_important("NVML couldn't open device " + std::to_string(deviceID) + ":", nvmlErrorString(status));
+            continue;
+        }
+        this->deviceIDs.emplace_back(deviceID);
+        handles.emplace_back(handle);
+    }
+    if (handles.empty()) {
+        nvmlShutdown();
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sampleMtx);
+        latestSamples.assign(handles.size(), DeviceSample());
+        for (size_t idx = 0; idx < handles.size(); ++idx) {
+            latestSamples[idx].deviceID = this->deviceIDs[idx];
+        }
+        sampleSums = latestSamples;
+        numberSamples = 0;
+    }
+    isRunning = true;
+    samplerThread = std::thread(&DeviceMonitor::run_sampler, this, std::max(intervalMS, size_t(1)));
+    return true;
+#else
+    info_string_important("The device monitor requires a build with USE_NVML.");
+    return false;
+#endif
+}
+
+void DeviceMonitor::stop()
+{
+    if (!samplerThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stopMtx);
+        isRunning = false;
+    }
+    stopCondition.notify_all();
+    samplerThread.join();
+#ifdef NVML
+    nvmlShutdown();
+#endif
+}
+
+bool DeviceMonitor::is_running() const
+{
+    return samplerThread.joinable();
+}
+
+void DeviceMonitor::run_sampler(size_t intervalMS)
+{
+    std::unique_lock<std::mutex> stopLock(stopMtx);
+    while (isRunning) {
+#ifdef NVML
+        std::vector<DeviceSample> samples(handles.size());
+        for (size_t idx = 0; idx < handles.size(); ++idx) {
+            nvmlDevice_t handle = static_cast<nvmlDevice_t>(handles[idx]);
+            DeviceSample& sample = samples[idx];
+            sample.deviceID = deviceIDs[idx];
+            // a query which isn't supported by the device leaves its value at zero
+            nvmlUtilization_t utilization;
+            if (nvmlDeviceGetUtilizationRates(handle, &utilization) == NVML_SUCCESS) {
+                sample.gpuUtilization = utilization.gpu;
+                sample.memoryUtilization = utilization.memory;
+            }
+            nvmlMemory_t memory;
+            if (nvmlDeviceGetMemoryInfo(handle, &memory) == NVML_SUCCESS) {
+                sample.memoryUsedBytes = memory.used;
+                sample.memoryTotalBytes = memory.total;
+            }
+            unsigned int value;
+            if (nvmlDeviceGetClockInfo(handle, NVML_CLOCK_SM, &value) == NVML_SUCCESS) {
+                sample.smClockMHz = value;
+            }
+            if (nvmlDeviceGetClockInfo(handle, NVML_CLOCK_MEM, &value) == NVML_SUCCESS) {
+                sample.memoryClockMHz = value;
+            }
+            if (nvmlDeviceGetTemperature(handle, NVML_TEMPERATURE_GPU, &value) == NVML_SUCCESS) {
+                sample.temperatureC = value;
+            }
+            unsigned long long throttleReasons;
+            if (nvmlDeviceGetCurrentClocksThrottleReasons(handle, &throttleReasons) == NVML_SUCCESS) {
+                sample.isThrottled = (throttleReasons & THROTTLE_REASONS_MASK) != 0;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(sampleMtx);
+            latestSamples = samples;
+            for (size_t idx = 0; idx < samples.size(); ++idx) {
+                DeviceSample& sum = sampleSums[idx];
+                sum.gpuUtilization += samples[idx].gpuUtilization;
+                sum.memoryUtilization += samples[idx].memoryUtilization;
+                sum.memoryUsedBytes += samples[idx].memoryUsedBytes;
+                sum.memoryTotalBytes = samples[idx].memoryTotalBytes;
+                sum.smClockMHz += samples[idx].smClockMHz;
+                sum.memoryClockMHz += samples[idx].memoryClockMHz;
+                sum.temperatureC += samples[idx].temperatureC;
+                sum.isThrottled = sum.isThrottled || samples[idx].isThrottled;
+            }
+            ++numberSamples;
+        }
+#endif
+        stopCondition.wait_for(stopLock, std::chrono::milliseconds(intervalMS), [this] { return !isRunning; });
+    }
+}
+
+std::vector<DeviceSample> DeviceMonitor::get_latest_samples() const
+{
+    std::lock_guard<std::mutex> lock(sampleMtx);
+    return latestSamples;
+}
+
+std::vector<DeviceSample> DeviceMonitor::get_average_samples() const
+{
+    std::lock_guard<std::mutex> lock(sampleMtx);
+    if (numberSamples == 0) {
+        return latestSamples;
+    }
+    std::vector<DeviceSample> averages = sampleSums;
+    for (DeviceSample& average : averages) {
+        average.gpuUtilization /= numberSamples;
+        average.memoryUtilization /= numberSamples;
+        average.memoryUsedBytes /= numberSamples;
+        average.smClockMHz /= numberSamples;
+        average.memoryClockMHz /= numberSamples;
+        average.temperatureC /= numberSamples;
+    }
+    return averages;
+}
+
+void DeviceMonitor::reset_averages()
+{
+    std::lock_guard<std::mutex> lock(sampleMtx);
+    for (size_t idx = 0; idx < sampleSums.size(); ++idx) {
+        sampleSums[idx] = DeviceSample();
+        sampleSums[idx].deviceID = latestSamples[idx].deviceID;
+    }
+    numberSamples = 0;
+}
+
+DeviceMonitor& device_monitor()
+{
+    static DeviceMonitor instance;
+    return instance;
+}
+
+std::string device_samples_report(const std::vector<DeviceSample>& samples)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(0);
+    for (const DeviceSample& sample : samples) {
+        ss << "gpu" << sample.deviceID << " util " << sample.gpuUtilization << "% mem util " << sample.memoryUtilization << "%"
+           << " mem " << sample.memoryUsedBytes / (1024 * 1024) << "/" << sample.memoryTotalBytes / (1024 * 1024) << " MB"
+           << " sm " << sample.smClockMHz << " MHz mem " << sample.memoryClockMHz << " MHz " << sample.temperatureC << " C"
+           << (sample.isThrottled ? " throttled" : "") << "\n";
+    }
+    return ss.str();
+}
@@ -0,0 +1,128 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: devicemonitor.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Background sampling of the utilization, memory, clocks and temperature of the GPUs via NVML (build option USE_NVML).
+ * The samples are reported next to the search speed, on the metrics endpoint and in the benchmark report,
+ * so that a drop of the NPS can be attributed to a saturated, throttled or starved device.
+ */
+
+#ifndef DEVICEMONITOR_H
+#define DEVICEMONITOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The DeviceSample struct holds the state of a single device
+ */
+struct DeviceSample
+{
+    int deviceID = 0;
+    // percentage of time in which a kernel was running and in which the device memory was read or written
+    double gpuUtilization = 0;
+    double memoryUtilization = 0;
+    uint64_t memoryUsedBytes = 0;
+    uint64_t memoryTotalBytes = 0;
+    double smClockMHz = 0;
+    double memoryClockMHz = 0;
+    double temperatureC = 0;
+    // true if the clocks are reduced for another reason than idling (e.g. power or thermal limit)
+    bool isThrottled = false;
+};
+
+/**
+ * @brief The DeviceMonitor class samples the devices in a background thread and keeps the latest sample and the average since the last reset
+ */
+class DeviceMonitor
+{
+private:
+    std::vector<int> deviceIDs;
+    // NVML device handles of deviceIDs
+    std::vector<void*> handles;
+    std::vector<DeviceSample> latestSamples;
+    std::vector<DeviceSample> sampleSums;
+    size_t numberSamples;
+    mutable std::mutex sampleMtx;
+    std::thread samplerThread;
+    std::mutex stopMtx;
+    std::condition_variable stopCondition;
+    bool isRunning;
+
+    void run_sampler(size_t intervalMS);
+
+public:
+    DeviceMonitor();
+    ~DeviceMonitor();
+    DeviceMonitor(const DeviceMonitor&) = delete;
+    DeviceMonitor& operator=(const DeviceMonitor&) = delete;
+
+    /**
+     * @brief start Starts sampling the given CUDA devices, a running sampler is stopped before
+     * @param deviceIDs CUDA device indices
+     * @param intervalMS Time between two samples
+     * @return False if NVML isn't available or none of the devices could be opened
+     */
+    bool start(const std::vector<int>& deviceIDs, size_t intervalMS);
+
+    /**
+     * @brief stop Stops the sampler thread
+     */
+    void stop();
+
+    bool is_running() const;
+
+    /**
+     * @brief get_latest_samples Returns the latest sample of each device
+     */
+    std::vector<DeviceSample> get_latest_samples() const;
+
+    /**
+     * @brief get_average_samples Returns the average of each device since the last call of reset_averages() (the throttle flag is set if any sample was throttled)
+     */
+    std::vector<DeviceSample> get_average_samples() const;
+
+    /**
+     * @brief reset_averages Starts a new averaging period, e.g. at the beginning of a benchmark
+     */
+    void reset_averages();
+};
+
+/**
+ * @brief device_monitor Returns the device monitor which is shared by the whole process
+ */
+DeviceMonitor& device_monitor();
+
+/**
+ * @brief device_samples_report Returns one line for each device, e.g. "gpu0 util 97% mem util 41% mem 5123/8192 MB sm 1830 MHz mem 7000 MHz 64 C"
+ * @param samples Samples of get_latest_samples() or get_average_samples()
+ */
+std::string device_samples_report(const std::vector<DeviceSample>& samples);
+
+#endif // DEVICEMONITOR_H
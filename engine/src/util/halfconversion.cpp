@@ -0,0 +1,184 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: halfconversion.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "halfconversion.h"
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HALF_X86_DISPATCH
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define HALF_NEON
+#include <arm_neon.h>
+#endif
+
+float half_to_float_scalar(uint16_t value)
+{
+    const uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0x1F) {
+        // infinity or NaN
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0) {
+        bits = sign;
+    }
+    else {
+        // subnormal half values are normal floats
+        exponent = 113;
+        while ((mantissa & 0x400) == 0) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, sizeof(float));
+    return result;
+}
+
+uint16_t float_to_half_scalar(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    const uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+    const uint32_t absBits = bits & 0x7FFFFFFF;
+    if (absBits >= 0x7F800000) {
+        // infinity or NaN (keep NaN quiet)
+        return sign | 0x7C00 | (absBits > 0x7F800000 ? 0x200 : 0);
+    }
+    if (absBits >= 0x477FF000) {
+        // overflow after rounding
+        return sign | 0x7C00;
+    }
+    if (absBits < 0x38800000) {
+        // subnormal half or zero
+        if (absBits < 0x33000000) {
+            return sign;
+        }
+        const uint32_t exponent = absBits >> 23;
+        const uint32_t mantissa = (absBits & 0x7FFFFF) | 0x800000;
+        const uint32_t shift = 126 - exponent;
+        uint32_t halfMantissa = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1U << shift) - 1);
+        const uint32_t halfway = 1U << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (halfMantissa & 1))) {
+            ++halfMantissa;
+        }
+        return sign | uint16_t(halfMantissa);
+    }
+    // normal half: rebias the exponent and round the mantissa to nearest even
+    uint32_t halfBits = ((absBits >> 13) - (112 << 10));
+    const uint32_t remainder = absBits & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (halfBits & 1))) {
+        ++halfBits;
+    }
+    return sign | uint16_t(halfBits);
+}
+
+namespace {
+#ifdef HALF_X86_DISPATCH
+__attribute__((target("avx,f16c")))
+void half_to_float_f16c(const uint16_t* input, float* output, size_t numberValues)
+{
+    size_t idx = 0;
+    for (; idx + 8 <= numberValues; idx += 8) {
+        const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + idx));
+        _mm256_storeu_ps(output + idx, _mm256_cvtph_ps(values));
+    }
+    for (; idx < numberValues; ++idx) {
+        output[idx] = half_to_float_scalar(input[idx]);
+    }
+}
+
+__attribute__((target("avx,f16c")))
+void float_to_half_f16c(const float* input, uint16_t* output, size_t numberValues)
+{
+    size_t idx = 0;
+    for (; idx + 8 <= numberValues; idx += 8) {
+        const __m256 values = _mm256_loadu_ps(input + idx);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + idx), _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT));
+    }
+    for (; idx < numberValues; ++idx) {
+        output[idx] = float_to_half_scalar(input[idx]);
+    }
+}
+
+bool has_f16c()
+{
+    static const bool supported = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return supported;
+}
+#endif
+}
+
+void half_to_float(const uint16_t* input, float* output, size_t numberValues)
+{
+#ifdef HALF_X86_DISPATCH
+    if (has_f16c()) {
+        half_to_float_f16c(input, output, numberValues);
+        return;
+    }
+#elif defined(HALF_NEON)
+    size_t idx = 0;
+    for (; idx + 4 <= numberValues; idx += 4) {
+        vst1q_f32(output + idx, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(input + idx))));
+    }
+    for (; idx < numberValues; ++idx) {
+        output[idx] = half_to_float_scalar(input[idx]);
+    }
+    return;
+#endif
+    for (size_t idx = 0; idx < numberValues; ++idx) {
+        output[idx] = half_to_float_scalar(input[idx]);
+    }
+}
+
+void float_to_half(const float* input, uint16_t* output, size_t numberValues)
+{
+#ifdef HALF_X86_DISPATCH
+    if (has_f16c()) {
+        float_to_half_f16c(input, output, numberValues);
+        return;
+    }
+#elif defined(HALF_NEON)
+    size_t idx = 0;
+    for (; idx + 4 <= numberValues; idx += 4) {
+        vst1_u16(output + idx, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(input + idx))));
+    }
+    for (; idx < numberValues; ++idx) {
+        output[idx] = float_to_half_scalar(input[idx]);
+    }
+    return;
+#endif
+    for (size_t idx = 0; idx < numberValues; ++idx) {
+        output[idx] = float_to_half_scalar(input[idx]);
+    }
+}
@@ -0,0 +1,65 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: halfconversion.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Conversion between IEEE 754 half precision (stored as uint16_t) and float arrays.
+ * The F16C instructions are used on x86 if the CPU supports them, NEON on aarch64 and a scalar version otherwise.
+ */
+
+#ifndef HALFCONVERSION_H
+#define HALFCONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief half_to_float_scalar Converts a single half precision value to float
+ * @param value Half precision bits
+ * @return float
+ */
+float half_to_float_scalar(uint16_t value);
+
+/**
+ * @brief float_to_half_scalar Converts a single float to half precision using round to nearest even
+ * @param value float
+ * @return Half precision bits
+ */
+uint16_t float_to_half_scalar(float value);
+
+/**
+ * @brief half_to_float Converts an array of half precision values to float
+ * @param input Half precision values
+ * @param output Float values
+ * @param numberValues Number of values
+ */
+void half_to_float(const uint16_t* input, float* output, size_t numberValues);
+
+/**
+ * @brief float_to_half Converts an array of float values to half precision
+ * @param input Float values
+ * @param output Half precision values
+ * @param numberValues Number of values
+ */
+void float_to_half(const float* input, uint16_t* output, size_t numberValues);
+
+#endif // HALFCONVERSION_H
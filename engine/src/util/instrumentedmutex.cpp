@@ -0,0 +1,122 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: instrumentedmutex.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "instrumentedmutex.h"
+#include <iomanip>
+#include <sstream>
+#include "communication.h"
+
+using namespace std;
+
+static thread_local size_t lockDepth = 0;
+
+LockStats::LockStats()
+{
+    reset();
+}
+
+void LockStats::reset()
+{
+    for (Counters& c : counters) {
+        c.acquisitions.store(0, memory_order_relaxed);
+        c.contended.store(0, memory_order_relaxed);
+        c.waitNanoseconds.store(0, memory_order_relaxed);
+        c.holdNanoseconds.store(0, memory_order_relaxed);
+    }
+}
+
+void LockStats::print() const
+{
+    info_string("lock | acquisitions | contended | avg wait us | avg hold us | total wait ms");
+    for (size_t idx = 0; idx < NB_LOCK_CLASSES; ++idx) {
+        const Counters& c = counters[idx];
+        const uint64_t acquisitions = c.acquisitions.load(memory_order_relaxed);
+        if (acquisitions == 0) {
+            continue;
+        }
+        const uint64_t contended = c.contended.load(memory_order_relaxed);
+        const uint64_t waitNanoseconds = c.waitNanoseconds.load(memory_order_relaxed);
+        stringstream ss;
+        ss << std::fixed << std::setprecision(2) << acquisitions << " | " << 100.0 * contended / acquisitions << "% | "
+           << (contended == 0 ? 0 : waitNanoseconds / 1e3 / contended) << " us | "
+           << c.holdNanoseconds.load(memory_order_relaxed) / 1e3 / acquisitions << " us | " << waitNanoseconds / 1e6 << " ms";
+        info_string(lock_class_name(LockClass(idx)), ss.str());
+    }
+}
+
+LockStats& lock_stats()
+{
+    static LockStats stats;
+    return stats;
+}
+
+const char* lock_class_name(LockClass lockClass)
+{
+    switch (lockClass) {
+    case LOCK_ROOT_NODE:
+        return "root_node";
+    case LOCK_NODE_DEPTH_1:
+        return "node_depth_1";
+    case LOCK_NODE_DEPTH_2_3:
+        return "node_depth_2_3";
+    case LOCK_NODE_DEPTH_4_7:
+        return "node_depth_4_7";
+    case LOCK_NODE_DEPTH_8_PLUS:
+        return "node_depth_8+";
+    case LOCK_HASH_SHARD:
+        return "hash_shard";
+    case LOCK_ROOT_PREDICTION:
+        return "root_prediction";
+    case LOCK_AGENT:
+        return "agent";
+    case LOCK_THREAD_EVENTS:
+        return "thread_events";
+    default:
+        return "unknown";
+    }
+}
+
+void set_lock_depth(size_t depth)
+{
+    lockDepth = depth;
+}
+
+LockClass get_node_lock_class(bool isRootNode)
+{
+    if (isRootNode) {
+        return LOCK_ROOT_NODE;
+    }
+    if (lockDepth <= 1) {
+        return LOCK_NODE_DEPTH_1;
+    }
+    if (lockDepth <= 3) {
+        return LOCK_NODE_DEPTH_2_3;
+    }
+    if (lockDepth <= 7) {
+        return LOCK_NODE_DEPTH_4_7;
+    }
+    return LOCK_NODE_DEPTH_8_PLUS;
+}
@@ -0,0 +1,184 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: instrumentedmutex.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Mutex wrapper which records the number of acquisitions, the contended acquisitions, the wait time and the hold time per lock class.
+ * The search locks are declared as ProfiledMutex<...> which is a plain std::mutex unless building with MCTS_LOCK_STATS,
+ * so the instrumentation has no cost in regular builds.
+ * The node locks are classified by the depth of the node, which is given by the search thread with LOCK_DEPTH() before locking.
+ */
+
+#ifndef INSTRUMENTEDMUTEX_H
+#define INSTRUMENTEDMUTEX_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+enum LockClass {
+    LOCK_ROOT_NODE,
+    LOCK_NODE_DEPTH_1,
+    LOCK_NODE_DEPTH_2_3,
+    LOCK_NODE_DEPTH_4_7,
+    LOCK_NODE_DEPTH_8_PLUS,
+    LOCK_HASH_SHARD,
+    // prediction of the root node which is shared by the agents of a multi-agent search
+    LOCK_ROOT_PREDICTION,
+    // start and stop of the search by the agent
+    LOCK_AGENT,
+    // events and termination of the thread manager and other killable threads
+    LOCK_THREAD_EVENTS,
+    NB_LOCK_CLASSES
+};
+
+/**
+ * @brief The LockStats class accumulates the lock statistics of all threads
+ */
+class LockStats
+{
+private:
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> acquisitions;
+        std::atomic<uint64_t> contended;
+        std::atomic<uint64_t> waitNanoseconds;
+        std::atomic<uint64_t> holdNanoseconds;
+    };
+    Counters counters[NB_LOCK_CLASSES];
+public:
+    LockStats();
+
+    void add_acquisition(LockClass lockClass, bool contended, uint64_t waitNanoseconds) {
+        Counters& c = counters[lockClass];
+        c.acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (contended) {
+            c.contended.fetch_add(1, std::memory_order_relaxed);
+            c.waitNanoseconds.fetch_add(waitNanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    void add_hold(LockClass lockClass, uint64_t holdNanoseconds) {
+        counters[lockClass].holdNanoseconds.fetch_add(holdNanoseconds, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief reset Sets all counters to 0
+     */
+    void reset();
+
+    /**
+     * @brief print Prints the acquisitions, the contention ratio and the average wait and hold time of each lock class as info strings
+     */
+    void print() const;
+};
+
+/**
+ * @brief lock_stats Returns the process wide lock statistics
+ */
+LockStats& lock_stats();
+
+/**
+ * @brief lock_class_name Returns a short name of the lock class
+ */
+const char* lock_class_name(LockClass lockClass);
+
+/**
+ * @brief set_lock_depth Sets the depth of the nodes which are locked next by the calling thread
+ */
+void set_lock_depth(size_t depth);
+
+/**
+ * @brief get_node_lock_class Returns the lock class of a node at the depth given by the last set_lock_depth() call of the calling thread
+ */
+LockClass get_node_lock_class(bool isRootNode);
+
+/**
+ * @brief The InstrumentedMutex class is a std::mutex which reports its acquisitions to lock_stats()
+ * @tparam lockClass Default class for lock(), nodes choose the class on every acquisition by lock_as()
+ */
+template <LockClass lockClass>
+class InstrumentedMutex
+{
+private:
+    std::mutex mtx;
+    // only modified by the thread which holds the mutex
+    LockClass heldClass = lockClass;
+    std::chrono::steady_clock::time_point acquisitionTime;
+
+    static uint64_t elapsed_nanoseconds(std::chrono::steady_clock::time_point start) {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+public:
+    void lock() {
+        lock_as(lockClass);
+    }
+
+    void lock_as(LockClass acquiredClass) {
+        uint64_t waitNanoseconds = 0;
+        const bool contended = !mtx.try_lock();
+        if (contended) {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            mtx.lock();
+            waitNanoseconds = elapsed_nanoseconds(start);
+        }
+        heldClass = acquiredClass;
+        acquisitionTime = std::chrono::steady_clock::now();
+        lock_stats().add_acquisition(acquiredClass, contended, waitNanoseconds);
+    }
+
+    bool try_lock() {
+        if (!mtx.try_lock()) {
+            return false;
+        }
+        heldClass = lockClass;
+        acquisitionTime = std::chrono::steady_clock::now();
+        lock_stats().add_acquisition(lockClass, false, 0);
+        return true;
+    }
+
+    void unlock() {
+        const LockClass releasedClass = heldClass;
+        const uint64_t holdNanoseconds = elapsed_nanoseconds(acquisitionTime);
+        mtx.unlock();
+        lock_stats().add_hold(releasedClass, holdNanoseconds);
+    }
+};
+
+#ifdef MCTS_LOCK_STATS
+template <LockClass lockClass>
+using ProfiledMutex = InstrumentedMutex<lockClass>;
+// std::condition_variable only accepts std::mutex
+using ProfiledConditionVariable = std::condition_variable_any;
+#define LOCK_DEPTH(depth) set_lock_depth(depth)
+#else
+template <LockClass lockClass>
+using ProfiledMutex = std::mutex;
+using ProfiledConditionVariable = std::condition_variable;
+#define LOCK_DEPTH(depth)
+#endif
+
+#endif // INSTRUMENTEDMUTEX_H
@@ -32,6 +32,7 @@
 
 #include <condition_variable>
 #include <mutex>
+#include "instrumentedmutex.h"
 
 using namespace std;
 
@@ -41,10 +42,13 @@ using namespace std;
 class KillableThread
 {
 protected:
-    mutable condition_variable cv;
-    mutable mutex mtx;
+    typedef ProfiledMutex<LOCK_THREAD_EVENTS> EventMutex;
+    mutable ProfiledConditionVariable cv;
+    mutable EventMutex mtx;
     bool isRunning = true;
     bool terminate = false;
+    // number of events which have been signaled by other threads
+    size_t numberEvents = 0;
 
 public:
     /**
@@ -54,15 +58,39 @@ public:
      */
     template<class R, class P>
     bool wait_for( std::chrono::duration<R,P> const& time ) const {
-        unique_lock<std::mutex> lock(mtx);
+        unique_lock<EventMutex> lock(mtx);
         return !cv.wait_for(lock, time, [&]{return terminate;});
     }
 
+    /**
+     * @brief wait_for_event Waits until the given deadline or until a new event has been signaled,
+     * but can be interrupted by a kill() call from an external thread
+     * @param deadline Point in time at which the waiting ends at the latest
+     * @param seenEvents Number of events which have already been handled, is updated to the current number of events
+     * @return False if it was triggered by kill() and true otherwise
+     */
+    template<class C, class D>
+    bool wait_for_event(std::chrono::time_point<C,D> const& deadline, size_t& seenEvents) const {
+        unique_lock<EventMutex> lock(mtx);
+        cv.wait_until(lock, deadline, [&]{return terminate || numberEvents != seenEvents;});
+        seenEvents = numberEvents;
+        return !terminate;
+    }
+
+    /**
+     * @brief signal_event Wakes up the thread if it is waiting in wait_for_event()
+     */
+    void signal_event() {
+        unique_lock<EventMutex> lock(mtx);
+        ++numberEvents;
+        cv.notify_all();
+    }
+
     /**
      * @brief kill Kills the current thread by triggering the conditional variable
      */
     void kill() {
-        unique_lock<std::mutex> lock(mtx);
+        unique_lock<EventMutex> lock(mtx);
         terminate = true;
         cv.notify_all();
         isRunning = false;
@@ -0,0 +1,140 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: largepages.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "largepages.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#elif defined(_WIN32)
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+namespace {
+atomic<LargePageMode> largePageMode(LARGE_PAGES_OFF);
+
+#ifdef __linux__
+inline size_t round_up(size_t numberBytes, size_t alignment)
+{
+    return (numberBytes + alignment - 1) & ~(alignment - 1);
+}
+
+void* map_anonymous(size_t numberBytes, int extraFlags)
+{
+    void* memory = mmap(nullptr, numberBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+    return memory == MAP_FAILED ? nullptr : memory;
+}
+#endif
+}
+
+LargePageMode str_to_large_page_mode(const string& mode)
+{
+    if (mode == "transparent") {
+        return LARGE_PAGES_TRANSPARENT;
+    }
+    if (mode == "explicit") {
+        return LARGE_PAGES_EXPLICIT;
+    }
+    return LARGE_PAGES_OFF;
+}
+
+void set_large_page_mode(LargePageMode mode)
+{
+    largePageMode = mode;
+}
+
+LargePageMode get_large_page_mode()
+{
+    return largePageMode;
+}
+
+void* large_page_allocate(size_t numberBytes, size_t alignment)
+{
+#ifdef __linux__
+    const LargePageMode mode = largePageMode;
+    const size_t mappedBytes = round_up(numberBytes, 4096);
+    // reserved huge pages can only back (and unmap) whole huge pages
+    if (mode == LARGE_PAGES_EXPLICIT && mappedBytes % HUGE_PAGE_SIZE == 0 && alignment <= HUGE_PAGE_SIZE) {
+        void* memory = map_anonymous(mappedBytes, MAP_HUGETLB);
+        if (memory != nullptr) {
+            return memory;
+        }
+    }
+    // over-allocate to align the block and return the unused head and tail to the system,
+    // transparent huge pages require the block to be aligned to the huge page size
+    const size_t blockAlignment = max(alignment, mode == LARGE_PAGES_OFF ? size_t(4096) : HUGE_PAGE_SIZE);
+    const size_t reservedBytes = mappedBytes + blockAlignment;
+    char* reserved = static_cast<char*>(map_anonymous(reservedBytes, 0));
+    if (reserved == nullptr) {
+        throw bad_alloc();
+    }
+    char* memory = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(reserved), blockAlignment));
+    if (memory != reserved) {
+        munmap(reserved, memory - reserved);
+    }
+    const size_t tailBytes = reserved + reservedBytes - (memory + mappedBytes);
+    if (tailBytes != 0) {
+        munmap(memory + mappedBytes, tailBytes);
+    }
+    if (mode != LARGE_PAGES_OFF) {
+        madvise(memory, mappedBytes, MADV_HUGEPAGE);
+    }
+    return memory;
+#else
+    // huge pages are only supported on Linux, the other platforms use the regular aligned allocation
+    const size_t alignedBytes = (numberBytes + alignment - 1) & ~(alignment - 1);
+#ifdef _WIN32
+    void* memory = _aligned_malloc(alignedBytes, alignment);
+#else
+    void* memory = aligned_alloc(alignment, alignedBytes);
+#endif
+    if (memory == nullptr) {
+        throw bad_alloc();
+    }
+    memset(memory, 0, alignedBytes);
+    return memory;
+#endif
+}
+
+void large_page_free(void* ptr, size_t numberBytes)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+#ifdef __linux__
+    munmap(ptr, round_up(numberBytes, 4096));
+#elif defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
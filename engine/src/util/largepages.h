@@ -0,0 +1,80 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: largepages.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Allocation of large memory blocks (node arena chunks, node pool blocks, evaluation cache) which can be backed by
+ * huge pages to reduce the TLB misses of deep descents in big trees.
+ * On Linux the blocks are mapped with mmap(), either with MAP_HUGETLB from the reserved huge pages or as transparent
+ * huge pages via madvise(MADV_HUGEPAGE). If huge pages aren't available, the allocation silently falls back to regular pages.
+ */
+
+#ifndef LARGEPAGES_H
+#define LARGEPAGES_H
+
+#include <cstddef>
+#include <string>
+
+// size of a huge page on x86-64 and arm64 with 4 KB base pages
+#define HUGE_PAGE_SIZE (size_t(1) << 21)
+
+enum LargePageMode {
+    // regular pages
+    LARGE_PAGES_OFF,
+    // transparent huge pages via madvise(MADV_HUGEPAGE)
+    LARGE_PAGES_TRANSPARENT,
+    // reserved huge pages via MAP_HUGETLB (see /proc/sys/vm/nr_hugepages), falls back to transparent huge pages
+    LARGE_PAGES_EXPLICIT
+};
+
+/**
+ * @brief str_to_large_page_mode Converts "off", "transparent" or "explicit" to the large page mode (LARGE_PAGES_OFF otherwise)
+ */
+LargePageMode str_to_large_page_mode(const std::string& mode);
+
+/**
+ * @brief set_large_page_mode Sets the mode of all later allocations, existing blocks are not affected
+ */
+void set_large_page_mode(LargePageMode mode);
+
+/**
+ * @brief get_large_page_mode Returns the current large page mode
+ */
+LargePageMode get_large_page_mode();
+
+/**
+ * @brief large_page_allocate Allocates a zero initialized memory block
+ * @param numberBytes Size of the block in bytes
+ * @param alignment Alignment of the block (a power of two)
+ * @return Pointer to the block, throws bad_alloc if no memory is available
+ */
+void* large_page_allocate(size_t numberBytes, size_t alignment);
+
+/**
+ * @brief large_page_free Releases a block of large_page_allocate()
+ * @param ptr Pointer returned by large_page_allocate() (nullptr is ignored)
+ * @param numberBytes Size which was passed to large_page_allocate()
+ */
+void large_page_free(void* ptr, size_t numberBytes);
+
+#endif // LARGEPAGES_H
@@ -0,0 +1,95 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+ * @file: memorystats.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "memorystats.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+const char* CATEGORY_NAMES[NB_MEMORY_CATEGORIES] = {
+    "nodes",
+    "node_data",
+    "hash_table",
+    "states",
+    "batch_buffers",
+    "device"
+};
+}
+
+MemoryStats::MemoryStats():
+    nextSlotIdx(0)
+{
+    for (Slot& slot : slots) {
+        for (std::atomic<int64_t>& bytes : slot.bytes) {
+            bytes = 0;
+        }
+    }
+}
+
+size_t MemoryStats::get(MemoryCategory category) const
+{
+    // a single slot can be negative if the memory was released by another thread
+    int64_t sum = 0;
+    for (const Slot& slot : slots) {
+        sum += slot.bytes[category].load(std::memory_order_relaxed);
+    }
+    return size_t(std::max(int64_t(0), sum));
+}
+
+size_t MemoryStats::get_total() const
+{
+    size_t total = 0;
+    for (size_t category = 0; category < NB_MEMORY_CATEGORIES; ++category) {
+        total += get(MemoryCategory(category));
+    }
+    return total;
+}
+
+MemoryStats& memory_stats()
+{
+    static MemoryStats instance;
+    return instance;
+}
+
+const char* memory_category_name(MemoryCategory category)
+{
+    return CATEGORY_NAMES[category];
+}
+
+std::string memory_stats_report()
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    for (size_t category = 0; category < NB_MEMORY_CATEGORIES; ++category) {
+        ss << std::left << std::setw(16) << CATEGORY_NAMES[category]
+           << std::right << std::setw(12) << memory_stats().get(MemoryCategory(category)) / (1024.0 * 1024.0) << " MB\n";
+    }
+    ss << std::left << std::setw(16) << "total"
+       << std::right << std::setw(12) << memory_stats().get_total() / (1024.0 * 1024.0) << " MB";
+    return ss.str();
+}
@@ -0,0 +1,112 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: memorystats.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Process wide byte counters of the main memory consumers (UCI command "memstats" and the metrics endpoint).
+ * Every thread updates its own cache line aligned slot without contention, the slots are summed up on read.
+ */
+
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+enum MemoryCategory {
+    // Node objects including their legal actions and prior policies
+    MEMORY_NODES,
+    // NodeData objects including their child arrays
+    MEMORY_NODE_DATA,
+    // buckets and entries of the transposition tables
+    MEMORY_HASH_TABLE,
+    // states which are stored in the nodes (MCTS_STORE_STATES)
+    MEMORY_STATES,
+    // host buffers for the input planes and the outputs of the networks
+    MEMORY_BATCH_BUFFERS,
+    // device memory of the back-ends (I/O buffers and execution contexts)
+    MEMORY_DEVICE,
+    NB_MEMORY_CATEGORIES
+};
+
+// number of slots, threads beyond this number share slots
+#define MEMORY_STATS_SLOTS 64
+
+class MemoryStats
+{
+private:
+    struct alignas(64) Slot {
+        std::atomic<int64_t> bytes[NB_MEMORY_CATEGORIES];
+    };
+    Slot slots[MEMORY_STATS_SLOTS];
+    std::atomic<size_t> nextSlotIdx;
+
+    /**
+     * @brief get_slot Returns the slot of the calling thread
+     */
+    inline Slot& get_slot() {
+        static thread_local size_t slotIdx = nextSlotIdx.fetch_add(1, std::memory_order_relaxed) % MEMORY_STATS_SLOTS;
+        return slots[slotIdx];
+    }
+
+public:
+    MemoryStats();
+    MemoryStats(const MemoryStats&) = delete;
+    MemoryStats& operator=(const MemoryStats&) = delete;
+
+    /**
+     * @brief add Adds the given number of bytes (negative for releases) to a category
+     */
+    inline void add(MemoryCategory category, int64_t bytes) {
+        get_slot().bytes[category].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief get Returns the number of bytes which are currently allocated for a category
+     */
+    size_t get(MemoryCategory category) const;
+
+    /**
+     * @brief get_total Returns the sum of all categories
+     */
+    size_t get_total() const;
+};
+
+/**
+ * @brief memory_stats Returns the memory statistics which are shared by the whole process
+ */
+MemoryStats& memory_stats();
+
+/**
+ * @brief memory_category_name Returns the name of a category as used by "memstats" and the metrics labels
+ */
+const char* memory_category_name(MemoryCategory category);
+
+/**
+ * @brief memory_stats_report Returns one line for each category and the total in MB, e.g. for the "memstats" command
+ */
+std::string memory_stats_report();
+
+#endif // MEMORYSTATS_H
@@ -0,0 +1,257 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: metrics.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "metrics.h"
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include "communication.h"
+#include "devicemonitor.h"
+#include "memorystats.h"
+#ifndef _WIN32
+#include "tcpsocket.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char* COUNTER_NAMES[NB_METRIC_COUNTERS] = {
+    "crazyara_nodes_total",
+    "crazyara_searches_total",
+    "crazyara_nn_batches_total",
+    "crazyara_nn_positions_total",
+    "crazyara_nn_batch_capacity_total",
+    "crazyara_nn_overflow_positions_total",
+    "crazyara_collisions_total",
+    "crazyara_tb_hits_total",
+    "crazyara_selfplay_games_total",
+    "crazyara_selfplay_samples_total",
+    "crazyara_selfplay_adjudicated_games_total"
+};
+
+const char* GAUGE_NAMES[NB_METRIC_GAUGES] = {
+    "crazyara_nps",
+    "crazyara_tree_nodes",
+    "crazyara_node_memory_bytes",
+    "crazyara_hash_load_permille"
+};
+}
+
+Metrics::Metrics():
+    latencySumUS(0)
+{
+    for (std::atomic<uint64_t>& counter : counters) {
+        counter = 0;
+    }
+    for (std::atomic<int64_t>& gauge : gauges) {
+        gauge = 0;
+    }
+    for (std::atomic<uint64_t>& bucket : latencyBuckets) {
+        bucket = 0;
+    }
+}
+
+void Metrics::observe_nn_latency(uint64_t latencyUS)
+{
+    size_t bucketIdx = 0;
+    while (bucketIdx < NB_LATENCY_BUCKETS && latencyUS > LATENCY_BUCKETS_US[bucketIdx]) {
+        ++bucketIdx;
+    }
+    latencyBuckets[bucketIdx].fetch_add(1, std::memory_order_relaxed);
+    latencySumUS.fetch_add(latencyUS, std::memory_order_relaxed);
+}
+
+std::string Metrics::to_prometheus() const
+{
+    std::stringstream ss;
+    for (size_t idx = 0; idx < NB_METRIC_COUNTERS; ++idx) {
+        ss << "# TYPE " << COUNTER_NAMES[idx] << " counter\n"
+           << COUNTER_NAMES[idx] << " " << counters[idx].load(std::memory_order_relaxed) << "\n";
+    }
+    for (size_t idx = 0; idx < NB_METRIC_GAUGES; ++idx) {
+        ss << "# TYPE " << GAUGE_NAMES[idx] << " gauge\n"
+           << GAUGE_NAMES[idx] << " " << gauges[idx].load(std::memory_order_relaxed) << "\n";
+    }
+    ss << "# TYPE crazyara_memory_bytes gauge\n";
+    for (size_t category = 0; category < NB_MEMORY_CATEGORIES; ++category) {
+        ss << "crazyara_memory_bytes{category=\"" << memory_category_name(MemoryCategory(category)) << "\"} "
+           << memory_stats().get(MemoryCategory(category)) << "\n";
+    }
+    const std::vector<DeviceSample> deviceSamples = device_monitor().get_latest_samples();
+    if (!deviceSamples.empty()) {
+        ss << "# TYPE crazyara_gpu_utilization_percent gauge\n"
+           << "# TYPE crazyara_gpu_memory_used_bytes gauge\n"
+           << "# TYPE crazyara_gpu_sm_clock_mhz gauge\n"
+           << "# TYPE crazyara_gpu_temperature_celsius gauge\n"
+           << "# TYPE crazyara_gpu_throttled gauge\n";
+    }
+    for (const DeviceSample& sample : deviceSamples) {
+        const std::string label = "{device=\"" + std::to_string(sample.deviceID) + "\"} ";
+        ss << "crazyara_gpu_utilization_percent" << label << sample.gpuUtilization << "\n"
+           << "crazyara_gpu_memory_used_bytes" << label << sample.memoryUsedBytes << "\n"
+           << "crazyara_gpu_sm_clock_mhz" << label << sample.smClockMHz << "\n"
+           << "crazyara_gpu_temperature_celsius" << label << sample.temperatureC << "\n"
+           << "crazyara_gpu_throttled" << label << sample.isThrottled << "\n";
+    }
+    ss << "# TYPE crazyara_nn_latency_seconds histogram\n";
+    uint64_t cumulativeCount = 0;
+    for (size_t idx = 0; idx < NB_LATENCY_BUCKETS; ++idx) {
+        cumulativeCount += latencyBuckets[idx].load(std::memory_order_relaxed);
+        ss << "crazyara_nn_latency_seconds_bucket{le=\"" << LATENCY_BUCKETS_US[idx] / 1e6 << "\"} " << cumulativeCount << "\n";
+    }
+    cumulativeCount += latencyBuckets[NB_LATENCY_BUCKETS].load(std::memory_order_relaxed);
+    ss << "crazyara_nn_latency_seconds_bucket{le=\"+Inf\"} " << cumulativeCount << "\n"
+       << "crazyara_nn_latency_seconds_sum " << latencySumUS.load(std::memory_order_relaxed) / 1e6 << "\n"
+       << "crazyara_nn_latency_seconds_count " << cumulativeCount << "\n";
+    return ss.str();
+}
+
+std::string Metrics::to_statsd(uint64_t* previousCounters) const
+{
+    std::stringstream ss;
+    for (size_t idx = 0; idx < NB_METRIC_COUNTERS; ++idx) {
+        const uint64_t value = counters[idx].load(std::memory_order_relaxed);
+        ss << COUNTER_NAMES[idx] << ":" << value - previousCounters[idx] << "|c\n";
+        previousCounters[idx] = value;
+    }
+    for (size_t idx = 0; idx < NB_METRIC_GAUGES; ++idx) {
+        ss << GAUGE_NAMES[idx] << ":" << gauges[idx].load(std::memory_order_relaxed) << "|g\n";
+    }
+    for (size_t category = 0; category < NB_MEMORY_CATEGORIES; ++category) {
+        ss << "crazyara_memory_bytes." << memory_category_name(MemoryCategory(category)) << ":"
+           << memory_stats().get(MemoryCategory(category)) << "|g\n";
+    }
+    for (const DeviceSample& sample : device_monitor().get_latest_samples()) {
+        const std::string suffix = ".gpu" + std::to_string(sample.deviceID) + ":";
+        ss << "crazyara_gpu_utilization_percent" << suffix << sample.gpuUtilization << "|g\n"
+           << "crazyara_gpu_memory_used_bytes" << suffix << sample.memoryUsedBytes << "|g\n"
+           << "crazyara_gpu_sm_clock_mhz" << suffix << sample.smClockMHz << "|g\n"
+           << "crazyara_gpu_temperature_celsius" << suffix << sample.temperatureC << "|g\n";
+    }
+    uint64_t latencyCount = 0;
+    for (const std::atomic<uint64_t>& bucket : latencyBuckets) {
+        latencyCount += bucket.load(std::memory_order_relaxed);
+    }
+    if (latencyCount != 0) {
+        ss << "crazyara_nn_latency_avg_us:" << latencySumUS.load(std::memory_order_relaxed) / latencyCount << "|g\n";
+    }
+    return ss.str();
+}
+
+Metrics& metrics()
+{
+    static Metrics instance;
+    return instance;
+}
+
+#ifndef _WIN32
+MetricsExporter::MetricsExporter(int port, const std::string& statsdAddress):
+    listenFd(-1),
+    statsdFd(-1),
+    isRunning(true)
+{
+    if (port != 0) {
+        listenFd = listen_on_port(port);
+        httpThread = std::thread(&MetricsExporter::serve_http, this);
+        info_string("metrics endpoint listening on port", port);
+    }
+    if (statsdAddress != "") {
+        statsdFd = connect_to_address(statsdAddress, true);
+        if (statsdFd == -1) {
+            throw std::invalid_argument("The StatsD address " + statsdAddress + " couldn't be used.");
+        }
+        pushThread = std::thread(&MetricsExporter::push_statsd, this);
+        info_string("pushing metrics to", statsdAddress);
+    }
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    isRunning = false;
+    if (httpThread.joinable()) {
+        // wakes up the blocking accept()
+        shutdown(listenFd, SHUT_RDWR);
+        httpThread.join();
+        close(listenFd);
+    }
+    if (pushThread.joinable()) {
+        pushThread.join();
+        close(statsdFd);
+    }
+}
+
+void MetricsExporter::serve_http()
+{
+    while (isRunning) {
+        const int fd = accept(listenFd, nullptr, nullptr);
+        if (fd == -1) {
+            if (!isRunning) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        // every request is answered with the metrics, the request itself is ignored
+        char request[1024];
+        recv(fd, request, sizeof(request), 0);
+        const std::string body = metrics().to_prometheus();
+        const std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        send_all(fd, response.data(), response.size());
+        close(fd);
+    }
+}
+
+void MetricsExporter::push_statsd()
+{
+    uint64_t previousCounters[NB_METRIC_COUNTERS] = {};
+    auto nextPush = std::chrono::steady_clock::now();
+    while (isRunning) {
+        if (std::chrono::steady_clock::now() < nextPush) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        nextPush += std::chrono::milliseconds(METRICS_PUSH_INTERVAL_MS);
+        const std::string lines = metrics().to_statsd(previousCounters);
+        // datagrams which can't be delivered are dropped
+        send(statsdFd, lines.data(), lines.size(), MSG_NOSIGNAL);
+    }
+}
+#else
+MetricsExporter::MetricsExporter(int port, const std::string& statsdAddress):
+    listenFd(-1),
+    statsdFd(-1),
+    isRunning(false)
+{
+    if (port != 0 || statsdAddress != "") {
+        throw std::invalid_argument("The metrics exporter is not supported on Windows.");
+    }
+}
+
+MetricsExporter::~MetricsExporter()
+{
+}
+#endif
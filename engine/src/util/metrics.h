@@ -0,0 +1,160 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: metrics.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Process wide counters, gauges and a latency histogram for monitoring long running engines.
+ * The values are served over HTTP in the Prometheus text format (UCI option "Metrics_Port")
+ * and/or pushed periodically as StatsD datagrams (UCI option "Metrics_StatsD_Address").
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+enum MetricCounter {
+    METRIC_NODES,
+    METRIC_SEARCHES,
+    METRIC_NN_BATCHES,
+    METRIC_NN_POSITIONS,
+    // sum of the batch sizes of all evaluated batches, the fill ratio is METRIC_NN_POSITIONS / METRIC_NN_BATCH_CAPACITY
+    METRIC_NN_BATCH_CAPACITY,
+    // positions which were evaluated by the cpu overflow workers of the inference server
+    METRIC_NN_OVERFLOW_POSITIONS,
+    METRIC_COLLISIONS,
+    METRIC_TB_HITS,
+    METRIC_SELFPLAY_GAMES,
+    METRIC_SELFPLAY_SAMPLES,
+    // selfplay games which were ended by resignation or adjudication
+    METRIC_SELFPLAY_ADJUDICATED_GAMES,
+    NB_METRIC_COUNTERS
+};
+
+enum MetricGauge {
+    METRIC_NPS,
+    METRIC_TREE_NODES,
+    METRIC_NODE_MEMORY_BYTES,
+    // entries of the hash table per thousand entries of its capacity
+    METRIC_HASH_LOAD_PERMILLE,
+    NB_METRIC_GAUGES
+};
+
+// upper bounds in microseconds of the buckets of the neural network latency histogram
+#define NB_LATENCY_BUCKETS 12
+constexpr uint64_t LATENCY_BUCKETS_US[NB_LATENCY_BUCKETS] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000};
+
+// interval of the StatsD push
+#define METRICS_PUSH_INTERVAL_MS 10000
+
+/**
+ * @brief The Metrics class stores all values in relaxed atomics, so that they can be updated from every thread without locks
+ */
+class Metrics
+{
+private:
+    std::atomic<uint64_t> counters[NB_METRIC_COUNTERS];
+    std::atomic<int64_t> gauges[NB_METRIC_GAUGES];
+    // the last bucket counts the latencies above the largest bound
+    std::atomic<uint64_t> latencyBuckets[NB_LATENCY_BUCKETS + 1];
+    std::atomic<uint64_t> latencySumUS;
+
+public:
+    Metrics();
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    inline void add(MetricCounter counter, uint64_t value) {
+        counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline void set(MetricGauge gauge, int64_t value) {
+        gauges[gauge].store(value, std::memory_order_relaxed);
+    }
+
+    inline uint64_t get(MetricCounter counter) const {
+        return counters[counter].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief get_nn_latency_sum_us Returns the sum of all observed neural network latencies in microseconds
+     */
+    inline uint64_t get_nn_latency_sum_us() const {
+        return latencySumUS.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief observe_nn_latency Adds the time between launching a neural network batch and receiving its results
+     * @param latencyUS Latency in microseconds
+     */
+    void observe_nn_latency(uint64_t latencyUS);
+
+    /**
+     * @brief to_prometheus Returns all metrics in the Prometheus text exposition format
+     */
+    std::string to_prometheus() const;
+
+    /**
+     * @brief to_statsd Returns all metrics as StatsD lines, counters are reported as the difference to the given previous values
+     * @param previousCounters Counter values of the last push, will be updated
+     */
+    std::string to_statsd(uint64_t* previousCounters) const;
+};
+
+/**
+ * @brief metrics Returns the metrics which are shared by the whole process
+ */
+Metrics& metrics();
+
+/**
+ * @brief The MetricsExporter class serves the metrics over HTTP and/or pushes them over UDP in a background thread
+ */
+class MetricsExporter
+{
+private:
+    int listenFd;
+    int statsdFd;
+    std::atomic<bool> isRunning;
+    std::thread httpThread;
+    std::thread pushThread;
+
+    void serve_http();
+    void push_statsd();
+
+public:
+    /**
+     * @brief MetricsExporter
+     * @param port HTTP port of the Prometheus endpoint (0 to disable)
+     * @param statsdAddress <host>:<port> of a StatsD daemon (empty to disable)
+     */
+    MetricsExporter(int port, const std::string& statsdAddress);
+    ~MetricsExporter();
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,76 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: movelatency.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "movelatency.h"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+float MoveLatency::total_ms() const
+{
+    float totalMS = 0;
+    for (size_t idx = 0; idx < NB_LATENCY_STAGES; ++idx) {
+        totalMS += stageMS[idx];
+    }
+    return totalMS;
+}
+
+string MoveLatency::to_string() const
+{
+    stringstream ss;
+    ss << std::fixed << std::setprecision(2) << "total " << total_ms() << " ms";
+    for (size_t idx = 0; idx < NB_LATENCY_STAGES; ++idx) {
+        ss << " " << latency_stage_name(LatencyStage(idx)) << " " << stageMS[idx];
+    }
+    return ss.str();
+}
+
+const char* latency_stage_name(LatencyStage stage)
+{
+    switch (stage) {
+    case LATENCY_POSITION:
+        return "position";
+    case LATENCY_GO:
+        return "go";
+    case LATENCY_TREE_REUSE:
+        return "tree_reuse";
+    case LATENCY_GC:
+        return "gc";
+    case LATENCY_SEARCH_SETUP:
+        return "search_setup";
+    case LATENCY_SEARCH:
+        return "search";
+    case LATENCY_SEARCH_SHUTDOWN:
+        return "search_shutdown";
+    case LATENCY_EVAL_INFO:
+        return "eval_info";
+    case LATENCY_OUTPUT:
+        return "output";
+    default:
+        return "unknown";
+    }
+}
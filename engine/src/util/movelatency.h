@@ -0,0 +1,103 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: movelatency.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Breakdown of the time between the "position"/"go" commands and the "bestmove" output into the stages of a move.
+ * The stages are measured by consecutive lap() calls, so the sum of all stages is the time from receiving "go" to sending "bestmove"
+ * plus the time for handling the preceding "position" command.
+ */
+
+#ifndef MOVELATENCY_H
+#define MOVELATENCY_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+enum LatencyStage {
+    // parsing of the "position" command including the tree reuse for the opponent's move
+    LATENCY_POSITION,
+    // from receiving "go" until the agent thread has started (includes waiting for the former search)
+    LATENCY_GO,
+    // lookup of the new root node in the former tree
+    LATENCY_TREE_REUSE,
+    // waiting for the garbage collector which frees the former tree
+    LATENCY_GC,
+    // root noise, time management and the start of the search threads
+    LATENCY_SEARCH_SETUP,
+    LATENCY_SEARCH,
+    // joining the search threads and the thread manager
+    LATENCY_SEARCH_SHUTDOWN,
+    // final update_eval_info() and metrics
+    LATENCY_EVAL_INFO,
+    // info and bestmove output
+    LATENCY_OUTPUT,
+    NB_LATENCY_STAGES
+};
+
+/**
+ * @brief The MoveLatency struct accumulates the time spent in each stage of a move
+ */
+struct MoveLatency
+{
+    float stageMS[NB_LATENCY_STAGES] = {};
+    std::chrono::steady_clock::time_point lastLap;
+    // true if the move was started by a "go" command (moves of selfplay games aren't measured)
+    bool isMeasured = false;
+
+    /**
+     * @brief reset Sets all stages to 0 and starts the first lap
+     */
+    void reset() {
+        *this = MoveLatency();
+        lastLap = std::chrono::steady_clock::now();
+        isMeasured = true;
+    }
+
+    /**
+     * @brief lap Adds the time since the last lap to the given stage
+     */
+    void lap(LatencyStage stage) {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        stageMS[stage] += std::chrono::duration_cast<std::chrono::microseconds>(now - lastLap).count() / 1000.0f;
+        lastLap = now;
+    }
+
+    /**
+     * @brief total_ms Returns the sum of all stages
+     */
+    float total_ms() const;
+
+    /**
+     * @brief to_string Returns the total time and the time of each stage in milliseconds, e.g. "total 12.30 ms position 0.20 go 0.10 ..."
+     */
+    std::string to_string() const;
+};
+
+/**
+ * @brief latency_stage_name Returns a short name of the latency stage
+ */
+const char* latency_stage_name(LatencyStage stage);
+
+#endif // MOVELATENCY_H
@@ -0,0 +1,120 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: nodearena.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "nodearena.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include "largepages.h"
+
+/**
+ * @brief The ArenaChunk struct is the header at the beginning of each chunk.
+ * The live counter holds one reference for each allocation and one additional reference as long as a thread still bumps from it.
+ */
+struct ArenaChunk
+{
+    std::atomic<size_t> liveAllocations;
+    // size of the chunk including this header
+    size_t numberBytes;
+};
+
+static_assert(sizeof(ArenaChunk) <= NODE_ARENA_ALIGNMENT, "The chunk header must fit into the first aligned slot");
+
+namespace {
+inline size_t align_up(size_t numberBytes)
+{
+    return (numberBytes + NODE_ARENA_ALIGNMENT - 1) & ~size_t(NODE_ARENA_ALIGNMENT - 1);
+}
+
+ArenaChunk* new_chunk(size_t numberBytes)
+{
+    void* memory = large_page_allocate(numberBytes, NODE_ARENA_CHUNK_SIZE);
+    ArenaChunk* chunk = new (memory) ArenaChunk;
+    chunk->liveAllocations.store(1, std::memory_order_relaxed);
+    chunk->numberBytes = numberBytes;
+    return chunk;
+}
+
+void release_chunk(ArenaChunk* chunk)
+{
+    if (chunk->liveAllocations.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        const size_t numberBytes = chunk->numberBytes;
+        chunk->~ArenaChunk();
+        large_page_free(chunk, numberBytes);
+    }
+}
+
+/**
+ * @brief The ThreadArena struct holds the chunk which is currently used by a single thread.
+ */
+struct ThreadArena
+{
+    ArenaChunk* chunk = nullptr;
+    size_t offset = NODE_ARENA_CHUNK_SIZE;
+
+    ~ThreadArena() {
+        if (chunk != nullptr) {
+            release_chunk(chunk);
+        }
+    }
+
+    void* allocate(size_t alignedBytes) {
+        if (offset + alignedBytes > NODE_ARENA_CHUNK_SIZE) {
+            if (chunk != nullptr) {
+                release_chunk(chunk);
+            }
+            chunk = new_chunk(NODE_ARENA_CHUNK_SIZE);
+            offset = NODE_ARENA_ALIGNMENT;
+        }
+        void* ptr = reinterpret_cast<char*>(chunk) + offset;
+        offset += alignedBytes;
+        chunk->liveAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ptr;
+    }
+};
+
+thread_local ThreadArena threadArena;
+}
+
+void* arena_allocate(size_t numberBytes)
+{
+    const size_t alignedBytes = align_up(numberBytes == 0 ? 1 : numberBytes);
+    if (alignedBytes > NODE_ARENA_CHUNK_SIZE - NODE_ARENA_ALIGNMENT) {
+        // dedicated chunk: the returned pointer still lies within the first NODE_ARENA_CHUNK_SIZE bytes,
+        // so arena_deallocate() finds the header the same way as for regular allocations
+        ArenaChunk* chunk = new_chunk((NODE_ARENA_ALIGNMENT + alignedBytes + NODE_ARENA_CHUNK_SIZE - 1) & ~size_t(NODE_ARENA_CHUNK_SIZE - 1));
+        return reinterpret_cast<char*>(chunk) + NODE_ARENA_ALIGNMENT;
+    }
+    return threadArena.allocate(alignedBytes);
+}
+
+void arena_deallocate(void* ptr)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+    release_chunk(reinterpret_cast<ArenaChunk*>(reinterpret_cast<uintptr_t>(ptr) & ~uintptr_t(NODE_ARENA_CHUNK_SIZE - 1)));
+}
@@ -0,0 +1,91 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: nodearena.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Slab allocator for the node data of the search tree.
+ * Each thread bumps allocations from its own chunk, so all arrays of a single NodeData are placed next to each other
+ * in memory. A chunk is returned to the system in one piece after all of its allocations have been released.
+ */
+
+#ifndef NODEARENA_H
+#define NODEARENA_H
+
+#include <cstddef>
+
+// size of a single arena chunk in bytes (must be a power of two, chunks are aligned to their size)
+// it matches the huge page size, so that each chunk can be backed by a single huge page (see largepages.h)
+#define NODE_ARENA_CHUNK_SIZE (1 << 21)
+// alignment of every arena allocation in bytes (covers the SIMD alignment of blaze)
+#define NODE_ARENA_ALIGNMENT 64
+
+/**
+ * @brief arena_allocate Returns a pointer to a memory block of the given size from the chunk of the current thread.
+ * Requests which would not fit into a single chunk receive a dedicated chunk.
+ * @param numberBytes Number of bytes to allocate
+ * @return Pointer aligned to NODE_ARENA_ALIGNMENT
+ */
+void* arena_allocate(size_t numberBytes);
+
+/**
+ * @brief arena_deallocate Releases a memory block which was returned by arena_allocate().
+ * The owning chunk is freed as soon as all of its allocations have been released.
+ * This method can be called from any thread.
+ * @param ptr Pointer returned by arena_allocate()
+ */
+void arena_deallocate(void* ptr);
+
+/**
+ * @brief The ArenaAllocator class is a minimal allocator which forwards to arena_allocate() and arena_deallocate().
+ * It can be used as a custom allocator for blaze::DynamicVector and the STL containers.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator() = default;
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    T* allocate(size_t numberObjects) {
+        return static_cast<T*>(arena_allocate(numberObjects * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t) {
+        arena_deallocate(ptr);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&) {
+    return false;
+}
+
+#endif // NODEARENA_H
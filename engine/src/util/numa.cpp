@@ -0,0 +1,197 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: numa.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "numa.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+int get_numa_node_of_pci_device(const string& pciBusId)
+{
+#ifdef __linux__
+    string busId = pciBusId;
+    // sysfs uses lower case hex digits
+    transform(busId.begin(), busId.end(), busId.begin(), [](unsigned char c){ return tolower(c); });
+    ifstream file("/sys/bus/pci/devices/" + busId + "/numa_node");
+    int numaNode = NO_NUMA_NODE;
+    if (file >> numaNode && numaNode >= 0) {
+        return numaNode;
+    }
+#endif
+    return NO_NUMA_NODE;
+}
+
+vector<int> parse_cpu_list(const string& cpuList)
+{
+    vector<int> cpus;
+    stringstream stream(cpuList);
+    string range;
+    while (getline(stream, range, ',')) {
+        const size_t dashPos = range.find('-');
+        try {
+            if (dashPos == string::npos) {
+                cpus.emplace_back(stoi(range));
+            }
+            else {
+                const int first = stoi(range.substr(0, dashPos));
+                const int last = stoi(range.substr(dashPos + 1));
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    cpus.emplace_back(cpu);
+                }
+            }
+        } catch (const exception&) {
+            // skip empty and malformed entries, e.g. the trailing new line
+        }
+    }
+    return cpus;
+}
+
+vector<int> get_numa_node_cpus(int numaNode)
+{
+#ifdef __linux__
+    if (numaNode != NO_NUMA_NODE) {
+        ifstream file("/sys/devices/system/node/node" + to_string(numaNode) + "/cpulist");
+        string cpuList;
+        if (getline(file, cpuList)) {
+            return parse_cpu_list(cpuList);
+        }
+    }
+#endif
+    return vector<int>();
+}
+
+vector<int> get_available_cpus()
+{
+    vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpuSet) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &cpuSet)) {
+                cpus.emplace_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+vector<vector<int>> group_cpus_by_core(const vector<int>& cpus)
+{
+    vector<vector<int>> cores;
+    vector<int> assigned;
+    for (int cpu : cpus) {
+        if (find(assigned.begin(), assigned.end(), cpu) != assigned.end()) {
+            continue;
+        }
+        vector<int> siblings;
+#ifdef __linux__
+        ifstream file("/sys/devices/system/cpu/cpu" + to_string(cpu) + "/topology/thread_siblings_list");
+        string siblingList;
+        if (getline(file, siblingList)) {
+            for (int sibling : parse_cpu_list(siblingList)) {
+                // siblings outside of the affinity mask of the process are skipped
+                if (find(cpus.begin(), cpus.end(), sibling) != cpus.end()) {
+                    siblings.emplace_back(sibling);
+                }
+            }
+        }
+#endif
+        if (find(siblings.begin(), siblings.end(), cpu) == siblings.end()) {
+            siblings = {cpu};
+        }
+        assigned.insert(assigned.end(), siblings.begin(), siblings.end());
+        cores.emplace_back(siblings);
+    }
+    return cores;
+}
+
+void split_cores(const vector<vector<int>>& cores, size_t searchCores, vector<int>& searchCpus, vector<int>& inferenceCpus)
+{
+    searchCpus.clear();
+    inferenceCpus.clear();
+    const size_t numberSearchCores = cores.size() > 1 ? min(searchCores, cores.size() - 1) : 0;
+    for (size_t idx = 0; idx < cores.size(); ++idx) {
+        vector<int>& target = idx < numberSearchCores ? searchCpus : inferenceCpus;
+        target.insert(target.end(), cores[idx].begin(), cores[idx].end());
+    }
+}
+
+bool bind_current_thread_to_cpus(const vector<int>& cpus)
+{
+#ifdef __linux__
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    return sched_setaffinity(0, sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+    return false;
+#endif
+}
+
+bool bind_current_thread_to_numa_node(int numaNode)
+{
+    return bind_current_thread_to_cpus(get_numa_node_cpus(numaNode));
+}
+
+ScopedNumaBinding::ScopedNumaBinding(int numaNode):
+    isBound(false)
+{
+#ifdef __linux__
+    if (numaNode != NO_NUMA_NODE && sched_getaffinity(0, sizeof(cpu_set_t), &previousCpus) == 0) {
+        isBound = bind_current_thread_to_numa_node(numaNode);
+    }
+#endif
+}
+
+ScopedNumaBinding::ScopedNumaBinding(const vector<int>& cpus):
+    isBound(false)
+{
+#ifdef __linux__
+    if (!cpus.empty() && sched_getaffinity(0, sizeof(cpu_set_t), &previousCpus) == 0) {
+        isBound = bind_current_thread_to_cpus(cpus);
+    }
+#endif
+}
+
+ScopedNumaBinding::~ScopedNumaBinding()
+{
+#ifdef __linux__
+    if (isBound) {
+        sched_setaffinity(0, sizeof(cpu_set_t), &previousCpus);
+    }
+#endif
+}
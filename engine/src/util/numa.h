@@ -0,0 +1,125 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: numa.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Helper functions to place threads and their memory on the NUMA node of a GPU and to partition the cores
+ * between the search threads and the inference threads of the back-end.
+ * The topology is read from sysfs and the functions have no effect on other platforms than Linux.
+ * Memory placement relies on the first touch policy of the kernel: pages are placed on the NUMA node
+ * of the thread which writes them first.
+ */
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// describes that the NUMA node is unknown or not available
+#define NO_NUMA_NODE -1
+
+/**
+ * @brief get_numa_node_of_pci_device Returns the NUMA node to which a PCI device is attached
+ * @param pciBusId PCI bus id in the format "domain:bus:device.function", e.g. "0000:3b:00.0"
+ * @return NUMA node index or NO_NUMA_NODE
+ */
+int get_numa_node_of_pci_device(const std::string& pciBusId);
+
+/**
+ * @brief parse_cpu_list Converts a cpu list of the form "0-15,32-47" into the list of cpu indices
+ * @param cpuList Cpu list as it is used in sysfs
+ * @return Cpu indices
+ */
+std::vector<int> parse_cpu_list(const std::string& cpuList);
+
+/**
+ * @brief get_numa_node_cpus Returns all cpus which belong to the given NUMA node
+ * @param numaNode NUMA node index
+ * @return Cpu indices (empty if the node doesn't exist)
+ */
+std::vector<int> get_numa_node_cpus(int numaNode);
+
+/**
+ * @brief get_available_cpus Returns the cpus on which the process is allowed to run
+ * @return Cpu indices (empty if the affinity is unknown)
+ */
+std::vector<int> get_available_cpus();
+
+/**
+ * @brief group_cpus_by_core Groups the cpus by their physical core, so that SMT siblings are kept together
+ * @param cpus Cpu indices
+ * @return One list of cpus per physical core in the order of their first cpu
+ */
+std::vector<std::vector<int>> group_cpus_by_core(const std::vector<int>& cpus);
+
+/**
+ * @brief split_cores Assigns the first physical cores to the search threads and all remaining ones to the inference threads
+ * @param cores Cpus grouped by physical core (see group_cpus_by_core())
+ * @param searchCores Number of physical cores of the search threads (at least one core is kept for the inference)
+ * @param searchCpus Cpus of the search threads
+ * @param inferenceCpus Cpus of the inference threads
+ */
+void split_cores(const std::vector<std::vector<int>>& cores, size_t searchCores, std::vector<int>& searchCpus, std::vector<int>& inferenceCpus);
+
+/**
+ * @brief bind_current_thread_to_cpus Restricts the calling thread to the given cpus
+ * @param cpus Cpu indices (an empty list is ignored)
+ * @return True, if the affinity has been changed
+ */
+bool bind_current_thread_to_cpus(const std::vector<int>& cpus);
+
+/**
+ * @brief bind_current_thread_to_numa_node Restricts the calling thread to the cpus of the given NUMA node
+ * @param numaNode NUMA node index (NO_NUMA_NODE is ignored)
+ * @return True, if the affinity has been changed
+ */
+bool bind_current_thread_to_numa_node(int numaNode);
+
+/**
+ * @brief The ScopedNumaBinding class binds the calling thread to a NUMA node for its life time and restores the previous affinity afterwards.
+ * It is used to allocate (and first touch) memory on the NUMA node of a thread which runs elsewhere later on.
+ */
+class ScopedNumaBinding
+{
+private:
+    bool isBound;
+#ifdef __linux__
+    cpu_set_t previousCpus;
+#endif
+public:
+    ScopedNumaBinding(int numaNode);
+    /**
+     * @brief ScopedNumaBinding Binds the calling thread to the given cpus instead of a whole NUMA node.
+     * Threads which are created meanwhile (e.g. the thread pools of a back-end) inherit this affinity.
+     */
+    ScopedNumaBinding(const std::vector<int>& cpus);
+    ~ScopedNumaBinding();
+    ScopedNumaBinding(const ScopedNumaBinding&) = delete;
+    ScopedNumaBinding& operator=(const ScopedNumaBinding&) = delete;
+};
+
+#endif // NUMA_H
@@ -0,0 +1,84 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: perft.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "perft.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+uint64_t PerftResult::nps() const
+{
+    return elapsedTimeMS == 0 ? nodes * 1000 : nodes * 1000 / elapsedTimeMS;
+}
+
+uint64_t perft(StateObj* state, size_t depth)
+{
+    const std::vector<Action> actions = state->legal_actions();
+    if (depth <= 1) {
+        return depth == 0 ? 1 : actions.size();
+    }
+    uint64_t nodes = 0;
+    for (Action action : actions) {
+        state->do_action(action);
+        nodes += perft(state, depth - 1);
+        state->undo_action(action);
+    }
+    return nodes;
+}
+
+PerftResult run_perft(const StateObj* state, size_t depth, size_t threads)
+{
+    PerftResult result;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::unique_ptr<StateObj> rootState = std::unique_ptr<StateObj>(state->clone());
+    result.rootActions = rootState->legal_actions();
+    result.rootNodes.resize(result.rootActions.size(), 0);
+
+    // the root moves are taken one by one, so that threads which finish early pick up the remaining moves
+    std::atomic<size_t> nextActionIdx(0);
+    auto count_root_moves = [&]() {
+        std::unique_ptr<StateObj> threadState = std::unique_ptr<StateObj>(state->clone());
+        for (size_t idx = nextActionIdx++; idx < result.rootActions.size(); idx = nextActionIdx++) {
+            threadState->do_action(result.rootActions[idx]);
+            result.rootNodes[idx] = perft(threadState.get(), depth - 1);
+            threadState->undo_action(result.rootActions[idx]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t idx = 1; idx < threads; ++idx) {
+        workers.emplace_back(count_root_moves);
+    }
+    count_root_moves();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    for (uint64_t nodes : result.rootNodes) {
+        result.nodes += nodes;
+    }
+    result.elapsedTimeMS = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
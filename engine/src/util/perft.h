@@ -0,0 +1,71 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: perft.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Generic perft (performance test) over the State interface which counts the leaf nodes of the move tree.
+ * It measures the raw speed of the move generation of an environment and verifies it against known node counts.
+ */
+
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <cstdint>
+#include <vector>
+#include "stateobj.h"
+
+/**
+ * @brief The PerftResult struct holds the node count of each root move and the measured speed
+ */
+struct PerftResult {
+    std::vector<Action> rootActions;
+    std::vector<uint64_t> rootNodes;
+    uint64_t nodes = 0;
+    size_t elapsedTimeMS = 0;
+
+    /**
+     * @brief nps Returns the counted leaf nodes per second
+     */
+    uint64_t nps() const;
+};
+
+/**
+ * @brief perft Counts the leaf nodes of the move tree of the given depth by applying and reverting the moves.
+ * The leaves are counted by the size of the move list (bulk counting).
+ * @param state State which is restored before returning
+ * @param depth Depth in plies
+ * @return Number of leaf nodes
+ */
+uint64_t perft(StateObj* state, size_t depth);
+
+/**
+ * @brief run_perft Runs perft for each root move, the root moves are distributed over the given number of threads
+ * which work on their own copy of the state.
+ * @param state Root state
+ * @param depth Depth in plies (at least 1)
+ * @param threads Number of threads
+ * @return Node counts of each root move and the speed
+ */
+PerftResult run_perft(const StateObj* state, size_t depth, size_t threads);
+
+#endif // PERFT_H
@@ -0,0 +1,74 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: phasetimers.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "phasetimers.h"
+#include <iomanip>
+#include <sstream>
+#include "communication.h"
+
+const char* phase_name(SearchPhase phase)
+{
+    switch (phase) {
+    case PHASE_SELECTION:
+        return "selection";
+    case PHASE_STATE_CLONE:
+        return "state_clone";
+    case PHASE_DO_ACTION:
+        return "do_action";
+    case PHASE_STATE_PLANES:
+        return "state_planes";
+    case PHASE_PREDICT:
+        return "predict";
+    case PHASE_SET_NN_RESULTS:
+        return "set_nn_results";
+    case PHASE_BACKUP_VALUES:
+        return "backup_values";
+    case PHASE_BACKUP_COLLISIONS:
+        return "backup_collisions";
+    default:
+        return "unknown";
+    }
+}
+
+void print_phase_timers(const PhaseTimers& timers)
+{
+    uint64_t totalNanoseconds = 0;
+    for (size_t idx = 0; idx < NB_SEARCH_PHASES; ++idx) {
+        // the state phases are part of the selection
+        if (idx != PHASE_STATE_CLONE && idx != PHASE_DO_ACTION && idx != PHASE_STATE_PLANES) {
+            totalNanoseconds += timers.nanoseconds[idx];
+        }
+    }
+    info_string("phase | total ms | calls | avg us | share (summed over all search threads)");
+    for (size_t idx = 0; idx < NB_SEARCH_PHASES; ++idx) {
+        const double totalMS = timers.nanoseconds[idx] / 1e6;
+        const double avgUS = timers.calls[idx] == 0 ? 0 : timers.nanoseconds[idx] / 1e3 / timers.calls[idx];
+        const double share = totalNanoseconds == 0 ? 0 : 100.0 * timers.nanoseconds[idx] / totalNanoseconds;
+        stringstream ss;
+        ss << std::fixed << std::setprecision(2) << totalMS << " ms | " << timers.calls[idx] << " | " << avgUS << " us | " << share << "%";
+        info_string(phase_name(SearchPhase(idx)), ss.str());
+    }
+}
@@ -0,0 +1,109 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: phasetimers.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Lightweight timers for the main phases of a search thread iteration.
+ * The timers are only compiled in when building with MCTS_PHASE_TIMERS, otherwise PHASE_TIMER() expands to nothing.
+ * Every search thread owns its own PhaseTimers object, so no synchronization is needed while searching.
+ */
+
+#ifndef PHASETIMERS_H
+#define PHASETIMERS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+enum SearchPhase {
+    // traversal of the tree in get_new_child_to_evaluate() (includes the nested state phases)
+    PHASE_SELECTION,
+    PHASE_STATE_CLONE,
+    PHASE_DO_ACTION,
+    PHASE_STATE_PLANES,
+    // time spent for launching and waiting for the neural network inference
+    PHASE_PREDICT,
+    PHASE_SET_NN_RESULTS,
+    PHASE_BACKUP_VALUES,
+    PHASE_BACKUP_COLLISIONS,
+    NB_SEARCH_PHASES
+};
+
+/**
+ * @brief The PhaseTimers struct accumulates the elapsed time and the number of calls of each search phase
+ */
+struct PhaseTimers
+{
+    uint64_t nanoseconds[NB_SEARCH_PHASES] = {};
+    uint64_t calls[NB_SEARCH_PHASES] = {};
+
+    void reset() {
+        *this = PhaseTimers();
+    }
+
+    void add(const PhaseTimers& other) {
+        for (size_t idx = 0; idx < NB_SEARCH_PHASES; ++idx) {
+            nanoseconds[idx] += other.nanoseconds[idx];
+            calls[idx] += other.calls[idx];
+        }
+    }
+};
+
+/**
+ * @brief The ScopedPhaseTimer class adds the life time of the object to the given phase
+ */
+class ScopedPhaseTimer
+{
+private:
+    PhaseTimers& timers;
+    const SearchPhase phase;
+    const std::chrono::steady_clock::time_point start;
+public:
+    ScopedPhaseTimer(PhaseTimers& timers, SearchPhase phase):
+        timers(timers), phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~ScopedPhaseTimer() {
+        timers.nanoseconds[phase] += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        ++timers.calls[phase];
+    }
+};
+
+#ifdef MCTS_PHASE_TIMERS
+#define PHASE_TIMER_CONCAT_(a, b) a##b
+#define PHASE_TIMER_CONCAT(a, b) PHASE_TIMER_CONCAT_(a, b)
+#define PHASE_TIMER(timers, phase) ScopedPhaseTimer PHASE_TIMER_CONCAT(phaseTimer, __LINE__)(timers, phase)
+#else
+#define PHASE_TIMER(timers, phase)
+#endif
+
+/**
+ * @brief phase_name Returns a short name of the search phase
+ */
+const char* phase_name(SearchPhase phase);
+
+/**
+ * @brief print_phase_timers Prints the total time, the number of calls and the average time of each phase as info strings
+ * @param timers Accumulated timers
+ */
+void print_phase_timers(const PhaseTimers& timers);
+
+#endif // PHASETIMERS_H
@@ -0,0 +1,73 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: policyindextable.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Direct look-up table from an encoded move to its neural network policy index.
+ * The table is shared by the chess and the fairy environments and replaces the former Action and hash map based look-ups.
+ */
+
+#ifndef POLICYINDEXTABLE_H
+#define POLICYINDEXTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// number of entries of a policy index table, covers every move which is encoded in 16 bits
+#define POLICY_INDEX_TABLE_SIZE (1 << 16)
+// alignment of a policy index table in bytes (cache line size)
+#define POLICY_INDEX_TABLE_ALIGNMENT 64
+
+/**
+ * @brief The PolicyIndexTable struct stores the policy index of every move as a 16 bit value.
+ * Compared to the former 32 bit entries the moves of a single origin square share half as many cache lines.
+ * Moves without a policy entry are mapped to index 0.
+ */
+struct alignas(POLICY_INDEX_TABLE_ALIGNMENT) PolicyIndexTable
+{
+    uint16_t indices[POLICY_INDEX_TABLE_SIZE];
+
+    uint16_t operator[](size_t move) const {
+        return indices[move];
+    }
+
+    uint16_t& operator[](size_t move) {
+        return indices[move];
+    }
+
+    /**
+     * @brief get Returns the policy index and 0 for moves which are out of the range of the table
+     * @param move Encoded move
+     * @return Policy index
+     */
+    uint16_t get(int64_t move) const {
+        if (move < 0 || move >= POLICY_INDEX_TABLE_SIZE) {
+            return 0;
+        }
+        return indices[move];
+    }
+};
+
+static_assert(sizeof(PolicyIndexTable) == POLICY_INDEX_TABLE_SIZE * sizeof(uint16_t), "The policy index table must not contain padding");
+
+#endif // POLICYINDEXTABLE_H
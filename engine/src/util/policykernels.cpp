@@ -0,0 +1,300 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: policykernels.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "policykernels.h"
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define POLICY_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// (scaled input, output, size, factor, applyLog) -> maximum of the written values
+using ScaleKernel = float (*)(const float*, float*, size_t, float, bool);
+// (data, size, offset) -> sum of the written values
+using ExpKernel = float (*)(float*, size_t, float);
+
+namespace {
+// Cephes coefficients of expf() and logf()
+const float EXP_UPPER_BOUND = 88.3762626647949f;
+const float EXP_LOWER_BOUND = -87.3365447504019f;
+const float LOG2E = 1.44269504088896341f;
+const float LN2_HI = 0.693359375f;
+const float LN2_LO = -2.12194440e-4f;
+const float EXP_P[6] = {1.9875691500E-4f, 1.3981999507E-3f, 8.3334519073E-3f, 4.1665795894E-2f, 1.6666665459E-1f, 5.0000001201E-1f};
+const float SQRT_HALF = 0.707106781186547524f;
+const float LOG_P[9] = {7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f, -1.2420140846E-1f, 1.4249322787E-1f,
+                        -1.6668057665E-1f, 2.0000714765E-1f, -2.4999993993E-1f, 3.3333331174E-1f};
+
+inline float fast_exp(float x)
+{
+    if (x < EXP_LOWER_BOUND) {
+        return 0.0f;
+    }
+    if (x > EXP_UPPER_BOUND) {
+        x = EXP_UPPER_BOUND;
+    }
+    const float n = float(int32_t(x * LOG2E + (x < 0 ? -0.5f : 0.5f)));
+    const float r = x - n * LN2_HI - n * LN2_LO;
+    float y = EXP_P[0];
+    for (size_t idx = 1; idx < 6; ++idx) {
+        y = y * r + EXP_P[idx];
+    }
+    y = y * r * r + r + 1.0f;
+    const int32_t bits = (int32_t(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(float));
+    return y * scale;
+}
+
+inline float fast_log(float x)
+{
+    if (x <= 0.0f) {
+        return -std::numeric_limits<float>::infinity();
+    }
+    int32_t bits;
+    std::memcpy(&bits, &x, sizeof(float));
+    float e = float(((bits >> 23) & 0xFF) - 126);
+    // mantissa in [0.5, 1)
+    bits = (bits & 0x807FFFFF) | 0x3F000000;
+    float m;
+    std::memcpy(&m, &bits, sizeof(float));
+    if (m < SQRT_HALF) {
+        e -= 1.0f;
+        m = m + m - 1.0f;
+    }
+    else {
+        m = m - 1.0f;
+    }
+    const float z = m * m;
+    float y = LOG_P[0];
+    for (size_t idx = 1; idx < 9; ++idx) {
+        y = y * m + LOG_P[idx];
+    }
+    y = y * m * z;
+    y += LN2_LO * e;
+    y -= 0.5f * z;
+    return m + y + LN2_HI * e;
+}
+
+float scale_max_scalar(const float* input, float* output, size_t size, float factor, bool applyLog)
+{
+    float maximum = -std::numeric_limits<float>::infinity();
+    for (size_t idx = 0; idx < size; ++idx) {
+        output[idx] = (applyLog ? fast_log(input[idx]) : input[idx]) * factor;
+        if (output[idx] > maximum) {
+            maximum = output[idx];
+        }
+    }
+    return maximum;
+}
+
+float exp_sum_scalar(float* data, size_t size, float offset)
+{
+    float sum = 0.0f;
+    for (size_t idx = 0; idx < size; ++idx) {
+        data[idx] = fast_exp(data[idx] - offset);
+        sum += data[idx];
+    }
+    return sum;
+}
+
+#ifdef POLICY_X86_DISPATCH
+__attribute__((target("avx2,fma")))
+inline __m256 exp_avx2(__m256 x)
+{
+    const __m256 underflow = _mm256_cmp_ps(x, _mm256_set1_ps(EXP_LOWER_BOUND), _CMP_LT_OQ);
+    x = _mm256_min_ps(x, _mm256_set1_ps(EXP_UPPER_BOUND));
+    x = _mm256_max_ps(x, _mm256_set1_ps(EXP_LOWER_BOUND));
+    const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_HI), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_LO), r);
+    __m256 y = _mm256_set1_ps(EXP_P[0]);
+    for (size_t idx = 1; idx < 6; ++idx) {
+        y = _mm256_fmadd_ps(y, r, _mm256_set1_ps(EXP_P[idx]));
+    }
+    y = _mm256_fmadd_ps(y, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+    const __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_andnot_ps(underflow, _mm256_mul_ps(y, _mm256_castsi256_ps(bits)));
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256 log_avx2(__m256 x)
+{
+    const __m256 invalid = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OQ);
+    const __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x807FFFFF)), _mm256_set1_epi32(0x3F000000)));
+    const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(small, _mm256_set1_ps(1.0f)));
+    m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), _mm256_set1_ps(1.0f));
+    const __m256 z = _mm256_mul_ps(m, m);
+    __m256 y = _mm256_set1_ps(LOG_P[0]);
+    for (size_t idx = 1; idx < 9; ++idx) {
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(LOG_P[idx]));
+    }
+    y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+    y = _mm256_fmadd_ps(e, _mm256_set1_ps(LN2_LO), y);
+    y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+    const __m256 result = _mm256_fmadd_ps(e, _mm256_set1_ps(LN2_HI), _mm256_add_ps(m, y));
+    return _mm256_blendv_ps(result, _mm256_set1_ps(-std::numeric_limits<float>::infinity()), invalid);
+}
+
+inline float horizontal_max(const float* laneValues, float maximum)
+{
+    for (size_t lane = 0; lane < 8; ++lane) {
+        if (laneValues[lane] > maximum) {
+            maximum = laneValues[lane];
+        }
+    }
+    return maximum;
+}
+
+__attribute__((target("avx2,fma")))
+float scale_max_avx2(const float* input, float* output, size_t size, float factor, bool applyLog)
+{
+    const __m256 factorVec = _mm256_set1_ps(factor);
+    __m256 maxVec = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        __m256 values = _mm256_loadu_ps(input + idx);
+        if (applyLog) {
+            values = log_avx2(values);
+        }
+        values = _mm256_mul_ps(values, factorVec);
+        _mm256_storeu_ps(output + idx, values);
+        maxVec = _mm256_max_ps(maxVec, values);
+    }
+    alignas(32) float laneValues[8];
+    _mm256_store_ps(laneValues, maxVec);
+    const float maximum = horizontal_max(laneValues, -std::numeric_limits<float>::infinity());
+    const float tailMaximum = scale_max_scalar(input + idx, output + idx, size - idx, factor, applyLog);
+    return tailMaximum > maximum ? tailMaximum : maximum;
+}
+
+__attribute__((target("avx2,fma")))
+float exp_sum_avx2(float* data, size_t size, float offset)
+{
+    const __m256 offsetVec = _mm256_set1_ps(offset);
+    __m256 sumVec = _mm256_setzero_ps();
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        const __m256 values = exp_avx2(_mm256_sub_ps(_mm256_loadu_ps(data + idx), offsetVec));
+        _mm256_storeu_ps(data + idx, values);
+        sumVec = _mm256_add_ps(sumVec, values);
+    }
+    alignas(32) float laneValues[8];
+    _mm256_store_ps(laneValues, sumVec);
+    float sum = 0.0f;
+    for (size_t lane = 0; lane < 8; ++lane) {
+        sum += laneValues[lane];
+    }
+    return sum + exp_sum_scalar(data + idx, size - idx, offset);
+}
+#endif
+
+struct KernelChoice {
+    ScaleKernel scaleMax;
+    ExpKernel expSum;
+    const char* name;
+};
+
+KernelChoice detect_kernel()
+{
+#ifdef POLICY_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return {scale_max_avx2, exp_sum_avx2, "avx2"};
+    }
+#endif
+    return {scale_max_scalar, exp_sum_scalar, "scalar"};
+}
+
+const KernelChoice& get_kernel()
+{
+    static const KernelChoice kernelChoice = detect_kernel();
+    return kernelChoice;
+}
+
+void normalize(float* data, size_t size, float sum)
+{
+    const float factor = 1.0f / sum;
+    for (size_t idx = 0; idx < size; ++idx) {
+        data[idx] *= factor;
+    }
+}
+
+inline void exp_normalize(const KernelChoice& kernel, const float* input, float* output, size_t size, float factor, bool applyLog)
+{
+    // the maximum is subtracted before the exponentiation to avoid an overflow
+    const float maximum = kernel.scaleMax(input, output, size, factor, applyLog);
+    normalize(output, size, kernel.expSum(output, size, maximum));
+}
+
+inline void copy_if_needed(const float* input, float* output, size_t size)
+{
+    if (input != output) {
+        std::memmove(output, input, size * sizeof(float));
+    }
+}
+
+const KernelChoice SCALAR_KERNEL = {scale_max_scalar, exp_sum_scalar, "scalar"};
+}
+
+void softmax_policy(const float* input, float* output, size_t size, float temperature)
+{
+    exp_normalize(get_kernel(), input, output, size, 1.0f / temperature, false);
+}
+
+void temperature_policy(const float* input, float* output, size_t size, float temperature)
+{
+    if (temperature == 1) {
+        copy_if_needed(input, output, size);
+        return;
+    }
+    exp_normalize(get_kernel(), input, output, size, 1.0f / temperature, true);
+}
+
+void softmax_policy_scalar(const float* input, float* output, size_t size, float temperature)
+{
+    exp_normalize(SCALAR_KERNEL, input, output, size, 1.0f / temperature, false);
+}
+
+void temperature_policy_scalar(const float* input, float* output, size_t size, float temperature)
+{
+    if (temperature == 1) {
+        copy_if_needed(input, output, size);
+        return;
+    }
+    exp_normalize(SCALAR_KERNEL, input, output, size, 1.0f / temperature, true);
+}
+
+const char* policy_kernel_name()
+{
+    return get_kernel().name;
+}
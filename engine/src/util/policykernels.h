@@ -0,0 +1,72 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: policykernels.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Allocation free softmax and temperature kernels for the policy post-processing of the mini-batch.
+ * Both use a polynomial exp/log approximation (relative error < 1e-6) instead of std::exp() and std::pow().
+ * The AVX2 kernel is chosen at runtime based on the CPU features, all other platforms use the scalar version.
+ */
+
+#ifndef POLICYKERNELS_H
+#define POLICYKERNELS_H
+
+#include <cstddef>
+
+/**
+ * @brief softmax_policy Computes the softmax of input / temperature and writes the result into output
+ * @param input Logits
+ * @param output Output probabilities (may be the same array as input)
+ * @param size Number of entries
+ * @param temperature Temperature which is applied to the logits
+ */
+void softmax_policy(const float* input, float* output, size_t size, float temperature = 1.0f);
+
+/**
+ * @brief temperature_policy Applies temperature rescaling p^(1/temperature) on a distribution and re-normalizes it.
+ * The computation is done in log-space, so very low temperatures don't underflow to a zero sum.
+ * Entries which are 0 stay 0.
+ * @param input Distribution with non-negative entries of which at least one is > 0
+ * @param output Rescaled distribution (may be the same array as input)
+ * @param size Number of entries
+ * @param temperature Temperature value
+ */
+void temperature_policy(const float* input, float* output, size_t size, float temperature);
+
+/**
+ * @brief softmax_policy_scalar Scalar reference implementation of softmax_policy()
+ */
+void softmax_policy_scalar(const float* input, float* output, size_t size, float temperature = 1.0f);
+
+/**
+ * @brief temperature_policy_scalar Scalar reference implementation of temperature_policy()
+ */
+void temperature_policy_scalar(const float* input, float* output, size_t size, float temperature);
+
+/**
+ * @brief policy_kernel_name Returns the name of the kernel which has been selected for the current CPU
+ * @return "avx2" or "scalar"
+ */
+const char* policy_kernel_name();
+
+#endif // POLICYKERNELS_H
@@ -0,0 +1,266 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: positionanalysis.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "positionanalysis.h"
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include "communication.h"
+
+namespace {
+std::string escape_json(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool is_game_result(const std::string& token)
+{
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+/**
+ * @brief normalize_san Removes the check, mate and annotation symbols and the promotion sign and uses the letter O for castling
+ */
+std::string normalize_san(const std::string& san)
+{
+    std::string normalized;
+    for (char c : san) {
+        if (c == '+' || c == '#' || c == '!' || c == '?' || c == '=') {
+            continue;
+        }
+        normalized += c;
+    }
+    if (normalized == "0-0" || normalized == "0-0-0") {
+        std::replace(normalized.begin(), normalized.end(), '0', 'O');
+    }
+    return normalized;
+}
+
+/**
+ * @brief find_action Returns the legal action which matches the given SAN (or uci) move or ACTION_NONE
+ */
+Action find_action(const StateObj* state, const std::string& move)
+{
+    const std::vector<Action> legalActions = state->legal_actions();
+    const std::string target = normalize_san(move);
+    for (Action action : legalActions) {
+        if (normalize_san(state->action_to_san(action, legalActions)) == target) {
+            return action;
+        }
+    }
+    // some tools write the moves in uci notation
+    for (Action action : legalActions) {
+        if (StateConstants::action_to_uci(action, state->is_chess960()) == move) {
+            return action;
+        }
+    }
+    return ACTION_NONE;
+}
+
+/**
+ * @brief strip_move_text Removes comments, variations and NAGs from the move text of a game
+ */
+std::string strip_move_text(const std::string& moveText)
+{
+    std::string stripped;
+    size_t variationDepth = 0;
+    bool isComment = false;
+    for (char c : moveText) {
+        if (isComment) {
+            isComment = c != '}';
+            continue;
+        }
+        if (c == '{') {
+            isComment = true;
+        }
+        else if (c == '(') {
+            ++variationDepth;
+        }
+        else if (c == ')') {
+            if (variationDepth != 0) {
+                --variationDepth;
+            }
+        }
+        else if (variationDepth == 0) {
+            stripped += c;
+        }
+    }
+    return stripped;
+}
+
+void add_game_positions(const std::string& fen, const std::string& moveText, size_t gameIdx, int variant, bool is960,
+                        std::vector<AnalysisPosition>& positions)
+{
+    std::unique_ptr<StateObj> state = std::make_unique<StateObj>();
+    state->set(fen.empty() ? StateConstants::start_fen(variant) : fen, is960, variant);
+    std::istringstream is(strip_move_text(moveText));
+    std::string token;
+    size_t ply = 0;
+    while (is >> token) {
+        if (is_game_result(token)) {
+            break;
+        }
+        // move numbers ("12." or "12...") may be attached to the move
+        const size_t moveStart = token.find_first_not_of("0123456789.");
+        if (moveStart == std::string::npos || token[0] == '$') {
+            continue;
+        }
+        if (moveStart != 0 && token.find('.') != std::string::npos) {
+            token = token.substr(moveStart);
+        }
+        const Action action = find_action(state.get(), token);
+        if (action == ACTION_NONE) {
+            info_string("skipped the remaining moves of game", gameIdx, "at the illegal move " + token);
+            return;
+        }
+        positions.push_back({std::to_string(gameIdx) + ":" + std::to_string(ply), state->fen(),
+                             StateConstants::action_to_uci(action, state->is_chess960())});
+        state->do_action(action);
+        ++ply;
+    }
+}
+}
+
+std::vector<AnalysisPosition> read_epd_positions(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::invalid_argument("The analysis file " + filename + " couldn't be opened.");
+    }
+    std::vector<AnalysisPosition> positions;
+    std::string line;
+    size_t lineIdx = 0;
+    while (std::getline(file, line)) {
+        ++lineIdx;
+        std::istringstream is(line);
+        std::string fen, token;
+        // board, side to move, castling rights and en-passant square
+        for (size_t idx = 0; idx < 4 && is >> token; ++idx) {
+            fen += (idx == 0 ? "" : " ") + token;
+        }
+        if (fen.empty() || fen[0] == '#') {
+            continue;
+        }
+        std::string halfMoveClock = "0";
+        std::string fullMoveNumber = "1";
+        // full FEN lines contain the move counters instead of operations
+        for (size_t fieldIdx = 0; fieldIdx < 2 && is >> token && token.find_first_not_of("0123456789") == std::string::npos; ++fieldIdx) {
+            (fieldIdx == 0 ? halfMoveClock : fullMoveNumber) = token;
+        }
+        std::string id = std::to_string(lineIdx);
+        const size_t idPos = line.find("id \"");
+        if (idPos != std::string::npos) {
+            const size_t idEnd = line.find('"', idPos + 4);
+            id = line.substr(idPos + 4, idEnd == std::string::npos ? std::string::npos : idEnd - idPos - 4);
+        }
+        positions.push_back({id, fen + " " + halfMoveClock + " " + fullMoveNumber, ""});
+    }
+    return positions;
+}
+
+std::vector<AnalysisPosition> read_pgn_positions(const std::string& filename, int variant, bool is960)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::invalid_argument("The analysis file " + filename + " couldn't be opened.");
+    }
+    std::vector<AnalysisPosition> positions;
+    std::string line, fen, moveText;
+    size_t gameIdx = 0;
+    while (std::getline(file, line)) {
+        const size_t textStart = line.find_first_not_of(" \t\r");
+        if (textStart == std::string::npos) {
+            continue;
+        }
+        if (line[textStart] == '[') {
+            if (!moveText.empty()) {
+                // the tag section of the next game begins
+                add_game_positions(fen, moveText, ++gameIdx, variant, is960, positions);
+                fen.clear();
+                moveText.clear();
+            }
+            if (line.compare(textStart, 6, "[FEN \"") == 0) {
+                const size_t fenEnd = line.find('"', textStart + 6);
+                fen = line.substr(textStart + 6, fenEnd == std::string::npos ? std::string::npos : fenEnd - textStart - 6);
+            }
+            continue;
+        }
+        // the rest of a line after ';' is a comment
+        moveText += line.substr(0, line.find(';')) + " ";
+    }
+    if (!moveText.empty()) {
+        add_game_positions(fen, moveText, ++gameIdx, variant, is960, positions);
+    }
+    return positions;
+}
+
+std::vector<AnalysisPosition> read_analysis_positions(const std::string& filename, int variant, bool is960)
+{
+    const std::string pgnSuffix = ".pgn";
+    if (filename.size() >= pgnSuffix.size() && filename.compare(filename.size() - pgnSuffix.size(), pgnSuffix.size(), pgnSuffix) == 0) {
+        return read_pgn_positions(filename, variant, is960);
+    }
+    return read_epd_positions(filename);
+}
+
+void write_analysis_json(std::ostream& os, const AnalysisPosition& position, const EvalInfo& evalInfo, size_t elapsedTimeMS)
+{
+    std::ostringstream line;
+    line << "{\"id\": \"" << escape_json(position.id) << "\", \"fen\": \"" << escape_json(position.fen) << "\"";
+    if (!position.playedMove.empty()) {
+        line << ", \"played\": \"" << position.playedMove << "\"";
+    }
+    const bool hasMove = !evalInfo.pv.empty() && !evalInfo.pv[0].empty();
+    if (hasMove) {
+        line << ", \"bestmove\": \"" << StateConstants::action_to_uci(evalInfo.pv[0][0], evalInfo.isChess960) << "\"";
+    }
+    if (!evalInfo.centipawns.empty()) {
+        line << ", \"cp\": " << evalInfo.centipawns[0];
+    }
+    if (!evalInfo.movesToMate.empty() && evalInfo.movesToMate[0] != 0) {
+        line << ", \"mate\": " << evalInfo.movesToMate[0];
+    }
+    if (!evalInfo.bestMoveQ.empty()) {
+        line << ", \"q\": " << evalInfo.bestMoveQ[0];
+    }
+    line << ", \"nodes\": " << evalInfo.nodes << ", \"depth\": " << evalInfo.depth << ", \"time_ms\": " << elapsedTimeMS << ", \"pv\": [";
+    if (hasMove) {
+        for (size_t idx = 0; idx < evalInfo.pv[0].size(); ++idx) {
+            line << (idx == 0 ? "" : ", ") << "\"" << StateConstants::action_to_uci(evalInfo.pv[0][idx], evalInfo.isChess960) << "\"";
+        }
+    }
+    line << "]}\n";
+    // a single write keeps the lines of concurrent workers intact
+    os << line.str() << std::flush;
+}
@@ -0,0 +1,82 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: positionanalysis.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Input and output of the "analyse" command which evaluates all positions of an EPD or PGN corpus.
+ * Every result is written as a single JSON line, so that the output can be streamed into other tools.
+ */
+
+#ifndef POSITIONANALYSIS_H
+#define POSITIONANALYSIS_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "evalinfo.h"
+#include "stateobj.h"
+
+/**
+ * @brief The AnalysisPosition struct describes a single position of the corpus
+ */
+struct AnalysisPosition {
+    // "id" operation of an EPD line or its line number, "<game>:<ply>" for PGN games
+    std::string id;
+    std::string fen;
+    // move of the game in uci notation which has been played in this position (only for PGN games)
+    std::string playedMove;
+};
+
+/**
+ * @brief read_epd_positions Reads all positions of an EPD file. Each line starts with the first four FEN fields,
+ * which are optionally followed by the move counters and the EPD operations.
+ * @param filename EPD file
+ * @return Positions in file order
+ */
+std::vector<AnalysisPosition> read_epd_positions(const std::string& filename);
+
+/**
+ * @brief read_pgn_positions Replays all games of a PGN file and returns the position before each move.
+ * The moves are given in SAN and are matched against the SAN of the legal moves, comments, variations and NAGs are skipped.
+ * A game is cut off at the first move which can't be parsed.
+ * @param filename PGN file
+ * @param variant Variant of the games (the "FEN" tag sets a custom starting position)
+ * @param is960 True for Chess960 castling
+ * @return Positions in game order
+ */
+std::vector<AnalysisPosition> read_pgn_positions(const std::string& filename, int variant, bool is960);
+
+/**
+ * @brief read_analysis_positions Reads a PGN file if the file name ends with ".pgn" and an EPD file otherwise
+ */
+std::vector<AnalysisPosition> read_analysis_positions(const std::string& filename, int variant, bool is960);
+
+/**
+ * @brief write_analysis_json Writes the evaluation of a position as a single JSON line
+ * @param os Output stream
+ * @param position Analysed position
+ * @param evalInfo Evaluation of the position
+ * @param elapsedTimeMS Time which has been spent on the position
+ */
+void write_analysis_json(std::ostream& os, const AnalysisPosition& position, const EvalInfo& evalInfo, size_t elapsedTimeMS);
+
+#endif // POSITIONANALYSIS_H
@@ -0,0 +1,69 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: prefetch.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Software prefetching of the tree data which is read by the next step of the selection.
+ * The prefetches are only emitted when building with MCTS_PREFETCH, otherwise PREFETCH() expands to nothing.
+ */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// maximum number of cache lines which are prefetched for a single array
+#define PREFETCH_MAX_LINES 4
+#define PREFETCH_LINE_SIZE 64
+
+#ifdef MCTS_PREFETCH
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(address) __builtin_prefetch(static_cast<const void*>(address))
+#elif defined(_MSC_VER)
+#include <xmmintrin.h>
+#define PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#endif
+#endif
+
+#ifndef PREFETCH
+#define PREFETCH(address)
+#endif
+
+/**
+ * @brief prefetch_range Prefetches the cache lines of the given memory range up to PREFETCH_MAX_LINES
+ * @param address Start of the range
+ * @param numberBytes Size of the range
+ */
+inline void prefetch_range(const void* address, size_t numberBytes)
+{
+#ifdef MCTS_PREFETCH
+    const char* line = static_cast<const char*>(address);
+    const char* end = line + numberBytes;
+    for (size_t idx = 0; idx < PREFETCH_MAX_LINES && line < end; ++idx, line += PREFETCH_LINE_SIZE) {
+        PREFETCH(line);
+    }
+#endif
+}
+
+#endif // PREFETCH_H
@@ -0,0 +1,216 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: puctselection.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "puctselection.h"
+#include <cstdint>
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PUCT_X86_DISPATCH
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define PUCT_NEON
+#include <arm_neon.h>
+#endif
+
+using SelectionKernel = size_t (*)(const float*, const float*, const uint32_t*, size_t, float);
+
+namespace {
+inline float q_plus_u(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t idx, float uFactor)
+{
+    // same operation order as in the vectorized kernels to get identical results, the visits are converted to float first
+    return qValues[idx] + (uFactor * policyProbs[idx]) / (float(childNumberVisits[idx]) + 1.0f);
+}
+
+/**
+ * @brief reduce_lanes Picks the best lane result, the lowest index wins for equal values
+ */
+inline void reduce_lanes(const float* laneValues, const int32_t* laneIndices, size_t numberLanes, float& bestValue, size_t& bestIdx)
+{
+    for (size_t lane = 0; lane < numberLanes; ++lane) {
+        if (laneValues[lane] > bestValue || (laneValues[lane] == bestValue && size_t(laneIndices[lane]) < bestIdx)) {
+            bestValue = laneValues[lane];
+            bestIdx = laneIndices[lane];
+        }
+    }
+}
+
+/**
+ * @brief argmax_tail Continues the scalar search from startIdx on
+ */
+inline size_t argmax_tail(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t startIdx, size_t numberChildren, float uFactor,
+                          float bestValue, size_t bestIdx)
+{
+    for (size_t idx = startIdx; idx < numberChildren; ++idx) {
+        const float value = q_plus_u(qValues, policyProbs, childNumberVisits, idx, uFactor);
+        if (value > bestValue) {
+            bestValue = value;
+            bestIdx = idx;
+        }
+    }
+    return bestIdx;
+}
+
+#ifdef PUCT_X86_DISPATCH
+__attribute__((target("avx2")))
+size_t argmax_q_plus_u_avx2(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t numberChildren, float uFactor)
+{
+    const __m256 uFactorVec = _mm256_set1_ps(uFactor);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256 bestValues = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    __m256i bestIndices = _mm256_setzero_si256();
+    __m256i curIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    size_t idx = 0;
+    for (; idx + 8 <= numberChildren; idx += 8) {
+        const __m256 u = _mm256_div_ps(_mm256_mul_ps(uFactorVec, _mm256_loadu_ps(policyProbs + idx)),
+                                       _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(childNumberVisits + idx))), one));
+        const __m256 values = _mm256_add_ps(_mm256_loadu_ps(qValues + idx), u);
+        const __m256 mask = _mm256_cmp_ps(values, bestValues, _CMP_GT_OQ);
+        bestValues = _mm256_blendv_ps(bestValues, values, mask);
+        bestIndices = _mm256_blendv_epi8(bestIndices, curIndices, _mm256_castps_si256(mask));
+        curIndices = _mm256_add_epi32(curIndices, step);
+    }
+
+    alignas(32) float laneValues[8];
+    alignas(32) int32_t laneIndices[8];
+    _mm256_store_ps(laneValues, bestValues);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndices), bestIndices);
+    float bestValue = -std::numeric_limits<float>::infinity();
+    size_t bestIdx = 0;
+    reduce_lanes(laneValues, laneIndices, 8, bestValue, bestIdx);
+    return argmax_tail(qValues, policyProbs, childNumberVisits, idx, numberChildren, uFactor, bestValue, bestIdx);
+}
+
+__attribute__((target("avx512f")))
+size_t argmax_q_plus_u_avx512(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t numberChildren, float uFactor)
+{
+    const __m512 uFactorVec = _mm512_set1_ps(uFactor);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512 bestValues = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+    __m512i bestIndices = _mm512_setzero_si512();
+    __m512i curIndices = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    size_t idx = 0;
+    for (; idx + 16 <= numberChildren; idx += 16) {
+        // the zero-masking conversion avoids the undefined source register of _mm512_cvtepu32_ps()
+        const __m512 u = _mm512_div_ps(_mm512_mul_ps(uFactorVec, _mm512_loadu_ps(policyProbs + idx)),
+                                       _mm512_add_ps(_mm512_maskz_cvtepu32_ps(0xFFFF, _mm512_loadu_si512(childNumberVisits + idx)), one));
+        const __m512 values = _mm512_add_ps(_mm512_loadu_ps(qValues + idx), u);
+        const __mmask16 mask = _mm512_cmp_ps_mask(values, bestValues, _CMP_GT_OQ);
+        bestValues = _mm512_mask_blend_ps(mask, bestValues, values);
+        bestIndices = _mm512_mask_blend_epi32(mask, bestIndices, curIndices);
+        curIndices = _mm512_add_epi32(curIndices, step);
+    }
+
+    alignas(64) float laneValues[16];
+    alignas(64) int32_t laneIndices[16];
+    _mm512_store_ps(laneValues, bestValues);
+    _mm512_store_si512(laneIndices, bestIndices);
+    float bestValue = -std::numeric_limits<float>::infinity();
+    size_t bestIdx = 0;
+    reduce_lanes(laneValues, laneIndices, 16, bestValue, bestIdx);
+    return argmax_tail(qValues, policyProbs, childNumberVisits, idx, numberChildren, uFactor, bestValue, bestIdx);
+}
+#endif
+
+#ifdef PUCT_NEON
+size_t argmax_q_plus_u_neon(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t numberChildren, float uFactor)
+{
+    const float32x4_t uFactorVec = vdupq_n_f32(uFactor);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const uint32x4_t step = vdupq_n_u32(4);
+    float32x4_t bestValues = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+    uint32x4_t bestIndices = vdupq_n_u32(0);
+    const uint32_t initIndices[4] = {0, 1, 2, 3};
+    uint32x4_t curIndices = vld1q_u32(initIndices);
+
+    size_t idx = 0;
+    for (; idx + 4 <= numberChildren; idx += 4) {
+        const float32x4_t u = vdivq_f32(vmulq_f32(uFactorVec, vld1q_f32(policyProbs + idx)),
+                                        vaddq_f32(vcvtq_f32_u32(vld1q_u32(childNumberVisits + idx)), one));
+        const float32x4_t values = vaddq_f32(vld1q_f32(qValues + idx), u);
+        const uint32x4_t mask = vcgtq_f32(values, bestValues);
+        bestValues = vbslq_f32(mask, values, bestValues);
+        bestIndices = vbslq_u32(mask, curIndices, bestIndices);
+        curIndices = vaddq_u32(curIndices, step);
+    }
+
+    float laneValues[4];
+    int32_t laneIndices[4];
+    vst1q_f32(laneValues, bestValues);
+    vst1q_s32(laneIndices, vreinterpretq_s32_u32(bestIndices));
+    float bestValue = -std::numeric_limits<float>::infinity();
+    size_t bestIdx = 0;
+    reduce_lanes(laneValues, laneIndices, 4, bestValue, bestIdx);
+    return argmax_tail(qValues, policyProbs, childNumberVisits, idx, numberChildren, uFactor, bestValue, bestIdx);
+}
+#endif
+
+struct KernelChoice {
+    SelectionKernel kernel;
+    const char* name;
+};
+
+KernelChoice detect_kernel()
+{
+#ifdef PUCT_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return {argmax_q_plus_u_avx512, "avx512"};
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return {argmax_q_plus_u_avx2, "avx2"};
+    }
+#elif defined(PUCT_NEON)
+    return {argmax_q_plus_u_neon, "neon"};
+#endif
+    return {argmax_q_plus_u_scalar, "scalar"};
+}
+
+const KernelChoice& get_kernel()
+{
+    static const KernelChoice kernelChoice = detect_kernel();
+    return kernelChoice;
+}
+}
+
+size_t argmax_q_plus_u_scalar(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t numberChildren, float uFactor)
+{
+    return argmax_tail(qValues, policyProbs, childNumberVisits, 1, numberChildren, uFactor,
+                       q_plus_u(qValues, policyProbs, childNumberVisits, 0, uFactor), 0);
+}
+
+size_t argmax_q_plus_u(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t numberChildren, float uFactor)
+{
+    return get_kernel().kernel(qValues, policyProbs, childNumberVisits, numberChildren, uFactor);
+}
+
+const char* puct_selection_kernel_name()
+{
+    return get_kernel().name;
+}
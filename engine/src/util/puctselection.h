@@ -0,0 +1,59 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: puctselection.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Allocation free PUCT child selection which fuses the u-value calculation and the argmax over Q+U.
+ * AVX-512 and AVX2 kernels are chosen at runtime based on the CPU features, NEON is used on aarch64.
+ * All other platforms use the scalar version.
+ */
+
+#ifndef PUCTSELECTION_H
+#define PUCTSELECTION_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief argmax_q_plus_u Returns the index of the child with the highest value Q + uFactor * P / (N + 1).
+ * In case of ties the lowest index is returned like for blaze::argmax().
+ * @param qValues Q-values of the child nodes
+ * @param policyProbs Prior policy of the child nodes
+ * @param childNumberVisits Visits of the child nodes, the kernels convert them to float
+ * @param numberChildren Number of entries which are evaluated (must be > 0)
+ * @param uFactor Exploration factor cpuct * sqrt(visitSum) which is shared by all child nodes
+ * @return Child index
+ */
+size_t argmax_q_plus_u(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t numberChildren, float uFactor);
+
+/**
+ * @brief argmax_q_plus_u_scalar Scalar reference implementation of argmax_q_plus_u()
+ */
+size_t argmax_q_plus_u_scalar(const float* qValues, const float* policyProbs, const uint32_t* childNumberVisits, size_t numberChildren, float uFactor);
+
+/**
+ * @brief puct_selection_kernel_name Returns the name of the kernel which has been selected for the current CPU
+ * @return "avx512", "avx2", "neon" or "scalar"
+ */
+const char* puct_selection_kernel_name();
+
+#endif // PUCTSELECTION_H
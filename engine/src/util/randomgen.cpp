@@ -24,3 +24,97 @@
  */
 
 #include "randomgen.h"
+#include <atomic>
+
+namespace {
+uint64_t random_device_seed() {
+    std::random_device device;
+    return device() | (uint64_t(device()) << 32);
+}
+
+std::atomic<uint64_t> baseSeed(random_device_seed());
+std::atomic<uint64_t> streamCounter(0);
+thread_local bool isThreadRandomSeeded = false;
+thread_local FastRandom threadRandom;
+
+inline uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+}
+
+void FastRandom::seed(uint64_t seed)
+{
+    for (size_t idx = 0; idx < 4; ++idx) {
+        s[idx] = splitmix64(seed);
+    }
+}
+
+void AliasTable::build(const float* weights, size_t size)
+{
+    acceptProbs.resize(size);
+    aliases.resize(size);
+    small.clear();
+    large.clear();
+
+    double weightSum = 0;
+    for (size_t idx = 0; idx < size; ++idx) {
+        weightSum += weights[idx];
+    }
+    for (size_t idx = 0; idx < size; ++idx) {
+        acceptProbs[idx] = float(weights[idx] * size / weightSum);
+        aliases[idx] = uint32_t(idx);
+        if (acceptProbs[idx] < 1.0f) {
+            small.emplace_back(idx);
+        }
+        else {
+            large.emplace_back(idx);
+        }
+    }
+    while (!small.empty() && !large.empty()) {
+        const uint32_t smallIdx = small.back();
+        small.pop_back();
+        const uint32_t largeIdx = large.back();
+        aliases[smallIdx] = largeIdx;
+        acceptProbs[largeIdx] -= 1.0f - acceptProbs[smallIdx];
+        if (acceptProbs[largeIdx] < 1.0f) {
+            large.pop_back();
+            small.emplace_back(largeIdx);
+        }
+    }
+    // the remaining entries are only left over due to rounding errors
+    for (uint32_t idx : small) {
+        acceptProbs[idx] = 1.0f;
+    }
+    for (uint32_t idx : large) {
+        acceptProbs[idx] = 1.0f;
+    }
+}
+
+void set_random_seed(uint64_t seed)
+{
+    if (seed == 0) {
+        seed = random_device_seed();
+    }
+    baseSeed = seed;
+    streamCounter = 0;
+    threadRandom.seed(next_stream_seed());
+    isThreadRandomSeeded = true;
+}
+
+uint64_t next_stream_seed()
+{
+    uint64_t x = baseSeed + streamCounter++;
+    return splitmix64(x);
+}
+
+FastRandom& thread_random()
+{
+    if (!isThreadRandomSeeded) {
+        threadRandom.seed(next_stream_seed());
+        isThreadRandomSeeded = true;
+    }
+    return threadRandom;
+}
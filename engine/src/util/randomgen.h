@@ -23,16 +23,121 @@
  * @author: queensgambit
  *
  * Utility methods which all random number generation from several distribution types
+ *
+ * All random numbers are drawn from xoshiro256++ generators. Every thread owns its own generator (thread_random()),
+ * which is derived from a common base seed, so no state is shared between threads.
  */
 
 #ifndef RANDOMGEN_H
 #define RANDOMGEN_H
 
 #include <random>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The FastRandom class xoshiro256++ pseudo random number generator (https://prng.di.unimi.it/).
+ * It satisfies the UniformRandomBitGenerator requirements and can be used with the std distributions.
+ */
+class FastRandom
+{
+private:
+    uint64_t s[4];
+
+    static inline uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+public:
+    using result_type = uint64_t;
+
+    explicit FastRandom(uint64_t seed = 1) {
+        this->seed(seed);
+    }
 
-// random generator used for all sort of distributions
-static std::random_device r;
-static std::default_random_engine generator(r());
+    /**
+     * @brief seed Initializes the state by expanding the given seed with splitmix64
+     */
+    void seed(uint64_t seed);
+
+    static constexpr result_type min() {
+        return 0;
+    }
+    static constexpr result_type max() {
+        return UINT64_MAX;
+    }
+
+    inline result_type operator()() {
+        const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    /**
+     * @brief bounded Returns a random integer in [0, range) without a modulo operation (Lemire's multiply-shift)
+     * @param range Upper bound which must be > 0
+     */
+    inline uint32_t bounded(uint32_t range) {
+        return uint32_t(((operator()() >> 32) * range) >> 32);
+    }
+
+    /**
+     * @brief uniform Returns a random float in [0, 1)
+     */
+    inline float uniform() {
+        return float(operator()() >> 40) * (1.0f / 16777216.0f);
+    }
+};
+
+/**
+ * @brief The AliasTable class Walker's alias method for sampling from a discrete distribution in constant time.
+ * The table keeps its memory, so rebuilding it for distributions of similar size doesn't allocate.
+ */
+class AliasTable
+{
+private:
+    std::vector<float> acceptProbs;
+    std::vector<uint32_t> aliases;
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+public:
+    /**
+     * @brief build Builds the table for the given non negative weights, which don't need to be normalized
+     * @param weights Weights of the entries
+     * @param size Number of entries (must be > 0)
+     */
+    void build(const float* weights, size_t size);
+
+    /**
+     * @brief sample Returns a random index according to the distribution of the last build() call
+     */
+    inline size_t sample(FastRandom& random) const {
+        const uint32_t idx = random.bounded(uint32_t(acceptProbs.size()));
+        return random.uniform() < acceptProbs[idx] ? idx : aliases[idx];
+    }
+};
+
+/**
+ * @brief set_random_seed Sets the base seed of all generators and reseeds the generator of the calling thread.
+ * @param seed Base seed, 0 uses a seed of std::random_device
+ */
+void set_random_seed(uint64_t seed);
+
+/**
+ * @brief next_stream_seed Returns the seed of the next generator stream derived from the base seed.
+ * Streams which are requested in the same order, e.g. by creating the search threads, get the same seeds.
+ */
+uint64_t next_stream_seed();
+
+/**
+ * @brief thread_random Returns the generator of the calling thread which is seeded by next_stream_seed() on first use
+ */
+FastRandom& thread_random();
 
 /**
  * @brief random_exponential Generates a random sample from a exponential distribution with a given mean.
@@ -42,7 +147,7 @@ static std::default_random_engine generator(r());
 template<typename T>
 T random_exponential(T lambda) {
     std::exponential_distribution<T> distribution(lambda);
-    return distribution(generator);
+    return distribution(thread_random());
 }
 
 #endif // RANDOMGEN_H
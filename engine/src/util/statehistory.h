@@ -0,0 +1,161 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: statehistory.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Storage for the StateInfo history of a board state which avoids heap allocations for short histories.
+ */
+
+#ifndef STATEHISTORY_H
+#define STATEHISTORY_H
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+// number of StateInfo entries which are stored inside each state object
+#define STATE_HISTORY_INLINE_SIZE 4
+// maximum number of overflow queues which are kept for reuse by each thread
+#define STATE_HISTORY_POOL_SIZE 64
+
+template <typename T, size_t inlineCapacity>
+/**
+ * @brief The StateHistory class is a stack of StateInfo entries with stable addresses.
+ * The first entries are stored inside the object, longer histories continue in an overflow queue
+ * which is taken from and returned to a pool of the current thread.
+ * An object must neither be copied nor moved, because the board keeps pointers to its entries.
+ */
+class StateHistory
+{
+private:
+    T inlineStates[inlineCapacity];
+    size_t numberStates;
+    std::unique_ptr<std::deque<T>> overflowStates;
+
+    /**
+     * @brief overflow_pool Returns the released overflow queues of the current thread
+     */
+    static std::vector<std::unique_ptr<std::deque<T>>>& overflow_pool() {
+        thread_local std::vector<std::unique_ptr<std::deque<T>>> pool;
+        return pool;
+    }
+
+    void release_overflow() {
+        if (overflowStates == nullptr) {
+            return;
+        }
+        std::vector<std::unique_ptr<std::deque<T>>>& pool = overflow_pool();
+        if (pool.size() < STATE_HISTORY_POOL_SIZE) {
+            overflowStates->clear();
+            pool.emplace_back(std::move(overflowStates));
+        }
+        overflowStates.reset();
+    }
+
+public:
+    StateHistory():
+        numberStates(0)
+    {
+    }
+    StateHistory(const StateHistory&) = delete;
+    StateHistory& operator=(const StateHistory&) = delete;
+
+    ~StateHistory()
+    {
+        release_overflow();
+    }
+
+    /**
+     * @brief emplace_back Appends a value-initialized entry
+     * @return Reference to the new entry
+     */
+    T& emplace_back()
+    {
+        if (numberStates < inlineCapacity) {
+            inlineStates[numberStates] = T();
+            return inlineStates[numberStates++];
+        }
+        if (overflowStates == nullptr) {
+            std::vector<std::unique_ptr<std::deque<T>>>& pool = overflow_pool();
+            if (pool.empty()) {
+                overflowStates = std::make_unique<std::deque<T>>();
+            }
+            else {
+                overflowStates = std::move(pool.back());
+                pool.pop_back();
+            }
+        }
+        ++numberStates;
+        overflowStates->emplace_back();
+        return overflowStates->back();
+    }
+
+    /**
+     * @brief emplace_back Appends a copy of the given entry
+     * @return Reference to the new entry
+     */
+    T& emplace_back(const T& value)
+    {
+        T& state = emplace_back();
+        state = value;
+        return state;
+    }
+
+    /**
+     * @brief pop_back Removes the last entry
+     */
+    void pop_back()
+    {
+        if (numberStates > inlineCapacity) {
+            overflowStates->pop_back();
+        }
+        --numberStates;
+    }
+
+    /**
+     * @brief back Returns the last entry
+     */
+    T& back()
+    {
+        return numberStates > inlineCapacity ? overflowStates->back() : inlineStates[numberStates-1];
+    }
+    const T& back() const
+    {
+        return numberStates > inlineCapacity ? overflowStates->back() : inlineStates[numberStates-1];
+    }
+
+    /**
+     * @brief clear Removes all entries
+     */
+    void clear()
+    {
+        release_overflow();
+        numberStates = 0;
+    }
+
+    size_t size() const
+    {
+        return numberStates;
+    }
+};
+
+#endif // STATEHISTORY_H
@@ -0,0 +1,223 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: tablebaseprober.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "tablebaseprober.h"
+#include <sstream>
+#include "communication.h"
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// the lower bits of an entry hold the probe result, the remaining bits the position key
+constexpr uint64_t TB_CACHE_RESULT_MASK = 0xFF;
+
+uint64_t encode_entry(Key key, Tablebase::ProbeState result, Tablebase::WDLScore wdlScore)
+{
+    // the encoded probe state is never zero, so that a stored entry is never empty
+    return (uint64_t(key) & ~TB_CACHE_RESULT_MASK) | (uint64_t(result + 2) << 3) | uint64_t(wdlScore + 2);
+}
+
+TablebaseProber::TablebaseProber():
+    mask(0),
+    asyncProbing(false),
+    isRunning(false),
+    hits(0)
+{
+}
+
+TablebaseProber::~TablebaseProber()
+{
+    stop_probe_thread();
+}
+
+void TablebaseProber::init(size_t numberBytes, bool asyncProbing)
+{
+    stop_probe_thread();
+    size_t numberEntries = 1;
+    while (numberEntries * 2 * sizeof(uint64_t) <= numberBytes) {
+        numberEntries *= 2;
+    }
+    if (numberBytes < sizeof(uint64_t)) {
+        entries.reset();
+        mask = 0;
+    }
+    else if (entries == nullptr || mask + 1 != numberEntries) {
+        entries = std::make_unique<std::atomic<uint64_t>[]>(numberEntries);
+        mask = numberEntries - 1;
+    }
+    hits = 0;
+    // the results of the background probes are only available through the cache
+    this->asyncProbing = asyncProbing && entries != nullptr;
+    if (this->asyncProbing) {
+        isRunning = true;
+        probeThread = std::thread(&TablebaseProber::run_probe_thread, this);
+    }
+}
+
+bool TablebaseProber::lookup(Key key, Tablebase::ProbeState& result, Tablebase::WDLScore& wdlScore) const
+{
+    const uint64_t entry = entries[key & mask].load(std::memory_order_relaxed);
+    if (entry == 0 || ((entry ^ uint64_t(key)) & ~TB_CACHE_RESULT_MASK) != 0) {
+        return false;
+    }
+    result = Tablebase::ProbeState(int((entry >> 3) & 7) - 2);
+    wdlScore = Tablebase::WDLScore(int(entry & 7) - 2);
+    return true;
+}
+
+void TablebaseProber::store(Key key, Tablebase::ProbeState result, Tablebase::WDLScore wdlScore)
+{
+    if (wdlScore < Tablebase::WDLLoss || wdlScore > Tablebase::WDLWin) {
+        // e.g. WDLScoreNone of failed probes
+        wdlScore = Tablebase::WDLDraw;
+    }
+    entries[key & mask].store(encode_entry(key, result, wdlScore), std::memory_order_relaxed);
+}
+
+Tablebase::WDLScore TablebaseProber::probe(StateObj* state, Tablebase::ProbeState& result)
+{
+    if (entries == nullptr || !state->could_be_in_tablebase()) {
+        return state->check_for_tablebase_wdl(result);
+    }
+    const Key key = state->hash_key();
+    Tablebase::WDLScore wdlScore;
+    if (lookup(key, result, wdlScore)) {
+        ++hits;
+        return wdlScore;
+    }
+    if (asyncProbing) {
+        enqueue(state);
+        result = Tablebase::FAIL;
+        return Tablebase::WDLScoreNone;
+    }
+    wdlScore = state->check_for_tablebase_wdl(result);
+    store(key, result, wdlScore);
+    return wdlScore;
+}
+
+void TablebaseProber::enqueue(const StateObj* state)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (probeQueue.size() >= TB_PROBE_QUEUE_SIZE || !queuedKeys.insert(state->hash_key()).second) {
+        return;
+    }
+    probeQueue.emplace_back(state->clone());
+    queueCondition.notify_one();
+}
+
+void TablebaseProber::run_probe_thread()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        queueCondition.wait(lock, [this] { return !isRunning || !probeQueue.empty(); });
+        if (!isRunning) {
+            return;
+        }
+        std::unique_ptr<StateObj> state = std::move(probeQueue.front());
+        probeQueue.pop_front();
+        lock.unlock();
+        // the probe may read from disk, so the queue isn't locked in the meantime
+        Tablebase::ProbeState result;
+        const Tablebase::WDLScore wdlScore = state->check_for_tablebase_wdl(result);
+        store(state->hash_key(), result, wdlScore);
+        lock.lock();
+        queuedKeys.erase(state->hash_key());
+    }
+}
+
+void TablebaseProber::stop_probe_thread()
+{
+    if (!probeThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        isRunning = false;
+        probeQueue.clear();
+        queuedKeys.clear();
+    }
+    queueCondition.notify_one();
+    probeThread.join();
+}
+
+void TablebaseProber::clear()
+{
+    for (size_t idx = 0; entries != nullptr && idx <= mask; ++idx) {
+        entries[idx].store(0, std::memory_order_relaxed);
+    }
+    hits = 0;
+}
+
+size_t TablebaseProber::get_hits() const
+{
+    return hits;
+}
+
+TablebaseProber& tablebase_prober()
+{
+    static TablebaseProber prober;
+    return prober;
+}
+
+void warm_up_tablebases(const std::string& syzygyPath)
+{
+#ifdef _WIN32
+    info_string("The tablebase warm-up isn't supported on Windows");
+#else
+    std::stringstream paths(syzygyPath);
+    std::string directory;
+    size_t numberFiles = 0;
+    size_t numberBytes = 0;
+    while (std::getline(paths, directory, ':')) {
+        std::shared_ptr<DIR> dirPtr(opendir(directory.c_str()), [](DIR* dir){ dir && closedir(dir); });
+        if (!dirPtr) {
+            continue;
+        }
+        struct dirent* entry;
+        while ((entry = readdir(dirPtr.get())) != nullptr) {
+            const std::string fileName = entry->d_name;
+            // only the WDL tables are probed during the search, the DTZ tables are used for the root position
+            if (fileName.size() < 5 || fileName.compare(fileName.size() - 5, 5, ".rtbw") != 0) {
+                continue;
+            }
+            const int fd = open((directory + "/" + fileName).c_str(), O_RDONLY);
+            if (fd < 0) {
+                continue;
+            }
+            struct stat fileStat;
+            if (fstat(fd, &fileStat) == 0) {
+                numberBytes += size_t(fileStat.st_size);
+            }
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            close(fd);
+            ++numberFiles;
+        }
+    }
+    info_string("tablebase warm-up of files:", numberFiles, "(" + std::to_string(numberBytes / (1024 * 1024)) + " MB)");
+#endif
+}
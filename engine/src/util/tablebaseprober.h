@@ -0,0 +1,121 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: tablebaseprober.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Tablebase probing for the node expansion with a lock-free cache of the WDL results which is kept across searches.
+ * Cache misses can optionally be probed by a background thread: the node is evaluated by the neural network
+ * in the meantime and later expansions of the same position use the cached result.
+ */
+
+#ifndef TABLEBASEPROBER_H
+#define TABLEBASEPROBER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include "../stateobj.h"
+
+// maximum number of positions which wait for a background probe, further cache misses are not queued
+#define TB_PROBE_QUEUE_SIZE 256
+
+class TablebaseProber
+{
+private:
+    // every entry packs the upper bits of the position key and the encoded probe result, zero marks an empty entry
+    std::unique_ptr<std::atomic<uint64_t>[]> entries;
+    size_t mask;
+    bool asyncProbing;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<std::unique_ptr<StateObj>> probeQueue;
+    std::unordered_set<Key> queuedKeys;
+    std::thread probeThread;
+    bool isRunning;
+    std::atomic<size_t> hits;
+
+    /**
+     * @brief lookup Returns true and sets the result of a previous probe if the key is stored in the cache
+     */
+    bool lookup(Key key, Tablebase::ProbeState& result, Tablebase::WDLScore& wdlScore) const;
+
+    void store(Key key, Tablebase::ProbeState result, Tablebase::WDLScore wdlScore);
+
+    /**
+     * @brief enqueue Adds a copy of the state to the background probe queue unless it is full or the position is already queued
+     */
+    void enqueue(const StateObj* state);
+
+    void run_probe_thread();
+    void stop_probe_thread();
+
+public:
+    TablebaseProber();
+    ~TablebaseProber();
+    TablebaseProber(const TablebaseProber&) = delete;
+    TablebaseProber& operator=(TablebaseProber const&) = delete;
+
+    /**
+     * @brief init (Re-)creates the cache and starts or stops the background probe thread. Must not be called during a search.
+     * @param numberBytes Memory size of the cache (rounded down to a power of two number of entries), 0 disables the cache
+     * @param asyncProbing True, if cache misses should be probed in the background (requires a cache)
+     */
+    void init(size_t numberBytes, bool asyncProbing);
+
+    /**
+     * @brief probe Returns the WDL score of the given state. The cache is searched first. On a miss the tablebases are probed
+     * synchronously or the position is queued for a background probe and Tablebase::FAIL is returned.
+     * @param state Current state
+     * @param result ProbeState result
+     * @return WDLScore
+     */
+    Tablebase::WDLScore probe(StateObj* state, Tablebase::ProbeState& result);
+
+    /**
+     * @brief clear Removes all cached results, e.g. when the tablebase path has changed
+     */
+    void clear();
+
+    /**
+     * @brief get_hits Returns the number of cache hits since the last init()
+     * @return size_t
+     */
+    size_t get_hits() const;
+};
+
+/**
+ * @brief tablebase_prober Returns the process wide tablebase prober
+ */
+TablebaseProber& tablebase_prober();
+
+/**
+ * @brief warm_up_tablebases Asks the operating system to read the WDL tablebase files into the page cache,
+ * so that the first probes of a search don't wait for the disk
+ * @param syzygyPath Directories of the tablebase files separated by ':'
+ */
+void warm_up_tablebases(const std::string& syzygyPath);
+
+#endif // TABLEBASEPROBER_H
@@ -0,0 +1,162 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: tcpsocket.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#ifndef _WIN32
+#include "tcpsocket.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool send_all(int fd, const char* data, size_t numberBytes)
+{
+    while (numberBytes > 0) {
+        const ssize_t sentBytes = send(fd, data, numberBytes, MSG_NOSIGNAL);
+        if (sentBytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sentBytes <= 0) {
+            return false;
+        }
+        data += sentBytes;
+        numberBytes -= size_t(sentBytes);
+    }
+    return true;
+}
+
+bool recv_all(int fd, void* buffer, size_t numberBytes)
+{
+    char* data = static_cast<char*>(buffer);
+    while (numberBytes > 0) {
+        const ssize_t receivedBytes = recv(fd, data, numberBytes, 0);
+        if (receivedBytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (receivedBytes <= 0) {
+            return false;
+        }
+        data += receivedBytes;
+        numberBytes -= size_t(receivedBytes);
+    }
+    return true;
+}
+
+bool send_line(int fd, const std::string& line)
+{
+    const std::string message = line + "\n";
+    return send_all(fd, message.data(), message.size());
+}
+
+bool recv_line(int fd, std::string& pending, std::string& line)
+{
+    char buffer[4096];
+    size_t lineEnd;
+    while ((lineEnd = pending.find('\n')) == std::string::npos) {
+        if (pending.size() > MAX_LINE_LENGTH) {
+            // the peer doesn't follow the protocol, the connection is dropped instead of buffering without limit
+            return false;
+        }
+        const ssize_t numberBytes = recv(fd, buffer, sizeof(buffer), 0);
+        if (numberBytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (numberBytes <= 0) {
+            return false;
+        }
+        pending.append(buffer, size_t(numberBytes));
+    }
+    line = pending.substr(0, lineEnd);
+    if (line.size() != 0 && line.back() == '\r') {
+        line.pop_back();
+    }
+    pending.erase(0, lineEnd + 1);
+    return true;
+}
+
+void set_no_delay(int fd)
+{
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+int connect_to_address(const std::string& address, bool isUDP)
+{
+    const size_t separatorPos = address.rfind(':');
+    if (separatorPos == std::string::npos) {
+        throw std::invalid_argument("The address must be given as <host>:<port>, but was " + address + ".");
+    }
+    const std::string host = address.substr(0, separatorPos);
+    const std::string port = address.substr(separatorPos + 1);
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = isUDP ? SOCK_DGRAM : SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+        throw std::invalid_argument("The address " + address + " couldn't be resolved.");
+    }
+    int fd = -1;
+    for (addrinfo* candidate = addresses; candidate != nullptr; candidate = candidate->ai_next) {
+        fd = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+        if (fd == -1) {
+            continue;
+        }
+        if (connect(fd, candidate->ai_addr, candidate->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    return fd;
+}
+
+int listen_on_port(int port)
+{
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        throw std::invalid_argument(std::string("The socket couldn't be created: ") + strerror(errno));
+    }
+    int flag = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    sockaddr_in serverAddress;
+    memset(&serverAddress, 0, sizeof(serverAddress));
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+    serverAddress.sin_port = htons(uint16_t(port));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&serverAddress), sizeof(serverAddress)) == -1 || listen(fd, SOMAXCONN) == -1) {
+        const std::string error = strerror(errno);
+        close(fd);
+        throw std::invalid_argument("Couldn't listen on port " + std::to_string(port) + ": " + error);
+    }
+    return fd;
+}
+#endif
@@ -0,0 +1,98 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: tcpsocket.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Small helpers for blocking POSIX sockets which are shared by the remote inference backend, the sample publisher and the metrics exporter
+ */
+
+#ifndef TCPSOCKET_H
+#define TCPSOCKET_H
+
+#ifndef _WIN32
+#include <cstddef>
+#include <string>
+
+// maximum number of bytes of a line which is received by recv_line()
+#define MAX_LINE_LENGTH (64 * 1024)
+
+/**
+ * @brief send_all Sends all bytes of a buffer
+ * @param fd Socket
+ * @param data Buffer
+ * @param numberBytes Number of bytes to send
+ * @return False if the connection has been closed or broken
+ */
+bool send_all(int fd, const char* data, size_t numberBytes);
+
+/**
+ * @brief recv_all Receives exactly numberBytes bytes
+ * @param fd Socket
+ * @param buffer Output buffer
+ * @param numberBytes Number of bytes to receive
+ * @return False if the connection has been closed or broken
+ */
+bool recv_all(int fd, void* buffer, size_t numberBytes);
+
+/**
+ * @brief send_line Sends a single line of a line based protocol
+ * @param fd Socket
+ * @param line Line without the trailing newline
+ * @return False if the connection has been closed or broken
+ */
+bool send_line(int fd, const std::string& line);
+
+/**
+ * @brief recv_line Receives a single line of a line based protocol
+ * @param fd Socket
+ * @param pending Received bytes after the former line, must be kept between the calls of the same connection
+ * @param line Output line without the trailing newline or carriage return
+ * @return False if the connection has been closed or broken or the line is longer than MAX_LINE_LENGTH
+ */
+bool recv_line(int fd, std::string& pending, std::string& line);
+
+/**
+ * @brief set_no_delay Disables Nagle's algorithm for latency bound connections
+ * @param fd Socket
+ */
+void set_no_delay(int fd);
+
+/**
+ * @brief connect_to_address Opens a TCP connection to the given address
+ * @param address Address in the form <host>:<port>
+ * @param isUDP If true, a connected UDP socket is returned instead
+ * @return Connected socket or -1 if the host couldn't be reached.
+ * Throws an invalid_argument exception if the address is malformed or can't be resolved.
+ */
+int connect_to_address(const std::string& address, bool isUDP=false);
+
+/**
+ * @brief listen_on_port Creates a TCP socket which listens on all interfaces.
+ * Throws an invalid_argument exception if the port can't be used.
+ * @param port Port number
+ * @return Listening socket
+ */
+int listen_on_port(int port);
+#endif
+
+#endif // TCPSOCKET_H
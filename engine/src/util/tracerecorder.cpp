@@ -0,0 +1,144 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: tracerecorder.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ */
+
+#include "tracerecorder.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include "communication.h"
+
+namespace {
+thread_local uint32_t traceThreadId = 0;
+}
+
+TraceRecorder::TraceRecorder():
+    enabled(false),
+    nextIdx(0),
+    dumpedIdx(0),
+    nextThreadId(1),
+    origin(std::chrono::steady_clock::now())
+{
+}
+
+void TraceRecorder::set_file(const std::string& traceFile)
+{
+    if (traceFile != "" && events == nullptr) {
+        events = std::make_unique<TraceEvent[]>(TRACE_BUFFER_SIZE);
+    }
+    fileName = traceFile;
+    enabled = traceFile != "";
+}
+
+void TraceRecorder::record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    if (traceThreadId == 0) {
+        traceThreadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    }
+    const uint64_t idx = nextIdx.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& event = events[idx & (TRACE_BUFFER_SIZE - 1)];
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name = name;
+    event.threadId = traceThreadId;
+    event.startNS = std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin).count();
+    event.durationNS = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    event.sequence.store(idx + 1, std::memory_order_release);
+}
+
+void TraceRecorder::set_thread_name(const std::string& name)
+{
+    if (!is_enabled()) {
+        return;
+    }
+    if (traceThreadId == 0) {
+        traceThreadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(threadNamesMtx);
+    for (auto& threadName : threadNames) {
+        if (threadName.first == traceThreadId) {
+            threadName.second = name;
+            return;
+        }
+    }
+    threadNames.emplace_back(traceThreadId, name);
+}
+
+void TraceRecorder::dump()
+{
+    if (!is_enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> dumpLock(dumpMtx);
+    // only the events up to this index are consumed, later ones are written by the next dump
+    const uint64_t endIdx = nextIdx.load(std::memory_order_acquire);
+    const uint64_t firstIdx = std::max(dumpedIdx, endIdx - std::min(endIdx, uint64_t(TRACE_BUFFER_SIZE)));
+    dumpedIdx = endIdx;
+    std::ofstream traceFile(fileName, std::ios_base::trunc);
+    if (!traceFile.is_open()) {
+        info_string("Could not open the trace file", fileName);
+        return;
+    }
+    traceFile << std::fixed << std::setprecision(3);
+    traceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool isFirst = true;
+    {
+        std::lock_guard<std::mutex> lock(threadNamesMtx);
+        for (const auto& threadName : threadNames) {
+            traceFile << (isFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadName.first
+                      << ",\"args\":{\"name\":\"" << threadName.second << "\"}}";
+            isFirst = false;
+        }
+    }
+    uint64_t numberEvents = 0;
+    for (uint64_t idx = firstIdx; idx < endIdx; ++idx) {
+        TraceEvent& slot = events[idx & (TRACE_BUFFER_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != idx + 1) {
+            // the event is still being written or has already been overwritten
+            continue;
+        }
+        TraceEvent event;
+        event.name = slot.name;
+        event.threadId = slot.threadId;
+        event.startNS = slot.startNS;
+        event.durationNS = slot.durationNS;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != idx + 1) {
+            continue;
+        }
+        ++numberEvents;
+        traceFile << (isFirst ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId
+                  << ",\"ts\":" << event.startNS / 1000.0 << ",\"dur\":" << event.durationNS / 1000.0 << "}";
+        isFirst = false;
+    }
+    traceFile << "\n]}\n";
+    info_string("wrote", numberEvents, "trace events to " + fileName);
+}
+
+TraceRecorder& trace_recorder()
+{
+    static TraceRecorder recorder;
+    return recorder;
+}
@@ -0,0 +1,143 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: tracerecorder.h
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Recorder of timestamped events of the search and inference threads which are exported in the Chrome trace format.
+ * The file can be opened with chrome://tracing or https://ui.perfetto.dev to inspect the overlap of the pipeline.
+ * Recording is enabled at runtime by the UCI option "Trace_File" and costs a single relaxed atomic load per event otherwise.
+ */
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// number of events of the ring buffer (must be a power of two), older events are overwritten
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+struct TraceEvent
+{
+    // must point to a string literal
+    const char* name;
+    uint32_t threadId;
+    int64_t startNS;
+    int64_t durationNS;
+    // index of the event + 1 once all fields are written, 0 while the slot is written
+    std::atomic<uint64_t> sequence;
+};
+
+/**
+ * @brief The TraceRecorder class stores the events of all threads in a lock-free ring buffer.
+ * Every event reserves its slot with a single atomic increment.
+ */
+class TraceRecorder
+{
+private:
+    std::atomic<bool> enabled;
+    std::atomic<uint64_t> nextIdx;
+    // index of the first event which hasn't been written to the trace file yet
+    uint64_t dumpedIdx;
+    // the member trees of a composite agent may finish their searches at the same time
+    std::mutex dumpMtx;
+    std::atomic<uint32_t> nextThreadId;
+    std::unique_ptr<TraceEvent[]> events;
+    std::chrono::steady_clock::time_point origin;
+    std::string fileName;
+    std::mutex threadNamesMtx;
+    std::vector<std::pair<uint32_t, std::string>> threadNames;
+
+public:
+    TraceRecorder();
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /**
+     * @brief set_file Enables the recording if the file name isn't empty and disables it otherwise
+     * @param traceFile File to which the events are dumped
+     */
+    void set_file(const std::string& traceFile);
+
+    inline bool is_enabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief record Adds an event of the calling thread to the ring buffer
+     * @param name Event name (must be a string literal)
+     * @param start Start time
+     * @param end End time
+     */
+    void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    /**
+     * @brief set_thread_name Assigns a name to the calling thread which is shown in the timeline
+     */
+    void set_thread_name(const std::string& name);
+
+    /**
+     * @brief dump Writes the events which have been recorded since the last dump to the trace file.
+     * Threads may keep recording during the dump, events which are still being written are skipped.
+     */
+    void dump();
+};
+
+/**
+ * @brief trace_recorder Returns the recorder which is shared by all threads of the process
+ */
+TraceRecorder& trace_recorder();
+
+/**
+ * @brief The TraceScope class records the life time of the object as an event if the recording is enabled
+ */
+class TraceScope
+{
+private:
+    const char* name;
+    const bool isEnabled;
+    std::chrono::steady_clock::time_point start;
+public:
+    TraceScope(const char* name):
+        name(name), isEnabled(trace_recorder().is_enabled()) {
+        if (isEnabled) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~TraceScope() {
+        if (isEnabled) {
+            trace_recorder().record(name, start, std::chrono::steady_clock::now());
+        }
+    }
+};
+
+#define TRACE_SCOPE_CONCAT_(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_SCOPE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACERECORDER_H
@@ -0,0 +1,163 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: treestats.cpp
+ * Created on 15.10.2026
+ * @author: queensgambit
+ */
+
+#include "treestats.h"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+static uint64_t get(const TreeCounter& counter)
+{
+    return counter.load(memory_order_relaxed);
+}
+
+static void add_counter(TreeCounter& counter, const TreeCounter& other)
+{
+    counter.fetch_add(get(other), memory_order_relaxed);
+}
+
+static double ratio(uint64_t numerator, uint64_t denominator)
+{
+    return denominator == 0 ? 0 : double(numerator) / denominator;
+}
+
+/**
+ * @brief used_depths Returns the number of depth buckets up to the deepest descent
+ */
+static size_t used_depths(const TreeStats& stats)
+{
+    size_t depths = TREE_STATS_MAX_DEPTH;
+    while (depths > 0 && get(stats.descents[depths-1]) == 0 && get(stats.expansions[depths-1]) == 0) {
+        --depths;
+    }
+    return depths;
+}
+
+static void write_array(ostream& os, const TreeCounter* counters, size_t size)
+{
+    os << "[";
+    for (size_t idx = 0; idx < size; ++idx) {
+        os << (idx == 0 ? "" : ",") << get(counters[idx]);
+    }
+    os << "]";
+}
+
+TreeStats::TreeStats()
+{
+    reset();
+}
+
+void TreeStats::reset()
+{
+    for (size_t depth = 0; depth < TREE_STATS_MAX_DEPTH; ++depth) {
+        descents[depth].store(0, memory_order_relaxed);
+        collisions[depth].store(0, memory_order_relaxed);
+        expansions[depth].store(0, memory_order_relaxed);
+        childNodes[depth].store(0, memory_order_relaxed);
+    }
+    for (TreeCounter* counter : {&terminals, &tablebaseHits, &transpositionChecks, &transpositionReturns,
+                                 &cacheHits, &duplicates, &batches, &batchNodes, &batchCapacity}) {
+        counter->store(0, memory_order_relaxed);
+    }
+    for (size_t idx = 0; idx < TREE_STATS_FILL_BUCKETS; ++idx) {
+        batchFill[idx].store(0, memory_order_relaxed);
+    }
+}
+
+void TreeStats::add(const TreeStats& other)
+{
+    for (size_t depth = 0; depth < TREE_STATS_MAX_DEPTH; ++depth) {
+        add_counter(descents[depth], other.descents[depth]);
+        add_counter(collisions[depth], other.collisions[depth]);
+        add_counter(expansions[depth], other.expansions[depth]);
+        add_counter(childNodes[depth], other.childNodes[depth]);
+    }
+    add_counter(terminals, other.terminals);
+    add_counter(tablebaseHits, other.tablebaseHits);
+    add_counter(transpositionChecks, other.transpositionChecks);
+    add_counter(transpositionReturns, other.transpositionReturns);
+    add_counter(cacheHits, other.cacheHits);
+    add_counter(duplicates, other.duplicates);
+    add_counter(batches, other.batches);
+    add_counter(batchNodes, other.batchNodes);
+    add_counter(batchCapacity, other.batchCapacity);
+    for (size_t idx = 0; idx < TREE_STATS_FILL_BUCKETS; ++idx) {
+        add_counter(batchFill[idx], other.batchFill[idx]);
+    }
+}
+
+void TreeStats::record_batch(size_t numberNodes, size_t batchSize)
+{
+    increment(batches);
+    increment(batchNodes, numberNodes);
+    increment(batchCapacity, batchSize);
+    const size_t bucket = batchSize == 0 ? 0 : numberNodes * (TREE_STATS_FILL_BUCKETS - 1) / batchSize;
+    increment(batchFill[bucket < TREE_STATS_FILL_BUCKETS ? bucket : TREE_STATS_FILL_BUCKETS - 1]);
+}
+
+string TreeStats::to_json() const
+{
+    const size_t depths = used_depths(*this);
+    uint64_t totalDescents = 0;
+    uint64_t totalCollisions = 0;
+    uint64_t weightedDepth = 0;
+    for (size_t depth = 0; depth < depths; ++depth) {
+        totalDescents += get(descents[depth]);
+        totalCollisions += get(collisions[depth]);
+        weightedDepth += depth * get(descents[depth]);
+    }
+
+    stringstream ss;
+    ss << std::fixed << std::setprecision(4);
+    ss << "{\"descents\":" << totalDescents
+       << ",\"avg_depth\":" << ratio(weightedDepth, totalDescents)
+       << ",\"depth_histogram\":";
+    write_array(ss, descents, depths);
+    ss << ",\"collisions\":" << totalCollisions
+       << ",\"collision_ratio\":" << ratio(totalCollisions, totalDescents)
+       << ",\"collisions_by_depth\":";
+    write_array(ss, collisions, depths);
+    ss << ",\"branching_factor\":[";
+    for (size_t depth = 0; depth < depths; ++depth) {
+        ss << (depth == 0 ? "" : ",") << ratio(get(childNodes[depth]), get(expansions[depth]));
+    }
+    ss << "],\"terminals\":" << get(terminals)
+       << ",\"terminal_ratio\":" << ratio(get(terminals), totalDescents)
+       << ",\"tb_hits\":" << get(tablebaseHits)
+       << ",\"tb_hit_ratio\":" << ratio(get(tablebaseHits), get(batchNodes))
+       << ",\"transposition_checks\":" << get(transpositionChecks)
+       << ",\"transposition_returns\":" << get(transpositionReturns)
+       << ",\"transposition_hit_rate\":" << ratio(get(transpositionReturns), get(transpositionChecks))
+       << ",\"cache_hits\":" << get(cacheHits)
+       << ",\"duplicates\":" << get(duplicates)
+       << ",\"batches\":" << get(batches)
+       << ",\"avg_batch_fill\":" << ratio(get(batchNodes), get(batchCapacity))
+       << ",\"batch_fill_histogram\":";
+    write_array(ss, batchFill, TREE_STATS_FILL_BUCKETS);
+    ss << "}";
+    return ss.str();
+}
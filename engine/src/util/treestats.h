@@ -0,0 +1,137 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: treestats.h
+ * Created on 15.10.2026
+ * @author: queensgambit
+ *
+ * Statistics about the shape of the search tree which is built during a search (depth histogram, branching factor,
+ * collisions, transpositions, terminal and tablebase hits and the fill of the mini-batches).
+ * The statistics are only recorded when building with MCTS_TREE_STATS, otherwise TREE_STATS() expands to nothing.
+ * Every search thread is the only writer of its own TreeStats object. The counters are relaxed atomics which are updated
+ * by a plain load and store, so they can be read by other threads at any time without slowing down the search.
+ */
+
+#ifndef TREESTATS_H
+#define TREESTATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// deeper descents are counted in the last bucket
+#define TREE_STATS_MAX_DEPTH 64
+// the batch fill is recorded in steps of 10%, the last bucket is a full mini-batch
+#define TREE_STATS_FILL_BUCKETS 11
+
+typedef std::atomic<uint64_t> TreeCounter;
+
+/**
+ * @brief The TreeStats struct counts the events of the tree traversal of a search thread
+ */
+struct TreeStats
+{
+    // depth of the nodes which were returned by the selection
+    TreeCounter descents[TREE_STATS_MAX_DEPTH];
+    TreeCounter collisions[TREE_STATS_MAX_DEPTH];
+    // number of newly expanded nodes and their summed number of legal moves per depth
+    TreeCounter expansions[TREE_STATS_MAX_DEPTH];
+    TreeCounter childNodes[TREE_STATS_MAX_DEPTH];
+    TreeCounter terminals;
+    TreeCounter tablebaseHits;
+    // visited transposition nodes and how many of them ended the descent
+    TreeCounter transpositionChecks;
+    TreeCounter transpositionReturns;
+    TreeCounter cacheHits;
+    TreeCounter duplicates;
+    // number of mini-batches, their summed size and capacity and the histogram of the fill
+    TreeCounter batches;
+    TreeCounter batchNodes;
+    TreeCounter batchCapacity;
+    TreeCounter batchFill[TREE_STATS_FILL_BUCKETS];
+
+    TreeStats();
+    TreeStats(const TreeStats&) = delete;
+    TreeStats& operator=(const TreeStats&) = delete;
+
+    /**
+     * @brief reset Sets all counters to 0
+     */
+    void reset();
+
+    /**
+     * @brief add Adds the counters of another thread
+     */
+    void add(const TreeStats& other);
+
+    /**
+     * @brief record_descent Records the depth and type of a finished selection (see NodeBackup)
+     * @param depth Depth of the returned node relative to the root node
+     * @param isCollision True if the node was still waiting for its neural network evaluation
+     */
+    void record_descent(size_t depth, bool isCollision) {
+        const size_t bucket = depth_bucket(depth);
+        increment(descents[bucket]);
+        if (isCollision) {
+            increment(collisions[bucket]);
+        }
+    }
+
+    /**
+     * @brief record_expansion Records a newly expanded node and its number of child nodes
+     */
+    void record_expansion(size_t depth, size_t numberChildNodes) {
+        const size_t bucket = depth_bucket(depth);
+        increment(expansions[bucket]);
+        increment(childNodes[bucket], numberChildNodes);
+    }
+
+    /**
+     * @brief record_batch Records the number of new nodes of a mini-batch
+     */
+    void record_batch(size_t numberNodes, size_t batchSize);
+
+    /**
+     * @brief to_json Returns all counters together with the derived branching factor, collision ratio and hit rates as a single line JSON object
+     */
+    std::string to_json() const;
+
+    /**
+     * @brief increment Increments a counter which is only written by the calling thread
+     */
+    static void increment(TreeCounter& counter, uint64_t value = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t depth_bucket(size_t depth) {
+        return depth < TREE_STATS_MAX_DEPTH ? depth : TREE_STATS_MAX_DEPTH - 1;
+    }
+};
+
+#ifdef MCTS_TREE_STATS
+#define TREE_STATS(statement) statement
+#else
+#define TREE_STATS(statement)
+#endif
+
+#endif // TREESTATS_H
@@ -24,6 +24,9 @@
  */
 
 #include "benchmarkpositions.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
 
 BenchmarkPositions::BenchmarkPositions():
     goCommand("movetime 3000"),
@@ -52,3 +55,58 @@ BenchmarkPositions::BenchmarkPositions():
     totalDepth(0)
 {
 }
+
+BenchmarkPositions::BenchmarkPositions(const string& epdFile):
+    goCommand("movetime 3000"),
+    totalNPS(0),
+    totalDepth(0)
+{
+    ifstream file(epdFile);
+    if (!file.is_open()) {
+        throw invalid_argument("The benchmark suite " + epdFile + " couldn't be opened.");
+    }
+    string line;
+    while (getline(file, line)) {
+        istringstream is(line);
+        string fen, token;
+        // board, side to move, castling rights and en-passant square
+        for (size_t idx = 0; idx < 4 && is >> token; ++idx) {
+            fen += (idx == 0 ? "" : " ") + token;
+        }
+        if (fen.empty() || fen[0] == '#') {
+            continue;
+        }
+        string blunderMove, alternativeMove;
+        string halfMoveClock = "0";
+        string fullMoveNumber = "1";
+        size_t fieldIdx = 0;
+        while (is >> token) {
+            // full FEN lines contain the move counters instead of operations
+            if (fieldIdx < 2 && token.find_first_not_of("0123456789") == string::npos) {
+                (fieldIdx == 0 ? halfMoveClock : fullMoveNumber) = token;
+                ++fieldIdx;
+                continue;
+            }
+            fieldIdx = 2;
+            string operand;
+            if ((token == "am" || token == "bm") && is >> operand) {
+                const bool isLast = operand.back() == ';';
+                if (isLast) {
+                    operand.pop_back();
+                }
+                (token == "am" ? blunderMove : alternativeMove) = operand;
+                if (!isLast) {
+                    // skip further operands of the operation
+                    getline(is, token, ';');
+                }
+            }
+            else if (token.back() != ';') {
+                getline(is, token, ';');
+            }
+        }
+        positions.emplace_back(fen + " " + halfMoveClock + " " + fullMoveNumber, blunderMove, alternativeMove);
+    }
+    if (positions.empty()) {
+        throw invalid_argument("The benchmark suite " + epdFile + " doesn't contain any position.");
+    }
+}
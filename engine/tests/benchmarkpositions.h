@@ -51,6 +51,14 @@ public:
     float totalNPS;
     float totalDepth;
     BenchmarkPositions();
+
+    /**
+     * @brief BenchmarkPositions Loads a position suite from an EPD file.
+     * The optional operations "am" (avoid move) and "bm" (best move) are given in UCI notation and
+     * are used as the blunder and alternative move, e.g. "<fen> am h4h5; bm Q@h2;"
+     * @param epdFile Path to the EPD file
+     */
+    BenchmarkPositions(const string& epdFile);
 };
 
 #ifdef BENCHMARK
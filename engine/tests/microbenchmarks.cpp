@@ -0,0 +1,185 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: microbenchmarks.cpp
+ * Created on 14.10.2026
+ * @author: queensgambit
+ *
+ * Micro-benchmarks of the core kernels of the input encoding, the move generation and the node statistics.
+ * Build with -DBUILD_MICROBENCHMARKS=ON to replace the engine main() by the benchmark runner. All variants of the
+ * compiled mode are measured on a position which is reached by a fixed sequence of random moves.
+ * Usage: ./<binary> [iteration scale]
+ */
+
+#ifdef BUILD_MICROBENCHMARKS
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "stateobj.h"
+#include "node.h"
+#include "constants.h"
+#include "nn/neuralnetapi.h"
+#include "uci/crazyara.h"
+#include "util/benchmarkreport.h"
+#include "agents/config/searchsettings.h"
+using namespace std;
+
+// number of timed repetitions of each kernel, the median is reported
+#define NB_REPETITIONS 7
+// number of random moves from the starting position to the benchmark position
+#define NB_OPENING_MOVES 20
+
+// accumulates the results of the kernels so that the compiler can't remove them
+static volatile double sink = 0;
+
+/**
+ * @brief measure_ns_per_op Returns the median time of a single call of func in nanoseconds
+ * @param func Kernel which is called with the iteration index
+ * @param iterations Calls of each repetition
+ */
+template<typename Func>
+double measure_ns_per_op(Func func, size_t iterations)
+{
+    vector<double> samples;
+    // the first repetition warms up the caches and the branch predictors and isn't measured
+    for (size_t rep = 0; rep <= NB_REPETITIONS; ++rep) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t it = 0; it < iterations; ++it) {
+            func(it);
+        }
+        const double elapsedNS = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        if (rep != 0) {
+            samples.emplace_back(elapsedNS / iterations);
+        }
+    }
+    return percentile(samples, 0.5);
+}
+
+void print_result(const string& variant, const string& kernel, double nsPerOp)
+{
+    cout << setw(20) << variant << setw(34) << kernel << setw(14) << fixed << setprecision(1) << nsPerOp << endl;
+}
+
+/**
+ * @brief run_microbenchmarks Measures all kernels for a single variant
+ * @param variantName UCI name of the variant
+ * @param scale Factor of the number of iterations
+ */
+void run_microbenchmarks(const string& variantName, size_t scale)
+{
+    const int variant = StateConstants::variant_to_int(variantName);
+    unique_ptr<StateObj> state = make_unique<StateObj>();
+    state->set(StateConstants::start_fen(variant), false, variant);
+    mt19937 prng(42);
+    for (size_t ply = 0; ply < NB_OPENING_MOVES; ++ply) {
+        const vector<Action> actions = state->legal_actions();
+        if (actions.empty()) {
+            break;
+        }
+        state->do_action(actions[prng() % actions.size()]);
+    }
+    const vector<Action> actions = state->legal_actions();
+    if (actions.empty()) {
+        cout << setw(20) << variantName << "  reached a terminal position, skipped" << endl;
+        return;
+    }
+
+    vector<float> inputPlanes(StateConstants::NB_VALUES_TOTAL());
+    print_result(variantName, "board_to_planes", measure_ns_per_op([&](size_t) {
+        state->get_state_planes(true, inputPlanes.data(), StateConstants::CURRENT_VERSION());
+        sink += inputPlanes[0];
+    }, 20000 * scale));
+
+    print_result(variantName, "legal_actions", measure_ns_per_op([&](size_t) {
+        sink += state->legal_actions().size();
+    }, 20000 * scale));
+
+    print_result(variantName, "clone_do_action", measure_ns_per_op([&](size_t it) {
+        unique_ptr<StateObj> child = unique_ptr<StateObj>(state->clone());
+        child->do_action(actions[it % actions.size()]);
+        sink += child->steps_from_null();
+    }, 20000 * scale));
+
+    print_result(variantName, "action_to_index", measure_ns_per_op([&](size_t it) {
+        sink += StateConstants::action_to_index<normal, notMirrored>(actions[it % actions.size()]);
+    }, 1000000 * scale));
+
+    vector<float> policy(max(StateConstants::NB_LABELS(), StateConstants::NB_LABELS_POLICY_MAP()));
+    for (size_t idx = 0; idx < policy.size(); ++idx) {
+        policy[idx] = float(prng() % 1000) / 100.0f;
+    }
+    print_result(variantName, "apply_softmax", measure_ns_per_op([&](size_t) {
+        apply_softmax(policy.data(), policy.size());
+        sink += policy[0];
+    }, 2000 * scale));
+
+    SearchSettings searchSettings;
+#ifdef MCTS_STORE_STATES
+    // the node takes the ownership of its state
+    Node node(state->clone(), &searchSettings);
+#else
+    Node node(state.get(), &searchSettings);
+#endif
+    const vector<float> uniformPolicy(policy.size(), 1.0f / actions.size());
+    node.set_probabilities_for_moves(uniformPolicy.data(), false);
+    node.enable_has_nn_results();
+    node.prepare_node_for_visits();
+    const size_t numberChildren = node.get_number_child_nodes();
+
+    print_result(variantName, "get_current_u_values", measure_ns_per_op([&](size_t) {
+        sink += node.get_current_u_values(&searchSettings)[0];
+    }, 200000 * scale));
+
+    // each selection is backed up, so that the statistics evolve like in a search
+    print_result(variantName, "select_child_node+backup", measure_ns_per_op([&](size_t it) {
+        const ChildIdx childIdx = node.select_child_node(&searchSettings);
+        node.apply_virtual_loss_to_child(childIdx, &searchSettings);
+        node.revert_virtual_loss_and_update<false>(childIdx, (it % 3) / 2.0f - 0.5f, &searchSettings, false);
+    }, 200000 * scale));
+
+    print_result(variantName, "revert_virtual_loss_and_update", measure_ns_per_op([&](size_t it) {
+        const ChildIdx childIdx = ChildIdx(it % numberChildren);
+        node.apply_virtual_loss_to_child(childIdx, &searchSettings);
+        node.revert_virtual_loss_and_update<false>(childIdx, (it % 3) / 2.0f - 0.5f, &searchSettings, false);
+    }, 200000 * scale));
+}
+
+int main(int argc, char* argv[]) {
+#ifdef XIANGQI
+    variants.init();
+#endif
+    // initializes the options and the move generation tables of the compiled mode
+    CrazyAra crazyara;
+    crazyara.init();
+    StateConstants::init(true, false);
+    const size_t scale = argc > 1 ? max(stoul(argv[1]), 1UL) : 1;
+
+    cout << setw(20) << "variant" << setw(34) << "kernel" << setw(14) << "ns/op" << endl;
+    for (const string& variantName : StateConstants::available_variants()) {
+        run_microbenchmarks(variantName, scale);
+    }
+    return 0;
+}
+#endif
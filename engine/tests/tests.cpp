@@ -31,19 +31,52 @@
 using namespace Catch::literals;
 using namespace std;
 #include <string>
+#include <filesystem>
 #ifndef MODE_STRATEGO
 #if !defined(MODE_XIANGQI) && !defined(MODE_BOARDGAMES)
 #ifdef SF_DEPENDENCY
 #include "uci.h"
 #endif
 #include "uci/optionsuci.h"
+#include "uci/networkcache.h"
+#include "uci/distributedsearch.h"
 #include "environments/chess_related/sfutil.h"
 #include "thread.h"
 #include "constants.h"
 #include "environments/chess_related/inputrepresentation.h"
 #include "legacyconstants.h"
 #include "util/blazeutil.h"
+#include "util/puctselection.h"
+#include "util/policykernels.h"
+#include "util/randomgen.h"
+#include "nn/enginecache.h"
+#include "nn/layerprecision.h"
+#include "nn/planepacking.h"
+#include "nn/inferencebenchmark.h"
+#include "nn/deviceconfig.h"
+#include "nn/nullapi.h"
+#include "nn/deferrednetapi.h"
+#include "nn/inferencerecording.h"
+#include "nn/inferenceserver.h"
+#include "util/numa.h"
+#include "util/benchmarkreport.h"
+#include "util/devicemonitor.h"
+#include "util/bufferedfilewriter.h"
+#include "util/perft.h"
+#include "manager/batchbackup.h"
+#include "manager/batchcontroller.h"
+#include "manager/timemanager.h"
+#include "agents/util/gumbelroot.h"
+#include "agents/util/rootstatsfeed.h"
+#include "node.h"
+#include <chrono>
+#include <fstream>
+#include <map>
 #include "environments/chess_related/boardstate.h"
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 using namespace OptionsUCI;
 
 #ifdef SF_DEPENDENCY
@@ -738,6 +771,256 @@ TEST_CASE("State: clone()"){
     unique_ptr<StateObj> state2 = unique_ptr<StateObj>(state.clone());
     REQUIRE(state2->fen() == state.fen());
 }
+
+#if defined(MODE_CHESS) || defined(MODE_CRAZYHOUSE)
+TEST_CASE("Perft"){
+    init();
+    StateObj state;
+    state.init(0, false);
+    const string fen = state.fen();
+    REQUIRE(perft(&state, 3) == 8902);
+    REQUIRE(state.fen() == fen);
+    const PerftResult result = run_perft(&state, 3, 4);
+    REQUIRE(result.nodes == 8902);
+    REQUIRE(result.rootActions.size() == 20);
+}
+#endif
+
+/*
+ * Performance regression tests
+ * They are hidden by the tag "[.perf]" and only run on request: ./<binary> "[perf]"
+ * Each measured value is compared to the baseline in the file given by the environment variable CRAZYARA_PERF_BASELINES
+ * (default: perf_baselines.txt in the working directory) with a relative tolerance of CRAZYARA_PERF_TOLERANCE (default: 0.1).
+ * Set CRAZYARA_PERF_UPDATE=1 to store the measured values as the new baselines of the current machine.
+ */
+string get_perf_baseline_file()
+{
+    const char* file = getenv("CRAZYARA_PERF_BASELINES");
+    return file == nullptr ? "perf_baselines.txt" : file;
+}
+
+map<string, double> read_perf_baselines()
+{
+    map<string, double> baselines;
+    ifstream file(get_perf_baseline_file());
+    string name;
+    double value;
+    while (file >> name >> value) {
+        baselines[name] = value;
+    }
+    return baselines;
+}
+
+/**
+ * @brief check_perf_baseline Fails if the value is worse than the stored baseline by more than the tolerance
+ * @param name Unique name of the measurement
+ * @param value Measured value
+ * @param higherIsBetter True for throughput values, false for memory or latency values
+ */
+void check_perf_baseline(const string& name, double value, bool higherIsBetter)
+{
+    map<string, double> baselines = read_perf_baselines();
+    const char* tolerance = getenv("CRAZYARA_PERF_TOLERANCE");
+    const double relativeTolerance = tolerance == nullptr ? 0.1 : stod(tolerance);
+    if (getenv("CRAZYARA_PERF_UPDATE") != nullptr) {
+        baselines[name] = value;
+        ofstream file(get_perf_baseline_file(), ios_base::trunc);
+        for (const auto& entry : baselines) {
+            file << entry.first << " " << entry.second << endl;
+        }
+        return;
+    }
+    INFO(name << ": " << value << " (baseline: " << (baselines.count(name) ? to_string(baselines[name]) : "none") << ")");
+    if (baselines.count(name) == 0) {
+        WARN("No baseline for " << name << ", run with CRAZYARA_PERF_UPDATE=1 to store it");
+        return;
+    }
+    if (higherIsBetter) {
+        REQUIRE(value >= baselines[name] * (1 - relativeTolerance));
+    }
+    else {
+        REQUIRE(value <= baselines[name] * (1 + relativeTolerance));
+    }
+}
+
+/**
+ * @brief measure_per_second Returns the calls of func per second for a fixed number of iterations
+ */
+template<typename Func>
+double measure_per_second(Func func, size_t iterations)
+{
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t it = 0; it < iterations; ++it) {
+        func(it);
+    }
+    const double elapsedS = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1e6;
+    return elapsedS == 0 ? 0 : iterations / elapsedS;
+}
+
+/**
+ * @brief create_perf_node Creates an expanded node with uniform priors for the given state
+ */
+unique_ptr<Node> create_perf_node(StateObj& state, const SearchSettings* searchSettings, const vector<float>& policy)
+{
+#ifdef MCTS_STORE_STATES
+    unique_ptr<Node> node = make_unique<Node>(state.clone(), searchSettings);
+#else
+    unique_ptr<Node> node = make_unique<Node>(&state, searchSettings);
+#endif
+    node->set_probabilities_for_moves(policy.data(), false);
+    node->enable_has_nn_results();
+    node->prepare_node_for_visits();
+    return node;
+}
+
+TEST_CASE("Perf_Planes_Per_Second", "[.perf]"){
+    init();
+    srand(42);
+    StateObj state;
+    state.init(0, false);
+    apply_random_moves(state, 10);
+    vector<float> inputPlanes(StateConstants::NB_VALUES_TOTAL());
+    const double planesPerSecond = measure_per_second([&](size_t) {
+        state.get_state_planes(true, inputPlanes.data(), StateConstants::CURRENT_VERSION());
+    }, 200000);
+    REQUIRE(inputPlanes.size() != 0);
+    check_perf_baseline("planes_per_second", planesPerSecond, true);
+}
+
+TEST_CASE("Perf_Movegen_Nodes_Per_Second", "[.perf]"){
+    init();
+    StateObj state;
+    state.init(0, false);
+    const PerftResult result = run_perft(&state, 4, 1);
+    check_perf_baseline("movegen_nodes_per_second", result.nps(), true);
+}
+
+TEST_CASE("Perf_Node_Expansion_And_Memory", "[.perf]"){
+    init();
+    StateConstants::init(true, false);
+    srand(42);
+    StateObj state;
+    state.init(0, false);
+    apply_random_moves(state, 10);
+    SearchSettings searchSettings;
+    const vector<float> policy(max(StateConstants::NB_LABELS(), StateConstants::NB_LABELS_POLICY_MAP()), 0.01f);
+
+    const double expansionsPerSecond = measure_per_second([&](size_t) {
+        create_perf_node(state, &searchSettings, policy);
+    }, 100000);
+    check_perf_baseline("node_expansions_per_second", expansionsPerSecond, true);
+
+    unique_ptr<Node> node = create_perf_node(state, &searchSettings, policy);
+    check_perf_baseline("node_memory_bytes", node->get_memory_size(), false);
+
+    // selection and backup of a simulation without a neural network
+    const double simulationsPerSecond = measure_per_second([&](size_t it) {
+        const ChildIdx childIdx = node->select_child_node(&searchSettings);
+        node->apply_virtual_loss_to_child(childIdx, &searchSettings);
+        node->revert_virtual_loss_and_update<false>(childIdx, (it % 3) / 2.0f - 0.5f, &searchSettings, false);
+    }, 1000000);
+    check_perf_baseline("node_simulations_per_second", simulationsPerSecond, true);
+}
+
+TEST_CASE("Node_Value_Correction"){
+    init();
+    StateConstants::init(true, false);
+    StateObj state;
+    state.init(0, false);
+    const vector<float> policy(max(StateConstants::NB_LABELS(), StateConstants::NB_LABELS_POLICY_MAP()), 0.01f);
+
+    for (VirtualStyle virtualStyle : {VIRTUAL_VISIT, VIRTUAL_LOSS}) {
+        SearchSettings searchSettings;
+        searchSettings.virtualStyle = virtualStyle;
+        // the first node receives the evaluation 0.6 which is corrected to -0.2 while a second simulation of the child is pending
+        unique_ptr<Node> correctedNode = create_perf_node(state, &searchSettings, policy);
+        unique_ptr<Node> referenceNode = create_perf_node(state, &searchSettings, policy);
+        for (float value : {0.2f, 0.4f}) {
+            for (Node* node : {correctedNode.get(), referenceNode.get()}) {
+                node->apply_virtual_loss_to_child(0, &searchSettings);
+                node->revert_virtual_loss_and_update<false>(0, value, &searchSettings, false);
+            }
+        }
+        correctedNode->apply_virtual_loss_to_child(0, &searchSettings);
+        correctedNode->revert_virtual_loss_and_update<false>(0, 0.6f, &searchSettings, false);
+        referenceNode->apply_virtual_loss_to_child(0, &searchSettings);
+        referenceNode->revert_virtual_loss_and_update<false>(0, -0.2f, &searchSettings, false);
+
+        for (Node* node : {correctedNode.get(), referenceNode.get()}) {
+            node->apply_virtual_loss_to_child(0, &searchSettings);
+        }
+        correctedNode->correct_child_value(0, -0.8f, &searchSettings);
+        for (Node* node : {correctedNode.get(), referenceNode.get()}) {
+            node->revert_virtual_loss_and_update<false>(0, 0.5f, &searchSettings, false);
+        }
+        REQUIRE_THAT(correctedNode->get_q_value(0), Catch::Matchers::WithinAbs(referenceNode->get_q_value(0), 1e-5));
+        REQUIRE_THAT(correctedNode->get_value(), Catch::Matchers::WithinAbs(referenceNode->get_value(), 1e-5));
+    }
+}
+
+TEST_CASE("Batch_Backup"){
+    init();
+    StateConstants::init(true, false);
+    StateObj state;
+    state.init(0, false);
+    const vector<float> policy(max(StateConstants::NB_LABELS(), StateConstants::NB_LABELS_POLICY_MAP()), 0.01f);
+    const vector<float> values = {0.3f, -0.5f, 0.8f, 0.1f};
+
+    for (VirtualStyle virtualStyle : {VIRTUAL_VISIT, VIRTUAL_LOSS}) {
+        SearchSettings searchSettings;
+        searchSettings.virtualStyle = virtualStyle;
+        // a root with the node of its first child, one copy is updated by backup_value() and the other one by a BatchBackup
+        unique_ptr<Node> sequentialRoot = create_perf_node(state, &searchSettings, policy);
+        unique_ptr<Node> sequentialChild = create_perf_node(state, &searchSettings, policy);
+        unique_ptr<Node> batchRoot = create_perf_node(state, &searchSettings, policy);
+        unique_ptr<Node> batchChild = create_perf_node(state, &searchSettings, policy);
+        auto get_value_trajectories = [](Node* root, Node* child) {
+            return vector<Trajectory>{{{root, 0}, {child, 0}}, {{root, 0}, {child, 1}}, {{root, 0}, {child, 0}}, {{root, 1}}};
+        };
+        auto get_collision_trajectories = [](Node* root, Node* child) {
+            return vector<Trajectory>{{{root, 0}, {child, 1}}, {{root, 2}}};
+        };
+        const vector<Trajectory> sequentialValues = get_value_trajectories(sequentialRoot.get(), sequentialChild.get());
+        const vector<Trajectory> sequentialCollisions = get_collision_trajectories(sequentialRoot.get(), sequentialChild.get());
+        const vector<Trajectory> batchValues = get_value_trajectories(batchRoot.get(), batchChild.get());
+        const vector<Trajectory> batchCollisions = get_collision_trajectories(batchRoot.get(), batchChild.get());
+        for (const vector<Trajectory>* trajectories : {&sequentialValues, &sequentialCollisions, &batchValues, &batchCollisions}) {
+            for (const Trajectory& trajectory : *trajectories) {
+                for (const NodeAndIdx& nodeAndIdx : trajectory) {
+                    nodeAndIdx.node->apply_virtual_loss_to_child(nodeAndIdx.childIdx, &searchSettings);
+                }
+            }
+        }
+
+        for (size_t idx = 0; idx < values.size(); ++idx) {
+            backup_value<false>(values[idx], &searchSettings, sequentialValues[idx], false);
+        }
+        for (const Trajectory& trajectory : sequentialCollisions) {
+            backup_collision(&searchSettings, trajectory);
+        }
+        BatchBackup batchBackup;
+        for (size_t idx = 0; idx < values.size(); ++idx) {
+            batchBackup.add_value(values[idx], batchValues[idx], false, &searchSettings);
+        }
+        batchBackup.apply(&searchSettings);
+        for (const Trajectory& trajectory : batchCollisions) {
+            batchBackup.add_collision(trajectory);
+        }
+        batchBackup.apply(&searchSettings);
+
+        for (const pair<Node*, Node*>& nodes : {make_pair(sequentialRoot.get(), batchRoot.get()), make_pair(sequentialChild.get(), batchChild.get())}) {
+            REQUIRE(nodes.first->get_visits() == nodes.second->get_visits());
+            REQUIRE_THAT(nodes.first->get_value(), Catch::Matchers::WithinAbs(nodes.second->get_value(), 1e-5));
+            for (ChildIdx childIdx = 0; childIdx < 3; ++childIdx) {
+                REQUIRE(nodes.first->get_real_visits(childIdx) == nodes.second->get_real_visits(childIdx));
+                REQUIRE(nodes.first->get_child_number_visits(childIdx) == nodes.second->get_child_number_visits(childIdx));
+                REQUIRE(nodes.first->get_virtual_loss_counter(childIdx) == nodes.second->get_virtual_loss_counter(childIdx));
+                REQUIRE(nodes.second->get_virtual_loss_counter(childIdx) == 0);
+                REQUIRE_THAT(nodes.first->get_q_value(childIdx), Catch::Matchers::WithinAbs(nodes.second->get_q_value(childIdx), 1e-5));
+            }
+        }
+    }
+}
 #elif defined(MODE_XIANGQI) || defined(MODE_BOARDGAMES)
 #include "piece.h"
 #include "thread.h"
@@ -1668,5 +1951,596 @@ TEST_CASE("Chess960 Input Planes V3") {
 }
 #endif
 
+TEST_CASE("PUCT_Selection_Kernel"){
+    // the vectorized kernel must return the same index as the scalar version including the tie breaking
+    const size_t numberChildren = 37;
+    vector<float> qValues(numberChildren, -1.0f);
+    vector<float> policyProbs(numberChildren, 0.0f);
+    vector<uint32_t> visits(numberChildren, 0);
+    for (size_t idx = 0; idx < numberChildren; ++idx) {
+        policyProbs[idx] = float((idx * 7) % 11) / 11.0f;
+        visits[idx] = uint32_t(idx % 5);
+    }
+    qValues[20] = 0.5f;
+    qValues[35] = 0.5f;
+    for (float uFactor : {0.0f, 0.1f, 1.0f, 25.0f}) {
+        REQUIRE(argmax_q_plus_u(qValues.data(), policyProbs.data(), visits.data(), numberChildren, uFactor) ==
+                argmax_q_plus_u_scalar(qValues.data(), policyProbs.data(), visits.data(), numberChildren, uFactor));
+    }
+    REQUIRE(argmax_q_plus_u(qValues.data(), policyProbs.data(), visits.data(), numberChildren, 0.0f) == 20);
+}
+
+TEST_CASE("Policy_Kernels"){
+    // the vectorized kernels must match the exact computation including the tail which doesn't fill a full register
+    const size_t numberMoves = 37;
+    vector<float> logits(numberMoves);
+    vector<float> probs(numberMoves);
+    for (size_t idx = 0; idx < numberMoves; ++idx) {
+        logits[idx] = 8.0f * std::sin(1.3f * idx);
+    }
+    softmax_policy(logits.data(), probs.data(), numberMoves);
+    const float logitMax = *std::max_element(logits.begin(), logits.end());
+    double sum = 0;
+    for (size_t idx = 0; idx < numberMoves; ++idx) {
+        sum += std::exp(double(logits[idx] - logitMax));
+    }
+    for (size_t idx = 0; idx < numberMoves; ++idx) {
+        REQUIRE_THAT(probs[idx], Catch::Matchers::WithinAbs(std::exp(double(logits[idx] - logitMax)) / sum, 1e-6));
+    }
+    probs[3] = 0.0f;
+    vector<float> sharpened(numberMoves);
+    vector<float> sharpenedScalar(numberMoves);
+    temperature_policy(probs.data(), sharpened.data(), numberMoves, 0.5f);
+    temperature_policy_scalar(probs.data(), sharpenedScalar.data(), numberMoves, 0.5f);
+    double squaredSum = 0;
+    for (size_t idx = 0; idx < numberMoves; ++idx) {
+        squaredSum += double(probs[idx]) * probs[idx];
+    }
+    for (size_t idx = 0; idx < numberMoves; ++idx) {
+        REQUIRE_THAT(sharpened[idx], Catch::Matchers::WithinAbs(double(probs[idx]) * probs[idx] / squaredSum, 1e-6));
+        REQUIRE_THAT(sharpenedScalar[idx], Catch::Matchers::WithinAbs(sharpened[idx], 1e-6));
+    }
+    REQUIRE(sharpened[3] == 0.0f);
+}
+
+TEST_CASE("Random_Alias_Table"){
+    // the same seed must reproduce the same samples
+    FastRandom random(42);
+    FastRandom sameRandom(42);
+    for (size_t idx = 0; idx < 10; ++idx) {
+        REQUIRE(random() == sameRandom());
+    }
+    const vector<float> weights = {0.1f, 0.0f, 0.6f, 0.3f};
+    AliasTable aliasTable;
+    aliasTable.build(weights.data(), weights.size());
+    vector<size_t> counts(weights.size(), 0);
+    const size_t numberSamples = 100000;
+    for (size_t idx = 0; idx < numberSamples; ++idx) {
+        ++counts[aliasTable.sample(random)];
+    }
+    REQUIRE(counts[1] == 0);
+    for (size_t idx = 0; idx < weights.size(); ++idx) {
+        REQUIRE_THAT(double(counts[idx]) / numberSamples, Catch::Matchers::WithinAbs(weights[idx], 0.01));
+    }
+}
+
+TEST_CASE("Engine_Cache_Manifest"){
+    const string cacheDir = (std::filesystem::temp_directory_path() / "crazyara-engine-cache-test").generic_string() + "/";
+    std::filesystem::remove_all(cacheDir);
+    const string description = "model=model.onnx onnx=1f gpu=test sm=8.6 trt=8601 cuda=12000 precision=float16 profiles=1,8,16";
+    const string buffer = "serialized engine";
+    REQUIRE(is_valid_cache_entry(cacheDir, description) == false);
+    REQUIRE(write_cache_entry(cacheDir, description, buffer.data(), buffer.size()));
+    REQUIRE(is_valid_cache_entry(cacheDir, description));
+    // a different precision results in a different key and must not match the existing entry
+    REQUIRE(is_valid_cache_entry(cacheDir, "model=model.onnx onnx=1f gpu=test sm=8.6 trt=8601 cuda=12000 precision=float32 profiles=1,8,16") == false);
+    // a truncated engine file is rejected
+    REQUIRE(write_file_atomic(get_engine_cache_path(cacheDir, description), buffer.data(), buffer.size() - 1));
+    REQUIRE(is_valid_cache_entry(cacheDir, description) == false);
+    std::filesystem::remove_all(cacheDir);
+}
+
+TEST_CASE("Layer_Precision_Selection"){
+    // value error of 0.5 and half of the policy mass moved to the other move
+    REQUIRE_THAT(get_output_error({0.0f, 0.0f}, {0.5f, 0.5f}, {1.0f, 0.0f, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f, 0.5f}, 2),
+                 Catch::Matchers::WithinAbs(0.5, 1e-6));
+    REQUIRE_THAT(get_output_error({0.0f, 0.0f}, {0.1f, 0.0f}, {1.0f, 0.0f, 0.5f, 0.5f}, {0.0f, 1.0f, 0.5f, 0.5f}, 2),
+                 Catch::Matchers::WithinAbs(0.5, 1e-6));
+    REQUIRE(get_layer_group(0, 10, 4) == 0);
+    REQUIRE(get_layer_group(9, 10, 4) == 3);
+    REQUIRE(get_layer_group(2, 3, 8) == 5);
+
+    // each group adds a fixed error, groups 1 and 3 are the most sensitive
+    const vector<double> groupErrors = {0.01, 0.2, 0.0, 0.1};
+    size_t numberMeasurements = 0;
+    auto measureError = [&](const vector<bool>& keepGroups) {
+        ++numberMeasurements;
+        double error = 0;
+        for (size_t group = 0; group < groupErrors.size(); ++group) {
+            error += keepGroups[group] ? 0 : groupErrors[group];
+        }
+        return error;
+    };
+    REQUIRE(select_sensitive_groups(4, 0.05, measureError) == vector<bool>({false, true, false, true}));
+    REQUIRE(select_sensitive_groups(4, 0.15, measureError) == vector<bool>({false, true, false, false}));
+    // the low precision network is already accurate enough, so only the baseline is measured
+    numberMeasurements = 0;
+    REQUIRE(select_sensitive_groups(4, 0.5, measureError) == vector<bool>(4, false));
+    REQUIRE(numberMeasurements == 1);
+    // an unreachable tolerance keeps all groups which reduce the error
+    REQUIRE(select_sensitive_groups(4, 0.0, measureError) == vector<bool>({true, true, false, true}));
+}
+
+TEST_CASE("Layer_Plan_Cache"){
+    const string cacheDir = (std::filesystem::temp_directory_path() / "crazyara-layer-plan-test").generic_string() + "/";
+    std::filesystem::remove_all(cacheDir);
+    std::filesystem::create_directories(cacheDir);
+    const string planPath = get_layer_plan_path(cacheDir, "model=model.onnx onnx=1f gpu=test precision=int8 tolerance=0.01");
+    REQUIRE(planPath != get_layer_plan_path(cacheDir, "model=model.onnx onnx=1f gpu=test precision=int8 tolerance=0.02"));
+    vector<string> layerNames;
+    REQUIRE(read_layer_plan(planPath, layerNames) == false);
+    // an empty plan is valid and differs from a missing plan
+    REQUIRE(write_layer_plan(planPath, {}));
+    REQUIRE(read_layer_plan(planPath, layerNames));
+    REQUIRE(layerNames.empty());
+    REQUIRE(write_layer_plan(planPath, {"Conv_0", "Gemm_42"}));
+    REQUIRE(read_layer_plan(planPath, layerNames));
+    REQUIRE(layerNames == vector<string>({"Conv_0", "Gemm_42"}));
+    std::filesystem::remove_all(cacheDir);
+}
+
+TEST_CASE("Pack_Input_Planes"){
+    vector<float> planes(3 * PACKED_PLANE_SIZE, 0.0f);
+    // binary plane
+    planes[0] = 1.0f;
+    planes[63] = 1.0f;
+    // constant plane
+    std::fill_n(planes.begin() + PACKED_PLANE_SIZE, PACKED_PLANE_SIZE, 0.25f);
+    uint64_t masks[3];
+    float values[3];
+    REQUIRE(pack_planes(planes.data(), 3, masks, values));
+    REQUIRE(masks[0] == ((uint64_t(1) << 63) | 1));
+    REQUIRE(values[0] == 1.0f);
+    REQUIRE(masks[1] == ~uint64_t(0));
+    REQUIRE(values[1] == 0.25f);
+    REQUIRE(masks[2] == 0);
+    // two distinct non-zero values can't be packed
+    planes[2 * PACKED_PLANE_SIZE] = 1.0f;
+    planes[2 * PACKED_PLANE_SIZE + 1] = 2.0f;
+    REQUIRE(pack_planes(planes.data(), 3, masks, values) == false);
+}
+
+TEST_CASE("NUMA_Cpu_List"){
+    REQUIRE(parse_cpu_list("0-3,8,10-11\n") == vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    REQUIRE(parse_cpu_list("5") == vector<int>({5}));
+    REQUIRE(parse_cpu_list("").empty());
+    REQUIRE(bind_current_thread_to_numa_node(NO_NUMA_NODE) == false);
+}
+
+TEST_CASE("Benchmark_Percentile"){
+    const vector<double> values = {4, 1, 3, 2};
+    REQUIRE(percentile(values, 0) == 1);
+    REQUIRE(percentile(values, 0.5) == 2.5);
+    REQUIRE(percentile(values, 1) == 4);
+    REQUIRE(percentile({}, 0.5) == 0);
+}
+
+TEST_CASE("Device_Samples_Report"){
+    DeviceSample sample;
+    sample.deviceID = 1;
+    sample.gpuUtilization = 97;
+    sample.memoryUtilization = 41;
+    sample.memoryUsedBytes = uint64_t(512) * 1024 * 1024;
+    sample.memoryTotalBytes = uint64_t(8192) * 1024 * 1024;
+    sample.smClockMHz = 1830;
+    sample.memoryClockMHz = 7000;
+    sample.temperatureC = 64;
+    REQUIRE(device_samples_report({sample}) == "gpu1 util 97% mem util 41% mem 512/8192 MB sm 1830 MHz mem 7000 MHz 64 C\n");
+    sample.isThrottled = true;
+    REQUIRE(device_samples_report({sample, sample}).find("64 C throttled\ngpu1") != string::npos);
+    // without a running sampler there are no samples
+    REQUIRE(device_monitor().get_latest_samples().empty());
+    REQUIRE(device_monitor().get_average_samples().empty());
+}
+
+TEST_CASE("Null_Backend"){
+    NullAPI net(2);
+    REQUIRE(net.get_batch_size() == 2);
+    const size_t nbInputValues = net.get_nb_input_values_total();
+    const size_t nbPolicyValues = net.get_nb_policy_values();
+    vector<float> inputPlanes(2 * nbInputValues, 0.0f);
+    inputPlanes[nbInputValues] = 1.0f;
+    vector<float> valueOutput(2);
+    vector<float> probOutputs(2 * nbPolicyValues);
+    vector<float> auxiliaryOutputs(2 * StateConstants::NB_AUXILIARY_OUTPUTS() + 1);
+    net.predict(inputPlanes.data(), valueOutput.data(), probOutputs.data(), auxiliaryOutputs.data());
+    for (size_t batchIdx = 0; batchIdx < 2; ++batchIdx) {
+        REQUIRE(valueOutput[batchIdx] >= -1.0f);
+        REQUIRE(valueOutput[batchIdx] <= 1.0f);
+        float sum = 0;
+        for (size_t idx = 0; idx < nbPolicyValues; ++idx) {
+            REQUIRE(probOutputs[batchIdx * nbPolicyValues + idx] > 0.0f);
+            sum += probOutputs[batchIdx * nbPolicyValues + idx];
+        }
+        REQUIRE_THAT(sum, Catch::Matchers::WithinAbs(1.0f, 1e-3f));
+    }
+    // the outputs only depend on the input planes of the position
+    REQUIRE(valueOutput[0] != valueOutput[1]);
+    vector<float> valueOutputRepeated(2);
+    vector<float> probOutputsRepeated(2 * nbPolicyValues);
+    net.predict(inputPlanes.data(), valueOutputRepeated.data(), probOutputsRepeated.data(), auxiliaryOutputs.data());
+    REQUIRE(valueOutputRepeated == valueOutput);
+    REQUIRE(probOutputsRepeated == probOutputs);
+    REQUIRE(hash_input_planes(inputPlanes.data(), nbInputValues, 0) != hash_input_planes(inputPlanes.data(), nbInputValues, 1));
+}
+
+TEST_CASE("Inference_Record_Replay"){
+    const string fileName = "inference_record_replay_test.bin";
+    inference_recording().set_record_file(fileName);
+    RecordingAPI recordingNet(make_unique<NullAPI>(2));
+    const size_t nbInputValues = recordingNet.get_nb_input_values_total();
+    const size_t nbPolicyValues = recordingNet.get_nb_policy_values();
+    vector<float> inputPlanes(2 * nbInputValues, 0.0f);
+    inputPlanes[3] = 1.0f;
+    inputPlanes[nbInputValues + 5] = 1.0f;
+    vector<float> valueOutput(2);
+    vector<float> probOutputs(2 * nbPolicyValues);
+    recordingNet.predict(inputPlanes.data(), valueOutput.data(), probOutputs.data(), nullptr);
+    inference_recording().add_decision("startpos e2e4");
+    inference_recording().set_record_file("");
+
+    inference_recording().set_replay_file(fileName);
+    const ReplayNet* replayNet = inference_recording().get_replay_net(recordingNet.get_model_directory());
+    REQUIRE(replayNet != nullptr);
+    REQUIRE(inference_recording().get_replay_directories("null/") == vector<string>({"null/"}));
+    ReplayAPI replayAPI(replayNet, 2);
+    REQUIRE(replayAPI.get_model_name() == recordingNet.get_model_name());
+    vector<float> replayValueOutput(2);
+    vector<float> replayProbOutputs(2 * nbPolicyValues);
+    // the positions are found independently of their batch index
+    std::swap_ranges(inputPlanes.begin(), inputPlanes.begin() + nbInputValues, inputPlanes.begin() + nbInputValues);
+    replayAPI.predict(inputPlanes.data(), replayValueOutput.data(), replayProbOutputs.data(), nullptr);
+    REQUIRE(replayValueOutput[0] == valueOutput[1]);
+    REQUIRE(replayValueOutput[1] == valueOutput[0]);
+    REQUIRE(std::equal(probOutputs.begin(), probOutputs.begin() + nbPolicyValues, replayProbOutputs.begin() + nbPolicyValues));
+    REQUIRE(inference_recording().get_missed_positions() == 0);
+    inputPlanes[7] = 1.0f;
+    replayAPI.predict(inputPlanes.data(), replayValueOutput.data(), replayProbOutputs.data(), nullptr);
+    REQUIRE(inference_recording().get_missed_positions() == 1);
+    REQUIRE(replayValueOutput[0] == 0);
+    inference_recording().set_replay_file("");
+    std::remove(fileName.c_str());
+}
+
+TEST_CASE("Network_Cache"){
+    auto create_networks = []() {
+        LoadedNetworks networks;
+        networks.netSingleVector.push_back(make_unique<NullAPI>(1));
+        return networks;
+    };
+    NetworkCache cache;
+    // the cache is disabled without a budget
+    cache.put("chess", 10, create_networks());
+    REQUIRE(cache.size() == 0);
+    cache.set_budget(25);
+    cache.put("chess", 10, create_networks());
+    cache.put("crazyhouse", 10, create_networks());
+    REQUIRE(cache.get_memory_bytes() == 20);
+    // the least recently used networks are released first
+    cache.put("atomic", 10, create_networks());
+    LoadedNetworks networks;
+    REQUIRE_FALSE(cache.take("chess", networks));
+    REQUIRE(cache.take("crazyhouse", networks));
+    REQUIRE(networks.netSingleVector.size() == 1);
+    REQUIRE(cache.size() == 1);
+    // networks which exceed the budget on their own aren't cached
+    cache.put("horde", 30, create_networks());
+    REQUIRE(cache.size() == 1);
+    cache.set_budget(5);
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.get_memory_bytes() == 0);
+    REQUIRE(estimate_network_memory("directory_which_does_not_exist/", 4) == 0);
+}
+
+TEST_CASE("Search_Stability"){
+    SearchStability stable(0.5f, 2.0f);
+    REQUIRE(stable.get_time_factor() == 1.0f);
+    for (size_t idx = 0; idx < 20; ++idx) {
+        stable.update(3, 0.2f, 0.3f);
+    }
+    // a stable best move with a clear margin needs the least time
+    REQUIRE(stable.get_time_factor() == 0.5f);
+
+    SearchStability switching(0.5f, 2.0f);
+    for (size_t idx = 0; idx < 6; ++idx) {
+        switching.update(idx % 2, 0.01f, 0.3f);
+    }
+    REQUIRE(switching.get_time_factor() > 1.0f);
+
+    SearchStability dropping(0.5f, 2.0f);
+    dropping.update(0, 0.05f, 0.3f);
+    dropping.update(0, 0.05f, 0.2f);
+    REQUIRE_THAT(dropping.get_time_factor(), Catch::Matchers::WithinAbs(1.4f, 1e-4f));
+    dropping.update(0, 0.05f, -0.5f);
+    REQUIRE(dropping.get_time_factor() == 2.0f);
+}
+
+TEST_CASE("Gumbel_Root"){
+    REQUIRE(gumbel_transformed_q(1.0f, 50, 50.0f, 1.0f) == 100.0f);
+    REQUIRE(gumbel_transformed_q(-1.0f, 50, 50.0f, 1.0f) == 0.0f);
+
+    DynamicVector<float> priors = {0.5f, 0.5f, 0.0f};
+    DynamicVector<float> completedQ = {1.0f, -1.0f, 1.0f};
+    DynamicVector<double> policy;
+    gumbel_improved_policy(priors, completedQ, 0, 1.0f, 1.0f, policy);
+    REQUIRE(policy.size() == 3);
+    REQUIRE_THAT(policy[0], Catch::Matchers::WithinAbs(exp(1.0) / (exp(1.0) + 1.0), 1e-4));
+    REQUIRE(policy[1] < policy[0]);
+    REQUIRE(policy[2] < 1e-6);
+    REQUIRE_THAT(sum(policy), Catch::Matchers::WithinAbs(1.0, 1e-6));
+
+    // every candidate is visited at least once per phase
+    REQUIRE(sequential_halving_phase_visits(64, 4, 16) == 1);
+    REQUIRE(sequential_halving_phase_visits(0, 4, 16) == 1);
+    REQUIRE(sequential_halving_phase_visits(800, 4, 8) == 25);
+}
+
+TEST_CASE("Inference_Fair_Share"){
+    // session 1 has queued many requests before session 2
+    InferenceRequest requests[5];
+    const size_t groups[5] = {1, 1, 1, 2, 2};
+    deque<InferenceRequest*> queue;
+    for (size_t idx = 0; idx < 5; ++idx) {
+        requests[idx].group = groups[idx];
+        requests[idx].numberPositions = 2;
+        queue.push_back(&requests[idx]);
+    }
+    vector<InferenceRequest*> batch;
+    size_t numberPositions = 0;
+    pop_fair_share_requests(queue, 6, batch, numberPositions);
+    REQUIRE(numberPositions == 6);
+    REQUIRE(batch == vector<InferenceRequest*>({&requests[0], &requests[3], &requests[1]}));
+    REQUIRE(queue == deque<InferenceRequest*>({&requests[2], &requests[4]}));
+
+    // a request which doesn't fit blocks the later requests of its group, but not the other groups
+    requests[2].numberPositions = 5;
+    batch.clear();
+    numberPositions = 0;
+    pop_fair_share_requests(queue, 6, batch, numberPositions);
+    REQUIRE(batch == vector<InferenceRequest*>({&requests[2]}));
+    batch.clear();
+    numberPositions = 4;
+    queue = {&requests[2], &requests[4]};
+    pop_fair_share_requests(queue, 6, batch, numberPositions);
+    REQUIRE(batch == vector<InferenceRequest*>({&requests[4]}));
+    REQUIRE(numberPositions == 6);
+
+    // a single group is served in submission order until a request doesn't fit
+    batch.clear();
+    numberPositions = 0;
+    queue = {&requests[0], &requests[1], &requests[2]};
+    pop_fair_share_requests(queue, 6, batch, numberPositions);
+    REQUIRE(batch == vector<InferenceRequest*>({&requests[0], &requests[1]}));
+    REQUIRE(queue == deque<InferenceRequest*>({&requests[2]}));
+    REQUIRE(numberPositions == 4);
+}
+
+TEST_CASE("Distributed_Search_Selection"){
+    vector<ShardedRootMove> moves(3);
+    moves[0].prior = 0.6f;
+    moves[1].prior = 0.3f;
+    moves[1].shardIdx = 1;
+    moves[2].prior = 0.1f;
+    // unvisited moves are picked by their prior
+    REQUIRE(select_sharded_move(moves, 0, 2.5f) == 0);
+    REQUIRE(select_sharded_move(moves, 1, 2.5f) == 1);
+    // a running subtree is blocked for further chunks of its node
+    moves[0].pendingNodes = 100;
+    REQUIRE(select_sharded_move(moves, 0, 2.5f) == 2);
+    moves[2].isFailed = true;
+    REQUIRE(select_sharded_move(moves, 0, 2.5f) == moves.size());
+    // the value of the searched subtree outweighs the prior
+    moves[0].pendingNodes = 0;
+    moves[0].nodes = 100;
+    moves[0].q = -0.5f;
+    moves[2].isFailed = false;
+    moves[2].nodes = 100;
+    moves[2].q = 0.5f;
+    REQUIRE(select_sharded_move(moves, 0, 2.5f) == 2);
+
+    double value;
+    const string reply = "{\"id\": \"\", \"bestmove\": \"e7e5\", \"q\": -0.125, \"nodes\": 4000, \"pv\": [\"e7e5\"]}";
+    REQUIRE(parse_json_number(reply, "q", value));
+    REQUIRE(value == -0.125);
+    REQUIRE(parse_json_number(reply, "nodes", value));
+    REQUIRE(value == 4000);
+    REQUIRE_FALSE(parse_json_number(reply, "mate", value));
+    REQUIRE_FALSE(parse_json_number(reply, "bestmove", value));
+}
+
+#ifdef __linux__
+TEST_CASE("Root_Stats_Feed"){
+    RootStatsFeed feed;
+    feed.open("/crazyara_test_root_stats");
+    REQUIRE(feed.is_open());
+    // a reader process maps the segment read-only
+    const int fd = shm_open("/crazyara_test_root_stats", O_RDONLY, 0);
+    REQUIRE(fd != -1);
+    const size_t segmentSize = sizeof(RootStatsHeader) + ROOT_STATS_MAX_MOVES * sizeof(RootStatsMove);
+    void* memory = mmap(nullptr, segmentSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    REQUIRE(memory != MAP_FAILED);
+    RootStatsHeader* header = static_cast<RootStatsHeader*>(memory);
+    RootStatsSnapshot snapshot;
+    REQUIRE(read_root_stats_snapshot(header, snapshot));
+    REQUIRE(snapshot.searchId == 0);
+    REQUIRE(!snapshot.isSearching);
+    REQUIRE(snapshot.moves.empty());
+    munmap(memory, segmentSize);
+
+    // no publishing without a searched root node
+    REQUIRE(!feed.start_publishing(nullptr, false, 10));
+    feed.close();
+    REQUIRE(!feed.is_open());
+    REQUIRE(shm_open("/crazyara_test_root_stats", O_RDONLY, 0) == -1);
+}
+#endif
+
+TEST_CASE("Deferred_Phase_Loading"){
+    NullAPI referenceNet(2);
+    const size_t numberThreads = 2;
+    auto loadPhase = [&](const string&, vector<unique_ptr<NeuralNetAPI>>& netSingleVector, vector<vector<unique_ptr<NeuralNetAPI>>>& netBatchesVector) {
+        netSingleVector.push_back(make_unique<NullAPI>(1));
+        for (size_t threadIdx = 0; threadIdx < numberThreads; ++threadIdx) {
+            netBatchesVector[threadIdx].push_back(make_unique<NullAPI>(2));
+        }
+    };
+    shared_ptr<DeferredPhaseLoader> loader = make_shared<DeferredPhaseLoader>(vector<string>({"model/phase1"}), numberThreads, &referenceNet, loadPhase);
+    DeferredNetAPI deferredNet(loader, 0, 1, &referenceNet, "model/phase1");
+    REQUIRE(deferredNet.get_game_phase() == 1);
+    REQUIRE(deferredNet.get_batch_size() == 2);
+    REQUIRE(deferredNet.get_nb_input_values_total() == referenceNet.get_nb_input_values_total());
+    REQUIRE(deferredNet.get_nb_policy_values() == referenceNet.get_nb_policy_values());
+    REQUIRE_FALSE(deferredNet.is_loaded());
+
+    loader->start();
+    while (!deferredNet.is_loaded()) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    // the predictions are forwarded to the loaded network
+    const size_t nbPolicyValues = referenceNet.get_nb_policy_values();
+    vector<float> inputPlanes(2 * referenceNet.get_nb_input_values_total(), 0.0f);
+    inputPlanes[1] = 1.0f;
+    vector<float> valueOutput(2);
+    vector<float> probOutputs(2 * nbPolicyValues);
+    vector<float> referenceValueOutput(2);
+    vector<float> referenceProbOutputs(2 * nbPolicyValues);
+    deferredNet.predict(inputPlanes.data(), valueOutput.data(), probOutputs.data(), nullptr);
+    referenceNet.predict(inputPlanes.data(), referenceValueOutput.data(), referenceProbOutputs.data(), nullptr);
+    REQUIRE(valueOutput == referenceValueOutput);
+    REQUIRE(probOutputs == referenceProbOutputs);
+}
+
+TEST_CASE("Buffered_File_Writer"){
+    const string fileName = "buffered_file_writer_test.pgn";
+    std::remove(fileName.c_str());
+    auto read_file = [&]() {
+        ifstream file(fileName);
+        return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    };
+    {
+        // the interval is long enough that only flush() writes the records
+        BufferedFileWriter writer(600000);
+        writer.append(fileName, "game 1\n");
+        writer.append(fileName, "game 2\n");
+        REQUIRE(read_file() == "");
+        writer.flush();
+        REQUIRE(read_file() == "game 1\ngame 2\n");
+        writer.append(fileName, "game 3\n");
+        writer.truncate(fileName);
+        REQUIRE(read_file() == "");
+        writer.append(fileName, "game 4\n");
+    }
+    // the remaining records are written by the destructor
+    REQUIRE(read_file() == "game 4\n");
+    REQUIRE(is_gzip_file_name("games.pgn.gz"));
+    REQUIRE_FALSE(is_gzip_file_name("games.pgn"));
+    std::remove(fileName.c_str());
+}
+
+#ifndef MCTS_NODE_POOL
+TEST_CASE("Hash_Table_Sweep"){
+    MapWithMutex mapWithMutex;
+    mapWithMutex.init(4, 64);
+    // the live entries only need an owner which keeps their reference from expiring
+    shared_ptr<int> owner = make_shared<int>(0);
+    const NodeRef liveRef = shared_ptr<Node>(owner, nullptr);
+    for (Key idx = 0; idx < 40; ++idx) {
+        const Key key = ((idx % 4) << 32) | idx;
+        HashShard& shard = mapWithMutex.get_shard(key);
+        lock_guard<HashMutex> lock(shard.mtx);
+        REQUIRE(mapWithMutex.insert(shard, key, idx % 2 == 0 ? liveRef : NodeRef()));
+    }
+    REQUIRE(mapWithMutex.get_load_factor() == Approx(40.0f / 64));
+
+    // a full pass over all shards removes every expired entry exactly once
+    size_t removedEntries = 0;
+    for (size_t step = 0; step < 1000; ++step) {
+        removedEntries += mapWithMutex.sweep_expired_entries(4);
+    }
+    REQUIRE(removedEntries == 20);
+    REQUIRE(mapWithMutex.size() == 20);
+    REQUIRE(mapWithMutex.get_load_factor() == Approx(20.0f / 64));
+    REQUIRE(mapWithMutex.remove_expired_entries() == 0);
+
+    owner = nullptr;
+    REQUIRE(mapWithMutex.remove_expired_entries() == 20);
+    REQUIRE(mapWithMutex.size() == 0);
+}
+#endif
+
+TEST_CASE("Distribute_Threads"){
+    REQUIRE(distribute_threads({3000, 1000}, 4) == vector<size_t>({3, 1}));
+    // each device keeps at least one thread
+    REQUIRE(distribute_threads({10000, 1}, 4) == vector<size_t>({3, 1}));
+    REQUIRE(distribute_threads({1, 1, 1}, 5) == vector<size_t>({2, 2, 1}));
+    REQUIRE(distribute_threads({0, 0}, 3) == vector<size_t>({2, 1}));
+    REQUIRE(distribute_threads({1000, 2000}, 1) == vector<size_t>({1, 0}));
+}
+
+TEST_CASE("Device_Config"){
+    vector<DeviceSpec> devices = parse_device_config("0:threads=3,batch=32,precision=float16; 2", 2, 16, "int8");
+    REQUIRE(devices.size() == 2);
+    REQUIRE(devices[0].deviceId == 0);
+    REQUIRE(devices[0].threads == 3);
+    REQUIRE(devices[0].batchSize == 32);
+    REQUIRE(devices[0].precision == "float16");
+    REQUIRE(devices[1].deviceId == 2);
+    REQUIRE(devices[1].threads == 2);
+    REQUIRE(devices[1].precision == "int8");
+    // only the default batch sizes are scaled
+    scale_batch_sizes(devices, 0.25);
+    REQUIRE(devices[0].batchSize == 32);
+    REQUIRE(devices[1].batchSize == 4);
+    // MIG partitions are enumerated in the given order
+    devices = parse_device_config("MIG-a:threads=1;MIG-b", 2, 16, "int8");
+    REQUIRE(devices[1].deviceId == 1);
+    REQUIRE_THROWS_AS(parse_device_config("0;MIG-a", 1, 1, ""), invalid_argument);
+    REQUIRE_THROWS_AS(parse_device_config("0:batch=0", 1, 1, ""), invalid_argument);
+    REQUIRE_THROWS_AS(parse_device_config("0:stream=1", 1, 1, ""), invalid_argument);
+    REQUIRE(parse_device_config("", 1, 1, "").empty());
+}
+
+TEST_CASE("KL_Divergence"){
+    DynamicVector<uint32_t> oldVisits{10, 30, 0};
+    DynamicVector<uint32_t> newVisits{20, 60, 0};
+    // scaled visit counts describe the same distribution
+    REQUIRE_THAT(kl_divergence(newVisits, oldVisits), Catch::Matchers::WithinAbs(0.0, 1e-9));
+    newVisits = {40, 60, 0};
+    REQUIRE_THAT(kl_divergence(newVisits, oldVisits), Catch::Matchers::WithinRel(0.4 * log(0.4 / 0.25) + 0.6 * log(0.6 / 0.75), 1e-6));
+    // a newly visited move can't be compared to the former distribution
+    newVisits = {10, 30, 1};
+    REQUIRE(kl_divergence(newVisits, oldVisits) == numeric_limits<double>::infinity());
+    REQUIRE(kl_divergence(newVisits, DynamicVector<uint32_t>()) == numeric_limits<double>::infinity());
+}
+
+TEST_CASE("Batch_Controller"){
+    BatchController controller(4, 16);
+    REQUIRE(controller.get_fill_target() == 16);
+    // a narrow tree with many collisions reduces the fill target down to the lower bound
+    for (size_t idx = 0; idx < 20 * BATCH_CONTROLLER_WINDOW; ++idx) {
+        controller.update(8, 8, 1.0f);
+    }
+    REQUIRE(controller.get_fill_target() == 4);
+    // without collisions the target grows again
+    for (size_t idx = 0; idx < BATCH_CONTROLLER_WINDOW; ++idx) {
+        controller.update(4, 0, 1.0f);
+    }
+    REQUIRE(controller.get_fill_target() == 5);
+    BatchController fixedController(16, 16);
+    fixedController.update(8, 8, 1.0f);
+    REQUIRE(fixedController.get_fill_target() == 16);
+}
+
 #endif
 